@@ -0,0 +1,184 @@
+/*
+ * Test of bt_tracker_update_batch against bt_tracker_update_into.
+ *
+ * Feeds a recorded detection sequence (MOTChallenge text) to one tracker frame by frame with
+ * bt_tracker_update_into and to another in batches of several frames, and checks that:
+ *  - each batch reports the per-frame track counts of the single-frame calls and writes the same
+ *    tracks back to back, bit for bit;
+ *  - a batch whose output does not fit returns BT_ERR_NO_SPACE, fills the buffer with the leading
+ *    tracks, reports the truncated counts (zero once the buffer is full) and still advances the
+ *    tracker through every frame, so the next batch matches again.
+ * Track ids come from one counter shared by every tracker in the process, so the reference runs
+ * over the whole sequence first and the batched ids must differ from it by a constant.
+ * Exits non-zero on the first difference.
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "bytetrack_c_api.h"
+
+// Objects of frame f are frames[f - 1]
+typedef std::vector<std::vector<bt_bbox_t> > Sequence;
+
+static bool load_det(const char* path, Sequence& seq) {
+    FILE* fp = fopen(path, "r");
+    if (fp == nullptr) {
+        fprintf(stderr, "cannot open %s\n", path);
+        return false;
+    }
+
+    char line[512];
+    while (fgets(line, sizeof(line), fp) != nullptr) {
+        double v[7] = {0};
+        int    n    = 0;
+        char*  p    = line;
+        while (n < 7) {
+            char*  end;
+            double x = strtod(p, &end);
+            if (end == p) break;
+            v[n++] = x;
+            p      = end;
+            while (*p == ',' || *p == ' ' || *p == '\t') ++p;
+        }
+        if (n < 7 || v[0] < 1) continue;
+
+        bt_bbox_t box;
+        for (int k = 0; k < 4; ++k) box.tlwh[k] = v[2 + k];
+        box.prob     = v[6];
+        box.label    = 0;
+        box.track_id = 0;
+
+        size_t frame = (size_t)v[0];
+        if (seq.size() < frame) seq.resize(frame);
+        seq[frame - 1].push_back(box);
+    }
+
+    fclose(fp);
+    return true;
+}
+
+static bool same_track(const bt_bbox_t& a, const bt_bbox_t& b, int id_offset) {
+    return memcmp(a.tlwh, b.tlwh, sizeof(a.tlwh)) == 0 && a.prob == b.prob && a.label == b.label && a.track_id == b.track_id + id_offset;
+}
+
+// The objects of frames [first, first + num) back to back, and their counts
+static void batch_input(const Sequence& det, size_t first, size_t num, std::vector<bt_bbox_t>& objects, std::vector<size_t>& num_objects) {
+    objects.clear();
+    num_objects.clear();
+    for (size_t f = first; f < first + num; ++f) {
+        objects.insert(objects.end(), det[f].begin(), det[f].end());
+        num_objects.push_back(det[f].size());
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc != 2) {
+        printf("usage: %s det.txt\n", argv[0]);
+        return 2;
+    }
+
+    Sequence det;
+    if (!load_det(argv[1], det) || det.empty()) return 2;
+
+    bt_config_t  config    = BT_CONFIG_DEFAULT();
+    bt_handler_t reference = bt_tracker_create(&config);
+    bt_handler_t batched   = bt_tracker_create(&config);
+    if (reference == nullptr || batched == nullptr) {
+        fprintf(stderr, "cannot create tracker\n");
+        return 2;
+    }
+
+    // Frame by frame first, then the same frames again in batches
+    Sequence reference_tracks(det.size());
+    for (size_t f = 0; f < det.size(); ++f) {
+        bt_bbox_t  frame_tracks[512];
+        size_t     count = 0;
+        bt_error_t err   = bt_tracker_update_into(reference, det[f].data(), det[f].size(), frame_tracks, 512, &count);
+        if (err != BT_ERR_OK) {
+            printf("frame %zu: reference update failed (%d)\n", f + 1, (int)err);
+            return 1;
+        }
+        reference_tracks[f].assign(frame_tracks, frame_tracks + count);
+    }
+
+    // Batches of 1 to 7 frames, every third one with an output buffer a few tracks too short
+    std::vector<bt_bbox_t> objects;
+    std::vector<size_t>    num_objects;
+    std::vector<bt_bbox_t> expected, tracks(4096);
+    std::vector<size_t>    expected_num, num_tracks;
+    size_t                 batches   = 0, truncated = 0;
+    bool                   ok        = true;
+    bool                   aligned   = false;
+    int                    id_offset = 0;
+    for (size_t first = 0; first < det.size() && ok; ++batches) {
+        size_t num = std::min<size_t>(1 + batches % 7, det.size() - first);
+
+        expected.clear();
+        expected_num.clear();
+        for (size_t f = first; f < first + num; ++f) {
+            expected.insert(expected.end(), reference_tracks[f].begin(), reference_tracks[f].end());
+            expected_num.push_back(reference_tracks[f].size());
+        }
+
+        size_t short_by = std::min<size_t>(expected.size(), 3);
+        bool   truncate = batches % 3 == 2 && short_by > 0;
+        size_t capacity = truncate ? expected.size() - short_by : tracks.size();
+        batch_input(det, first, num, objects, num_objects);
+        num_tracks.assign(num, (size_t)-1);
+        bt_error_t err = bt_tracker_update_batch(batched, objects.data(), num_objects.data(), num, tracks.data(), capacity, num_tracks.data());
+
+        if (err != (truncate ? BT_ERR_NO_SPACE : BT_ERR_OK)) {
+            printf("frames %zu-%zu: batch returned %d with room for %zu of %zu tracks\n", first + 1, first + num, (int)err, capacity,
+                   expected.size());
+            ok = false;
+            break;
+        }
+        truncated += truncate;
+
+        // the counts of a truncated batch are what fitted, frame after frame
+        size_t room = capacity;
+        for (size_t i = 0; i < num && ok; ++i) {
+            size_t want = std::min(expected_num[i], room);
+            room -= want;
+            if (num_tracks[i] != want) {
+                printf("frame %zu: batch wrote %zu tracks, expected %zu\n", first + i + 1, num_tracks[i], want);
+                ok = false;
+            }
+        }
+        for (size_t i = 0; i < std::min(capacity, expected.size()) && ok; ++i) {
+            if (!aligned) {
+                id_offset = tracks[i].track_id - expected[i].track_id;
+                aligned   = true;
+            }
+            if (!same_track(tracks[i], expected[i], id_offset)) {
+                printf("frames %zu-%zu: track %zu of the batch (id %d) differs from the reference (id %d)\n", first + 1, first + num, i, tracks[i].track_id,
+                       expected[i].track_id + id_offset);
+                ok = false;
+            }
+        }
+        first += num;
+    }
+
+    // no frames is a no-op, an output buffer is required once there is room to write to
+    size_t no_objects = 0;
+    if (ok && bt_tracker_update_batch(batched, nullptr, nullptr, 0, nullptr, 0, nullptr) != BT_ERR_OK) {
+        printf("an empty batch failed\n");
+        ok = false;
+    }
+    if (ok && bt_tracker_update_batch(batched, nullptr, &no_objects, 1, nullptr, 4, nullptr) != BT_ERR_INVALID_OBJECTS) {
+        printf("a missing output buffer was accepted\n");
+        ok = false;
+    }
+
+    bt_tracker_destroy(reference);
+    bt_tracker_destroy(batched);
+
+    if (ok) {
+        printf("%zu frames in %zu batches, %zu truncated, match\n", det.size(), batches, truncated);
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,160 @@
+/*
+ * Host microbenchmark of the ByteTrack IoU distance.
+ *
+ * Fills the track x detection cost matrix of a crowded scene once with the original
+ * vector<vector<float> > path (per-track tlbr copies, scalar loops, 1 - IoU in a second pass) and
+ * once with the SoA kernel of iouMatrix.h, checks both give the same costs and reports the time
+ * per matrix and per pair. Exits non-zero on a mismatch.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "iouMatrix.h"
+
+using std::vector;
+
+// The association before the SoA kernel: tlbr vectors copied out of every track, then IoU, then 1 - IoU
+static vector<vector<float> > ious_reference(const vector<vector<float> >& atlbrs, const vector<vector<float> >& btlbrs) {
+    vector<vector<float> > ious(atlbrs.size(), vector<float>(btlbrs.size()));
+    for (size_t k = 0; k < btlbrs.size(); k++) {
+        float box_area = (btlbrs[k][2] - btlbrs[k][0] + 1) * (btlbrs[k][3] - btlbrs[k][1] + 1);
+        for (size_t n = 0; n < atlbrs.size(); n++) {
+            float iw = std::min(atlbrs[n][2], btlbrs[k][2]) - std::max(atlbrs[n][0], btlbrs[k][0]) + 1;
+            ious[n][k] = 0.f;
+            if (iw > 0) {
+                float ih = std::min(atlbrs[n][3], btlbrs[k][3]) - std::max(atlbrs[n][1], btlbrs[k][1]) + 1;
+                if (ih > 0) {
+                    float ua   = (atlbrs[n][2] - atlbrs[n][0] + 1) * (atlbrs[n][3] - atlbrs[n][1] + 1) + box_area - iw * ih;
+                    ious[n][k] = iw * ih / ua;
+                }
+            }
+        }
+    }
+    return ious;
+}
+
+static vector<vector<float> > iou_distance_reference(const vector<vector<float> >& tracks, const vector<vector<float> >& dets) {
+    vector<vector<float> > atlbrs(tracks.size()), btlbrs(dets.size());
+    for (size_t i = 0; i < tracks.size(); i++) atlbrs[i] = tracks[i];
+    for (size_t i = 0; i < dets.size(); i++) btlbrs[i] = dets[i];
+
+    vector<vector<float> > cost = ious_reference(atlbrs, btlbrs);
+    for (auto& row : cost) {
+        for (auto& c : row) c = 1 - c;
+    }
+    return cost;
+}
+
+// People standing in a 1920x1080 frame, crowded enough that most boxes overlap a few others
+static vector<vector<float> > make_boxes(int n, std::mt19937& rng) {
+    std::uniform_real_distribution<float> x(0.f, 1800.f), y(0.f, 900.f), w(40.f, 120.f);
+    vector<vector<float> > boxes(n);
+    for (auto& box : boxes) {
+        float bw = w(rng);
+        float bx = x(rng), by = y(rng);
+        box      = {bx, by, bx + bw, by + bw * 2.2f};
+    }
+    return boxes;
+}
+
+static vector<vector<float> > jitter(const vector<vector<float> >& boxes, std::mt19937& rng) {
+    std::normal_distribution<float> d(0.f, 6.f);
+    vector<vector<float> >          out = boxes;
+    for (auto& box : out) {
+        float dx = d(rng), dy = d(rng);
+        box[0] += dx;
+        box[2] += dx;
+        box[1] += dy;
+        box[3] += dy;
+    }
+    return out;
+}
+
+template <typename F>
+static double time_us(int iters, F&& fn) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iters; i++) fn();
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::micro>(end - start).count() / iters;
+}
+
+static void usage(const char* prog) {
+    printf("usage: %s [options]\n"
+           "  --iters N   matrices per size and path (default 200)\n"
+           "  --seed N    scene seed (default 1)\n",
+           prog);
+}
+
+int main(int argc, char** argv) {
+    int iters = 200;
+    int seed  = 1;
+    for (int i = 1; i < argc; ++i) {
+        const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (value == nullptr) {
+            usage(argv[0]);
+            return 2;
+        }
+        if (!strcmp(argv[i], "--iters")) {
+            iters = atoi(value);
+        } else if (!strcmp(argv[i], "--seed")) {
+            seed = atoi(value);
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+        ++i;
+    }
+    if (iters <= 0) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    printf("kernel: %s\n", byte_iou::iou_kernel_name());
+    printf("%9s %14s %14s %12s %12s %8s\n", "tracks", "reference us", "soa us", "ref ns/pair", "soa ns/pair", "speedup");
+
+    std::mt19937 rng(seed);
+    bool         ok = true;
+    for (int n : {16, 50, 100, 200, 400}) {
+        vector<vector<float> > tracks = make_boxes(n, rng);
+        vector<vector<float> > dets   = jitter(tracks, rng);
+
+        vector<vector<float> > expected = iou_distance_reference(tracks, dets);
+        double                 ref_us   = time_us(iters, [&] {
+            vector<vector<float> > cost = iou_distance_reference(tracks, dets);
+            if (cost.empty()) abort();
+        });
+
+        byte_iou::BoxesSoA a, b;
+        CostMatrix         cost;
+        double             soa_us = time_us(iters, [&] {
+            // building the lanes from the tracks is part of every frame, as in BYTETracker
+            a.clear();
+            b.clear();
+            for (const auto& box : tracks) a.push_back(box.data());
+            for (const auto& box : dets) b.push_back(box.data());
+            byte_iou::iou_distance(a, b, cost);
+        });
+
+        float max_diff = 0.f;
+        for (int i = 0; i < n; i++) {
+            for (int j = 0; j < n; j++) {
+                max_diff = std::max(max_diff, std::fabs(cost.row(i)[j] - expected[i][j]));
+            }
+        }
+        if (max_diff > 1e-5f) {
+            printf("%9d cost mismatch, max difference %g\n", n, max_diff);
+            ok = false;
+            continue;
+        }
+        double pairs = double(n) * n;
+        printf("%9d %14.1f %14.1f %12.2f %12.2f %7.1fx\n", n, ref_us, soa_us, ref_us * 1000 / pairs, soa_us * 1000 / pairs, ref_us / soa_us);
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,219 @@
+/*
+ * Host microbenchmark of the ByteTrack Kalman filter.
+ *
+ * Runs the same tracks (initiate, then predict and update with a noisy measurement every frame)
+ * through the original filter, kept below as it was with its 8x8/4x8 Eigen products and the LLT
+ * solve, and through byte_kalman::KalmanFilter, checks that both keep the same means and
+ * covariances and reports the time per track of predict and of update. Exits non-zero on a
+ * mismatch.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include <eigen3/Eigen/Cholesky>
+
+#include "kalmanFilter.h"
+
+namespace reference {
+// byte_kalman::KalmanFilter before it was written out over the block structure
+class KalmanFilter {
+   public:
+    KalmanFilter() {
+        _motion_mat = Eigen::MatrixXf::Identity(8, 8);
+        for (int i = 0; i < 4; i++) {
+            _motion_mat(i, 4 + i) = 1.f;
+        }
+        _update_mat = Eigen::MatrixXf::Identity(4, 8);
+
+        _std_weight_position = 1. / 20;
+        _std_weight_velocity = 1. / 160;
+    }
+
+    void predict(KAL_MEAN& mean, KAL_COVA& covariance) {
+        DETECTBOX std_pos;
+        std_pos << _std_weight_position * mean(3), _std_weight_position * mean(3), 1e-2, _std_weight_position * mean(3);
+        DETECTBOX std_vel;
+        std_vel << _std_weight_velocity * mean(3), _std_weight_velocity * mean(3), 1e-5, _std_weight_velocity * mean(3);
+        KAL_MEAN tmp;
+        tmp.block<1, 4>(0, 0) = std_pos;
+        tmp.block<1, 4>(0, 4) = std_vel;
+        tmp                   = tmp.array().square();
+        KAL_COVA motion_cov   = tmp.asDiagonal();
+        KAL_MEAN mean1        = this->_motion_mat * mean.transpose();
+        KAL_COVA covariance1  = this->_motion_mat * covariance * (_motion_mat.transpose());
+        covariance1 += motion_cov;
+
+        mean       = mean1;
+        covariance = covariance1;
+    }
+
+    KAL_HDATA project(const KAL_MEAN& mean, const KAL_COVA& covariance) {
+        DETECTBOX std;
+        std << _std_weight_position * mean(3), _std_weight_position * mean(3), 1e-1, _std_weight_position * mean(3);
+        KAL_HMEAN                  mean1       = _update_mat * mean.transpose();
+        KAL_HCOVA                  covariance1 = _update_mat * covariance * (_update_mat.transpose());
+        Eigen::Matrix<float, 4, 4> diag        = std.asDiagonal();
+        diag                                   = diag.array().square().matrix();
+        covariance1 += diag;
+        return std::make_pair(mean1, covariance1);
+    }
+
+    KAL_DATA update(const KAL_MEAN& mean, const KAL_COVA& covariance, const DETECTBOX& measurement) {
+        KAL_HDATA pa             = project(mean, covariance);
+        KAL_HMEAN projected_mean = pa.first;
+        KAL_HCOVA projected_cov  = pa.second;
+
+        Eigen::Matrix<float, 4, 8> B              = (covariance * (_update_mat.transpose())).transpose();
+        Eigen::Matrix<float, 8, 4> kalman_gain    = (projected_cov.llt().solve(B)).transpose();
+        Eigen::Matrix<float, 1, 4> innovation     = measurement - projected_mean;
+        auto                       tmp            = innovation * (kalman_gain.transpose());
+        KAL_MEAN                   new_mean       = (mean.array() + tmp.array()).matrix();
+        KAL_COVA                   new_covariance = covariance - kalman_gain * projected_cov * (kalman_gain.transpose());
+        return std::make_pair(new_mean, new_covariance);
+    }
+
+   private:
+    Eigen::Matrix<float, 8, 8, Eigen::RowMajor> _motion_mat;
+    Eigen::Matrix<float, 4, 8, Eigen::RowMajor> _update_mat;
+
+    float _std_weight_position;
+    float _std_weight_velocity;
+};
+}  // namespace reference
+
+struct Track {
+    KAL_MEAN mean;
+    KAL_COVA covariance;
+};
+
+// Largest difference of the means relative to their magnitude and of the covariances relative to
+// their largest entry, so entries that cancel down to rounding noise do not dominate
+static float max_rel_diff(const Track& a, const Track& b) {
+    float diff  = 0.f;
+    float scale = b.covariance.cwiseAbs().maxCoeff();
+    for (int i = 0; i < 8; i++) {
+        diff = std::max(diff, std::fabs(a.mean(i) - b.mean(i)) / std::max(1.f, std::fabs(b.mean(i))));
+        for (int j = 0; j < 8; j++) {
+            diff = std::max(diff, std::fabs(a.covariance(i, j) - b.covariance(i, j)) / scale);
+        }
+    }
+    return diff;
+}
+
+template <typename F>
+static double time_ns(F&& fn) {
+    auto start = std::chrono::steady_clock::now();
+    fn();
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count();
+}
+
+static void usage(const char* prog) {
+    printf("usage: %s [options]\n"
+           "  --tracks N   tracks per frame (default 100)\n"
+           "  --frames N   frames (default 1000)\n"
+           "  --seed N     scene seed (default 1)\n",
+           prog);
+}
+
+int main(int argc, char** argv) {
+    int tracks = 100;
+    int frames = 1000;
+    int seed   = 1;
+    for (int i = 1; i < argc; ++i) {
+        const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (value == nullptr) {
+            usage(argv[0]);
+            return 2;
+        }
+        if (!strcmp(argv[i], "--tracks")) {
+            tracks = atoi(value);
+        } else if (!strcmp(argv[i], "--frames")) {
+            frames = atoi(value);
+        } else if (!strcmp(argv[i], "--seed")) {
+            seed = atoi(value);
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+        ++i;
+    }
+    if (tracks <= 0 || frames <= 0) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    // Objects moving at constant velocity in xyah space and bouncing off the frame and the size
+    // limits, measured with pixel noise
+    std::mt19937                          rng(seed);
+    std::uniform_real_distribution<float> x(0.f, 1800.f), y(0.f, 900.f), h(60.f, 250.f), v(-4.f, 4.f);
+    std::normal_distribution<float>       noise(0.f, 2.f);
+    std::vector<DETECTBOX>                truth(tracks), velocity(tracks);
+    for (int i = 0; i < tracks; i++) {
+        truth[i] << x(rng), y(rng), 0.45f, h(rng);
+        velocity[i] << v(rng), v(rng), 0.f, v(rng) * 0.1f;
+    }
+
+    reference::KalmanFilter   ref_filter;
+    byte_kalman::KalmanFilter filter;
+    std::vector<Track>        ref(tracks), cur(tracks);
+    for (int i = 0; i < tracks; i++) {
+        KAL_DATA data     = filter.initiate(truth[i]);
+        cur[i].mean       = data.first;
+        cur[i].covariance = data.second;
+        ref[i]            = cur[i];
+    }
+
+    std::vector<DETECTBOX> measurements(tracks);
+    double                 ref_predict = 0, ref_update = 0, cur_predict = 0, cur_update = 0;
+    float                  max_diff = 0.f;
+    for (int f = 0; f < frames; f++) {
+        for (int i = 0; i < tracks; i++) {
+            truth[i] += velocity[i];
+            if (truth[i](0) < 0.f || truth[i](0) > 1800.f) velocity[i](0) = -velocity[i](0);
+            if (truth[i](1) < 0.f || truth[i](1) > 900.f) velocity[i](1) = -velocity[i](1);
+            if (truth[i](3) < 60.f || truth[i](3) > 250.f) velocity[i](3) = -velocity[i](3);
+            measurements[i] = truth[i];
+            measurements[i](0) += noise(rng);
+            measurements[i](1) += noise(rng);
+            measurements[i](3) += noise(rng);
+        }
+
+        ref_predict += time_ns([&] {
+            for (auto& t : ref) ref_filter.predict(t.mean, t.covariance);
+        });
+        cur_predict += time_ns([&] {
+            for (auto& t : cur) filter.predict(t.mean, t.covariance);
+        });
+        ref_update += time_ns([&] {
+            for (int i = 0; i < tracks; i++) {
+                KAL_DATA data     = ref_filter.update(ref[i].mean, ref[i].covariance, measurements[i]);
+                ref[i].mean       = data.first;
+                ref[i].covariance = data.second;
+            }
+        });
+        cur_update += time_ns([&] {
+            for (int i = 0; i < tracks; i++) filter.update(cur[i].mean, cur[i].covariance, measurements[i]);
+        });
+
+        for (int i = 0; i < tracks; i++) max_diff = std::max(max_diff, max_rel_diff(cur[i], ref[i]));
+    }
+
+    double steps = double(tracks) * frames;
+    printf("%d tracks x %d frames, largest relative difference %g\n", tracks, frames, max_diff);
+    printf("%9s %14s %14s %8s\n", "", "reference ns", "current ns", "speedup");
+    printf("%9s %14.1f %14.1f %7.1fx\n", "predict", ref_predict / steps, cur_predict / steps, ref_predict / cur_predict);
+    printf("%9s %14.1f %14.1f %7.1fx\n", "update", ref_update / steps, cur_update / steps, ref_update / cur_update);
+    if (max_diff > 1e-3f) {
+        printf("state mismatch\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,238 @@
+/*
+ * Test of the multi-stream tracker manager against standalone trackers.
+ *
+ * Builds a number of streams from a recorded detection sequence (MOTChallenge text), each starting
+ * at a different frame and shifted by a few pixels, and tracks every stream once with its own
+ * bt_tracker_update_into tracker. The streams are then submitted to bt_manager in a scrambled
+ * interleaving with a small max_pending, for 1, 2 and 4 workers and one per hardware thread, and
+ * polled with a tracks buffer too small for all ready results. For every worker count each stream
+ * must come back with seq 0, 1, 2, ... and the same tracks as its standalone tracker, bit for bit.
+ * Track ids come from one counter shared by every tracker in the process, so they are compared
+ * through a per-stream mapping that must stay one to one. Exits non-zero on the first difference.
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <thread>
+#include <vector>
+
+#include "bytetrack_c_api.h"
+
+// Objects of frame f are frames[f - 1]
+typedef std::vector<std::vector<bt_bbox_t> > Sequence;
+
+static bool load_det(const char* path, Sequence& seq) {
+    FILE* fp = fopen(path, "r");
+    if (fp == nullptr) {
+        fprintf(stderr, "cannot open %s\n", path);
+        return false;
+    }
+
+    char line[512];
+    while (fgets(line, sizeof(line), fp) != nullptr) {
+        double v[7] = {0};
+        int    n    = 0;
+        char*  p    = line;
+        while (n < 7) {
+            char*  end;
+            double x = strtod(p, &end);
+            if (end == p) break;
+            v[n++] = x;
+            p      = end;
+            while (*p == ',' || *p == ' ' || *p == '\t') ++p;
+        }
+        if (n < 7 || v[0] < 1) continue;
+
+        bt_bbox_t box;
+        for (int k = 0; k < 4; ++k) box.tlwh[k] = v[2 + k];
+        box.prob     = v[6];
+        box.label    = 0;
+        box.track_id = 0;
+
+        size_t frame = (size_t)v[0];
+        if (seq.size() < frame) seq.resize(frame);
+        seq[frame - 1].push_back(box);
+    }
+
+    fclose(fp);
+    return true;
+}
+
+// Stream s replays the sequence from frame 17 * s on, wrapping around, moved by 3 * s pixels
+static Sequence make_stream(const Sequence& det, size_t s) {
+    Sequence stream(det.size());
+    for (size_t f = 0; f < det.size(); ++f) {
+        stream[f] = det[(f + 17 * s) % det.size()];
+        for (auto& box : stream[f]) {
+            box.tlwh[0] += 3.0f * s;
+            box.tlwh[1] += 3.0f * s;
+        }
+    }
+    return stream;
+}
+
+struct StreamCheck {
+    uint32_t           next_seq = 0;
+    std::map<int, int> ids;    // standalone id -> manager id
+    std::map<int, int> taken;  // manager id -> standalone id
+};
+
+static bool check_result(const bt_stream_result_t& result, const std::vector<Sequence>& expected, std::vector<StreamCheck>& checks) {
+    if (result.stream_id >= checks.size()) {
+        printf("result of unknown stream %u\n", result.stream_id);
+        return false;
+    }
+
+    StreamCheck& check = checks[result.stream_id];
+    if (result.seq != check.next_seq) {
+        printf("stream %u: seq %u returned, expected %u\n", result.stream_id, result.seq, check.next_seq);
+        return false;
+    }
+    ++check.next_seq;
+
+    const std::vector<bt_bbox_t>& want = expected[result.stream_id][result.seq];
+    if (result.num_tracks != want.size()) {
+        printf("stream %u frame %u: %zu tracks, expected %zu\n", result.stream_id, result.seq, result.num_tracks, want.size());
+        return false;
+    }
+    for (size_t i = 0; i < want.size(); ++i) {
+        const bt_bbox_t& a = result.tracks[i];
+        const bt_bbox_t& e = want[i];
+        if (memcmp(a.tlwh, e.tlwh, sizeof(a.tlwh)) != 0 || a.prob != e.prob || a.label != e.label) {
+            printf("stream %u frame %u: track %zu differs from the standalone tracker\n", result.stream_id, result.seq, i);
+            return false;
+        }
+
+        auto id    = check.ids.insert(std::make_pair(e.track_id, a.track_id));
+        auto owner = check.taken.insert(std::make_pair(a.track_id, e.track_id));
+        if (id.first->second != a.track_id || owner.first->second != e.track_id) {
+            printf("stream %u frame %u: track %d reported as %d, earlier as %d\n", result.stream_id, result.seq, e.track_id, a.track_id,
+                   id.first->second);
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool run_manager(size_t workers, const std::vector<Sequence>& streams, const std::vector<Sequence>& expected) {
+    bt_manager_config_t config = BT_MANAGER_CONFIG_DEFAULT();
+    config.max_streams         = streams.size();
+    config.num_workers         = workers;
+    config.max_pending         = 2 * streams.size();
+
+    bt_manager_handler_t manager = bt_manager_create(&config);
+    if (manager == nullptr) {
+        fprintf(stderr, "cannot create manager\n");
+        return false;
+    }
+
+    // room for a few results per poll, so ready results are regularly held back
+    std::vector<bt_stream_result_t> results(streams.size());
+    std::vector<bt_bbox_t>          tracks(256);
+    std::vector<size_t>             next_frame(streams.size(), 0);
+    std::vector<StreamCheck>        checks(streams.size());
+
+    const size_t frames    = streams[0].size();
+    const size_t total     = frames * streams.size();
+    size_t       submitted = 0;
+    size_t       done      = 0;
+    uint32_t     rng       = 1;
+    bool         ok        = true;
+    while (done < total && ok) {
+        // pick streams in a scrambled order, every stream still in submission order
+        while (submitted < total) {
+            rng      = rng * 1103515245u + 12345u;
+            size_t s = (rng >> 16) % streams.size();
+            while (next_frame[s] == frames) s = (s + 1) % streams.size();
+
+            const std::vector<bt_bbox_t>& objects = streams[s][next_frame[s]];
+            bt_stream_frame_t             frame   = {(uint32_t)s, objects.data(), objects.size()};
+            bt_error_t                    err     = bt_manager_submit(manager, &frame, 1, nullptr);
+            if (err == BT_ERR_NO_SPACE) break;
+            if (err != BT_ERR_OK) {
+                printf("submit failed (%d)\n", (int)err);
+                ok = false;
+                break;
+            }
+            ++next_frame[s];
+            ++submitted;
+        }
+
+        size_t     n   = 0;
+        bt_error_t err = bt_manager_poll(manager, results.data(), results.size(), tracks.data(), tracks.size(), &n);
+        if (err != BT_ERR_OK) {
+            printf("poll failed (%d)\n", (int)err);
+            ok = false;
+        }
+        for (size_t i = 0; i < n && ok; ++i) ok = check_result(results[i], expected, checks);
+        done += n;
+        if (n == 0) std::this_thread::yield();
+    }
+
+    if (ok) {
+        size_t n = 0;
+        bt_manager_poll(manager, results.data(), results.size(), tracks.data(), tracks.size(), &n);
+        if (n != 0) {
+            printf("%zu results past the last frame\n", n);
+            ok = false;
+        }
+    }
+    bt_manager_destroy(manager);
+
+    if (ok) {
+        printf("workers %zu: %zu streams x %zu frames match\n", workers, streams.size(), frames);
+    }
+    return ok;
+}
+
+int main(int argc, char** argv) {
+    if (argc != 2 && argc != 3) {
+        printf("usage: %s det.txt [streams]\n", argv[0]);
+        return 2;
+    }
+
+    Sequence det;
+    if (!load_det(argv[1], det) || det.empty()) return 2;
+    size_t num_streams = argc == 3 ? (size_t)atoi(argv[2]) : 8;
+    if (num_streams == 0) {
+        printf("streams must be positive\n");
+        return 2;
+    }
+
+    // Every stream tracked on its own first
+    bt_config_t            config = BT_CONFIG_DEFAULT();
+    std::vector<Sequence>  streams, expected;
+    std::vector<bt_bbox_t> frame_tracks(512);
+    for (size_t s = 0; s < num_streams; ++s) {
+        streams.push_back(make_stream(det, s));
+        expected.emplace_back(det.size());
+
+        bt_handler_t tracker = bt_tracker_create(&config);
+        if (tracker == nullptr) {
+            fprintf(stderr, "cannot create tracker\n");
+            return 2;
+        }
+        for (size_t f = 0; f < det.size(); ++f) {
+            size_t     count = 0;
+            bt_error_t err   = bt_tracker_update_into(tracker, streams[s][f].data(), streams[s][f].size(), frame_tracks.data(),
+                                                      frame_tracks.size(), &count);
+            if (err != BT_ERR_OK) {
+                printf("stream %zu frame %zu: standalone update failed (%d)\n", s, f, (int)err);
+                return 1;
+            }
+            expected[s][f].assign(frame_tracks.begin(), frame_tracks.begin() + count);
+        }
+        bt_tracker_destroy(tracker);
+    }
+
+    std::vector<size_t> workers = {1, 2, 4, std::max<size_t>(std::thread::hardware_concurrency(), 1)};
+    std::sort(workers.begin(), workers.end());
+    workers.erase(std::unique(workers.begin(), workers.end()), workers.end());
+    for (size_t w : workers) {
+        if (!run_manager(w, streams, expected)) return 1;
+    }
+    return 0;
+}
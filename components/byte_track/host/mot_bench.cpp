@@ -0,0 +1,566 @@
+/*
+ * Host benchmark and evaluation tool for byte_track.
+ *
+ * Replays MOTChallenge detections (or a generated scene) through the tracker and reports per-frame
+ * latency percentiles, heap allocations per frame, peak RSS and, when ground truth is available,
+ * CLEAR MOT (MOTA) and identity (IDF1) scores. With --streams the same sequence is fed to the
+ * multi-stream manager instead and the throughput is reported for 1 up to one worker per hardware
+ * thread, or for the given --workers only.
+ */
+
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <new>
+#include <random>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "bytetrack_c_api.h"
+#include "lapjv.h"
+
+// Every C++ allocation made by the tracker goes through here
+static std::atomic<long> g_allocs(0);
+
+void* operator new(size_t size) {
+    g_allocs.fetch_add(1, std::memory_order_relaxed);
+    void* ptr = malloc(size ? size : 1);
+    if (ptr == nullptr) throw std::bad_alloc();
+    return ptr;
+}
+void* operator new[](size_t size) { return operator new(size); }
+void  operator delete(void* ptr) noexcept { free(ptr); }
+void  operator delete[](void* ptr) noexcept { free(ptr); }
+void  operator delete(void* ptr, size_t) noexcept { free(ptr); }
+void  operator delete[](void* ptr, size_t) noexcept { free(ptr); }
+
+struct Row {
+    int   id;
+    float box[4];  // left, top, width, height
+    float conf;
+};
+
+// Rows of frame f are frames[f - 1]
+typedef std::vector<std::vector<Row> > Sequence;
+
+struct Options {
+    const char* det_path   = nullptr;
+    const char* gt_path    = nullptr;
+    const char* out_path   = nullptr;
+    const char* det_out    = nullptr;
+    int         synthetic  = 0;
+    int         frames     = 1000;
+    int         seed       = 1;
+    float       min_conf   = -1e30f;
+    float       conf_scale = 1.f;
+    int         streams    = 0;
+    int         workers    = 0;
+    bt_config_t config     = BT_CONFIG_DEFAULT();
+    float       iou_thresh = 0.5f;
+};
+
+static void usage(const char* prog) {
+    printf("usage: %s (--det det.txt [--gt gt.txt] | --synthetic N) [options]\n"
+           "  --det PATH          MOTChallenge detections (frame,id,left,top,width,height,conf,...)\n"
+           "  --gt PATH           MOTChallenge ground truth, enables MOTA/IDF1\n"
+           "  --synthetic N       generate a scene with N objects, detections and ground truth\n"
+           "  --frames N          length of the generated scene (default 1000)\n"
+           "  --seed N            seed of the generated scene (default 1)\n"
+           "  --min-conf X        drop detections below X before scaling\n"
+           "  --conf-scale X      multiply detection confidences by X (default 1)\n"
+           "  --frame-rate N      tracker frame rate (default 10)\n"
+           "  --track-buffer N    tracker buffer (default 15)\n"
+           "  --track-thresh X    high detection threshold (default 0.5)\n"
+           "  --high-thresh X     new track threshold (default 0.6)\n"
+           "  --match-thresh X    first association threshold (default 0.8)\n"
+           "  --gated             use the gated association\n"
+           "  --iou X             evaluation IoU threshold (default 0.5)\n"
+           "  --out PATH          write the tracks in MOTChallenge format\n"
+           "  --det-out PATH      write the detections of the generated scene in MOTChallenge format\n"
+           "  --streams N         run N copies of the sequence through the stream manager\n"
+           "  --workers N         manager worker threads (default: each of 1 to one per hardware thread)\n",
+           prog);
+}
+
+static bool parse_args(int argc, char** argv, Options& opt) {
+    for (int i = 1; i < argc; ++i) {
+        const char* arg   = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (!strcmp(arg, "--gated")) {
+            opt.config.association = BT_ASSOCIATION_GATED;
+            continue;
+        }
+        if (value == nullptr) {
+            return false;
+        }
+        ++i;
+        if (!strcmp(arg, "--det")) {
+            opt.det_path = value;
+        } else if (!strcmp(arg, "--gt")) {
+            opt.gt_path = value;
+        } else if (!strcmp(arg, "--out")) {
+            opt.out_path = value;
+        } else if (!strcmp(arg, "--det-out")) {
+            opt.det_out = value;
+        } else if (!strcmp(arg, "--synthetic")) {
+            opt.synthetic = atoi(value);
+        } else if (!strcmp(arg, "--frames")) {
+            opt.frames = atoi(value);
+        } else if (!strcmp(arg, "--seed")) {
+            opt.seed = atoi(value);
+        } else if (!strcmp(arg, "--min-conf")) {
+            opt.min_conf = atof(value);
+        } else if (!strcmp(arg, "--conf-scale")) {
+            opt.conf_scale = atof(value);
+        } else if (!strcmp(arg, "--frame-rate")) {
+            opt.config.frame_rate = atoi(value);
+        } else if (!strcmp(arg, "--track-buffer")) {
+            opt.config.track_buffer = atoi(value);
+        } else if (!strcmp(arg, "--track-thresh")) {
+            opt.config.track_thresh = atof(value);
+        } else if (!strcmp(arg, "--high-thresh")) {
+            opt.config.high_thresh = atof(value);
+        } else if (!strcmp(arg, "--match-thresh")) {
+            opt.config.match_thresh = atof(value);
+        } else if (!strcmp(arg, "--iou")) {
+            opt.iou_thresh = atof(value);
+        } else if (!strcmp(arg, "--streams")) {
+            opt.streams = atoi(value);
+        } else if (!strcmp(arg, "--workers")) {
+            opt.workers = atoi(value);
+        } else {
+            return false;
+        }
+    }
+    return (opt.det_path != nullptr) != (opt.synthetic > 0);
+}
+
+/**
+ * Load a MOTChallenge text file. Ground truth rows with a zero "consider" flag or a class other than
+ * pedestrian (when the class column is present) are skipped.
+ */
+static bool load_mot(const char* path, bool gt, const Options& opt, Sequence& seq) {
+    FILE* fp = fopen(path, "r");
+    if (fp == nullptr) {
+        fprintf(stderr, "cannot open %s\n", path);
+        return false;
+    }
+
+    char line[512];
+    while (fgets(line, sizeof(line), fp) != nullptr) {
+        double v[10] = {0};
+        int    n     = 0;
+        char*  p     = line;
+        while (n < 10) {
+            char*  end;
+            double x = strtod(p, &end);
+            if (end == p) break;
+            v[n++] = x;
+            p      = end;
+            while (*p == ',' || *p == ' ' || *p == '\t') ++p;
+        }
+        if (n < 7 || v[0] < 1) continue;
+
+        Row row;
+        row.id     = (int)v[1];
+        row.box[0] = v[2];
+        row.box[1] = v[3];
+        row.box[2] = v[4];
+        row.box[3] = v[5];
+        row.conf   = v[6];
+
+        if (gt) {
+            if (row.conf == 0) continue;
+            if (n >= 8 && (int)v[7] != 1) continue;
+        } else {
+            if (row.conf < opt.min_conf) continue;
+            row.conf *= opt.conf_scale;
+        }
+
+        size_t frame = (size_t)v[0];
+        if (seq.size() < frame) seq.resize(frame);
+        seq[frame - 1].push_back(row);
+    }
+
+    fclose(fp);
+    return true;
+}
+
+/**
+ * Constant-velocity objects entering and leaving the view, detected with position noise, misses,
+ * jittered confidences and a few false positives.
+ */
+static void make_scene(const Options& opt, Sequence& det, Sequence& gt) {
+    std::mt19937                          rng(opt.seed);
+    std::uniform_real_distribution<float> uni(0.f, 1.f);
+    std::normal_distribution<float>       noise(0.f, 1.f);
+
+    struct Object {
+        int   id;
+        float x, y, w, h, vx, vy;
+        int   life;
+    };
+    int  next_id = 1;
+    auto spawn   = [&](Object& o) {
+        o.id   = next_id++;
+        o.w    = 20 + uni(rng) * 40;
+        o.h    = o.w * (1.5f + uni(rng));
+        o.x    = uni(rng) * (1920 - o.w);
+        o.y    = uni(rng) * (1080 - o.h);
+        o.vx   = (uni(rng) - 0.5f) * 8;
+        o.vy   = (uni(rng) - 0.5f) * 4;
+        o.life = 30 + (int)(uni(rng) * 300);
+    };
+
+    std::vector<Object> objects(opt.synthetic);
+    for (auto& o : objects) spawn(o);
+
+    det.assign(opt.frames, std::vector<Row>());
+    gt.assign(opt.frames, std::vector<Row>());
+    for (int f = 0; f < opt.frames; ++f) {
+        for (auto& o : objects) {
+            if (--o.life < 0) spawn(o);
+            o.x += o.vx;
+            o.y += o.vy;
+
+            gt[f].push_back({o.id, {o.x, o.y, o.w, o.h}, 1.f});
+            if (uni(rng) < 0.1f) continue;  // missed
+
+            float s   = 0.03f * o.h;
+            float occ = uni(rng);
+            Row   row = {-1, {o.x + noise(rng) * s, o.y + noise(rng) * s, o.w + noise(rng) * s, o.h + noise(rng) * s}, 0};
+            row.conf  = occ < 0.2f ? 0.1f + 0.4f * uni(rng) : 0.5f + 0.5f * uni(rng);
+            det[f].push_back(row);
+        }
+        for (int k = 0; k < opt.synthetic / 20 + 1; ++k) {
+            if (uni(rng) < 0.3f) {
+                det[f].push_back({-1, {uni(rng) * 1800, uni(rng) * 1000, 30, 60}, 0.1f + 0.6f * uni(rng)});
+            }
+        }
+    }
+}
+
+static float iou(const float* a, const float* b) {
+    float iw = std::min(a[0] + a[2], b[0] + b[2]) - std::max(a[0], b[0]);
+    float ih = std::min(a[1] + a[3], b[1] + b[3]) - std::max(a[1], b[1]);
+    if (iw <= 0 || ih <= 0) return 0;
+    float inter = iw * ih;
+    return inter / (a[2] * a[3] + b[2] * b[3] - inter);
+}
+
+static double percentile(std::vector<double> sorted, double p) {
+    if (sorted.empty()) return 0;
+    std::sort(sorted.begin(), sorted.end());
+    size_t idx = (size_t)(p / 100.0 * (sorted.size() - 1) + 0.5);
+    return sorted[idx];
+}
+
+static long peak_rss_kb() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+static void bbox_from_row(const Row& row, bt_bbox_t& box) {
+    memcpy(box.tlwh, row.box, sizeof(box.tlwh));
+    box.prob     = row.conf;
+    box.label    = 0;
+    box.track_id = 0;
+}
+
+static int run_single(const Options& opt, const Sequence& det, Sequence& out) {
+    bt_handler_t tracker = bt_tracker_create(&opt.config);
+    if (tracker == nullptr) {
+        fprintf(stderr, "cannot create tracker\n");
+        return 1;
+    }
+
+    std::vector<bt_bbox_t> objects;
+    std::vector<bt_bbox_t> tracks(256);
+    std::vector<double>    latency;
+    latency.reserve(det.size());
+    out.assign(det.size(), std::vector<Row>());
+
+    long   allocs = 0;
+    size_t warmup = std::min<size_t>(det.size() / 10, 100);
+    for (size_t f = 0; f < det.size(); ++f) {
+        objects.resize(det[f].size());
+        for (size_t i = 0; i < det[f].size(); ++i) bbox_from_row(det[f][i], objects[i]);
+
+        size_t     num_tracks = 0;
+        long       before     = g_allocs.load();
+        auto       t0         = std::chrono::steady_clock::now();
+        bt_error_t err        = bt_tracker_update_into(tracker, objects.data(), objects.size(), tracks.data(), tracks.size(), &num_tracks);
+        auto       t1         = std::chrono::steady_clock::now();
+        if (f >= warmup) allocs += g_allocs.load() - before;
+
+        if (err == BT_ERR_NO_SPACE) {
+            tracks.resize(tracks.size() * 2);
+        }
+        latency.push_back(std::chrono::duration<double, std::micro>(t1 - t0).count());
+
+        for (size_t i = 0; i < num_tracks; ++i) {
+            Row row;
+            row.id = tracks[i].track_id;
+            memcpy(row.box, tracks[i].tlwh, sizeof(row.box));
+            row.conf = tracks[i].prob;
+            out[f].push_back(row);
+        }
+    }
+    bt_tracker_destroy(tracker);
+
+    double total = 0;
+    for (double us : latency) total += us;
+    printf("frames            %zu\n", det.size());
+    printf("latency us        mean %.1f  p50 %.1f  p90 %.1f  p99 %.1f  max %.1f\n",
+           latency.empty() ? 0 : total / latency.size(),
+           percentile(latency, 50),
+           percentile(latency, 90),
+           percentile(latency, 99),
+           percentile(latency, 100));
+    printf("allocs/frame      %.2f (after %zu warm-up frames)\n", det.size() > warmup ? double(allocs) / (det.size() - warmup) : 0.0, warmup);
+    printf("peak RSS          %ld KiB\n", peak_rss_kb());
+    return 0;
+}
+
+// Frames per second of the streams through one manager, negative on failure
+static double stream_throughput(const Options& opt, const std::vector<std::vector<bt_bbox_t> >& objects, size_t workers) {
+    bt_manager_config_t config = BT_MANAGER_CONFIG_DEFAULT();
+    config.tracker             = opt.config;
+    config.max_streams         = opt.streams;
+    config.num_workers         = workers;
+    config.max_pending         = 4 * opt.streams;
+
+    bt_manager_handler_t manager = bt_manager_create(&config);
+    if (manager == nullptr) {
+        fprintf(stderr, "cannot create manager\n");
+        return -1;
+    }
+
+    std::vector<bt_stream_result_t> results(opt.streams);
+    std::vector<bt_bbox_t>          tracks(256 * opt.streams);
+
+    const size_t total     = objects.size() * opt.streams;
+    size_t       submitted = 0;
+    size_t       done      = 0;
+    auto         t0        = std::chrono::steady_clock::now();
+    while (done < total) {
+        while (submitted < total) {
+            size_t            f     = submitted / opt.streams;
+            bt_stream_frame_t frame = {(uint32_t)(submitted % opt.streams), objects[f].data(), objects[f].size()};
+            if (bt_manager_submit(manager, &frame, 1, nullptr) != BT_ERR_OK) break;
+            ++submitted;
+        }
+
+        size_t n = 0;
+        bt_manager_poll(manager, results.data(), results.size(), tracks.data(), tracks.size(), &n);
+        done += n;
+        if (n == 0) std::this_thread::yield();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    bt_manager_destroy(manager);
+    return total / seconds;
+}
+
+static int run_streams(const Options& opt, const Sequence& det) {
+    std::vector<std::vector<bt_bbox_t> > objects(det.size());
+    for (size_t f = 0; f < det.size(); ++f) {
+        objects[f].resize(det[f].size());
+        for (size_t i = 0; i < det[f].size(); ++i) bbox_from_row(det[f][i], objects[f][i]);
+    }
+
+    // every worker count up to the hardware threads unless one is given
+    size_t first = opt.workers, last = opt.workers;
+    if (opt.workers <= 0) {
+        first = 1;
+        last  = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+
+    printf("streams           %d\n", opt.streams);
+    printf("frames            %zu per run\n", det.size() * opt.streams);
+    for (size_t workers = first; workers <= last; ++workers) {
+        double fps = stream_throughput(opt, objects, workers);
+        if (fps < 0) return 1;
+        printf("workers %-9zu %.0f frames/s (%.1f fps per stream)\n", workers, fps, fps / opt.streams);
+    }
+    printf("peak RSS          %ld KiB\n", peak_rss_kb());
+    return 0;
+}
+
+/**
+ * CLEAR MOT: matches carry over from the previous frame while they stay above the IoU threshold,
+ * the remaining pairs are assigned by minimum 1 - IoU. An identity switch is counted when a ground
+ * truth object is matched to a different track than the last time it was matched.
+ */
+static void evaluate(const Options& opt, const Sequence& gt, const Sequence& hyp) {
+    long num_gt = 0, num_hyp = 0, fp = 0, fn = 0, idsw = 0, tp = 0;
+
+    std::unordered_map<int, int>       last_match;
+    std::unordered_map<long long, int> pair_frames;  // (gt id, hyp id) -> frames above the threshold
+    std::map<int, int>                 gt_index, hyp_index;
+    LapjvSolver                        solver;
+    std::vector<float>                 cost;
+    std::vector<int>                   rowsol, colsol, gt_match, hyp_match;
+    const std::vector<Row>             empty;
+
+    size_t frames = std::max(gt.size(), hyp.size());
+    for (size_t f = 0; f < frames; ++f) {
+        const std::vector<Row>& g = f < gt.size() ? gt[f] : empty;
+        const std::vector<Row>& h = f < hyp.size() ? hyp[f] : empty;
+        num_gt += g.size();
+        num_hyp += h.size();
+
+        gt_match.assign(g.size(), -1);
+        hyp_match.assign(h.size(), -1);
+
+        for (size_t i = 0; i < g.size(); ++i) {
+            gt_index.emplace(g[i].id, (int)gt_index.size());
+            for (size_t j = 0; j < h.size(); ++j) {
+                if (iou(g[i].box, h[j].box) >= opt.iou_thresh) {
+                    pair_frames[((long long)g[i].id << 32) | (unsigned)h[j].id]++;
+                }
+            }
+        }
+        for (size_t j = 0; j < h.size(); ++j) hyp_index.emplace(h[j].id, (int)hyp_index.size());
+
+        // keep last frame's correspondences
+        for (size_t i = 0; i < g.size(); ++i) {
+            auto it = last_match.find(g[i].id);
+            if (it == last_match.end()) continue;
+            for (size_t j = 0; j < h.size(); ++j) {
+                if (h[j].id == it->second && hyp_match[j] < 0 && iou(g[i].box, h[j].box) >= opt.iou_thresh) {
+                    gt_match[i]  = j;
+                    hyp_match[j] = i;
+                    break;
+                }
+            }
+        }
+
+        // assign the rest
+        std::vector<int> rows, cols;
+        for (size_t i = 0; i < g.size(); ++i) {
+            if (gt_match[i] < 0) rows.push_back(i);
+        }
+        for (size_t j = 0; j < h.size(); ++j) {
+            if (hyp_match[j] < 0) cols.push_back(j);
+        }
+        if (!rows.empty() && !cols.empty()) {
+            cost.resize(rows.size() * cols.size());
+            for (size_t r = 0; r < rows.size(); ++r) {
+                for (size_t c = 0; c < cols.size(); ++c) {
+                    cost[r * cols.size() + c] = 1 - iou(g[rows[r]].box, h[cols[c]].box);
+                }
+            }
+            rowsol.resize(rows.size());
+            colsol.resize(cols.size());
+            solver.solve(cost.data(), rows.size(), cols.size(), cols.size(), 1 - opt.iou_thresh + 1e-6f, rowsol.data(), colsol.data());
+            for (size_t r = 0; r < rows.size(); ++r) {
+                if (rowsol[r] < 0 || cost[r * cols.size() + rowsol[r]] > 1 - opt.iou_thresh) continue;
+                int i = rows[r], j = cols[rowsol[r]];
+                auto it = last_match.find(g[i].id);
+                if (it != last_match.end() && it->second != h[j].id) ++idsw;
+                gt_match[i]  = j;
+                hyp_match[j] = i;
+            }
+        }
+
+        for (size_t i = 0; i < g.size(); ++i) {
+            if (gt_match[i] < 0) {
+                ++fn;
+            } else {
+                ++tp;
+                last_match[g[i].id] = h[gt_match[i]].id;
+            }
+        }
+        for (size_t j = 0; j < h.size(); ++j) {
+            if (hyp_match[j] < 0) ++fp;
+        }
+    }
+
+    // IDF1: one-to-one assignment of ground truth to track identities maximising shared frames
+    long idtp = 0;
+    if (!gt_index.empty() && !hyp_index.empty()) {
+        size_t rows = gt_index.size(), cols = hyp_index.size();
+        cost.assign(rows * cols, 0.f);
+        for (const auto& kv : pair_frames) {
+            int r = gt_index[(int)(kv.first >> 32)];
+            int c = hyp_index[(int)(kv.first & 0xffffffff)];
+            cost[r * cols + c] = -(float)kv.second;
+        }
+        rowsol.resize(rows);
+        colsol.resize(cols);
+        solver.solve(cost.data(), rows, cols, cols, 0, rowsol.data(), colsol.data());
+        for (size_t r = 0; r < rows; ++r) {
+            if (rowsol[r] >= 0) idtp -= (long)cost[r * cols + rowsol[r]];
+        }
+    }
+
+    double mota = num_gt ? 1.0 - double(fn + fp + idsw) / num_gt : 0;
+    double idf1 = num_gt + num_hyp ? 2.0 * idtp / (num_gt + num_hyp) : 0;
+    printf("ground truth      %ld boxes, %zu identities\n", num_gt, gt_index.size());
+    printf("tracks            %ld boxes, %zu identities\n", num_hyp, hyp_index.size());
+    printf("TP %ld  FP %ld  FN %ld  IDSW %ld\n", tp, fp, fn, idsw);
+    printf("MOTA              %.2f%%\n", 100 * mota);
+    printf("IDF1              %.2f%%  (IDP %.2f%%  IDR %.2f%%)\n",
+           100 * idf1,
+           num_hyp ? 100.0 * idtp / num_hyp : 0,
+           num_gt ? 100.0 * idtp / num_gt : 0);
+}
+
+static bool write_mot(const char* path, const Sequence& seq) {
+    FILE* fp = fopen(path, "w");
+    if (fp == nullptr) {
+        fprintf(stderr, "cannot open %s\n", path);
+        return false;
+    }
+    for (size_t f = 0; f < seq.size(); ++f) {
+        for (const Row& row : seq[f]) {
+            fprintf(fp, "%zu,%d,%.2f,%.2f,%.2f,%.2f,%.3f,-1,-1,-1\n", f + 1, row.id, row.box[0], row.box[1], row.box[2], row.box[3], row.conf);
+        }
+    }
+    fclose(fp);
+    return true;
+}
+
+int main(int argc, char** argv) {
+    Options opt;
+    if (!parse_args(argc, argv, opt)) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    Sequence det, gt;
+    if (opt.synthetic > 0) {
+        make_scene(opt, det, gt);
+        if (opt.det_out != nullptr && !write_mot(opt.det_out, det)) {
+            return 1;
+        }
+    } else {
+        if (!load_mot(opt.det_path, false, opt, det)) return 1;
+        if (opt.gt_path != nullptr && !load_mot(opt.gt_path, true, opt, gt)) return 1;
+    }
+
+    if (opt.streams > 0) {
+        return run_streams(opt, det);
+    }
+
+    Sequence out;
+    int      ret = run_single(opt, det, out);
+    if (ret != 0) return ret;
+
+    if (!gt.empty()) {
+        evaluate(opt, gt, out);
+    }
+    if (opt.out_path != nullptr && !write_mot(opt.out_path, out)) {
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,164 @@
+/*
+ * Regression test of the tracker against recorded output.
+ *
+ * Feeds a recorded detection sequence (MOTChallenge text, as written by bt_mot_bench --det-out)
+ * through the tracker with the default configuration and compares every frame with the expected
+ * tracks: the same track IDs must be reported and their boxes and scores must agree within the
+ * tolerance of the two-decimal text format. The expected files in testdata/ were produced by the
+ * original Eigen-based tracker, so any change to the association, the Kalman filter or the ID
+ * assignment that alters the tracking shows up here. With --gated the tracker uses the gated
+ * association instead of the dense one and must still produce the same tracks. Exits non-zero on
+ * the first differing frame.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "bytetrack_c_api.h"
+
+struct Row {
+    int   id;
+    float box[4];  // left, top, width, height
+    float conf;
+};
+
+// Rows of frame f are frames[f - 1]
+typedef std::vector<std::vector<Row> > Sequence;
+
+static const float BOX_TOLERANCE   = 0.05f;
+static const float SCORE_TOLERANCE = 0.002f;
+
+static bool load_mot(const char* path, Sequence& seq) {
+    FILE* fp = fopen(path, "r");
+    if (fp == nullptr) {
+        fprintf(stderr, "cannot open %s\n", path);
+        return false;
+    }
+
+    char line[512];
+    while (fgets(line, sizeof(line), fp) != nullptr) {
+        double v[7] = {0};
+        int    n    = 0;
+        char*  p    = line;
+        while (n < 7) {
+            char*  end;
+            double x = strtod(p, &end);
+            if (end == p) break;
+            v[n++] = x;
+            p      = end;
+            while (*p == ',' || *p == ' ' || *p == '\t') ++p;
+        }
+        if (n < 7 || v[0] < 1) continue;
+
+        Row row;
+        row.id     = (int)v[1];
+        row.box[0] = v[2];
+        row.box[1] = v[3];
+        row.box[2] = v[4];
+        row.box[3] = v[5];
+        row.conf   = v[6];
+
+        size_t frame = (size_t)v[0];
+        if (seq.size() < frame) seq.resize(frame);
+        seq[frame - 1].push_back(row);
+    }
+
+    fclose(fp);
+    return true;
+}
+
+static bool by_id(const Row& a, const Row& b) { return a.id < b.id; }
+
+static bool same_frame(size_t frame, std::vector<Row> expected, std::vector<Row> actual) {
+    std::sort(expected.begin(), expected.end(), by_id);
+    std::sort(actual.begin(), actual.end(), by_id);
+    if (expected.size() != actual.size()) {
+        printf("frame %zu: %zu tracks, expected %zu\n", frame, actual.size(), expected.size());
+        return false;
+    }
+    for (size_t i = 0; i < expected.size(); ++i) {
+        const Row& e = expected[i];
+        const Row& a = actual[i];
+        if (e.id != a.id) {
+            printf("frame %zu: track %d reported, expected %d\n", frame, a.id, e.id);
+            return false;
+        }
+        for (int k = 0; k < 4; ++k) {
+            if (std::fabs(e.box[k] - a.box[k]) > BOX_TOLERANCE) {
+                printf("frame %zu: track %d box %.2f,%.2f,%.2f,%.2f, expected %.2f,%.2f,%.2f,%.2f\n",
+                       frame, a.id, a.box[0], a.box[1], a.box[2], a.box[3], e.box[0], e.box[1], e.box[2], e.box[3]);
+                return false;
+            }
+        }
+        if (std::fabs(e.conf - a.conf) > SCORE_TOLERANCE) {
+            printf("frame %zu: track %d score %.3f, expected %.3f\n", frame, a.id, a.conf, e.conf);
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    bool gated = argc == 4 && !strcmp(argv[3], "--gated");
+    if (argc != 3 && !gated) {
+        printf("usage: %s det.txt expected_tracks.txt [--gated]\n", argv[0]);
+        return 2;
+    }
+
+    Sequence det, expected;
+    if (!load_mot(argv[1], det) || !load_mot(argv[2], expected)) return 2;
+    if (expected.size() > det.size()) {
+        printf("expected tracks past the last detection frame\n");
+        return 1;
+    }
+    expected.resize(det.size());
+
+    bt_config_t config = BT_CONFIG_DEFAULT();
+    if (gated) config.association = BT_ASSOCIATION_GATED;
+    bt_handler_t tracker = bt_tracker_create(&config);
+    if (tracker == nullptr) {
+        fprintf(stderr, "cannot create tracker\n");
+        return 2;
+    }
+
+    std::vector<bt_bbox_t> objects;
+    std::vector<bt_bbox_t> tracks(512);
+    size_t                 compared = 0;
+    bool                   ok       = true;
+    for (size_t f = 0; f < det.size() && ok; ++f) {
+        objects.resize(det[f].size());
+        for (size_t i = 0; i < det[f].size(); ++i) {
+            memcpy(objects[i].tlwh, det[f][i].box, sizeof(objects[i].tlwh));
+            objects[i].prob     = det[f][i].conf;
+            objects[i].label    = 0;
+            objects[i].track_id = 0;
+        }
+
+        size_t     num_tracks = 0;
+        bt_error_t err        = bt_tracker_update_into(tracker, objects.data(), objects.size(), tracks.data(), tracks.size(), &num_tracks);
+        if (err != BT_ERR_OK) {
+            printf("frame %zu: update failed (%d)\n", f + 1, (int)err);
+            ok = false;
+            break;
+        }
+
+        std::vector<Row> actual(num_tracks);
+        for (size_t i = 0; i < num_tracks; ++i) {
+            actual[i].id = tracks[i].track_id;
+            memcpy(actual[i].box, tracks[i].tlwh, sizeof(actual[i].box));
+            actual[i].conf = tracks[i].prob;
+        }
+        ok = same_frame(f + 1, expected[f], actual);
+        compared += num_tracks;
+    }
+    bt_tracker_destroy(tracker);
+
+    if (ok) {
+        printf("%zu frames, %zu tracks match\n", det.size(), compared);
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,251 @@
+/*
+ * Long-running soak test of the tracker.
+ *
+ * Streams a generated scene with steady object churn (objects leave after a random lifetime and
+ * are replaced, detections are missed, noisy and mixed with false positives) through one tracker
+ * for as many frames as requested and checks that:
+ *  - the live C++ heap stays bounded once the tracker has warmed up. The track pool and scratch
+ *    buffers still grow when the scene reaches a new peak of tracks or detections, and the pool
+ *    grows by doubling, so the heap may reach twice its warm-up size; anything kept per removed
+ *    track would pass that within a few thousand births;
+ *  - the lifecycle events are consistent: NEW for a track not alive, LOST, REFOUND and REMOVED only
+ *    for live tracks, and every reported track is alive;
+ *  - a lost track is refound or removed within the track buffer, so the tracker holds no history
+ *    beyond it.
+ * Exits non-zero on the first violation.
+ */
+
+#include <malloc.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+#include "bytetrack_c_api.h"
+
+// Live bytes of the C++ allocations made inside the tracker calls, the tracker allocates through
+// operator new only. The bookkeeping of the test itself runs with counting switched off.
+static long g_live_bytes = 0;
+static bool g_counting   = false;
+
+static void* counted_alloc(size_t size, size_t align) {
+    void* ptr = align > alignof(std::max_align_t) ? aligned_alloc(align, (size + align - 1) / align * align) : malloc(size ? size : 1);
+    if (ptr == nullptr) throw std::bad_alloc();
+    if (g_counting) g_live_bytes += malloc_usable_size(ptr);
+    return ptr;
+}
+
+static void counted_free(void* ptr) {
+    if (ptr == nullptr) return;
+    if (g_counting) g_live_bytes -= malloc_usable_size(ptr);
+    free(ptr);
+}
+
+void* operator new(size_t size) { return counted_alloc(size, 0); }
+void* operator new[](size_t size) { return counted_alloc(size, 0); }
+void* operator new(size_t size, std::align_val_t align) { return counted_alloc(size, (size_t)align); }
+void* operator new[](size_t size, std::align_val_t align) { return counted_alloc(size, (size_t)align); }
+void  operator delete(void* ptr) noexcept { counted_free(ptr); }
+void  operator delete[](void* ptr) noexcept { counted_free(ptr); }
+void  operator delete(void* ptr, size_t) noexcept { counted_free(ptr); }
+void  operator delete[](void* ptr, size_t) noexcept { counted_free(ptr); }
+void  operator delete(void* ptr, std::align_val_t) noexcept { counted_free(ptr); }
+void  operator delete[](void* ptr, std::align_val_t) noexcept { counted_free(ptr); }
+void  operator delete(void* ptr, size_t, std::align_val_t) noexcept { counted_free(ptr); }
+void  operator delete[](void* ptr, size_t, std::align_val_t) noexcept { counted_free(ptr); }
+
+struct Lifecycle {
+    int  max_time_lost;
+    long frame;
+    long births;
+    bool ok;
+
+    // Frame the track was lost on, -1 while it is tracked
+    std::unordered_map<int, long> live;
+};
+
+static void fail(Lifecycle& lc, const char* what, int track_id) {
+    if (lc.ok) printf("frame %ld: %s (track %d)\n", lc.frame, what, track_id);
+    lc.ok = false;
+}
+
+static void on_event(const bt_track_event_t* event, void* user_ctx) {
+    g_counting    = false;
+    Lifecycle& lc = *static_cast<Lifecycle*>(user_ctx);
+    int        id = event->track.track_id;
+    auto       it = lc.live.find(id);
+    switch (event->type) {
+        case BT_TRACK_EVENT_NEW:
+            if (it != lc.live.end()) fail(lc, "NEW for a live track", id);
+            lc.live[id] = -1;
+            lc.births++;
+            break;
+        case BT_TRACK_EVENT_LOST:
+            if (it == lc.live.end() || it->second >= 0) fail(lc, "LOST for a track that is not tracked", id);
+            else it->second = lc.frame;
+            break;
+        case BT_TRACK_EVENT_REFOUND:
+            if (it == lc.live.end() || it->second < 0) fail(lc, "REFOUND for a track that is not lost", id);
+            else it->second = -1;
+            break;
+        case BT_TRACK_EVENT_REMOVED:
+            if (it == lc.live.end()) fail(lc, "REMOVED for a dead track", id);
+            else lc.live.erase(it);
+            break;
+    }
+    g_counting = true;
+}
+
+static void usage(const char* prog) {
+    printf("usage: %s [options]\n"
+           "  --frames N    frames to run (default 2000000)\n"
+           "  --objects N   objects in view (default 20)\n"
+           "  --warmup N    frames before the heap is expected to stay flat (default 5000)\n"
+           "  --seed N      scene seed (default 1)\n",
+           prog);
+}
+
+int main(int argc, char** argv) {
+    long frames  = 2000000;
+    int  objects = 20;
+    long warmup  = 5000;
+    int  seed    = 1;
+    for (int i = 1; i < argc; ++i) {
+        const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (value == nullptr) {
+            usage(argv[0]);
+            return 2;
+        }
+        if (!strcmp(argv[i], "--frames")) {
+            frames = atol(value);
+        } else if (!strcmp(argv[i], "--objects")) {
+            objects = atoi(value);
+        } else if (!strcmp(argv[i], "--warmup")) {
+            warmup = atol(value);
+        } else if (!strcmp(argv[i], "--seed")) {
+            seed = atoi(value);
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+        ++i;
+    }
+    if (frames <= warmup || objects <= 0 || warmup < 0) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    std::vector<bt_bbox_t> dets;
+    std::vector<bt_bbox_t> tracks(objects * 4 + 64);
+    dets.reserve(objects * 2 + 8);
+
+    bt_config_t config = BT_CONFIG_DEFAULT();
+    g_counting         = true;
+    bt_handler_t tracker = bt_tracker_create(&config);
+    g_counting           = false;
+    if (tracker == nullptr) {
+        fprintf(stderr, "cannot create tracker\n");
+        return 2;
+    }
+
+    Lifecycle lc;
+    lc.max_time_lost = int(config.frame_rate / 30.0 * config.track_buffer);
+    lc.frame         = 0;
+    lc.births        = 0;
+    lc.ok            = true;
+    lc.live.reserve(objects * 16);
+    bt_tracker_set_event_callback(tracker, on_event, &lc);
+
+    // The scene of bt_mot_bench --synthetic, generated frame by frame; objects wrap around the view
+    std::mt19937                          rng(seed);
+    std::uniform_real_distribution<float> uni(0.f, 1.f);
+    std::normal_distribution<float>       noise(0.f, 1.f);
+    struct Object {
+        float x, y, w, h, vx, vy;
+        int   life;
+    };
+    auto spawn = [&](Object& o) {
+        o.w    = 20 + uni(rng) * 40;
+        o.h    = o.w * (1.5f + uni(rng));
+        o.x    = uni(rng) * (1920 - o.w);
+        o.y    = uni(rng) * (1080 - o.h);
+        o.vx   = (uni(rng) - 0.5f) * 8;
+        o.vy   = (uni(rng) - 0.5f) * 4;
+        o.life = 30 + (int)(uni(rng) * 300);
+    };
+    std::vector<Object> scene(objects);
+    for (auto& o : scene) spawn(o);
+
+    long   heap_warm = 0, heap_peak = 0;
+    size_t max_live = 0;
+    for (long f = 1; f <= frames && lc.ok; ++f) {
+        lc.frame = f;
+        dets.clear();
+        for (auto& o : scene) {
+            if (--o.life < 0) spawn(o);
+            o.x = fmodf(o.x + o.vx + 1920, 1920);
+            o.y = fmodf(o.y + o.vy + 1080, 1080);
+            if (uni(rng) < 0.1f) continue;  // missed
+
+            float     s = 0.03f * o.h;
+            bt_bbox_t box;
+            box.tlwh[0]  = o.x + noise(rng) * s;
+            box.tlwh[1]  = o.y + noise(rng) * s;
+            box.tlwh[2]  = o.w + noise(rng) * s;
+            box.tlwh[3]  = o.h + noise(rng) * s;
+            box.prob     = uni(rng) < 0.2f ? 0.1f + 0.4f * uni(rng) : 0.5f + 0.5f * uni(rng);
+            box.label    = 0;
+            box.track_id = 0;
+            dets.push_back(box);
+        }
+        for (int k = 0; k < objects / 20 + 1; ++k) {
+            if (uni(rng) < 0.3f) {
+                bt_bbox_t box = {{uni(rng) * 1800, uni(rng) * 1000, 30, 60}, 0.1f + 0.6f * uni(rng), 0, 0};
+                dets.push_back(box);
+            }
+        }
+
+        size_t num_tracks = 0;
+        g_counting        = true;
+        bt_error_t err    = bt_tracker_update_into(tracker, dets.data(), dets.size(), tracks.data(), tracks.size(), &num_tracks);
+        g_counting        = false;
+        if (err != BT_ERR_OK) {
+            printf("frame %ld: update failed (%d)\n", f, (int)err);
+            lc.ok = false;
+            break;
+        }
+
+        for (size_t i = 0; i < num_tracks; ++i) {
+            auto it = lc.live.find(tracks[i].track_id);
+            if (it == lc.live.end() || it->second >= 0) fail(lc, "reported track is not tracked", tracks[i].track_id);
+        }
+        for (const auto& entry : lc.live) {
+            if (entry.second >= 0 && f - entry.second > lc.max_time_lost + 1) fail(lc, "lost track kept past the track buffer", entry.first);
+        }
+        max_live = std::max(max_live, lc.live.size());
+
+        long heap = g_live_bytes;
+        if (f == warmup) {
+            heap_warm = heap;
+        }
+        heap_peak = std::max(heap_peak, heap);
+        if (f > warmup && heap > 2 * heap_warm) {
+            printf("frame %ld: live heap grew from %ld bytes at warm-up to %ld\n", f, heap_warm, heap);
+            lc.ok = false;
+        }
+    }
+    bt_tracker_destroy(tracker);
+
+    printf("frames            %ld\n", frames);
+    printf("tracks born       %ld\n", lc.births);
+    printf("live tracks max   %zu\n", max_live);
+    printf("live heap bytes   %ld at warm-up, peak %ld\n", heap_warm, heap_peak);
+    return lc.ok ? 0 : 1;
+}
@@ -28,11 +28,59 @@ bt_handler_t bt_tracker_create(const bt_config_t* config);
  * @param tracks Output array of tracks
  * @param num_tracks Number of tracks in the output array
  * @return Error code
- * @note The caller is responsible for freeing the memory of the output tracks array
+ * @note If *tracks is NULL a new array is allocated and the caller is responsible for freeing it,
+ *       otherwise *tracks is used as the output buffer and *num_tracks must hold its capacity
 */
 bt_error_t bt_tracker_update(
   bt_handler_t tracker, const bt_bbox_t* objects, size_t num_objects, bt_bbox_t** tracks, size_t* num_tracks);
 
+/**
+ * @brief Update the tracker and write the tracks into a caller-owned buffer
+ * @param tracker BYTETrack handler
+ * @param objects Array of objects to update the tracker with
+ * @param num_objects Number of objects in the array
+ * @param tracks Output array of at least capacity tracks
+ * @param capacity Number of tracks the output array can hold
+ * @param num_tracks Number of tracks written to the output array
+ * @return Error code, BT_ERR_NO_SPACE if the tracks did not fit and the output was truncated
+ * @note No memory is allocated by this call once the tracker has reached its steady state
+*/
+bt_error_t bt_tracker_update_into(bt_handler_t     tracker,
+                                  const bt_bbox_t* objects,
+                                  size_t           num_objects,
+                                  bt_bbox_t*       tracks,
+                                  size_t           capacity,
+                                  size_t*          num_tracks);
+
+/**
+ * @brief Update the tracker with several consecutive frames in one call
+ * @param tracker BYTETrack handler
+ * @param objects Objects of all frames, stored back to back
+ * @param num_objects Number of objects of each frame, num_frames entries
+ * @param num_frames Number of frames
+ * @param tracks Output array, the tracks of all frames are stored back to back
+ * @param capacity Number of tracks the output array can hold in total
+ * @param num_tracks Number of tracks written for each frame, num_frames entries (may be NULL)
+ * @return Error code, BT_ERR_NO_SPACE if some tracks did not fit and were dropped
+ * @note All frames are always fed to the tracker, even once the output array is full
+*/
+bt_error_t bt_tracker_update_batch(bt_handler_t     tracker,
+                                   const bt_bbox_t* objects,
+                                   const size_t*    num_objects,
+                                   size_t           num_frames,
+                                   bt_bbox_t*       tracks,
+                                   size_t           capacity,
+                                   size_t*          num_tracks);
+
+/**
+ * @brief Register a callback for track lifecycle events
+ * @param tracker BYTETrack handler
+ * @param callback Called from the update functions once per event, after the frame has been processed; NULL to disable
+ * @param user_ctx Passed back to the callback
+ * @return Error code
+*/
+bt_error_t bt_tracker_set_event_callback(bt_handler_t tracker, bt_track_event_cb_t callback, void* user_ctx);
+
 /**
  * @brief Destroy the BYTETrack handler
  * @param tracker BYTETrack handler
@@ -40,6 +88,53 @@ bt_error_t bt_tracker_update(
 */
 bt_error_t bt_tracker_destroy(bt_handler_t tracker);
 
+/**
+ * @brief Create a tracker manager running one tracker per stream on a shared thread pool
+ * @param config Manager configuration
+ * @return Manager handler, NULL on failure
+ * @note Frames of one stream are tracked in submission order, different streams run in parallel
+*/
+bt_manager_handler_t bt_manager_create(const bt_manager_config_t* config);
+
+/**
+ * @brief Queue frames of one or more streams for tracking
+ * @param manager Manager handler
+ * @param frames Frames to queue, the objects are copied
+ * @param num_frames Number of frames
+ * @param num_submitted Number of frames queued (may be NULL)
+ * @return Error code, BT_ERR_NO_SPACE once max_pending frames are waiting to be polled
+ * @note Frames are queued in order and queueing stops at the first frame that is rejected
+*/
+bt_error_t bt_manager_submit(bt_manager_handler_t     manager,
+                             const bt_stream_frame_t* frames,
+                             size_t                   num_frames,
+                             size_t*                  num_submitted);
+
+/**
+ * @brief Collect tracked frames without blocking
+ * @param manager Manager handler
+ * @param results Output array of results
+ * @param max_results Number of results the output array can hold
+ * @param tracks Output array, the tracks of all results are stored back to back
+ * @param capacity Number of tracks the output array can hold
+ * @param num_results Number of results written
+ * @return Error code, BT_ERR_NO_SPACE if a single result had more tracks than capacity and was truncated
+ * @note Results of one stream are returned in submission order. Must not be called from several threads at once
+*/
+bt_error_t bt_manager_poll(bt_manager_handler_t manager,
+                           bt_stream_result_t*  results,
+                           size_t               max_results,
+                           bt_bbox_t*           tracks,
+                           size_t               capacity,
+                           size_t*              num_results);
+
+/**
+ * @brief Destroy the manager, frames still queued are tracked and dropped
+ * @param manager Manager handler
+ * @return Error code
+*/
+bt_error_t bt_manager_destroy(bt_manager_handler_t manager);
+
 #ifdef __cplusplus
 }
 #endif
@@ -12,7 +12,7 @@
 #include <stdint.h>
 
 #define BT_CONFIG_DEFAULT() \
-    { .frame_rate = 10, .track_buffer = 15, .track_thresh = 0.5, .high_thresh = 0.6, .match_thresh = 0.8, }
+    { .frame_rate = 10, .track_buffer = 15, .track_thresh = 0.5, .high_thresh = 0.6, .match_thresh = 0.8, .association = BT_ASSOCIATION_DENSE, }
 
 #ifdef __cplusplus
 extern "C" {
@@ -25,24 +25,82 @@ typedef struct bt_bbox_t {
     int   track_id;
 } bt_bbox_t;
 
+/**
+ * @brief Track/detection association strategy
+ *
+ * BT_ASSOCIATION_DENSE scores every track against every detection and solves one assignment.
+ * BT_ASSOCIATION_GATED only scores pairs whose boxes share a spatial grid cell and solves each
+ * group of overlapping pairs on its own; it gives the same tracks (up to ties) and scales with the
+ * number of overlaps instead of tracks x detections, which pays off in crowded scenes.
+ */
+typedef enum {
+    BT_ASSOCIATION_DENSE = 0,
+    BT_ASSOCIATION_GATED,
+} bt_association_t;
+
 typedef struct bt_config_t {
-    int   frame_rate;
-    int   track_buffer;
-    float track_thresh;
-    float high_thresh;
-    float match_thresh;
+    int              frame_rate;
+    int              track_buffer;
+    float            track_thresh;
+    float            high_thresh;
+    float            match_thresh;
+    bt_association_t association;
 } bt_config_t;
 
+/**
+ * @brief Track lifecycle events, only tracks that have been reported as active produce events
+ */
+typedef enum {
+    BT_TRACK_EVENT_NEW = 0, /*!< track reported for the first time, or again right after its removal */
+    BT_TRACK_EVENT_LOST,    /*!< track no longer matched, kept for re-identification */
+    BT_TRACK_EVENT_REFOUND, /*!< lost track matched again */
+    BT_TRACK_EVENT_REMOVED, /*!< track dropped by the tracker */
+} bt_track_event_type_t;
+
+typedef struct bt_track_event_t {
+    bt_track_event_type_t type;
+    int                   frame_id;
+    bt_bbox_t             track;
+} bt_track_event_t;
+
+typedef void (*bt_track_event_cb_t)(const bt_track_event_t* event, void* user_ctx);
+
 typedef enum {
     BT_ERR_OK              = 0,
     BT_ERR_FAIL            = -1,
     BT_ERR_INVALID_TRACKER = -2,
     BT_ERR_INVALID_OBJECTS = -3,
+    BT_ERR_NO_SPACE        = -4,
     BT_ERR_MEM_ALLOC_FAIL  = -5,
 } bt_error_t;
 
 typedef void* bt_handler_t;
 
+#define BT_MANAGER_CONFIG_DEFAULT() \
+    { .tracker = BT_CONFIG_DEFAULT(), .max_streams = 16, .num_workers = 0, .max_pending = 256, }
+
+typedef struct bt_manager_config_t {
+    bt_config_t tracker;     /*!< configuration of every stream's tracker */
+    size_t      max_streams; /*!< stream IDs range from 0 to max_streams - 1 */
+    size_t      num_workers; /*!< worker threads, 0 for one per hardware thread */
+    size_t      max_pending; /*!< frames submitted but not yet polled, across all streams */
+} bt_manager_config_t;
+
+typedef struct bt_stream_frame_t {
+    uint32_t         stream_id;
+    const bt_bbox_t* objects;
+    size_t           num_objects;
+} bt_stream_frame_t;
+
+typedef struct bt_stream_result_t {
+    uint32_t   stream_id;
+    uint32_t   seq;        /*!< index of the frame within its stream, in submission order */
+    bt_bbox_t* tracks;     /*!< points into the tracks buffer passed to bt_manager_poll */
+    size_t     num_tracks;
+} bt_stream_result_t;
+
+typedef void* bt_manager_handler_t;
+
 #ifdef __cplusplus
 }
 #endif
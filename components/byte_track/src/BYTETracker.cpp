@@ -1,222 +1,346 @@
-/*
- * MIT License
- * Copyright (c) 2021 Yifu Zhang
- *
- * Modified by nullptr, Apr 15, 2024, Seeed Technology Co.,Ltd
-*/
-
-#include "BYTETracker.h"
-
-#include <cstdint>
-#include <utility>
-#include <vector>
-
-using namespace std;
-
-BYTETracker::BYTETracker(int frame_rate, int track_buffer) {
-    track_thresh = 0.5;
-    high_thresh  = 0.6;
-    match_thresh = 0.8;
-
-    frame_id      = 0;
-    max_time_lost = int(frame_rate / 30.0 * track_buffer);
-}
-
-BYTETracker::BYTETracker(const bt_config_t* config) {
-    track_thresh = config->track_thresh;
-    high_thresh  = config->high_thresh;
-    match_thresh = config->match_thresh;
-
-    frame_id      = 0;
-    max_time_lost = int(config->frame_rate / 30.0 * config->track_buffer);
-}
-
-BYTETracker::~BYTETracker() {}
-
-vector<STrack> BYTETracker::update(const bt_bbox_t* objects, size_t num_objects) {
-    ////////////////// Step 1: Get detections //////////////////
-    this->frame_id += 1;
-
-    vector<STrack> activated_stracks;
-    vector<STrack> refind_stracks;
-    vector<STrack> removed_stracks;
-    vector<STrack> lost_stracks;
-    vector<STrack> detections;
-    vector<STrack> detections_low;
-
-    vector<STrack> detections_cp;
-    vector<STrack> tracked_stracks_swap;
-    vector<STrack> resa, resb;
-    vector<STrack> output_stracks;
-
-    vector<STrack*> unconfirmed;
-    vector<STrack*> tracked_stracks;
-    vector<STrack*> strack_pool;
-    vector<STrack*> r_tracked_stracks;
-
-    for (size_t i = 0; i < num_objects; ++i) {
-        vector<float> tlwh_;
-        tlwh_.resize(4);
-
-        tlwh_[0] = objects[i].tlwh[0];
-        tlwh_[1] = objects[i].tlwh[1];
-        tlwh_[2] = objects[i].tlwh[2];
-        tlwh_[3] = objects[i].tlwh[3];
-
-        float score = objects[i].prob;
-        if (score >= track_thresh) {
-            detections.emplace_back(move(tlwh_), score, objects[i].label);
-        } else {
-            detections_low.emplace_back(move(tlwh_), score, objects[i].label);
-        }
-    }
-
-    // Add newly detected tracklets to tracked_stracks
-    for (size_t i = 0; i < this->tracked_stracks.size(); ++i) {
-        if (!this->tracked_stracks[i].is_activated)
-            unconfirmed.push_back(&this->tracked_stracks[i]);
-        else
-            tracked_stracks.push_back(&this->tracked_stracks[i]);
-    }
-
-    ////////////////// Step 2: First association, with IoU //////////////////
-    strack_pool = joint_stracks(tracked_stracks, this->lost_stracks);
-    STrack::multi_predict(strack_pool, this->kalman_filter);
-
-    vector<vector<float> > dists;
-    int                    dist_size = 0, dist_size_size = 0;
-    dists = iou_distance(strack_pool, detections, dist_size, dist_size_size);
-
-    vector<vector<int> > matches;
-    vector<int>          u_track, u_detection;
-    linear_assignment(dists, dist_size, dist_size_size, match_thresh, matches, u_track, u_detection);
-
-    for (int i = 0; i < matches.size(); ++i) {
-        STrack* track = strack_pool[matches[i][0]];
-        STrack* det   = &detections[matches[i][1]];
-        if (track->state == TrackState::Tracked) {
-            track->update(*det, this->frame_id);
-            activated_stracks.push_back(*track);
-        } else {
-            track->re_activate(*det, this->frame_id, false);
-            refind_stracks.push_back(*track);
-        }
-    }
-
-    ////////////////// Step 3: Second association, using low score dets //////////////////
-    for (int i = 0; i < u_detection.size(); ++i) {
-        detections_cp.push_back(move(detections[u_detection[i]]));
-    }
-    detections.clear();
-    detections.assign(detections_low.begin(), detections_low.end());
-
-    for (int i = 0; i < u_track.size(); ++i) {
-        auto idx = u_track[i];
-        auto st  = strack_pool[idx];
-        if (st->state == TrackState::Tracked) {
-            r_tracked_stracks.push_back(st);
-        }
-    }
-
-    dists.clear();
-    dists = iou_distance(r_tracked_stracks, detections, dist_size, dist_size_size);
-
-    matches.clear();
-    u_track.clear();
-    u_detection.clear();
-    linear_assignment(dists, dist_size, dist_size_size, 0.5, matches, u_track, u_detection);
-
-    for (int i = 0; i < matches.size(); ++i) {
-        STrack* track = r_tracked_stracks[matches[i][0]];
-        STrack* det   = &detections[matches[i][1]];
-        if (track->state == TrackState::Tracked) {
-            track->update(*det, this->frame_id);
-            activated_stracks.push_back(*track);
-        } else {
-            track->re_activate(*det, this->frame_id, false);
-            refind_stracks.push_back(*track);
-        }
-    }
-
-    for (int i = 0; i < u_track.size(); ++i) {
-        STrack* track = r_tracked_stracks[u_track[i]];
-        if (track->state != TrackState::Lost) {
-            track->mark_lost();
-            lost_stracks.push_back(*track);
-        }
-    }
-
-    // Deal with unconfirmed tracks, usually tracks with only one beginning frame
-    detections.clear();
-    detections.assign(detections_cp.begin(), detections_cp.end());
-
-    dists.clear();
-    dists = iou_distance(unconfirmed, detections, dist_size, dist_size_size);
-
-    matches.clear();
-    vector<int> u_unconfirmed;
-    u_detection.clear();
-    linear_assignment(dists, dist_size, dist_size_size, 0.7, matches, u_unconfirmed, u_detection);
-
-    for (int i = 0; i < matches.size(); ++i) {
-        unconfirmed[matches[i][0]]->update(detections[matches[i][1]], this->frame_id);
-        activated_stracks.push_back(*unconfirmed[matches[i][0]]);
-    }
-
-    for (int i = 0; i < u_unconfirmed.size(); ++i) {
-        STrack* track = unconfirmed[u_unconfirmed[i]];
-        track->mark_removed();
-        removed_stracks.push_back(*track);
-    }
-
-    ////////////////// Step 4: Init new stracks //////////////////
-    for (int i = 0; i < u_detection.size(); ++i) {
-        STrack* track = &detections[u_detection[i]];
-        if (track->score < this->high_thresh) continue;
-        track->activate(this->kalman_filter, this->frame_id);
-        activated_stracks.push_back(*track);
-    }
-
-    ////////////////// Step 5: Update state //////////////////
-    for (int i = 0; i < this->lost_stracks.size(); ++i) {
-        if (this->frame_id - this->lost_stracks[i].end_frame() > this->max_time_lost) {
-            this->lost_stracks[i].mark_removed();
-            removed_stracks.push_back(this->lost_stracks[i]);
-        }
-    }
-
-    for (int i = 0; i < this->tracked_stracks.size(); ++i) {
-        if (this->tracked_stracks[i].state == TrackState::Tracked) {
-            tracked_stracks_swap.push_back(this->tracked_stracks[i]);
-        }
-    }
-    this->tracked_stracks.clear();
-    this->tracked_stracks.assign(tracked_stracks_swap.begin(), tracked_stracks_swap.end());
-
-    this->tracked_stracks = joint_stracks(this->tracked_stracks, activated_stracks);
-    this->tracked_stracks = joint_stracks(this->tracked_stracks, refind_stracks);
-
-    this->lost_stracks = sub_stracks(this->lost_stracks, this->tracked_stracks);
-    for (int i = 0; i < lost_stracks.size(); ++i) {
-        this->lost_stracks.push_back(lost_stracks[i]);
-    }
-
-    this->lost_stracks = sub_stracks(this->lost_stracks, this->removed_stracks);
-    for (int i = 0; i < removed_stracks.size(); ++i) {
-        this->removed_stracks.push_back(removed_stracks[i]);
-    }
-
-    remove_duplicate_stracks(resa, resb, this->tracked_stracks, this->lost_stracks);
-
-    this->tracked_stracks.clear();
-    this->tracked_stracks.assign(resa.begin(), resa.end());
-    this->lost_stracks.clear();
-    this->lost_stracks.assign(resb.begin(), resb.end());
-
-    for (int i = 0; i < this->tracked_stracks.size(); ++i) {
-        if (this->tracked_stracks[i].is_activated) {
-            output_stracks.push_back(this->tracked_stracks[i]);
-        }
-    }
-    return output_stracks;
-}
\ No newline at end of file
+/*
+ * MIT License
+ * Copyright (c) 2021 Yifu Zhang
+ *
+ * Modified by nullptr, Apr 15, 2024, Seeed Technology Co.,Ltd
+*/
+
+#include "BYTETracker.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+BYTETracker::BYTETracker(int frame_rate, int track_buffer) {
+    track_thresh = 0.5;
+    high_thresh  = 0.6;
+    match_thresh = 0.8;
+    gated        = false;
+
+    frame_id      = 0;
+    max_time_lost = int(frame_rate / 30.0 * track_buffer);
+
+    event_cb  = nullptr;
+    event_ctx = nullptr;
+
+    reserve_slots(POOL_INIT_SIZE);
+}
+
+BYTETracker::BYTETracker(const bt_config_t* config) {
+    track_thresh = config->track_thresh;
+    high_thresh  = config->high_thresh;
+    match_thresh = config->match_thresh;
+    gated        = config->association == BT_ASSOCIATION_GATED;
+
+    frame_id      = 0;
+    max_time_lost = int(config->frame_rate / 30.0 * config->track_buffer);
+
+    event_cb  = nullptr;
+    event_ctx = nullptr;
+
+    reserve_slots(POOL_INIT_SIZE);
+}
+
+BYTETracker::~BYTETracker() {}
+
+static void to_bbox(const STrack& track, bt_bbox_t& out) {
+    for (size_t j = 0; j < 4; ++j) {
+        out.tlwh[j] = track.tlwh[j];
+    }
+    out.prob     = track.score;
+    out.label    = track.label;
+    out.track_id = track.track_id;
+}
+
+void BYTETracker::set_event_callback(bt_track_event_cb_t callback, void* user_ctx) {
+    event_cb  = callback;
+    event_ctx = user_ctx;
+}
+
+void BYTETracker::push_event(bt_track_event_type_t type, STrack* track) {
+    if (event_cb != nullptr) {
+        scratch.events.emplace_back(type, track);
+    }
+}
+
+void BYTETracker::reserve_slots(size_t count) {
+    if (free_slots.size() >= count) return;
+
+    // Remember list positions as indices, the pool storage may move
+    vector<size_t> tracked_idx, lost_idx, free_idx;
+    for (auto t : this->tracked_stracks) tracked_idx.push_back(t - pool.data());
+    for (auto t : this->lost_stracks) lost_idx.push_back(t - pool.data());
+    for (auto t : this->free_slots) free_idx.push_back(t - pool.data());
+
+    size_t old_size = pool.size();
+    size_t new_size = max(old_size * 2, old_size + count - free_slots.size());
+    pool.resize(new_size);
+    slot_live.resize(new_size);
+
+    for (size_t i = 0; i < tracked_idx.size(); ++i) this->tracked_stracks[i] = &pool[tracked_idx[i]];
+    for (size_t i = 0; i < lost_idx.size(); ++i) this->lost_stracks[i] = &pool[lost_idx[i]];
+    for (size_t i = 0; i < free_idx.size(); ++i) free_slots[i] = &pool[free_idx[i]];
+
+    free_slots.reserve(new_size);
+    for (size_t i = new_size; i > old_size; --i) {
+        free_slots.push_back(&pool[i - 1]);
+    }
+}
+
+void BYTETracker::release_slots() {
+    // Any slot not referenced by the tracked or lost lists goes back to the free list
+    std::fill(slot_live.begin(), slot_live.end(), 0);
+    for (auto t : this->tracked_stracks) slot_live[t - pool.data()] = 1;
+    for (auto t : this->lost_stracks) slot_live[t - pool.data()] = 1;
+
+    free_slots.clear();
+    for (size_t i = pool.size(); i > 0; --i) {
+        if (!slot_live[i - 1]) free_slots.push_back(&pool[i - 1]);
+    }
+}
+
+const vector<STrack*>& BYTETracker::update(const bt_bbox_t* objects, size_t num_objects) {
+    vector<STrack*>& output_stracks = scratch.output_stracks;
+
+    step(objects, num_objects);
+
+    output_stracks.clear();
+    for (size_t i = 0; i < this->tracked_stracks.size(); ++i) {
+        if (this->tracked_stracks[i]->is_activated) {
+            output_stracks.push_back(this->tracked_stracks[i]);
+        }
+    }
+    return output_stracks;
+}
+
+size_t BYTETracker::update(const bt_bbox_t* objects, size_t num_objects, bt_bbox_t* tracks, size_t capacity) {
+    step(objects, num_objects);
+
+    size_t count = 0;
+    for (size_t i = 0; i < this->tracked_stracks.size(); ++i) {
+        const STrack* track = this->tracked_stracks[i];
+        if (!track->is_activated) continue;
+        if (count < capacity) {
+            to_bbox(*track, tracks[count]);
+        }
+        ++count;
+    }
+    return count;
+}
+
+void BYTETracker::step(const bt_bbox_t* objects, size_t num_objects) {
+    ////////////////// Step 1: Get detections //////////////////
+    this->frame_id += 1;
+
+    reserve_slots(num_objects);
+
+    vector<STrack*>& activated_stracks = scratch.activated_stracks;
+    vector<STrack*>& refind_stracks    = scratch.refind_stracks;
+    vector<STrack*>& removed_stracks   = scratch.removed_stracks;
+    vector<STrack*>& lost_stracks      = scratch.lost_stracks;
+    vector<STrack*>& detections        = scratch.detections;
+    vector<STrack*>& detections_low    = scratch.detections_low;
+
+    vector<STrack*>& detections_cp        = scratch.detections_cp;
+    vector<STrack*>& tracked_stracks_swap = scratch.stracks_swap;
+    vector<STrack*>& resa                 = scratch.resa;
+    vector<STrack*>& resb                 = scratch.resb;
+
+    vector<STrack*>& unconfirmed       = scratch.unconfirmed;
+    vector<STrack*>& tracked_stracks   = scratch.tracked_stracks;
+    vector<STrack*>& strack_pool       = scratch.strack_pool;
+    vector<STrack*>& r_tracked_stracks = scratch.r_tracked_stracks;
+
+    vector<pair<int, int> >& matches       = scratch.matches;
+    vector<int>&             u_track       = scratch.u_track;
+    vector<int>&             u_detection   = scratch.u_detection;
+    vector<int>&             u_unconfirmed = scratch.u_unconfirmed;
+
+    activated_stracks.clear();
+    refind_stracks.clear();
+    removed_stracks.clear();
+    lost_stracks.clear();
+    detections.clear();
+    detections_low.clear();
+    detections_cp.clear();
+    tracked_stracks_swap.clear();
+    resa.clear();
+    resb.clear();
+    unconfirmed.clear();
+    tracked_stracks.clear();
+    r_tracked_stracks.clear();
+    scratch.events.clear();
+
+    for (size_t i = 0; i < num_objects; ++i) {
+        STrack* det = free_slots.back();
+        free_slots.pop_back();
+
+        float score = objects[i].prob;
+        *det        = STrack(objects[i].tlwh, score, objects[i].label);
+        if (score >= track_thresh) {
+            detections.push_back(det);
+        } else {
+            detections_low.push_back(det);
+        }
+    }
+
+    // Add newly detected tracklets to tracked_stracks
+    for (size_t i = 0; i < this->tracked_stracks.size(); ++i) {
+        if (!this->tracked_stracks[i]->is_activated)
+            unconfirmed.push_back(this->tracked_stracks[i]);
+        else
+            tracked_stracks.push_back(this->tracked_stracks[i]);
+    }
+
+    ////////////////// Step 2: First association, with IoU //////////////////
+    joint_stracks(tracked_stracks, this->lost_stracks, strack_pool);
+    STrack::multi_predict(strack_pool, this->kalman_filter);
+
+    matches.clear();
+    u_track.clear();
+    u_detection.clear();
+    associate(strack_pool, detections, match_thresh, matches, u_track, u_detection);
+
+    for (size_t i = 0; i < matches.size(); ++i) {
+        STrack* track = strack_pool[matches[i].first];
+        STrack* det   = detections[matches[i].second];
+        if (track->state == TrackState::Tracked) {
+            track->update(this->kalman_filter, *det, this->frame_id);
+            activated_stracks.push_back(track);
+        } else {
+            // a track removed last frame is still in the lost list for one more frame and may come back
+            bt_track_event_type_t event = track->state == TrackState::Removed ? BT_TRACK_EVENT_NEW : BT_TRACK_EVENT_REFOUND;
+            track->re_activate(this->kalman_filter, *det, this->frame_id, false);
+            refind_stracks.push_back(track);
+            push_event(event, track);
+        }
+    }
+
+    ////////////////// Step 3: Second association, using low score dets //////////////////
+    for (size_t i = 0; i < u_detection.size(); ++i) {
+        detections_cp.push_back(detections[u_detection[i]]);
+    }
+    detections.assign(detections_low.begin(), detections_low.end());
+
+    for (size_t i = 0; i < u_track.size(); ++i) {
+        auto idx = u_track[i];
+        auto st  = strack_pool[idx];
+        if (st->state == TrackState::Tracked) {
+            r_tracked_stracks.push_back(st);
+        }
+    }
+
+    matches.clear();
+    u_track.clear();
+    u_detection.clear();
+    associate(r_tracked_stracks, detections, 0.5, matches, u_track, u_detection);
+
+    for (size_t i = 0; i < matches.size(); ++i) {
+        STrack* track = r_tracked_stracks[matches[i].first];
+        STrack* det   = detections[matches[i].second];
+        if (track->state == TrackState::Tracked) {
+            track->update(this->kalman_filter, *det, this->frame_id);
+            activated_stracks.push_back(track);
+        } else {
+            track->re_activate(this->kalman_filter, *det, this->frame_id, false);
+            refind_stracks.push_back(track);
+            push_event(BT_TRACK_EVENT_REFOUND, track);
+        }
+    }
+
+    for (size_t i = 0; i < u_track.size(); ++i) {
+        STrack* track = r_tracked_stracks[u_track[i]];
+        if (track->state != TrackState::Lost) {
+            track->mark_lost();
+            lost_stracks.push_back(track);
+            push_event(BT_TRACK_EVENT_LOST, track);
+        }
+    }
+
+    // Deal with unconfirmed tracks, usually tracks with only one beginning frame
+    detections.assign(detections_cp.begin(), detections_cp.end());
+
+    matches.clear();
+    u_unconfirmed.clear();
+    u_detection.clear();
+    associate(unconfirmed, detections, 0.7, matches, u_unconfirmed, u_detection);
+
+    for (size_t i = 0; i < matches.size(); ++i) {
+        STrack* track = unconfirmed[matches[i].first];
+        track->update(this->kalman_filter, *detections[matches[i].second], this->frame_id);
+        activated_stracks.push_back(track);
+        push_event(BT_TRACK_EVENT_NEW, track);
+    }
+
+    // Never reported and never in the lost list, nothing to remember
+    for (size_t i = 0; i < u_unconfirmed.size(); ++i) {
+        unconfirmed[u_unconfirmed[i]]->mark_removed();
+    }
+
+    ////////////////// Step 4: Init new stracks //////////////////
+    for (size_t i = 0; i < u_detection.size(); ++i) {
+        STrack* track = detections[u_detection[i]];
+        if (track->score < this->high_thresh) continue;
+        track->activate(this->kalman_filter, this->frame_id);
+        activated_stracks.push_back(track);
+        if (track->is_activated) push_event(BT_TRACK_EVENT_NEW, track);
+    }
+
+    ////////////////// Step 5: Update state //////////////////
+    for (size_t i = 0; i < this->lost_stracks.size(); ++i) {
+        STrack* track = this->lost_stracks[i];
+        if (this->frame_id - track->end_frame() > this->max_time_lost && track->state != TrackState::Removed) {
+            track->mark_removed();
+            track->removed_frame = this->frame_id;
+            push_event(BT_TRACK_EVENT_REMOVED, track);
+        }
+    }
+
+    for (size_t i = 0; i < this->tracked_stracks.size(); ++i) {
+        if (this->tracked_stracks[i]->state == TrackState::Tracked) {
+            tracked_stracks_swap.push_back(this->tracked_stracks[i]);
+        }
+    }
+
+    joint_stracks(tracked_stracks_swap, activated_stracks, resa);
+    joint_stracks(resa, refind_stracks, this->tracked_stracks);
+
+    sub_stracks(this->lost_stracks, this->tracked_stracks, resb);
+    for (size_t i = 0; i < lost_stracks.size(); ++i) {
+        resb.push_back(lost_stracks[i]);
+    }
+
+    // Tracks removed on an earlier frame leave the lost list; this frame's removals stay in it for one
+    // more frame. A track re-found during that frame is dropped as soon as it is lost again.
+    for (size_t i = 0; i < resb.size(); ++i) {
+        STrack* track = resb[i];
+        if (track->removed_frame == 0 || track->removed_frame == this->frame_id) continue;
+        if (track->state != TrackState::Removed) {
+            track->mark_removed();
+            push_event(BT_TRACK_EVENT_REMOVED, track);
+        }
+        removed_stracks.push_back(track);
+    }
+    sub_stracks(resb, removed_stracks, this->lost_stracks);
+
+    resa.clear();
+    resb.clear();
+    remove_duplicate_stracks(resa, resb, this->tracked_stracks, this->lost_stracks);
+
+    this->tracked_stracks.swap(resa);
+    this->lost_stracks.swap(resb);
+
+    release_slots();
+
+    // Released slots keep their contents until the next frame, removed tracks are still readable here
+    for (size_t i = 0; i < scratch.events.size() && event_cb != nullptr; ++i) {
+        bt_track_event_t event;
+        event.type     = scratch.events[i].first;
+        event.frame_id = this->frame_id;
+        to_bbox(*scratch.events[i].second, event.track);
+        event_cb(&event, event_ctx);
+    }
+}
@@ -1,76 +1,145 @@
-/*
- * MIT License
- * Copyright (c) 2021 Yifu Zhang
- *
- * Modified by nullptr, Apr 15, 2024, Seeed Technology Co.,Ltd
-*/
-
-#pragma once
-
-#include <cfloat>
-#include <climits>
-#include <cstdint>
-#include <vector>
-
-#include "STrack.h"
-#include "bytetracl_c_types.h"
-
-class BYTETracker {
-   public:
-    struct Object {
-        Rect4f rect;
-        float  prob;
-        int    label = -1;
-    };
-
-   public:
-    BYTETracker(int frame_rate = 10, int track_buffer = 15);
-    BYTETracker(const bt_config_t* config);
-    ~BYTETracker();
-
-    std::vector<STrack> update(const bt_bbox_t* objects, size_t num_objects);
-
-   private:
-    std::vector<STrack*> joint_stracks(std::vector<STrack*>& tlista, std::vector<STrack>& tlistb);
-    std::vector<STrack>  joint_stracks(std::vector<STrack>& tlista, std::vector<STrack>& tlistb);
-
-    std::vector<STrack> sub_stracks(std::vector<STrack>& tlista, std::vector<STrack>& tlistb);
-    void                remove_duplicate_stracks(std::vector<STrack>& resa,
-                                                 std::vector<STrack>& resb,
-                                                 std::vector<STrack>& stracksa,
-                                                 std::vector<STrack>& stracksb);
-
-    void                             linear_assignment(std::vector<std::vector<float> >& cost_matrix,
-                                                       int                               cost_matrix_size,
-                                                       int                               cost_matrix_size_size,
-                                                       float                             thresh,
-                                                       std::vector<std::vector<int> >&   matches,
-                                                       std::vector<int>&                 unmatched_a,
-                                                       std::vector<int>&                 unmatched_b);
-    std::vector<std::vector<float> > iou_distance(std::vector<STrack*>& atracks,
-                                                  std::vector<STrack>&  btracks,
-                                                  int&                  dist_size,
-                                                  int&                  dist_size_size);
-    std::vector<std::vector<float> > iou_distance(std::vector<STrack>& atracks, std::vector<STrack>& btracks);
-    std::vector<std::vector<float> > ious(std::vector<std::vector<float> >& atlbrs,
-                                          std::vector<std::vector<float> >& btlbrs);
-
-    double lapjv(const std::vector<std::vector<float> >& cost,
-                 std::vector<int>&                       rowsol,
-                 std::vector<int>&                       colsol,
-                 bool                                    extend_cost = false,
-                 float                                   cost_limit  = LONG_MAX,
-                 bool                                    return_cost = true);
-
-   private:
-    float track_thresh;
-    float high_thresh;
-    float match_thresh;
-    int   frame_id;
-    int   max_time_lost;
-
-    std::vector<STrack>       tracked_stracks;
-    std::vector<STrack>       lost_stracks;
-    std::vector<STrack>       removed_stracks;
-    byte_kalman::KalmanFilter kalman_filter;
+/*
+ * MIT License
+ * Copyright (c) 2021 Yifu Zhang
+ *
+ * Modified by nullptr, Apr 15, 2024, Seeed Technology Co.,Ltd
+*/
+
+#pragma once
+
+#include <cfloat>
+#include <climits>
+#include <cstdint>
+#include <vector>
+
+#include "STrack.h"
+#include "gatedAssignment.h"
+#include "iouMatrix.h"
+#include "lapjv.h"
+#include "bytetracl_c_types.h"
+
+class BYTETracker {
+   public:
+    struct Object {
+        Rect4f rect;
+        float  prob;
+        int    label = -1;
+    };
+
+   public:
+    BYTETracker(int frame_rate = 10, int track_buffer = 15);
+    BYTETracker(const bt_config_t* config);
+    ~BYTETracker();
+
+    /**
+     * Run one tracking step.
+     *
+     * The returned tracks point into the tracker's own storage and stay valid until the next call
+     * to update(); no memory is allocated once the track pool and scratch buffers have grown to the
+     * scene's steady-state size.
+     */
+    const std::vector<STrack*>& update(const bt_bbox_t* objects, size_t num_objects);
+
+    /**
+     * Run one tracking step and write the active tracks straight into caller storage.
+     *
+     * At most `capacity` tracks are written; the return value is the number of active tracks,
+     * which exceeds `capacity` when the output was truncated.
+     */
+    size_t update(const bt_bbox_t* objects, size_t num_objects, bt_bbox_t* tracks, size_t capacity);
+
+    /**
+     * Report track births, losses, re-finds and removals.
+     *
+     * Events of a frame are delivered at the end of update(), before the tracks are returned.
+     */
+    void set_event_callback(bt_track_event_cb_t callback, void* user_ctx);
+
+   private:
+    void step(const bt_bbox_t* objects, size_t num_objects);
+
+    void joint_stracks(std::vector<STrack*>& tlista, std::vector<STrack*>& tlistb, std::vector<STrack*>& res);
+
+    void sub_stracks(std::vector<STrack*>& tlista, std::vector<STrack*>& tlistb, std::vector<STrack*>& res);
+    void remove_duplicate_stracks(std::vector<STrack*>& resa,
+                                  std::vector<STrack*>& resb,
+                                  std::vector<STrack*>& stracksa,
+                                  std::vector<STrack*>& stracksb);
+
+    void associate(std::vector<STrack*>&              atracks,
+                   std::vector<STrack*>&              btracks,
+                   float                              thresh,
+                   std::vector<std::pair<int, int> >& matches,
+                   std::vector<int>&                  unmatched_a,
+                   std::vector<int>&                  unmatched_b);
+    void linear_assignment(CostMatrix&                        cost_matrix,
+                           float                              thresh,
+                           std::vector<std::pair<int, int> >& matches,
+                           std::vector<int>&                  unmatched_a,
+                           std::vector<int>&                  unmatched_b);
+    void iou_distance(std::vector<STrack*>& atracks, std::vector<STrack*>& btracks, CostMatrix& cost_matrix);
+    void collect_assignment(std::vector<std::pair<int, int> >& matches, std::vector<int>& unmatched_a, std::vector<int>& unmatched_b);
+
+    void reserve_slots(size_t count);
+    void release_slots();
+
+    void push_event(bt_track_event_type_t type, STrack* track);
+
+   private:
+    static const size_t POOL_INIT_SIZE = 32;
+
+    float track_thresh;
+    float high_thresh;
+    float match_thresh;
+    bool  gated;
+    int   frame_id;
+    int   max_time_lost;
+
+    // Every track and detection lives in one flat pool; the lists below only hold pointers into it.
+    // The pool is grown (and the lists rebased) at the start of a frame, never while pointers are in use.
+    std::vector<STrack>  pool;
+    std::vector<STrack*> free_slots;
+    std::vector<uint8_t> slot_live;
+
+    std::vector<STrack*>      tracked_stracks;
+    std::vector<STrack*>      lost_stracks;
+    byte_kalman::KalmanFilter kalman_filter;
+
+    bt_track_event_cb_t event_cb;
+    void*               event_ctx;
+
+    // Track boxes in structure-of-arrays form for the IoU kernels
+    byte_iou::BoxesSoA        atlbrs, btlbrs;
+    LapjvSolver               lap_solver;
+    byte_iou::GatedAssignment gate;
+
+    // Per-frame working sets, cleared at the start of every update() but never shrunk.
+    struct {
+        std::vector<STrack*> activated_stracks;
+        std::vector<STrack*> refind_stracks;
+        std::vector<STrack*> removed_stracks;
+        std::vector<STrack*> lost_stracks;
+        std::vector<STrack*> detections;
+        std::vector<STrack*> detections_low;
+        std::vector<STrack*> detections_cp;
+        std::vector<STrack*> stracks_swap;
+        std::vector<STrack*> resa, resb;
+        std::vector<STrack*> output_stracks;
+
+        std::vector<STrack*> unconfirmed;
+        std::vector<STrack*> tracked_stracks;
+        std::vector<STrack*> strack_pool;
+        std::vector<STrack*> r_tracked_stracks;
+
+        CostMatrix dists, pdist;
+        TrackIdSet ids;
+
+        std::vector<uint8_t> dupa, dupb;
+
+        std::vector<std::pair<bt_track_event_type_t, STrack*> > events;
+
+        std::vector<std::pair<int, int> > matches;
+        std::vector<int>                  u_track, u_detection, u_unconfirmed;
+        std::vector<int>                  rowsol, colsol;
+    } scratch;
 };
\ No newline at end of file
@@ -1,8 +1,10 @@
 #include "bytetrack_c_api.h"
 
+#include <algorithm>
 #include <cstdlib>
 
 #include "BYTETracker.h"
+#include "trackerManager.h"
 
 bt_handler_t bt_tracker_create(const bt_config_t* config) {
     if (config == nullptr) {
@@ -23,9 +25,8 @@ bt_error_t bt_tracker_update(
         return BT_ERR_INVALID_OBJECTS;
     }
 
-    auto tracker_ptr = reinterpret_cast<BYTETracker*>(tracker);
-    auto tracks_vec  = tracker_ptr->update(objects, num_objects);
-    tracks_vec.shrink_to_fit();
+    auto        tracker_ptr = reinterpret_cast<BYTETracker*>(tracker);
+    const auto& tracks_vec  = tracker_ptr->update(objects, num_objects);
 
     if (num_tracks == nullptr) {
         return BT_ERR_OK;
@@ -36,20 +37,24 @@ bt_error_t bt_tracker_update(
         return BT_ERR_OK;
     }
 
-    void* tracks_ptr = nullptr;
-    if (*tracks == nullptr) {
-        tracks_ptr = calloc(tracks_vec.size(), sizeof(bt_bbox_t));
-        if (tracks_ptr == nullptr) {
-            return BT_ERR_MEM_ALLOC_FAIL;
+    bt_bbox_t* tracks_ptr = *tracks;
+    size_t     size       = tracks_vec.size();
+    if (tracks_ptr == nullptr) {
+        if (size != 0) {
+            tracks_ptr = reinterpret_cast<bt_bbox_t*>(calloc(size, sizeof(bt_bbox_t)));
+            if (tracks_ptr == nullptr) {
+                return BT_ERR_MEM_ALLOC_FAIL;
+            }
         }
-
-        *num_tracks = tracks_vec.size();
+    } else {
+        // caller provided the buffer, *num_tracks holds its capacity
+        size = std::min(size, *num_tracks);
     }
+    *num_tracks = size;
 
-    const auto size = std::min(tracks_vec.size(), *num_tracks);
     for (size_t i = 0; i < size; ++i) {
-        auto& track     = tracks_vec[i];
-        auto& track_ptr = reinterpret_cast<bt_bbox_t*>(tracks_ptr)[i];
+        auto& track     = *tracks_vec[i];
+        auto& track_ptr = tracks_ptr[i];
 
         for (size_t j = 0; j < 4; ++j) {
             track_ptr.tlwh[j] = track.tlwh[j];
@@ -59,7 +64,86 @@ bt_error_t bt_tracker_update(
         track_ptr.track_id = track.track_id;
     }
 
-    *tracks = reinterpret_cast<bt_bbox_t*>(tracks_ptr);
+    *tracks = tracks_ptr;
+
+    return BT_ERR_OK;
+}
+
+bt_error_t bt_tracker_update_into(bt_handler_t     tracker,
+                                  const bt_bbox_t* objects,
+                                  size_t           num_objects,
+                                  bt_bbox_t*       tracks,
+                                  size_t           capacity,
+                                  size_t*          num_tracks) {
+    if (tracker == nullptr) {
+        return BT_ERR_INVALID_TRACKER;
+    }
+
+    if ((objects == nullptr && num_objects != 0) || (tracks == nullptr && capacity != 0)) {
+        return BT_ERR_INVALID_OBJECTS;
+    }
+
+    auto   tracker_ptr = reinterpret_cast<BYTETracker*>(tracker);
+    size_t count       = tracker_ptr->update(objects, num_objects, tracks, capacity);
+
+    if (num_tracks != nullptr) {
+        *num_tracks = std::min(count, capacity);
+    }
+
+    return count > capacity ? BT_ERR_NO_SPACE : BT_ERR_OK;
+}
+
+bt_error_t bt_tracker_update_batch(bt_handler_t     tracker,
+                                   const bt_bbox_t* objects,
+                                   const size_t*    num_objects,
+                                   size_t           num_frames,
+                                   bt_bbox_t*       tracks,
+                                   size_t           capacity,
+                                   size_t*          num_tracks) {
+    if (tracker == nullptr) {
+        return BT_ERR_INVALID_TRACKER;
+    }
+
+    if ((num_objects == nullptr && num_frames != 0) || (tracks == nullptr && capacity != 0)) {
+        return BT_ERR_INVALID_OBJECTS;
+    }
+
+    auto       tracker_ptr = reinterpret_cast<BYTETracker*>(tracker);
+    bt_error_t ret         = BT_ERR_OK;
+    size_t     used        = 0;
+
+    for (size_t f = 0; f < num_frames; ++f) {
+        if (objects == nullptr && num_objects[f] != 0) {
+            return BT_ERR_INVALID_OBJECTS;
+        }
+
+        // Every frame advances the tracker, even once the output buffer is exhausted
+        size_t room  = capacity - used;
+        size_t count = tracker_ptr->update(objects, num_objects[f], tracks + used, room);
+        if (count > room) {
+            count = room;
+            ret   = BT_ERR_NO_SPACE;
+        }
+
+        if (num_tracks != nullptr) {
+            num_tracks[f] = count;
+        }
+        used += count;
+        if (objects != nullptr) {
+            objects += num_objects[f];
+        }
+    }
+
+    return ret;
+}
+
+bt_error_t bt_tracker_set_event_callback(bt_handler_t tracker, bt_track_event_cb_t callback, void* user_ctx) {
+    if (tracker == nullptr) {
+        return BT_ERR_INVALID_TRACKER;
+    }
+
+    auto tracker_ptr = reinterpret_cast<BYTETracker*>(tracker);
+    tracker_ptr->set_event_callback(callback, user_ctx);
 
     return BT_ERR_OK;
 }
@@ -74,3 +158,60 @@ bt_error_t bt_tracker_destroy(bt_handler_t tracker) {
 
     return BT_ERR_OK;
 }
+
+bt_manager_handler_t bt_manager_create(const bt_manager_config_t* config) {
+    if (config == nullptr || config->max_streams == 0 || config->max_pending == 0) {
+        return nullptr;
+    }
+
+    auto* manager = new TrackerManager(config);
+    return reinterpret_cast<bt_manager_handler_t>(manager);
+}
+
+bt_error_t bt_manager_submit(bt_manager_handler_t     manager,
+                             const bt_stream_frame_t* frames,
+                             size_t                   num_frames,
+                             size_t*                  num_submitted) {
+    if (manager == nullptr) {
+        return BT_ERR_INVALID_TRACKER;
+    }
+
+    if (frames == nullptr && num_frames != 0) {
+        return BT_ERR_INVALID_OBJECTS;
+    }
+
+    auto manager_ptr = reinterpret_cast<TrackerManager*>(manager);
+    return manager_ptr->submit(frames, num_frames, num_submitted);
+}
+
+bt_error_t bt_manager_poll(bt_manager_handler_t manager,
+                           bt_stream_result_t*  results,
+                           size_t               max_results,
+                           bt_bbox_t*           tracks,
+                           size_t               capacity,
+                           size_t*              num_results) {
+    if (manager == nullptr) {
+        return BT_ERR_INVALID_TRACKER;
+    }
+
+    if ((results == nullptr && max_results != 0) || (tracks == nullptr && capacity != 0) || num_results == nullptr) {
+        return BT_ERR_INVALID_OBJECTS;
+    }
+
+    auto manager_ptr = reinterpret_cast<TrackerManager*>(manager);
+    bool truncated   = false;
+    *num_results     = manager_ptr->poll(results, max_results, tracks, capacity, &truncated);
+
+    return truncated ? BT_ERR_NO_SPACE : BT_ERR_OK;
+}
+
+bt_error_t bt_manager_destroy(bt_manager_handler_t manager) {
+    if (manager == nullptr) {
+        return BT_ERR_INVALID_TRACKER;
+    }
+
+    auto manager_ptr = reinterpret_cast<TrackerManager*>(manager);
+    delete manager_ptr;
+
+    return BT_ERR_OK;
+}
\ No newline at end of file
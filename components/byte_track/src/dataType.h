@@ -1,54 +1,106 @@
-/*
- * MIT License
- * Copyright (c) 2021 Yifu Zhang
- *
- * Modified by nullptr, Apr 15, 2024, Seeed Technology Co.,Ltd
-*/
-
-#pragma once
-
-#include <cfloat>
-#include <cstddef>
-#include <cstdint>
-#include <vector>
-
-#include <eigen3/Eigen/Core>
-#include <eigen3/Eigen/Dense>
-
-typedef Eigen::Matrix<float, 1, 4, Eigen::RowMajor>                DETECTBOX;
-typedef Eigen::Matrix<float, -1, 4, Eigen::RowMajor>               DETECTBOXSS;
-typedef Eigen::Matrix<float, 1, 128, Eigen::RowMajor>              FEATURE;
-typedef Eigen::Matrix<float, Eigen::Dynamic, 128, Eigen::RowMajor> FEATURESS;
-
-//Kalmanfilter
-typedef Eigen::Matrix<float, 1, 8, Eigen::RowMajor> KAL_MEAN;
-typedef Eigen::Matrix<float, 8, 8, Eigen::RowMajor> KAL_COVA;
-typedef Eigen::Matrix<float, 1, 4, Eigen::RowMajor> KAL_HMEAN;
-typedef Eigen::Matrix<float, 4, 4, Eigen::RowMajor> KAL_HCOVA;
-using KAL_DATA  = std::pair<KAL_MEAN, KAL_COVA>;
-using KAL_HDATA = std::pair<KAL_HMEAN, KAL_HCOVA>;
-
-//main
-using RESULT_DATA = std::pair<int, DETECTBOX>;
-
-//tracker
-using TRACKER_DATA = std::pair<int, FEATURESS>;
-using MATCH_DATA   = std::pair<int, int>;
-
-//linear_assignment
-typedef Eigen::Matrix<float, -1, -1, Eigen::RowMajor> DYNAMICM;
-
-struct Rect4f {
-    float x;
-    float y;
-    float width;
-    float height;
-};
-
-struct Scalar3u {
-    Scalar3u(unsigned int v1, unsigned int v2, unsigned int v3) : val1(v1), val2(v2), val3(v3) {}
-
-    unsigned int val1;
-    unsigned int val2;
-    unsigned int val3;
-};
+/*
+ * MIT License
+ * Copyright (c) 2021 Yifu Zhang
+ *
+ * Modified by nullptr, Apr 15, 2024, Seeed Technology Co.,Ltd
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <cfloat>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <eigen3/Eigen/Core>
+#include <eigen3/Eigen/Dense>
+
+typedef Eigen::Matrix<float, 1, 4, Eigen::RowMajor>                DETECTBOX;
+typedef Eigen::Matrix<float, -1, 4, Eigen::RowMajor>               DETECTBOXSS;
+typedef Eigen::Matrix<float, 1, 128, Eigen::RowMajor>              FEATURE;
+typedef Eigen::Matrix<float, Eigen::Dynamic, 128, Eigen::RowMajor> FEATURESS;
+
+//Kalmanfilter
+typedef Eigen::Matrix<float, 1, 8, Eigen::RowMajor> KAL_MEAN;
+typedef Eigen::Matrix<float, 8, 8, Eigen::RowMajor> KAL_COVA;
+typedef Eigen::Matrix<float, 1, 4, Eigen::RowMajor> KAL_HMEAN;
+typedef Eigen::Matrix<float, 4, 4, Eigen::RowMajor> KAL_HCOVA;
+using KAL_DATA  = std::pair<KAL_MEAN, KAL_COVA>;
+using KAL_HDATA = std::pair<KAL_HMEAN, KAL_HCOVA>;
+
+//main
+using RESULT_DATA = std::pair<int, DETECTBOX>;
+
+//tracker
+using TRACKER_DATA = std::pair<int, FEATURESS>;
+using MATCH_DATA   = std::pair<int, int>;
+
+//linear_assignment
+typedef Eigen::Matrix<float, -1, -1, Eigen::RowMajor> DYNAMICM;
+
+//association, row-major rows x cols matrix whose storage is kept between frames
+struct CostMatrix {
+    int                rows = 0;
+    int                cols = 0;
+    std::vector<float> data;
+
+    void resize(int r, int c) {
+        rows = r;
+        cols = c;
+        data.resize(static_cast<size_t>(r) * c);
+    }
+    float*       row(int i) { return data.data() + static_cast<size_t>(i) * cols; }
+    const float* row(int i) const { return data.data() + static_cast<size_t>(i) * cols; }
+    bool         empty() const { return rows == 0 || cols == 0; }
+};
+
+//set of track ids with linear probing; reset() is O(1) and storage is kept between frames
+struct TrackIdSet {
+    std::vector<int>      keys;
+    std::vector<uint32_t> stamps;
+    uint32_t              stamp = 0;
+    size_t                mask  = 0;
+
+    // empty the set and make room for n ids
+    void reset(size_t n) {
+        size_t cap = 16;
+        while (cap < 2 * n) cap <<= 1;
+        if (cap > keys.size()) {
+            keys.assign(cap, 0);
+            stamps.assign(cap, 0);
+            stamp = 0;
+        }
+        mask = keys.size() - 1;
+        if (++stamp == 0) {
+            std::fill(stamps.begin(), stamps.end(), 0);
+            stamp = 1;
+        }
+    }
+    // true if id was not in the set yet
+    bool insert(int id) {
+        size_t i = (static_cast<uint32_t>(id) * 2654435761u) & mask;
+        while (stamps[i] == stamp) {
+            if (keys[i] == id) return false;
+            i = (i + 1) & mask;
+        }
+        stamps[i] = stamp;
+        keys[i]   = id;
+        return true;
+    }
+};
+
+struct Rect4f {
+    float x;
+    float y;
+    float width;
+    float height;
+};
+
+struct Scalar3u {
+    Scalar3u(unsigned int v1, unsigned int v2, unsigned int v3) : val1(v1), val2(v2), val3(v3) {}
+
+    unsigned int val1;
+    unsigned int val2;
+    unsigned int val3;
+};
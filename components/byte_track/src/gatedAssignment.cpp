@@ -0,0 +1,189 @@
+#include "gatedAssignment.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace byte_iou {
+
+// Upper bound on grid cells per detection, the cell size grows until the grid fits
+#define GATE_MAX_CELLS_PER_BOX 4
+
+void GatedAssignment::build_grid(const BoxesSoA& b) {
+    const size_t nb = b.size();
+
+    float x0 = b.x1[0], y0 = b.y1[0], x1 = b.x2[0] + 1, y1 = b.y2[0] + 1;
+    float extent = 0;
+    for (size_t j = 0; j < nb; ++j) {
+        x0 = std::min(x0, b.x1[j]);
+        y0 = std::min(y0, b.y1[j]);
+        x1 = std::max(x1, b.x2[j] + 1);
+        y1 = std::max(y1, b.y2[j] + 1);
+        extent += std::max(b.x2[j] - b.x1[j], b.y2[j] - b.y1[j]) + 1;
+    }
+
+    // one typical box per cell, coarser if the scene is sparse
+    cell_size = std::max(extent / nb, 1.f);
+    while (true) {
+        grid_w = std::max(1, (int)std::ceil((x1 - x0) / cell_size));
+        grid_h = std::max(1, (int)std::ceil((y1 - y0) / cell_size));
+        if ((size_t)grid_w * grid_h <= GATE_MAX_CELLS_PER_BOX * nb + 16) break;
+        cell_size *= 2;
+    }
+    grid_x0 = x0;
+    grid_y0 = y0;
+
+    const int cells = grid_w * grid_h;
+    cell_start.assign(cells + 1, 0);
+    for (int pass = 0; pass < 2; ++pass) {
+        for (size_t j = 0; j < nb; ++j) {
+            int cx0 = std::min((int)((b.x1[j] - grid_x0) / cell_size), grid_w - 1);
+            int cy0 = std::min((int)((b.y1[j] - grid_y0) / cell_size), grid_h - 1);
+            int cx1 = std::min((int)((b.x2[j] + 1 - grid_x0) / cell_size), grid_w - 1);
+            int cy1 = std::min((int)((b.y2[j] + 1 - grid_y0) / cell_size), grid_h - 1);
+            for (int cy = cy0; cy <= cy1; ++cy) {
+                for (int cx = cx0; cx <= cx1; ++cx) {
+                    int cell = cy * grid_w + cx;
+                    if (pass == 0) {
+                        cell_start[cell + 1]++;
+                    } else {
+                        cell_items[seen[cell]++] = j;
+                    }
+                }
+            }
+        }
+        if (pass == 0) {
+            for (int c = 0; c < cells; ++c) cell_start[c + 1] += cell_start[c];
+            cell_items.resize(cell_start[cells]);
+            seen.assign(cell_start.begin(), cell_start.end() - 1);  // fill cursor per cell
+        }
+    }
+}
+
+void GatedAssignment::collect_edges(const BoxesSoA& a, const BoxesSoA& b, float thresh) {
+    const size_t na = a.size();
+
+    edges.clear();
+    seen.assign(b.size(), -1);
+
+    for (size_t i = 0; i < na; ++i) {
+        float bx0 = (a.x1[i] - grid_x0) / cell_size;
+        float by0 = (a.y1[i] - grid_y0) / cell_size;
+        float bx1 = (a.x2[i] + 1 - grid_x0) / cell_size;
+        float by1 = (a.y2[i] + 1 - grid_y0) / cell_size;
+        if (!(bx1 >= 0 && by1 >= 0 && bx0 < grid_w && by0 < grid_h)) continue;
+
+        int cx0 = std::max((int)bx0, 0);
+        int cy0 = std::max((int)by0, 0);
+        int cx1 = std::min((int)bx1, grid_w - 1);
+        int cy1 = std::min((int)by1, grid_h - 1);
+        for (int cy = cy0; cy <= cy1; ++cy) {
+            for (int cx = cx0; cx <= cx1; ++cx) {
+                int cell = cy * grid_w + cx;
+                for (int k = cell_start[cell]; k < cell_start[cell + 1]; ++k) {
+                    int j = cell_items[k];
+                    if (seen[j] == (int)i) continue;
+                    seen[j] = i;
+
+                    float cost = iou_cost(a, i, b, j);
+                    if (cost < thresh) {
+                        edges.push_back({(int)i, j, cost});
+                    }
+                }
+            }
+        }
+    }
+}
+
+int GatedAssignment::find(int node) {
+    while (parent[node] != node) {
+        parent[node] = parent[parent[node]];
+        node         = parent[node];
+    }
+    return node;
+}
+
+void GatedAssignment::solve(
+  const BoxesSoA& a, const BoxesSoA& b, float thresh, LapjvSolver& solver, std::vector<int>& rowsol, std::vector<int>& colsol) {
+    const int na = a.size();
+    const int nb = b.size();
+
+    rowsol.assign(na, -1);
+    colsol.assign(nb, -1);
+    if (na == 0 || nb == 0) return;
+
+    build_grid(b);
+    collect_edges(a, b, thresh);
+    if (edges.empty()) return;
+
+    // connected components of the candidate graph
+    parent.resize(na + nb);
+    for (int n = 0; n < na + nb; ++n) parent[n] = n;
+    for (const Edge& e : edges) {
+        int ra = find(e.row);
+        int rb = find(na + e.col);
+        if (ra != rb) parent[rb] = ra;
+    }
+
+    // group edges by component root
+    comp_start.assign(na + nb + 1, 0);
+    for (const Edge& e : edges) comp_start[find(e.row) + 1]++;
+    for (int n = 0; n < na + nb; ++n) comp_start[n + 1] += comp_start[n];
+    comp_edges.resize(edges.size());
+    local_index.assign(comp_start.begin(), comp_start.end() - 1);  // fill cursor per root
+    for (const Edge& e : edges) comp_edges[local_index[find(e.row)]++] = e;
+
+    local_index.assign(na + nb, -1);
+    for (int root = 0; root < na + nb; ++root) {
+        const Edge* first = comp_edges.data() + comp_start[root];
+        const Edge* last  = comp_edges.data() + comp_start[root + 1];
+        if (first == last) continue;
+
+        // a lone candidate pair always beats leaving both sides unmatched
+        if (last - first == 1) {
+            rowsol[first->row] = first->col;
+            colsol[first->col] = first->row;
+            continue;
+        }
+
+        local_rows.clear();
+        local_cols.clear();
+        for (const Edge* e = first; e != last; ++e) {
+            if (local_index[e->row] < 0) {
+                local_index[e->row] = 0;
+                local_rows.push_back(e->row);
+            }
+            if (local_index[na + e->col] < 0) {
+                local_index[na + e->col] = 0;
+                local_cols.push_back(e->col);
+            }
+        }
+        // keep the dense solver's row and column order
+        std::sort(local_rows.begin(), local_rows.end());
+        std::sort(local_cols.begin(), local_cols.end());
+        for (size_t r = 0; r < local_rows.size(); ++r) local_index[local_rows[r]] = r;
+        for (size_t c = 0; c < local_cols.size(); ++c) local_index[na + local_cols[c]] = c;
+
+        // pairs without an edge can never be matched, any cost >= thresh keeps them out
+        local_cost.resize(local_rows.size(), local_cols.size());
+        std::fill(local_cost.data.begin(), local_cost.data.end(), 1.f);
+        for (const Edge* e = first; e != last; ++e) {
+            local_cost.row(local_index[e->row])[local_index[na + e->col]] = e->cost;
+        }
+
+        local_rowsol.resize(local_cost.rows);
+        local_colsol.resize(local_cost.cols);
+        solver.solve(local_cost.data.data(), local_cost.rows, local_cost.cols, local_cost.cols, thresh, local_rowsol.data(), local_colsol.data());
+
+        for (int r = 0; r < local_cost.rows; ++r) {
+            if (local_rowsol[r] >= 0) {
+                rowsol[local_rows[r]]                  = local_cols[local_rowsol[r]];
+                colsol[local_cols[local_rowsol[r]]] = local_rows[r];
+            }
+        }
+
+        for (int row : local_rows) local_index[row] = -1;
+        for (int col : local_cols) local_index[na + col] = -1;
+    }
+}
+
+}  // namespace byte_iou
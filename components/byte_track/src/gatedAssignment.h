@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "dataType.h"
+#include "iouMatrix.h"
+#include "lapjv.h"
+
+namespace byte_iou {
+
+/**
+ * Sparse IoU association.
+ *
+ * Detections are bucketed into a uniform grid, IoU is only evaluated for track/detection pairs
+ * sharing a cell, and pairs that could be matched (cost below the threshold) become edges of a
+ * bipartite graph. Each connected component is solved on its own with LAPJV, so the work grows
+ * with the number of overlapping pairs instead of tracks x detections.
+ *
+ * The result is the same assignment the dense extended LAPJV finds, up to ties, as long as
+ * thresh < 1 so that non-overlapping pairs can never be matched.
+ */
+class GatedAssignment {
+   public:
+    /**
+     * @param a track boxes
+     * @param b detection boxes
+     * @param thresh cost limit, pairs with 1 - IoU >= thresh are never matched
+     * @param solver LAPJV solver used for the components
+     * @param rowsol detection matched to each track or -1, resized to a.size()
+     * @param colsol track matched to each detection or -1, resized to b.size()
+     */
+    void solve(const BoxesSoA& a, const BoxesSoA& b, float thresh, LapjvSolver& solver, std::vector<int>& rowsol, std::vector<int>& colsol);
+
+   private:
+    struct Edge {
+        int   row;
+        int   col;
+        float cost;
+    };
+
+    void build_grid(const BoxesSoA& b);
+    void collect_edges(const BoxesSoA& a, const BoxesSoA& b, float thresh);
+    int  find(int node);
+
+    // grid, cells stored in CSR form
+    float            grid_x0, grid_y0, cell_size;
+    int              grid_w, grid_h;
+    std::vector<int> cell_start;
+    std::vector<int> cell_items;
+    std::vector<int> seen;
+
+    std::vector<Edge> edges;
+
+    // union-find over rows [0, na) and columns [na, na + nb)
+    std::vector<int> parent;
+
+    // edges grouped by component, and the component-local problem
+    std::vector<int>  comp_start;
+    std::vector<Edge> comp_edges;
+    std::vector<int>  local_index;
+    std::vector<int>  local_rows, local_cols;
+    std::vector<int>  local_rowsol, local_colsol;
+    CostMatrix        local_cost;
+};
+
+}  // namespace byte_iou
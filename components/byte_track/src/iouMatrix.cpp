@@ -0,0 +1,128 @@
+#include "iouMatrix.h"
+
+#include <algorithm>
+
+#if BYTE_IOU_SIMD_AVX2
+    #include <immintrin.h>
+#elif BYTE_IOU_SIMD_SSE2
+    #include <emmintrin.h>
+#endif
+
+namespace byte_iou {
+
+void BoxesSoA::clear() {
+    x1.clear();
+    y1.clear();
+    x2.clear();
+    y2.clear();
+    area.clear();
+}
+
+void BoxesSoA::push_back(const float* tlbr) {
+    x1.push_back(tlbr[0]);
+    y1.push_back(tlbr[1]);
+    x2.push_back(tlbr[2]);
+    y2.push_back(tlbr[3]);
+    area.push_back((tlbr[2] - tlbr[0] + 1) * (tlbr[3] - tlbr[1] + 1));
+}
+
+static void iou_distance_scalar(const BoxesSoA& a, const BoxesSoA& b, CostMatrix& cost, size_t from) {
+    const size_t na = a.size();
+    const size_t nb = b.size();
+    for (size_t i = 0; i < na; ++i) {
+        float* out = cost.row(i);
+        for (size_t j = from; j < nb; ++j) {
+            out[j] = iou_cost(a, i, b, j);
+        }
+    }
+}
+
+#if BYTE_IOU_SIMD_AVX2
+
+static size_t iou_distance_simd(const BoxesSoA& a, const BoxesSoA& b, CostMatrix& cost) {
+    const size_t na   = a.size();
+    const size_t nb   = b.size();
+    const size_t nvec = nb & ~size_t(7);
+    const __m256 one  = _mm256_set1_ps(1.f);
+    const __m256 zero = _mm256_setzero_ps();
+
+    for (size_t i = 0; i < na; ++i) {
+        const __m256 ax1   = _mm256_set1_ps(a.x1[i]);
+        const __m256 ay1   = _mm256_set1_ps(a.y1[i]);
+        const __m256 ax2   = _mm256_set1_ps(a.x2[i]);
+        const __m256 ay2   = _mm256_set1_ps(a.y2[i]);
+        const __m256 aarea = _mm256_set1_ps(a.area[i]);
+        float*       out   = cost.row(i);
+
+        for (size_t j = 0; j < nvec; j += 8) {
+            __m256 iw = _mm256_add_ps(
+              _mm256_sub_ps(_mm256_min_ps(ax2, _mm256_loadu_ps(&b.x2[j])), _mm256_max_ps(ax1, _mm256_loadu_ps(&b.x1[j]))), one);
+            __m256 ih = _mm256_add_ps(
+              _mm256_sub_ps(_mm256_min_ps(ay2, _mm256_loadu_ps(&b.y2[j])), _mm256_max_ps(ay1, _mm256_loadu_ps(&b.y1[j]))), one);
+            __m256 mask  = _mm256_and_ps(_mm256_cmp_ps(iw, zero, _CMP_GT_OQ), _mm256_cmp_ps(ih, zero, _CMP_GT_OQ));
+            __m256 inter = _mm256_mul_ps(iw, ih);
+            __m256 ua    = _mm256_sub_ps(_mm256_add_ps(aarea, _mm256_loadu_ps(&b.area[j])), inter);
+            __m256 iou   = _mm256_and_ps(_mm256_div_ps(inter, ua), mask);
+            _mm256_storeu_ps(out + j, _mm256_sub_ps(one, iou));
+        }
+    }
+    return nvec;
+}
+
+#elif BYTE_IOU_SIMD_SSE2
+
+static size_t iou_distance_simd(const BoxesSoA& a, const BoxesSoA& b, CostMatrix& cost) {
+    const size_t na   = a.size();
+    const size_t nb   = b.size();
+    const size_t nvec = nb & ~size_t(3);
+    const __m128 one  = _mm_set1_ps(1.f);
+    const __m128 zero = _mm_setzero_ps();
+
+    for (size_t i = 0; i < na; ++i) {
+        const __m128 ax1   = _mm_set1_ps(a.x1[i]);
+        const __m128 ay1   = _mm_set1_ps(a.y1[i]);
+        const __m128 ax2   = _mm_set1_ps(a.x2[i]);
+        const __m128 ay2   = _mm_set1_ps(a.y2[i]);
+        const __m128 aarea = _mm_set1_ps(a.area[i]);
+        float*       out   = cost.row(i);
+
+        for (size_t j = 0; j < nvec; j += 4) {
+            __m128 iw    = _mm_add_ps(_mm_sub_ps(_mm_min_ps(ax2, _mm_loadu_ps(&b.x2[j])), _mm_max_ps(ax1, _mm_loadu_ps(&b.x1[j]))), one);
+            __m128 ih    = _mm_add_ps(_mm_sub_ps(_mm_min_ps(ay2, _mm_loadu_ps(&b.y2[j])), _mm_max_ps(ay1, _mm_loadu_ps(&b.y1[j]))), one);
+            __m128 mask  = _mm_and_ps(_mm_cmpgt_ps(iw, zero), _mm_cmpgt_ps(ih, zero));
+            __m128 inter = _mm_mul_ps(iw, ih);
+            __m128 ua    = _mm_sub_ps(_mm_add_ps(aarea, _mm_loadu_ps(&b.area[j])), inter);
+            __m128 iou   = _mm_and_ps(_mm_div_ps(inter, ua), mask);
+            _mm_storeu_ps(out + j, _mm_sub_ps(one, iou));
+        }
+    }
+    return nvec;
+}
+
+#else
+
+static size_t iou_distance_simd(const BoxesSoA&, const BoxesSoA&, CostMatrix&) { return 0; }
+
+#endif
+
+void iou_distance(const BoxesSoA& a, const BoxesSoA& b, CostMatrix& cost) {
+    cost.resize(a.size(), b.size());
+    if (cost.empty()) return;
+
+    size_t done = iou_distance_simd(a, b, cost);
+    if (done < b.size()) {
+        iou_distance_scalar(a, b, cost, done);
+    }
+}
+
+const char* iou_kernel_name() {
+#if BYTE_IOU_SIMD_AVX2
+    return "avx2";
+#elif BYTE_IOU_SIMD_SSE2
+    return "sse2";
+#else
+    return "scalar";
+#endif
+}
+
+}  // namespace byte_iou
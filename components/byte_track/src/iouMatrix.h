@@ -0,0 +1,62 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+#include "dataType.h"
+
+#if defined(__AVX2__)
+    #define BYTE_IOU_SIMD_AVX2 1
+#elif defined(__SSE2__)
+    #define BYTE_IOU_SIMD_SSE2 1
+#endif
+
+namespace byte_iou {
+
+/**
+ * Boxes in top-left/bottom-right form, stored as four separate lanes so the kernels can load
+ * several boxes per instruction.
+ */
+struct BoxesSoA {
+    std::vector<float> x1;
+    std::vector<float> y1;
+    std::vector<float> x2;
+    std::vector<float> y2;
+    std::vector<float> area;
+
+    void clear();
+    void push_back(const float* tlbr);
+
+    size_t size() const { return x1.size(); }
+};
+
+/**
+ * 1 - IoU of a[i] and b[j], the reference formula every kernel reproduces.
+ *
+ * Non-overlapping pairs return before the division, which is why the ESP32-S3 runs this scalar
+ * path: its PIE unit has no float lanes and an FPU division costs tens of cycles.
+ */
+inline float iou_cost(const BoxesSoA& a, size_t i, const BoxesSoA& b, size_t j) {
+    float iw = std::min(a.x2[i], b.x2[j]) - std::max(a.x1[i], b.x1[j]) + 1;
+    if (iw <= 0) return 1.f;
+    float ih = std::min(a.y2[i], b.y2[j]) - std::max(a.y1[i], b.y1[j]) + 1;
+    if (ih <= 0) return 1.f;
+    float ua = a.area[i] + b.area[j] - iw * ih;
+    return 1 - iw * ih / ua;
+}
+
+/**
+ * Fill the rows x cols cost matrix with 1 - IoU(a[i], b[j]).
+ *
+ * The matrix is resized to a.size() rows by b.size() columns. The selected code path (AVX2, SSE2
+ * or portable scalar) only changes speed, all paths produce the same values.
+ */
+void iou_distance(const BoxesSoA& a, const BoxesSoA& b, CostMatrix& cost);
+
+/**
+ * Name of the kernel selected at compile time, for logs and benchmarks.
+ */
+const char* iou_kernel_name();
+
+}  // namespace byte_iou
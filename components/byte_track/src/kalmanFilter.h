@@ -1,31 +1,36 @@
-/*
- * MIT License
- * Copyright (c) 2021 Yifu Zhang
- *
- * Modified by nullptr, Apr 15, 2024, Seeed Technology Co.,Ltd
-*/
-
-#pragma once
-
-#include "dataType.h"
-
-namespace byte_kalman {
-class KalmanFilter {
-   public:
-    static const double chi2inv95[10];
-
-    KalmanFilter();
-
-    KAL_DATA  initiate(const DETECTBOX& measurement);
-    void      predict(KAL_MEAN& mean, KAL_COVA& covariance);
-    KAL_HDATA project(const KAL_MEAN& mean, const KAL_COVA& covariance);
-    KAL_DATA  update(const KAL_MEAN& mean, const KAL_COVA& covariance, const DETECTBOX& measurement);
-
-   private:
-    Eigen::Matrix<float, 8, 8, Eigen::RowMajor> _motion_mat;
-    Eigen::Matrix<float, 4, 8, Eigen::RowMajor> _update_mat;
-
-    float _std_weight_position;
-    float _std_weight_velocity;
-};
+/*
+ * MIT License
+ * Copyright (c) 2021 Yifu Zhang
+ *
+ * Modified by nullptr, Apr 15, 2024, Seeed Technology Co.,Ltd
+*/
+
+#pragma once
+
+#include "dataType.h"
+
+namespace byte_kalman {
+/**
+ * Constant-velocity Kalman filter over (x, y, aspect, height) and their velocities.
+ *
+ * The motion and observation models are fixed (dt = 1, identity observation of the first four
+ * states), so predict, project and update are written out over the 4x4 blocks of the covariance
+ * instead of going through generic 8x8 products. The filter holds no per-track state; one
+ * instance is shared by every track of a tracker.
+ */
+class KalmanFilter {
+   public:
+    static const double chi2inv95[10];
+
+    KalmanFilter();
+
+    KAL_DATA  initiate(const DETECTBOX& measurement) const;
+    void      predict(KAL_MEAN& mean, KAL_COVA& covariance) const;
+    KAL_HDATA project(const KAL_MEAN& mean, const KAL_COVA& covariance) const;
+    void      update(KAL_MEAN& mean, KAL_COVA& covariance, const DETECTBOX& measurement) const;
+
+   private:
+    float _std_weight_position;
+    float _std_weight_velocity;
+};
 }  // namespace byte_kalman
\ No newline at end of file
@@ -1,14 +1,57 @@
 #include "lapjv.h"
 
+#include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+/** Cost accessor over an array of row pointers.
+ */
+struct RowPointerCost {
+    cost_t** cost;
+
+    inline cost_t operator()(uint_t i, uint_t j) const { return cost[i][j]; }
+};
+
+/** Cost accessor over a rectangular float matrix, extended to (rows + cols) square on the fly.
+ *
+ * Real rows against dummy columns and dummy rows against real columns cost `fill`, the
+ * dummy-dummy block costs nothing.
+ */
+struct ExtendedCost {
+    const float* cost;
+    size_t       stride;
+    uint_t       rows;
+    uint_t       cols;
+    cost_t       fill;
+
+    inline cost_t operator()(uint_t i, uint_t j) const {
+        if (i < rows) {
+            return j < cols ? (cost_t)cost[i * stride + j] : fill;
+        }
+        return j < cols ? fill : 0;
+    }
+};
+
+void lapjv_workspace_t::reserve(uint_t n) {
+    if (free_rows.size() >= n) {
+        return;
+    }
+    free_rows.resize(n);
+    x.resize(n);
+    y.resize(n);
+    cols.resize(n);
+    pred.resize(n);
+    v.resize(n);
+    d.resize(n);
+    unique.resize(n);
+}
+
 /** Column-reduction and reduction transfer for a dense cost matrix.
  */
-int_t _ccrrt_dense(const uint_t n, cost_t* cost[], int_t* free_rows, int_t* x, int_t* y, cost_t* v) {
-    int_t    n_free_rows;
-    boolean* unique;
+template <class Cost>
+static int_t _ccrrt_dense(const uint_t n, const Cost& cost, int_t* free_rows, int_t* x, int_t* y, cost_t* v, boolean* unique) {
+    int_t n_free_rows;
 
     for (uint_t i = 0; i < n; i++) {
         x[i] = -1;
@@ -17,7 +60,7 @@ int_t _ccrrt_dense(const uint_t n, cost_t* cost[], int_t* free_rows, int_t* x, i
     }
     for (uint_t i = 0; i < n; i++) {
         for (uint_t j = 0; j < n; j++) {
-            const cost_t c = cost[i][j];
+            const cost_t c = cost(i, j);
             if (c < v[j]) {
                 v[j] = c;
                 y[j] = i;
@@ -27,7 +70,6 @@ int_t _ccrrt_dense(const uint_t n, cost_t* cost[], int_t* free_rows, int_t* x, i
     }
     PRINT_COST_ARRAY(v, n);
     PRINT_INDEX_ARRAY(y, n);
-    NEW(unique, boolean, n);
     memset(unique, TRUE, n);
     {
         int_t j = n;
@@ -53,7 +95,7 @@ int_t _ccrrt_dense(const uint_t n, cost_t* cost[], int_t* free_rows, int_t* x, i
                 if (j2 == (uint_t)j) {
                     continue;
                 }
-                const cost_t c = cost[i][j2] - v[j2];
+                const cost_t c = cost(i, j2) - v[j2];
                 if (c < min) {
                     min = c;
                 }
@@ -62,14 +104,14 @@ int_t _ccrrt_dense(const uint_t n, cost_t* cost[], int_t* free_rows, int_t* x, i
             v[j] -= min;
         }
     }
-    FREE(unique);
     return n_free_rows;
 }
 
 /** Augmenting row reduction for a dense cost matrix.
  */
-int_t _carr_dense(
-  const uint_t n, cost_t* cost[], const uint_t n_free_rows, int_t* free_rows, int_t* x, int_t* y, cost_t* v) {
+template <class Cost>
+static int_t _carr_dense(
+  const uint_t n, const Cost& cost, const uint_t n_free_rows, int_t* free_rows, int_t* x, int_t* y, cost_t* v) {
     uint_t current       = 0;
     int_t  new_free_rows = 0;
     uint_t rr_cnt        = 0;
@@ -87,12 +129,12 @@ int_t _carr_dense(
         PRINTF("current = %d rr_cnt = %d\n", current, rr_cnt);
         const int_t free_i = free_rows[current++];
         j1                 = 0;
-        v1                 = cost[free_i][0] - v[0];
+        v1                 = cost(free_i, 0) - v[0];
         j2                 = -1;
         v2                 = LARGE;
         for (uint_t j = 1; j < n; j++) {
             PRINTF("%d = %f %d = %f\n", j1, v1, j2, v2);
-            const cost_t c = cost[free_i][j] - v[j];
+            const cost_t c = cost(free_i, j) - v[j];
             if (c < v2) {
                 if (c >= v1) {
                     v2 = c;
@@ -137,7 +179,7 @@ int_t _carr_dense(
 
 /** Find columns with minimum d[j] and put them on the SCAN list.
  */
-uint_t _find_dense(const uint_t n, uint_t lo, cost_t* d, int_t* cols, int_t* y) {
+static uint_t _find_dense(const uint_t n, uint_t lo, cost_t* d, int_t* cols) {
     uint_t hi   = lo + 1;
     cost_t mind = d[cols[lo]];
     for (uint_t k = hi; k < n; k++) {
@@ -156,8 +198,9 @@ uint_t _find_dense(const uint_t n, uint_t lo, cost_t* d, int_t* cols, int_t* y)
 
 // Scan all columns in TODO starting from arbitrary column in SCAN
 // and try to decrease d of the TODO columns using the SCAN column.
-int_t _scan_dense(
-  const uint_t n, cost_t* cost[], uint_t* plo, uint_t* phi, cost_t* d, int_t* cols, int_t* pred, int_t* y, cost_t* v) {
+template <class Cost>
+static int_t _scan_dense(
+  const uint_t n, const Cost& cost, uint_t* plo, uint_t* phi, cost_t* d, int_t* cols, int_t* pred, int_t* y, cost_t* v) {
     uint_t lo = *plo;
     uint_t hi = *phi;
     cost_t h, cred_ij;
@@ -166,12 +209,12 @@ int_t _scan_dense(
         int_t        j    = cols[lo++];
         const int_t  i    = y[j];
         const cost_t mind = d[j];
-        h                 = cost[i][j] - v[j] - mind;
+        h                 = cost(i, j) - v[j] - mind;
         PRINTF("i=%d j=%d h=%f\n", i, j, h);
         // For all columns in TODO
         for (uint_t k = hi; k < n; k++) {
             j       = cols[k];
-            cred_ij = cost[i][j] - v[j] - h;
+            cred_ij = cost(i, j) - v[j] - h;
             if (cred_ij < d[j]) {
                 d[j]    = cred_ij;
                 pred[j] = i;
@@ -196,20 +239,17 @@ int_t _scan_dense(
  *
  * \return The closest free column index.
  */
-int_t find_path_dense(const uint_t n, cost_t* cost[], const int_t start_i, int_t* y, cost_t* v, int_t* pred) {
-    uint_t  lo = 0, hi = 0;
-    int_t   final_j = -1;
-    uint_t  n_ready = 0;
-    int_t*  cols;
-    cost_t* d;
-
-    NEW(cols, int_t, n);
-    NEW(d, cost_t, n);
+template <class Cost>
+static int_t find_path_dense(
+  const uint_t n, const Cost& cost, const int_t start_i, int_t* y, cost_t* v, int_t* pred, int_t* cols, cost_t* d) {
+    uint_t lo = 0, hi = 0;
+    int_t  final_j = -1;
+    uint_t n_ready = 0;
 
     for (uint_t i = 0; i < n; i++) {
         cols[i] = i;
         pred[i] = start_i;
-        d[i]    = cost[start_i][i] - v[i];
+        d[i]    = cost(start_i, i) - v[i];
     }
     PRINT_COST_ARRAY(d, n);
     while (final_j == -1) {
@@ -217,7 +257,7 @@ int_t find_path_dense(const uint_t n, cost_t* cost[], const int_t start_i, int_t
         if (lo == hi) {
             PRINTF("%d..%d -> find\n", lo, hi);
             n_ready = lo;
-            hi      = _find_dense(n, lo, d, cols, y);
+            hi      = _find_dense(n, lo, d, cols);
             PRINTF("check %d..%d\n", lo, hi);
             PRINT_INDEX_ARRAY(cols, n);
             for (uint_t k = lo; k < hi; k++) {
@@ -246,26 +286,28 @@ int_t find_path_dense(const uint_t n, cost_t* cost[], const int_t start_i, int_t
         }
     }
 
-    FREE(cols);
-    FREE(d);
-
     return final_j;
 }
 
 /** Augment for a dense cost matrix.
  */
-int_t _ca_dense(
-  const uint_t n, cost_t* cost[], const uint_t n_free_rows, int_t* free_rows, int_t* x, int_t* y, cost_t* v) {
-    int_t* pred;
-
-    NEW(pred, int_t, n);
+template <class Cost>
+static int_t _ca_dense(const uint_t       n,
+                       const Cost&        cost,
+                       const uint_t       n_free_rows,
+                       int_t*             free_rows,
+                       int_t*             x,
+                       int_t*             y,
+                       cost_t*            v,
+                       lapjv_workspace_t& ws) {
+    int_t* pred = ws.pred.data();
 
     for (int_t* pfree_i = free_rows; pfree_i < free_rows + n_free_rows; pfree_i++) {
         int_t  i = -1, j;
         uint_t k = 0;
 
         PRINTF("looking at free_i=%d\n", *pfree_i);
-        j = find_path_dense(n, cost, *pfree_i, y, v, pred);
+        j = find_path_dense(n, cost, *pfree_i, y, v, pred, ws.cols.data(), ws.d.data());
         ASSERT(j >= 0);
         ASSERT(j < n);
         while (i != *pfree_i) {
@@ -282,30 +324,80 @@ int_t _ca_dense(
             }
         }
     }
-    FREE(pred);
     return 0;
 }
 
-/** Solve dense sparse LAP.
+/** Solve dense sparse LAP, x and y receive the row and column solutions.
  */
-int lapjv_internal(const uint_t n, cost_t* cost[], int_t* x, int_t* y) {
-    int     ret;
-    int_t*  free_rows;
-    cost_t* v;
+template <class Cost>
+static int_t lapjv_dense(const uint_t n, const Cost& cost, int_t* x, int_t* y, lapjv_workspace_t& ws) {
+    int_t   ret;
+    int_t*  free_rows = ws.free_rows.data();
+    cost_t* v         = ws.v.data();
 
-    NEW(free_rows, int_t, n);
-    NEW(v, cost_t, n);
-    ret   = _ccrrt_dense(n, cost, free_rows, x, y, v);
+    ret   = _ccrrt_dense(n, cost, free_rows, x, y, v, ws.unique.data());
     int i = 0;
     while (ret > 0 && i < 2) {
         ret = _carr_dense(n, cost, ret, free_rows, x, y, v);
         i++;
     }
     if (ret > 0) {
-        ret = _ca_dense(n, cost, ret, free_rows, x, y, v);
+        ret = _ca_dense(n, cost, ret, free_rows, x, y, v, ws);
     }
-    FREE(v);
-    FREE(free_rows);
-    
+
     return ret;
+}
+
+/** Solve dense sparse LAP.
+ */
+int lapjv_internal(const uint_t n, cost_t* cost[], int_t* x, int_t* y) {
+    lapjv_workspace_t ws;
+    ws.reserve(n);
+    return lapjv_dense(n, RowPointerCost{cost}, x, y, ws);
+}
+
+double LapjvSolver::solve(const float* cost, int rows, int cols, size_t stride, float cost_limit, int* rowsol, int* colsol) {
+    const bool limited = cost_limit > 0 && isfinite(cost_limit);
+
+    ExtendedCost ext = {cost, stride, (uint_t)rows, (uint_t)cols, 0};
+    uint_t       n   = rows;
+    if (limited) {
+        n        = rows + cols;
+        ext.fill = cost_limit / 2.0;
+    } else if (rows != cols) {
+        float cost_max = -1.0;
+        for (int i = 0; i < rows; i++) {
+            for (int j = 0; j < cols; j++) {
+                if (cost[i * stride + j] > cost_max) cost_max = cost[i * stride + j];
+            }
+        }
+        n        = rows + cols;
+        ext.fill = cost_max + 1;
+    }
+
+    if (n == 0) {
+        return 0.0;
+    }
+
+    ws.reserve(n);
+    int_t* x = ws.x.data();
+    int_t* y = ws.y.data();
+
+    if (lapjv_dense(n, ext, x, y, ws) != 0) {
+        puts("lapjv_internal failed");
+        return -1.0;
+    }
+
+    double opt = 0.0;
+    for (int i = 0; i < rows; i++) {
+        rowsol[i] = x[i] < cols ? x[i] : -1;
+        if (rowsol[i] >= 0) {
+            opt += cost[i * stride + rowsol[i]];
+        }
+    }
+    for (int j = 0; j < cols; j++) {
+        colsol[j] = y[j] < rows ? y[j] : -1;
+    }
+
+    return opt;
 }
\ No newline at end of file
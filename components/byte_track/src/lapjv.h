@@ -10,15 +10,6 @@
     #define FALSE 0
 #endif
 
-#define NEW(x, t, n)                              \
-    if ((x = (t*)malloc(sizeof(t) * (n))) == 0) { \
-        return -1;                                \
-    }
-#define FREE(x)   \
-    if (x != 0) { \
-        free(x);  \
-        x = 0;    \
-    }
 #define SWAP_INDICES(a, b)               \
     {                                    \
         int_t _temp_index = a;           \
@@ -69,4 +60,51 @@ typedef enum fp_t { FP_1 = 1, FP_2 = 2, FP_DYNAMIC = 3 } fp_t;
 
 extern int_t lapjv_internal(const uint_t n, cost_t* cost[], int_t* x, int_t* y);
 
+#ifdef __cplusplus
+
+    #include <cstddef>
+    #include <vector>
+
+/** Scratch arrays of the dense solver, grown on demand and kept between solves.
+ */
+struct lapjv_workspace_t {
+    std::vector<int_t>   free_rows;
+    std::vector<int_t>   x;
+    std::vector<int_t>   y;
+    std::vector<int_t>   cols;
+    std::vector<int_t>   pred;
+    std::vector<cost_t>  v;
+    std::vector<cost_t>  d;
+    std::vector<boolean> unique;
+
+    void reserve(uint_t n);
+};
+
+/** Rectangular LAPJV solver reusing one workspace across calls.
+ *
+ * The cost matrix is read in place as rows x cols floats with a row stride of `stride` elements.
+ * With a finite cost_limit every row and column may also stay unassigned for cost_limit / 2,
+ * which is the usual square extension of the problem; the extended matrix is evaluated on the
+ * fly instead of being copied.
+ */
+class LapjvSolver {
+   public:
+    /**
+     * @param cost row-major cost matrix
+     * @param rows number of rows
+     * @param cols number of columns
+     * @param stride distance between two rows, in elements
+     * @param cost_limit cost above which a pair is never assigned, <= 0 or infinite for none
+     * @param rowsol column assigned to each row or -1, rows entries
+     * @param colsol row assigned to each column or -1, cols entries
+     * @return total cost of the assignment, or a negative value on failure
+     */
+    double solve(const float* cost, int rows, int cols, size_t stride, float cost_limit, int* rowsol, int* colsol);
+
+   private:
+    lapjv_workspace_t ws;
+};
+
+#endif
+
 #endif  // LAPJV_H
\ No newline at end of file
@@ -0,0 +1,77 @@
+#include "threadPool.h"
+
+ThreadPool::ThreadPool(size_t num_workers) : next_worker(0), pending(0), stopping(false) {
+    if (num_workers == 0) {
+        num_workers = 1;
+    }
+
+    workers.reserve(num_workers);
+    for (size_t i = 0; i < num_workers; ++i) {
+        workers.emplace_back(new Worker);
+    }
+    for (size_t i = 0; i < num_workers; ++i) {
+        workers[i]->thread = std::thread(&ThreadPool::run, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lk(idle_lock);
+        stopping = true;
+    }
+    idle.notify_all();
+
+    for (auto& worker : workers) {
+        worker->thread.join();
+    }
+}
+
+void ThreadPool::submit(task_fn fn, void* arg) {
+    Worker& worker = *workers[next_worker.fetch_add(1, std::memory_order_relaxed) % workers.size()];
+    {
+        std::lock_guard<std::mutex> lk(worker.lock);
+        worker.tasks.push_back({fn, arg});
+    }
+    pending.fetch_add(1);
+
+    // pass through the idle lock so a worker between its check and its wait cannot miss the wakeup
+    { std::lock_guard<std::mutex> lk(idle_lock); }
+    idle.notify_one();
+}
+
+bool ThreadPool::pop(size_t self, Task& task) {
+    const size_t n = workers.size();
+    for (size_t i = 0; i < n; ++i) {
+        Worker&                     worker = *workers[(self + i) % n];
+        std::lock_guard<std::mutex> lk(worker.lock);
+        if (worker.tasks.empty()) continue;
+
+        if (i == 0) {
+            task = worker.tasks.front();
+            worker.tasks.pop_front();
+        } else {
+            task = worker.tasks.back();
+            worker.tasks.pop_back();
+        }
+        pending.fetch_sub(1);
+        return true;
+    }
+    return false;
+}
+
+void ThreadPool::run(size_t self) {
+    while (true) {
+        Task task;
+        if (pop(self, task)) {
+            task.fn(task.arg);
+            continue;
+        }
+
+        // pending tasks are still drained after stop has been requested
+        std::unique_lock<std::mutex> lk(idle_lock);
+        idle.wait(lk, [this] { return stopping || pending.load() > 0; });
+        if (stopping && pending.load() == 0) {
+            return;
+        }
+    }
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Fixed set of worker threads with one task deque each.
+ *
+ * Tasks submitted from outside are spread round-robin over the deques. A worker runs its own tasks
+ * in FIFO order and, once its deque is empty, steals from the back of the others before going to
+ * sleep. Tasks are a plain function pointer and argument so that submitting never allocates beyond
+ * the deque's own storage.
+ */
+class ThreadPool {
+   public:
+    typedef void (*task_fn)(void* arg);
+
+    explicit ThreadPool(size_t num_workers);
+    ~ThreadPool();
+
+    void   submit(task_fn fn, void* arg);
+    size_t size() const { return workers.size(); }
+
+   private:
+    struct Task {
+        task_fn fn;
+        void*   arg;
+    };
+
+    struct Worker {
+        std::mutex       lock;
+        std::deque<Task> tasks;
+        std::thread      thread;
+    };
+
+    bool pop(size_t self, Task& task);
+    void run(size_t self);
+
+    std::vector<std::unique_ptr<Worker> > workers;
+    std::atomic<size_t>                   next_worker;
+    std::atomic<size_t>                   pending;
+
+    std::mutex              idle_lock;
+    std::condition_variable idle;
+    bool                    stopping;
+};
@@ -0,0 +1,150 @@
+#include "trackerManager.h"
+
+#include <algorithm>
+#include <thread>
+
+static size_t worker_count(size_t requested) {
+    if (requested != 0) {
+        return requested;
+    }
+    size_t hw = std::thread::hardware_concurrency();
+    return hw != 0 ? hw : 1;
+}
+
+TrackerManager::TrackerManager(const bt_manager_config_t* config)
+    : tracker_config(config->tracker),
+      jobs(config->max_pending),
+      free_jobs(config->max_pending),
+      done_jobs(config->max_pending),
+      held(nullptr),
+      pool(worker_count(config->num_workers)) {
+    for (auto& job : jobs) {
+        free_jobs.push(&job);
+    }
+
+    streams.reserve(config->max_streams);
+    for (size_t i = 0; i < config->max_streams; ++i) {
+        Stream* stream    = new Stream;
+        stream->owner     = this;
+        stream->scheduled = false;
+        stream->next_seq  = 0;
+        streams.emplace_back(stream);
+    }
+}
+
+TrackerManager::~TrackerManager() {}
+
+bt_error_t TrackerManager::submit(const bt_stream_frame_t* frames, size_t num_frames, size_t* num_submitted) {
+    size_t     count = 0;
+    bt_error_t ret   = BT_ERR_OK;
+
+    for (; count < num_frames; ++count) {
+        const bt_stream_frame_t& frame = frames[count];
+        if (frame.stream_id >= streams.size() || (frame.objects == nullptr && frame.num_objects != 0)) {
+            ret = BT_ERR_INVALID_OBJECTS;
+            break;
+        }
+
+        Job* job = nullptr;
+        if (!free_jobs.pop(job)) {
+            ret = BT_ERR_NO_SPACE;
+            break;
+        }
+
+        job->stream_id = frame.stream_id;
+        job->objects.assign(frame.objects, frame.objects + frame.num_objects);
+
+        Stream& stream   = *streams[frame.stream_id];
+        bool    schedule = false;
+        {
+            std::lock_guard<std::mutex> lk(stream.lock);
+            job->seq = stream.next_seq++;
+            stream.queue.push_back(job);
+            if (!stream.scheduled) {
+                stream.scheduled = true;
+                schedule         = true;
+            }
+        }
+        if (schedule) {
+            pool.submit(&TrackerManager::run_stream, &stream);
+        }
+    }
+
+    if (num_submitted != nullptr) {
+        *num_submitted = count;
+    }
+    return ret;
+}
+
+void TrackerManager::run_stream(void* arg) {
+    Stream&         stream = *static_cast<Stream*>(arg);
+    TrackerManager& owner  = *stream.owner;
+
+    while (true) {
+        Job* job = nullptr;
+        {
+            std::lock_guard<std::mutex> lk(stream.lock);
+            if (stream.queue.empty()) {
+                stream.scheduled = false;
+                return;
+            }
+            job = stream.queue.front();
+            stream.queue.pop_front();
+        }
+
+        if (!stream.tracker) {
+            stream.tracker.reset(new BYTETracker(&owner.tracker_config));
+        }
+
+        const auto& output = stream.tracker->update(job->objects.data(), job->objects.size());
+        job->tracks.resize(output.size());
+        for (size_t i = 0; i < output.size(); ++i) {
+            const STrack& track = *output[i];
+            bt_bbox_t&    out   = job->tracks[i];
+            for (size_t j = 0; j < 4; ++j) {
+                out.tlwh[j] = track.tlwh[j];
+            }
+            out.prob     = track.score;
+            out.label    = track.label;
+            out.track_id = track.track_id;
+        }
+
+        // cannot fail, the queue holds every job
+        owner.done_jobs.push(job);
+    }
+}
+
+size_t TrackerManager::poll(bt_stream_result_t* results, size_t max_results, bt_bbox_t* tracks, size_t capacity, bool* truncated) {
+    size_t count = 0;
+    size_t used  = 0;
+
+    *truncated = false;
+    while (count < max_results) {
+        Job* job = held;
+        if (job == nullptr && !done_jobs.pop(job)) {
+            break;
+        }
+
+        // keep a result that does not fit for the next call, unless it would never fit
+        if (job->tracks.size() > capacity - used && count != 0) {
+            held = job;
+            break;
+        }
+        held = nullptr;
+
+        bt_stream_result_t& result = results[count++];
+        result.stream_id           = job->stream_id;
+        result.seq                 = job->seq;
+        result.num_tracks          = std::min(job->tracks.size(), capacity - used);
+        result.tracks              = tracks + used;
+        std::copy(job->tracks.begin(), job->tracks.begin() + result.num_tracks, result.tracks);
+        used += result.num_tracks;
+        if (result.num_tracks < job->tracks.size()) {
+            *truncated = true;
+        }
+
+        free_jobs.push(job);
+    }
+
+    return count;
+}
@@ -0,0 +1,150 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "BYTETracker.h"
+#include "bytetracl_c_types.h"
+#include "threadPool.h"
+
+/**
+ * Bounded multi-producer multi-consumer queue (Vyukov). Every cell carries a sequence number that
+ * tells producers and consumers whether it is free for the current lap, so push and pop are a
+ * single compare-and-swap on the shared index with no locks.
+ */
+template <typename T>
+class MpmcQueue {
+   public:
+    explicit MpmcQueue(size_t capacity) {
+        size_t size = 2;
+        while (size < capacity) size <<= 1;
+
+        cells.reset(new Cell[size]);
+        mask = size - 1;
+        for (size_t i = 0; i < size; ++i) {
+            cells[i].seq.store(i, std::memory_order_relaxed);
+        }
+        head.store(0, std::memory_order_relaxed);
+        tail.store(0, std::memory_order_relaxed);
+    }
+
+    bool push(const T& value) {
+        size_t pos = tail.load(std::memory_order_relaxed);
+        while (true) {
+            Cell&    cell = cells[pos & mask];
+            size_t   seq  = cell.seq.load(std::memory_order_acquire);
+            intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+            if (diff == 0) {
+                if (tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    cell.data = value;
+                    cell.seq.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;  // full
+            } else {
+                pos = tail.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool pop(T& value) {
+        size_t pos = head.load(std::memory_order_relaxed);
+        while (true) {
+            Cell&    cell = cells[pos & mask];
+            size_t   seq  = cell.seq.load(std::memory_order_acquire);
+            intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+            if (diff == 0) {
+                if (head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    value = cell.data;
+                    cell.seq.store(pos + mask + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;  // empty
+            } else {
+                pos = head.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+   private:
+    struct Cell {
+        std::atomic<size_t> seq;
+        T                   data;
+    };
+
+    std::unique_ptr<Cell[]> cells;
+    size_t                  mask;
+
+    // producers and consumers spin on different cache lines
+    alignas(64) std::atomic<size_t> tail;
+    alignas(64) std::atomic<size_t> head;
+};
+
+/**
+ * Runs one BYTETracker per stream on a shared thread pool.
+ *
+ * Frames are queued per stream and a stream is scheduled on the pool only while it has frames and
+ * is not already running, so the frames of one stream are processed one at a time and in submission
+ * order while different streams run in parallel. Finished frames go to a lock-free completion queue
+ * that poll() drains. Frame and result storage comes from a fixed set of jobs allocated up front;
+ * submit() refuses frames once all of them are in flight.
+ */
+class TrackerManager {
+   public:
+    explicit TrackerManager(const bt_manager_config_t* config);
+    ~TrackerManager();
+
+    /**
+     * Queue frames, stopping at the first one that cannot be accepted.
+     *
+     * May be called from several threads. `*num_submitted` is set to the number of frames queued.
+     */
+    bt_error_t submit(const bt_stream_frame_t* frames, size_t num_frames, size_t* num_submitted);
+
+    /**
+     * Collect finished frames without blocking.
+     *
+     * The tracks of all returned results are stored back to back in `tracks`. A result that does not
+     * fit is kept for the next call, or truncated if it is the first one and `*truncated` is set.
+     * Only one thread may poll at a time.
+     */
+    size_t poll(bt_stream_result_t* results, size_t max_results, bt_bbox_t* tracks, size_t capacity, bool* truncated);
+
+   private:
+    struct Job {
+        uint32_t               stream_id;
+        uint32_t               seq;
+        std::vector<bt_bbox_t> objects;
+        std::vector<bt_bbox_t> tracks;
+    };
+
+    struct Stream {
+        TrackerManager*              owner;
+        std::mutex                   lock;
+        std::deque<Job*>             queue;
+        bool                         scheduled;
+        uint32_t                     next_seq;
+        std::unique_ptr<BYTETracker> tracker;
+    };
+
+    static void run_stream(void* arg);
+
+    bt_config_t tracker_config;
+
+    std::vector<Job>                      jobs;
+    std::vector<std::unique_ptr<Stream> > streams;
+
+    MpmcQueue<Job*> free_jobs;
+    MpmcQueue<Job*> done_jobs;
+    Job*            held;  // popped by poll() but did not fit yet
+
+    // last member, so the workers are joined before anything they use is destroyed
+    ThreadPool pool;
+};
@@ -142,6 +142,15 @@ esp_err_t bsp_i2c_check(i2c_port_t i2c_num, uint8_t address)
     return ret;
 }
 
+static void bsp_io_expander_isr_cb(void *arg)
+{
+    // the SSCMA SYNC line is an expander input, wake the client up when it may have changed
+    if (sscma_client_io_handle != NULL)
+    {
+        sscma_client_io_spi_sync_isr(sscma_client_io_handle);
+    }
+}
+
 esp_io_expander_handle_t bsp_io_expander_init()
 {
     if (io_exp_handle != NULL)
@@ -157,7 +166,7 @@ esp_io_expander_handle_t bsp_io_expander_init()
 
         .int_gpio = BSP_IO_EXPANDER_INT,
         .update_interval_us = 1000000, // 1s
-        .isr_cb = NULL,
+        .isr_cb = bsp_io_expander_isr_cb,
         .user_ctx = NULL,
     };
 
@@ -1270,6 +1279,9 @@ sscma_client_handle_t bsp_sscma_client_init()
         .pclk_hz = BSP_SSCMA_CLIENT_SPI_CLK,
         .spi_mode = 0,
         .wait_delay = 2,
+        .trans_queue_depth = CONFIG_SSCMA_SPI_TRANS_QUEUE_DEPTH,
+        .max_write_len = CONFIG_SSCMA_SPI_MAX_WRITE_LEN,
+        .max_read_len = CONFIG_SSCMA_SPI_MAX_READ_LEN,
         .user_ctx = NULL,
         .io_expander = io_exp_handle,
         .flags.sync_use_expander = BSP_SSCMA_CLIENT_RST_USE_EXPANDER,
@@ -1288,9 +1300,15 @@ sscma_client_handle_t bsp_sscma_client_init()
     sscma_client_config.monitor_task_stack = CONFIG_SSCMA_MONITOR_TASK_STACK_SIZE;
     sscma_client_config.monitor_task_affinity = CONFIG_SSCMA_MONITOR_TASK_AFFINITY;
     sscma_client_config.monitor_task_priority = CONFIG_SSCMA_MONITOR_TASK_PRIORITY;
+    sscma_client_config.reply_slab_size = CONFIG_SSCMA_REPLY_SLAB_SIZE;
+    sscma_client_config.reply_slabs = CONFIG_SSCMA_REPLY_SLABS;
+    sscma_client_config.reply_large_blocks = CONFIG_SSCMA_REPLY_LARGE_BLOCKS;
     sscma_client_config.reset_gpio_num = BSP_SSCMA_CLIENT_RST;
     sscma_client_config.io_expander = io_exp_handle;
     sscma_client_config.flags.reset_use_expander = BSP_SSCMA_CLIENT_RST_USE_EXPANDER;
+#ifdef CONFIG_SSCMA_BINARY_FRAMING
+    sscma_client_config.flags.binary_framing = true;
+#endif
 
     sscma_client_new(sscma_client_io_handle, &sscma_client_config, &sscma_client_handle);
 
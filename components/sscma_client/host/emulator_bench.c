@@ -0,0 +1,436 @@
+// Request latency and stream throughput of the SSCMA client against the emulated device.
+//
+// The client is the one the firmware runs, sscma_client_ops.c with its process and monitor tasks,
+// on the pthread port of FreeRTOS. It talks to sscma_emulator over a socketpair through the
+// loopback IO, so everything from the framer to the request table and the reply dispatch is in
+// the measurement and only the SPI link is not. Three runs:
+//   sync    blocking AT+ID? one after the other, the round trip of a request
+//   async   AT+ID? with up to --in-flight requests outstanding, tagged by the request table
+//   stream  AT+INVOKE events at --fps with --boxes boxes and a --image-size JPEG each; every event
+//           has its boxes read and its image decoded in on_event like the camera pipeline does.
+//           Latency is from the emulator writing an event to on_event being done with it.
+// The emulator_bench_scan build reads inference events with the schema scanner instead of cJSON
+// (CONFIG_SSCMA_SCAN_INFERENCE_EVENTS). --framing binary has the events sent as binary frames with
+// the JPEG as is, --framing fallback asks for them from an emulator without AT+FRAMING. The reply
+// pool counters are printed last, --large-blocks gives image replies blocks of their own. The exit
+// status is non-zero if a request failed, a run timed out or no event was read in full.
+// --io poll takes the data-ready callback away from the loopback IO, so the process task polls
+// every SSCMA_CLIENT_POLL_INTERVAL_MS like with an IO without one, for the latency it adds.
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include "sscma_client_commands.h"
+#include "sscma_client_io.h"
+#include "sscma_client_ops.h"
+#include "sscma_client_io_loopback.h"
+#include "sscma_emulator.h"
+
+#define MAX_BOXES      64
+#define STREAM_IDLE_MS 200
+
+typedef struct
+{
+    sscma_emulator_config_t emulator;
+    int requests;
+    int in_flight;
+    int frames;
+    bool binary_framing;
+    int large_blocks;
+    bool polled;
+} options_t;
+
+typedef struct
+{
+    int64_t *samples;
+    int count;
+    int capacity;
+} samples_t;
+
+typedef struct
+{
+    sscma_emulator_handle_t emulator;
+    SemaphoreHandle_t done;
+    int expected;
+    int frames;
+    int failed;
+    size_t bytes;
+    size_t jpeg_bytes;
+    int64_t first_us;
+    int64_t last_us;
+    int64_t handle_us;
+    int64_t parse_us;
+    samples_t latency;
+    uint8_t *jpeg;
+    size_t jpeg_cap;
+} stream_t;
+
+typedef struct
+{
+    SemaphoreHandle_t slots;
+    SemaphoreHandle_t done;
+    int remaining;
+    int failed;
+} async_t;
+
+static void samples_add(samples_t *samples, int64_t value)
+{
+    if (samples->count == samples->capacity)
+    {
+        samples->capacity = samples->capacity ? samples->capacity * 2 : 1024;
+        samples->samples = realloc(samples->samples, sizeof(int64_t) * samples->capacity);
+    }
+    samples->samples[samples->count++] = value;
+}
+
+static int compare_int64(const void *a, const void *b)
+{
+    int64_t x = *(const int64_t *)a;
+    int64_t y = *(const int64_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+static void samples_report(const char *name, samples_t *samples)
+{
+    if (samples->count == 0)
+    {
+        printf("%-8s no samples\n", name);
+        return;
+    }
+    qsort(samples->samples, samples->count, sizeof(int64_t), compare_int64);
+    int64_t sum = 0;
+    for (int i = 0; i < samples->count; i++)
+    {
+        sum += samples->samples[i];
+    }
+    printf("%-8s %8.1f us avg %8lld us p50 %8lld us p99 %8lld us max\n", name, (double)sum / samples->count, (long long)samples->samples[samples->count / 2],
+        (long long)samples->samples[samples->count * 99 / 100], (long long)samples->samples[samples->count - 1]);
+}
+
+static void on_event(sscma_client_handle_t client, const sscma_client_reply_t *reply, void *user_ctx)
+{
+    stream_t *stream = (stream_t *)user_ctx;
+    (void)client;
+    sscma_client_box_t boxes[MAX_BOXES];
+    int num_boxes = 0;
+    size_t len = 0;
+    int count = -1;
+
+    int64_t start = esp_timer_get_time();
+    if (stream->frames == 0)
+    {
+        stream->first_us = start;
+    }
+
+    sscma_client_inference_t inference = { 0 };
+    if (sscma_utils_parse_inference_from_reply(reply, &inference) == ESP_OK)
+    {
+        count = inference.count;
+    }
+    if (sscma_utils_copy_boxes_from_reply(reply, boxes, MAX_BOXES, &num_boxes) != ESP_OK)
+    {
+        stream->failed++;
+    }
+    int64_t parsed = esp_timer_get_time();
+    if (sscma_utils_decode_image_into(reply, stream->jpeg, stream->jpeg_cap, &len) != ESP_OK)
+    {
+        stream->failed++;
+    }
+
+    int64_t end = esp_timer_get_time();
+    int64_t sent_at = sscma_emulator_sent_at(stream->emulator, count);
+    if (sent_at >= 0)
+    {
+        samples_add(&stream->latency, end - sent_at);
+    }
+    stream->handle_us += end - start;
+    stream->parse_us += parsed - start;
+    stream->bytes += reply->len;
+    stream->jpeg_bytes += len;
+    stream->last_us = end;
+    if (++stream->frames == stream->expected)
+    {
+        xSemaphoreGive(stream->done);
+    }
+}
+
+static void on_async(sscma_client_handle_t client, esp_err_t err, const sscma_client_reply_t *reply, void *user_ctx)
+{
+    async_t *async = (async_t *)user_ctx;
+    (void)client;
+    (void)reply;
+
+    if (err != ESP_OK)
+    {
+        async->failed++;
+    }
+    xSemaphoreGive(async->slots);
+    if (--async->remaining == 0)
+    {
+        xSemaphoreGive(async->done);
+    }
+}
+
+static bool run_sync(sscma_client_handle_t client, const options_t *opt)
+{
+    samples_t latency = { 0 };
+    sscma_client_reply_t reply;
+    int failed = 0;
+
+    int64_t start = esp_timer_get_time();
+    for (int i = 0; i < opt->requests; i++)
+    {
+        int64_t t = esp_timer_get_time();
+        if (sscma_client_request(client, CMD_PREFIX CMD_AT_ID CMD_QUERY CMD_SUFFIX, &reply, true, CMD_WAIT_DELAY) != ESP_OK)
+        {
+            failed++;
+            continue;
+        }
+        samples_add(&latency, esp_timer_get_time() - t);
+        sscma_client_reply_clear(&reply);
+    }
+    int64_t us = esp_timer_get_time() - start;
+
+    samples_report("sync", &latency);
+    printf("%-8s %8.0f requests/s %d failed\n", "", opt->requests * 1e6 / us, failed);
+    free(latency.samples);
+    return failed == 0;
+}
+
+static bool run_async(sscma_client_handle_t client, const options_t *opt)
+{
+    async_t async = {
+        .slots = xSemaphoreCreateCounting(opt->in_flight, opt->in_flight),
+        .done = xSemaphoreCreateBinary(),
+        .remaining = opt->requests,
+    };
+
+    int64_t start = esp_timer_get_time();
+    for (int i = 0; i < opt->requests; i++)
+    {
+        xSemaphoreTake(async.slots, portMAX_DELAY);
+        if (sscma_client_request_async(client, CMD_PREFIX CMD_AT_ID CMD_QUERY CMD_SUFFIX, on_async, &async, CMD_WAIT_DELAY) != ESP_OK)
+        {
+            on_async(client, ESP_FAIL, NULL, &async);
+        }
+    }
+    bool finished = xSemaphoreTake(async.done, pdMS_TO_TICKS(CMD_WAIT_DELAY * 2)) == pdTRUE;
+    int64_t us = esp_timer_get_time() - start;
+
+    printf("%-8s %8.0f requests/s with %d in flight, %d failed%s\n", "async", opt->requests * 1e6 / us, opt->in_flight, async.failed, finished ? "" : ", timed out");
+    vSemaphoreDelete(async.slots);
+    vSemaphoreDelete(async.done);
+    return finished && async.failed == 0;
+}
+
+static bool run_stream(sscma_client_handle_t client, sscma_emulator_handle_t emulator, const options_t *opt)
+{
+    stream_t stream = {
+        .emulator = emulator,
+        .done = xSemaphoreCreateBinary(),
+        .expected = opt->frames,
+        .jpeg_cap = opt->emulator.image_size + 4,
+    };
+    stream.jpeg = malloc(stream.jpeg_cap);
+
+    const sscma_client_callback_t callback = {
+        .on_event = on_event,
+    };
+    sscma_client_register_callback(client, &callback, &stream);
+
+    sscma_emulator_stats_t before, after;
+    sscma_emulator_get_stats(emulator, &before);
+
+    // the wait is sized by the stream rate, with a margin for a slow host. Events the client drops
+    // when its queue is full never come, so the run also ends once everything sent is handled.
+    int64_t deadline = esp_timer_get_time() + 1000LL * (5000 + (opt->emulator.fps > 0 ? opt->frames * 2000LL / opt->emulator.fps : opt->frames * 10LL));
+    bool finished = sscma_client_invoke(client, opt->frames, false, true) == ESP_OK;
+    int handled = -1;
+    while (finished && xSemaphoreTake(stream.done, pdMS_TO_TICKS(STREAM_IDLE_MS)) != pdTRUE)
+    {
+        sscma_emulator_get_stats(emulator, &after);
+        if (after.frames - before.frames == (uint32_t)opt->frames && stream.frames == handled)
+        {
+            break;
+        }
+        handled = stream.frames;
+        finished = esp_timer_get_time() < deadline;
+    }
+    sscma_client_break(client);
+
+    sscma_emulator_get_stats(emulator, &after);
+    int sent = after.frames - before.frames;
+    int64_t us = stream.last_us - stream.first_us;
+
+    printf("%-8s %d of %d events, %d dropped, %d failed%s\n", "stream", stream.frames, opt->frames, sent - stream.frames, stream.failed, finished ? "" : ", timed out");
+    if (stream.frames > 1 && us > 0)
+    {
+        printf("%-8s %8.1f events/s %8.2f MB/s on the link %8.2f MB/s of JPEG %8.1f us in on_event\n", "", (stream.frames - 1) * 1e6 / us, stream.bytes / (double)us,
+            stream.jpeg_bytes / (double)us, (double)stream.handle_us / stream.frames);
+    }
+    if (stream.frames > 0)
+    {
+        printf("%-8s %8zu B/event on the link %8.1f us/event reading results %8.1f us/event getting the JPEG\n", "", stream.bytes / stream.frames, (double)stream.parse_us / stream.frames,
+            (double)(stream.handle_us - stream.parse_us) / stream.frames);
+    }
+    samples_report("latency", &stream.latency);
+
+    vSemaphoreDelete(stream.done);
+    free(stream.latency.samples);
+    free(stream.jpeg);
+    return finished && stream.frames > 0 && stream.failed == 0;
+}
+
+static void usage(const char *argv0)
+{
+    fprintf(stderr,
+        "usage: %s [options]\n"
+        "  --fps N            INVOKE events per second, 0 for as fast as they are taken (default 30)\n"
+        "  --frames N         INVOKE events in the stream run (default 300)\n"
+        "  --boxes N          boxes per event (default 4)\n"
+        "  --image-size B     JPEG bytes per event, before base64 (default 16384)\n"
+        "  --sensor N         sensor resolution, 0 240x240 .. 3 640x480 (default 3)\n"
+        "  --requests N       requests in the sync and async runs (default 2000)\n"
+        "  --in-flight N      outstanding requests in the async run (default 4)\n"
+        "  --framing MODE     json, binary, or fallback to json from a device without binary (default json)\n"
+        "  --large-blocks N   reply pool blocks for image replies, 0 to take them from the heap (default 0)\n"
+        "  --io MODE          notify on data-ready, or poll (default notify)\n"
+        "  --verbose          client logs down to info\n",
+        argv0);
+}
+
+int main(int argc, char **argv)
+{
+    options_t opt = {
+        .emulator = SSCMA_EMULATOR_CONFIG_DEFAULT(),
+        .requests = 2000,
+        .in_flight = 4,
+        .frames = 300,
+    };
+
+    for (int i = 1; i < argc; i++)
+    {
+        const char *arg = argv[i];
+        if (strcmp(arg, "--verbose") == 0)
+        {
+            esp_log_level_set("*", ESP_LOG_INFO);
+            continue;
+        }
+        const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+        if (value == NULL)
+        {
+            usage(argv[0]);
+            return 1;
+        }
+        if (strcmp(arg, "--fps") == 0)
+        {
+            opt.emulator.fps = atoi(value);
+        }
+        else if (strcmp(arg, "--frames") == 0)
+        {
+            opt.frames = atoi(value);
+        }
+        else if (strcmp(arg, "--boxes") == 0)
+        {
+            opt.emulator.num_boxes = atoi(value);
+        }
+        else if (strcmp(arg, "--image-size") == 0)
+        {
+            opt.emulator.image_size = strtoul(value, NULL, 10);
+        }
+        else if (strcmp(arg, "--sensor") == 0)
+        {
+            opt.emulator.sensor_opt_id = atoi(value);
+        }
+        else if (strcmp(arg, "--requests") == 0)
+        {
+            opt.requests = atoi(value);
+        }
+        else if (strcmp(arg, "--in-flight") == 0)
+        {
+            opt.in_flight = atoi(value);
+        }
+        else if (strcmp(arg, "--large-blocks") == 0)
+        {
+            opt.large_blocks = atoi(value);
+        }
+        else if (strcmp(arg, "--framing") == 0 && (strcmp(value, "json") == 0 || strcmp(value, "binary") == 0 || strcmp(value, "fallback") == 0))
+        {
+            opt.binary_framing = strcmp(value, "json") != 0;
+            opt.emulator.binary = strcmp(value, "binary") == 0;
+        }
+        else if (strcmp(arg, "--io") == 0 && (strcmp(value, "notify") == 0 || strcmp(value, "poll") == 0))
+        {
+            opt.polled = strcmp(value, "poll") == 0;
+        }
+        else
+        {
+            usage(argv[0]);
+            return 1;
+        }
+        i++;
+    }
+    if (opt.emulator.fps < 0 || opt.frames <= 0 || opt.emulator.num_boxes < 0 || opt.emulator.num_boxes > MAX_BOXES || opt.emulator.image_size == 0 || opt.requests <= 0
+        || opt.in_flight <= 0 || opt.in_flight > SSCMA_CLIENT_REQUEST_SLOTS || opt.large_blocks < 0)
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0)
+    {
+        perror("socketpair");
+        return 1;
+    }
+
+    sscma_emulator_handle_t emulator = NULL;
+    sscma_client_io_handle_t io = NULL;
+    sscma_client_handle_t client = NULL;
+    sscma_client_config_t config = SSCMA_CLIENT_CONFIG_DEFAULT();
+    sscma_client_info_t *info = NULL;
+    sscma_client_model_t *model = NULL;
+
+    config.flags.binary_framing = opt.binary_framing;
+    config.reply_large_blocks = opt.large_blocks;
+
+    esp_err_t io_ret = opt.polled ? sscma_client_new_io_loopback_polled(fds[0], &io) : sscma_client_new_io_loopback(fds[0], &io);
+    if (sscma_emulator_start(&opt.emulator, fds[1], &emulator) != ESP_OK || io_ret != ESP_OK || sscma_client_new(io, &config, &client) != ESP_OK
+        || sscma_client_init(client) != ESP_OK)
+    {
+        fprintf(stderr, "cannot set up the client\n");
+        return 1;
+    }
+    if (sscma_client_get_info(client, &info, false) != ESP_OK || sscma_client_get_model(client, &model, false) != ESP_OK)
+    {
+        fprintf(stderr, "emulator does not answer\n");
+        return 1;
+    }
+    printf("%s %s, model %s, %d boxes and %zu B JPEG per event at %d fps, %s framing, %s\n", info->name, info->fw_ver, model->name, opt.emulator.num_boxes,
+        opt.emulator.image_size, opt.emulator.fps, client->rx_buffer.binary ? "binary" : "json", client->process_task.notify ? "notified" : "polling");
+
+    bool ok = run_sync(client, &opt);
+    ok = run_async(client, &opt) && ok;
+    ok = run_stream(client, emulator, &opt) && ok;
+
+    sscma_client_pool_stats_t pool;
+    sscma_client_get_pool_stats(client, &pool);
+    printf("%-8s %u replies, %u from the heap, at most %u slabs, %u large blocks and %u heap buffers held\n", "pool", pool.allocs, pool.heap_fallbacks, pool.slabs_high_water,
+        pool.large_high_water, pool.heap_high_water);
+
+    sscma_client_del(client);
+    sscma_client_del_io(io);
+    sscma_emulator_stop(emulator);
+    close(fds[0]);
+    close(fds[1]);
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,225 @@
+// Throughput of the WE2 UART flasher against an emulated bootloader.
+//
+// The flasher is the one the firmware runs, sscma_client_flasher_we2_uart.c on the pthread port of
+// FreeRTOS, talking to sscma_bootloader over a socketpair through the loopback IO. The bootloader
+// holds every answer for the time the block takes on a UART at --baud plus --turnaround-us to
+// check and program it, and NAKs one block in --error-rate. An image of --size bytes is written
+// in --chunk sized writes like app_ota does, then read back from the bootloader and compared,
+// and the block sizes the bootloader took must be those of the run.
+// Runs, all by default:
+//   128       XMODEM with 128 byte blocks, as the flasher always did
+//   1k        XMODEM-1K, 1024 byte blocks while enough data is left
+//   fallback  XMODEM-1K asked of a bootloader that refuses it, 128 byte blocks after the first NAK
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include "sscma_client_io.h"
+#include "sscma_client_flasher.h"
+#include "sscma_client_io_loopback.h"
+#include "sscma_bootloader.h"
+
+typedef struct
+{
+    sscma_bootloader_config_t bootloader;
+    size_t size;
+    size_t chunk;
+    size_t offset;
+    const char *run;
+} options_t;
+
+static bool run_flash(const char *name, const options_t *opt, const uint8_t *image, bool xmodem_1k, bool receiver_1k)
+{
+    sscma_bootloader_config_t bootloader_config = opt->bootloader;
+    sscma_client_flasher_we2_config_t flasher_config = {
+        .reset_gpio_num = -1,
+        .flags.xmodem_1k = xmodem_1k,
+    };
+    sscma_bootloader_handle_t bootloader = NULL;
+    sscma_client_io_handle_t io = NULL;
+    sscma_client_flasher_handle_t flasher = NULL;
+    esp_err_t ret = ESP_FAIL;
+    int fds[2];
+
+    bootloader_config.xmodem_1k = receiver_1k;
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0)
+    {
+        perror("socketpair");
+        return false;
+    }
+    if (sscma_bootloader_start(&bootloader_config, fds[1], &bootloader) != ESP_OK || sscma_client_new_io_loopback(fds[0], &io) != ESP_OK
+        || sscma_client_new_flasher_we2_uart(io, &flasher_config, &flasher) != ESP_OK)
+    {
+        fprintf(stderr, "cannot set up the flasher\n");
+        return false;
+    }
+
+    // entering the bootloader is a fixed cost, the rate is that of the transfer
+    int64_t start = esp_timer_get_time();
+    int64_t transfer = 0;
+    ret = sscma_client_flasher_start(flasher, opt->offset);
+    if (ret == ESP_OK)
+    {
+        transfer = esp_timer_get_time();
+        for (size_t pos = 0; pos < opt->size && ret == ESP_OK; pos += opt->chunk)
+        {
+            size_t len = opt->size - pos < opt->chunk ? opt->size - pos : opt->chunk;
+            ret = sscma_client_flasher_write(flasher, image + pos, len);
+        }
+    }
+    if (ret == ESP_OK)
+    {
+        ret = sscma_client_flasher_finish(flasher);
+    }
+    int64_t end = esp_timer_get_time();
+
+    sscma_bootloader_stats_t stats;
+    size_t len = 0;
+    size_t offset = 0;
+    sscma_bootloader_get_stats(bootloader, &stats);
+    const uint8_t *received = sscma_bootloader_get_image(bootloader, &len, &offset);
+    bool match = ret == ESP_OK && stats.done && len >= opt->size && memcmp(received, image, opt->size) == 0 && offset == opt->offset;
+    // every whole KB of a write in a 1K block when both ends take them, none otherwise and a
+    // refusing bootloader NAKs the first STX block
+    size_t whole_kb = opt->size / opt->chunk * (opt->chunk / 1024) + opt->size % opt->chunk / 1024;
+    bool blocks = xmodem_1k && receiver_1k ? stats.blocks_1k == whole_kb : stats.blocks_1k == 0 && (!xmodem_1k || stats.naks > 0);
+
+    if (ret != ESP_OK)
+    {
+        printf("%-9s failed: 0x%x\n", name, ret);
+    }
+    else
+    {
+        double seconds = (end - transfer) / 1e6;
+        printf("%-9s %7.1f KB/s  %6.2f s (%.2f s total)  %u blocks, %u of 1K, %u NAKs, %u resent  %.1f%% link overhead  %s%s\n", name, opt->size / 1024.0 / seconds, seconds,
+            (end - start) / 1e6, stats.blocks, stats.blocks_1k, stats.naks, stats.duplicates, 100.0 * ((double)stats.bytes / opt->size - 1), match ? "image OK" : "IMAGE MISMATCH",
+            blocks ? "" : ", WRONG BLOCK SIZES");
+    }
+
+    sscma_client_flasher_delete(flasher);
+    sscma_client_del_io(io);
+    sscma_bootloader_stop(bootloader);
+    close(fds[0]);
+    close(fds[1]);
+
+    return match && blocks;
+}
+
+static void usage(const char *argv0)
+{
+    fprintf(stderr,
+        "usage: %s [options]\n"
+        "  --size B           image bytes, a multiple of 128 (default 262144)\n"
+        "  --chunk B          bytes per flasher write, a multiple of 128 (default 4096)\n"
+        "  --offset B         flash offset, sent in the config transfer first when not 0 (default 0)\n"
+        "  --baud N           emulated UART baud rate, 0 for no limit (default 921600)\n"
+        "  --turnaround-us N  bootloader time to check and program a block (default 2000)\n"
+        "  --error-rate N     one block in N is corrupted, 0 for none (default 0)\n"
+        "  --run NAME         128, 1k, fallback or all (default all)\n"
+        "  --verbose          flasher logs down to info\n",
+        argv0);
+}
+
+int main(int argc, char **argv)
+{
+    options_t opt = {
+        .bootloader = SSCMA_BOOTLOADER_CONFIG_DEFAULT(),
+        .size = 256 * 1024,
+        .chunk = 4096,
+        .run = "all",
+    };
+
+    for (int i = 1; i < argc; i++)
+    {
+        const char *arg = argv[i];
+        if (strcmp(arg, "--verbose") == 0)
+        {
+            esp_log_level_set("*", ESP_LOG_INFO);
+            continue;
+        }
+        const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+        if (value == NULL)
+        {
+            usage(argv[0]);
+            return 1;
+        }
+        if (strcmp(arg, "--size") == 0)
+        {
+            opt.size = strtoul(value, NULL, 10);
+        }
+        else if (strcmp(arg, "--chunk") == 0)
+        {
+            opt.chunk = strtoul(value, NULL, 10);
+        }
+        else if (strcmp(arg, "--offset") == 0)
+        {
+            opt.offset = strtoul(value, NULL, 0);
+        }
+        else if (strcmp(arg, "--baud") == 0)
+        {
+            opt.bootloader.baud = atoi(value);
+        }
+        else if (strcmp(arg, "--turnaround-us") == 0)
+        {
+            opt.bootloader.turnaround_us = atoi(value);
+        }
+        else if (strcmp(arg, "--error-rate") == 0)
+        {
+            opt.bootloader.error_rate = atoi(value);
+        }
+        else if (strcmp(arg, "--run") == 0 && (strcmp(value, "128") == 0 || strcmp(value, "1k") == 0 || strcmp(value, "fallback") == 0 || strcmp(value, "all") == 0))
+        {
+            opt.run = value;
+        }
+        else
+        {
+            usage(argv[0]);
+            return 1;
+        }
+        i++;
+    }
+    if (opt.size == 0 || opt.size % 128 != 0 || opt.chunk == 0 || opt.chunk % 128 != 0 || opt.bootloader.baud < 0 || opt.bootloader.turnaround_us < 0 || opt.bootloader.error_rate < 0)
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    uint8_t *image = (uint8_t *)malloc(opt.size);
+    if (image == NULL)
+    {
+        fprintf(stderr, "no mem for image\n");
+        return 1;
+    }
+    for (size_t i = 0; i < opt.size; i++)
+    {
+        image[i] = (uint8_t)(i * 31 + (i >> 9));
+    }
+
+    printf("%zu B image in %zu B writes at %d baud, %d us turnaround, one block in %d corrupted\n", opt.size, opt.chunk, opt.bootloader.baud, opt.bootloader.turnaround_us,
+        opt.bootloader.error_rate);
+
+    bool ok = true;
+    bool all = strcmp(opt.run, "all") == 0;
+    if (all || strcmp(opt.run, "128") == 0)
+    {
+        ok &= run_flash("128", &opt, image, false, true);
+    }
+    if (all || strcmp(opt.run, "1k") == 0)
+    {
+        ok &= run_flash("1k", &opt, image, true, true);
+    }
+    if (all || strcmp(opt.run, "fallback") == 0)
+    {
+        ok &= run_flash("fallback", &opt, image, true, false);
+    }
+
+    free(image);
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,281 @@
+// Throughput of the SSCMA reply framer, fed the way sscma_client_process feeds it.
+//
+// The input is either a capture of the raw bytes read from the Himax (as returned by
+// sscma_client_read, NUL padding included) or synthetic INVOKE events carrying a base64 image.
+// The previous parser (strip NULs over the whole buffer, strnstr from the start, memmove after
+// every reply) is run on the same input as a baseline.
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "sscma_client_framer.h"
+
+#define RESPONSE_PREFIX "\r{"
+#define RESPONSE_SUFFIX "}\n"
+
+typedef struct
+{
+    const char *capture;
+    size_t frames;
+    size_t image_size;
+    size_t chunk;
+    size_t ring;
+    int repeat;
+} options_t;
+
+static double now_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static char *load_capture(const char *path, size_t *len)
+{
+    FILE *f = fopen(path, "rb");
+    if (f == NULL)
+    {
+        return NULL;
+    }
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    char *data = malloc(size > 0 ? size : 1);
+    *len = fread(data, 1, size, f);
+    fclose(f);
+    return data;
+}
+
+// INVOKE events as sent by the Himax, with the SPI transport padding every read with NULs
+static char *synthesize(const options_t *opt, size_t *len)
+{
+    static const char b64[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    size_t cap = opt->frames * (opt->image_size + 512);
+    char *data = malloc(cap);
+    size_t pos = 0;
+
+    srand(1);
+    for (size_t i = 0; i < opt->frames; i++)
+    {
+        pos += sprintf(data + pos, "\r{\"type\": 1, \"name\": \"INVOKE\", \"code\": 0, \"data\": {\"count\": %u, \"image\": \"", (unsigned)i);
+        for (size_t j = 0; j < opt->image_size; j++)
+        {
+            data[pos++] = b64[rand() & 63];
+        }
+        pos += sprintf(data + pos, "\", \"boxes\": [[%d, %d, 64, 64, 87, 0]], \"perf\": [8, 42, 1]}}\n", rand() % 480, rand() % 480);
+        if (rand() % 4 == 0)
+        {
+            size_t pad = rand() % 64;
+            memset(data + pos, 0, pad);
+            pos += pad;
+        }
+    }
+    *len = pos;
+    return data;
+}
+
+static char *bsd_strnstr(const char *s, const char *find, size_t slen)
+{
+    size_t len = strlen(find);
+    for (; slen >= len && *s; s++, slen--)
+    {
+        if (strncmp(s, find, len) == 0)
+        {
+            return (char *)s;
+        }
+    }
+    return NULL;
+}
+
+static size_t run_framer(const options_t *opt, const char *input, size_t len, char *reply)
+{
+    char *ring = malloc(opt->ring);
+    sscma_client_framer_t framer;
+    sscma_client_frame_t frame;
+    size_t frames = 0;
+    size_t pos = 0;
+
+    sscma_client_framer_init(&framer, ring, opt->ring);
+    while (pos < len)
+    {
+        size_t space = 0;
+        char *data = sscma_client_framer_write_ptr(&framer, &space);
+        if (space == 0)
+        {
+            sscma_client_framer_reset(&framer);
+            continue;
+        }
+        size_t n = len - pos < opt->chunk ? len - pos : opt->chunk;
+        n = n < space ? n : space;
+        memcpy(data, input + pos, n);
+        pos += n;
+        sscma_client_framer_commit(&framer, n);
+        while (sscma_client_framer_next(&framer, &frame))
+        {
+            sscma_client_frame_copy(&frame, reply);
+            frames++;
+        }
+    }
+    free(ring);
+    return frames;
+}
+
+static size_t run_legacy(const options_t *opt, const char *input, size_t len, char *reply)
+{
+    char *buffer = malloc(opt->ring + 1);
+    size_t frames = 0;
+    size_t pos = 0;
+    size_t in = 0;
+    char *suffix = NULL;
+    char *prefix = NULL;
+
+    while (in < len)
+    {
+        size_t n = len - in < opt->chunk ? len - in : opt->chunk;
+        if (n + pos > opt->ring)
+        {
+            n = opt->ring - pos;
+            if (n == 0)
+            {
+                pos = 0;
+                continue;
+            }
+        }
+        memcpy(buffer + pos, input + in, n);
+        in += n;
+        pos += n;
+
+        size_t new_pos = 0;
+        for (size_t i = 0; i < pos; i++)
+        {
+            if (buffer[i] != '\0')
+            {
+                buffer[new_pos++] = buffer[i];
+            }
+        }
+        pos = new_pos;
+        buffer[pos] = 0;
+
+        while ((suffix = bsd_strnstr(buffer, RESPONSE_SUFFIX, pos)) != NULL)
+        {
+            size_t consumed = suffix - buffer + 2;
+            if ((prefix = bsd_strnstr(buffer, RESPONSE_PREFIX, suffix - buffer)) != NULL)
+            {
+                size_t flen = suffix - prefix + 2;
+                memcpy(reply, prefix, flen);
+                reply[flen] = 0;
+                frames++;
+            }
+            memmove(buffer, buffer + consumed, pos - consumed);
+            pos -= consumed;
+            buffer[pos] = 0;
+        }
+    }
+    free(buffer);
+    return frames;
+}
+
+static void report(const char *name, size_t (*run)(const options_t *, const char *, size_t, char *), const options_t *opt, const char *input, size_t len)
+{
+    char *reply = malloc(opt->ring + 1);
+    size_t frames = 0;
+    double best = 1e30;
+
+    for (int i = 0; i < opt->repeat; i++)
+    {
+        double start = now_seconds();
+        frames = run(opt, input, len, reply);
+        double elapsed = now_seconds() - start;
+        best = elapsed < best ? elapsed : best;
+    }
+    printf("%-8s %8zu frames %10.1f MB/s %10.3f ms\n", name, frames, len / best / 1e6, best * 1e3);
+    free(reply);
+}
+
+static void usage(const char *argv0)
+{
+    fprintf(stderr,
+        "usage: %s [options]\n"
+        "  --capture FILE     raw bytes read from the Himax, NUL padding included\n"
+        "  --frames N         synthetic INVOKE events without a capture (default 200)\n"
+        "  --image-size B     base64 image bytes per synthetic event (default 40000)\n"
+        "  --chunk B          bytes per read, as returned by available() (default 4095)\n"
+        "  --ring B           rx buffer size (default 65536)\n"
+        "  --repeat N         runs, the fastest is reported (default 5)\n",
+        argv0);
+}
+
+int main(int argc, char **argv)
+{
+    options_t opt = {
+        .capture = NULL,
+        .frames = 200,
+        .image_size = 40000,
+        .chunk = 4095,
+        .ring = 65536,
+        .repeat = 5,
+    };
+
+    for (int i = 1; i < argc; i++)
+    {
+        const char *arg = argv[i];
+        const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+        if (value == NULL)
+        {
+            usage(argv[0]);
+            return 1;
+        }
+        if (strcmp(arg, "--capture") == 0)
+        {
+            opt.capture = value;
+        }
+        else if (strcmp(arg, "--frames") == 0)
+        {
+            opt.frames = strtoul(value, NULL, 10);
+        }
+        else if (strcmp(arg, "--image-size") == 0)
+        {
+            opt.image_size = strtoul(value, NULL, 10);
+        }
+        else if (strcmp(arg, "--chunk") == 0)
+        {
+            opt.chunk = strtoul(value, NULL, 10);
+        }
+        else if (strcmp(arg, "--ring") == 0)
+        {
+            opt.ring = strtoul(value, NULL, 10);
+        }
+        else if (strcmp(arg, "--repeat") == 0)
+        {
+            opt.repeat = atoi(value);
+        }
+        else
+        {
+            usage(argv[0]);
+            return 1;
+        }
+        i++;
+    }
+    if (opt.chunk == 0 || opt.ring == 0 || opt.repeat <= 0)
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    size_t len = 0;
+    char *input = opt.capture ? load_capture(opt.capture, &len) : synthesize(&opt, &len);
+    if (input == NULL)
+    {
+        fprintf(stderr, "cannot read %s\n", opt.capture);
+        return 1;
+    }
+
+    printf("%zu bytes, %zu byte reads, %zu byte ring\n", len, opt.chunk, opt.ring);
+    report("framer", run_framer, &opt, input, len);
+    report("legacy", run_legacy, &opt, input, len);
+
+    free(input);
+    return 0;
+}
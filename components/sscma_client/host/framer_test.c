@@ -0,0 +1,756 @@
+// Tests of the SSCMA reply framer, fed the way sscma_client_process feeds it.
+//
+// Unit cases cover frames split at every byte, garbage and logs around frames, frames cut short,
+// NUL padding in both modes, the wrap of the ring, a full ring and binary frames. The fuzz pass
+// builds random streams of frames, garbage and padding, inside JSON frames too, feeds them in random reads into rings of random size and
+// requires exactly the frames put in; a second pass feeds random bytes and checks every frame
+// handed out is well formed. With --replay a capture of the raw bytes read from the device is fed
+// in reads of several sizes into rings of several sizes, and every run must hand out the frames a
+// plain scan of the whole capture finds, in binary mode with --binary.
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sscma_client_binary.h"
+#include "sscma_client_framer.h"
+
+#define MAX_FRAMES 4096
+
+typedef struct
+{
+    char *data;        // Frames back to back
+    size_t size;       // Capacity of data
+    size_t len;        // Bytes used
+    size_t count;      // Number of frames
+    size_t off[MAX_FRAMES];
+    size_t flen[MAX_FRAMES];
+    bool wrapped;      // Whether some frame was handed out in two parts
+    bool overflowed;   // Whether the ring ran full and was reset
+} frames_t;
+
+static int failures = 0;
+
+#define CHECK(cond, ...)                                                                                                                                                                               \
+    do                                                                                                                                                                                                 \
+    {                                                                                                                                                                                                  \
+        if (!(cond))                                                                                                                                                                                   \
+        {                                                                                                                                                                                              \
+            printf("%s:%d: ", __func__, __LINE__);                                                                                                                                                     \
+            printf(__VA_ARGS__);                                                                                                                                                                       \
+            printf("\n");                                                                                                                                                                              \
+            failures++;                                                                                                                                                                                \
+            return;                                                                                                                                                                                    \
+        }                                                                                                                                                                                              \
+    } while (0)
+
+static void frames_init(frames_t *frames, size_t size)
+{
+    memset(frames, 0, sizeof(*frames));
+    frames->data = malloc(size + 1);
+    frames->size = size;
+}
+
+static void frames_free(frames_t *frames)
+{
+    free(frames->data);
+}
+
+static void frames_add(frames_t *frames, const char *data, size_t len)
+{
+    if (frames->count == MAX_FRAMES || frames->len + len > frames->size)
+    {
+        return;
+    }
+    memcpy(frames->data + frames->len, data, len);
+    frames->off[frames->count] = frames->len;
+    frames->flen[frames->count] = len;
+    frames->len += len;
+    frames->count++;
+}
+
+static const char *frames_at(const frames_t *frames, size_t i)
+{
+    return frames->data + frames->off[i];
+}
+
+// Feed input in reads of chunk bytes, or of random sizes up to chunk when random is set, as
+// sscma_client_process does: read into the free space, commit, take every complete frame
+static void feed(sscma_client_framer_t *framer, const char *input, size_t len, size_t chunk, bool random, frames_t *out)
+{
+    char *copy = malloc(framer->size + 1);
+    size_t pos = 0;
+    sscma_client_frame_t frame;
+
+    while (pos < len)
+    {
+        size_t space = 0;
+        char *data = sscma_client_framer_write_ptr(framer, &space);
+        if (space == 0)
+        {
+            out->overflowed = true;
+            sscma_client_framer_reset(framer);
+            continue;
+        }
+        size_t n = random ? 1 + (size_t)rand() % chunk : chunk;
+        n = n < len - pos ? n : len - pos;
+        n = n < space ? n : space;
+        memcpy(data, input + pos, n);
+        pos += n;
+        sscma_client_framer_commit(framer, n);
+        while (sscma_client_framer_next(framer, &frame))
+        {
+            if (frame.part[1] != NULL)
+            {
+                out->wrapped = true;
+            }
+            if (frame.part_len[0] + frame.part_len[1] != frame.len || frame.len > framer->size)
+            {
+                frames_add(out, "", 0); // counted, and never equal to a real frame
+                continue;
+            }
+            sscma_client_frame_copy(&frame, copy);
+            frames_add(out, copy, frame.len);
+        }
+    }
+    free(copy);
+}
+
+static bool frames_equal(const frames_t *a, const frames_t *b)
+{
+    if (a->count != b->count)
+    {
+        return false;
+    }
+    for (size_t i = 0; i < a->count; i++)
+    {
+        if (a->flen[i] != b->flen[i] || memcmp(frames_at(a, i), frames_at(b, i), a->flen[i]) != 0)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static size_t first_difference(const frames_t *a, const frames_t *b)
+{
+    size_t i = 0;
+    while (i < a->count && i < b->count && a->flen[i] == b->flen[i] && memcmp(frames_at(a, i), frames_at(b, i), a->flen[i]) == 0)
+    {
+        i++;
+    }
+    return i;
+}
+
+// Feed a string in every read size from 1 to its length and expect the same frames each time
+static void expect_frames(const char *name, const char *input, size_t len, bool binary, size_t ring, const char *const *expected, size_t count)
+{
+    char *storage = malloc(ring);
+    sscma_client_framer_t framer;
+
+    for (size_t chunk = 1; chunk <= len; chunk++)
+    {
+        frames_t out;
+        frames_init(&out, len + 1);
+        sscma_client_framer_init(&framer, storage, ring);
+        sscma_client_framer_set_binary(&framer, binary);
+        feed(&framer, input, len, chunk, false, &out);
+
+        bool ok = out.count == count;
+        for (size_t i = 0; ok && i < count; i++)
+        {
+            ok = out.flen[i] == strlen(expected[i]) && memcmp(frames_at(&out, i), expected[i], out.flen[i]) == 0;
+        }
+        if (!ok)
+        {
+            printf("%s: %zu byte reads give %zu frames, expected %zu\n", name, chunk, out.count, count);
+            failures++;
+            frames_free(&out);
+            break;
+        }
+        frames_free(&out);
+    }
+    free(storage);
+}
+
+static void test_single(void)
+{
+    static const char input[] = "\r{\"type\":0,\"name\":\"ID?\",\"code\":0,\"data\":\"e3f0a1b2\"}\n";
+    const char *expected[] = {input};
+    expect_frames(__func__, input, sizeof(input) - 1, false, 256, expected, 1);
+}
+
+static void test_garbage(void)
+{
+    static const char input[] = "boot log\r\n\r{\"a\":1}\nnoise}\n}\n\r\r{\"b\":2}\n\n\r";
+    const char *expected[] = {"\r{\"a\":1}\n", "\r{\"b\":2}\n"};
+    expect_frames(__func__, input, sizeof(input) - 1, false, 256, expected, 2);
+}
+
+static void test_cut_short(void)
+{
+    // the device restarted in the middle of a reply
+    static const char input[] = "\r{\"type\":1,\"name\":\"INVOKE\",\"da\r{\"type\":1,\"name\":\"INIT@STAT\"}\n";
+    const char *expected[] = {"\r{\"type\":1,\"name\":\"INIT@STAT\"}\n"};
+    expect_frames(__func__, input, sizeof(input) - 1, false, 256, expected, 1);
+}
+
+static void test_nul_padding(void)
+{
+    // reads are padded with NULs wherever they end, in and between frames; binary mode keeps
+    // them in the ring but hands out the same JSON frames
+    static const char input[] = "\0\0\r\0{\"a\":\0\0\0001}\0\n\0\0\0\r{\"b\":2}\n\0\r\0\0";
+    const char *expected[] = {"\r{\"a\":1}\n", "\r{\"b\":2}\n"};
+    expect_frames(__func__, input, sizeof(input) - 1, false, 256, expected, 2);
+    expect_frames(__func__, input, sizeof(input) - 1, true, 256, expected, 2);
+    expect_frames(__func__, input, sizeof(input) - 1, true, 14, expected, 2); // the padded frame just fits
+}
+
+static void test_wrap(void)
+{
+    static const char one[] = "\r{\"count\":1234}\n";
+    char input[sizeof(one) * 16];
+    size_t len = 0;
+    for (int i = 0; i < 16; i++)
+    {
+        memcpy(input + len, one, sizeof(one) - 1);
+        len += sizeof(one) - 1;
+    }
+
+    // reads of 5 bytes into 40 bytes of ring leave frames across its end
+    char storage[40];
+    sscma_client_framer_t framer;
+    frames_t out;
+    frames_init(&out, len);
+    sscma_client_framer_init(&framer, storage, sizeof(storage));
+    feed(&framer, input, len, 5, false, &out);
+
+    CHECK(out.count == 16, "%zu frames, expected 16", out.count);
+    CHECK(out.wrapped, "no frame wrapped around the ring");
+    for (size_t i = 0; i < out.count; i++)
+    {
+        CHECK(out.flen[i] == sizeof(one) - 1 && memcmp(frames_at(&out, i), one, out.flen[i]) == 0, "frame %zu differs", i);
+    }
+    frames_free(&out);
+}
+
+static void test_full(void)
+{
+    // a frame larger than the ring fills it, the reader resets and the next frame comes through
+    static const char input[] = "\r{\"image\":\"0123456789012345678901234567890123456789\"}\n\r{\"a\":1}\n";
+    char storage[32];
+    sscma_client_framer_t framer;
+    frames_t out;
+    frames_init(&out, sizeof(input));
+    sscma_client_framer_init(&framer, storage, sizeof(storage));
+    feed(&framer, input, sizeof(input) - 1, 7, false, &out);
+
+    CHECK(out.overflowed, "the ring never ran full");
+    CHECK(out.count == 1 && out.flen[0] == 9 && memcmp(frames_at(&out, 0), "\r{\"a\":1}\n", 9) == 0, "%zu frames, expected only the small one", out.count);
+    frames_free(&out);
+}
+
+// A binary frame around body, the length in the header
+static size_t binary_frame(char *dst, const char *body, size_t body_len)
+{
+    dst[0] = '\r';
+    dst[1] = (char)SSCMA_CLIENT_BINARY_MAGIC;
+    for (int i = 0; i < 4; i++)
+    {
+        dst[2 + i] = (char)(body_len >> (8 * i));
+    }
+    memcpy(dst + SSCMA_CLIENT_BINARY_HEADER_LEN, body, body_len);
+    return SSCMA_CLIENT_BINARY_HEADER_LEN + body_len;
+}
+
+static void test_binary(void)
+{
+    // the body holds everything a JSON scan would trip over
+    static const char body[] = "\x01\0\0\x06INVOKE}\n\r{\0\r\xb1\xff\xff\xff\x7f}\n";
+    static const char json[] = "\r{\"type\":0,\"name\":\"BREAK\"}\n";
+    char input[128];
+    char frame[64];
+    size_t frame_len = binary_frame(frame, body, sizeof(body) - 1);
+    size_t len = 0;
+    memcpy(input + len, "log\r\n", 5);
+    len += 5;
+    memcpy(input + len, frame, frame_len);
+    len += frame_len;
+    memcpy(input + len, json, sizeof(json) - 1);
+    len += sizeof(json) - 1;
+
+    char storage[256];
+    sscma_client_framer_t framer;
+    for (size_t chunk = 1; chunk <= len; chunk++)
+    {
+        frames_t out;
+        frames_init(&out, len);
+        sscma_client_framer_init(&framer, storage, sizeof(storage));
+        sscma_client_framer_set_binary(&framer, true);
+        feed(&framer, input, len, chunk, false, &out);
+        bool ok = out.count == 2 && out.flen[0] == frame_len && memcmp(frames_at(&out, 0), frame, frame_len) == 0 && out.flen[1] == sizeof(json) - 1
+                  && memcmp(frames_at(&out, 1), json, out.flen[1]) == 0;
+        frames_free(&out);
+        CHECK(ok, "%zu byte reads: %zu frames, expected the binary one and the JSON one", chunk, out.count);
+    }
+}
+
+static void test_binary_padding(void)
+{
+    // padding between frames and inside the JSON one is dropped, the NULs of the body are kept
+    static const char body[] = "\x01\0\0\x06INVOKE\0\0\r\0{";
+    static const char json[] = "\r{\"type\":0,\"name\":\"BREAK\"}\n";
+    static const char padded[] = "\r\0{\"type\":0,\"na\0\0me\":\"BREAK\"}\0\n";
+    char input[128];
+    char frame[64];
+    size_t frame_len = binary_frame(frame, body, sizeof(body) - 1);
+    size_t len = 0;
+    memset(input + len, 0, 7);
+    len += 7;
+    memcpy(input + len, frame, frame_len);
+    len += frame_len;
+    memset(input + len, 0, 3);
+    len += 3;
+    memcpy(input + len, padded, sizeof(padded) - 1);
+    len += sizeof(padded) - 1;
+    memcpy(input + len, "\r\0\0", 3);
+    len += 3;
+    memcpy(input + len, frame, frame_len);
+    len += frame_len;
+
+    // rings that just hold a frame and its padding, so both wrap
+    const size_t rings[] = {sizeof(padded) - 1, sizeof(padded) + 5, 256};
+    for (size_t r = 0; r < sizeof(rings) / sizeof(rings[0]); r++)
+    {
+        char storage[256];
+        sscma_client_framer_t framer;
+        for (size_t chunk = 1; chunk <= len; chunk++)
+        {
+            frames_t out;
+            frames_init(&out, len);
+            sscma_client_framer_init(&framer, storage, rings[r]);
+            sscma_client_framer_set_binary(&framer, true);
+            feed(&framer, input, len, chunk, false, &out);
+            bool ok = out.count == 3 && !out.overflowed;
+            for (size_t i = 0; ok && i < 3; i++)
+            {
+                const char *want = i == 1 ? json : frame;
+                size_t want_len = i == 1 ? sizeof(json) - 1 : frame_len;
+                ok = out.flen[i] == want_len && memcmp(frames_at(&out, i), want, want_len) == 0;
+            }
+            frames_free(&out);
+            CHECK(ok, "%zu byte ring, %zu byte reads: %zu frames, expected binary, JSON, binary", rings[r], chunk, out.count);
+        }
+    }
+}
+
+static void test_binary_off(void)
+{
+    // without binary framing the prefix is garbage
+    static const char body[] = "\x01\0\0\x06INVOKE";
+    static const char json[] = "\r{\"a\":1}\n";
+    char input[64];
+    size_t len = binary_frame(input, body, sizeof(body) - 1);
+    memcpy(input + len, json, sizeof(json) - 1);
+    len += sizeof(json) - 1;
+
+    const char *expected[] = {json};
+    expect_frames(__func__, input, len, false, 256, expected, 1);
+}
+
+static void test_binary_oversized(void)
+{
+    // a length that cannot fit in the ring is no frame, the scan goes on after the prefix
+    static const char input[] = "\r\xb1\xff\xff\xff\x0f\r{\"a\":1}\n";
+    const char *expected[] = {"\r{\"a\":1}\n"};
+    expect_frames(__func__, input, sizeof(input) - 1, true, 256, expected, 1);
+
+    // a frame that exactly fills the ring is taken; with one byte more the length is refused at
+    // once, without waiting for the ring to run full
+    static const char json[] = "\r{\"b\":2}\n";
+    char body[64];
+    char stream[128];
+    memset(body, 'x', sizeof(body));
+    char storage[64];
+    sscma_client_framer_t framer;
+    for (size_t extra = 0; extra <= 1; extra++)
+    {
+        size_t len = binary_frame(stream, body, sizeof(storage) - SSCMA_CLIENT_BINARY_HEADER_LEN + extra);
+        memcpy(stream + len, json, sizeof(json) - 1);
+        len += sizeof(json) - 1;
+
+        frames_t out;
+        frames_init(&out, sizeof(stream));
+        sscma_client_framer_init(&framer, storage, sizeof(storage));
+        sscma_client_framer_set_binary(&framer, true);
+        feed(&framer, stream, len, 16, false, &out);
+        bool ok = !out.overflowed && out.count == 2 - extra && out.flen[out.count - 1] == sizeof(json) - 1;
+        ok = ok && (extra || (out.flen[0] == sizeof(storage) && memcmp(frames_at(&out, 0), stream, sizeof(storage)) == 0));
+        frames_free(&out);
+        CHECK(ok, "binary frame %zu bytes over the ring: %zu frames%s", extra, out.count, out.overflowed ? ", ring ran full" : "");
+    }
+}
+
+static size_t random_json(char *dst, size_t max_body)
+{
+    // no '\r' and no newline inside, so neither a prefix nor a suffix can appear
+    static const char alphabet[] = "abcdefghijklmnopqrstuvwxyz0123456789\":,[]{} ";
+    size_t len = 0;
+    dst[len++] = '\r';
+    dst[len++] = '{';
+    size_t body = (size_t)rand() % (max_body + 1);
+    for (size_t i = 0; i < body; i++)
+    {
+        dst[len++] = alphabet[rand() % (sizeof(alphabet) - 1)];
+    }
+    dst[len++] = '}';
+    dst[len++] = '\n';
+    return len;
+}
+
+// Random streams of frames, garbage and padding must give back exactly the frames put in
+static void fuzz_streams(int iterations)
+{
+    for (int it = 0; it < iterations; it++)
+    {
+        bool binary = rand() % 2;
+        size_t max_body = 1 + (size_t)rand() % 300;
+        // a padded JSON frame needs room for its NULs in binary mode
+        size_t ring = max_body + max_body / 4 + 64 + SSCMA_CLIENT_BINARY_HEADER_LEN + (size_t)rand() % 512;
+        size_t cap = 64 * (2 * max_body + 64);
+        char *input = malloc(cap);
+        size_t len = 0;
+        frames_t expected;
+        frames_init(&expected, cap);
+
+        int items = 1 + rand() % 48;
+        for (int k = 0; k < items; k++)
+        {
+            int kind = rand() % 4;
+            if (kind == 0)
+            {
+                // a JSON frame, split by read padding now and then
+                char frame[512];
+                size_t n = random_json(frame, max_body);
+                frames_add(&expected, frame, n);
+                for (size_t i = 0; i < n; i++)
+                {
+                    if (rand() % 64 == 0)
+                    {
+                        size_t pad = 1 + (size_t)rand() % 8;
+                        memset(input + len, 0, pad);
+                        len += pad;
+                    }
+                    input[len++] = frame[i];
+                }
+            }
+            else if (kind == 1 && binary)
+            {
+                char body[512];
+                size_t body_len = (size_t)rand() % (max_body + 1);
+                for (size_t i = 0; i < body_len; i++)
+                {
+                    body[i] = (char)rand();
+                }
+                size_t n = binary_frame(input + len, body, body_len);
+                frames_add(&expected, input + len, n);
+                len += n;
+            }
+            else if (kind == 2)
+            {
+                // logs and stray bytes between frames, '\r' excluded so no prefix can form
+                static const char noise[] = "abc }\n{\n:\"\xb1\xff";
+                size_t n = (size_t)rand() % 40;
+                for (size_t i = 0; i < n; i++)
+                {
+                    input[len++] = noise[rand() % (sizeof(noise) - 1)];
+                }
+            }
+            else
+            {
+                // read padding between frames, never inside a binary body where it is data
+                size_t n = (size_t)rand() % 24;
+                memset(input + len, 0, n);
+                len += n;
+            }
+        }
+
+        char *storage = malloc(ring);
+        sscma_client_framer_t framer;
+        frames_t out;
+        frames_init(&out, cap);
+        sscma_client_framer_init(&framer, storage, ring);
+        sscma_client_framer_set_binary(&framer, binary);
+        feed(&framer, input, len, 1 + (size_t)rand() % (2 * ring), true, &out);
+
+        bool ok = frames_equal(&out, &expected);
+        if (!ok)
+        {
+            printf("%s: iteration %d (%s, %zu byte ring, %zu bytes): %zu frames, expected %zu, first difference at frame %zu\n", __func__, it, binary ? "binary" : "json", ring, len, out.count,
+                expected.count, first_difference(&out, &expected));
+            failures++;
+        }
+        frames_free(&out);
+        frames_free(&expected);
+        free(storage);
+        free(input);
+        if (!ok)
+        {
+            return;
+        }
+    }
+}
+
+// Random bytes, rich in the framing characters: whatever comes out must be a well formed frame
+static void fuzz_bytes(int iterations)
+{
+    static const char bytes[] = "\r\r{{}}\n\n\0\xb1 a\"";
+    for (int it = 0; it < iterations; it++)
+    {
+        bool binary = rand() % 2;
+        size_t ring = 8 + (size_t)rand() % 256;
+        size_t len = (size_t)rand() % 4096;
+        char *input = malloc(len + 1);
+        for (size_t i = 0; i < len; i++)
+        {
+            input[i] = rand() % 4 ? bytes[rand() % (sizeof(bytes) - 1)] : (char)rand();
+        }
+
+        char *storage = malloc(ring);
+        sscma_client_framer_t framer;
+        frames_t out;
+        frames_init(&out, len + 1);
+        sscma_client_framer_init(&framer, storage, ring);
+        sscma_client_framer_set_binary(&framer, binary);
+        feed(&framer, input, len, 1 + (size_t)rand() % (2 * ring), true, &out);
+
+        for (size_t i = 0; i < out.count; i++)
+        {
+            const char *f = frames_at(&out, i);
+            size_t n = out.flen[i];
+            bool ok;
+            if (binary && sscma_client_binary_is_frame(f, n))
+            {
+                uint32_t body = (uint8_t)f[2] | (uint32_t)(uint8_t)f[3] << 8 | (uint32_t)(uint8_t)f[4] << 16 | (uint32_t)(uint8_t)f[5] << 24;
+                ok = n == SSCMA_CLIENT_BINARY_HEADER_LEN + body;
+            }
+            else
+            {
+                ok = n >= 4 && f[0] == '\r' && f[1] == '{' && f[n - 2] == '}' && f[n - 1] == '\n' && memchr(f, '\0', n) == NULL;
+            }
+            if (!ok)
+            {
+                printf("%s: iteration %d (%s, %zu byte ring): frame %zu of %zu bytes is malformed\n", __func__, it, binary ? "binary" : "json", ring, i, n);
+                failures++;
+                it = iterations;
+                break;
+            }
+        }
+        frames_free(&out);
+        free(storage);
+        free(input);
+    }
+}
+
+static char *load_capture(const char *path, size_t *len)
+{
+    FILE *f = fopen(path, "rb");
+    if (f == NULL)
+    {
+        return NULL;
+    }
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    char *data = malloc(size > 0 ? size : 1);
+    *len = fread(data, 1, size, f);
+    fclose(f);
+    return data;
+}
+
+// The frames of a whole capture in one plain pass: NULs dropped, a frame runs from the last "\r{"
+// to the next "}\n". With binary frames, a "\r" SSCMA_CLIENT_BINARY_MAGIC in the raw bytes is a
+// frame of the length in its header, taken as is, and a JSON frame it interrupts is dropped.
+static void scan_capture(const char *input, size_t len, bool binary, frames_t *out)
+{
+    char *text = malloc(len + 1);
+    size_t n = 0;
+    bool in_frame = false;
+    size_t start = 0;
+
+    for (size_t i = 0; i < len; i++)
+    {
+        if (binary && i + SSCMA_CLIENT_BINARY_HEADER_LEN <= len && sscma_client_binary_is_frame(input + i, SSCMA_CLIENT_BINARY_HEADER_LEN))
+        {
+            size_t body = (uint8_t)input[i + 2] | (size_t)(uint8_t)input[i + 3] << 8 | (size_t)(uint8_t)input[i + 4] << 16 | (size_t)(uint8_t)input[i + 5] << 24;
+            if (body <= len - i - SSCMA_CLIENT_BINARY_HEADER_LEN)
+            {
+                frames_add(out, input + i, SSCMA_CLIENT_BINARY_HEADER_LEN + body);
+                i += SSCMA_CLIENT_BINARY_HEADER_LEN + body - 1;
+                in_frame = false;
+                n = 0;
+                continue;
+            }
+        }
+        if (input[i] == '\0')
+        {
+            continue;
+        }
+        text[n++] = input[i];
+        if (n < 2)
+        {
+            continue;
+        }
+        if (text[n - 2] == '\r' && text[n - 1] == '{')
+        {
+            in_frame = true;
+            start = n - 2;
+        }
+        else if (in_frame && text[n - 2] == '}' && text[n - 1] == '\n')
+        {
+            frames_add(out, text + start, n - start);
+            in_frame = false;
+            n = 0; // the '\n' cannot start anything
+        }
+    }
+    free(text);
+}
+
+static void replay(const char *path, long expect, bool binary)
+{
+    size_t len = 0;
+    char *input = load_capture(path, &len);
+    if (input == NULL)
+    {
+        printf("cannot read %s\n", path);
+        failures++;
+        return;
+    }
+
+    frames_t expected;
+    frames_init(&expected, len);
+    scan_capture(input, len, binary, &expected);
+    size_t largest = 0;
+    for (size_t i = 0; i < expected.count; i++)
+    {
+        largest = expected.flen[i] > largest ? expected.flen[i] : largest;
+    }
+    printf("%s: %zu bytes, %zu frames, largest %zu bytes\n", path, len, expected.count, largest);
+    if (expect >= 0 && expected.count != (size_t)expect)
+    {
+        printf("%s: %zu frames, expected %ld\n", path, expected.count, expect);
+        failures++;
+    }
+
+    // from a ring that just holds the largest frame to the firmware default, in reads from single
+    // bytes to more than the ring
+    const size_t rings[] = {largest, largest + 1, 2 * largest + 7, 32 * 1024};
+    const size_t chunks[] = {1, 3, 64, 509, 4095, 65536};
+    for (size_t r = 0; r < sizeof(rings) / sizeof(rings[0]) && failures == 0; r++)
+    {
+        char *storage = malloc(rings[r]);
+        for (size_t c = 0; c < sizeof(chunks) / sizeof(chunks[0]); c++)
+        {
+            sscma_client_framer_t framer;
+            frames_t out;
+            frames_init(&out, len);
+            sscma_client_framer_init(&framer, storage, rings[r]);
+            sscma_client_framer_set_binary(&framer, binary);
+            feed(&framer, input, len, chunks[c], false, &out);
+            if (!frames_equal(&out, &expected))
+            {
+                printf("%s: %zu byte ring, %zu byte reads: %zu frames, first difference at frame %zu\n", path, rings[r], chunks[c], out.count, first_difference(&out, &expected));
+                failures++;
+            }
+            frames_free(&out);
+        }
+        free(storage);
+    }
+
+    frames_free(&expected);
+    free(input);
+}
+
+static void usage(const char *argv0)
+{
+    fprintf(stderr,
+        "usage: %s [options]\n"
+        "  --iterations N     fuzz iterations of each kind (default 2000)\n"
+        "  --seed N           fuzz seed (default 1)\n"
+        "  --replay FILE      only replay a capture of the raw bytes read from the device\n"
+        "  --expect N         frames the capture must hold\n"
+        "  --binary           the capture holds binary frames, replay in binary mode\n",
+        argv0);
+}
+
+int main(int argc, char **argv)
+{
+    int iterations = 2000;
+    unsigned seed = 1;
+    const char *capture = NULL;
+    long expect = -1;
+    bool binary = false;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const char *arg = argv[i];
+        if (strcmp(arg, "--binary") == 0)
+        {
+            binary = true;
+            continue;
+        }
+        const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+        if (value == NULL)
+        {
+            usage(argv[0]);
+            return 2;
+        }
+        if (strcmp(arg, "--iterations") == 0)
+        {
+            iterations = atoi(value);
+        }
+        else if (strcmp(arg, "--seed") == 0)
+        {
+            seed = strtoul(value, NULL, 10);
+        }
+        else if (strcmp(arg, "--replay") == 0)
+        {
+            capture = value;
+        }
+        else if (strcmp(arg, "--expect") == 0)
+        {
+            expect = atol(value);
+        }
+        else
+        {
+            usage(argv[0]);
+            return 2;
+        }
+        i++;
+    }
+
+    if (capture != NULL)
+    {
+        replay(capture, expect, binary);
+    }
+    else
+    {
+        srand(seed);
+        test_single();
+        test_garbage();
+        test_cut_short();
+        test_nul_padding();
+        test_wrap();
+        test_full();
+        test_binary();
+        test_binary_padding();
+        test_binary_off();
+        test_binary_oversized();
+        fuzz_streams(iterations);
+        fuzz_bytes(iterations);
+    }
+
+    printf("%s\n", failures ? "FAILED" : "OK");
+    return failures ? 1 : 0;
+}
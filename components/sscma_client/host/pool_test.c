@@ -0,0 +1,328 @@
+// Tests of the reply pool of the SSCMA client.
+//
+//   classes    replies go to the smallest class that fits, to the next one when it is used up and
+//              to the heap after that; blocks come back on release and the counters follow
+//   refs       a retained buffer goes back to the pool with its last release only, and counts as in
+//              use until then
+//   bitmap     classes of more than 32 blocks hand out every block once, across the words of the
+//              bitmap, and take them back in any order
+//   config     a pool without classes takes everything from the heap, a class too large to index
+//              is refused
+//   threads    several threads allocate, retain and release at once; every block is held by one
+//              buffer at a time, and the pool is empty again at the end
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sscma_client_pool.h"
+
+#define THREADS    8
+#define ITERATIONS 200000
+#define MAILBOXES  4
+
+static int failures = 0;
+
+#define CHECK(cond, ...)                                                                                                                                                                               \
+    do                                                                                                                                                                                                 \
+    {                                                                                                                                                                                                  \
+        if (!(cond))                                                                                                                                                                                   \
+        {                                                                                                                                                                                              \
+            printf("%s:%d: ", __func__, __LINE__);                                                                                                                                                     \
+            printf(__VA_ARGS__);                                                                                                                                                                       \
+            printf("\n");                                                                                                                                                                              \
+            failures++;                                                                                                                                                                                \
+            return;                                                                                                                                                                                    \
+        }                                                                                                                                                                                              \
+    } while (0)
+
+// Whether data lies in one of the blocks of the class
+static bool in_class(const sscma_client_pool_class_t *class, const char *data)
+{
+    return class->storage != NULL && data > class->storage && data < class->storage + class->stride * class->count;
+}
+
+static void test_classes(void)
+{
+    const sscma_client_pool_config_t config = {
+        .slab_size = 64,
+        .slabs = 2,
+        .large_size = 1000,
+        .large_blocks = 2,
+    };
+    sscma_client_pool_t pool;
+    sscma_client_pool_stats_t stats;
+    char *data[6];
+
+    CHECK(sscma_client_pool_init(&pool, &config), "init failed");
+
+    // slabs first, then large blocks for small replies too, then the heap
+    for (int i = 0; i < 4; i++)
+    {
+        data[i] = sscma_client_pool_alloc(&pool, 10);
+        CHECK(data[i] != NULL, "alloc %d failed", i);
+        memset(data[i], 'a' + i, 10);
+    }
+    CHECK(in_class(&pool.slabs, data[0]) && in_class(&pool.slabs, data[1]), "small replies not in slabs");
+    CHECK(in_class(&pool.large, data[2]) && in_class(&pool.large, data[3]), "small replies past the slabs not in large blocks");
+    data[4] = sscma_client_pool_alloc(&pool, 10);
+    CHECK(data[4] != NULL && !in_class(&pool.slabs, data[4]) && !in_class(&pool.large, data[4]), "small reply with both classes used up not from the heap");
+    // too large for any class
+    data[5] = sscma_client_pool_alloc(&pool, 1001);
+    CHECK(data[5] != NULL && !in_class(&pool.large, data[5]), "oversized reply not from the heap");
+    memset(data[5], 'z', 1001);
+
+    sscma_client_pool_get_stats(&pool, &stats);
+    CHECK(stats.allocs == 6 && stats.heap_fallbacks == 2, "%u allocs, %u from the heap, expected 6 and 2", stats.allocs, stats.heap_fallbacks);
+    CHECK(stats.slabs_in_use == 2 && stats.large_in_use == 2 && stats.heap_in_use == 2, "in use: %u slabs, %u large, %u heap", stats.slabs_in_use, stats.large_in_use, stats.heap_in_use);
+    CHECK(sscma_client_pool_in_use(&pool) == 6, "%u buffers in use, expected 6", sscma_client_pool_in_use(&pool));
+    for (int i = 0; i < 4; i++)
+    {
+        CHECK(data[i][0] == 'a' + i && data[i][9] == 'a' + i, "buffer %d overwritten", i);
+    }
+
+    // a released slab is taken again before any large block
+    CHECK(sscma_client_pool_release(data[1]), "single reference not the last");
+    char *again = sscma_client_pool_alloc(&pool, 64);
+    CHECK(again == data[1], "released slab not reused");
+    // a large reply never takes a slab
+    CHECK(sscma_client_pool_release(data[3]), "single reference not the last");
+    char *image = sscma_client_pool_alloc(&pool, 1000);
+    CHECK(image == data[3], "released large block not reused");
+
+    for (int i = 0; i < 6; i++)
+    {
+        if (i != 1 && i != 3)
+        {
+            sscma_client_pool_release(data[i]);
+        }
+    }
+    sscma_client_pool_release(again);
+    sscma_client_pool_release(image);
+
+    sscma_client_pool_get_stats(&pool, &stats);
+    CHECK(stats.slabs_in_use == 0 && stats.large_in_use == 0 && stats.heap_in_use == 0, "still in use: %u slabs, %u large, %u heap", stats.slabs_in_use, stats.large_in_use, stats.heap_in_use);
+    CHECK(stats.slabs_high_water == 2 && stats.large_high_water == 2 && stats.heap_high_water == 2, "high water: %u slabs, %u large, %u heap", stats.slabs_high_water,
+        stats.large_high_water, stats.heap_high_water);
+    CHECK(stats.allocs == 8 && stats.heap_fallbacks == 2, "%u allocs, %u from the heap, expected 8 and 2", stats.allocs, stats.heap_fallbacks);
+    CHECK(sscma_client_pool_in_use(&pool) == 0, "%u buffers in use after the last release", sscma_client_pool_in_use(&pool));
+    sscma_client_pool_deinit(&pool);
+}
+
+static void test_refs(void)
+{
+    const sscma_client_pool_config_t config = {
+        .slab_size = 64,
+        .slabs = 1,
+    };
+    sscma_client_pool_t pool;
+    sscma_client_pool_stats_t stats;
+
+    CHECK(sscma_client_pool_init(&pool, &config), "init failed");
+    for (int kind = 0; kind < 2; kind++)
+    {
+        // a slab, then a heap buffer
+        char *data = sscma_client_pool_alloc(&pool, kind ? 100 : 10);
+        CHECK(data != NULL, "alloc failed");
+        CHECK(sscma_client_pool_retain(data) == data, "retain changed the buffer");
+        sscma_client_pool_retain(data);
+        CHECK(!sscma_client_pool_release(data) && !sscma_client_pool_release(data), "released with references left");
+        sscma_client_pool_get_stats(&pool, &stats);
+        CHECK(stats.slabs_in_use + stats.heap_in_use == 1 && sscma_client_pool_in_use(&pool) == 1, "buffer %d given back with a reference left", kind);
+        CHECK(sscma_client_pool_release(data), "last reference not the last");
+        sscma_client_pool_get_stats(&pool, &stats);
+        CHECK(stats.slabs_in_use + stats.heap_in_use == 0, "buffer %d not given back", kind);
+    }
+    sscma_client_pool_deinit(&pool);
+}
+
+static void test_bitmap(void)
+{
+    enum
+    {
+        COUNT = 70,
+    };
+    const sscma_client_pool_config_t config = {
+        .slab_size = 16,
+        .slabs = COUNT,
+    };
+    sscma_client_pool_t pool;
+    sscma_client_pool_stats_t stats;
+    char *data[COUNT];
+
+    CHECK(sscma_client_pool_init(&pool, &config), "init failed");
+    for (int round = 0; round < 3; round++)
+    {
+        for (int i = 0; i < COUNT; i++)
+        {
+            data[i] = sscma_client_pool_alloc(&pool, 16);
+            CHECK(in_class(&pool.slabs, data[i]), "round %d: block %d not a slab", round, i);
+            for (int k = 0; k < i; k++)
+            {
+                CHECK(data[k] != data[i], "round %d: block %d handed out twice", round, i);
+            }
+        }
+        char *extra = sscma_client_pool_alloc(&pool, 16);
+        CHECK(extra != NULL && !in_class(&pool.slabs, extra), "round %d: alloc past the last slab not from the heap", round);
+        sscma_client_pool_release(extra);
+
+        // give them back in a different order each round, across the words of the bitmap
+        for (int i = 0; i < COUNT; i++)
+        {
+            int k = round == 0 ? i : round == 1 ? COUNT - 1 - i : (i * 37) % COUNT;
+            CHECK(sscma_client_pool_release(data[k]), "round %d: block %d not released", round, k);
+        }
+        sscma_client_pool_get_stats(&pool, &stats);
+        CHECK(stats.slabs_in_use == 0, "round %d: %u slabs still in use", round, stats.slabs_in_use);
+    }
+    CHECK(stats.slabs_high_water == COUNT, "high water %u, expected %d", stats.slabs_high_water, COUNT);
+    sscma_client_pool_deinit(&pool);
+}
+
+static void test_config(void)
+{
+    const sscma_client_pool_config_t none = { 0 };
+    const sscma_client_pool_config_t too_many = {
+        .slab_size = 8,
+        .slabs = UINT16_MAX + 1,
+    };
+    sscma_client_pool_t pool;
+    sscma_client_pool_stats_t stats;
+
+    CHECK(sscma_client_pool_init(&pool, &none), "init without classes failed");
+    char *data = sscma_client_pool_alloc(&pool, 1);
+    CHECK(data != NULL, "alloc failed");
+    sscma_client_pool_get_stats(&pool, &stats);
+    CHECK(stats.heap_fallbacks == 1 && stats.heap_in_use == 1, "%u from the heap, %u in use, expected 1 and 1", stats.heap_fallbacks, stats.heap_in_use);
+    sscma_client_pool_release(data);
+    sscma_client_pool_deinit(&pool);
+
+    CHECK(!sscma_client_pool_init(&pool, &too_many), "class of %d blocks accepted", too_many.slabs);
+    CHECK(pool.slabs.storage == NULL && pool.large.storage == NULL, "refused pool not left empty");
+}
+
+typedef struct
+{
+    sscma_client_pool_t *pool;
+    char **mailboxes; // Shared by the workers
+    unsigned seed;
+    int clashes;
+} worker_t;
+
+// Each buffer is stamped with its owner and a counter when it is taken, so a block handed out to
+// two holders at once shows as a stamp changed under its owner. Half of them get a second
+// reference left in a mailbox, where another worker releases it while the owner may be releasing
+// its own, as with a reply retained by on_event and passed on to another task.
+static void *worker(void *arg)
+{
+    worker_t *w = (worker_t *)arg;
+    char *held[4] = { 0 };
+    uint32_t stamps[4] = { 0 };
+    uint32_t stamp = 0;
+
+    for (int it = 0; it < ITERATIONS; it++)
+    {
+        int i = rand_r(&w->seed) % 4;
+        if (held[i] == NULL)
+        {
+            size_t len = rand_r(&w->seed) % 3 == 0 ? 900 : sizeof(w) + sizeof(stamp) + rand_r(&w->seed) % 50;
+            held[i] = sscma_client_pool_alloc(w->pool, len);
+            if (held[i] == NULL)
+            {
+                w->clashes++;
+                continue;
+            }
+            stamps[i] = ++stamp;
+            memcpy(held[i], &w, sizeof(w));
+            memcpy(held[i] + sizeof(w), &stamp, sizeof(stamp));
+            if (rand_r(&w->seed) % 2)
+            {
+                char *old = __atomic_exchange_n(&w->mailboxes[rand_r(&w->seed) % MAILBOXES], sscma_client_pool_retain(held[i]), __ATOMIC_ACQ_REL);
+                if (old != NULL)
+                {
+                    sscma_client_pool_release(old);
+                }
+            }
+        }
+        else
+        {
+            worker_t *owner = NULL;
+            uint32_t seen = 0;
+            memcpy(&owner, held[i], sizeof(owner));
+            memcpy(&seen, held[i] + sizeof(w), sizeof(seen));
+            if (owner != w || seen != stamps[i])
+            {
+                w->clashes++;
+            }
+            sscma_client_pool_release(held[i]);
+            held[i] = NULL;
+        }
+    }
+    for (int i = 0; i < 4; i++)
+    {
+        if (held[i] != NULL)
+        {
+            sscma_client_pool_release(held[i]);
+        }
+    }
+    return NULL;
+}
+
+static void test_threads(void)
+{
+    // fewer blocks than the threads can hold, fewer large ones than one thread can, so the classes
+    // run out and fall back all the time
+    const sscma_client_pool_config_t config = {
+        .slab_size = 64,
+        .slabs = 12,
+        .large_size = 1024,
+        .large_blocks = 3,
+    };
+    sscma_client_pool_t pool;
+    sscma_client_pool_stats_t stats;
+    pthread_t threads[THREADS];
+    worker_t workers[THREADS];
+    char *mailboxes[MAILBOXES] = { 0 };
+
+    CHECK(sscma_client_pool_init(&pool, &config), "init failed");
+    for (int t = 0; t < THREADS; t++)
+    {
+        workers[t] = (worker_t) { .pool = &pool, .mailboxes = mailboxes, .seed = 1 + t };
+        pthread_create(&threads[t], NULL, worker, &workers[t]);
+    }
+    int clashes = 0;
+    for (int t = 0; t < THREADS; t++)
+    {
+        pthread_join(threads[t], NULL);
+        clashes += workers[t].clashes;
+    }
+    for (int i = 0; i < MAILBOXES; i++)
+    {
+        if (mailboxes[i] != NULL)
+        {
+            sscma_client_pool_release(mailboxes[i]);
+        }
+    }
+
+    sscma_client_pool_get_stats(&pool, &stats);
+    CHECK(clashes == 0, "%d buffers held twice or failed", clashes);
+    CHECK(stats.slabs_in_use == 0 && stats.large_in_use == 0 && stats.heap_in_use == 0, "still in use: %u slabs, %u large, %u heap", stats.slabs_in_use, stats.large_in_use, stats.heap_in_use);
+    CHECK(stats.slabs_high_water <= 12 && stats.large_high_water == 3 && stats.heap_fallbacks > 0, "high water %u slabs, %u large, %u from the heap", stats.slabs_high_water,
+        stats.large_high_water, stats.heap_fallbacks);
+    CHECK(pool.slabs.used[0] == 0 && pool.large.used[0] == 0, "bitmap not clear: %08x %08x", pool.slabs.used[0], pool.large.used[0]);
+    sscma_client_pool_deinit(&pool);
+}
+
+int main(void)
+{
+    test_classes();
+    test_refs();
+    test_bitmap();
+    test_config();
+    test_threads();
+
+    printf("%s\n", failures ? "FAILED" : "OK");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+
+/* The emulator has no reset or SYNC lines, every GPIO call succeeds and does nothing */
+
+typedef int gpio_num_t;
+
+typedef enum
+{
+    GPIO_MODE_DISABLE,
+    GPIO_MODE_INPUT,
+    GPIO_MODE_OUTPUT,
+} gpio_mode_t;
+
+typedef enum
+{
+    GPIO_INTR_DISABLE,
+    GPIO_INTR_POSEDGE,
+} gpio_int_type_t;
+
+typedef struct
+{
+    uint64_t pin_bit_mask;
+    gpio_mode_t mode;
+    int pull_up_en;
+    int pull_down_en;
+    gpio_int_type_t intr_type;
+} gpio_config_t;
+
+static inline esp_err_t gpio_config(const gpio_config_t *config)
+{
+    (void)config;
+    return ESP_OK;
+}
+
+static inline esp_err_t gpio_set_level(int gpio, uint32_t level)
+{
+    (void)gpio;
+    (void)level;
+    return ESP_OK;
+}
+
+static inline esp_err_t gpio_reset_pin(int gpio)
+{
+    (void)gpio;
+    return ESP_OK;
+}
+
+static inline int gpio_get_level(int gpio)
+{
+    (void)gpio;
+    return 0;
+}
+
+static inline esp_err_t gpio_set_intr_type(int gpio, gpio_int_type_t intr_type)
+{
+    (void)gpio;
+    (void)intr_type;
+    return ESP_OK;
+}
+
+typedef void (*gpio_isr_t)(void *arg);
+
+static inline esp_err_t gpio_install_isr_service(int intr_alloc_flags)
+{
+    (void)intr_alloc_flags;
+    return ESP_OK;
+}
+
+static inline esp_err_t gpio_isr_handler_add(int gpio, gpio_isr_t isr_handler, void *args)
+{
+    (void)gpio;
+    (void)isr_handler;
+    (void)args;
+    return ESP_OK;
+}
+
+static inline esp_err_t gpio_isr_handler_remove(int gpio)
+{
+    (void)gpio;
+    return ESP_OK;
+}
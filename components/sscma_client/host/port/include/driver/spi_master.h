@@ -0,0 +1,45 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+
+/* The SPI master calls of the SPI transport, served by the emulated bus of host/sscma_spi_bus.c */
+
+typedef intptr_t spi_host_device_t;
+typedef struct spi_device_t *spi_device_handle_t;
+
+#define SPI_DEVICE_TXBIT_LSBFIRST (1 << 0)
+#define SPI_DEVICE_3WIRE          (1 << 2)
+#define SPI_DEVICE_POSITIVE_CS    (1 << 3)
+
+#define SPI_TRANS_CS_KEEP_ACTIVE (1 << 8)
+
+typedef struct
+{
+    uint32_t flags;
+    int clock_speed_hz;
+    uint8_t mode;
+    int spics_io_num;
+    int queue_size;
+} spi_device_interface_config_t;
+
+typedef struct
+{
+    uint32_t flags;
+    size_t length;   /* bits */
+    size_t rxlength; /* bits */
+    void *user;
+    const void *tx_buffer;
+    void *rx_buffer;
+} spi_transaction_t;
+
+esp_err_t spi_bus_get_max_transaction_len(spi_host_device_t host, size_t *max_bytes);
+esp_err_t spi_bus_add_device(spi_host_device_t host, const spi_device_interface_config_t *config, spi_device_handle_t *handle);
+esp_err_t spi_bus_remove_device(spi_device_handle_t handle);
+esp_err_t spi_bus_free(spi_host_device_t host);
+esp_err_t spi_device_acquire_bus(spi_device_handle_t device, TickType_t wait);
+void spi_device_release_bus(spi_device_handle_t device);
+esp_err_t spi_device_queue_trans(spi_device_handle_t handle, spi_transaction_t *trans, TickType_t ticks);
+esp_err_t spi_device_get_trans_result(spi_device_handle_t handle, spi_transaction_t **trans, TickType_t ticks);
@@ -0,0 +1,3 @@
+#pragma once
+
+#define ESP_STATIC_ASSERT _Static_assert
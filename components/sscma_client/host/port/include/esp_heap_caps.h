@@ -0,0 +1,13 @@
+#pragma once
+
+#include <stdlib.h>
+
+#define MALLOC_CAP_8BIT     (1 << 2)
+#define MALLOC_CAP_DMA      (1 << 3)
+#define MALLOC_CAP_SPIRAM   (1 << 10)
+#define MALLOC_CAP_INTERNAL (1 << 11)
+
+#define heap_caps_malloc(size, caps)           ((void)(caps), malloc(size))
+#define heap_caps_calloc(n, size, caps)        ((void)(caps), calloc(n, size))
+#define heap_caps_realloc(ptr, size, caps)     ((void)(caps), realloc(ptr, size))
+#define heap_caps_free(ptr)                    free(ptr)
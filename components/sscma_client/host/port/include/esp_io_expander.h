@@ -0,0 +1,36 @@
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+
+typedef struct esp_io_expander_s *esp_io_expander_handle_t;
+
+typedef enum
+{
+    IO_EXPANDER_INPUT,
+    IO_EXPANDER_OUTPUT,
+} esp_io_expander_dir_t;
+
+static inline esp_err_t esp_io_expander_set_dir(esp_io_expander_handle_t handle, uint32_t pin_num_mask, esp_io_expander_dir_t direction)
+{
+    (void)handle;
+    (void)pin_num_mask;
+    (void)direction;
+    return ESP_OK;
+}
+
+static inline esp_err_t esp_io_expander_set_level(esp_io_expander_handle_t handle, uint32_t pin_num_mask, uint8_t level)
+{
+    (void)handle;
+    (void)pin_num_mask;
+    (void)level;
+    return ESP_OK;
+}
+
+static inline esp_err_t esp_io_expander_get_level(esp_io_expander_handle_t handle, uint32_t pin_num_mask, uint32_t *level_mask)
+{
+    (void)handle;
+    (void)pin_num_mask;
+    *level_mask = 0;
+    return ESP_OK;
+}
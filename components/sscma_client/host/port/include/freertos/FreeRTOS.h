@@ -0,0 +1,66 @@
+#pragma once
+
+/*
+ * Host port of the FreeRTOS and ESP-IDF APIs sscma_client and the task flow engine of the
+ * factory firmware use, backed by pthreads. Ticks are milliseconds. Task suspension is
+ * cooperative: a suspended task stops at its next delay or notification wait, which is where the
+ * process task spends its idle time.
+ */
+
+#include <assert.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_heap_caps.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef uint32_t TickType_t;
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+typedef uint8_t StackType_t;
+typedef void (*TaskFunction_t)(void *);
+
+typedef struct
+{
+    int dummy;
+} StaticTask_t;
+
+typedef struct
+{
+    int dummy;
+} StaticQueue_t;
+
+typedef StaticQueue_t StaticSemaphore_t;
+
+#define pdTRUE  ((BaseType_t)1)
+#define pdFALSE ((BaseType_t)0)
+#define pdPASS  pdTRUE
+#define pdFAIL  pdFALSE
+
+#define portMAX_DELAY        ((TickType_t)0xffffffffUL)
+#define portTICK_PERIOD_MS   ((TickType_t)1)
+#define configTICK_RATE_HZ   1000
+#define configMAX_PRIORITIES 25
+#define pdMS_TO_TICKS(ms)    ((TickType_t)(ms))
+#define portYIELD_FROM_ISR(...)
+
+/* newlib provides these, glibc does not */
+#ifndef __containerof
+#define __containerof(ptr, type, member) ((type *)((char *)(ptr)-offsetof(type, member)))
+#endif
+
+char *strnstr(const char *haystack, const char *needle, size_t len);
+
+BaseType_t xPortInIsrContext(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,23 @@
+#pragma once
+
+#include "freertos/queue.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef QueueHandle_t SemaphoreHandle_t;
+
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t max, UBaseType_t initial);
+
+#define xSemaphoreCreateMutex()                           xSemaphoreCreateCounting(1, 1)
+#define xSemaphoreCreateBinary()                          xSemaphoreCreateCounting(1, 0)
+#define xSemaphoreCreateBinaryStatic(buffer)              ((void)(buffer), xSemaphoreCreateCounting(1, 0))
+#define xSemaphoreCreateCountingStatic(max, init, buffer) ((void)(buffer), xSemaphoreCreateCounting(max, init))
+#define xSemaphoreTake(sem, ticks)                        xQueueReceive(sem, NULL, ticks)
+#define xSemaphoreGive(sem)                               xQueueSend(sem, NULL, 0)
+#define vSemaphoreDelete(sem)                             vQueueDelete(sem)
+
+#ifdef __cplusplus
+}
+#endif
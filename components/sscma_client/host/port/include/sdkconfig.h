@@ -0,0 +1,3 @@
+#pragma once
+
+/* Host builds set CONFIG_ options as compile definitions */
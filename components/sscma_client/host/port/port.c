@@ -0,0 +1,647 @@
+#include <errno.h>
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/event_groups.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "mbedtls/base64.h"
+
+struct host_task
+{
+    pthread_t thread;
+    TaskFunction_t fn;
+    void *arg;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    uint32_t notify;
+    bool suspended;
+    bool parked;
+};
+
+struct host_queue
+{
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    size_t item_size;
+    size_t capacity;
+    size_t count;
+    size_t head;
+    uint8_t *items;
+};
+
+struct host_event_group
+{
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    EventBits_t bits;
+};
+
+static __thread struct host_task *current_task;
+
+// Stands for a thread the port did not create, main() among them, once it asks for its handle
+static __thread struct host_task thread_task;
+
+static esp_log_level_t log_level = ESP_LOG_WARN;
+
+static void cond_init(pthread_cond_t *cond)
+{
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(cond, &attr);
+    pthread_condattr_destroy(&attr);
+}
+
+static void deadline_after(struct timespec *deadline, TickType_t ticks)
+{
+    clock_gettime(CLOCK_MONOTONIC, deadline);
+    deadline->tv_sec += ticks / 1000;
+    deadline->tv_nsec += (long)(ticks % 1000) * 1000000L;
+    if (deadline->tv_nsec >= 1000000000L)
+    {
+        deadline->tv_sec++;
+        deadline->tv_nsec -= 1000000000L;
+    }
+}
+
+// Wait on cond until signalled or the deadline, forever with portMAX_DELAY. Returns false on timeout.
+static void cond_wait_cancelled(void *lock)
+{
+    pthread_mutex_unlock((pthread_mutex_t *)lock);
+}
+
+// A task deleted while it waits here leaves the queue or semaphore usable, as on FreeRTOS
+static bool cond_wait(pthread_cond_t *cond, pthread_mutex_t *lock, TickType_t ticks, const struct timespec *deadline)
+{
+    // volatile: pthread_cleanup_push may expand to setjmp
+    volatile bool woken = true;
+
+    pthread_cleanup_push(cond_wait_cancelled, lock);
+    if (ticks == portMAX_DELAY)
+    {
+        pthread_cond_wait(cond, lock);
+    }
+    else
+    {
+        woken = pthread_cond_timedwait(cond, lock, deadline) != ETIMEDOUT;
+    }
+    pthread_cleanup_pop(0);
+    return woken;
+}
+
+// Stop here while the task is suspended, the task lock is held
+static void task_park(struct host_task *task)
+{
+    while (task->suspended)
+    {
+        task->parked = true;
+        pthread_cond_broadcast(&task->cond);
+        pthread_cond_wait(&task->cond, &task->lock);
+    }
+    task->parked = false;
+}
+
+static void *task_entry(void *arg)
+{
+    struct host_task *task = (struct host_task *)arg;
+    current_task = task;
+    task->fn(task->arg);
+    return NULL;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *name, uint32_t stack, void *arg, UBaseType_t priority, TaskHandle_t *ret_task)
+{
+    (void)name;
+    (void)stack;
+    (void)priority;
+
+    struct host_task *task = (struct host_task *)calloc(1, sizeof(struct host_task));
+    if (task == NULL)
+    {
+        return pdFAIL;
+    }
+    task->fn = fn;
+    task->arg = arg;
+    pthread_mutex_init(&task->lock, NULL);
+    cond_init(&task->cond);
+    if (pthread_create(&task->thread, NULL, task_entry, task) != 0)
+    {
+        free(task);
+        return pdFAIL;
+    }
+    if (ret_task)
+    {
+        *ret_task = task;
+    }
+    return pdPASS;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char *name, uint32_t stack, void *arg, UBaseType_t priority, TaskHandle_t *ret_task, BaseType_t core)
+{
+    (void)core;
+    return xTaskCreate(fn, name, stack, arg, priority, ret_task);
+}
+
+TaskHandle_t xTaskCreateStatic(TaskFunction_t fn, const char *name, uint32_t stack, void *arg, UBaseType_t priority, StackType_t *stack_buffer, StaticTask_t *task_buffer)
+{
+    TaskHandle_t task = NULL;
+    (void)stack_buffer;
+    (void)task_buffer;
+    xTaskCreate(fn, name, stack, arg, priority, &task);
+    return task;
+}
+
+TaskHandle_t xTaskCreateStaticPinnedToCore(TaskFunction_t fn, const char *name, uint32_t stack, void *arg, UBaseType_t priority, StackType_t *stack_buffer, StaticTask_t *task_buffer,
+    BaseType_t core)
+{
+    (void)core;
+    return xTaskCreateStatic(fn, name, stack, arg, priority, stack_buffer, task_buffer);
+}
+
+void vTaskDelete(TaskHandle_t task)
+{
+    if (task == NULL || task == current_task)
+    {
+        pthread_detach(pthread_self());
+        pthread_exit(NULL);
+    }
+    // the task stops at its next blocking call, queues and semaphores it waits on are let go
+    pthread_cancel(task->thread);
+    pthread_join(task->thread, NULL);
+    pthread_mutex_destroy(&task->lock);
+    pthread_cond_destroy(&task->cond);
+    free(task);
+}
+
+void vTaskSuspend(TaskHandle_t task)
+{
+    if (task == NULL || task == current_task)
+    {
+        return; // tasks here never suspend themselves
+    }
+    pthread_mutex_lock(&task->lock);
+    task->suspended = true;
+    pthread_cond_broadcast(&task->cond);
+    while (task->suspended && !task->parked)
+    {
+        pthread_cond_wait(&task->cond, &task->lock);
+    }
+    pthread_mutex_unlock(&task->lock);
+}
+
+void vTaskResume(TaskHandle_t task)
+{
+    if (task == NULL)
+    {
+        return;
+    }
+    pthread_mutex_lock(&task->lock);
+    task->suspended = false;
+    pthread_cond_broadcast(&task->cond);
+    pthread_mutex_unlock(&task->lock);
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    struct host_task *task = current_task;
+    struct timespec deadline;
+
+    deadline_after(&deadline, ticks);
+    if (task == NULL)
+    {
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, NULL);
+        return;
+    }
+
+    pthread_mutex_lock(&task->lock);
+    task_park(task);
+    while (cond_wait(&task->cond, &task->lock, ticks, &deadline))
+    {
+        task_park(task);
+    }
+    task_park(task);
+    pthread_mutex_unlock(&task->lock);
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+    return (TickType_t)(esp_timer_get_time() / 1000);
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t ticks)
+{
+    struct host_task *task = current_task;
+    struct timespec deadline;
+    uint32_t value = 0;
+
+    if (task == NULL)
+    {
+        return 0;
+    }
+    deadline_after(&deadline, ticks);
+
+    pthread_mutex_lock(&task->lock);
+    task_park(task);
+    while (task->notify == 0 && ticks != 0 && cond_wait(&task->cond, &task->lock, ticks, &deadline))
+    {
+        task_park(task);
+    }
+    task_park(task);
+    value = task->notify;
+    if (value)
+    {
+        task->notify = clear ? 0 : value - 1;
+    }
+    pthread_mutex_unlock(&task->lock);
+    return value;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task)
+{
+    pthread_mutex_lock(&task->lock);
+    task->notify++;
+    pthread_cond_broadcast(&task->cond);
+    pthread_mutex_unlock(&task->lock);
+    return pdPASS;
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t *woken)
+{
+    xTaskNotifyGive(task);
+    if (woken)
+    {
+        *woken = pdFALSE;
+    }
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+    if (current_task == NULL)
+    {
+        thread_task.thread = pthread_self();
+        pthread_mutex_init(&thread_task.lock, NULL);
+        cond_init(&thread_task.cond);
+        current_task = &thread_task;
+    }
+    return current_task;
+}
+
+BaseType_t xPortInIsrContext(void)
+{
+    return pdFALSE;
+}
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size)
+{
+    struct host_queue *queue = (struct host_queue *)calloc(1, sizeof(struct host_queue));
+    if (queue == NULL)
+    {
+        return NULL;
+    }
+    queue->item_size = item_size;
+    queue->capacity = length;
+    if (item_size)
+    {
+        queue->items = (uint8_t *)calloc(length, item_size);
+        if (queue->items == NULL)
+        {
+            free(queue);
+            return NULL;
+        }
+    }
+    pthread_mutex_init(&queue->lock, NULL);
+    cond_init(&queue->cond);
+    return queue;
+}
+
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t max, UBaseType_t initial)
+{
+    struct host_queue *queue = xQueueCreate(max, 0);
+    if (queue)
+    {
+        queue->count = initial;
+    }
+    return queue;
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t ticks)
+{
+    struct timespec deadline;
+    BaseType_t ret = pdFALSE;
+
+    deadline_after(&deadline, ticks);
+    pthread_mutex_lock(&queue->lock);
+    while (queue->count == queue->capacity && ticks != 0 && cond_wait(&queue->cond, &queue->lock, ticks, &deadline))
+    {
+    }
+    if (queue->count < queue->capacity)
+    {
+        if (queue->item_size)
+        {
+            memcpy(queue->items + ((queue->head + queue->count) % queue->capacity) * queue->item_size, item, queue->item_size);
+        }
+        queue->count++;
+        pthread_cond_broadcast(&queue->cond);
+        ret = pdTRUE;
+    }
+    pthread_mutex_unlock(&queue->lock);
+    return ret;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t ticks)
+{
+    struct timespec deadline;
+    BaseType_t ret = pdFALSE;
+
+    deadline_after(&deadline, ticks);
+    pthread_mutex_lock(&queue->lock);
+    while (queue->count == 0 && ticks != 0 && cond_wait(&queue->cond, &queue->lock, ticks, &deadline))
+    {
+    }
+    if (queue->count > 0)
+    {
+        if (queue->item_size)
+        {
+            memcpy(item, queue->items + queue->head * queue->item_size, queue->item_size);
+        }
+        queue->head = (queue->head + 1) % queue->capacity;
+        queue->count--;
+        pthread_cond_broadcast(&queue->cond);
+        ret = pdTRUE;
+    }
+    pthread_mutex_unlock(&queue->lock);
+    return ret;
+}
+
+BaseType_t xQueueReset(QueueHandle_t queue)
+{
+    pthread_mutex_lock(&queue->lock);
+    queue->head = 0;
+    queue->count = 0;
+    pthread_cond_broadcast(&queue->cond);
+    pthread_mutex_unlock(&queue->lock);
+    return pdPASS;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue)
+{
+    pthread_mutex_lock(&queue->lock);
+    UBaseType_t count = queue->count;
+    pthread_mutex_unlock(&queue->lock);
+    return count;
+}
+
+void vQueueDelete(QueueHandle_t queue)
+{
+    if (queue == NULL)
+    {
+        return;
+    }
+    pthread_mutex_destroy(&queue->lock);
+    pthread_cond_destroy(&queue->cond);
+    free(queue->items);
+    free(queue);
+}
+
+EventGroupHandle_t xEventGroupCreate(void)
+{
+    struct host_event_group *group = (struct host_event_group *)calloc(1, sizeof(struct host_event_group));
+    if (group == NULL)
+    {
+        return NULL;
+    }
+    pthread_mutex_init(&group->lock, NULL);
+    cond_init(&group->cond);
+    return group;
+}
+
+void vEventGroupDelete(EventGroupHandle_t group)
+{
+    if (group == NULL)
+    {
+        return;
+    }
+    pthread_mutex_destroy(&group->lock);
+    pthread_cond_destroy(&group->cond);
+    free(group);
+}
+
+EventBits_t xEventGroupSetBits(EventGroupHandle_t group, EventBits_t bits)
+{
+    pthread_mutex_lock(&group->lock);
+    group->bits |= bits;
+    EventBits_t value = group->bits;
+    pthread_cond_broadcast(&group->cond);
+    pthread_mutex_unlock(&group->lock);
+    return value;
+}
+
+EventBits_t xEventGroupClearBits(EventGroupHandle_t group, EventBits_t bits)
+{
+    pthread_mutex_lock(&group->lock);
+    EventBits_t value = group->bits;
+    group->bits &= ~bits;
+    pthread_mutex_unlock(&group->lock);
+    return value;
+}
+
+// Returns the bits when the wait ended, those waited for are cleared with clear only if the wait was met
+EventBits_t xEventGroupWaitBits(EventGroupHandle_t group, EventBits_t bits, BaseType_t clear, BaseType_t all, TickType_t ticks)
+{
+    struct timespec deadline;
+    EventBits_t value = 0;
+    bool met = false;
+    bool waiting = ticks != 0;
+
+    deadline_after(&deadline, ticks);
+    pthread_mutex_lock(&group->lock);
+    while (1)
+    {
+        value = group->bits;
+        met = all ? (value & bits) == bits : (value & bits) != 0;
+        if (met || !waiting)
+        {
+            break;
+        }
+        waiting = cond_wait(&group->cond, &group->lock, ticks, &deadline);
+    }
+    if (met && clear)
+    {
+        group->bits &= ~bits;
+    }
+    pthread_mutex_unlock(&group->lock);
+    return value;
+}
+
+int64_t esp_timer_get_time(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (int64_t)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
+
+void esp_log_level_set(const char *tag, esp_log_level_t level)
+{
+    // one level for every tag, "*" or not
+    (void)tag;
+    log_level = level;
+}
+
+void esp_log_write(esp_log_level_t level, const char *tag, const char *format, ...)
+{
+    static const char letters[] = "NEWIDV";
+    va_list args;
+
+    if (level > log_level)
+    {
+        return;
+    }
+    fprintf(stderr, "%c (%lld) %s: ", letters[level], (long long)(esp_timer_get_time() / 1000), tag);
+    va_start(args, format);
+    vfprintf(stderr, format, args);
+    va_end(args);
+    fputc('\n', stderr);
+}
+
+char *strnstr(const char *haystack, const char *needle, size_t len)
+{
+    size_t needle_len = strlen(needle);
+
+    if (needle_len == 0)
+    {
+        return (char *)haystack;
+    }
+    for (size_t i = 0; i + needle_len <= len && haystack[i]; i++)
+    {
+        if (haystack[i] == needle[0] && strncmp(haystack + i, needle, needle_len) == 0)
+        {
+            return (char *)haystack + i;
+        }
+    }
+    return NULL;
+}
+
+static const char base64_alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+int mbedtls_base64_encode(unsigned char *dst, size_t dlen, size_t *olen, const unsigned char *src, size_t slen)
+{
+    size_t need = (slen + 2) / 3 * 4 + 1;
+    size_t n = 0;
+
+    if (dst == NULL || dlen < need)
+    {
+        *olen = need;
+        return MBEDTLS_ERR_BASE64_BUFFER_TOO_SMALL;
+    }
+    for (size_t i = 0; i < slen; i += 3)
+    {
+        uint32_t v = (uint32_t)src[i] << 16;
+        if (i + 1 < slen)
+        {
+            v |= (uint32_t)src[i + 1] << 8;
+        }
+        if (i + 2 < slen)
+        {
+            v |= src[i + 2];
+        }
+        dst[n++] = base64_alphabet[(v >> 18) & 0x3F];
+        dst[n++] = base64_alphabet[(v >> 12) & 0x3F];
+        dst[n++] = i + 1 < slen ? base64_alphabet[(v >> 6) & 0x3F] : '=';
+        dst[n++] = i + 2 < slen ? base64_alphabet[v & 0x3F] : '=';
+    }
+    dst[n] = '\0';
+    *olen = n;
+    return 0;
+}
+
+static int base64_value(unsigned char c)
+{
+    if (c >= 'A' && c <= 'Z')
+    {
+        return c - 'A';
+    }
+    if (c >= 'a' && c <= 'z')
+    {
+        return c - 'a' + 26;
+    }
+    if (c >= '0' && c <= '9')
+    {
+        return c - '0' + 52;
+    }
+    if (c == '+')
+    {
+        return 62;
+    }
+    if (c == '/')
+    {
+        return 63;
+    }
+    return -1;
+}
+
+int mbedtls_base64_decode(unsigned char *dst, size_t dlen, size_t *olen, const unsigned char *src, size_t slen)
+{
+    size_t digits = 0;
+    size_t pad = 0;
+
+    for (size_t i = 0; i < slen; i++)
+    {
+        if (src[i] == '=')
+        {
+            pad++;
+        }
+        else if (pad || base64_value(src[i]) < 0)
+        {
+            return MBEDTLS_ERR_BASE64_INVALID_CHARACTER;
+        }
+        else
+        {
+            digits++;
+        }
+    }
+    if ((digits + pad) % 4 != 0 || pad > 2)
+    {
+        return MBEDTLS_ERR_BASE64_INVALID_CHARACTER;
+    }
+
+    size_t need = digits * 3 / 4;
+    if (dst == NULL || dlen < need)
+    {
+        *olen = need;
+        return MBEDTLS_ERR_BASE64_BUFFER_TOO_SMALL;
+    }
+
+    uint32_t v = 0;
+    size_t n = 0;
+    for (size_t i = 0; i < digits; i++)
+    {
+        v = (v << 6) | (uint32_t)base64_value(src[i]);
+        if (i % 4 == 3)
+        {
+            dst[n++] = v >> 16;
+            dst[n++] = v >> 8;
+            dst[n++] = v;
+            v = 0;
+        }
+    }
+    if (digits % 4 == 3)
+    {
+        dst[n++] = v >> 10;
+        dst[n++] = v >> 2;
+    }
+    else if (digits % 4 == 2)
+    {
+        dst[n++] = v >> 4;
+    }
+    *olen = n;
+    return 0;
+}
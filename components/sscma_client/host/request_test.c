@@ -0,0 +1,497 @@
+// Tests of the request table of the SSCMA client, on the pthread port of FreeRTOS.
+//
+// Most cases play the device by hand on the other end of the socketpair, so replies can be sent
+// out of order, late or not at all:
+//   tags      a command sent while the same one is in flight goes out as AT+<tag>@CMD and each
+//             reply, answered in reverse order, reaches the request it names; a reply with a known
+//             tag but another command completes nothing
+//   late      a reply to a blocking request that already timed out is dropped: a tagged one does
+//             not complete the untagged request still in flight, an untagged one is not handed to
+//             the next request of the same command
+//   deadline  an asynchronous request without reply has its callback run once with
+//             ESP_ERR_TIMEOUT, no sooner than its timeout and within one wake of the process task
+//             after it, a reply after that is dropped, and the slots of expired requests are free
+//   retained  a reply retained in a request callback and released by another task while
+//             sscma_client_del waits lets the client go; one still held makes it return
+//             ESP_ERR_INVALID_STATE and stays readable and releasable afterwards
+// The emulator case runs against sscma_emulator with every slot taken by two commands, and every
+// request must be completed once, by a reply to its own command.
+#include <poll.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+#include "cJSON.h"
+
+#include "sscma_client_commands.h"
+#include "sscma_client_io.h"
+#include "sscma_client_ops.h"
+#include "sscma_client_io_loopback.h"
+#include "sscma_emulator.h"
+
+#define CMD_ID   CMD_PREFIX CMD_AT_ID CMD_QUERY CMD_SUFFIX
+#define CMD_NAME CMD_PREFIX CMD_AT_NAME CMD_QUERY CMD_SUFFIX
+
+// The process task wakes at least every SSCMA_CLIENT_NOTIFY_TIMEOUT_MS to expire requests
+#define EXPIRE_SLACK_MS 300
+#define SETTLE_MS       100
+
+typedef struct
+{
+    SemaphoreHandle_t done;
+    int calls;
+    esp_err_t err;
+    bool replied;
+    char name[32];
+    char data[64];
+    int64_t done_us;
+} result_t;
+
+typedef struct
+{
+    result_t result;
+    sscma_client_reply_t reply;
+    int release_ms;
+} held_t;
+
+typedef struct
+{
+    int fds[2];
+    sscma_client_io_handle_t io;
+    sscma_client_handle_t client;
+    sscma_emulator_handle_t emulator;
+} setup_t;
+
+static int failures = 0;
+
+#define CHECK(cond, ...)                                                                                                                                                                               \
+    do                                                                                                                                                                                                 \
+    {                                                                                                                                                                                                  \
+        if (!(cond))                                                                                                                                                                                   \
+        {                                                                                                                                                                                              \
+            printf("%s:%d: ", __func__, __LINE__);                                                                                                                                                     \
+            printf(__VA_ARGS__);                                                                                                                                                                       \
+            printf("\n");                                                                                                                                                                              \
+            failures++;                                                                                                                                                                                \
+            return;                                                                                                                                                                                    \
+        }                                                                                                                                                                                              \
+    } while (0)
+
+static bool setup_open(setup_t *setup, const sscma_emulator_config_t *emulator)
+{
+    sscma_client_config_t config = SSCMA_CLIENT_CONFIG_DEFAULT();
+
+    memset(setup, 0, sizeof(*setup));
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, setup->fds) != 0)
+    {
+        perror("socketpair");
+        return false;
+    }
+    if ((emulator != NULL && sscma_emulator_start(emulator, setup->fds[1], &setup->emulator) != ESP_OK) || sscma_client_new_io_loopback(setup->fds[0], &setup->io) != ESP_OK
+        || sscma_client_new(setup->io, &config, &setup->client) != ESP_OK || sscma_client_init(setup->client) != ESP_OK)
+    {
+        fprintf(stderr, "cannot set up the client\n");
+        return false;
+    }
+    return true;
+}
+
+static void setup_close(setup_t *setup)
+{
+    sscma_client_del(setup->client);
+    sscma_client_del_io(setup->io);
+    if (setup->emulator != NULL)
+    {
+        sscma_emulator_stop(setup->emulator);
+    }
+    close(setup->fds[0]);
+    close(setup->fds[1]);
+}
+
+static void result_init(result_t *result)
+{
+    memset(result, 0, sizeof(*result));
+    result->done = xSemaphoreCreateCounting(16, 0);
+}
+
+static void result_free(result_t *result)
+{
+    vSemaphoreDelete(result->done);
+}
+
+static bool result_wait(result_t *result, int timeout_ms)
+{
+    return xSemaphoreTake(result->done, pdMS_TO_TICKS(timeout_ms)) == pdTRUE;
+}
+
+static void copy_string(char *dst, size_t size, const cJSON *item)
+{
+    snprintf(dst, size, "%s", cJSON_IsString(item) ? item->valuestring : "");
+}
+
+static void on_request(sscma_client_handle_t client, esp_err_t err, const sscma_client_reply_t *reply, void *user_ctx)
+{
+    result_t *result = (result_t *)user_ctx;
+    (void)client;
+
+    result->calls++;
+    result->err = err;
+    result->replied = reply != NULL;
+    if (reply != NULL)
+    {
+        copy_string(result->name, sizeof(result->name), cJSON_GetObjectItem(reply->payload, "name"));
+        copy_string(result->data, sizeof(result->data), cJSON_GetObjectItem(reply->payload, "data"));
+    }
+    result->done_us = esp_timer_get_time();
+    xSemaphoreGive(result->done);
+}
+
+// Keep a reference to the reply past the callback
+static void on_request_retain(sscma_client_handle_t client, esp_err_t err, const sscma_client_reply_t *reply, void *user_ctx)
+{
+    held_t *held = (held_t *)user_ctx;
+
+    if (reply != NULL)
+    {
+        sscma_client_reply_retain(reply, &held->reply);
+    }
+    on_request(client, err, reply, &held->result);
+}
+
+static void release_task(void *arg)
+{
+    held_t *held = (held_t *)arg;
+
+    vTaskDelay(pdMS_TO_TICKS(held->release_ms));
+    sscma_client_reply_clear(&held->reply);
+    vTaskDelete(NULL);
+}
+
+// Read the next command the client wrote, without its suffix
+static bool device_read(int fd, char *line, size_t size, int timeout_ms)
+{
+    struct pollfd pfd = {
+        .fd = fd,
+        .events = POLLIN,
+    };
+    size_t len = 0;
+
+    while (len + 1 < size)
+    {
+        char c;
+        if (poll(&pfd, 1, timeout_ms) <= 0 || recv(fd, &c, 1, 0) != 1)
+        {
+            return false;
+        }
+        if (c == '\n')
+        {
+            break;
+        }
+        if (c != '\r')
+        {
+            line[len++] = c;
+        }
+    }
+    line[len] = '\0';
+    return true;
+}
+
+// Read a command and return its tag, 0 if it went out untagged, -1 if it is not cmd
+static int device_read_tag(int fd, const char *cmd)
+{
+    char line[64];
+    const char *p = line + CMD_PREFIX_LEN;
+    int tag = 0;
+
+    if (!device_read(fd, line, sizeof(line), 1000) || strncmp(line, CMD_PREFIX, CMD_PREFIX_LEN) != 0)
+    {
+        return -1;
+    }
+    const char *at = strchr(p, '@');
+    if (at != NULL)
+    {
+        tag = atoi(p);
+        p = at + 1;
+    }
+    return strcmp(p, cmd) == 0 ? tag : -1;
+}
+
+static void device_send(int fd, int type, const char *name, int tag, const char *data)
+{
+    char buf[256];
+    char tagged[64];
+    int len;
+
+    if (tag > 0)
+    {
+        snprintf(tagged, sizeof(tagged), "%d@%s", tag, name);
+    }
+    else
+    {
+        snprintf(tagged, sizeof(tagged), "%s", name);
+    }
+    len = snprintf(buf, sizeof(buf), RESPONSE_PREFIX "\"type\":%d,\"name\":\"%s\",\"code\":0,\"data\":\"%s\"" RESPONSE_SUFFIX, type, tagged, data);
+    if (send(fd, buf, len, MSG_NOSIGNAL) != len)
+    {
+        perror("send");
+    }
+}
+
+static void device_reply(int fd, const char *name, int tag, const char *data)
+{
+    device_send(fd, CMD_TYPE_RESPONSE, name, tag, data);
+}
+
+// Wait for result while the device logs every interval_ms, each log wakes the process task
+static bool result_wait_logging(result_t *result, int fd, int timeout_ms, int interval_ms)
+{
+    for (int waited = 0; waited < timeout_ms; waited += interval_ms)
+    {
+        device_send(fd, CMD_TYPE_LOG, "AT", 0, "tick");
+        if (result_wait(result, interval_ms))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void test_tags(setup_t *setup)
+{
+    static const char *const data[] = { "first", "second", "third" };
+    result_t results[3];
+    int tags[3];
+    int fd = setup->fds[1];
+
+    for (int i = 0; i < 3; i++)
+    {
+        result_init(&results[i]);
+    }
+    for (int i = 0; i < 3; i++)
+    {
+        CHECK(sscma_client_request_async(setup->client, CMD_ID, on_request, &results[i], pdMS_TO_TICKS(2000)) == ESP_OK, "request %d not sent", i);
+    }
+    for (int i = 0; i < 3; i++)
+    {
+        tags[i] = device_read_tag(fd, CMD_AT_ID CMD_QUERY);
+        CHECK(tags[i] >= 0, "command %d missing", i);
+    }
+    CHECK(tags[0] == 0 && tags[1] > 0 && tags[2] > 0 && tags[1] != tags[2], "tags %d %d %d, the first untagged and the others distinct", tags[0], tags[1], tags[2]);
+
+    // a known tag on another command, then the replies in reverse order
+    device_reply(fd, CMD_AT_NAME CMD_QUERY, tags[1], "wrong");
+    for (int i = 2; i >= 0; i--)
+    {
+        device_reply(fd, CMD_AT_ID CMD_QUERY, tags[i], data[i]);
+    }
+    for (int i = 0; i < 3; i++)
+    {
+        CHECK(result_wait(&results[i], 1000), "request %d not completed", i);
+        CHECK(results[i].err == ESP_OK && strcmp(results[i].data, data[i]) == 0, "request %d got \"%s\" (%d), expected \"%s\"", i, results[i].data, results[i].err, data[i]);
+    }
+    vTaskDelay(pdMS_TO_TICKS(SETTLE_MS));
+    for (int i = 0; i < 3; i++)
+    {
+        CHECK(results[i].calls == 1, "request %d completed %d times", i, results[i].calls);
+        result_free(&results[i]);
+    }
+}
+
+static void test_late(setup_t *setup)
+{
+    sscma_client_reply_t reply = { 0 };
+    result_t pending, fresh;
+    int fd = setup->fds[1];
+
+    result_init(&pending);
+    result_init(&fresh);
+
+    // a blocking request times out while the same command is in flight, so it is tagged
+    CHECK(sscma_client_request_async(setup->client, CMD_ID, on_request, &pending, pdMS_TO_TICKS(2000)) == ESP_OK, "request not sent");
+    CHECK(sscma_client_request(setup->client, CMD_ID, &reply, true, pdMS_TO_TICKS(50)) == ESP_ERR_TIMEOUT, "blocking request did not time out");
+    CHECK(device_read_tag(fd, CMD_AT_ID CMD_QUERY) == 0, "first command not untagged");
+    int tag = device_read_tag(fd, CMD_AT_ID CMD_QUERY);
+    CHECK(tag > 0, "second command not tagged");
+
+    device_reply(fd, CMD_AT_ID CMD_QUERY, tag, "late");
+    vTaskDelay(pdMS_TO_TICKS(SETTLE_MS));
+    CHECK(pending.calls == 0, "late tagged reply completed the untagged request with \"%s\"", pending.data);
+    device_reply(fd, CMD_AT_ID CMD_QUERY, 0, "pending");
+    CHECK(result_wait(&pending, 1000) && strcmp(pending.data, "pending") == 0, "in-flight request got \"%s\"", pending.data);
+
+    // an untagged late reply once nothing is in flight
+    CHECK(sscma_client_request(setup->client, CMD_ID, &reply, true, pdMS_TO_TICKS(50)) == ESP_ERR_TIMEOUT, "blocking request did not time out");
+    CHECK(device_read_tag(fd, CMD_AT_ID CMD_QUERY) == 0, "command not untagged");
+    device_reply(fd, CMD_AT_ID CMD_QUERY, 0, "late");
+    vTaskDelay(pdMS_TO_TICKS(SETTLE_MS));
+
+    CHECK(sscma_client_request_async(setup->client, CMD_ID, on_request, &fresh, pdMS_TO_TICKS(2000)) == ESP_OK, "request not sent");
+    CHECK(device_read_tag(fd, CMD_AT_ID CMD_QUERY) == 0, "command not untagged");
+    device_reply(fd, CMD_AT_ID CMD_QUERY, 0, "fresh");
+    CHECK(result_wait(&fresh, 1000), "request not completed");
+    CHECK(strcmp(fresh.data, "fresh") == 0, "request got \"%s\", the late reply was kept", fresh.data);
+    vTaskDelay(pdMS_TO_TICKS(SETTLE_MS));
+    CHECK(pending.calls == 1 && fresh.calls == 1, "requests completed %d and %d times", pending.calls, fresh.calls);
+
+    result_free(&pending);
+    result_free(&fresh);
+}
+
+static void test_deadline(setup_t *setup)
+{
+    result_t expired;
+    result_t results[SSCMA_CLIENT_REQUEST_SLOTS];
+    result_t spare;
+    int fd = setup->fds[1];
+    const int timeout_ms = 100;
+
+    result_init(&expired);
+    int64_t start = esp_timer_get_time();
+    CHECK(sscma_client_request_async(setup->client, CMD_ID, on_request, &expired, pdMS_TO_TICKS(timeout_ms)) == ESP_OK, "request not sent");
+    CHECK(device_read_tag(fd, CMD_AT_ID CMD_QUERY) == 0, "command not untagged");
+    CHECK(result_wait(&expired, timeout_ms + EXPIRE_SLACK_MS + 500), "request never expired");
+    int64_t elapsed_ms = (expired.done_us - start) / 1000;
+    CHECK(expired.err == ESP_ERR_TIMEOUT && !expired.replied, "expired with %d and %s reply", expired.err, expired.replied ? "a" : "no");
+    CHECK(elapsed_ms >= timeout_ms && elapsed_ms <= timeout_ms + EXPIRE_SLACK_MS, "expired after %lld ms, timeout %d ms", (long long)elapsed_ms, timeout_ms);
+
+    device_reply(fd, CMD_AT_ID CMD_QUERY, 0, "late");
+    vTaskDelay(pdMS_TO_TICKS(SETTLE_MS));
+    CHECK(expired.calls == 1, "expired request called back %d times", expired.calls);
+    result_free(&expired);
+
+    // with traffic waking the process task every 10 ms the deadline is kept to within a few wakes
+    result_init(&expired);
+    start = esp_timer_get_time();
+    CHECK(sscma_client_request_async(setup->client, CMD_ID, on_request, &expired, pdMS_TO_TICKS(timeout_ms)) == ESP_OK, "request not sent");
+    CHECK(device_read_tag(fd, CMD_AT_ID CMD_QUERY) == 0, "command not untagged");
+    CHECK(result_wait_logging(&expired, fd, timeout_ms + EXPIRE_SLACK_MS + 500, 10), "request never expired");
+    elapsed_ms = (expired.done_us - start) / 1000;
+    CHECK(expired.err == ESP_ERR_TIMEOUT && elapsed_ms >= timeout_ms && elapsed_ms <= timeout_ms + 50, "expired with %d after %lld ms, timeout %d ms", expired.err, (long long)elapsed_ms,
+        timeout_ms);
+    result_free(&expired);
+
+    // the expired slot is free again: every slot can be taken, one more cannot
+    for (int i = 0; i < SSCMA_CLIENT_REQUEST_SLOTS; i++)
+    {
+        result_init(&results[i]);
+        CHECK(sscma_client_request_async(setup->client, CMD_ID, on_request, &results[i], pdMS_TO_TICKS(timeout_ms)) == ESP_OK, "slot %d not free", i);
+    }
+    result_init(&spare);
+    CHECK(sscma_client_request_async(setup->client, CMD_ID, on_request, &spare, pdMS_TO_TICKS(timeout_ms)) == ESP_ERR_NO_MEM, "more requests than slots in flight");
+    for (int i = 0; i < SSCMA_CLIENT_REQUEST_SLOTS; i++)
+    {
+        CHECK(device_read_tag(fd, CMD_AT_ID CMD_QUERY) >= 0, "command %d missing", i);
+    }
+    for (int i = 0; i < SSCMA_CLIENT_REQUEST_SLOTS; i++)
+    {
+        CHECK(result_wait(&results[i], timeout_ms + EXPIRE_SLACK_MS + 500), "request %d never expired", i);
+        CHECK(results[i].err == ESP_ERR_TIMEOUT, "request %d expired with %d", i, results[i].err);
+    }
+    vTaskDelay(pdMS_TO_TICKS(SETTLE_MS));
+    for (int i = 0; i < SSCMA_CLIENT_REQUEST_SLOTS; i++)
+    {
+        CHECK(results[i].calls == 1, "request %d called back %d times", i, results[i].calls);
+        result_free(&results[i]);
+    }
+    CHECK(spare.calls == 0, "refused request called back");
+    result_free(&spare);
+}
+
+static void test_emulator(setup_t *setup)
+{
+    static const char *const cmds[] = { CMD_ID, CMD_NAME };
+    static const char *const names[] = { CMD_AT_ID CMD_QUERY, CMD_AT_NAME CMD_QUERY };
+    result_t results[SSCMA_CLIENT_REQUEST_SLOTS];
+
+    for (int round = 0; round < 50; round++)
+    {
+        for (int i = 0; i < SSCMA_CLIENT_REQUEST_SLOTS; i++)
+        {
+            result_init(&results[i]);
+            CHECK(sscma_client_request_async(setup->client, cmds[i % 2], on_request, &results[i], pdMS_TO_TICKS(2000)) == ESP_OK, "round %d: request %d not sent", round, i);
+        }
+        for (int i = 0; i < SSCMA_CLIENT_REQUEST_SLOTS; i++)
+        {
+            const char *at = NULL;
+            CHECK(result_wait(&results[i], 2000), "round %d: request %d not completed", round, i);
+            at = strchr(results[i].name, '@');
+            CHECK(results[i].err == ESP_OK && strcmp(at ? at + 1 : results[i].name, names[i % 2]) == 0, "round %d: request %d for %s answered by %s (%d)", round, i, names[i % 2],
+                results[i].name, results[i].err);
+        }
+        for (int i = 0; i < SSCMA_CLIENT_REQUEST_SLOTS; i++)
+        {
+            CHECK(results[i].calls == 1, "round %d: request %d completed %d times", round, i, results[i].calls);
+            result_free(&results[i]);
+        }
+    }
+}
+
+static void test_retained(void)
+{
+    for (int late = 0; late < 2; late++)
+    {
+        setup_t setup;
+        held_t held = { .release_ms = 100 };
+        int fd;
+
+        CHECK(setup_open(&setup, NULL), "cannot set up the client");
+        fd = setup.fds[1];
+        result_init(&held.result);
+        CHECK(sscma_client_request_async(setup.client, CMD_ID, on_request_retain, &held, pdMS_TO_TICKS(2000)) == ESP_OK, "request not sent");
+        CHECK(device_read_tag(fd, CMD_AT_ID CMD_QUERY) == 0, "command not untagged");
+        device_reply(fd, CMD_AT_ID CMD_QUERY, 0, "kept");
+        CHECK(result_wait(&held.result, 1000) && held.reply.data != NULL, "reply not retained");
+        vTaskDelay(pdMS_TO_TICKS(SETTLE_MS));
+
+        int64_t start = esp_timer_get_time();
+        if (!late)
+        {
+            CHECK(xTaskCreate(release_task, "release", 4096, &held, 5, NULL) == pdPASS, "cannot start the release task");
+            CHECK(sscma_client_del(setup.client) == ESP_OK, "delete failed with the reply released while waiting");
+            CHECK(held.reply.data == NULL && esp_timer_get_time() - start >= held.release_ms * 1000, "delete returned before the reply was released");
+        }
+        else
+        {
+            CHECK(sscma_client_del(setup.client) == ESP_ERR_INVALID_STATE, "delete succeeded with a reply still retained");
+            CHECK(strstr(held.reply.data, "kept") != NULL, "retained reply overwritten after delete: %.*s", (int)held.reply.len, held.reply.data);
+            sscma_client_reply_clear(&held.reply);
+        }
+        setup.client = NULL;
+        setup_close(&setup);
+        result_free(&held.result);
+    }
+}
+
+int main(void)
+{
+    setup_t setup;
+    sscma_emulator_config_t emulator = SSCMA_EMULATOR_CONFIG_DEFAULT();
+
+    if (!setup_open(&setup, NULL))
+    {
+        return 2;
+    }
+    test_tags(&setup);
+    test_late(&setup);
+    test_deadline(&setup);
+    setup_close(&setup);
+
+    if (!setup_open(&setup, &emulator))
+    {
+        return 2;
+    }
+    test_emulator(&setup);
+    setup_close(&setup);
+
+    test_retained();
+
+    printf("%s\n", failures ? "FAILED" : "OK");
+    return failures ? 1 : 0;
+}
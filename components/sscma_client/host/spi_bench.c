@@ -0,0 +1,195 @@
+// Throughput of the SPI transport against an emulated SPI bus.
+//
+// The transport is the one the firmware runs, sscma_client_io_spi.c on the pthread port of
+// FreeRTOS, with the SPI master calls served by sscma_spi_bus: queued transactions are clocked
+// one after the other at --clock-hz, each taking --overhead-us on top of its bits. The device
+// reports --available bytes at a time, and --size bytes are fetched the way the process task
+// does, AVAILABLE then READ of what is available, without a SYNC line. Every configuration of
+// examples/sscma_client_spi_bench gets a fresh IO, the data is checked against the byte counter
+// the device sends, and the rate is shown with the share of the time the bus was clocking.
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include "sscma_client_io.h"
+#include "sscma_client_io_interface.h"
+#include "sscma_spi_bus.h"
+
+#define SPI_BENCH_MAX_WRITE_LEN 250
+
+typedef struct
+{
+    size_t max_read_len;
+    size_t trans_queue_depth;
+    int wait_delay;
+} bench_config_t;
+
+static const bench_config_t bench_configs[] = {
+    { 1024, 1, 2 },
+    { 2048, 1, 2 },
+    { 4095, 1, 2 },
+    { 4095, 2, 2 },
+    { 4095, 2, 0 },
+    { 4095, 3, 0 },
+    { 8190, 2, 0 },
+    { 16380, 2, 0 },
+};
+
+typedef struct
+{
+    sscma_spi_bus_config_t bus;
+    int clock_hz;
+    size_t size;
+    int wait_delay;
+} options_t;
+
+static bool run_fetch(const bench_config_t *bench, const options_t *opt, uint8_t *data)
+{
+    const sscma_client_io_spi_config_t io_config = {
+        .cs_gpio_num = -1,
+        .sync_gpio_num = -1,
+        .pclk_hz = opt->clock_hz,
+        .spi_mode = 0,
+        .wait_delay = opt->wait_delay >= 0 ? opt->wait_delay : bench->wait_delay,
+        .trans_queue_depth = bench->trans_queue_depth,
+        .max_write_len = SPI_BENCH_MAX_WRITE_LEN,
+        .max_read_len = bench->max_read_len,
+    };
+    sscma_client_io_handle_t io = NULL;
+    sscma_spi_bus_stats_t stats;
+    esp_err_t ret = ESP_OK;
+    size_t fetched = 0;
+    size_t rounds = 0;
+
+    sscma_spi_bus_set_config(&opt->bus);
+    if (sscma_client_new_io_spi_bus(NULL, &io_config, &io) != ESP_OK)
+    {
+        fprintf(stderr, "cannot set up the SPI IO\n");
+        return false;
+    }
+
+    int64_t start = esp_timer_get_time();
+    while (fetched < opt->size && ret == ESP_OK)
+    {
+        size_t avail = 0;
+        ret = sscma_client_io_available(io, &avail);
+        if (ret == ESP_OK)
+        {
+            avail = avail > opt->size - fetched ? opt->size - fetched : avail;
+            ret = sscma_client_io_read(io, data + fetched, avail);
+            fetched += avail;
+            rounds++;
+        }
+    }
+    int64_t end = esp_timer_get_time();
+
+    sscma_spi_bus_get_stats((spi_device_handle_t)io->handle, &stats);
+    sscma_client_del_io(io);
+
+    bool match = ret == ESP_OK && stats.data_bytes == opt->size;
+    for (size_t i = 0; match && i < opt->size; i++)
+    {
+        match = data[i] == (uint8_t)i;
+    }
+
+    if (ret != ESP_OK)
+    {
+        printf("%5zu %5zu %4d  failed: 0x%x\n", bench->max_read_len, bench->trans_queue_depth, io_config.wait_delay, ret);
+    }
+    else
+    {
+        double seconds = (end - start) / 1e6;
+        printf("%5zu %5zu %4d  %7.1f kB/s  %7.1f ms  %4zu rounds  %5u transactions  %3.0f%% bus busy  %s\n", bench->max_read_len, bench->trans_queue_depth,
+            io_config.wait_delay, opt->size / 1000.0 / seconds, seconds * 1e3, rounds, stats.transactions, 100.0 * stats.busy_us / (end - start),
+            match ? "data OK" : "DATA MISMATCH");
+    }
+
+    return match;
+}
+
+static void usage(const char *argv0)
+{
+    fprintf(stderr,
+        "usage: %s [options]\n"
+        "  --size B           bytes fetched per configuration (default 40960)\n"
+        "  --available B      bytes the device reports at a time (default 16380)\n"
+        "  --clock-hz N       SPI clock (default 12000000, the SenseCAP Watcher's)\n"
+        "  --overhead-us N    bus time per transaction on top of its bits (default 20)\n"
+        "  --wait-delay MS    wait_delay of every configuration instead of the example's\n",
+        argv0);
+}
+
+int main(int argc, char **argv)
+{
+    options_t opt = {
+        .bus = SSCMA_SPI_BUS_CONFIG_DEFAULT(),
+        .clock_hz = 12000000,
+        .size = 40960,
+        .wait_delay = -1,
+    };
+
+    opt.bus.available = 16380;
+    for (int i = 1; i < argc; i++)
+    {
+        const char *arg = argv[i];
+        const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+        if (value == NULL)
+        {
+            usage(argv[0]);
+            return 1;
+        }
+        if (strcmp(arg, "--size") == 0)
+        {
+            opt.size = strtoul(value, NULL, 10);
+        }
+        else if (strcmp(arg, "--available") == 0)
+        {
+            opt.bus.available = (uint16_t)strtoul(value, NULL, 10);
+        }
+        else if (strcmp(arg, "--clock-hz") == 0)
+        {
+            opt.clock_hz = atoi(value);
+        }
+        else if (strcmp(arg, "--overhead-us") == 0)
+        {
+            opt.bus.overhead_us = atoi(value);
+        }
+        else if (strcmp(arg, "--wait-delay") == 0)
+        {
+            opt.wait_delay = atoi(value);
+        }
+        else
+        {
+            usage(argv[0]);
+            return 1;
+        }
+        i++;
+    }
+    if (opt.size == 0 || opt.bus.available == 0 || opt.bus.available == 0xFFFF || opt.clock_hz <= 0 || opt.bus.overhead_us < 0)
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    uint8_t *data = (uint8_t *)malloc(opt.size);
+    if (data == NULL)
+    {
+        fprintf(stderr, "no mem for data\n");
+        return 1;
+    }
+
+    printf("%zu B fetched %u B at a time at %d Hz, %d us per transaction\n", opt.size, opt.bus.available, opt.clock_hz, opt.bus.overhead_us);
+    printf(" read depth wait\n");
+    bool ok = true;
+    for (size_t i = 0; i < sizeof(bench_configs) / sizeof(bench_configs[0]); i++)
+    {
+        ok = run_fetch(&bench_configs[i], &opt, data) && ok;
+    }
+
+    free(data);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,382 @@
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+
+#include "esp_log.h"
+#include "esp_check.h"
+
+#include "sscma_bootloader.h"
+
+static const char *TAG = "sscma_bootloader";
+
+#define BOOTLOADER_ENTER_HINT "Send data using the xmodem protocol from your terminal"
+#define BOOTLOADER_DONE_HINT  "Do you want to end file transmission and reboot system?"
+
+#define BOOTLOADER_POLL_MS    100   // 'C' interval until the first block and stop check interval
+#define BOOTLOADER_BLOCK_MS   1000  // a block not complete by then is NAKed
+#define BOOTLOADER_ANSWER_MS  60000 // wait for "y" or "n" after EOT
+
+#define XSOH 0x01
+#define XSTX 0x02
+#define XEOT 0x04
+#define XACK 0x06
+#define XNAK 0x15
+#define XCAN 0x18
+#define XC   0x43
+
+#define CONFIG_LEN 12
+
+struct sscma_bootloader_t
+{
+    sscma_bootloader_config_t config;
+    int fd;                         // Device end of the socket
+    pthread_t thread;               // Runs the menu and the transfers
+    pthread_mutex_t lock;           // Guards the image and the counters
+    volatile bool running;          // Cleared on stop
+    uint32_t seed;                  // Picks the corrupted blocks
+    uint8_t *image;                 // Data of the last transfer
+    size_t len;                     // Bytes of it
+    size_t size;                    // Bytes allocated for it
+    size_t offset;                  // Set by the config transfer
+    sscma_bootloader_stats_t stats; // Counters
+};
+
+// Read len bytes unless timeout_ms passes without any, returns the bytes read or -1 once closed
+static int bootloader_recv(sscma_bootloader_handle_t bootloader, void *data, size_t len, int timeout_ms)
+{
+    struct pollfd pfd = { .fd = bootloader->fd, .events = POLLIN };
+    uint8_t *p = (uint8_t *)data;
+    size_t got = 0;
+
+    while (got < len && bootloader->running)
+    {
+        int n = poll(&pfd, 1, timeout_ms);
+        if (n < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (n <= 0)
+        {
+            break;
+        }
+        ssize_t r = recv(bootloader->fd, p + got, len - got, 0);
+        if (r < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (r <= 0)
+        {
+            return -1;
+        }
+        got += r;
+    }
+
+    return bootloader->running ? (int)got : -1;
+}
+
+static void bootloader_send(sscma_bootloader_handle_t bootloader, const void *data, size_t len)
+{
+    send(bootloader->fd, data, len, MSG_NOSIGNAL);
+}
+
+static void bootloader_send_byte(sscma_bootloader_handle_t bootloader, uint8_t c)
+{
+    bootloader_send(bootloader, &c, 1);
+}
+
+// The socket delivers at once, hold the answer for the time the block takes on the UART and to program
+static void bootloader_wire(sscma_bootloader_handle_t bootloader, size_t bytes)
+{
+    int64_t us = bootloader->config.turnaround_us;
+    if (bootloader->config.baud > 0)
+    {
+        us += (int64_t)bytes * 10 * 1000000 / bootloader->config.baud;
+    }
+    if (us > 0)
+    {
+        struct timespec ts = { .tv_sec = us / 1000000, .tv_nsec = (us % 1000000) * 1000 };
+        while (nanosleep(&ts, &ts) != 0 && errno == EINTR)
+        {
+        }
+    }
+}
+
+static uint16_t bootloader_crc(const uint8_t *data, size_t len)
+{
+    uint16_t crc = 0;
+
+    while (len--)
+    {
+        crc ^= (uint16_t)*data++ << 8;
+        for (int i = 0; i < 8; i++)
+        {
+            crc = crc & 0x8000 ? (crc << 1) ^ 0x1021 : crc << 1;
+        }
+    }
+
+    return crc;
+}
+
+static bool bootloader_corrupt(sscma_bootloader_handle_t bootloader)
+{
+    if (bootloader->config.error_rate <= 0)
+    {
+        return false;
+    }
+    // xorshift, the same blocks are hit on every run
+    bootloader->seed ^= bootloader->seed << 13;
+    bootloader->seed ^= bootloader->seed >> 17;
+    bootloader->seed ^= bootloader->seed << 5;
+    return bootloader->seed % bootloader->config.error_rate == 0;
+}
+
+static bool bootloader_append(sscma_bootloader_handle_t bootloader, const uint8_t *data, size_t len)
+{
+    bool ok = true;
+
+    pthread_mutex_lock(&bootloader->lock);
+    if (bootloader->len + len > bootloader->config.capacity)
+    {
+        ok = false;
+    }
+    else
+    {
+        if (bootloader->len + len > bootloader->size)
+        {
+            size_t size = bootloader->size ? bootloader->size * 2 : 64 * 1024;
+            while (size < bootloader->len + len)
+            {
+                size *= 2;
+            }
+            uint8_t *image = (uint8_t *)realloc(bootloader->image, size);
+            ok = image != NULL;
+            if (ok)
+            {
+                bootloader->image = image;
+                bootloader->size = size;
+            }
+        }
+        if (ok)
+        {
+            memcpy(bootloader->image + bootloader->len, data, len);
+            bootloader->len += len;
+        }
+    }
+    pthread_mutex_unlock(&bootloader->lock);
+
+    return ok;
+}
+
+// Take one block after its SOH or STX, and answer it
+static bool bootloader_block(sscma_bootloader_handle_t bootloader, uint8_t start, uint8_t *expected)
+{
+    uint8_t packet[2 + 1024 + 2];
+    size_t block = start == XSTX ? 1024 : 128;
+    size_t len = 2 + block + 2;
+
+    int got = bootloader_recv(bootloader, packet, len, BOOTLOADER_BLOCK_MS);
+    if (got < 0)
+    {
+        return false;
+    }
+    bootloader_wire(bootloader, 1 + got);
+
+    pthread_mutex_lock(&bootloader->lock);
+    bootloader->stats.bytes += 1 + got;
+    pthread_mutex_unlock(&bootloader->lock);
+
+    uint16_t crc = (uint16_t)packet[2 + block] << 8 | packet[3 + block];
+    bool refused = start == XSTX && !bootloader->config.xmodem_1k;
+    if (refused || (size_t)got != len || packet[0] + packet[1] != 0xFF || crc != bootloader_crc(packet + 2, block) || bootloader_corrupt(bootloader))
+    {
+        pthread_mutex_lock(&bootloader->lock);
+        bootloader->stats.naks++;
+        pthread_mutex_unlock(&bootloader->lock);
+        bootloader_send_byte(bootloader, XNAK);
+        return true;
+    }
+
+    if (packet[0] == (uint8_t)(*expected - 1))
+    {
+        pthread_mutex_lock(&bootloader->lock);
+        bootloader->stats.duplicates++;
+        pthread_mutex_unlock(&bootloader->lock);
+        bootloader_send_byte(bootloader, XACK);
+        return true;
+    }
+    if (packet[0] != *expected || !bootloader_append(bootloader, packet + 2, block))
+    {
+        ESP_LOGE(TAG, "block %u out of sequence or over capacity, cancelling", packet[0]);
+        bootloader_send_byte(bootloader, XCAN);
+        return false;
+    }
+    (*expected)++;
+
+    pthread_mutex_lock(&bootloader->lock);
+    bootloader->stats.blocks++;
+    bootloader->stats.blocks_1k += block == 1024;
+    pthread_mutex_unlock(&bootloader->lock);
+    bootloader_send_byte(bootloader, XACK);
+
+    return true;
+}
+
+// One xmodem transfer after the hint, returns whether another one follows
+static bool bootloader_transfer(sscma_bootloader_handle_t bootloader)
+{
+    uint8_t expected = 1;
+    bool started = false;
+    uint8_t c;
+
+    pthread_mutex_lock(&bootloader->lock);
+    bootloader->len = 0;
+    pthread_mutex_unlock(&bootloader->lock);
+
+    while (true)
+    {
+        int got = bootloader_recv(bootloader, &c, 1, started ? BOOTLOADER_BLOCK_MS : BOOTLOADER_POLL_MS);
+        if (got < 0)
+        {
+            return false;
+        }
+        if (got == 0)
+        {
+            if (!started)
+            {
+                bootloader_send_byte(bootloader, XC);
+            }
+            continue;
+        }
+
+        switch (c)
+        {
+            case XSOH:
+            case XSTX:
+                started = true;
+                if (!bootloader_block(bootloader, c, &expected))
+                {
+                    return false;
+                }
+                break;
+            case XEOT:
+                if (!started)
+                {
+                    break;
+                }
+                bootloader_send_byte(bootloader, XACK);
+                bootloader_send(bootloader, "\r\n" BOOTLOADER_DONE_HINT "\r\n", sizeof("\r\n" BOOTLOADER_DONE_HINT "\r\n") - 1);
+                // a second EOT may come before the answer
+                do
+                {
+                    if (bootloader_recv(bootloader, &c, 1, BOOTLOADER_ANSWER_MS) <= 0)
+                    {
+                        return false;
+                    }
+                }
+                while (c != 'y' && c != 'n');
+
+                pthread_mutex_lock(&bootloader->lock);
+                if (c == 'y')
+                {
+                    bootloader->stats.done = true;
+                }
+                else if (bootloader->len >= CONFIG_LEN && bootloader->image[0] == 0xC0 && bootloader->image[1] == 0x5A)
+                {
+                    const uint8_t *p = bootloader->image + 2;
+                    bootloader->offset = (size_t)p[0] | (size_t)p[1] << 8 | (size_t)p[2] << 16 | (size_t)p[3] << 24;
+                }
+                pthread_mutex_unlock(&bootloader->lock);
+                return c == 'n';
+            case XCAN:
+                return false;
+            default:
+                break; // "1" sent after the hint, or noise
+        }
+    }
+}
+
+static void *bootloader_thread(void *arg)
+{
+    sscma_bootloader_handle_t bootloader = (sscma_bootloader_handle_t)arg;
+    uint8_t c;
+    int got;
+
+    while ((got = bootloader_recv(bootloader, &c, 1, BOOTLOADER_POLL_MS)) >= 0)
+    {
+        // AT+RST and anything else but the menu entry is ignored
+        if (got == 1 && c == '1')
+        {
+            bootloader_send(bootloader, "\r\n" BOOTLOADER_ENTER_HINT "\r\n", sizeof("\r\n" BOOTLOADER_ENTER_HINT "\r\n") - 1);
+            while (bootloader_transfer(bootloader))
+            {
+            }
+        }
+    }
+
+    return NULL;
+}
+
+esp_err_t sscma_bootloader_start(const sscma_bootloader_config_t *config, int fd, sscma_bootloader_handle_t *ret_bootloader)
+{
+    sscma_bootloader_handle_t bootloader = NULL;
+    ESP_RETURN_ON_FALSE(config && fd >= 0 && ret_bootloader, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+
+    bootloader = (sscma_bootloader_handle_t)calloc(1, sizeof(struct sscma_bootloader_t));
+    ESP_RETURN_ON_FALSE(bootloader, ESP_ERR_NO_MEM, TAG, "no mem for bootloader");
+
+    bootloader->config = *config;
+    bootloader->fd = fd;
+    bootloader->seed = 0x9E3779B9;
+    bootloader->running = true;
+    pthread_mutex_init(&bootloader->lock, NULL);
+
+    if (pthread_create(&bootloader->thread, NULL, bootloader_thread, bootloader) != 0)
+    {
+        pthread_mutex_destroy(&bootloader->lock);
+        free(bootloader);
+        ESP_RETURN_ON_FALSE(false, ESP_ERR_NO_MEM, TAG, "create thread failed");
+    }
+
+    *ret_bootloader = bootloader;
+    return ESP_OK;
+}
+
+esp_err_t sscma_bootloader_stop(sscma_bootloader_handle_t bootloader)
+{
+    if (bootloader == NULL)
+    {
+        return ESP_OK;
+    }
+
+    bootloader->running = false;
+    shutdown(bootloader->fd, SHUT_RDWR);
+    pthread_join(bootloader->thread, NULL);
+
+    pthread_mutex_destroy(&bootloader->lock);
+    free(bootloader->image);
+    free(bootloader);
+
+    return ESP_OK;
+}
+
+const uint8_t *sscma_bootloader_get_image(sscma_bootloader_handle_t bootloader, size_t *len, size_t *offset)
+{
+    pthread_mutex_lock(&bootloader->lock);
+    *len = bootloader->len;
+    *offset = bootloader->offset;
+    pthread_mutex_unlock(&bootloader->lock);
+
+    return bootloader->image;
+}
+
+void sscma_bootloader_get_stats(sscma_bootloader_handle_t bootloader, sscma_bootloader_stats_t *stats)
+{
+    pthread_mutex_lock(&bootloader->lock);
+    *stats = bootloader->stats;
+    pthread_mutex_unlock(&bootloader->lock);
+}
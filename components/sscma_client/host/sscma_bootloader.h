@@ -0,0 +1,93 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct sscma_bootloader_t *sscma_bootloader_handle_t; /*!< Type of emulated bootloader handle */
+
+/**
+ * @brief Emulated WE2 bootloader configuration
+ */
+typedef struct
+{
+    int baud;          /*!< UART baud rate the link is throttled to, 10 bits a byte, 0 for no limit */
+    int turnaround_us; /*!< Time to check and program a block before it is answered */
+    int error_rate;    /*!< One block in error_rate arrives corrupted and is NAKed, 0 for none */
+    bool xmodem_1k;    /*!< Whether STX blocks of 1024 bytes are taken, they are NAKed otherwise */
+    size_t capacity;   /*!< Bytes of flash the image may take */
+} sscma_bootloader_config_t;
+
+#define SSCMA_BOOTLOADER_CONFIG_DEFAULT()                                                                \
+    {                                                                                                    \
+        .baud = 921600, .turnaround_us = 2000, .error_rate = 0, .xmodem_1k = true,                       \
+        .capacity = 16 * 1024 * 1024,                                                                    \
+    }
+
+/**
+ * @brief Bootloader counters
+ */
+typedef struct
+{
+    uint32_t blocks;     /*!< Blocks taken */
+    uint32_t blocks_1k;  /*!< Of which 1024 byte blocks */
+    uint32_t naks;       /*!< Blocks answered with NAK, corrupted or refused */
+    uint32_t duplicates; /*!< Blocks sent again after their ACK was missed */
+    uint64_t bytes;      /*!< Bytes received on the link */
+    bool done;           /*!< Whether the sender confirmed the end of the transfer */
+} sscma_bootloader_stats_t;
+
+/**
+ * @brief Start an emulated WE2 UART bootloader on one end of a connected socket
+ *
+ * Stands in for the Himax after AT+RST: "1" gets the xmodem hint, then 'C' is sent until the
+ * first block arrives. SOH and STX blocks are checked by CRC, EOT is answered with ACK and the
+ * reboot question, "n" starts another transfer and "y" ends it. A first transfer holding the
+ * 12 byte offset config sets the offset of the next one.
+ *
+ * @param[in] config bootloader configuration
+ * @param[in] fd socket, owned by the caller and left open on stop
+ * @param[out] ret_bootloader Returned bootloader handle
+ * @return
+ *          - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *          - ESP_ERR_NO_MEM        if out of memory
+ *          - ESP_OK                on success
+ */
+esp_err_t sscma_bootloader_start(const sscma_bootloader_config_t *config, int fd, sscma_bootloader_handle_t *ret_bootloader);
+
+/**
+ * @brief Stop the bootloader and free it
+ *
+ * @param[in] bootloader bootloader handle
+ * @return
+ *          - ESP_OK
+ */
+esp_err_t sscma_bootloader_stop(sscma_bootloader_handle_t bootloader);
+
+/**
+ * @brief Get the image written by the last transfer
+ *
+ * @param[in] bootloader bootloader handle
+ * @param[out] len bytes received, padding of the last block included
+ * @param[out] offset offset set by the config transfer, 0 if none
+ * @return the image, valid until the bootloader is stopped
+ */
+const uint8_t *sscma_bootloader_get_image(sscma_bootloader_handle_t bootloader, size_t *len, size_t *offset);
+
+/**
+ * @brief Get the bootloader counters
+ *
+ * @param[in] bootloader bootloader handle
+ * @param[out] stats counters
+ */
+void sscma_bootloader_get_stats(sscma_bootloader_handle_t bootloader, sscma_bootloader_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
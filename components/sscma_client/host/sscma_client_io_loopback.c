@@ -0,0 +1,228 @@
+#include <errno.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
+#include "sscma_client_io_interface.h"
+#include "sscma_client_io_loopback.h"
+#include "esp_log.h"
+#include "esp_check.h"
+
+static const char *TAG = "sscma_client.io.loopback";
+
+#define WATCH_TASK_STACK        4096
+#define WATCH_TASK_PRIORITY     5
+#define WATCH_POLL_INTERVAL_MS  10
+#define WATCH_DRAIN_TIMEOUT_MS  5
+
+static esp_err_t client_io_loopback_del(sscma_client_io_t *io);
+static esp_err_t client_io_loopback_write(sscma_client_io_t *io, const void *data, size_t len);
+static esp_err_t client_io_loopback_read(sscma_client_io_t *io, void *data, size_t len);
+static esp_err_t client_io_loopback_available(sscma_client_io_t *io, size_t *len);
+static esp_err_t client_io_loopback_flush(sscma_client_io_t *io);
+static esp_err_t client_io_loopback_set_ready_cb(sscma_client_io_t *io, sscma_client_io_ready_cb_t cb, void *user_ctx);
+
+typedef struct
+{
+    sscma_client_io_t base;
+    int fd;                              // Connected socket
+    SemaphoreHandle_t lock;              // Mutex lock
+    SemaphoreHandle_t drained;           // Given by read, so the watcher does not spin on unread bytes
+    TaskHandle_t watch_task;             // Forwards incoming data to ready_cb
+    sscma_client_io_ready_cb_t ready_cb; // Data-ready callback
+    void *ready_ctx;                     // Data-ready callback context
+} sscma_client_io_loopback_t;
+
+esp_err_t sscma_client_new_io_loopback(int fd, sscma_client_io_handle_t *ret_io)
+{
+    esp_err_t ret = ESP_OK;
+    sscma_client_io_loopback_t *loopback_client_io = NULL;
+    ESP_GOTO_ON_FALSE(fd >= 0 && ret_io, ESP_ERR_INVALID_ARG, err, TAG, "invalid argument");
+
+    loopback_client_io = (sscma_client_io_loopback_t *)calloc(1, sizeof(sscma_client_io_loopback_t));
+    ESP_GOTO_ON_FALSE(loopback_client_io, ESP_ERR_NO_MEM, err, TAG, "no mem for loopback client io");
+
+    loopback_client_io->fd = fd;
+    loopback_client_io->base.del = client_io_loopback_del;
+    loopback_client_io->base.write = client_io_loopback_write;
+    loopback_client_io->base.read = client_io_loopback_read;
+    loopback_client_io->base.available = client_io_loopback_available;
+    loopback_client_io->base.flush = client_io_loopback_flush;
+    loopback_client_io->base.set_ready_cb = client_io_loopback_set_ready_cb;
+
+    loopback_client_io->lock = xSemaphoreCreateMutex();
+    ESP_GOTO_ON_FALSE(loopback_client_io->lock, ESP_ERR_NO_MEM, err, TAG, "no mem for mutex");
+    loopback_client_io->drained = xSemaphoreCreateBinary();
+    ESP_GOTO_ON_FALSE(loopback_client_io->drained, ESP_ERR_NO_MEM, err, TAG, "no mem for semaphore");
+
+    *ret_io = &loopback_client_io->base;
+    ESP_LOGI(TAG, "new loopback sscma client io @%p", loopback_client_io);
+
+    return ESP_OK;
+
+err:
+    if (loopback_client_io)
+    {
+        if (loopback_client_io->lock)
+        {
+            vSemaphoreDelete(loopback_client_io->lock);
+        }
+        free(loopback_client_io);
+    }
+
+    return ret;
+}
+
+esp_err_t sscma_client_new_io_loopback_polled(int fd, sscma_client_io_handle_t *ret_io)
+{
+    esp_err_t ret = sscma_client_new_io_loopback(fd, ret_io);
+    if (ret == ESP_OK)
+    {
+        (*ret_io)->set_ready_cb = NULL;
+    }
+
+    return ret;
+}
+
+static esp_err_t client_io_loopback_del(sscma_client_io_t *io)
+{
+    sscma_client_io_loopback_t *loopback_client_io = __containerof(io, sscma_client_io_loopback_t, base);
+
+    if (loopback_client_io->watch_task)
+    {
+        vTaskDelete(loopback_client_io->watch_task);
+    }
+
+    vSemaphoreDelete(loopback_client_io->drained);
+    vSemaphoreDelete(loopback_client_io->lock);
+
+    ESP_LOGD(TAG, "del loopback sscma client io @%p", loopback_client_io);
+    free(loopback_client_io);
+
+    return ESP_OK;
+}
+
+static esp_err_t client_io_loopback_write(sscma_client_io_t *io, const void *data, size_t len)
+{
+    esp_err_t ret = ESP_OK;
+    sscma_client_io_loopback_t *loopback_client_io = __containerof(io, sscma_client_io_loopback_t, base);
+    const uint8_t *p = (const uint8_t *)data;
+
+    xSemaphoreTake(loopback_client_io->lock, portMAX_DELAY);
+    while (len > 0)
+    {
+        ssize_t n = send(loopback_client_io->fd, p, len, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        ESP_GOTO_ON_FALSE(n > 0, ESP_FAIL, err, TAG, "send failed: %d", errno);
+        p += n;
+        len -= n;
+    }
+
+err:
+    xSemaphoreGive(loopback_client_io->lock);
+    return ret;
+}
+
+static esp_err_t client_io_loopback_read(sscma_client_io_t *io, void *data, size_t len)
+{
+    esp_err_t ret = ESP_OK;
+    sscma_client_io_loopback_t *loopback_client_io = __containerof(io, sscma_client_io_loopback_t, base);
+    uint8_t *p = (uint8_t *)data;
+
+    while (len > 0)
+    {
+        ssize_t n = recv(loopback_client_io->fd, p, len, MSG_WAITALL);
+        if (n < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        ESP_GOTO_ON_FALSE(n > 0, ESP_FAIL, err, TAG, "recv failed: %d", errno);
+        p += n;
+        len -= n;
+    }
+
+err:
+    xSemaphoreGive(loopback_client_io->drained);
+    return ret;
+}
+
+static esp_err_t client_io_loopback_available(sscma_client_io_t *io, size_t *len)
+{
+    sscma_client_io_loopback_t *loopback_client_io = __containerof(io, sscma_client_io_loopback_t, base);
+    int avail = 0;
+
+    if (ioctl(loopback_client_io->fd, FIONREAD, &avail) != 0)
+    {
+        *len = 0;
+        return ESP_FAIL;
+    }
+    *len = avail;
+
+    return ESP_OK;
+}
+
+static esp_err_t client_io_loopback_flush(sscma_client_io_t *io)
+{
+    (void)io;
+    return ESP_OK;
+}
+
+static void client_io_loopback_watch_task(void *arg)
+{
+    sscma_client_io_loopback_t *loopback_client_io = (sscma_client_io_loopback_t *)arg;
+    struct pollfd pfd = {
+        .fd = loopback_client_io->fd,
+        .events = POLLIN,
+    };
+
+    while (true)
+    {
+        if (poll(&pfd, 1, WATCH_POLL_INTERVAL_MS) <= 0 || (pfd.revents & POLLIN) == 0)
+        {
+            if (pfd.revents & (POLLHUP | POLLERR))
+            {
+                vTaskDelay(pdMS_TO_TICKS(WATCH_POLL_INTERVAL_MS));
+            }
+            continue;
+        }
+        if (loopback_client_io->ready_cb)
+        {
+            loopback_client_io->ready_cb(&loopback_client_io->base, loopback_client_io->ready_ctx);
+        }
+        // poll stays readable until the client reads, wait for it instead of notifying again
+        xSemaphoreTake(loopback_client_io->drained, pdMS_TO_TICKS(WATCH_DRAIN_TIMEOUT_MS));
+    }
+}
+
+static esp_err_t client_io_loopback_set_ready_cb(sscma_client_io_t *io, sscma_client_io_ready_cb_t cb, void *user_ctx)
+{
+    sscma_client_io_loopback_t *loopback_client_io = __containerof(io, sscma_client_io_loopback_t, base);
+
+    loopback_client_io->ready_ctx = user_ctx;
+    loopback_client_io->ready_cb = cb;
+
+    if (cb && loopback_client_io->watch_task == NULL)
+    {
+        BaseType_t res = xTaskCreate(client_io_loopback_watch_task, "sscma_client_loopback", WATCH_TASK_STACK, loopback_client_io, WATCH_TASK_PRIORITY, &loopback_client_io->watch_task);
+        if (res != pdPASS)
+        {
+            loopback_client_io->ready_cb = NULL;
+            loopback_client_io->ready_ctx = NULL;
+            loopback_client_io->watch_task = NULL;
+            ESP_LOGE(TAG, "create loopback watch task failed");
+            return ESP_ERR_NO_MEM;
+        }
+    }
+
+    return ESP_OK;
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "sscma_client_io.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Create SSCMA client IO handle, for a connected socket on the host
+ *
+ * The socket is one end of a socketpair or a pty, the emulator or a real device behind a bridge
+ * holds the other. A watcher thread calls the data-ready callback when bytes arrive.
+ *
+ * @param[in] fd socket, owned by the caller and left open on delete
+ * @param[out] ret_io Returned IO handle
+ * @return
+ *          - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *          - ESP_ERR_NO_MEM        if out of memory
+ *          - ESP_OK                on success
+ */
+esp_err_t sscma_client_new_io_loopback(int fd, sscma_client_io_handle_t *ret_io);
+
+/**
+ * @brief Create SSCMA client IO handle, for a connected socket on the host, without data-ready callback
+ *
+ * Same as sscma_client_new_io_loopback() but without the watcher thread, like an IO that has no
+ * data-ready signal, so the client falls back to polling.
+ *
+ * @param[in] fd socket, owned by the caller and left open on delete
+ * @param[out] ret_io Returned IO handle
+ * @return
+ *          - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *          - ESP_ERR_NO_MEM        if out of memory
+ *          - ESP_OK                on success
+ */
+esp_err_t sscma_client_new_io_loopback_polled(int fd, sscma_client_io_handle_t *ret_io);
+
+#ifdef __cplusplus
+}
+#endif
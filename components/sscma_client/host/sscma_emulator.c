@@ -0,0 +1,646 @@
+#include <errno.h>
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+
+#include "esp_log.h"
+#include "esp_check.h"
+#include "esp_timer.h"
+#include "mbedtls/base64.h"
+
+#include "sscma_client_binary.h"
+#include "sscma_client_commands.h"
+#include "sscma_emulator.h"
+
+static const char *TAG = "sscma_emulator";
+
+#define EMULATOR_LINE_SIZE   512
+#define EMULATOR_FRAME_SLACK 4096 // room for everything in a frame but its image
+#define EMULATOR_HISTORY     1024 // events whose send time is kept
+#define EMULATOR_MAX_BOXES   64
+#define EMULATOR_NAME_SIZE   64 // command name with its tag, as replied
+
+#define EMULATOR_DEVICE_ID   "e3f0a1b2"
+#define EMULATOR_DEVICE_NAME "Grove Vision AI (WE2)"
+#define EMULATOR_MODEL_INFO                                                                                                                                                                            \
+    "{\"model_id\":\"60086\",\"model_name\":\"Person Detection--Swift YOLO\",\"version\":\"1.0.0\",\"url\":\"https://sensecraft.seeed.cc/ai/#/model/detail?id=60086\",\"checksum\":\"\","                \
+    "\"classes\":[\"person\"]}"
+
+typedef struct
+{
+    int width;
+    int height;
+    const char *detail;
+} sscma_emulator_resolution_t;
+
+static const sscma_emulator_resolution_t resolutions[] = {
+    { 240, 240, "240x240 Auto" },
+    { 416, 416, "416x416 Auto" },
+    { 480, 480, "480x480 Auto" },
+    { 640, 480, "640x480 Auto" },
+};
+
+struct sscma_emulator_t
+{
+    sscma_emulator_config_t config;
+    int fd;                   // Device end of the socket
+    pthread_t rx_thread;      // Reads and answers commands
+    pthread_t stream_thread;  // Sends INVOKE and SAMPLE events
+    pthread_mutex_t lock;     // Guards the device state below
+    pthread_cond_t cond;      // Signals stream changes
+    pthread_mutex_t tx_lock;  // Keeps frames whole on the socket
+    bool running;             // Cleared by stop
+    int stream_times;         // Events left in the stream, -1 for no end, 0 when idle
+    bool stream_invoke;       // INVOKE, or SAMPLE when false
+    bool stream_image;        // Events carry the image
+    bool binary;              // Events are sent as binary frames, switched by AT+FRAMING=
+    // Name of the stream events, with the tag of the command
+    char stream_name[EMULATOR_NAME_SIZE];
+    int count;                // Frame counter of the stream
+    int model_id;             // Current model
+    int sensor_opt_id;        // Current sensor resolution
+    int tscore;               // Score threshold
+    int tiou;                 // IoU threshold
+    uint8_t *jpeg;            // JPEG sent with every frame
+    size_t jpeg_len;          // Length of jpeg
+    char *image;              // Base64 of jpeg
+    size_t image_len;         // Length of image
+    char *model_info;         // Base64 of EMULATOR_MODEL_INFO
+    char *tx;                 // Frame being sent, under tx_lock
+    size_t tx_size;           // Size of tx
+    int64_t sent_at[EMULATOR_HISTORY];
+    int sent_count[EMULATOR_HISTORY];
+    sscma_emulator_stats_t stats;
+};
+
+static char *emulator_base64(const uint8_t *data, size_t len, size_t *ret_len)
+{
+    size_t olen = 0;
+    mbedtls_base64_encode(NULL, 0, &olen, data, len);
+    char *out = (char *)malloc(olen);
+    if (out == NULL || mbedtls_base64_encode((unsigned char *)out, olen, &olen, data, len) != 0)
+    {
+        free(out);
+        return NULL;
+    }
+    if (ret_len)
+    {
+        *ret_len = olen;
+    }
+    return out;
+}
+
+// A JPEG sized like a real frame: markers at both ends and noise in between
+static uint8_t *emulator_make_jpeg(size_t size)
+{
+    uint8_t *jpeg = (uint8_t *)malloc(size);
+    if (jpeg == NULL)
+    {
+        return NULL;
+    }
+    uint32_t seed = 0x12345678;
+    for (size_t i = 0; i < size; i++)
+    {
+        seed = seed * 1103515245 + 12345;
+        jpeg[i] = seed >> 16;
+    }
+    if (size >= 4)
+    {
+        jpeg[0] = 0xFF;
+        jpeg[1] = 0xD8;
+        jpeg[size - 2] = 0xFF;
+        jpeg[size - 1] = 0xD9;
+    }
+    return jpeg;
+}
+
+static esp_err_t emulator_send(sscma_emulator_handle_t emulator, const char *data, size_t len)
+{
+    while (len > 0)
+    {
+        ssize_t n = send(emulator->fd, data, len, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (n <= 0)
+        {
+            return ESP_FAIL;
+        }
+        data += n;
+        len -= n;
+    }
+    return ESP_OK;
+}
+
+// Send one frame, formatted like the firmware does it
+static esp_err_t emulator_reply(sscma_emulator_handle_t emulator, const char *format, ...)
+{
+    esp_err_t ret = ESP_OK;
+    va_list args;
+
+    pthread_mutex_lock(&emulator->tx_lock);
+    va_start(args, format);
+    int len = vsnprintf(emulator->tx, emulator->tx_size, format, args);
+    va_end(args);
+    ESP_GOTO_ON_FALSE(len > 0 && (size_t)len < emulator->tx_size, ESP_ERR_INVALID_SIZE, err, TAG, "frame too large: %d", len);
+    ret = emulator_send(emulator, emulator->tx, len);
+    emulator->stats.bytes += len;
+
+err:
+    pthread_mutex_unlock(&emulator->tx_lock);
+    return ret;
+}
+
+static inline uint8_t *put_u16(uint8_t *p, uint16_t v)
+{
+    p[0] = v;
+    p[1] = v >> 8;
+    return p + 2;
+}
+
+static inline uint8_t *put_u32(uint8_t *p, uint32_t v)
+{
+    p[0] = v;
+    p[1] = v >> 8;
+    p[2] = v >> 16;
+    p[3] = v >> 24;
+    return p + 4;
+}
+
+static inline uint8_t *put_record(uint8_t *p, uint8_t tag, uint32_t len)
+{
+    *p++ = tag;
+    return put_u32(p, len);
+}
+
+// Send one binary event, laid out as in sscma_client_binary.h. boxes holds 6 values per box.
+static esp_err_t emulator_reply_binary(sscma_emulator_handle_t emulator, const char *name, int count, const int *boxes, int num_boxes, int width, int height, bool image)
+{
+    esp_err_t ret = ESP_OK;
+    size_t name_len = strlen(name);
+    size_t jpeg_len = image ? emulator->jpeg_len : 0;
+
+    pthread_mutex_lock(&emulator->tx_lock);
+    ESP_GOTO_ON_FALSE(name_len < 256 && (size_t)num_boxes * SSCMA_CLIENT_BINARY_BOX_LEN + jpeg_len + name_len + 64 < emulator->tx_size, ESP_ERR_INVALID_SIZE, err, TAG, "frame too large");
+
+    uint8_t *p = (uint8_t *)emulator->tx + SSCMA_CLIENT_BINARY_HEADER_LEN;
+    *p++ = CMD_TYPE_EVENT;
+    p = put_u16(p, 0);
+    *p++ = name_len;
+    memcpy(p, name, name_len);
+    p += name_len;
+
+    p = put_u32(put_record(p, SSCMA_CLIENT_BINARY_COUNT, 4), count);
+    p = put_u16(put_u16(put_record(p, SSCMA_CLIENT_BINARY_RESOLUTION, 4), width), height);
+    if (boxes != NULL)
+    {
+        p = put_u16(put_u16(put_u16(put_record(p, SSCMA_CLIENT_BINARY_PERF, 6), 7), 48), 2);
+        p = put_record(p, SSCMA_CLIENT_BINARY_BOXES, num_boxes * SSCMA_CLIENT_BINARY_BOX_LEN);
+        for (int i = 0; i < num_boxes; i++)
+        {
+            const int *box = boxes + i * 6;
+            p = put_u16(put_u16(put_u16(put_u16(p, box[0]), box[1]), box[2]), box[3]);
+            *p++ = box[4];
+            *p++ = box[5];
+        }
+    }
+    if (jpeg_len > 0)
+    {
+        p = put_record(p, SSCMA_CLIENT_BINARY_IMAGE, jpeg_len);
+        memcpy(p, emulator->jpeg, jpeg_len);
+        p += jpeg_len;
+    }
+
+    size_t len = p - (uint8_t *)emulator->tx;
+    emulator->tx[0] = '\r';
+    emulator->tx[1] = (char)SSCMA_CLIENT_BINARY_MAGIC;
+    put_u32((uint8_t *)emulator->tx + 2, len - SSCMA_CLIENT_BINARY_HEADER_LEN);
+    ret = emulator_send(emulator, emulator->tx, len);
+    emulator->stats.bytes += len;
+
+err:
+    pthread_mutex_unlock(&emulator->tx_lock);
+    return ret;
+}
+
+static esp_err_t emulator_response(sscma_emulator_handle_t emulator, const char *name, int code, const char *data)
+{
+    return emulator_reply(emulator, RESPONSE_PREFIX "\"type\":%d,\"name\":\"%s\",\"code\":%d,\"data\":%s" RESPONSE_SUFFIX, CMD_TYPE_RESPONSE, name, code, data);
+}
+
+static void emulator_sensor_json(sscma_emulator_handle_t emulator, char *buf, size_t size)
+{
+    snprintf(buf, size, "{\"id\":1,\"type\":1,\"state\":1,\"opt_id\":%d,\"opt_detail\":\"%s\"}", emulator->sensor_opt_id, resolutions[emulator->sensor_opt_id].detail);
+}
+
+// Start a stream of times events, -1 for no end. name carries the tag of the command.
+static void emulator_stream(sscma_emulator_handle_t emulator, const char *name, int times, bool invoke, bool image)
+{
+    pthread_mutex_lock(&emulator->lock);
+    snprintf(emulator->stream_name, sizeof(emulator->stream_name), "%s", name);
+    emulator->stream_times = times < 0 ? -1 : times;
+    emulator->stream_invoke = invoke;
+    emulator->stream_image = image && emulator->image != NULL;
+    emulator->count = 0;
+    pthread_cond_broadcast(&emulator->cond);
+    pthread_mutex_unlock(&emulator->lock);
+}
+
+static void emulator_command(sscma_emulator_handle_t emulator, char *line)
+{
+    char data[1024];
+    char sensor[128];
+    char name[EMULATOR_NAME_SIZE];
+    const char *args = NULL;
+    const char *cmd = NULL;
+
+    if (strncmp(line, CMD_PREFIX, CMD_PREFIX_LEN) != 0)
+    {
+        return;
+    }
+    line += CMD_PREFIX_LEN;
+
+    // the reply is named after the command up to its arguments, tag included
+    char *set = strchr(line, '=');
+    if (set != NULL)
+    {
+        *set = '\0';
+        args = set + 1;
+    }
+    // a reply under a cut name would match nothing, leave the command unanswered like an unknown one
+    if (snprintf(name, sizeof(name), "%s", line) >= (int)sizeof(name))
+    {
+        return;
+    }
+    cmd = strchr(line, '@') ? strchr(line, '@') + 1 : line;
+
+    pthread_mutex_lock(&emulator->lock);
+    emulator->stats.commands++;
+    emulator_sensor_json(emulator, sensor, sizeof(sensor));
+    pthread_mutex_unlock(&emulator->lock);
+
+    if (strcmp(cmd, CMD_AT_ID CMD_QUERY) == 0)
+    {
+        emulator_response(emulator, name, 0, "\"" EMULATOR_DEVICE_ID "\"");
+    }
+    else if (strcmp(cmd, CMD_AT_NAME CMD_QUERY) == 0)
+    {
+        emulator_response(emulator, name, 0, "\"" EMULATOR_DEVICE_NAME "\"");
+    }
+    else if (strcmp(cmd, CMD_AT_VERSION CMD_QUERY) == 0)
+    {
+        emulator_response(emulator, name, 0, "{\"at_api\":\"v0\",\"software\":\"2024.08.19\",\"hardware\":\"1\"}");
+    }
+    else if (strcmp(cmd, CMD_AT_STATS CMD_QUERY) == 0)
+    {
+        emulator_response(emulator, name, 0, "{\"boot_count\":1,\"is_ready\":1}");
+    }
+    else if (strcmp(cmd, CMD_AT_INFO CMD_QUERY) == 0)
+    {
+        snprintf(data, sizeof(data), "{\"crc16_maxim\":0,\"info\":\"%s\"}", emulator->model_info);
+        emulator_response(emulator, name, 0, data);
+    }
+    else if (strcmp(cmd, CMD_AT_MODEL CMD_QUERY) == 0 || (strcmp(cmd, CMD_AT_MODEL) == 0 && args != NULL))
+    {
+        pthread_mutex_lock(&emulator->lock);
+        if (args != NULL)
+        {
+            emulator->model_id = atoi(args);
+        }
+        snprintf(data, sizeof(data), "{\"id\":%d,\"type\":3,\"address\":4194304,\"size\":262144}", emulator->model_id);
+        pthread_mutex_unlock(&emulator->lock);
+        emulator_response(emulator, name, 0, data);
+    }
+    else if (strcmp(cmd, CMD_AT_SENSOR CMD_QUERY) == 0 || (strcmp(cmd, CMD_AT_SENSOR) == 0 && args != NULL))
+    {
+        int id = 1, enable = 1, opt_id = 0;
+        int code = 0;
+        if (args != NULL)
+        {
+            if (sscanf(args, "%d,%d,%d", &id, &enable, &opt_id) != 3 || opt_id < 0 || opt_id >= (int)(sizeof(resolutions) / sizeof(resolutions[0])))
+            {
+                code = CMD_EINVAL;
+            }
+            else
+            {
+                pthread_mutex_lock(&emulator->lock);
+                emulator->sensor_opt_id = opt_id;
+                emulator_sensor_json(emulator, sensor, sizeof(sensor));
+                pthread_mutex_unlock(&emulator->lock);
+            }
+        }
+        snprintf(data, sizeof(data), "{\"sensor\":%s}", sensor);
+        emulator_response(emulator, name, code, data);
+    }
+    else if (strcmp(cmd, CMD_AT_TSCORE CMD_QUERY) == 0 || strcmp(cmd, CMD_AT_TIOU CMD_QUERY) == 0 || ((strcmp(cmd, CMD_AT_TSCORE) == 0 || strcmp(cmd, CMD_AT_TIOU) == 0) && args != NULL))
+    {
+        int *value = strncmp(cmd, CMD_AT_TSCORE, strlen(CMD_AT_TSCORE)) == 0 ? &emulator->tscore : &emulator->tiou;
+        pthread_mutex_lock(&emulator->lock);
+        if (args != NULL)
+        {
+            *value = atoi(args);
+        }
+        snprintf(data, sizeof(data), "%d", *value);
+        pthread_mutex_unlock(&emulator->lock);
+        emulator_response(emulator, name, 0, data);
+    }
+    else if (strcmp(cmd, CMD_AT_INVOKE) == 0 && args != NULL)
+    {
+        int times = 1, filter = 0, results_only = 0;
+        sscanf(args, "%d,%d,%d", &times, &filter, &results_only);
+        pthread_mutex_lock(&emulator->lock);
+        snprintf(data, sizeof(data), "{\"model\":{\"id\":%d,\"type\":3},\"algorithm\":{\"type\":3,\"categroy\":1,\"input_from\":1},\"sensor\":%s}", emulator->model_id, sensor);
+        pthread_mutex_unlock(&emulator->lock);
+        // the response goes out before the first event, as on the device
+        emulator_response(emulator, name, 0, data);
+        emulator_stream(emulator, name, times, true, results_only == 0);
+    }
+    else if (strcmp(cmd, CMD_AT_SAMPLE) == 0 && args != NULL)
+    {
+        snprintf(data, sizeof(data), "{\"sensor\":%s}", sensor);
+        emulator_response(emulator, name, 0, data);
+        emulator_stream(emulator, name, atoi(args), false, true);
+    }
+    else if (emulator->config.binary && strcmp(cmd, CMD_AT_FRAMING CMD_QUERY) == 0)
+    {
+        snprintf(data, sizeof(data), "%d", SSCMA_CLIENT_FRAMING_JSON | SSCMA_CLIENT_FRAMING_BINARY);
+        emulator_response(emulator, name, 0, data);
+    }
+    else if (emulator->config.binary && strcmp(cmd, CMD_AT_FRAMING) == 0 && args != NULL)
+    {
+        int mode = atoi(args);
+        int code = mode == 0 || mode == 1 ? 0 : CMD_EINVAL;
+        pthread_mutex_lock(&emulator->lock);
+        if (code == 0)
+        {
+            emulator->binary = mode == 1;
+        }
+        snprintf(data, sizeof(data), "%d", emulator->binary ? 1 : 0);
+        pthread_mutex_unlock(&emulator->lock);
+        emulator_response(emulator, name, code, data);
+    }
+    else if (strcmp(cmd, CMD_AT_BREAK) == 0)
+    {
+        pthread_mutex_lock(&emulator->lock);
+        emulator->stream_times = 0;
+        pthread_mutex_unlock(&emulator->lock);
+        emulator_response(emulator, name, 0, "{}");
+    }
+    else
+    {
+        if (args != NULL)
+        {
+            line[strlen(line)] = '='; // the log quotes the command as it came
+        }
+        emulator_reply(emulator, RESPONSE_PREFIX "\"type\":%d,\"name\":\"AT\",\"code\":%d,\"data\":\"Unknown command: %s\"" RESPONSE_SUFFIX, CMD_TYPE_LOG, CMD_EINVAL, line);
+    }
+}
+
+static void *emulator_rx_thread(void *arg)
+{
+    sscma_emulator_handle_t emulator = (sscma_emulator_handle_t)arg;
+    char line[EMULATOR_LINE_SIZE];
+    size_t len = 0;
+    char c;
+
+    while (recv(emulator->fd, &c, 1, 0) == 1)
+    {
+        if (c == '\n' || c == '\r')
+        {
+            if (len > 0)
+            {
+                line[len] = '\0';
+                emulator_command(emulator, line);
+            }
+            len = 0;
+        }
+        else if (len < sizeof(line) - 1)
+        {
+            line[len++] = c;
+        }
+    }
+    return NULL;
+}
+
+static void emulator_send_frame(sscma_emulator_handle_t emulator, const char *name, int count, bool invoke, bool image, bool binary, int opt_id)
+{
+    const sscma_emulator_resolution_t *res = &resolutions[opt_id];
+    int values[EMULATOR_MAX_BOXES * 6];
+    int num_boxes = 0;
+    char boxes[EMULATOR_MAX_BOXES * 40];
+    size_t len = 0;
+
+    boxes[0] = '\0';
+    if (invoke)
+    {
+        // boxes drift across the frame so no two events are alike
+        for (; num_boxes < emulator->config.num_boxes && num_boxes < EMULATOR_MAX_BOXES; num_boxes++)
+        {
+            int i = num_boxes;
+            int *box = values + i * 6;
+            box[2] = res->width / 8 + i * 4;
+            box[3] = res->height / 6 + i * 4;
+            box[0] = (count * 7 + i * 53) % (res->width - box[2]) + box[2] / 2;
+            box[1] = (count * 5 + i * 31) % (res->height - box[3]) + box[3] / 2;
+            box[4] = 60 + (count + i) % 40;
+            box[5] = 0;
+            if (!binary)
+            {
+                len += snprintf(boxes + len, sizeof(boxes) - len, "%s[%d,%d,%d,%d,%d,%d]", i ? "," : "", box[0], box[1], box[2], box[3], box[4], box[5]);
+            }
+        }
+    }
+
+    int64_t now = esp_timer_get_time();
+    pthread_mutex_lock(&emulator->lock);
+    emulator->sent_at[count % EMULATOR_HISTORY] = now;
+    emulator->sent_count[count % EMULATOR_HISTORY] = count;
+    emulator->stats.frames++;
+    pthread_mutex_unlock(&emulator->lock);
+
+    if (binary)
+    {
+        emulator_reply_binary(emulator, name, count, invoke ? values : NULL, num_boxes, res->width, res->height, image);
+    }
+    else if (invoke)
+    {
+        emulator_reply(emulator, RESPONSE_PREFIX "\"type\":%d,\"name\":\"%s\",\"code\":0,\"data\":{\"count\":%d,\"perf\":[7,48,2],\"boxes\":[%s],\"resolution\":[%d,%d]%s%s%s}" RESPONSE_SUFFIX,
+            CMD_TYPE_EVENT, name, count, boxes, res->width, res->height, image ? ",\"image\":\"" : "", image ? emulator->image : "", image ? "\"" : "");
+    }
+    else
+    {
+        emulator_reply(emulator, RESPONSE_PREFIX "\"type\":%d,\"name\":\"%s\",\"code\":0,\"data\":{\"count\":%d,\"resolution\":[%d,%d],\"image\":\"%s\"}" RESPONSE_SUFFIX, CMD_TYPE_EVENT,
+            name, count, res->width, res->height, image ? emulator->image : "");
+    }
+}
+
+static void *emulator_stream_thread(void *arg)
+{
+    sscma_emulator_handle_t emulator = (sscma_emulator_handle_t)arg;
+    struct timespec next;
+    char name[sizeof(emulator->stream_name)];
+    long period_ns = emulator->config.fps > 0 ? 1000000000L / emulator->config.fps : 0;
+
+    clock_gettime(CLOCK_MONOTONIC, &next);
+    pthread_mutex_lock(&emulator->lock);
+    while (emulator->running)
+    {
+        if (emulator->stream_times == 0)
+        {
+            pthread_cond_wait(&emulator->cond, &emulator->lock);
+            clock_gettime(CLOCK_MONOTONIC, &next);
+            continue;
+        }
+
+        int count = emulator->count++;
+        bool invoke = emulator->stream_invoke;
+        bool image = emulator->stream_image;
+        bool binary = emulator->binary;
+        int opt_id = emulator->sensor_opt_id;
+        snprintf(name, sizeof(name), "%s", emulator->stream_name);
+        if (emulator->stream_times > 0)
+        {
+            emulator->stream_times--;
+        }
+        pthread_mutex_unlock(&emulator->lock);
+
+        emulator_send_frame(emulator, name, count, invoke, image, binary, opt_id);
+
+        if (period_ns > 0)
+        {
+            next.tv_nsec += period_ns;
+            while (next.tv_nsec >= 1000000000L)
+            {
+                next.tv_sec++;
+                next.tv_nsec -= 1000000000L;
+            }
+            clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+        }
+        pthread_mutex_lock(&emulator->lock);
+    }
+    pthread_mutex_unlock(&emulator->lock);
+    return NULL;
+}
+
+esp_err_t sscma_emulator_start(const sscma_emulator_config_t *config, int fd, sscma_emulator_handle_t *ret_emulator)
+{
+    esp_err_t ret = ESP_OK;
+    sscma_emulator_handle_t emulator = NULL;
+    ESP_RETURN_ON_FALSE(config && fd >= 0 && ret_emulator, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    ESP_RETURN_ON_FALSE(config->sensor_opt_id >= 0 && config->sensor_opt_id < (int)(sizeof(resolutions) / sizeof(resolutions[0])), ESP_ERR_INVALID_ARG, TAG, "invalid sensor option");
+
+    emulator = (sscma_emulator_handle_t)calloc(1, sizeof(struct sscma_emulator_t));
+    ESP_RETURN_ON_FALSE(emulator, ESP_ERR_NO_MEM, TAG, "no mem for emulator");
+
+    emulator->config = *config;
+    emulator->fd = fd;
+    emulator->model_id = config->model_id;
+    emulator->sensor_opt_id = config->sensor_opt_id;
+    emulator->tscore = 60;
+    emulator->tiou = 55;
+    emulator->running = true;
+    for (int i = 0; i < EMULATOR_HISTORY; i++)
+    {
+        emulator->sent_count[i] = -1;
+    }
+    pthread_mutex_init(&emulator->lock, NULL);
+    pthread_mutex_init(&emulator->tx_lock, NULL);
+    pthread_cond_init(&emulator->cond, NULL);
+
+    emulator->model_info = emulator_base64((const uint8_t *)EMULATOR_MODEL_INFO, strlen(EMULATOR_MODEL_INFO), NULL);
+    ESP_GOTO_ON_FALSE(emulator->model_info, ESP_ERR_NO_MEM, err, TAG, "no mem for model info");
+    if (config->image_size > 0)
+    {
+        emulator->jpeg = emulator_make_jpeg(config->image_size);
+        ESP_GOTO_ON_FALSE(emulator->jpeg, ESP_ERR_NO_MEM, err, TAG, "no mem for image");
+        emulator->jpeg_len = config->image_size;
+        emulator->image = emulator_base64(emulator->jpeg, emulator->jpeg_len, &emulator->image_len);
+        ESP_GOTO_ON_FALSE(emulator->image, ESP_ERR_NO_MEM, err, TAG, "no mem for image");
+    }
+    emulator->tx_size = emulator->image_len + EMULATOR_FRAME_SLACK;
+    emulator->tx = (char *)malloc(emulator->tx_size);
+    ESP_GOTO_ON_FALSE(emulator->tx, ESP_ERR_NO_MEM, err, TAG, "no mem for tx buffer");
+
+    ESP_GOTO_ON_FALSE(pthread_create(&emulator->stream_thread, NULL, emulator_stream_thread, emulator) == 0, ESP_ERR_NO_MEM, err, TAG, "create stream thread failed");
+    if (pthread_create(&emulator->rx_thread, NULL, emulator_rx_thread, emulator) != 0)
+    {
+        pthread_mutex_lock(&emulator->lock);
+        emulator->running = false;
+        pthread_cond_broadcast(&emulator->cond);
+        pthread_mutex_unlock(&emulator->lock);
+        pthread_join(emulator->stream_thread, NULL);
+        ESP_GOTO_ON_FALSE(false, ESP_ERR_NO_MEM, err, TAG, "create rx thread failed");
+    }
+
+    emulator_reply(emulator, RESPONSE_PREFIX "\"type\":%d,\"name\":\"" EVENT_INIT "\",\"code\":0,\"data\":{\"boot_count\":1,\"is_ready\":1}" RESPONSE_SUFFIX, CMD_TYPE_EVENT);
+
+    *ret_emulator = emulator;
+    return ESP_OK;
+
+err:
+    free(emulator->tx);
+    free(emulator->jpeg);
+    free(emulator->image);
+    free(emulator->model_info);
+    free(emulator);
+    return ret;
+}
+
+esp_err_t sscma_emulator_stop(sscma_emulator_handle_t emulator)
+{
+    if (emulator == NULL)
+    {
+        return ESP_OK;
+    }
+
+    pthread_mutex_lock(&emulator->lock);
+    emulator->running = false;
+    emulator->stream_times = 0;
+    pthread_cond_broadcast(&emulator->cond);
+    pthread_mutex_unlock(&emulator->lock);
+    pthread_join(emulator->stream_thread, NULL);
+
+    // the rx thread leaves once the socket reads nothing more
+    shutdown(emulator->fd, SHUT_RDWR);
+    pthread_join(emulator->rx_thread, NULL);
+
+    pthread_cond_destroy(&emulator->cond);
+    pthread_mutex_destroy(&emulator->tx_lock);
+    pthread_mutex_destroy(&emulator->lock);
+    free(emulator->tx);
+    free(emulator->jpeg);
+    free(emulator->image);
+    free(emulator->model_info);
+    free(emulator);
+
+    return ESP_OK;
+}
+
+int64_t sscma_emulator_sent_at(sscma_emulator_handle_t emulator, int count)
+{
+    int64_t sent_at = -1;
+
+    pthread_mutex_lock(&emulator->lock);
+    if (count >= 0 && emulator->sent_count[count % EMULATOR_HISTORY] == count)
+    {
+        sent_at = emulator->sent_at[count % EMULATOR_HISTORY];
+    }
+    pthread_mutex_unlock(&emulator->lock);
+
+    return sent_at;
+}
+
+void sscma_emulator_get_stats(sscma_emulator_handle_t emulator, sscma_emulator_stats_t *stats)
+{
+    pthread_mutex_lock(&emulator->tx_lock);
+    pthread_mutex_lock(&emulator->lock);
+    *stats = emulator->stats;
+    pthread_mutex_unlock(&emulator->lock);
+    pthread_mutex_unlock(&emulator->tx_lock);
+}
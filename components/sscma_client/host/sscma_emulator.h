@@ -0,0 +1,90 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct sscma_emulator_t *sscma_emulator_handle_t; /*!< Type of SSCMA emulator handle */
+
+/**
+ * @brief SSCMA emulator configuration
+ */
+typedef struct
+{
+    int fps;           /*!< Frames per second of INVOKE and SAMPLE streams, 0 for as fast as the link takes them */
+    int num_boxes;     /*!< Boxes in every INVOKE event */
+    size_t image_size; /*!< Bytes of JPEG in every frame, before base64, 0 for no image */
+    int model_id;      /*!< Model reported by AT+MODEL? until AT+MODEL= changes it */
+    int sensor_opt_id; /*!< Sensor resolution until AT+SENSOR= changes it: 0 240x240, 1 416x416, 2 480x480, 3 640x480 */
+    bool binary;       /*!< Whether AT+FRAMING is known and binary events can be asked for, as on newer firmware */
+} sscma_emulator_config_t;
+
+#define SSCMA_EMULATOR_CONFIG_DEFAULT()                                                                  \
+    {                                                                                                    \
+        .fps = 30, .num_boxes = 4, .image_size = 16 * 1024, .model_id = 1, .sensor_opt_id = 3,          \
+        .binary = false,                                                                                 \
+    }
+
+/**
+ * @brief Emulator counters
+ */
+typedef struct
+{
+    uint32_t commands; /*!< Commands received */
+    uint32_t frames;   /*!< INVOKE and SAMPLE events sent */
+    uint64_t bytes;    /*!< Bytes sent */
+} sscma_emulator_stats_t;
+
+/**
+ * @brief Start an emulated SSCMA device on one end of a connected socket
+ *
+ * The device speaks the AT protocol of the SSCMA firmware: ID?, NAME?, VER?, STAT?, INFO?, MODEL,
+ * SENSOR, TSCORE, TIOU, INVOKE, SAMPLE and BREAK, tagged or not, and FRAMING when config->binary
+ * is set. Other commands are answered with the unknown command log of the firmware. It sends
+ * INIT@STAT when started.
+ *
+ * @param[in] config emulator configuration
+ * @param[in] fd socket, owned by the caller and left open on stop
+ * @param[out] ret_emulator Returned emulator handle
+ * @return
+ *          - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *          - ESP_ERR_NO_MEM        if out of memory
+ *          - ESP_OK                on success
+ */
+esp_err_t sscma_emulator_start(const sscma_emulator_config_t *config, int fd, sscma_emulator_handle_t *ret_emulator);
+
+/**
+ * @brief Stop the emulator and free it
+ *
+ * @param[in] emulator emulator handle
+ * @return
+ *          - ESP_OK
+ */
+esp_err_t sscma_emulator_stop(sscma_emulator_handle_t emulator);
+
+/**
+ * @brief Time an event was written, for latency measurements
+ *
+ * @param[in] emulator emulator handle
+ * @param[in] count frame counter of the event
+ * @return esp_timer_get_time() when the event was sent, -1 if it is unknown or too old
+ */
+int64_t sscma_emulator_sent_at(sscma_emulator_handle_t emulator, int count);
+
+/**
+ * @brief Get the emulator counters
+ *
+ * @param[in] emulator emulator handle
+ * @param[out] stats counters
+ */
+void sscma_emulator_get_stats(sscma_emulator_handle_t emulator, sscma_emulator_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
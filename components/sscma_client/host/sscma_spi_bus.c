@@ -0,0 +1,223 @@
+#include <errno.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "esp_log.h"
+#include "esp_check.h"
+
+#include "sscma_spi_bus.h"
+
+static const char *TAG = "sscma_spi_bus";
+
+#define FEATURE_TRANSPORT               0x10
+#define FEATURE_TRANSPORT_CMD_READ      0x01
+#define FEATURE_TRANSPORT_CMD_AVAILABLE 0x03
+
+struct spi_device_t
+{
+    sscma_spi_bus_config_t config;
+    int clock_hz;
+    QueueHandle_t queued;        // Transactions waiting for the bus
+    QueueHandle_t done;          // Transactions clocked out, in queue order
+    pthread_t thread;
+    pthread_mutex_t lock;        // Guards stats
+    struct timespec free_at;     // When the bus is done with the last transaction
+    bool packet_start;           // Whether the next transaction starts with CS asserted anew
+    uint8_t cmd;                 // Command of the last packet
+    uint8_t counter;             // Next byte of the data stream
+    sscma_spi_bus_stats_t stats;
+};
+
+static sscma_spi_bus_config_t bus_config = SSCMA_SPI_BUS_CONFIG_DEFAULT();
+
+static spi_transaction_t *const bus_stop = NULL;
+
+void sscma_spi_bus_set_config(const sscma_spi_bus_config_t *config)
+{
+    bus_config = *config;
+}
+
+static void timespec_add_us(struct timespec *ts, int64_t us)
+{
+    ts->tv_sec += us / 1000000;
+    ts->tv_nsec += (us % 1000000) * 1000;
+    if (ts->tv_nsec >= 1000000000)
+    {
+        ts->tv_sec++;
+        ts->tv_nsec -= 1000000000;
+    }
+}
+
+static bool timespec_before(const struct timespec *a, const struct timespec *b)
+{
+    return a->tv_sec < b->tv_sec || (a->tv_sec == b->tv_sec && a->tv_nsec < b->tv_nsec);
+}
+
+// Hold the transaction for its time on the wire, back to back with the one before it
+static void bus_clock(spi_device_handle_t device, size_t bytes)
+{
+    struct timespec now;
+    int64_t us = device->config.overhead_us + (int64_t)bytes * 8 * 1000000 / device->clock_hz;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    if (timespec_before(&device->free_at, &now))
+    {
+        device->free_at = now;
+    }
+    timespec_add_us(&device->free_at, us);
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &device->free_at, NULL) == EINTR)
+    {
+    }
+
+    pthread_mutex_lock(&device->lock);
+    device->stats.transactions++;
+    device->stats.bytes += bytes;
+    device->stats.busy_us += us;
+    pthread_mutex_unlock(&device->lock);
+}
+
+// The device side of a transaction: a packet header sets the command, data follows it
+static void bus_answer(spi_device_handle_t device, spi_transaction_t *trans, size_t bytes)
+{
+    const uint8_t *tx = (const uint8_t *)trans->tx_buffer;
+    uint8_t *rx = (uint8_t *)trans->rx_buffer;
+
+    if (device->packet_start && tx != NULL && bytes >= 2 && tx[0] == FEATURE_TRANSPORT)
+    {
+        device->cmd = tx[1];
+    }
+    else if (rx != NULL && device->cmd == FEATURE_TRANSPORT_CMD_READ)
+    {
+        for (size_t i = 0; i < bytes; i++)
+        {
+            rx[i] = device->counter++;
+        }
+        pthread_mutex_lock(&device->lock);
+        device->stats.data_bytes += bytes;
+        pthread_mutex_unlock(&device->lock);
+    }
+    else if (rx != NULL && device->cmd == FEATURE_TRANSPORT_CMD_AVAILABLE && bytes >= 2)
+    {
+        rx[0] = device->config.available >> 8;
+        rx[1] = device->config.available & 0xFF;
+    }
+    device->packet_start = (trans->flags & SPI_TRANS_CS_KEEP_ACTIVE) == 0;
+}
+
+static void *bus_thread(void *arg)
+{
+    spi_device_handle_t device = (spi_device_handle_t)arg;
+    spi_transaction_t *trans = NULL;
+
+    while (xQueueReceive(device->queued, &trans, portMAX_DELAY) == pdTRUE && trans != bus_stop)
+    {
+        size_t bytes = trans->length / 8;
+        bus_clock(device, bytes);
+        bus_answer(device, trans, bytes);
+        xQueueSend(device->done, &trans, portMAX_DELAY);
+    }
+
+    return NULL;
+}
+
+esp_err_t spi_bus_get_max_transaction_len(spi_host_device_t host, size_t *max_bytes)
+{
+    (void)host;
+    *max_bytes = bus_config.max_transaction_len;
+    return ESP_OK;
+}
+
+esp_err_t spi_bus_add_device(spi_host_device_t host, const spi_device_interface_config_t *config, spi_device_handle_t *handle)
+{
+    spi_device_handle_t device = NULL;
+    (void)host;
+    ESP_RETURN_ON_FALSE(config && config->clock_speed_hz > 0 && config->queue_size > 0 && handle, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+
+    device = (spi_device_handle_t)calloc(1, sizeof(struct spi_device_t));
+    ESP_RETURN_ON_FALSE(device, ESP_ERR_NO_MEM, TAG, "no mem for device");
+
+    device->config = bus_config;
+    device->clock_hz = config->clock_speed_hz;
+    device->packet_start = true;
+    device->queued = xQueueCreate(config->queue_size + 1, sizeof(spi_transaction_t *));
+    device->done = xQueueCreate(config->queue_size, sizeof(spi_transaction_t *));
+    pthread_mutex_init(&device->lock, NULL);
+
+    if (device->queued == NULL || device->done == NULL || pthread_create(&device->thread, NULL, bus_thread, device) != 0)
+    {
+        if (device->queued)
+        {
+            vQueueDelete(device->queued);
+        }
+        if (device->done)
+        {
+            vQueueDelete(device->done);
+        }
+        pthread_mutex_destroy(&device->lock);
+        free(device);
+        ESP_RETURN_ON_FALSE(false, ESP_ERR_NO_MEM, TAG, "create device failed");
+    }
+
+    *handle = device;
+    return ESP_OK;
+}
+
+esp_err_t spi_bus_remove_device(spi_device_handle_t handle)
+{
+    if (handle == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    xQueueSend(handle->queued, &bus_stop, portMAX_DELAY);
+    pthread_join(handle->thread, NULL);
+    vQueueDelete(handle->queued);
+    vQueueDelete(handle->done);
+    pthread_mutex_destroy(&handle->lock);
+    free(handle);
+
+    return ESP_OK;
+}
+
+esp_err_t spi_bus_free(spi_host_device_t host)
+{
+    (void)host;
+    return ESP_OK;
+}
+
+esp_err_t spi_device_acquire_bus(spi_device_handle_t device, TickType_t wait)
+{
+    (void)device;
+    (void)wait;
+    return ESP_OK;
+}
+
+void spi_device_release_bus(spi_device_handle_t device)
+{
+    (void)device;
+}
+
+esp_err_t spi_device_queue_trans(spi_device_handle_t handle, spi_transaction_t *trans, TickType_t ticks)
+{
+    ESP_RETURN_ON_FALSE(handle && trans && trans->length > 0, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    ESP_RETURN_ON_FALSE(trans->length / 8 <= handle->config.max_transaction_len, ESP_ERR_INVALID_ARG, TAG, "transaction too long");
+    return xQueueSend(handle->queued, &trans, ticks) == pdTRUE ? ESP_OK : ESP_ERR_TIMEOUT;
+}
+
+esp_err_t spi_device_get_trans_result(spi_device_handle_t handle, spi_transaction_t **trans, TickType_t ticks)
+{
+    ESP_RETURN_ON_FALSE(handle && trans, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    return xQueueReceive(handle->done, trans, ticks) == pdTRUE ? ESP_OK : ESP_ERR_TIMEOUT;
+}
+
+void sscma_spi_bus_get_stats(spi_device_handle_t device, sscma_spi_bus_stats_t *stats)
+{
+    pthread_mutex_lock(&device->lock);
+    *stats = device->stats;
+    pthread_mutex_unlock(&device->lock);
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "driver/spi_master.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Emulated SPI bus configuration
+ */
+typedef struct
+{
+    size_t max_transaction_len; /*!< Bytes the bus takes in one transaction, as spi_bus_get_max_transaction_len reports */
+    int overhead_us;            /*!< Time to set up each transaction on top of its bits on the wire */
+    uint16_t available;         /*!< Bytes the device reports for AVAILABLE */
+} sscma_spi_bus_config_t;
+
+#define SSCMA_SPI_BUS_CONFIG_DEFAULT()                                                                   \
+    {                                                                                                    \
+        .max_transaction_len = 4092, .overhead_us = 20, .available = 4095,                               \
+    }
+
+/**
+ * @brief Bus counters
+ */
+typedef struct
+{
+    uint32_t transactions; /*!< Transactions clocked out */
+    uint64_t bytes;        /*!< Bytes on the wire, both directions counted once */
+    int64_t busy_us;       /*!< Time the bus was clocking or setting up a transaction */
+    uint64_t data_bytes;   /*!< Bytes of data read after READ packets */
+} sscma_spi_bus_stats_t;
+
+/**
+ * @brief Set the configuration of the devices added from now on
+ *
+ * The SPI transport adds its device in sscma_client_new_io_spi_bus(), the emulated bus behind the
+ * driver/spi_master.h calls gives it a thread that clocks queued transactions at the device clock
+ * one after the other, and answers the SSCMA transport packets: the data read after a READ
+ * packet is a byte counter continued across reads, AVAILABLE is answered with config->available.
+ *
+ * @param[in] config bus configuration
+ */
+void sscma_spi_bus_set_config(const sscma_spi_bus_config_t *config);
+
+/**
+ * @brief Get the counters of a device
+ *
+ * @param[in] device device handle, the handle of the SPI IO
+ * @param[out] stats counters
+ */
+void sscma_spi_bus_get_stats(spi_device_handle_t device, sscma_spi_bus_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
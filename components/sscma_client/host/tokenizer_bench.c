@@ -0,0 +1,483 @@
+// Parse time and heap use per reply of the inference schema scanner, next to cJSON.
+//
+// The replies are either split from a capture of the raw bytes read from the Himax or synthetic
+// INVOKE events. Each run extracts the results into fixed arrays, the way the copy utils do. The
+// cJSON baselines are only built when the cJSON sources are found (see CMakeLists.txt): "cjson" cuts
+// the image out before parsing like sscma_client_dispatch does, "cjson-full" parses the whole reply.
+// The scanner never allocates, cJSON allocations are counted through cJSON_InitHooks. With cJSON
+// every reply is also read both ways and the results compared, and the exit status is non-zero if
+// any differ.
+#include <limits.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "sscma_client_framer.h"
+#include "sscma_client_tokenizer.h"
+
+#ifdef HAVE_CJSON
+#include "cJSON.h"
+#endif
+
+#define MAX_RESULTS 64
+
+typedef struct
+{
+    const char *capture;
+    const char *schema;
+    size_t replies;
+    int objects;
+    size_t image_size;
+    int repeat;
+} options_t;
+
+typedef struct
+{
+    char **data;
+    size_t *len;
+    size_t count;
+    size_t bytes;
+} replies_t;
+
+typedef struct
+{
+    sscma_client_box_t boxes[MAX_RESULTS];
+    sscma_client_class_t classes[MAX_RESULTS];
+    sscma_client_point_t points[MAX_RESULTS];
+    sscma_client_keypoint_t keypoints[MAX_RESULTS];
+    int num;
+} results_t;
+
+typedef struct
+{
+    size_t allocs;
+    size_t in_use;
+    size_t peak;
+} heap_t;
+
+static heap_t heap;
+
+static double now_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void replies_add(replies_t *replies, const char *data, size_t len)
+{
+    replies->data = realloc(replies->data, sizeof(char *) * (replies->count + 1));
+    replies->len = realloc(replies->len, sizeof(size_t) * (replies->count + 1));
+    replies->data[replies->count] = malloc(len + 1);
+    memcpy(replies->data[replies->count], data, len);
+    replies->data[replies->count][len] = '\0';
+    replies->len[replies->count] = len;
+    replies->count++;
+    replies->bytes += len;
+}
+
+static bool load_capture(const char *path, replies_t *replies)
+{
+    FILE *f = fopen(path, "rb");
+    if (f == NULL)
+    {
+        return false;
+    }
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    char *ring = malloc(size > 0 ? size : 1);
+    char *reply = malloc(size + 1);
+    sscma_client_framer_t framer;
+    sscma_client_frame_t frame;
+    size_t space = 0;
+
+    sscma_client_framer_init(&framer, ring, size > 0 ? size : 1);
+    size_t len = fread(sscma_client_framer_write_ptr(&framer, &space), 1, size, f);
+    sscma_client_framer_commit(&framer, len);
+    while (sscma_client_framer_next(&framer, &frame))
+    {
+        sscma_client_frame_copy(&frame, reply);
+        replies_add(replies, reply, frame.len);
+    }
+    fclose(f);
+    free(reply);
+    free(ring);
+    return true;
+}
+
+static int synthesize_result(char *out, const char *schema)
+{
+    int x = rand() % 416, y = rand() % 416, score = 50 + rand() % 50, target = rand() % 80;
+    if (strcmp(schema, "classes") == 0)
+    {
+        return sprintf(out, "[%d, %d]", score, target);
+    }
+    if (strcmp(schema, "points") == 0)
+    {
+        return sprintf(out, "[%d, %d, %d, %d]", x, y, score, target);
+    }
+    if (strcmp(schema, "keypoints") == 0)
+    {
+        int pos = sprintf(out, "[[%d, %d, 64, 128, %d, %d], [", x, y, score, target);
+        for (int i = 0; i < 17; i++)
+        {
+            pos += sprintf(out + pos, "%s[%d, %d, %d, %d]", i ? ", " : "", rand() % 416, rand() % 416, rand() % 100, i);
+        }
+        return pos + sprintf(out + pos, "]]");
+    }
+    return sprintf(out, "[%d, %d, 64, 64, %d, %d]", x, y, score, target);
+}
+
+// INVOKE events as sent by the Himax
+static void synthesize(const options_t *opt, replies_t *replies)
+{
+    static const char b64[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    char *reply = malloc(opt->image_size + opt->objects * 512 + 512);
+
+    srand(1);
+    for (size_t i = 0; i < opt->replies; i++)
+    {
+        int pos = sprintf(reply, "\r{\"type\": 1, \"name\": \"INVOKE\", \"code\": 0, \"data\": {\"count\": %u, \"algo\": 0, \"model\": 1, \"sensor\": 0, \"perf\": [7, 91, 0], \"%s\": [", (unsigned)i, opt->schema);
+        for (int j = 0; j < opt->objects; j++)
+        {
+            pos += sprintf(reply + pos, j ? ", " : "");
+            pos += synthesize_result(reply + pos, opt->schema);
+        }
+        pos += sprintf(reply + pos, "], \"resolution\": [416, 416], \"image\": \"");
+        for (size_t j = 0; j < opt->image_size; j++)
+        {
+            reply[pos++] = b64[rand() & 63];
+        }
+        pos += sprintf(reply + pos, "\"}}\n");
+        replies_add(replies, reply, pos);
+    }
+    free(reply);
+}
+
+static int run_tokenizer(const char *data, size_t len, results_t *results)
+{
+    sscma_client_inference_t inference = {
+        .boxes = results->boxes,
+        .max_boxes = MAX_RESULTS,
+        .classes = results->classes,
+        .max_classes = MAX_RESULTS,
+        .points = results->points,
+        .max_points = MAX_RESULTS,
+        .keypoints = results->keypoints,
+        .max_keypoints = MAX_RESULTS,
+    };
+    if (!sscma_client_tokenize_inference(data, len, &inference))
+    {
+        return -1;
+    }
+    results->num = inference.num_boxes + inference.num_classes + inference.num_points + inference.num_keypoints;
+    return inference.width;
+}
+
+#ifdef HAVE_CJSON
+static void *count_malloc(size_t size)
+{
+    size_t *block = malloc(sizeof(size_t) + size);
+    if (block == NULL)
+    {
+        return NULL;
+    }
+    *block = size;
+    heap.allocs++;
+    heap.in_use += size;
+    heap.peak = heap.in_use > heap.peak ? heap.in_use : heap.peak;
+    return block + 1;
+}
+
+static void count_free(void *ptr)
+{
+    if (ptr != NULL)
+    {
+        size_t *block = (size_t *)ptr - 1;
+        heap.in_use -= *block;
+        free(block);
+    }
+}
+
+static int get_int(cJSON *array, int index)
+{
+    cJSON *item = cJSON_GetArrayItem(array, index);
+    return item != NULL && cJSON_IsNumber(item) ? item->valueint : INT_MIN;
+}
+
+static void walk_records(cJSON *array, int fields, results_t *results, int kind)
+{
+    int count = cJSON_GetArraySize(array);
+    count = count > MAX_RESULTS ? MAX_RESULTS : count;
+    for (int i = 0; i < count; i++)
+    {
+        cJSON *item = cJSON_GetArrayItem(array, i);
+        int values[6];
+        for (int j = 0; j < fields; j++)
+        {
+            values[j] = get_int(item, j);
+        }
+        if (kind == 0)
+        {
+            results->boxes[i] = (sscma_client_box_t){ values[0], values[1], values[2], values[3], values[4], values[5] };
+        }
+        else if (kind == 1)
+        {
+            results->classes[i] = (sscma_client_class_t){ .score = values[0], .target = values[1] };
+        }
+        else
+        {
+            results->points[i] = (sscma_client_point_t){ values[0], values[1], 0, values[2], values[3] };
+        }
+    }
+    results->num += count;
+}
+
+static int walk_payload(cJSON *payload, results_t *results)
+{
+    if (payload == NULL)
+    {
+        return -1;
+    }
+    cJSON *data = cJSON_GetObjectItem(payload, "data");
+    results->num = 0;
+    walk_records(cJSON_GetObjectItem(data, "boxes"), 6, results, 0);
+    walk_records(cJSON_GetObjectItem(data, "classes"), 2, results, 1);
+    walk_records(cJSON_GetObjectItem(data, "points"), 4, results, 2);
+
+    cJSON *keypoints = cJSON_GetObjectItem(data, "keypoints");
+    int count = cJSON_GetArraySize(keypoints);
+    count = count > MAX_RESULTS ? MAX_RESULTS : count;
+    for (int i = 0; i < count; i++)
+    {
+        cJSON *item = cJSON_GetArrayItem(keypoints, i);
+        cJSON *box = cJSON_GetArrayItem(item, 0);
+        cJSON *points = cJSON_GetArrayItem(item, 1);
+        sscma_client_keypoint_t *keypoint = &results->keypoints[i];
+        keypoint->box = (sscma_client_box_t){ get_int(box, 0), get_int(box, 1), get_int(box, 2), get_int(box, 3), get_int(box, 4), get_int(box, 5) };
+        int points_num = cJSON_GetArraySize(points);
+        keypoint->points_num = points_num > SSCMA_CLIENT_MODEL_KEYPOINTS_MAX ? SSCMA_CLIENT_MODEL_KEYPOINTS_MAX : points_num;
+        for (int j = 0; j < keypoint->points_num; j++)
+        {
+            cJSON *point = cJSON_GetArrayItem(points, j);
+            keypoint->points[j] = (sscma_client_point_t){ get_int(point, 0), get_int(point, 1), 0, get_int(point, 2), get_int(point, 3) };
+        }
+    }
+    results->num += count;
+
+    cJSON *resolution = cJSON_GetObjectItem(data, "resolution");
+    int width = get_int(resolution, 0);
+    cJSON_Delete(payload);
+    return width;
+}
+
+static int run_cjson_full(const char *data, size_t len, results_t *results)
+{
+    (void)len;
+    return walk_payload(cJSON_Parse(data), results);
+}
+
+static int run_cjson(const char *data, size_t len, results_t *results)
+{
+    // the image value is cut out before parsing, the base64 string holds no quotes
+    const char *image = strstr(data, "\"image\"");
+    const char *value = image ? strchr(image + 7, '"') : NULL;
+    const char *value_end = value ? strchr(value + 1, '"') : NULL;
+    if (value_end == NULL)
+    {
+        return run_cjson_full(data, len, results);
+    }
+
+    size_t head = value + 1 - data;
+    size_t tail = len - (value_end - data);
+    char *json = count_malloc(head + tail + 1);
+    memcpy(json, data, head);
+    memcpy(json + head, value_end, tail);
+    json[head + tail] = '\0';
+    cJSON *payload = cJSON_Parse(json);
+    count_free(json);
+    return walk_payload(payload, results);
+}
+
+// Replies the scanner reads differently from the cJSON walk, a reply without resolution counts
+// the same whichever way it has none
+static size_t check(const replies_t *replies)
+{
+    results_t *scanned = malloc(sizeof(results_t));
+    results_t *parsed = malloc(sizeof(results_t));
+    size_t differ = 0;
+
+    for (size_t i = 0; i < replies->count; i++)
+    {
+        memset(scanned, 0, sizeof(results_t));
+        memset(parsed, 0, sizeof(results_t));
+        int width = run_tokenizer(replies->data[i], replies->len[i], scanned);
+        int expected = run_cjson_full(replies->data[i], replies->len[i], parsed);
+        bool same_width = width == expected || (width <= 0 && expected <= 0);
+        if (!same_width || memcmp(scanned, parsed, sizeof(results_t)) != 0)
+        {
+            if (differ == 0)
+            {
+                printf("reply %zu is read differently from cJSON\n", i);
+            }
+            differ++;
+        }
+    }
+    free(scanned);
+    free(parsed);
+    return differ;
+}
+#endif
+
+static void report(const char *name, int (*run)(const char *, size_t, results_t *), const options_t *opt, const replies_t *replies)
+{
+    results_t *results = malloc(sizeof(results_t));
+    double best = 1e30;
+    size_t failed = 0;
+    size_t objects = 0;
+    size_t peak = 0;
+
+    for (int i = 0; i < opt->repeat; i++)
+    {
+        heap = (heap_t){ 0 };
+        failed = 0;
+        objects = 0;
+        peak = 0;
+        double start = now_seconds();
+        for (size_t j = 0; j < replies->count; j++)
+        {
+            heap.in_use = 0;
+            heap.peak = 0;
+            results->num = 0;
+            if (run(replies->data[j], replies->len[j], results) < 0)
+            {
+                failed++;
+            }
+            objects += results->num;
+            peak = heap.peak > peak ? heap.peak : peak;
+        }
+        double elapsed = now_seconds() - start;
+        best = elapsed < best ? elapsed : best;
+    }
+    printf("%-10s %8.2f us/reply %8.1f allocs/reply %8zu B peak heap %8zu objects %6zu failed\n", name, best / replies->count * 1e6,
+        (double)heap.allocs / replies->count, peak, objects, failed);
+    free(results);
+}
+
+static void usage(const char *argv0)
+{
+    fprintf(stderr,
+        "usage: %s [options]\n"
+        "  --capture FILE     raw bytes read from the Himax, split into replies\n"
+        "  --replies N        synthetic INVOKE events without a capture (default 500)\n"
+        "  --schema S         boxes, classes, points or keypoints (default boxes)\n"
+        "  --objects N        results per synthetic event (default 10)\n"
+        "  --image-size B     base64 image bytes per synthetic event (default 20000)\n"
+        "  --repeat N         runs, the fastest is reported (default 5)\n",
+        argv0);
+}
+
+int main(int argc, char **argv)
+{
+    options_t opt = {
+        .capture = NULL,
+        .schema = "boxes",
+        .replies = 500,
+        .objects = 10,
+        .image_size = 20000,
+        .repeat = 5,
+    };
+
+    for (int i = 1; i < argc; i++)
+    {
+        const char *arg = argv[i];
+        const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+        if (value == NULL)
+        {
+            usage(argv[0]);
+            return 1;
+        }
+        if (strcmp(arg, "--capture") == 0)
+        {
+            opt.capture = value;
+        }
+        else if (strcmp(arg, "--replies") == 0)
+        {
+            opt.replies = strtoul(value, NULL, 10);
+        }
+        else if (strcmp(arg, "--schema") == 0)
+        {
+            opt.schema = value;
+        }
+        else if (strcmp(arg, "--objects") == 0)
+        {
+            opt.objects = atoi(value);
+        }
+        else if (strcmp(arg, "--image-size") == 0)
+        {
+            opt.image_size = strtoul(value, NULL, 10);
+        }
+        else if (strcmp(arg, "--repeat") == 0)
+        {
+            opt.repeat = atoi(value);
+        }
+        else
+        {
+            usage(argv[0]);
+            return 1;
+        }
+        i++;
+    }
+    if (opt.repeat <= 0 || opt.objects < 0)
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    replies_t replies = { 0 };
+    if (opt.capture)
+    {
+        if (!load_capture(opt.capture, &replies))
+        {
+            fprintf(stderr, "cannot read %s\n", opt.capture);
+            return 1;
+        }
+    }
+    else
+    {
+        synthesize(&opt, &replies);
+    }
+    if (replies.count == 0)
+    {
+        fprintf(stderr, "no replies\n");
+        return 1;
+    }
+
+    printf("%zu replies, %zu bytes on average\n", replies.count, replies.bytes / replies.count);
+    report("tokenizer", run_tokenizer, &opt, &replies);
+#ifdef HAVE_CJSON
+    cJSON_Hooks hooks = { .malloc_fn = count_malloc, .free_fn = count_free };
+    cJSON_InitHooks(&hooks);
+    report("cjson", run_cjson, &opt, &replies);
+    report("cjson-full", run_cjson_full, &opt, &replies);
+    size_t differ = check(&replies);
+    printf("%-10s %zu of %zu replies read differently from cJSON\n", "check", differ, replies.count);
+#else
+    printf("cJSON baseline not built, configure with -DCJSON_DIR=<dir with cJSON.c>\n");
+#endif
+
+    for (size_t i = 0; i < replies.count; i++)
+    {
+        free(replies.data[i]);
+    }
+    free(replies.data);
+    free(replies.len);
+#ifdef HAVE_CJSON
+    return differ ? 1 : 0;
+#else
+    return 0;
+#endif
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "sscma_client_tokenizer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Binary frames, sent instead of JSON for INVOKE and SAMPLE events once AT+FRAMING=1 is accepted.
+ * Responses and logs stay JSON. All integers are little endian.
+ *
+ *   '\r' SSCMA_CLIENT_BINARY_MAGIC   u32 body length
+ *   body: u8 type, i16 code, u8 name length, name, then records of u8 tag, u32 length, value
+ *
+ * Records, unknown tags are skipped:
+ *   COUNT       u32
+ *   RESOLUTION  u16 width, u16 height
+ *   PERF        u16 preprocess, u16 inference, u16 postprocess, in ms
+ *   BOXES       per box u16 x, y, w, h, u8 score, target
+ *   CLASSES     per class u8 target, score
+ *   POINTS      per point u16 x, y, z, u8 score, target
+ *   KEYPOINTS   per keypoint a box as above, u8 point count, the points as above
+ *   IMAGE       the JPEG itself
+ */
+#define SSCMA_CLIENT_FRAMING_JSON   (1 << 0) /*!< Bit of AT+FRAMING? for JSON frames, mode 0 of AT+FRAMING= */
+#define SSCMA_CLIENT_FRAMING_BINARY (1 << 1) /*!< Bit of AT+FRAMING? for binary frames, mode 1 of AT+FRAMING= */
+
+#define SSCMA_CLIENT_BINARY_MAGIC      0xB1
+#define SSCMA_CLIENT_BINARY_HEADER_LEN 6
+
+#define SSCMA_CLIENT_BINARY_BOX_LEN   10
+#define SSCMA_CLIENT_BINARY_CLASS_LEN 2
+#define SSCMA_CLIENT_BINARY_POINT_LEN 8
+
+typedef enum
+{
+    SSCMA_CLIENT_BINARY_COUNT = 1,
+    SSCMA_CLIENT_BINARY_RESOLUTION = 2,
+    SSCMA_CLIENT_BINARY_PERF = 3,
+    SSCMA_CLIENT_BINARY_BOXES = 4,
+    SSCMA_CLIENT_BINARY_CLASSES = 5,
+    SSCMA_CLIENT_BINARY_POINTS = 6,
+    SSCMA_CLIENT_BINARY_KEYPOINTS = 7,
+    SSCMA_CLIENT_BINARY_IMAGE = 8,
+} sscma_client_binary_tag_t;
+
+/**
+ * @brief Whether a frame is a binary one
+ *
+ * @param[in] frame Frame, prefix included
+ * @param[in] len Length of the frame
+ * @return Whether the frame starts with the binary prefix
+ */
+static inline bool sscma_client_binary_is_frame(const char *frame, size_t len)
+{
+    return frame != NULL && len >= SSCMA_CLIENT_BINARY_HEADER_LEN && frame[0] == '\r' && (uint8_t)frame[1] == SSCMA_CLIENT_BINARY_MAGIC;
+}
+
+/**
+ * @brief Decode a binary INVOKE or SAMPLE frame without allocating
+ *
+ * Fills the same fields as sscma_client_tokenize_inference, the image is the JPEG itself and
+ * image_raw is set.
+ *
+ * @param[in] frame Frame, prefix included
+ * @param[in] len Length of the frame
+ * @param[in,out] inference Storage set up by the caller, filled with the fields found
+ * @return Whether the frame is a well formed binary frame
+ */
+bool sscma_client_binary_decode_inference(const char *frame, size_t len, sscma_client_inference_t *inference);
+
+#ifdef __cplusplus
+}
+#endif
@@ -42,6 +42,7 @@
 #define CMD_AT_ACTION     "ACTION"
 #define CMD_AT_LED        "LED"
 #define CMD_AT_OTA        "OTA"
+#define CMD_AT_FRAMING    "FRAMING"
 
 #define EVENT_INVOKE     "INVOKE"
 #define EVENT_SAMPLE     "SAMPLE"
@@ -25,6 +25,8 @@ typedef struct
     {
         unsigned int reset_high_active : 1;  /*!< Reset line is high active */
         unsigned int reset_use_expander : 1; /*!< Reset line use IO expander */
+        unsigned int xmodem_1k : 1;          /*!< UART only, send XMODEM-1K blocks, falling back to
+                                                128 byte blocks if the first one is refused */
     } flags;
 } sscma_client_flasher_we2_config_t;
 
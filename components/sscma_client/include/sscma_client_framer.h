@@ -0,0 +1,112 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Streaming framer for SSCMA replies
+ *
+ * Received bytes are appended to a ring buffer and scanned once for `\r{ ... }\n` frames. The scan
+ * position is kept across reads, bytes outside of a frame are dropped as soon as they are scanned,
+ * and complete frames are handed out in place, so no data is moved after it has been received.
+ *
+ * In binary mode, length prefixed frames starting with `\r` SSCMA_CLIENT_BINARY_MAGIC are found
+ * as well, their body is skipped over without being scanned. NUL padding is then kept in the ring,
+ * skipped by the scan and squeezed out of JSON frames before they are handed out.
+ */
+typedef struct
+{
+    char *data;       /*!< Ring storage */
+    size_t size;      /*!< Ring capacity */
+    size_t tail;      /*!< Index of the oldest retained byte */
+    size_t len;       /*!< Number of retained bytes */
+    size_t scanned;   /*!< Number of retained bytes already scanned */
+    size_t start;     /*!< Offset of the current frame prefix from tail */
+    size_t consumed;  /*!< Length of the frame handed out last, released on the next call */
+    bool in_frame;    /*!< Whether a frame prefix has been seen */
+    bool in_binary;   /*!< Whether that prefix is a binary one */
+    size_t frame_len; /*!< Length of the binary frame, 0 until its header is complete */
+    bool binary;      /*!< Whether binary frames are expected, NUL bytes are kept in the ring then */
+} sscma_client_framer_t;
+
+/**
+ * @brief A complete frame, prefix and suffix included
+ *
+ * The frame may wrap around the end of the ring, in which case it is split in two parts. It stays
+ * valid until the next call on the framer.
+ */
+typedef struct
+{
+    const char *part[2]; /*!< Frame data, the second part is NULL unless the frame wraps */
+    size_t part_len[2];  /*!< Length of each part */
+    size_t len;          /*!< Total frame length */
+} sscma_client_frame_t;
+
+/**
+ * @brief Initialize a framer over caller provided storage
+ *
+ * @param[in] framer Framer
+ * @param[in] data Ring storage
+ * @param[in] size Ring capacity, bounds the largest frame
+ */
+void sscma_client_framer_init(sscma_client_framer_t *framer, char *data, size_t size);
+
+/**
+ * @brief Drop all buffered data
+ *
+ * @param[in] framer Framer
+ */
+void sscma_client_framer_reset(sscma_client_framer_t *framer);
+
+/**
+ * @brief Expect binary frames or not, kept across sscma_client_framer_reset
+ *
+ * @param[in] framer Framer
+ * @param[in] binary Whether binary frames are expected
+ */
+void sscma_client_framer_set_binary(sscma_client_framer_t *framer, bool binary);
+
+/**
+ * @brief Get the contiguous free space to receive into
+ *
+ * @param[in] framer Framer
+ * @param[out] space Size of the free space, 0 if the buffer is full with a partial frame
+ * @return Where to write the received bytes
+ */
+char *sscma_client_framer_write_ptr(sscma_client_framer_t *framer, size_t *space);
+
+/**
+ * @brief Append bytes written at sscma_client_framer_write_ptr, NUL padding is stripped here unless in binary mode
+ *
+ * @param[in] framer Framer
+ * @param[in] len Number of bytes written
+ * @return Number of bytes kept
+ */
+size_t sscma_client_framer_commit(sscma_client_framer_t *framer, size_t len);
+
+/**
+ * @brief Get the next complete frame
+ *
+ * Only bytes not scanned by a previous call are examined. The previously returned frame is released.
+ *
+ * @param[in] framer Framer
+ * @param[out] frame Next frame
+ * @return Whether a frame was found
+ */
+bool sscma_client_framer_next(sscma_client_framer_t *framer, sscma_client_frame_t *frame);
+
+/**
+ * @brief Copy a frame into contiguous memory and NUL terminate it
+ *
+ * @param[in] frame Frame
+ * @param[out] dst Destination, at least frame->len + 1 bytes
+ */
+void sscma_client_frame_copy(const sscma_client_frame_t *frame, char *dst);
+
+#ifdef __cplusplus
+}
+#endif
@@ -22,10 +22,12 @@ typedef struct
 {
     int cs_gpio_num;   /*!< GPIO used for CS line */
     int sync_gpio_num; /*!< GPIO used for SYNC line */
-    int spi_mode;
-    int wait_delay;                       /*!< Traditional SPI mode (0~3) */
+    int spi_mode;                         /*!< Traditional SPI mode (0~3) */
+    int wait_delay;                       /*!< Milliseconds given to the device before each write, read, available or reset, not before every packet */
     unsigned int pclk_hz;                 /*!< Frequency of pixel clock */
-    size_t trans_queue_depth;             /*!< Size of internal transaction queue */
+    size_t trans_queue_depth;             /*!< Packets in flight, each with its own DMA buffer, 0 for 2 */
+    size_t max_write_len;                 /*!< Payload of a write packet, 0 for 250, must match the firmware */
+    size_t max_read_len;                  /*!< Bytes fetched per read packet, 0 for 4095, must match the firmware */
     void *user_ctx;                       /*!< User private data, passed directly to on_color_trans_done's user_ctx */
     esp_io_expander_handle_t io_expander; /*!< IO expander handle */
     struct
@@ -53,6 +55,15 @@ typedef struct
 
 esp_err_t sscma_client_new_io_spi_bus(sscma_client_spi_bus_handle_t bus, const sscma_client_io_spi_config_t *io_config, sscma_client_io_handle_t *ret_io);
 
+/**
+ * @brief Signal a possible SYNC line change, for SYNC lines read through an IO expander
+ *
+ * @note Call it from the IO expander interrupt handler, it is safe in ISR context
+ *
+ * @param[in] io IO handle, for SPI interface
+ */
+void sscma_client_io_spi_sync_isr(sscma_client_io_handle_t io);
+
 /**
  * @brief Client IO configuration structure, for I2C interface
  *
@@ -83,7 +94,8 @@ esp_err_t sscma_client_new_io_i2c_bus(sscma_client_i2c_bus_handle_t bus, const s
  */
 typedef struct
 {
-    void *user_ctx; /*!< User private data, passed directly to user_ctx */
+    void *user_ctx;            /*!< User private data, passed directly to user_ctx */
+    QueueHandle_t event_queue; /*!< Event queue returned by uart_driver_install, NULL to poll for data */
 } sscma_client_io_uart_config_t;
 
 /**
@@ -152,6 +164,18 @@ esp_err_t sscma_client_io_available(sscma_client_io_handle_t io, size_t *len);
  */
 esp_err_t sscma_client_io_flush(sscma_client_io_handle_t io);
 
+/**
+ * @brief Register a callback invoked when new data becomes available
+ *
+ * @param[in] io IO handle
+ * @param[in] cb Callback, may be invoked from ISR context, NULL to unregister
+ * @param[in] user_ctx User context passed to the callback
+ * @return
+ *          - ESP_ERR_NOT_SUPPORTED if the transport has no data-ready signal
+ *          - ESP_OK                on success
+ */
+esp_err_t sscma_client_io_set_ready_cb(sscma_client_io_handle_t io, sscma_client_io_ready_cb_t cb, void *user_ctx);
+
 #ifdef __cplusplus
 }
 #endif
@@ -26,6 +26,10 @@ typedef struct
     int monitor_task_affinity;            /* SSCMA monitor task pinned to core (-1 is no
                                              affinity) */
     int event_queue_size;                 /* Event queue size */
+    int reply_slab_size;                  /*!< Bytes of a reply slab, replies that fit are taken from the slabs */
+    int reply_slabs;                      /*!< Reply slabs, 0 for none */
+    int reply_large_size;                 /*!< Bytes of a large reply block, 0 for the RX buffer size */
+    int reply_large_blocks;               /*!< Large reply blocks for image replies, 0 to take them from the heap */
     void *user_ctx;                       /* User context */
     esp_io_expander_handle_t io_expander; /*!< IO expander handle */
     struct
@@ -33,13 +37,16 @@ typedef struct
         unsigned int reset_active_high : 1;  /*!< Setting this if the panel reset is
                                                 high level active */
         unsigned int reset_use_expander : 1; /*!< Reset line use IO expander */
+        unsigned int binary_framing : 1;     /*!< Ask for binary INVOKE and SAMPLE events on init,
+                                                JSON is kept if the firmware lacks them */
     } flags;                                 /*!< SSCMA client config flags */
 } sscma_client_config_t;
 
 #define SSCMA_CLIENT_CONFIG_DEFAULT()                                                                                                                                                                  \
     {                                                                                                                                                                                                  \
         .reset_gpio_num = -1, .tx_buffer_size = 4096, .rx_buffer_size = 65536, .process_task_priority = 5, .process_task_stack = 4096, .process_task_affinity = -1, .monitor_task_priority = 4,        \
-        .monitor_task_stack = 10240, .monitor_task_affinity = -1, .event_queue_size = 2, .user_ctx = NULL,                                                                                             \
+        .monitor_task_stack = 10240, .monitor_task_affinity = -1, .event_queue_size = 2, .reply_slab_size = 512, .reply_slabs = 16, .reply_large_size = 0, .reply_large_blocks = 0,                    \
+        .user_ctx = NULL,                                                                                                                                                                              \
         .flags = {                                                                                                                                                                                     \
             .reset_active_high = false,                                                                                                                                                                \
         },                                                                                                                                                                                             \
@@ -61,9 +68,15 @@ esp_err_t sscma_client_new(const sscma_client_io_handle_t io, const sscma_client
 /**
  * @brief Destroy SCCMA client
  *
+ * Every reply taken with sscma_client_reply_retain must be released with sscma_client_reply_clear
+ * before, or from another task within half a second. Replies still held after that keep the reply
+ * pool and the client memory allocated, so releasing them later stays safe, and the client is
+ * stopped but leaked.
+ *
  * @param[in] client SCCMA client handle
  * @return
  *          - ESP_OK on success
+ *          - ESP_ERR_INVALID_STATE if retained replies were not released
  */
 esp_err_t sscma_client_del(sscma_client_handle_t client);
 
@@ -140,6 +153,32 @@ esp_err_t sscma_client_register_callback(sscma_client_handle_t client, const ssc
  */
 void sscma_client_reply_clear(sscma_client_reply_t *reply);
 
+/**
+ * @brief Take another reference to a reply without copying it
+ *
+ * Lets on_event and the request callbacks hand a reply on to another task, the reply they are
+ * given is cleared when they return. Each reference is released with sscma_client_reply_clear,
+ * all of them before the client is deleted.
+ *
+ * @param[in] reply Reply
+ * @param[out] ref Reference sharing data and payload with reply
+ * @return
+ *          - ESP_OK on success
+ *          - ESP_ERR_INVALID_ARG if reply has no data
+ */
+esp_err_t sscma_client_reply_retain(const sscma_client_reply_t *reply, sscma_client_reply_t *ref);
+
+/**
+ * @brief Get the counters of the reply pool
+ *
+ * @param[in] client SCCMA client handle
+ * @param[out] stats Blocks in use and their high water marks, heap fallbacks
+ * @return
+ *          - ESP_OK on success
+ *          - ESP_ERR_INVALID_ARG if parameter is invalid
+ */
+esp_err_t sscma_client_get_pool_stats(sscma_client_handle_t client, sscma_client_pool_stats_t *stats);
+
 /**
  * @brief Send request to SCCMA client
  *
@@ -150,6 +189,24 @@ void sscma_client_reply_clear(sscma_client_reply_t *reply);
  */
 esp_err_t sscma_client_request(sscma_client_handle_t client, const char *cmd, sscma_client_reply_t *reply, bool wait, TickType_t timeout);
 
+/**
+ * @brief Send request to SCCMA client without waiting for the reply
+ *
+ * Up to SSCMA_CLIENT_REQUEST_SLOTS requests can be in flight, a command already in flight is
+ * tagged so each reply reaches its own request.
+ *
+ * @param[in] client SCCMA client handle
+ * @param[in] cmd Command, AT+ prefix and suffix included
+ * @param[in] cb Called from the process task with the reply, or on timeout
+ * @param[in] user_ctx User context passed to cb
+ * @param[in] timeout Ticks to wait for the reply
+ *
+ * @return
+ *          - ESP_OK on success
+ *          - ESP_ERR_NO_MEM if no request slot is free
+ */
+esp_err_t sscma_client_request_async(sscma_client_handle_t client, const char *cmd, sscma_client_request_cb_t cb, void *user_ctx, TickType_t timeout);
+
 /**
  * @brief Get SCCMA client info
  *
@@ -233,6 +290,25 @@ esp_err_t sscma_client_invoke(sscma_client_handle_t client, int times, bool flit
 
 esp_err_t sscma_client_break(sscma_client_handle_t client);
 
+/**
+ * @brief Switch the framing of INVOKE and SAMPLE events
+ *
+ * Binary events carry the results in a compact form and the JPEG as is. They are read with the
+ * same sscma_utils_* functions, only sscma_utils_view_image_from_reply needs JSON framing, and
+ * sscma_utils_view_jpeg_from_reply binary framing. A reset of the client goes back to JSON.
+ *
+ * @note AT+FRAMING is not implemented by released SSCMA firmware, which answers it with the
+ *       unknown command log and so gets ESP_ERR_NOT_SUPPORTED. The RX framing is switched by the
+ *       process task from its next read on, it is safe to call from any task.
+ *
+ * @param[in] client SCCMA client handle
+ * @param[in] binary true for binary events, false for JSON
+ * @return
+ *          - ESP_OK on success
+ *          - ESP_ERR_NOT_SUPPORTED if the firmware does not advertise binary framing
+ */
+esp_err_t sscma_client_set_framing(sscma_client_handle_t client, bool binary);
+
 /**
  * @brief Set iou threshold
  * @param[in] client SCCMA client handle
@@ -362,6 +438,19 @@ esp_err_t sscma_utils_fetch_keypoints_from_reply(const sscma_client_reply_t *rep
  */
 esp_err_t sscma_utils_copy_keypoints_from_reply(const sscma_client_reply_t *reply, sscma_client_keypoint_t *keypoints, int max_keypoints, int *num_keypoints);
 
+/**
+ * Parse an INVOKE or SAMPLE reply in one pass into caller provided storage, without cJSON
+ *
+ * The other utils use the same scanner and only read reply->payload for replies it refuses.
+ *
+ * @param[in] reply sscma client reply
+ * @param[in,out] inference result storage and capacities, see sscma_client_inference_t
+ * @return
+ *    - ESP_OK
+ *    - ESP_ERR_NOT_SUPPORTED if the reply has to be read from reply->payload instead
+ */
+esp_err_t sscma_utils_parse_inference_from_reply(const sscma_client_reply_t *reply, sscma_client_inference_t *inference);
+
 /**
  * Fetch image from sscma client reply
  * @param[in] reply sscma client reply
@@ -383,6 +472,49 @@ esp_err_t sscma_utils_fetch_image_from_reply(const sscma_client_reply_t *reply,
  */
 esp_err_t sscma_utils_copy_image_from_reply(const sscma_client_reply_t *reply, char *image, int max_image_size, int *image_size);
 
+/**
+ * View the base64 image of sscma client reply without copying it
+ *
+ * The image is not kept in reply->payload, it is read in place from reply->data.
+ *
+ * @param[in] reply sscma client reply
+ * @param[out] image base64 image, borrowed from reply and not NUL terminated
+ * @param[out] image_size size of image
+ * @return
+ *    - ESP_OK
+ *    - ESP_FAIL if the reply carries no image
+ *    - ESP_ERR_NOT_SUPPORTED if the reply is a binary frame, whose image is not base64
+ */
+esp_err_t sscma_utils_view_image_from_reply(const sscma_client_reply_t *reply, const char **image, size_t *image_size);
+
+/**
+ * View the JPEG of a binary frame without copying it
+ *
+ * @param[in] reply sscma client reply
+ * @param[out] jpeg JPEG, borrowed from reply
+ * @param[out] jpeg_size size of jpeg
+ * @return
+ *    - ESP_OK
+ *    - ESP_FAIL if the reply carries no image
+ *    - ESP_ERR_NOT_SUPPORTED if the reply is not a binary frame
+ *    - ESP_ERR_INVALID_RESPONSE if the frame is malformed
+ */
+esp_err_t sscma_utils_view_jpeg_from_reply(const sscma_client_reply_t *reply, const uint8_t **jpeg, size_t *jpeg_size);
+
+/**
+ * Decode the base64 image of sscma client reply into a caller buffer, the JPEG of a binary frame is copied as is
+ * @param[in] reply sscma client reply
+ * @param[out] dst decoded image, JPEG
+ * @param[in] cap size of dst
+ * @param[out] len size of decoded image
+ * @return
+ *    - ESP_OK
+ *    - ESP_FAIL if the reply carries no image
+ *    - ESP_ERR_INVALID_SIZE if dst is too small
+ *    - ESP_ERR_INVALID_RESPONSE if the image is not valid base64
+ */
+esp_err_t sscma_utils_decode_image_into(const sscma_client_reply_t *reply, uint8_t *dst, size_t cap, size_t *len);
+
 /**
  * Start ota
  * @param[in] client SCCMA client handle
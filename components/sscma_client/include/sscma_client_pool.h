@@ -0,0 +1,123 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Pool of reply buffers
+ *
+ * Replies are taken from two classes of fixed size blocks allocated once: small slabs for
+ * responses, logs and events without an image, and large blocks for image replies. A reply that
+ * fits neither, or finds its class used up, falls back to the heap. Every buffer carries a
+ * reference count, so a reply can be handed on to other tasks without being copied and goes back
+ * to the pool when its last reference is released. Allocation and release are lock free.
+ */
+typedef struct
+{
+    size_t slab_size;  /*!< Bytes of a slab */
+    int slabs;         /*!< Number of slabs, 0 for none */
+    size_t large_size; /*!< Bytes of a large block */
+    int large_blocks;  /*!< Number of large blocks, 0 for none */
+} sscma_client_pool_config_t;
+
+/**
+ * @brief Pool counters
+ */
+typedef struct
+{
+    uint32_t allocs;            /*!< Buffers handed out */
+    uint32_t heap_fallbacks;    /*!< Of which taken from the heap, too large or their class used up */
+    uint16_t slabs_in_use;      /*!< Slabs held now */
+    uint16_t slabs_high_water;  /*!< Most slabs held at once */
+    uint16_t large_in_use;      /*!< Large blocks held now */
+    uint16_t large_high_water;  /*!< Most large blocks held at once */
+    uint16_t heap_in_use;       /*!< Heap buffers held now */
+    uint16_t heap_high_water;   /*!< Most heap buffers held at once */
+} sscma_client_pool_stats_t;
+
+typedef struct
+{
+    char *storage;   /*!< Blocks of the class, NULL if it has none */
+    size_t size;     /*!< Bytes of a block, header excluded */
+    size_t stride;   /*!< Bytes between blocks */
+    int count;       /*!< Number of blocks */
+    uint32_t *used;  /*!< One bit per block, changed atomically */
+    uint32_t in_use; /*!< Blocks held */
+    uint32_t high;   /*!< Most blocks held at once */
+} sscma_client_pool_class_t;
+
+typedef struct
+{
+    sscma_client_pool_class_t slabs; /*!< Small buffers */
+    sscma_client_pool_class_t large; /*!< Image replies */
+    uint32_t allocs;                 /*!< Buffers handed out */
+    uint32_t heap_fallbacks;         /*!< Buffers taken from the heap */
+    uint32_t heap_in_use;            /*!< Heap buffers held */
+    uint32_t heap_high;              /*!< Most heap buffers held at once */
+} sscma_client_pool_t;
+
+/**
+ * @brief Allocate the blocks of a pool
+ *
+ * @param[in] pool Pool
+ * @param[in] config Sizes and counts of both classes
+ * @return Whether the blocks could be allocated, the pool is left empty otherwise
+ */
+bool sscma_client_pool_init(sscma_client_pool_t *pool, const sscma_client_pool_config_t *config);
+
+/**
+ * @brief Free the blocks of a pool, every buffer must have been released
+ *
+ * @param[in] pool Pool
+ */
+void sscma_client_pool_deinit(sscma_client_pool_t *pool);
+
+/**
+ * @brief Take a buffer with one reference
+ *
+ * @param[in] pool Pool
+ * @param[in] len Bytes needed
+ * @return The buffer, NULL if out of memory
+ */
+char *sscma_client_pool_alloc(sscma_client_pool_t *pool, size_t len);
+
+/**
+ * @brief Add a reference to a buffer of sscma_client_pool_alloc
+ *
+ * @param[in] data Buffer
+ * @return data
+ */
+char *sscma_client_pool_retain(char *data);
+
+/**
+ * @brief Drop a reference to a buffer of sscma_client_pool_alloc, freeing it with the last one
+ *
+ * @param[in] data Buffer
+ * @return Whether this was the last reference
+ */
+bool sscma_client_pool_release(char *data);
+
+/**
+ * @brief Count the buffers handed out and not released yet
+ *
+ * @param[in] pool Pool
+ * @return Slabs, large blocks and heap buffers still referenced
+ */
+uint32_t sscma_client_pool_in_use(sscma_client_pool_t *pool);
+
+/**
+ * @brief Get the pool counters
+ *
+ * @param[in] pool Pool
+ * @param[out] stats Counters
+ */
+void sscma_client_pool_get_stats(sscma_client_pool_t *pool, sscma_client_pool_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
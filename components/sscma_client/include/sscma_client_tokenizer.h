@@ -0,0 +1,95 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define SSCMA_CLIENT_MODEL_KEYPOINTS_MAX 80
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct
+{
+    uint16_t x;
+    uint16_t y;
+    uint16_t w;
+    uint16_t h;
+    uint8_t score;
+    uint8_t target;
+} sscma_client_box_t;
+
+typedef struct
+{
+    uint8_t target;
+    uint8_t score;
+} sscma_client_class_t;
+
+typedef struct
+{
+    uint16_t x;
+    uint16_t y;
+    uint16_t z;
+    uint8_t score;
+    uint8_t target;
+} sscma_client_point_t;
+
+typedef struct
+{
+    sscma_client_box_t box;
+    uint8_t points_num;
+    sscma_client_point_t points[SSCMA_CLIENT_MODEL_KEYPOINTS_MAX];
+} sscma_client_keypoint_t;
+
+/**
+ * @brief Fields of an INVOKE or SAMPLE reply
+ *
+ * The result arrays are provided by the caller and may be NULL with a capacity of 0. The num_ fields
+ * count the entries in the reply, of which only the first max_ ones are stored. Strings point into
+ * the scanned reply and are not NUL terminated. Numbers that are missing or not numbers read as
+ * INT_MIN, like with the cJSON helpers.
+ */
+typedef struct
+{
+    int type;                           /*!< Reply type */
+    int code;                           /*!< Reply code */
+    const char *name;                   /*!< Reply name, NULL if missing */
+    size_t name_len;                    /*!< Length of name */
+    int count;                          /*!< Frame counter */
+    int width;                          /*!< Resolution width, 0 if missing */
+    int height;                         /*!< Resolution height, 0 if missing */
+    const char *image;                  /*!< Base64 image, NULL if missing */
+    size_t image_len;                   /*!< Length of image */
+    bool image_raw;                     /*!< Whether image is the JPEG itself, from a binary frame */
+    sscma_client_box_t *boxes;          /*!< Box storage */
+    int max_boxes;                      /*!< Capacity of boxes */
+    int num_boxes;                      /*!< Boxes in the reply */
+    sscma_client_class_t *classes;      /*!< Class storage */
+    int max_classes;                    /*!< Capacity of classes */
+    int num_classes;                    /*!< Classes in the reply */
+    sscma_client_point_t *points;       /*!< Point storage */
+    int max_points;                     /*!< Capacity of points */
+    int num_points;                     /*!< Points in the reply */
+    sscma_client_keypoint_t *keypoints; /*!< Keypoint storage */
+    int max_keypoints;                  /*!< Capacity of keypoints */
+    int num_keypoints;                  /*!< Keypoints in the reply */
+} sscma_client_inference_t;
+
+/**
+ * @brief Scan an INVOKE or SAMPLE reply in a single pass without allocating
+ *
+ * Only the fields of the inference schema are extracted, everything else is skipped. Replies this
+ * scanner does not handle, such as an image with escapes, are refused so the caller can fall back
+ * to cJSON.
+ *
+ * @param[in] json Reply, surrounding whitespace included
+ * @param[in] len Length of the reply
+ * @param[in,out] inference Storage set up by the caller, filled with the fields found
+ * @return Whether the reply is a well formed JSON object the scanner handles
+ */
+bool sscma_client_tokenize_inference(const char *json, size_t len, sscma_client_inference_t *inference);
+
+#ifdef __cplusplus
+}
+#endif
@@ -4,6 +4,7 @@
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/queue.h"
+#include "freertos/semphr.h"
 #include "freertos/event_groups.h"
 
 #include "cJSON.h"
@@ -12,11 +13,14 @@
 
 #include "sscma_client_io_interface.h"
 #include "sscma_client_flasher_interface.h"
+#include "sscma_client_framer.h"
+#include "sscma_client_pool.h"
+#include "sscma_client_tokenizer.h"
 
 #include "esp_io_expander.h"
 
 #define SSCMA_CLIENT_MODEL_MAX_CLASSES   80
-#define SSCMA_CLIENT_MODEL_KEYPOINTS_MAX 80
+#define SSCMA_CLIENT_REQUEST_SLOTS       8 // commands in flight at once, a power of two
 
 #ifdef __cplusplus
 extern "C" {
@@ -28,6 +32,9 @@ typedef struct sscma_client_flasher_t *sscma_client_flasher_handle_t; /*!< Type
 
 /**
  * @brief Reply message
+ *
+ * data comes from the reply pool of the client and is shared with the copies made by
+ * sscma_client_reply_retain, every copy is released with sscma_client_reply_clear.
  */
 typedef struct
 {
@@ -36,14 +43,31 @@ typedef struct
     size_t len;
 } sscma_client_reply_t;
 
+/**
+ * @brief Completion callback of an asynchronous request
+ * @param[in] client SCCMA client handle
+ * @param[in] err ESP_OK, the error of the reply code, or ESP_ERR_TIMEOUT
+ * @param[in] reply Reply message, NULL on timeout, cleared after the callback returns
+ * @param[in] user_ctx User context
+ * @return None
+ */
+typedef void (*sscma_client_request_cb_t)(sscma_client_handle_t client, esp_err_t err, const sscma_client_reply_t *reply, void *user_ctx);
+
 /**
  * @brief Request message
  */
 typedef struct
 {
-    char cmd[32];
-    QueueHandle_t reply;
-    ListItem_t item;
+    char cmd[32];                  /* !< Command name as echoed by the reply, tag excluded */
+    uint32_t hash;                 /* !< Hash of cmd */
+    uint16_t tag;                  /* !< Tag sent as AT+<tag>@<cmd>, 0 if sent untagged */
+    uint8_t state;                 /* !< Free, pending, sent or done */
+    sscma_client_reply_t reply;    /* !< Reply, once done */
+    sscma_client_request_cb_t cb;  /* !< Completion callback, NULL for a blocking request */
+    void *user_ctx;                /* !< User context of cb */
+    TickType_t deadline;           /* !< Tick count an asynchronous request times out at */
+    SemaphoreHandle_t done;        /* !< Given when a blocking request is done */
+    StaticSemaphore_t done_buffer; /* !< Storage of done */
 } sscma_client_request_t;
 
 /**
@@ -78,38 +102,6 @@ typedef struct
     char *opt_detail;
 } sscma_client_sensor_t;
 
-typedef struct
-{
-    uint16_t x;
-    uint16_t y;
-    uint16_t w;
-    uint16_t h;
-    uint8_t score;
-    uint8_t target;
-} sscma_client_box_t;
-
-typedef struct
-{
-    uint8_t target;
-    uint8_t score;
-} sscma_client_class_t;
-
-typedef struct
-{
-    uint16_t x;
-    uint16_t y;
-    uint16_t z;
-    uint8_t score;
-    uint8_t target;
-} sscma_client_point_t;
-
-typedef struct
-{
-    sscma_client_box_t box;
-    uint8_t points_num;
-    sscma_client_point_t points[SSCMA_CLIENT_MODEL_KEYPOINTS_MAX];
-} sscma_client_keypoint_t;
-
 /**
  * @brief Callback function of SCCMA client
  * @param[in] client SCCMA client handle
@@ -138,6 +130,7 @@ struct sscma_client_t
     int reset_gpio_num;                    /* !< GPIO number of reset pin */
     bool reset_level;                      /* !< Level of reset pin */
     bool inited;                           /* !< Whether inited */
+    bool binary_framing;                   /* !< Whether binary framing is negotiated on init */
     sscma_client_info_t info;              /* !< Info */
     sscma_client_model_t model;            /* !< Model */
     sscma_client_reply_cb_t on_connect;    /* !< Callback function */
@@ -158,19 +151,26 @@ struct sscma_client_t
     struct
     {
         TaskHandle_t handle;
+        bool notify; /* !< Woken by the IO data-ready callback instead of polling */
 #ifdef CONFIG_SSCMA_MONITOR_TASK_STACK_ALLOC_EXTERNAL
         StaticTask_t *task;
         StackType_t *stack;
 #endif
     } process_task;
+    sscma_client_framer_t rx_buffer; /* !< RX buffer, split into replies, owned by the process task */
+    bool rx_binary;                  /* !< Framing the process task applies to rx_buffer from its next read on, under request_lock */
     struct
     {
         char *data;            /* !< Data buffer */
         size_t len;            /* !< Data length */
         size_t pos;            /* !< Data position */
-    } rx_buffer, tx_buffer;    /* !< RX and TX buffer */
+    } tx_buffer;               /* !< TX buffer */
     QueueHandle_t reply_queue; /* !< Queue for reply message */
-    List_t *request_list;      /* !< Request list */
+    sscma_client_pool_t reply_pool; /* !< Buffers of the replies */
+    sscma_client_request_t requests[SSCMA_CLIENT_REQUEST_SLOTS]; /* !< Requests in flight */
+    uint16_t request_seq;                                       /* !< Last tag used */
+    SemaphoreHandle_t request_lock;                             /* !< Protects requests */
+    SemaphoreHandle_t tx_lock;                                  /* !< Serializes commands written through tx_buffer */
 };
 
 #ifdef __cplusplus
@@ -9,6 +9,15 @@ extern "C" {
 
 typedef struct sscma_client_io_t sscma_client_io_t; /*!< Type of SSCMA client IO */
 
+/**
+ * @brief Data-ready callback, may be invoked from ISR context
+ *
+ * @param[in] io SCCMA client IO handle
+ * @param[in] user_ctx User context passed to set_ready_cb
+ * @return Whether a higher priority task has been woken up by this function
+ */
+typedef bool (*sscma_client_io_ready_cb_t)(sscma_client_io_t *io, void *user_ctx);
+
 /**
  * @brief SSCMA IO interface
  */
@@ -75,6 +84,20 @@ struct sscma_client_io_t
      *          - ESP_OK
      */
     esp_err_t (*flush)(sscma_client_io_t *io);
+
+    /**
+     * @brief Register a callback invoked when new data becomes available
+     *
+     * @note Optional, transports without a data-ready signal leave it NULL and are polled
+     *
+     * @param[in] io IO handle
+     * @param[in] cb Callback, NULL to unregister
+     * @param[in] user_ctx User context passed to the callback
+     * @return
+     *          - ESP_ERR_NOT_SUPPORTED if the transport has no data-ready signal
+     *          - ESP_OK                on success
+     */
+    esp_err_t (*set_ready_cb)(sscma_client_io_t *io, sscma_client_io_ready_cb_t cb, void *user_ctx);
 };
 
 #ifdef __cplusplus
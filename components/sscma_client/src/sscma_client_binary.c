@@ -0,0 +1,211 @@
+#include <limits.h>
+#include <string.h>
+#include "sscma_client_binary.h"
+
+typedef struct
+{
+    const uint8_t *p;
+    const uint8_t *end;
+} reader_t;
+
+static inline uint16_t get_u16(const uint8_t *p)
+{
+    return (uint16_t)(p[0] | p[1] << 8);
+}
+
+static inline uint32_t get_u32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+static inline bool take(reader_t *r, size_t len, const uint8_t **out)
+{
+    if ((size_t)(r->end - r->p) < len)
+    {
+        return false;
+    }
+    *out = r->p;
+    r->p += len;
+    return true;
+}
+
+static void load_box(sscma_client_box_t *box, const uint8_t *p)
+{
+    box->x = get_u16(p);
+    box->y = get_u16(p + 2);
+    box->w = get_u16(p + 4);
+    box->h = get_u16(p + 6);
+    box->score = p[8];
+    box->target = p[9];
+}
+
+static void load_point(sscma_client_point_t *point, const uint8_t *p)
+{
+    point->x = get_u16(p);
+    point->y = get_u16(p + 2);
+    point->z = get_u16(p + 4);
+    point->score = p[6];
+    point->target = p[7];
+}
+
+// Records of a fixed size, all are counted and as many as fit are stored
+static bool load_records(const uint8_t *value, size_t len, size_t record_len, void *items, size_t item_size, int max, int *num, void (*load)(void *, const uint8_t *))
+{
+    if (len % record_len != 0)
+    {
+        return false;
+    }
+    *num = len / record_len;
+    for (int i = 0; i < *num && i < max && items != NULL; i++)
+    {
+        load((uint8_t *)items + i * item_size, value + i * record_len);
+    }
+    return true;
+}
+
+static void load_box_item(void *item, const uint8_t *p)
+{
+    load_box((sscma_client_box_t *)item, p);
+}
+
+static void load_class_item(void *item, const uint8_t *p)
+{
+    sscma_client_class_t *class = (sscma_client_class_t *)item;
+    class->target = p[0];
+    class->score = p[1];
+}
+
+static void load_point_item(void *item, const uint8_t *p)
+{
+    load_point((sscma_client_point_t *)item, p);
+}
+
+static bool load_keypoints(const uint8_t *value, size_t len, sscma_client_keypoint_t *keypoints, int max, int *num)
+{
+    reader_t r = { .p = value, .end = value + len };
+    const uint8_t *p;
+
+    *num = 0;
+    while (r.p < r.end)
+    {
+        if (!take(&r, SSCMA_CLIENT_BINARY_BOX_LEN + 1, &p))
+        {
+            return false;
+        }
+        int points = p[SSCMA_CLIENT_BINARY_BOX_LEN];
+        const uint8_t *q;
+        if (!take(&r, (size_t)points * SSCMA_CLIENT_BINARY_POINT_LEN, &q))
+        {
+            return false;
+        }
+        if (keypoints != NULL && *num < max)
+        {
+            sscma_client_keypoint_t *keypoint = &keypoints[*num];
+            load_box(&keypoint->box, p);
+            keypoint->points_num = points > SSCMA_CLIENT_MODEL_KEYPOINTS_MAX ? SSCMA_CLIENT_MODEL_KEYPOINTS_MAX : points;
+            for (int i = 0; i < keypoint->points_num; i++)
+            {
+                load_point(&keypoint->points[i], q + i * SSCMA_CLIENT_BINARY_POINT_LEN);
+            }
+        }
+        (*num)++;
+    }
+    return true;
+}
+
+bool sscma_client_binary_decode_inference(const char *frame, size_t len, sscma_client_inference_t *inference)
+{
+    const uint8_t *p;
+
+    inference->type = INT_MIN;
+    inference->code = INT_MIN;
+    inference->name = NULL;
+    inference->name_len = 0;
+    inference->count = INT_MIN;
+    inference->width = 0;
+    inference->height = 0;
+    inference->image = NULL;
+    inference->image_len = 0;
+    inference->image_raw = false;
+    inference->num_boxes = 0;
+    inference->num_classes = 0;
+    inference->num_points = 0;
+    inference->num_keypoints = 0;
+
+    if (!sscma_client_binary_is_frame(frame, len))
+    {
+        return false;
+    }
+    reader_t r = { .p = (const uint8_t *)frame + SSCMA_CLIENT_BINARY_HEADER_LEN, .end = (const uint8_t *)frame + len };
+    if (get_u32((const uint8_t *)frame + 2) != len - SSCMA_CLIENT_BINARY_HEADER_LEN || !take(&r, 4, &p))
+    {
+        return false;
+    }
+    inference->type = p[0];
+    inference->code = (int16_t)get_u16(p + 1);
+    inference->name_len = p[3];
+    if (!take(&r, inference->name_len, &p))
+    {
+        return false;
+    }
+    inference->name = (const char *)p;
+
+    while (r.p < r.end)
+    {
+        const uint8_t *value;
+        if (!take(&r, 5, &p))
+        {
+            return false;
+        }
+        uint8_t tag = p[0];
+        size_t value_len = get_u32(p + 1);
+        if (!take(&r, value_len, &value))
+        {
+            return false;
+        }
+
+        bool ok = true;
+        switch (tag)
+        {
+            case SSCMA_CLIENT_BINARY_COUNT:
+                ok = value_len == 4;
+                inference->count = ok ? (int)get_u32(value) : INT_MIN;
+                break;
+            case SSCMA_CLIENT_BINARY_RESOLUTION:
+                ok = value_len == 4;
+                if (ok)
+                {
+                    inference->width = get_u16(value);
+                    inference->height = get_u16(value + 2);
+                }
+                break;
+            case SSCMA_CLIENT_BINARY_BOXES:
+                ok = load_records(value, value_len, SSCMA_CLIENT_BINARY_BOX_LEN, inference->boxes, sizeof(sscma_client_box_t), inference->max_boxes, &inference->num_boxes,
+                    load_box_item);
+                break;
+            case SSCMA_CLIENT_BINARY_CLASSES:
+                ok = load_records(value, value_len, SSCMA_CLIENT_BINARY_CLASS_LEN, inference->classes, sizeof(sscma_client_class_t), inference->max_classes,
+                    &inference->num_classes, load_class_item);
+                break;
+            case SSCMA_CLIENT_BINARY_POINTS:
+                ok = load_records(value, value_len, SSCMA_CLIENT_BINARY_POINT_LEN, inference->points, sizeof(sscma_client_point_t), inference->max_points,
+                    &inference->num_points, load_point_item);
+                break;
+            case SSCMA_CLIENT_BINARY_KEYPOINTS:
+                ok = load_keypoints(value, value_len, inference->keypoints, inference->max_keypoints, &inference->num_keypoints);
+                break;
+            case SSCMA_CLIENT_BINARY_IMAGE:
+                inference->image = (const char *)value;
+                inference->image_len = value_len;
+                inference->image_raw = true;
+                break;
+            default:
+                break; // PERF and newer records
+        }
+        if (!ok)
+        {
+            return false;
+        }
+    }
+    return true;
+}
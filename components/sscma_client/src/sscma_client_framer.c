@@ -0,0 +1,268 @@
+#include <string.h>
+#include "sscma_client_binary.h"
+#include "sscma_client_framer.h"
+
+static inline size_t framer_index(const sscma_client_framer_t *framer, size_t offset)
+{
+    size_t index = framer->tail + offset;
+    return index >= framer->size ? index - framer->size : index;
+}
+
+static inline char framer_byte(const sscma_client_framer_t *framer, size_t offset)
+{
+    return framer->data[framer_index(framer, offset)];
+}
+
+static void framer_drop(sscma_client_framer_t *framer, size_t len)
+{
+    if (len == 0)
+    {
+        return;
+    }
+    framer->len -= len;
+    framer->scanned -= len;
+    framer->start = framer->in_frame ? framer->start - len : 0;
+    // restart at the beginning of the storage when empty, so reads are not split by the wrap
+    framer->tail = framer->len ? framer_index(framer, len) : 0;
+}
+
+// Offset just past the last byte before offset that is not NUL padding, which binary mode keeps
+static size_t framer_last(const sscma_client_framer_t *framer, size_t offset)
+{
+    while (offset > 0 && framer_byte(framer, offset - 1) == '\0')
+    {
+        offset--;
+    }
+    return offset;
+}
+
+// Squeeze the NUL padding out of the JSON frame at tail, moving its bytes toward its end
+static void framer_compact(sscma_client_framer_t *framer)
+{
+    size_t out = framer->scanned;
+    for (size_t in = framer->scanned; in > 0; in--)
+    {
+        char c = framer_byte(framer, in - 1);
+        if (c != '\0' && --out != in - 1)
+        {
+            framer->data[framer_index(framer, out)] = c;
+        }
+    }
+    framer_drop(framer, out);
+}
+
+// Find the end of a binary frame, whose body is not scanned
+static bool framer_binary(sscma_client_framer_t *framer, char *prev)
+{
+    if (framer->frame_len == 0)
+    {
+        if (framer->len - framer->start < SSCMA_CLIENT_BINARY_HEADER_LEN)
+        {
+            framer->scanned = framer->len;
+            return false;
+        }
+        size_t body = 0;
+        for (int i = 3; i >= 0; i--)
+        {
+            body = body << 8 | (uint8_t)framer_byte(framer, framer->start + 2 + i);
+        }
+        if (body > framer->size - SSCMA_CLIENT_BINARY_HEADER_LEN)
+        {
+            // cannot be held, so not a frame, scan again past the prefix
+            framer->in_frame = false;
+            framer->in_binary = false;
+            framer->scanned = framer->start + 2;
+            framer->start = 0;
+            *prev = (char)SSCMA_CLIENT_BINARY_MAGIC;
+            return false;
+        }
+        framer->frame_len = SSCMA_CLIENT_BINARY_HEADER_LEN + body;
+    }
+    if (framer->len - framer->start < framer->frame_len)
+    {
+        framer->scanned = framer->len;
+        return false;
+    }
+    framer->scanned = framer->start + framer->frame_len;
+    return true;
+}
+
+void sscma_client_framer_init(sscma_client_framer_t *framer, char *data, size_t size)
+{
+    framer->data = data;
+    framer->size = size;
+    framer->binary = false;
+    sscma_client_framer_reset(framer);
+}
+
+void sscma_client_framer_set_binary(sscma_client_framer_t *framer, bool binary)
+{
+    framer->binary = binary;
+}
+
+void sscma_client_framer_reset(sscma_client_framer_t *framer)
+{
+    framer->tail = 0;
+    framer->len = 0;
+    framer->scanned = 0;
+    framer->start = 0;
+    framer->consumed = 0;
+    framer->in_frame = false;
+    framer->in_binary = false;
+    framer->frame_len = 0;
+}
+
+char *sscma_client_framer_write_ptr(sscma_client_framer_t *framer, size_t *space)
+{
+    framer_drop(framer, framer->consumed);
+    framer->consumed = 0;
+
+    size_t head = framer_index(framer, framer->len);
+    if (framer->len == framer->size)
+    {
+        *space = 0;
+    }
+    else if (head >= framer->tail)
+    {
+        *space = framer->size - head;
+    }
+    else
+    {
+        *space = framer->tail - head;
+    }
+    return framer->data + head;
+}
+
+size_t sscma_client_framer_commit(sscma_client_framer_t *framer, size_t len)
+{
+    char *begin = framer->data + framer_index(framer, framer->len);
+    char *end = begin + len;
+    char *out = framer->binary ? NULL : memchr(begin, '\0', len);
+
+    if (out != NULL)
+    {
+        for (const char *in = out + 1; in < end; in++)
+        {
+            if (*in != '\0')
+            {
+                *out++ = *in;
+            }
+        }
+        len = out - begin;
+    }
+    framer->len += len;
+    return len;
+}
+
+bool sscma_client_framer_next(sscma_client_framer_t *framer, sscma_client_frame_t *frame)
+{
+    framer_drop(framer, framer->consumed);
+    framer->consumed = 0;
+
+    size_t last = framer_last(framer, framer->scanned);
+    char prev = last ? framer_byte(framer, last - 1) : '\0';
+    bool found = false;
+
+    while (!found && framer->scanned < framer->len)
+    {
+        if (framer->in_binary)
+        {
+            found = framer_binary(framer, &prev);
+            continue;
+        }
+
+        size_t index = framer_index(framer, framer->scanned);
+        size_t count = framer->len - framer->scanned;
+        if (count > framer->size - index)
+        {
+            count = framer->size - index; // up to the wrap
+        }
+
+        const char *p = framer->data + index;
+        size_t i = 0;
+        for (; i < count; i++)
+        {
+            char c = p[i];
+            if (prev == '\r' && c == '{')
+            {
+                // a frame cut short is dropped when the next one starts
+                framer->in_frame = true;
+                framer->start = framer_last(framer, framer->scanned + i) - 1;
+            }
+            else if (prev == '\r' && (uint8_t)c == SSCMA_CLIENT_BINARY_MAGIC && framer->binary && framer_byte(framer, framer->scanned + i - 1) == '\r')
+            {
+                framer->in_frame = true;
+                framer->in_binary = true;
+                framer->frame_len = 0;
+                framer->start = framer->scanned + i - 1;
+                i++;
+                break;
+            }
+            else if (prev == '}' && c == '\n' && framer->in_frame)
+            {
+                found = true;
+                i++;
+                break;
+            }
+            if (c != '\0')
+            {
+                prev = c; // NUL padding only reaches the scan in binary mode, it is skipped over
+            }
+        }
+        framer->scanned += i;
+    }
+
+    if (!found)
+    {
+        if (framer->in_frame)
+        {
+            framer_drop(framer, framer->start);
+        }
+        else
+        {
+            // everything scanned is garbage, except a trailing '\r' that may start a prefix
+            framer_drop(framer, prev == '\r' ? framer_last(framer, framer->scanned) - 1 : framer->scanned);
+        }
+        return false;
+    }
+
+    // the frame now spans from tail to the scan position
+    framer_drop(framer, framer->start);
+    framer->in_frame = false;
+    framer->start = 0;
+    if (framer->binary && !framer->in_binary)
+    {
+        framer_compact(framer);
+    }
+    framer->in_binary = false;
+    framer->frame_len = 0;
+    framer->consumed = framer->scanned;
+
+    size_t len = framer->scanned;
+    size_t first = framer->size - framer->tail;
+    frame->len = len;
+    frame->part[0] = framer->data + framer->tail;
+    if (len <= first)
+    {
+        frame->part_len[0] = len;
+        frame->part[1] = NULL;
+        frame->part_len[1] = 0;
+    }
+    else
+    {
+        frame->part_len[0] = first;
+        frame->part[1] = framer->data;
+        frame->part_len[1] = len - first;
+    }
+    return true;
+}
+
+void sscma_client_frame_copy(const sscma_client_frame_t *frame, char *dst)
+{
+    memcpy(dst, frame->part[0], frame->part_len[0]);
+    if (frame->part_len[1])
+    {
+        memcpy(dst + frame->part_len[0], frame->part[1], frame->part_len[1]);
+    }
+    dst[frame->len] = '\0';
+}
@@ -4,7 +4,7 @@
 
 static const char *TAG = "sscma_client.io";
 
-esp_err_t sscma_client_io_del(sscma_client_io_t *io)
+esp_err_t sscma_client_del_io(sscma_client_io_t *io)
 {
     ESP_RETURN_ON_FALSE(io, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
     ESP_RETURN_ON_FALSE(io->del, ESP_ERR_NOT_SUPPORTED, TAG, "del not supported");
@@ -41,3 +41,13 @@ esp_err_t sscma_client_io_flush(sscma_client_io_t *io)
     ESP_RETURN_ON_FALSE(io->flush, ESP_ERR_NOT_SUPPORTED, TAG, "flush not supported");
     return io->flush(io);
 }
+
+esp_err_t sscma_client_io_set_ready_cb(sscma_client_io_t *io, sscma_client_io_ready_cb_t cb, void *user_ctx)
+{
+    ESP_RETURN_ON_FALSE(io, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    if (io->set_ready_cb == NULL)
+    {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    return io->set_ready_cb(io, cb, user_ctx);
+}
@@ -14,6 +14,7 @@
 #include "sscma_client_io.h"
 #include "driver/spi_master.h"
 #include "driver/gpio.h"
+#include "esp_heap_caps.h"
 #include "esp_log.h"
 #include "esp_check.h"
 
@@ -23,10 +24,12 @@ static const char *TAG = "sscma_client.io.spi";
 #define MAX_PL_LEN   (uint8_t)250
 #define CHECKSUM_LEN (uint8_t)2
 
-#define PACKET_SIZE (uint16_t)(HEADER_LEN + MAX_PL_LEN + CHECKSUM_LEN)
-
 #define MAX_RECIEVE_SIZE (uint16_t)4095
 
+#define MAX_LEN_FIELD (size_t)0xFFFF // the length field of a packet is 16 bits
+
+#define DEFAULT_QUEUE_DEPTH 2
+
 #define FEATURE_TRANSPORT               0x10
 #define FEATURE_TRANSPORT_CMD_READ      0x01
 #define FEATURE_TRANSPORT_CMD_WRITE     0x02
@@ -40,6 +43,14 @@ static esp_err_t client_io_spi_write(sscma_client_io_t *io, const void *data, si
 static esp_err_t client_io_spi_read(sscma_client_io_t *io, void *data, size_t len);
 static esp_err_t client_io_spi_available(sscma_client_io_t *io, size_t *len);
 static esp_err_t client_io_spi_flush(sscma_client_io_t *io);
+static esp_err_t client_io_spi_set_ready_cb(sscma_client_io_t *io, sscma_client_io_ready_cb_t cb, void *user_ctx);
+
+typedef struct
+{
+    uint8_t *buffer;          // DMA capable packet: header, payload and checksum
+    spi_transaction_t *trans; // Transactions of the packet and of the data read after it
+    size_t num_trans;         // Transactions queued and not yet collected
+} sscma_client_io_spi_slot_t;
 
 typedef struct
 {
@@ -51,9 +62,41 @@ typedef struct
     void *user_ctx;                       // User context
     esp_io_expander_handle_t io_expander; // IO expander
     SemaphoreHandle_t lock;               // Lock
-    uint8_t buffer[PACKET_SIZE];
+    sscma_client_io_ready_cb_t ready_cb;  // Data-ready callback, driven by the SYNC line
+    void *ready_ctx;                      // Data-ready callback context
+    size_t max_write_len;                 // Payload of a write packet
+    size_t max_read_len;                  // Bytes fetched by a read packet
+    size_t packet_size;                   // Header, payload and checksum
+    size_t num_slots;                     // Packets in flight
+    size_t next_slot;                     // Slot used next, the oldest one in flight
+    sscma_client_io_spi_slot_t *slots;    // Packet slots, used round robin
 } sscma_client_io_spi_t;
 
+static void client_io_spi_sync_isr(void *arg)
+{
+    sscma_client_io_spi_t *spi_client_io = (sscma_client_io_spi_t *)arg;
+    sscma_client_io_ready_cb_t cb = spi_client_io->ready_cb;
+    if (cb && cb(&spi_client_io->base, spi_client_io->ready_ctx))
+    {
+        portYIELD_FROM_ISR();
+    }
+}
+
+static void client_io_spi_free_slots(sscma_client_io_spi_t *spi_client_io)
+{
+    if (spi_client_io->slots == NULL)
+    {
+        return;
+    }
+    for (size_t i = 0; i < spi_client_io->num_slots; i++)
+    {
+        free(spi_client_io->slots[i].buffer);
+        free(spi_client_io->slots[i].trans);
+    }
+    free(spi_client_io->slots);
+    spi_client_io->slots = NULL;
+}
+
 esp_err_t sscma_client_new_io_spi_bus(sscma_client_spi_bus_handle_t bus, const sscma_client_io_spi_config_t *io_config, sscma_client_io_handle_t *ret_io)
 {
 #if CONFIG_SSCMA_ENABLE_DEBUG_LOG
@@ -65,12 +108,36 @@ esp_err_t sscma_client_new_io_spi_bus(sscma_client_spi_bus_handle_t bus, const s
     spi_client_io = (sscma_client_io_spi_t *)calloc(1, sizeof(sscma_client_io_spi_t));
     ESP_GOTO_ON_FALSE(spi_client_io, ESP_ERR_NO_MEM, err, TAG, "no mem for spi client io");
 
+    spi_client_io->max_write_len = io_config->max_write_len ? io_config->max_write_len : MAX_PL_LEN;
+    spi_client_io->max_read_len = io_config->max_read_len ? io_config->max_read_len : MAX_RECIEVE_SIZE;
+    spi_client_io->num_slots = io_config->trans_queue_depth ? io_config->trans_queue_depth : DEFAULT_QUEUE_DEPTH;
+    ESP_GOTO_ON_FALSE(spi_client_io->max_write_len <= MAX_LEN_FIELD && spi_client_io->max_read_len <= MAX_LEN_FIELD, ESP_ERR_INVALID_ARG, err, TAG, "packet size too large");
+    spi_client_io->packet_size = HEADER_LEN + spi_client_io->max_write_len + CHECKSUM_LEN;
+
+    size_t max_trans_bytes = 0;
+    ESP_GOTO_ON_ERROR(spi_bus_get_max_transaction_len((spi_host_device_t)bus, &max_trans_bytes), err, TAG, "get spi max transaction len failed");
+    spi_client_io->spi_trans_max_bytes = max_trans_bytes;
+    ESP_LOGI(TAG, "spi max trans bytes: %d", spi_client_io->spi_trans_max_bytes);
+
+    // a packet and the data read after it are split into transactions of at most the bus limit
+    size_t trans_per_slot = (spi_client_io->packet_size + max_trans_bytes - 1) / max_trans_bytes + (spi_client_io->max_read_len + max_trans_bytes - 1) / max_trans_bytes;
+
+    spi_client_io->slots = (sscma_client_io_spi_slot_t *)calloc(spi_client_io->num_slots, sizeof(sscma_client_io_spi_slot_t));
+    ESP_GOTO_ON_FALSE(spi_client_io->slots, ESP_ERR_NO_MEM, err, TAG, "no mem for packet slots");
+    for (size_t i = 0; i < spi_client_io->num_slots; i++)
+    {
+        spi_client_io->slots[i].buffer = (uint8_t *)heap_caps_calloc(1, spi_client_io->packet_size, MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+        ESP_GOTO_ON_FALSE(spi_client_io->slots[i].buffer, ESP_ERR_NO_MEM, err, TAG, "no mem for packet buffer");
+        spi_client_io->slots[i].trans = (spi_transaction_t *)calloc(trans_per_slot, sizeof(spi_transaction_t));
+        ESP_GOTO_ON_FALSE(spi_client_io->slots[i].trans, ESP_ERR_NO_MEM, err, TAG, "no mem for packet transactions");
+    }
+
     spi_device_interface_config_t dev_config = {
         .flags = (io_config->flags.lsb_first ? SPI_DEVICE_TXBIT_LSBFIRST : 0) | (io_config->flags.sio_mode ? SPI_DEVICE_3WIRE : 0) | (io_config->flags.cs_high_active ? SPI_DEVICE_POSITIVE_CS : 0),
         .clock_speed_hz = io_config->pclk_hz,
         .mode = io_config->spi_mode,
         .spics_io_num = io_config->cs_gpio_num,
-        .queue_size = 1,
+        .queue_size = spi_client_io->num_slots * trans_per_slot,
     };
 
     ret = spi_bus_add_device((spi_host_device_t)bus, &dev_config, &spi_client_io->spi_dev);
@@ -107,15 +174,13 @@ esp_err_t sscma_client_new_io_spi_bus(sscma_client_spi_bus_handle_t bus, const s
     spi_client_io->base.read = client_io_spi_read;
     spi_client_io->base.available = client_io_spi_available;
     spi_client_io->base.flush = client_io_spi_flush;
+    spi_client_io->base.set_ready_cb = client_io_spi_set_ready_cb;
     spi_client_io->base.handle = spi_client_io->spi_dev;
 
     spi_client_io->lock = xSemaphoreCreateMutex();
     ESP_GOTO_ON_FALSE(spi_client_io->lock, ESP_ERR_NO_MEM, err, TAG, "no mem for mutex");
 
-    size_t max_trans_bytes = 0;
-    ESP_GOTO_ON_ERROR(spi_bus_get_max_transaction_len((spi_host_device_t)bus, &max_trans_bytes), err, TAG, "get spi max transaction len failed");
-    spi_client_io->spi_trans_max_bytes = max_trans_bytes;
-    ESP_LOGI(TAG, "spi max trans bytes: %d", spi_client_io->spi_trans_max_bytes);
+    ESP_LOGI(TAG, "spi packets: write %d, read %d, %d in flight", spi_client_io->max_write_len, spi_client_io->max_read_len, spi_client_io->num_slots);
 
     *ret_io = &spi_client_io->base;
     ESP_LOGD(TAG, "new spi sscma client io @%p", spi_client_io);
@@ -134,6 +199,7 @@ err:
         {
             vSemaphoreDelete(spi_client_io->lock);
         }
+        client_io_spi_free_slots(spi_client_io);
         free(spi_client_io);
     }
     return ret;
@@ -143,6 +209,10 @@ static esp_err_t client_io_spi_del(sscma_client_io_t *io)
 {
     esp_err_t ret = ESP_OK;
     sscma_client_io_spi_t *spi_client_io = __containerof(io, sscma_client_io_spi_t, base);
+    if (spi_client_io->ready_cb && spi_client_io->sync_gpio_num >= 0 && spi_client_io->io_expander == NULL)
+    {
+        gpio_isr_handler_remove(spi_client_io->sync_gpio_num);
+    }
     if (spi_client_io->lock)
     {
         vSemaphoreDelete(spi_client_io->lock);
@@ -153,20 +223,114 @@ static esp_err_t client_io_spi_del(sscma_client_io_t *io)
     {
         gpio_reset_pin(spi_client_io->sync_gpio_num);
     }
+    client_io_spi_free_slots(spi_client_io);
     ESP_LOGD(TAG, "del spi sscma client io @%p", spi_client_io);
 
     free(spi_client_io);
     return ret;
 }
 
+// Collect the transactions of a slot. Results come back in queue order and slots are used round
+// robin, so the slot collected is always the oldest one in flight.
+static esp_err_t client_io_spi_slot_wait(sscma_client_io_spi_t *spi_client_io, sscma_client_io_spi_slot_t *slot)
+{
+    esp_err_t ret = ESP_OK;
+    spi_transaction_t *done = NULL;
+
+    while (slot->num_trans > 0)
+    {
+        esp_err_t err = spi_device_get_trans_result(spi_client_io->spi_dev, &done, portMAX_DELAY);
+        if (ret == ESP_OK)
+        {
+            ret = err;
+        }
+        slot->num_trans--;
+    }
+    return ret;
+}
+
+// Wait for every packet in flight, oldest first
+static esp_err_t client_io_spi_drain(sscma_client_io_spi_t *spi_client_io)
+{
+    esp_err_t ret = ESP_OK;
+
+    for (size_t i = 0; i < spi_client_io->num_slots; i++)
+    {
+        esp_err_t err = client_io_spi_slot_wait(spi_client_io, &spi_client_io->slots[(spi_client_io->next_slot + i) % spi_client_io->num_slots]);
+        if (ret == ESP_OK)
+        {
+            ret = err;
+        }
+    }
+    return ret;
+}
+
+// Take the next slot and fill its packet, while the packets before it may still be on the wire
+static esp_err_t client_io_spi_slot_prepare(sscma_client_io_spi_t *spi_client_io, sscma_client_io_spi_slot_t **ret_slot, uint8_t cmd, uint16_t len, const void *payload)
+{
+    sscma_client_io_spi_slot_t *slot = &spi_client_io->slots[spi_client_io->next_slot];
+    size_t payload_len = payload ? len : 0;
+
+    spi_client_io->next_slot = (spi_client_io->next_slot + 1) % spi_client_io->num_slots;
+    ESP_RETURN_ON_ERROR(client_io_spi_slot_wait(spi_client_io, slot), TAG, "spi transmit failed");
+
+    slot->buffer[0] = FEATURE_TRANSPORT;
+    slot->buffer[1] = cmd;
+    slot->buffer[2] = len >> 8;
+    slot->buffer[3] = len & 0xFF;
+    if (payload_len)
+    {
+        memcpy(slot->buffer + HEADER_LEN, payload, payload_len);
+    }
+    slot->buffer[HEADER_LEN + payload_len] = 0xFF;
+    slot->buffer[HEADER_LEN + payload_len + 1] = 0xFF;
+    memset(slot->buffer + HEADER_LEN + payload_len + CHECKSUM_LEN, 0, spi_client_io->packet_size - HEADER_LEN - payload_len - CHECKSUM_LEN);
+
+    *ret_slot = slot;
+    return ESP_OK;
+}
+
+// Give the device wait_delay before a batch of packets. Every operation drains its packets before
+// it returns, so the delay follows the previous transfer; the packets of the batch are queued back
+// to back.
+static void client_io_spi_batch_delay(sscma_client_io_spi_t *spi_client_io)
+{
+    if (spi_client_io->wait_delay > 0)
+    {
+        vTaskDelay(pdMS_TO_TICKS(spi_client_io->wait_delay));
+    }
+}
+
+// Queue a transfer on behalf of slot, split into chunks the bus can take with CS held in between
+static esp_err_t client_io_spi_slot_queue(sscma_client_io_spi_t *spi_client_io, sscma_client_io_spi_slot_t *slot, const uint8_t *tx, uint8_t *rx, size_t len)
+{
+    while (len > 0)
+    {
+        size_t chunk_size = len > spi_client_io->spi_trans_max_bytes ? spi_client_io->spi_trans_max_bytes : len;
+        spi_transaction_t *spi_trans = &slot->trans[slot->num_trans];
+
+        memset(spi_trans, 0, sizeof(spi_transaction_t));
+        spi_trans->flags = chunk_size < len ? SPI_TRANS_CS_KEEP_ACTIVE : 0;
+        spi_trans->length = chunk_size * 8;
+        spi_trans->tx_buffer = tx;
+        spi_trans->rx_buffer = rx;
+        spi_trans->rxlength = rx ? chunk_size * 8 : 0;
+        spi_trans->user = spi_client_io;
+        ESP_RETURN_ON_ERROR(spi_device_queue_trans(spi_client_io->spi_dev, spi_trans, portMAX_DELAY), TAG, "spi transmit (queue) failed");
+        slot->num_trans++;
+
+        tx = tx ? tx + chunk_size : NULL;
+        rx = rx ? rx + chunk_size : NULL;
+        len -= chunk_size;
+    }
+    return ESP_OK;
+}
+
 static esp_err_t client_io_spi_write(sscma_client_io_t *io, const void *data, size_t len)
 {
     esp_err_t ret = ESP_OK;
-    spi_transaction_t spi_trans = {};
     sscma_client_io_spi_t *spi_client_io = __containerof(io, sscma_client_io_spi_t, base);
-    uint16_t packets = len / MAX_PL_LEN;
-    uint16_t remain = len % MAX_PL_LEN;
-    size_t trans_len = 0;
+    sscma_client_io_spi_slot_t *slot = NULL;
 
     xSemaphoreTake(spi_client_io->lock, portMAX_DELAY);
 
@@ -178,91 +342,20 @@ static esp_err_t client_io_spi_write(sscma_client_io_t *io, const void *data, si
 
     if (data)
     {
-        for (uint16_t i = 0; i < packets; i++)
+        client_io_spi_batch_delay(spi_client_io);
+        for (size_t offset = 0; offset < len; offset += spi_client_io->max_write_len)
         {
-            trans_len = PACKET_SIZE;
-            memset(spi_client_io->buffer, 0, sizeof(spi_client_io->buffer));
-            spi_client_io->buffer[0] = FEATURE_TRANSPORT;
-            spi_client_io->buffer[1] = FEATURE_TRANSPORT_CMD_WRITE;
-            spi_client_io->buffer[2] = MAX_PL_LEN >> 8;
-            spi_client_io->buffer[3] = MAX_PL_LEN & 0xFF;
-            spi_client_io->buffer[4 + MAX_PL_LEN] = 0xFF;
-            spi_client_io->buffer[5 + MAX_PL_LEN] = 0xFF;
-            memcpy(spi_client_io->buffer + 4, data + i * MAX_PL_LEN, MAX_PL_LEN);
-            spi_trans.tx_buffer = spi_client_io->buffer;
-            if (spi_client_io->wait_delay > 0)
-            {
-                vTaskDelay(pdMS_TO_TICKS(spi_client_io->wait_delay));
-            }
-            do
-            {
-                uint16_t chunk_size = trans_len;
-                if (chunk_size > spi_client_io->spi_trans_max_bytes)
-                {
-                    chunk_size = spi_client_io->spi_trans_max_bytes;
-                    spi_trans.flags |= SPI_TRANS_CS_KEEP_ACTIVE;
-                }
-                else
-                {
-                    chunk_size = trans_len;
-                    spi_trans.flags &= ~SPI_TRANS_CS_KEEP_ACTIVE;
-                }
-                spi_trans.length = chunk_size * 8;
-                spi_trans.rxlength = 0;
-                spi_trans.rx_buffer = NULL;
-                spi_trans.user = spi_client_io;
-                ret = spi_device_transmit(spi_client_io->spi_dev, &spi_trans);
-                ESP_GOTO_ON_ERROR(ret, err, TAG, "spi transmit (queue) failed");
-                spi_trans.tx_buffer = spi_trans.tx_buffer + chunk_size;
-                trans_len -= chunk_size;
-            }
-            while (trans_len > 0);
-        }
-
-        if (remain)
-        {
-            trans_len = PACKET_SIZE;
-            memset(spi_client_io->buffer, 0, sizeof(spi_client_io->buffer));
-            spi_client_io->buffer[0] = FEATURE_TRANSPORT;
-            spi_client_io->buffer[1] = FEATURE_TRANSPORT_CMD_WRITE;
-            spi_client_io->buffer[2] = remain >> 8;
-            spi_client_io->buffer[3] = remain & 0xFF;
-            spi_client_io->buffer[4 + remain] = 0xFF;
-            spi_client_io->buffer[5 + remain] = 0xFF;
-            memcpy(spi_client_io->buffer + 4, data + packets * MAX_PL_LEN, remain);
-            spi_trans.tx_buffer = spi_client_io->buffer;
-            if (spi_client_io->wait_delay > 0)
-            {
-                vTaskDelay(pdMS_TO_TICKS(spi_client_io->wait_delay));
-            }
-            do
-            {
-                uint16_t chunk_size = trans_len;
-                if (chunk_size > spi_client_io->spi_trans_max_bytes)
-                {
-                    chunk_size = spi_client_io->spi_trans_max_bytes;
-                    spi_trans.flags |= SPI_TRANS_CS_KEEP_ACTIVE;
-                }
-                else
-                {
-                    chunk_size = trans_len;
-                    spi_trans.flags &= ~SPI_TRANS_CS_KEEP_ACTIVE;
-                }
-                spi_trans.length = chunk_size * 8;
-                spi_trans.tx_buffer = spi_client_io->buffer;
-                spi_trans.rxlength = 0;
-                spi_trans.rx_buffer = NULL;
-                spi_trans.user = spi_client_io;
-                ret = spi_device_transmit(spi_client_io->spi_dev, &spi_trans);
-                ESP_GOTO_ON_ERROR(ret, err, TAG, "spi transmit (queue) failed");
-                spi_trans.tx_buffer = spi_trans.tx_buffer + chunk_size;
-                trans_len -= chunk_size;
-            }
-            while (trans_len > 0);
+            size_t payload_len = len - offset > spi_client_io->max_write_len ? spi_client_io->max_write_len : len - offset;
+            ESP_GOTO_ON_ERROR(client_io_spi_slot_prepare(spi_client_io, &slot, FEATURE_TRANSPORT_CMD_WRITE, payload_len, (const uint8_t *)data + offset), err, TAG, "prepare write failed");
+            ESP_GOTO_ON_ERROR(client_io_spi_slot_queue(spi_client_io, slot, slot->buffer, NULL, spi_client_io->packet_size), err, TAG, "queue write failed");
         }
     }
 
 err:
+    if (client_io_spi_drain(spi_client_io) != ESP_OK && ret == ESP_OK)
+    {
+        ret = ESP_FAIL;
+    }
     spi_device_release_bus(spi_client_io->spi_dev);
     xSemaphoreGive(spi_client_io->lock);
     return ret;
@@ -271,11 +364,8 @@ err:
 static esp_err_t client_io_spi_read(sscma_client_io_t *io, void *data, size_t len)
 {
     esp_err_t ret = ESP_OK;
-    spi_transaction_t spi_trans = {};
     sscma_client_io_spi_t *spi_client_io = __containerof(io, sscma_client_io_spi_t, base);
-    uint16_t packets = len / MAX_RECIEVE_SIZE;
-    uint16_t remain = len % MAX_RECIEVE_SIZE;
-    size_t trans_len = 0;
+    sscma_client_io_spi_slot_t *slot = NULL;
 
     xSemaphoreTake(spi_client_io->lock, portMAX_DELAY);
 
@@ -287,187 +377,63 @@ static esp_err_t client_io_spi_read(sscma_client_io_t *io, void *data, size_t le
 
     if (data)
     {
-        for (uint16_t i = 0; i < packets; i++)
+        client_io_spi_batch_delay(spi_client_io);
+        // the data of each packet is received straight into the caller's buffer
+        for (size_t offset = 0; offset < len; offset += spi_client_io->max_read_len)
         {
-            trans_len = PACKET_SIZE;
-            memset(spi_client_io->buffer, 0, sizeof(spi_client_io->buffer));
-            spi_client_io->buffer[0] = FEATURE_TRANSPORT;
-            spi_client_io->buffer[1] = FEATURE_TRANSPORT_CMD_READ;
-            spi_client_io->buffer[2] = MAX_RECIEVE_SIZE >> 8;
-            spi_client_io->buffer[3] = MAX_RECIEVE_SIZE & 0xFF;
-            spi_client_io->buffer[4] = 0xFF;
-            spi_client_io->buffer[5] = 0xFF;
-            spi_trans.tx_buffer = spi_client_io->buffer;
-            if (spi_client_io->wait_delay > 0)
-            {
-                vTaskDelay(pdMS_TO_TICKS(spi_client_io->wait_delay));
-            }
-            do
-            {
-                uint16_t chunk_size = trans_len;
-                if (chunk_size > spi_client_io->spi_trans_max_bytes)
-                {
-                    chunk_size = spi_client_io->spi_trans_max_bytes;
-                    spi_trans.flags |= SPI_TRANS_CS_KEEP_ACTIVE;
-                }
-                else
-                {
-                    chunk_size = trans_len;
-                    spi_trans.flags &= ~SPI_TRANS_CS_KEEP_ACTIVE;
-                }
-                spi_trans.length = chunk_size * 8;
-                spi_trans.rxlength = 0;
-                spi_trans.rx_buffer = NULL;
-                spi_trans.user = spi_client_io;
-                ret = spi_device_transmit(spi_client_io->spi_dev, &spi_trans);
-                ESP_GOTO_ON_ERROR(ret, err, TAG, "spi transmit (queue) failed");
-                spi_trans.tx_buffer = spi_trans.tx_buffer + chunk_size;
-                trans_len -= chunk_size;
-            }
-            while (trans_len > 0);
-            if (spi_client_io->wait_delay > 0)
-            {
-                vTaskDelay(pdMS_TO_TICKS(spi_client_io->wait_delay));
-            }
-
-            trans_len = MAX_RECIEVE_SIZE;
-            spi_trans.rx_buffer = data + i * MAX_RECIEVE_SIZE;
-            do
-            {
-                uint16_t chunk_size = trans_len;
-                if (chunk_size > spi_client_io->spi_trans_max_bytes)
-                {
-                    chunk_size = spi_client_io->spi_trans_max_bytes;
-                    spi_trans.flags |= SPI_TRANS_CS_KEEP_ACTIVE;
-                }
-                else
-                {
-                    chunk_size = trans_len;
-                    spi_trans.flags &= ~SPI_TRANS_CS_KEEP_ACTIVE;
-                }
-                spi_trans.length = chunk_size * 8;
-                spi_trans.tx_buffer = NULL;
-                spi_trans.rxlength = chunk_size * 8;
-                spi_trans.user = spi_client_io;
-                ret = spi_device_transmit(spi_client_io->spi_dev, &spi_trans);
-                ESP_GOTO_ON_ERROR(ret, err, TAG, "spi transmit (queue) failed");
-                spi_trans.rx_buffer = spi_trans.rx_buffer + chunk_size;
-                trans_len -= chunk_size;
-            }
-            while (trans_len > 0);
-        }
-        if (remain)
-        {
-            trans_len = PACKET_SIZE;
-            memset(spi_client_io->buffer, 0, sizeof(spi_client_io->buffer));
-            spi_client_io->buffer[0] = FEATURE_TRANSPORT;
-            spi_client_io->buffer[1] = FEATURE_TRANSPORT_CMD_READ;
-            spi_client_io->buffer[2] = remain >> 8;
-            spi_client_io->buffer[3] = remain & 0xFF;
-            spi_client_io->buffer[4] = 0xFF;
-            spi_client_io->buffer[5] = 0xFF;
-            spi_trans.tx_buffer = spi_client_io->buffer;
-            if (spi_client_io->wait_delay > 0)
-            {
-                vTaskDelay(pdMS_TO_TICKS(spi_client_io->wait_delay));
-            }
-            do
-            {
-                uint16_t chunk_size = trans_len;
-                if (chunk_size > spi_client_io->spi_trans_max_bytes)
-                {
-                    chunk_size = spi_client_io->spi_trans_max_bytes;
-                    spi_trans.flags |= SPI_TRANS_CS_KEEP_ACTIVE;
-                }
-                else
-                {
-                    chunk_size = trans_len;
-                    spi_trans.flags &= ~SPI_TRANS_CS_KEEP_ACTIVE;
-                }
-                spi_trans.rxlength = 0;
-                spi_trans.rx_buffer = NULL;
-                spi_trans.length = chunk_size * 8;
-                spi_trans.user = spi_client_io;
-                ret = spi_device_transmit(spi_client_io->spi_dev, &spi_trans);
-                ESP_GOTO_ON_ERROR(ret, err, TAG, "spi transmit (queue) failed");
-                spi_trans.tx_buffer = spi_trans.tx_buffer + chunk_size;
-                trans_len -= chunk_size;
-            }
-            while (trans_len > 0);
-
-            if (spi_client_io->wait_delay > 0)
-            {
-                vTaskDelay(pdMS_TO_TICKS(spi_client_io->wait_delay));
-            }
-            trans_len = remain;
-            spi_trans.rx_buffer = data + packets * MAX_RECIEVE_SIZE;
-            do
-            {
-                uint16_t chunk_size = trans_len;
-                if (chunk_size > spi_client_io->spi_trans_max_bytes)
-                {
-                    chunk_size = spi_client_io->spi_trans_max_bytes;
-                    spi_trans.flags |= SPI_TRANS_CS_KEEP_ACTIVE;
-                }
-                else
-                {
-                    chunk_size = trans_len;
-                    spi_trans.flags &= ~SPI_TRANS_CS_KEEP_ACTIVE;
-                }
-                spi_trans.length = chunk_size * 8;
-                spi_trans.tx_buffer = NULL;
-                spi_trans.rxlength = chunk_size * 8;
-                spi_trans.user = spi_client_io;
-                ret = spi_device_transmit(spi_client_io->spi_dev, &spi_trans);
-                ESP_GOTO_ON_ERROR(ret, err, TAG, "spi transmit (queue) failed");
-                spi_trans.rx_buffer = spi_trans.rx_buffer + chunk_size;
-                trans_len -= chunk_size;
-            }
-            while (trans_len > 0);
+            size_t read_len = len - offset > spi_client_io->max_read_len ? spi_client_io->max_read_len : len - offset;
+            ESP_GOTO_ON_ERROR(client_io_spi_slot_prepare(spi_client_io, &slot, FEATURE_TRANSPORT_CMD_READ, read_len, NULL), err, TAG, "prepare read failed");
+            ESP_GOTO_ON_ERROR(client_io_spi_slot_queue(spi_client_io, slot, slot->buffer, NULL, spi_client_io->packet_size), err, TAG, "queue read failed");
+            ESP_GOTO_ON_ERROR(client_io_spi_slot_queue(spi_client_io, slot, NULL, (uint8_t *)data + offset, read_len), err, TAG, "queue read failed");
         }
     }
 
 err:
+    if (client_io_spi_drain(spi_client_io) != ESP_OK && ret == ESP_OK)
+    {
+        ret = ESP_FAIL;
+    }
     spi_device_release_bus(spi_client_io->spi_dev);
     xSemaphoreGive(spi_client_io->lock);
     return ret;
 }
 
-static esp_err_t client_io_spi_available(sscma_client_io_t *io, size_t *len)
+// Whether the device has data to send, always true without a SYNC line
+static esp_err_t client_io_spi_sync_ready(sscma_client_io_spi_t *spi_client_io, bool *ready)
 {
-    esp_err_t ret = ESP_OK;
-    spi_transaction_t spi_trans = {};
-    sscma_client_io_spi_t *spi_client_io = __containerof(io, sscma_client_io_spi_t, base);
-    size_t trans_len = 0;
     uint32_t sync_level = 0;
 
-    *len = 0;
-
-    xSemaphoreTake(spi_client_io->lock, portMAX_DELAY);
-
+    *ready = true;
     if (spi_client_io->sync_gpio_num >= 0)
     {
         if (spi_client_io->io_expander)
         {
-            if (esp_io_expander_get_level(spi_client_io->io_expander, spi_client_io->sync_gpio_num, &sync_level) != ESP_OK)
-            {
-                xSemaphoreGive(spi_client_io->lock);
-                return ESP_FAIL;
-            }
+            ESP_RETURN_ON_ERROR(esp_io_expander_get_level(spi_client_io->io_expander, spi_client_io->sync_gpio_num, &sync_level), TAG, "get sync level failed");
         }
         else
         {
             sync_level = gpio_get_level(spi_client_io->sync_gpio_num);
         }
-        if (sync_level == 0)
-        {
-            xSemaphoreGive(spi_client_io->lock);
-            return ESP_OK;
-        }
+        *ready = sync_level != 0;
     }
-    else
+    return ESP_OK;
+}
+
+static esp_err_t client_io_spi_available(sscma_client_io_t *io, size_t *len)
+{
+    esp_err_t ret = ESP_OK;
+    sscma_client_io_spi_t *spi_client_io = __containerof(io, sscma_client_io_spi_t, base);
+    sscma_client_io_spi_slot_t *slot = NULL;
+    bool ready = false;
+
+    *len = 0;
+
+    xSemaphoreTake(spi_client_io->lock, portMAX_DELAY);
+
+    if (client_io_spi_sync_ready(spi_client_io, &ready) != ESP_OK || !ready)
     {
-        vTaskDelay(pdMS_TO_TICKS(spi_client_io->wait_delay));
+        xSemaphoreGive(spi_client_io->lock);
+        return ready ? ESP_FAIL : ESP_OK;
     }
 
     if (spi_device_acquire_bus(spi_client_io->spi_dev, portMAX_DELAY) != ESP_OK)
@@ -476,62 +442,20 @@ static esp_err_t client_io_spi_available(sscma_client_io_t *io, size_t *len)
         return ESP_FAIL;
     }
 
-    trans_len = PACKET_SIZE;
-    memset(spi_client_io->buffer, 0, sizeof(spi_client_io->buffer));
-    spi_client_io->buffer[0] = FEATURE_TRANSPORT;
-    spi_client_io->buffer[1] = FEATURE_TRANSPORT_CMD_AVAILABLE;
-    spi_client_io->buffer[2] = 0x00;
-    spi_client_io->buffer[3] = 0x00;
-    spi_client_io->buffer[4] = 0xFF;
-    spi_client_io->buffer[5] = 0xFF;
-    spi_trans.tx_buffer = spi_client_io->buffer;
-    if (spi_client_io->wait_delay > 0)
-    {
-        vTaskDelay(pdMS_TO_TICKS(spi_client_io->wait_delay));
-    }
-    do
-    {
-        uint16_t chunk_size = trans_len;
-        if (chunk_size > spi_client_io->spi_trans_max_bytes)
-        {
-            chunk_size = spi_client_io->spi_trans_max_bytes;
-            spi_trans.flags |= SPI_TRANS_CS_KEEP_ACTIVE;
-        }
-        else
-        {
-            chunk_size = trans_len;
-            spi_trans.flags &= ~SPI_TRANS_CS_KEEP_ACTIVE;
-        }
-        spi_trans.length = chunk_size * 8;
-        spi_trans.rxlength = 0;
-        spi_trans.rx_buffer = NULL;
-        spi_trans.user = spi_client_io;
-        ret = spi_device_transmit(spi_client_io->spi_dev, &spi_trans);
-        ESP_GOTO_ON_ERROR(ret, err, TAG, "spi transmit (queue) failed");
-        spi_trans.tx_buffer = spi_trans.tx_buffer + chunk_size;
-        trans_len -= chunk_size;
-    }
-    while (trans_len > 0);
-
-    spi_trans.length = 2 * 8;
-    spi_trans.tx_buffer = NULL;
-    spi_trans.rxlength = 2 * 8; // 8 bits per byte
-    spi_trans.rx_buffer = spi_client_io->buffer;
-    spi_trans.user = spi_client_io;
-    spi_trans.flags &= ~SPI_TRANS_CS_KEEP_ACTIVE;
-    memset(spi_client_io->buffer, 0, sizeof(spi_client_io->buffer));
-    if (spi_client_io->wait_delay > 0)
-    {
-        vTaskDelay(pdMS_TO_TICKS(spi_client_io->wait_delay));
-    }
-    ret = spi_device_transmit(spi_client_io->spi_dev, &spi_trans);
-    ESP_GOTO_ON_ERROR(ret, err, TAG, "spi transmit (queue) failed");
-    *len = (spi_client_io->buffer[0] << 8) | spi_client_io->buffer[1];
+    client_io_spi_batch_delay(spi_client_io);
+    ESP_GOTO_ON_ERROR(client_io_spi_slot_prepare(spi_client_io, &slot, FEATURE_TRANSPORT_CMD_AVAILABLE, 0, NULL), err, TAG, "prepare available failed");
+    ESP_GOTO_ON_ERROR(client_io_spi_slot_queue(spi_client_io, slot, slot->buffer, NULL, spi_client_io->packet_size), err, TAG, "queue available failed");
+    // the length is read into the packet buffer, which is only reused once it is collected
+    ESP_GOTO_ON_ERROR(client_io_spi_slot_queue(spi_client_io, slot, NULL, slot->buffer, 2), err, TAG, "queue available failed");
+    ESP_GOTO_ON_ERROR(client_io_spi_drain(spi_client_io), err, TAG, "spi transmit failed");
+
+    *len = (slot->buffer[0] << 8) | slot->buffer[1];
     if (*len == 0xFFFF)
     {
         *len = 0;
     }
 err:
+    client_io_spi_drain(spi_client_io);
     spi_device_release_bus(spi_client_io->spi_dev);
     xSemaphoreGive(spi_client_io->lock);
     return ret;
@@ -540,36 +464,16 @@ err:
 static esp_err_t client_io_spi_flush(sscma_client_io_t *io)
 {
     esp_err_t ret = ESP_OK;
-    spi_transaction_t spi_trans = {};
     sscma_client_io_spi_t *spi_client_io = __containerof(io, sscma_client_io_spi_t, base);
-    size_t trans_len = 0;
-    uint32_t sync_level = 0;
+    sscma_client_io_spi_slot_t *slot = NULL;
+    bool ready = false;
 
     xSemaphoreTake(spi_client_io->lock, portMAX_DELAY);
 
-    if (spi_client_io->sync_gpio_num >= 0)
+    if (client_io_spi_sync_ready(spi_client_io, &ready) != ESP_OK || !ready)
     {
-        if (spi_client_io->io_expander)
-        {
-            if (esp_io_expander_get_level(spi_client_io->io_expander, spi_client_io->sync_gpio_num, &sync_level) != ESP_OK)
-            {
-                xSemaphoreGive(spi_client_io->lock);
-                return ESP_FAIL;
-            }
-        }
-        else
-        {
-            sync_level = gpio_get_level(spi_client_io->sync_gpio_num);
-        }
-        if (sync_level == 0)
-        {
-            xSemaphoreGive(spi_client_io->lock);
-            return ESP_OK;
-        }
-    }
-    else
-    {
-        vTaskDelay(pdMS_TO_TICKS(spi_client_io->wait_delay));
+        xSemaphoreGive(spi_client_io->lock);
+        return ready ? ESP_FAIL : ESP_OK;
     }
 
     if (spi_device_acquire_bus(spi_client_io->spi_dev, portMAX_DELAY) != ESP_OK)
@@ -578,45 +482,74 @@ static esp_err_t client_io_spi_flush(sscma_client_io_t *io)
         return ESP_FAIL;
     }
 
-    trans_len = PACKET_SIZE;
-    memset(spi_client_io->buffer, 0, sizeof(spi_client_io->buffer));
-    spi_client_io->buffer[0] = FEATURE_TRANSPORT;
-    spi_client_io->buffer[1] = FEATURE_TRANSPORT_CMD_RESET;
-    spi_client_io->buffer[2] = 0x00;
-    spi_client_io->buffer[3] = 0x00;
-    spi_client_io->buffer[4] = 0xFF;
-    spi_client_io->buffer[5] = 0xFF;
-    spi_trans.tx_buffer = spi_client_io->buffer;
-    if (spi_client_io->wait_delay > 0)
+    client_io_spi_batch_delay(spi_client_io);
+    ESP_GOTO_ON_ERROR(client_io_spi_slot_prepare(spi_client_io, &slot, FEATURE_TRANSPORT_CMD_RESET, 0, NULL), err, TAG, "prepare reset failed");
+    ESP_GOTO_ON_ERROR(client_io_spi_slot_queue(spi_client_io, slot, slot->buffer, NULL, spi_client_io->packet_size), err, TAG, "queue reset failed");
+
+err:
+    if (client_io_spi_drain(spi_client_io) != ESP_OK && ret == ESP_OK)
     {
-        vTaskDelay(pdMS_TO_TICKS(spi_client_io->wait_delay));
+        ret = ESP_FAIL;
+    }
+    spi_device_release_bus(spi_client_io->spi_dev);
+    xSemaphoreGive(spi_client_io->lock);
+    return ret;
+}
+
+static esp_err_t client_io_spi_set_ready_cb(sscma_client_io_t *io, sscma_client_io_ready_cb_t cb, void *user_ctx)
+{
+    esp_err_t ret = ESP_OK;
+    sscma_client_io_spi_t *spi_client_io = __containerof(io, sscma_client_io_spi_t, base);
+
+    if (spi_client_io->sync_gpio_num < 0)
+    {
+        return ESP_ERR_NOT_SUPPORTED;
     }
-    do
+
+    // a SYNC line behind an IO expander is signalled by sscma_client_io_spi_sync_isr from the expander interrupt
+    if (spi_client_io->io_expander)
     {
-        uint16_t chunk_size = trans_len;
-        if (chunk_size > spi_client_io->spi_trans_max_bytes)
-        {
-            chunk_size = spi_client_io->spi_trans_max_bytes;
-            spi_trans.flags |= SPI_TRANS_CS_KEEP_ACTIVE;
-        }
-        else
+        spi_client_io->ready_ctx = user_ctx;
+        spi_client_io->ready_cb = cb;
+        return ESP_OK;
+    }
+
+    if (cb == NULL)
+    {
+        if (spi_client_io->ready_cb)
         {
-            chunk_size = trans_len;
-            spi_trans.flags &= ~SPI_TRANS_CS_KEEP_ACTIVE;
+            gpio_set_intr_type(spi_client_io->sync_gpio_num, GPIO_INTR_DISABLE);
+            gpio_isr_handler_remove(spi_client_io->sync_gpio_num);
         }
-        spi_trans.length = chunk_size * 8;
-        spi_trans.rxlength = 0;
-        spi_trans.rx_buffer = NULL;
-        spi_trans.user = spi_client_io;
-        ret = spi_device_transmit(spi_client_io->spi_dev, &spi_trans);
-        ESP_GOTO_ON_ERROR(ret, err, TAG, "spi transmit (queue) failed");
-        spi_trans.tx_buffer = spi_trans.tx_buffer + chunk_size;
-        trans_len -= chunk_size;
+        spi_client_io->ready_cb = NULL;
+        spi_client_io->ready_ctx = NULL;
+        return ESP_OK;
     }
-    while (trans_len > 0);
+
+    bool installed = spi_client_io->ready_cb != NULL;
+    spi_client_io->ready_ctx = user_ctx;
+    spi_client_io->ready_cb = cb;
+    if (!installed)
+    {
+        // the service may already be installed by another driver
+        ret = gpio_install_isr_service(0);
+        ESP_GOTO_ON_FALSE(ret == ESP_OK || ret == ESP_ERR_INVALID_STATE, ret, err, TAG, "install gpio isr service failed");
+        ESP_GOTO_ON_ERROR(gpio_set_intr_type(spi_client_io->sync_gpio_num, GPIO_INTR_POSEDGE), err, TAG, "set sync GPIO interrupt type failed");
+        ESP_GOTO_ON_ERROR(gpio_isr_handler_add(spi_client_io->sync_gpio_num, client_io_spi_sync_isr, spi_client_io), err, TAG, "add sync GPIO isr handler failed");
+    }
+    return ESP_OK;
 
 err:
-    spi_device_release_bus(spi_client_io->spi_dev);
-    xSemaphoreGive(spi_client_io->lock);
+    gpio_set_intr_type(spi_client_io->sync_gpio_num, GPIO_INTR_DISABLE);
+    spi_client_io->ready_cb = NULL;
+    spi_client_io->ready_ctx = NULL;
     return ret;
-}
\ No newline at end of file
+}
+
+void sscma_client_io_spi_sync_isr(sscma_client_io_handle_t io)
+{
+    if (io)
+    {
+        client_io_spi_sync_isr(__containerof(io, sscma_client_io_spi_t, base));
+    }
+}
@@ -5,6 +5,8 @@
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
 
 #include "sscma_client_io_interface.h"
 #include "sscma_client_io.h"
@@ -15,18 +17,26 @@
 
 static const char *TAG = "sscma_client.io.uart";
 
+#define EVENT_TASK_STACK    2048
+#define EVENT_TASK_PRIORITY (configMAX_PRIORITIES - 2)
+
 static esp_err_t client_io_uart_del(sscma_client_io_t *io);
 static esp_err_t client_io_uart_write(sscma_client_io_t *io, const void *data, size_t len);
 static esp_err_t client_io_uart_read(sscma_client_io_t *io, void *data, size_t len);
 static esp_err_t client_io_uart_available(sscma_client_io_t *io, size_t *len);
 static esp_err_t client_io_uart_flush(sscma_client_io_t *io);
+static esp_err_t client_io_uart_set_ready_cb(sscma_client_io_t *io, sscma_client_io_ready_cb_t cb, void *user_ctx);
 
 typedef struct
 {
     sscma_client_io_t base;
-    SemaphoreHandle_t lock; // Mutex lock
-    uint32_t uart_port;     // UART port
-    void *user_ctx;         // User context
+    SemaphoreHandle_t lock;              // Mutex lock
+    uint32_t uart_port;                  // UART port
+    void *user_ctx;                      // User context
+    QueueHandle_t event_queue;           // UART driver event queue
+    TaskHandle_t event_task;             // Forwards UART data events to ready_cb
+    sscma_client_io_ready_cb_t ready_cb; // Data-ready callback
+    void *ready_ctx;                     // Data-ready callback context
 } sscma_client_io_uart_t;
 
 esp_err_t sscma_client_new_io_uart_bus(sscma_client_uart_bus_handle_t bus, const sscma_client_io_uart_config_t *io_config, sscma_client_io_handle_t *ret_io)
@@ -43,11 +53,13 @@ esp_err_t sscma_client_new_io_uart_bus(sscma_client_uart_bus_handle_t bus, const
 
     uart_client_io->uart_port = (uint32_t)bus;
     uart_client_io->user_ctx = io_config->user_ctx;
+    uart_client_io->event_queue = io_config->event_queue;
     uart_client_io->base.del = client_io_uart_del;
     uart_client_io->base.write = client_io_uart_write;
     uart_client_io->base.read = client_io_uart_read;
     uart_client_io->base.available = client_io_uart_available;
     uart_client_io->base.flush = client_io_uart_flush;
+    uart_client_io->base.set_ready_cb = client_io_uart_set_ready_cb;
 
     uart_client_io->lock = xSemaphoreCreateMutex();
     ESP_GOTO_ON_FALSE(uart_client_io->lock, ESP_ERR_NO_MEM, err, TAG, "no mem for mutex");
@@ -75,6 +87,11 @@ esp_err_t client_io_uart_del(sscma_client_io_t *io)
     esp_err_t ret = ESP_OK;
     sscma_client_io_uart_t *uart_client_io = __containerof(io, sscma_client_io_uart_t, base);
 
+    if (uart_client_io->event_task)
+    {
+        vTaskDelete(uart_client_io->event_task);
+    }
+
     if (uart_client_io->lock)
     {
         vSemaphoreDelete(uart_client_io->lock);
@@ -141,4 +158,53 @@ static esp_err_t client_io_uart_flush(sscma_client_io_t *io)
     sscma_client_io_uart_t *uart_client_io = __containerof(io, sscma_client_io_uart_t, base);
     ESP_RETURN_ON_ERROR(uart_flush(uart_client_io->uart_port), TAG, "uart flush failed");
     return ESP_OK;
-}
\ No newline at end of file
+}
+
+static void client_io_uart_event_task(void *arg)
+{
+    sscma_client_io_uart_t *uart_client_io = (sscma_client_io_uart_t *)arg;
+    uart_event_t event;
+    while (true)
+    {
+        if (xQueueReceive(uart_client_io->event_queue, &event, portMAX_DELAY) != pdTRUE)
+        {
+            continue;
+        }
+        // overflows are reported too, so the reader drains what is left in the ring buffer
+        if (event.type == UART_DATA || event.type == UART_BUFFER_FULL || event.type == UART_FIFO_OVF)
+        {
+            sscma_client_io_ready_cb_t cb = uart_client_io->ready_cb;
+            if (cb)
+            {
+                cb(&uart_client_io->base, uart_client_io->ready_ctx);
+            }
+        }
+    }
+}
+
+static esp_err_t client_io_uart_set_ready_cb(sscma_client_io_t *io, sscma_client_io_ready_cb_t cb, void *user_ctx)
+{
+    sscma_client_io_uart_t *uart_client_io = __containerof(io, sscma_client_io_uart_t, base);
+    if (uart_client_io->event_queue == NULL)
+    {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    uart_client_io->ready_ctx = user_ctx;
+    uart_client_io->ready_cb = cb;
+
+    if (cb && uart_client_io->event_task == NULL)
+    {
+        BaseType_t res = xTaskCreate(client_io_uart_event_task, "sscma_client_uart", EVENT_TASK_STACK, uart_client_io, EVENT_TASK_PRIORITY, &uart_client_io->event_task);
+        if (res != pdPASS)
+        {
+            uart_client_io->ready_cb = NULL;
+            uart_client_io->ready_ctx = NULL;
+            uart_client_io->event_task = NULL;
+            ESP_LOGE(TAG, "create uart event task failed");
+            return ESP_ERR_NO_MEM;
+        }
+    }
+
+    return ESP_OK;
+}
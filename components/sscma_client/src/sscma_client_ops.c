@@ -25,6 +25,7 @@
 #include "sscma_client_io.h"
 #include "sscma_client_flasher.h"
 #include "sscma_client_commands.h"
+#include "sscma_client_binary.h"
 #include "sscma_client_ops.h"
 
 static const char *TAG = "sscma_client";
@@ -42,6 +43,17 @@ const int error_map[] = {
     ESP_FAIL,
 };
 
+#define SSCMA_CLIENT_POLL_INTERVAL_MS 10
+// also wake up periodically when notified, in case an edge is missed while the task is suspended
+#define SSCMA_CLIENT_NOTIFY_TIMEOUT_MS 100
+// how long sscma_client_del waits for retained replies to be released
+#define SSCMA_CLIENT_DEL_RELEASE_TIMEOUT_MS 500
+
+#define SSCMA_CLIENT_REQUEST_FREE    0 // slot unused
+#define SSCMA_CLIENT_REQUEST_PENDING 1 // waiting for the reply, being written or blocking
+#define SSCMA_CLIENT_REQUEST_SENT    2 // asynchronous and written, expires at its deadline
+#define SSCMA_CLIENT_REQUEST_DONE    3 // reply stored for the blocked caller
+
 #define SSCMA_CLIENT_CMD_ERROR_CODE(err) (error_map[(err & 0x0F) > (CMD_EUNKNOWN - 1) ? (CMD_EUNKNOWN - 1) : (err & 0x0F)])
 
 static inline void *__malloc(size_t sz)
@@ -138,19 +150,37 @@ static inline int get_int_from_array(cJSON *object, int index)
 
 void sscma_client_reply_clear(sscma_client_reply_t *reply)
 {
-    if (reply->payload)
+    // retained copies share data and payload, the last one to go frees both
+    bool last = reply->data == NULL || sscma_client_pool_release(reply->data);
+    if (reply->payload && last)
     {
         cJSON_Delete(reply->payload);
-        reply->payload = NULL;
-    }
-    if (reply->data)
-    {
-        free(reply->data);
-        reply->data = NULL;
     }
+    reply->payload = NULL;
+    reply->data = NULL;
     reply->len = 0;
 }
 
+esp_err_t sscma_client_reply_retain(const sscma_client_reply_t *reply, sscma_client_reply_t *ref)
+{
+    ESP_RETURN_ON_FALSE(reply && reply->data && ref, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+
+    ref->data = sscma_client_pool_retain(reply->data);
+    ref->payload = reply->payload;
+    ref->len = reply->len;
+
+    return ESP_OK;
+}
+
+esp_err_t sscma_client_get_pool_stats(sscma_client_handle_t client, sscma_client_pool_stats_t *stats)
+{
+    ESP_RETURN_ON_FALSE(client && stats, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+
+    sscma_client_pool_get_stats(&client->reply_pool, stats);
+
+    return ESP_OK;
+}
+
 static void sscma_client_monitor(void *arg)
 {
     sscma_client_handle_t client = (sscma_client_handle_t)arg;
@@ -159,6 +189,17 @@ static void sscma_client_monitor(void *arg)
     {
         xQueueReceive(client->reply_queue, &reply, portMAX_DELAY);
 
+        // inference events read by the scanner come without a cJSON tree
+        if (reply.payload == NULL)
+        {
+            if (client->on_event)
+            {
+                client->on_event(client, &reply, client->user_ctx);
+            }
+            sscma_client_reply_clear(&reply);
+            continue;
+        }
+
         cJSON *type = cJSON_GetObjectItem(reply.payload, "type");
         if (type == NULL)
         {
@@ -203,231 +244,543 @@ static void sscma_client_monitor(void *arg)
     }
 }
 
-static void sscma_client_process(void *arg)
+static bool sscma_client_io_ready(sscma_client_io_t *io, void *user_ctx)
 {
-    size_t rlen = 0;
-    char *suffix = NULL;
-    char *prefix = NULL;
-    sscma_client_handle_t client = (sscma_client_handle_t)arg;
-    sscma_client_reply_t reply;
-    while (true)
+    sscma_client_handle_t client = (sscma_client_handle_t)user_ctx;
+    BaseType_t task_woken = pdFALSE;
+    if (xPortInIsrContext())
     {
-        vTaskDelay(10 / portTICK_PERIOD_MS);
-        if (client->inited == false)
+        vTaskNotifyGiveFromISR(client->process_task.handle, &task_woken);
+    }
+    else
+    {
+        xTaskNotifyGive(client->process_task.handle);
+    }
+    return task_woken == pdTRUE;
+}
+
+// Scan reply->data for the inference fields, false when the cJSON payload has to be used instead
+static bool sscma_client_scan_inference(const sscma_client_reply_t *reply, sscma_client_inference_t *inference)
+{
+    if (reply->data == NULL)
+    {
+        return false;
+    }
+    if (sscma_client_binary_is_frame(reply->data, reply->len))
+    {
+        return sscma_client_binary_decode_inference(reply->data, reply->len, inference);
+    }
+    return sscma_client_tokenize_inference(reply->data, reply->len, inference);
+}
+
+// Events of AT+INVOKE and AT+SAMPLE, the name may carry a prefix such as "xxx@SAMPLE"
+static bool sscma_client_is_inference(const sscma_client_inference_t *inference)
+{
+    static const char *names[] = { EVENT_INVOKE, EVENT_SAMPLE };
+
+    for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); i++)
+    {
+        size_t len = strlen(names[i]);
+        if (inference->name_len >= len && memcmp(inference->name + inference->name_len - len, names[i], len) == 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Find the value of the "image" key in the raw reply, the base64 string holds no escapes
+static bool sscma_client_find_image(const char *json, size_t len, const char **image, size_t *image_size)
+{
+    const char *end = json + len;
+    const char *p = json;
+
+    while ((p = memchr(p, '"', end - p)) != NULL)
+    {
+        const char *str = ++p;
+        while (p < end && *p != '"')
+        {
+            p += *p == '\\' ? 2 : 1;
+        }
+        if (p >= end)
+        {
+            return false;
+        }
+        const char *str_end = p++;
+
+        if (str_end - str != 5 || memcmp(str, "image", 5) != 0)
         {
             continue;
         }
-        if (sscma_client_available(client, &rlen) == ESP_OK && rlen)
+        while (p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n'))
+        {
+            p++;
+        }
+        if (p >= end || *p != ':')
+        {
+            continue; // a value, not the key
+        }
+        p++;
+        while (p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n'))
+        {
+            p++;
+        }
+        if (p >= end || *p != '"')
+        {
+            return false;
+        }
+        const char *value = ++p;
+        const char *value_end = memchr(value, '"', end - value);
+        if (value_end == NULL || memchr(value, '\\', value_end - value) != NULL)
+        {
+            return false;
+        }
+        *image = value;
+        *image_size = value_end - value;
+        return true;
+    }
+    return false;
+}
+
+static cJSON *sscma_client_parse_reply(sscma_client_handle_t client, const sscma_client_reply_t *reply)
+{
+    const char *image = NULL;
+    size_t image_size = 0;
+
+    if (!sscma_client_find_image(reply->data, reply->len, &image, &image_size) || image_size == 0)
+    {
+        return cJSON_Parse(reply->data);
+    }
+
+    // parse the reply without the image, which is read in place from reply->data when needed
+    size_t head = image - reply->data;
+    size_t tail = reply->len - head - image_size;
+    char *json = sscma_client_pool_alloc(&client->reply_pool, head + tail + 1);
+    if (json == NULL)
+    {
+        return NULL;
+    }
+    memcpy(json, reply->data, head);
+    memcpy(json + head, image + image_size, tail);
+    json[head + tail] = '\0';
+
+    cJSON *payload = cJSON_Parse(json);
+    sscma_client_pool_release(json);
+    return payload;
+}
+
+static uint32_t sscma_client_hash(const char *s, size_t len)
+{
+    uint32_t hash = 2166136261u; // FNV-1a
+    for (size_t i = 0; i < len; i++)
+    {
+        hash = (hash ^ (uint8_t)s[i]) * 16777619u;
+    }
+    return hash;
+}
+
+static inline size_t sscma_client_request_index(uint32_t hash, uint16_t tag)
+{
+    return (hash + tag * 2654435761u) & (SSCMA_CLIENT_REQUEST_SLOTS - 1);
+}
+
+// Find an outstanding request by command name and tag, request_lock must be held
+static sscma_client_request_t *sscma_client_request_lookup(sscma_client_handle_t client, const char *name, size_t len, uint16_t tag)
+{
+    uint32_t hash = sscma_client_hash(name, len);
+    size_t index = sscma_client_request_index(hash, tag);
+
+    // slots are probed from the home slot on, so a lookup usually stops at the first one
+    for (size_t i = 0; i < SSCMA_CLIENT_REQUEST_SLOTS; i++)
+    {
+        sscma_client_request_t *request = &client->requests[(index + i) & (SSCMA_CLIENT_REQUEST_SLOTS - 1)];
+        if ((request->state == SSCMA_CLIENT_REQUEST_PENDING || request->state == SSCMA_CLIENT_REQUEST_SENT) && request->hash == hash && request->tag == tag
+            && strncmp(request->cmd, name, len) == 0 && request->cmd[len] == '\0')
+        {
+            return request;
+        }
+    }
+    return NULL;
+}
+
+// Find the request a reply answers, the name of the reply carries the tag the request was sent with
+static sscma_client_request_t *sscma_client_request_find(sscma_client_handle_t client, const char *name)
+{
+    size_t len = strlen(name);
+    const char *at = memchr(name, '@', len);
+
+    if (at != NULL && at > name && at - name <= 5)
+    {
+        uint32_t tag = 0;
+        const char *p = name;
+        for (; p < at && *p >= '0' && *p <= '9'; p++)
+        {
+            tag = tag * 10 + (*p - '0');
+        }
+        if (p == at && tag > 0 && tag <= UINT16_MAX)
         {
-            if (rlen + client->rx_buffer.pos > client->rx_buffer.len)
+            sscma_client_request_t *request = sscma_client_request_lookup(client, at + 1, len - (at + 1 - name), tag);
+            if (request != NULL)
             {
-                rlen = client->rx_buffer.len - client->rx_buffer.pos;
-                if (rlen <= 0)
-                {
-                    ESP_LOGW(TAG, "rx buffer is full");
-                    client->rx_buffer.pos = 0;
-                    continue;
-                }
+                return request;
             }
+        }
+    }
+    return sscma_client_request_lookup(client, name, len, 0);
+}
+
+// Take a slot for cmd, request_lock must be held. A command that is already in flight is tagged so
+// that the replies of both can be told apart.
+static sscma_client_request_t *sscma_client_request_alloc(sscma_client_handle_t client, const char *cmd, bool can_tag)
+{
+    char name[sizeof(((sscma_client_request_t *)0)->cmd)];
+    size_t len = 0;
+    uint16_t tag = 0;
+
+    for (const char *p = cmd + CMD_PREFIX_LEN; len < sizeof(name) - 1 && *p && *p != '\r' && *p != '\n' && *p != '='; p++)
+    {
+        name[len++] = *p;
+    }
+    name[len] = '\0';
+
+    if (can_tag && memchr(name, '@', len) == NULL && sscma_client_request_lookup(client, name, len, 0) != NULL)
+    {
+        do
+        {
+            tag = ++client->request_seq;
+        }
+        while (tag == 0 || sscma_client_request_lookup(client, name, len, tag) != NULL);
+    }
+
+    uint32_t hash = sscma_client_hash(name, len);
+    size_t index = sscma_client_request_index(hash, tag);
+    for (size_t i = 0; i < SSCMA_CLIENT_REQUEST_SLOTS; i++)
+    {
+        sscma_client_request_t *request = &client->requests[(index + i) & (SSCMA_CLIENT_REQUEST_SLOTS - 1)];
+        if (request->state == SSCMA_CLIENT_REQUEST_FREE)
+        {
+            memcpy(request->cmd, name, len + 1);
+            request->hash = hash;
+            request->tag = tag;
+            request->state = SSCMA_CLIENT_REQUEST_PENDING;
+            request->cb = NULL;
+            request->user_ctx = NULL;
+            request->deadline = 0;
+            return request;
+        }
+    }
+    return NULL;
+}
+
+static esp_err_t sscma_client_reply_error(const sscma_client_reply_t *reply)
+{
+    int code = get_int_from_object(reply->payload, "code");
+    return SSCMA_CLIENT_CMD_ERROR_CODE(code);
+}
+
+// Hand reply to request. request_lock is held on entry and released before the callback of an
+// asynchronous request runs, which owns the reply until it returns.
+static void sscma_client_request_complete(sscma_client_handle_t client, sscma_client_request_t *request, sscma_client_reply_t *reply)
+{
+    sscma_client_request_cb_t cb = request->cb;
+    void *user_ctx = request->user_ctx;
+
+    if (cb != NULL)
+    {
+        request->state = SSCMA_CLIENT_REQUEST_FREE;
+    }
+    else
+    {
+        request->reply = *reply;
+        request->state = SSCMA_CLIENT_REQUEST_DONE;
+        xSemaphoreGive(request->done);
+    }
+    xSemaphoreGive(client->request_lock);
 
-            sscma_client_read(client, client->rx_buffer.data + client->rx_buffer.pos, rlen);
-            client->rx_buffer.pos += rlen;
+    if (cb != NULL)
+    {
+        cb(client, sscma_client_reply_error(reply), reply, user_ctx);
+        sscma_client_reply_clear(reply);
+    }
+}
 
-            int new_pos = 0;
-            for (int i = 0; i < client->rx_buffer.pos; i++)
+// Time out asynchronous requests whose reply did not come in time
+static void sscma_client_request_expire(sscma_client_handle_t client)
+{
+    TickType_t now = xTaskGetTickCount();
+
+    for (size_t i = 0; i < SSCMA_CLIENT_REQUEST_SLOTS; i++)
+    {
+        sscma_client_request_t *request = &client->requests[i];
+        sscma_client_request_cb_t cb = NULL;
+        void *user_ctx = NULL;
+
+        xSemaphoreTake(client->request_lock, portMAX_DELAY);
+        if (request->state == SSCMA_CLIENT_REQUEST_SENT && (int32_t)(now - request->deadline) >= 0)
+        {
+            cb = request->cb;
+            user_ctx = request->user_ctx;
+            request->state = SSCMA_CLIENT_REQUEST_FREE;
+            ESP_LOGW(TAG, "request timeout: %s", request->cmd);
+        }
+        xSemaphoreGive(client->request_lock);
+
+        if (cb != NULL)
+        {
+            cb(client, ESP_ERR_TIMEOUT, NULL, user_ctx);
+        }
+    }
+}
+
+// Whether a command containing cmd is outstanding
+static bool sscma_client_request_pending(sscma_client_handle_t client, const char *cmd)
+{
+    bool found = false;
+
+    xSemaphoreTake(client->request_lock, portMAX_DELAY);
+    for (size_t i = 0; i < SSCMA_CLIENT_REQUEST_SLOTS && !found; i++)
+    {
+        sscma_client_request_t *request = &client->requests[i];
+        found = (request->state == SSCMA_CLIENT_REQUEST_PENDING || request->state == SSCMA_CLIENT_REQUEST_SENT) && strstr(request->cmd, cmd) != NULL;
+    }
+    xSemaphoreGive(client->request_lock);
+
+    return found;
+}
+
+// Find the outstanding request an unknown command log names, request_lock must be held
+static sscma_client_request_t *sscma_client_request_find_in(sscma_client_handle_t client, const char *log)
+{
+    for (size_t i = 0; i < SSCMA_CLIENT_REQUEST_SLOTS; i++)
+    {
+        sscma_client_request_t *request = &client->requests[i];
+        if ((request->state == SSCMA_CLIENT_REQUEST_PENDING || request->state == SSCMA_CLIENT_REQUEST_SENT) && strstr(log, request->cmd) != NULL)
+        {
+            return request;
+        }
+    }
+    return NULL;
+}
+
+static void sscma_client_dispatch_event(sscma_client_handle_t client, sscma_client_reply_t reply)
+{
+    // discard all the events while AT+BREAK is found
+    bool found = sscma_client_request_pending(client, CMD_AT_BREAK);
+    if (client->on_event == NULL || found || xQueueSend(client->reply_queue, &reply, 0) != pdTRUE)
+    {
+        sscma_client_reply_clear(&reply); // discard this reply
+    }
+}
+
+static void sscma_client_dispatch(sscma_client_handle_t client, sscma_client_reply_t reply)
+{
+    // binary frames only carry inference events and have no cJSON tree
+    if (sscma_client_binary_is_frame(reply.data, reply.len))
+    {
+        sscma_client_inference_t inference = { 0 };
+        if (sscma_client_binary_decode_inference(reply.data, reply.len, &inference) && inference.type == CMD_TYPE_EVENT && sscma_client_is_inference(&inference))
+        {
+            reply.payload = NULL;
+            sscma_client_dispatch_event(client, reply);
+            return;
+        }
+        ESP_LOGW(TAG, "invalid binary reply: %d", reply.len);
+        sscma_client_reply_clear(&reply);
+        return;
+    }
+
+#ifdef CONFIG_SSCMA_SCAN_INFERENCE_EVENTS
+    // inference events are read with the schema scanner, so no cJSON tree is built for them
+    sscma_client_inference_t inference = { 0 };
+    if (sscma_client_scan_inference(&reply, &inference) && inference.type == CMD_TYPE_EVENT && sscma_client_is_inference(&inference))
+    {
+        reply.payload = NULL;
+        sscma_client_dispatch_event(client, reply);
+        return;
+    }
+#endif
+
+    reply.payload = sscma_client_parse_reply(client, &reply);
+    if (reply.payload != NULL)
+    {
+        cJSON *type = cJSON_GetObjectItem(reply.payload, "type");
+        cJSON *name = cJSON_GetObjectItem(reply.payload, "name");
+
+        if (type == NULL || name == NULL)
+        {
+            ESP_LOGW(TAG, "invalid reply: %s", reply.data);
+            sscma_client_reply_clear(&reply);
+            return;
+        }
+
+        if (client->on_connect)
+        {
+            if (name != NULL && strnstr(name->valuestring, EVENT_INIT, strlen(name->valuestring)) != NULL)
             {
-                if (client->rx_buffer.data[i] != '\0')
+                xQueueReset(client->reply_queue); // reset reply queue
+                if (xQueueSend(client->reply_queue, &reply, 0) != pdTRUE)
                 {
-                    client->rx_buffer.data[new_pos++] = client->rx_buffer.data[i];
+                    sscma_client_reply_clear(&reply);
                 }
+                return;
             }
-            client->rx_buffer.pos = new_pos;
+        }
 
+        if (type->valueint == CMD_TYPE_RESPONSE)
+        {
+            xSemaphoreTake(client->request_lock, portMAX_DELAY);
+            sscma_client_request_t *request = sscma_client_request_find(client, name->valuestring);
+            if (request != NULL)
+            {
+                sscma_client_request_complete(client, request, &reply);
+                return;
+            }
+            xSemaphoreGive(client->request_lock);
 
-            client->rx_buffer.data[client->rx_buffer.pos] = 0;
-            while ((suffix = strnstr(client->rx_buffer.data, RESPONSE_SUFFIX, client->rx_buffer.pos)) != NULL)
+            ESP_LOGW(TAG, "request not found: %s", name->valuestring);
+            if (client->on_response == NULL || xQueueSend(client->reply_queue, &reply, 0) != pdTRUE)
+            {
+                sscma_client_reply_clear(&reply); // discard this reply
+            }
+        }
+        else if (type->valueint == CMD_TYPE_LOG)
+        {
+            cJSON *code = cJSON_GetObjectItem(reply.payload, "code");
+            if (code == NULL)
             {
-                if ((prefix = strnstr(client->rx_buffer.data, RESPONSE_PREFIX, suffix - client->rx_buffer.data)) != NULL)
+                ESP_LOGW(TAG, "invalid log: %s", reply.data);
+                sscma_client_reply_clear(&reply);
+                return;
+            }
+            if (code->valueint == CMD_EINVAL)
+            { // unkown command
+                cJSON *data = cJSON_GetObjectItem(reply.payload, "data");
+                if (data == NULL)
                 {
-                    int len = suffix - prefix + RESPONSE_SUFFIX_LEN;
-                    reply.data = (char *)__malloc(len + 1);
-                    if (reply.data != NULL)
-                    {
-                        reply.len = len;
-                        memcpy(reply.data, prefix, len);
-
-                        // delete this reply from rx buffer
-                        memmove(client->rx_buffer.data, suffix + RESPONSE_SUFFIX_LEN, client->rx_buffer.pos - (suffix - client->rx_buffer.data) - RESPONSE_PREFIX_LEN);
-                        client->rx_buffer.pos -= len;
-
-                        reply.data[len] = 0;
-                        reply.payload = cJSON_Parse(reply.data);
-                        if (reply.payload != NULL)
-                        {
-                            cJSON *type = cJSON_GetObjectItem(reply.payload, "type");
-                            cJSON *name = cJSON_GetObjectItem(reply.payload, "name");
+                    ESP_LOGW(TAG, "invalid log: %s", reply.data);
+                    sscma_client_reply_clear(&reply);
+                    return;
+                }
+                xSemaphoreTake(client->request_lock, portMAX_DELAY);
+                sscma_client_request_t *request = sscma_client_request_find_in(client, data->valuestring);
+                if (request != NULL)
+                {
+                    sscma_client_request_complete(client, request, &reply);
+                    return;
+                }
+                xSemaphoreGive(client->request_lock);
 
-                            if (type == NULL || name == NULL)
-                            {
-                                ESP_LOGW(TAG, "invalid reply: %s", reply.data);
-                                sscma_client_reply_clear(&reply);
-                                continue;
-                            }
+                ESP_LOGW(TAG, "request not found: %s", name->valuestring);
+                if (client->on_log == NULL || xQueueSend(client->reply_queue, &reply, 0) != pdTRUE)
+                {
+                    sscma_client_reply_clear(&reply); // discard this reply
+                }
+            }
+            else
+            {
+                if (client->on_log == NULL || xQueueSend(client->reply_queue, &reply, 0) != pdTRUE)
+                {
+                    sscma_client_reply_clear(&reply); // discard this reply
+                }
+            }
+        }
+        else if (type->valueint == CMD_TYPE_EVENT)
+        {
+            sscma_client_dispatch_event(client, reply);
+        }
+        else
+        {
+            ESP_LOGW(TAG, "Invalid reply: %s", reply.data);
+            sscma_client_reply_clear(&reply);
+        }
+    }
+    else
+    {
+        ESP_LOGW(TAG, "Invalid reply: %s cc", reply.data);
+        sscma_client_reply_clear(&reply);
+    }
+}
 
-                            if (client->on_connect)
-                            {
-                                if (name != NULL && strnstr(name->valuestring, EVENT_INIT, strlen(name->valuestring)) != NULL)
-                                {
-                                    xQueueReset(client->reply_queue); // reset reply queue
-                                    if (xQueueSend(client->reply_queue, &reply, 0) != pdTRUE)
-                                    {
-                                        sscma_client_reply_clear(&reply);
-                                    }
-                                    continue;
-                                }
-                            }
+// Ask the process task to expect binary frames or not, from the bytes it reads next on
+static void sscma_client_set_rx_binary(sscma_client_handle_t client, bool binary)
+{
+    xSemaphoreTake(client->request_lock, portMAX_DELAY);
+    client->rx_binary = binary;
+    xSemaphoreGive(client->request_lock);
+}
 
-                            if (type->valueint == CMD_TYPE_RESPONSE)
-                            {
-                                sscma_client_request_t *first_req, *next_req = NULL;
-                                bool found = false;
-                                if (listCURRENT_LIST_LENGTH(client->request_list) > (UBaseType_t)0)
-                                {
-                                    listGET_OWNER_OF_NEXT_ENTRY(first_req, client->request_list);
-                                    do
-                                    {
-                                        listGET_OWNER_OF_NEXT_ENTRY(next_req, client->request_list);
-                                        if (strncmp(next_req->cmd, name->valuestring, sizeof(next_req->cmd)) == 0)
-                                        {
-                                            if (next_req->reply)
-                                            {
-                                                found = true;
-                                                if (xQueueSend(next_req->reply, &reply, 0) != pdTRUE)
-                                                {
-                                                    sscma_client_reply_clear(&reply); // discard this reply
-                                                }
-                                                break;
-                                            }
-                                        }
-                                    }
-                                    while (next_req != first_req);
-                                }
-                                if (!found)
-                                {
-                                    ESP_LOGW(TAG, "request not found: %s", name->valuestring);
-                                    if (client->on_response == NULL || xQueueSend(client->reply_queue, &reply, 0) != pdTRUE)
-                                    {
-                                        sscma_client_reply_clear(&reply); // discard this reply
-                                    }
-                                }
-                            }
-                            else if (type->valueint == CMD_TYPE_LOG)
-                            {
-                                cJSON *code = cJSON_GetObjectItem(reply.payload, "code");
-                                if (code == NULL)
-                                {
-                                    ESP_LOGW(TAG, "invalid log: %s", reply.data);
-                                    sscma_client_reply_clear(&reply);
-                                    continue;
-                                }
-                                if (code->valueint == CMD_EINVAL)
-                                { // unkown command
-                                    cJSON *data = cJSON_GetObjectItem(reply.payload, "data");
-                                    if (data == NULL)
-                                    {
-                                        ESP_LOGW(TAG, "invalid log: %s", reply.data);
-                                        sscma_client_reply_clear(&reply);
-                                        continue;
-                                    }
-                                    sscma_client_request_t *first_req, *next_req = NULL;
-                                    bool found = false;
-                                    if (listCURRENT_LIST_LENGTH(client->request_list) > (UBaseType_t)0)
-                                    {
-                                        listGET_OWNER_OF_NEXT_ENTRY(first_req, client->request_list);
-                                        do
-                                        {
-                                            listGET_OWNER_OF_NEXT_ENTRY(next_req, client->request_list);
-                                            if (strnstr(data->valuestring, next_req->cmd, strlen(data->valuestring)) != NULL)
-                                            {
-                                                if (next_req->reply)
-                                                {
-                                                    found = true;
-                                                    if (xQueueSend(next_req->reply, &reply, 0) != pdTRUE)
-                                                    {
-                                                        sscma_client_reply_clear(&reply); // discard this reply
-                                                    }
-                                                    break;
-                                                }
-                                            }
-                                        }
-                                        while (next_req != first_req);
-                                    }
-                                    if (!found)
-                                    {
-                                        ESP_LOGW(TAG, "request not found: %s", name->valuestring);
-                                        if (client->on_log == NULL || xQueueSend(client->reply_queue, &reply, 0) != pdTRUE)
-                                        {
-                                            sscma_client_reply_clear(&reply); // discard this reply
-                                        }
-                                    }
-                                }
-                                else
-                                {
-                                    if (client->on_log == NULL || xQueueSend(client->reply_queue, &reply, 0) != pdTRUE)
-                                    {
-                                        sscma_client_reply_clear(&reply); // discard this reply
-                                    }
-                                }
-                            }
-                            else if (type->valueint == CMD_TYPE_EVENT)
-                            {
-                                sscma_client_request_t *first_req, *next_req = NULL;
-                                bool found = false;
-                                // discard all the events while AT+BREAK is found
-                                if (listCURRENT_LIST_LENGTH(client->request_list) > (UBaseType_t)0)
-                                {
-                                    listGET_OWNER_OF_NEXT_ENTRY(first_req, client->request_list);
-                                    do
-                                    {
-                                        listGET_OWNER_OF_NEXT_ENTRY(next_req, client->request_list);
-                                        if (strnstr(next_req->cmd, CMD_AT_BREAK, strlen(next_req->cmd)) != NULL)
-                                        {
-                                            found = true;
-                                            break;
-                                        }
-                                    }
-                                    while (next_req != first_req);
-                                }
-                                if (client->on_event == NULL || found || xQueueSend(client->reply_queue, &reply, 0) != pdTRUE)
-                                {
-                                    sscma_client_reply_clear(&reply); // discard this reply
-                                }
-                            }
-                            else
-                            {
-                                ESP_LOGW(TAG, "Invalid reply: %s", reply.data);
-                                sscma_client_reply_clear(&reply);
-                            }
-                        }
-                        else
-                        {
-                            ESP_LOGW(TAG, "Invalid reply: %s cc", reply.data);
-                            sscma_client_reply_clear(&reply);
-                        }
-                    }else{
-                        printf("reply.data == NULL\r\n");
-                        client->rx_buffer.pos -= len;
-                    }
+static void sscma_client_process(void *arg)
+{
+    size_t rlen = 0;
+    size_t len = 0;
+    size_t space = 0;
+    char *data = NULL;
+    sscma_client_frame_t frame;
+    sscma_client_handle_t client = (sscma_client_handle_t)arg;
+    sscma_client_reply_t reply;
+    bool binary = false;
+    while (true)
+    {
+        if (client->process_task.notify)
+        {
+            ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(SSCMA_CLIENT_NOTIFY_TIMEOUT_MS));
+        }
+        else
+        {
+            vTaskDelay(pdMS_TO_TICKS(SSCMA_CLIENT_POLL_INTERVAL_MS));
+        }
+        if (client->inited == false)
+        {
+            continue;
+        }
+        sscma_client_request_expire(client);
+        // drain everything that is available before sleeping again
+        while (sscma_client_available(client, &rlen) == ESP_OK && rlen)
+        {
+            // what is available is read up to the wrap of the ring and then on from its start,
+            // without asking the device again
+            while (rlen > 0)
+            {
+                data = sscma_client_framer_write_ptr(&client->rx_buffer, &space);
+                if (space == 0)
+                {
+                    ESP_LOGW(TAG, "rx buffer is full");
+                    sscma_client_framer_reset(&client->rx_buffer);
+                    continue;
+                }
+                len = rlen > space ? space : rlen;
+
+                if (sscma_client_read(client, data, len) != ESP_OK)
+                {
+                    break;
                 }
-                else
+                // the framing is switched before the command that switches the device is sent, so
+                // bytes read after the switch are all framed the new way
+                xSemaphoreTake(client->request_lock, portMAX_DELAY);
+                binary = client->rx_binary;
+                xSemaphoreGive(client->request_lock);
+                sscma_client_framer_set_binary(&client->rx_buffer, binary);
+                sscma_client_framer_commit(&client->rx_buffer, len);
+                rlen -= len;
+
+                // only the bytes just received are scanned, frames are copied straight out of the ring
+                while (sscma_client_framer_next(&client->rx_buffer, &frame))
                 {
-                    // discard this reply
-                    ESP_LOGW(TAG, "Invalid reply: %d/%d", client->rx_buffer.pos, client->rx_buffer.len);
-                    memmove(client->rx_buffer.data, suffix + RESPONSE_SUFFIX_LEN, client->rx_buffer.pos - (suffix - client->rx_buffer.data) - RESPONSE_PREFIX_LEN);
-                    client->rx_buffer.pos -= suffix - client->rx_buffer.data + RESPONSE_SUFFIX_LEN;
-                    client->rx_buffer.data[client->rx_buffer.pos] = 0;
+                    reply.data = sscma_client_pool_alloc(&client->reply_pool, frame.len + 1);
+                    if (reply.data == NULL)
+                    {
+                        ESP_LOGW(TAG, "no mem for reply: %d", frame.len);
+                        continue;
+                    }
+                    reply.len = frame.len;
+                    sscma_client_frame_copy(&frame, reply.data);
+                    sscma_client_dispatch(client, reply);
                 }
             }
+            if (rlen > 0)
+            {
+                break; // read failed
+            }
         }
     }
 }
@@ -446,6 +799,7 @@ esp_err_t sscma_client_new(const sscma_client_io_handle_t io, const sscma_client
     ESP_GOTO_ON_FALSE(client, ESP_ERR_NO_MEM, err, TAG, "no mem for sscma client");
     client->io = io;
     client->inited = false;
+    client->binary_framing = config->flags.binary_framing;
     client->flasher = NULL;
 
     if (config->reset_gpio_num >= 0)
@@ -466,10 +820,9 @@ esp_err_t sscma_client_new(const sscma_client_io_handle_t io, const sscma_client
         }
     }
 
-    client->rx_buffer.data = (char *)malloc(config->rx_buffer_size);
-    ESP_GOTO_ON_FALSE(client->rx_buffer.data, ESP_ERR_NO_MEM, err, TAG, "no mem for rx buffer");
-    client->rx_buffer.pos = 0;
-    client->rx_buffer.len = config->rx_buffer_size;
+    char *rx_data = (char *)malloc(config->rx_buffer_size);
+    ESP_GOTO_ON_FALSE(rx_data, ESP_ERR_NO_MEM, err, TAG, "no mem for rx buffer");
+    sscma_client_framer_init(&client->rx_buffer, rx_data, config->rx_buffer_size);
 
     client->tx_buffer.data = (char *)malloc(config->tx_buffer_size);
     ESP_GOTO_ON_FALSE(client->tx_buffer.data, ESP_ERR_NO_MEM, err, TAG, "no mem for tx buffer");
@@ -481,13 +834,29 @@ esp_err_t sscma_client_new(const sscma_client_io_handle_t io, const sscma_client
 
     client->user_ctx = config->user_ctx;
 
-    client->request_list = (List_t *)malloc(sizeof(List_t));
-    ESP_GOTO_ON_FALSE(client->request_list, ESP_ERR_NO_MEM, err, TAG, "no mem for request list");
+    client->request_lock = xSemaphoreCreateMutex();
+    ESP_GOTO_ON_FALSE(client->request_lock, ESP_ERR_NO_MEM, err, TAG, "no mem for request lock");
+    client->tx_lock = xSemaphoreCreateMutex();
+    ESP_GOTO_ON_FALSE(client->tx_lock, ESP_ERR_NO_MEM, err, TAG, "no mem for tx lock");
+
+    client->request_seq = 0;
+    for (int i = 0; i < SSCMA_CLIENT_REQUEST_SLOTS; i++)
+    {
+        client->requests[i].state = SSCMA_CLIENT_REQUEST_FREE;
+        client->requests[i].done = xSemaphoreCreateBinaryStatic(&client->requests[i].done_buffer);
+    }
 
     client->reply_queue = xQueueCreate(config->event_queue_size, sizeof(sscma_client_reply_t));
     ESP_GOTO_ON_FALSE(client->reply_queue, ESP_ERR_NO_MEM, err, TAG, "no mem for reply queue");
 
-    vListInitialise(client->request_list);
+    // a frame never outgrows the RX buffer, nor does a large block need to
+    sscma_client_pool_config_t pool_config = {
+        .slab_size = config->reply_slab_size,
+        .slabs = config->reply_slabs,
+        .large_size = config->reply_large_size > 0 ? config->reply_large_size : config->rx_buffer_size,
+        .large_blocks = config->reply_large_blocks,
+    };
+    ESP_GOTO_ON_FALSE(sscma_client_pool_init(&client->reply_pool, &pool_config), ESP_ERR_NO_MEM, err, TAG, "no mem for reply pool");
 
 #ifdef CONFIG_SSCMA_PROCESS_TASK_STACK_ALLOC_EXTERNAL
     client->process_task.task = heap_caps_calloc(1, sizeof(StaticTask_t), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
@@ -552,6 +921,11 @@ esp_err_t sscma_client_new(const sscma_client_io_handle_t io, const sscma_client
     client->on_response = NULL;
     client->on_event = NULL;
     client->on_log = NULL;
+
+    // transports without a data-ready signal are polled
+    client->process_task.notify = sscma_client_io_set_ready_cb(io, sscma_client_io_ready, client) == ESP_OK;
+    ESP_LOGD(TAG, "process task %s", client->process_task.notify ? "notified by io" : "polling io");
+
     *ret_client = client;
 
     ESP_LOGD(TAG, "new sscma client @%p", client);
@@ -580,9 +954,14 @@ err:
         {
             vQueueDelete(client->reply_queue);
         }
-        if (client->request_list)
+        sscma_client_pool_deinit(&client->reply_pool);
+        if (client->request_lock)
+        {
+            vSemaphoreDelete(client->request_lock);
+        }
+        if (client->tx_lock)
         {
-            free(client->request_list);
+            vSemaphoreDelete(client->tx_lock);
         }
         if (client->process_task.handle)
         {
@@ -621,6 +1000,14 @@ esp_err_t sscma_client_del(sscma_client_handle_t client)
 {
     if (client)
     {
+        // stop the tasks before the queue, locks and buffers they use go away
+        if (client->process_task.notify)
+        {
+            sscma_client_io_set_ready_cb(client->io, NULL, NULL);
+        }
+        vTaskDelete(client->process_task.handle);
+        vTaskDelete(client->monitor_task.handle);
+
         if (client->reset_gpio_num >= 0)
         {
             if (client->io_expander)
@@ -640,27 +1027,41 @@ esp_err_t sscma_client_del(sscma_client_handle_t client)
                 gpio_reset_pin(client->reset_gpio_num);
             }
         }
+
+        sscma_client_reply_t reply;
+        while (xQueueReceive(client->reply_queue, &reply, 0) == pdTRUE)
+        {
+            sscma_client_reply_clear(&reply);
+        }
         vQueueDelete(client->reply_queue);
 
-        sscma_client_request_t *first_req, *next_req = NULL;
-        if (listCURRENT_LIST_LENGTH(client->request_list) > (UBaseType_t)0)
+        for (int i = 0; i < SSCMA_CLIENT_REQUEST_SLOTS; i++)
         {
-            listGET_OWNER_OF_NEXT_ENTRY(first_req, client->request_list);
-            do
+            sscma_client_request_t *request = &client->requests[i];
+            if (request->state == SSCMA_CLIENT_REQUEST_DONE)
             {
-                listGET_OWNER_OF_NEXT_ENTRY(next_req, client->request_list);
-                uxListRemove(&(next_req->item));
-                vQueueDelete(next_req->reply);
-                free(next_req);
+                sscma_client_reply_clear(&request->reply);
             }
-            while (next_req != first_req);
+            vSemaphoreDelete(request->done);
+        }
+
+        // replies retained with sscma_client_reply_retain point into the pool and release into it,
+        // give their owners a moment and keep the pool and the client if they are still held
+        int retained = sscma_client_pool_in_use(&client->reply_pool);
+        for (int waited = 0; retained != 0 && waited < SSCMA_CLIENT_DEL_RELEASE_TIMEOUT_MS; waited += SSCMA_CLIENT_POLL_INTERVAL_MS)
+        {
+            vTaskDelay(pdMS_TO_TICKS(SSCMA_CLIENT_POLL_INTERVAL_MS));
+            retained = sscma_client_pool_in_use(&client->reply_pool);
+        }
+        if (retained == 0)
+        {
+            sscma_client_pool_deinit(&client->reply_pool);
         }
+        vSemaphoreDelete(client->request_lock);
+        vSemaphoreDelete(client->tx_lock);
 
-        free(client->request_list);
         free(client->rx_buffer.data);
         free(client->tx_buffer.data);
-        vTaskDelete(client->process_task.handle);
-        vTaskDelete(client->monitor_task.handle);
 
 #ifdef CONFIG_SSCMA_PROCESS_TASK_STACK_ALLOC_EXTERNAL
         free(client->process_task.stack);
@@ -725,6 +1126,11 @@ esp_err_t sscma_client_del(sscma_client_handle_t client)
             }
         }
 
+        if (retained != 0)
+        {
+            ESP_LOGE(TAG, "%d replies still retained, keeping the reply pool", retained);
+            return ESP_ERR_INVALID_STATE;
+        }
         free(client);
     }
     return ESP_OK;
@@ -736,6 +1142,10 @@ esp_err_t sscma_client_init(sscma_client_handle_t client)
     {
         sscma_client_reset(client);
         client->inited = true;
+        if (client->binary_framing && sscma_client_set_framing(client, true) != ESP_OK)
+        {
+            ESP_LOGW(TAG, "binary framing not available, using JSON");
+        }
     }
 
     memset(&client->info, 0, sizeof(sscma_client_info_t));
@@ -747,9 +1157,11 @@ esp_err_t sscma_client_init(sscma_client_handle_t client)
 esp_err_t sscma_client_reset(sscma_client_handle_t client)
 {
     esp_err_t ret = ESP_OK;
+    // before the process task is suspended, it may be holding request_lock
+    sscma_client_set_rx_binary(client, false); // the device starts with JSON
     vTaskSuspend(client->process_task.handle);
 
-    client->rx_buffer.pos = 0;
+    sscma_client_framer_reset(&client->rx_buffer);
     client->tx_buffer.pos = 0;
 
     // perform hardware reset
@@ -826,59 +1238,108 @@ esp_err_t sscma_client_register_callback(sscma_client_handle_t client, const ssc
     return ESP_OK;
 }
 
+// Write cmd, with the tag of its request when it has one
+static esp_err_t sscma_client_write_command(sscma_client_handle_t client, const char *cmd, uint16_t tag)
+{
+    esp_err_t ret = ESP_OK;
+
+    xSemaphoreTake(client->tx_lock, portMAX_DELAY);
+    if (tag == 0)
+    {
+        ret = sscma_client_write(client, cmd, strlen(cmd));
+    }
+    else
+    {
+        int len = snprintf(client->tx_buffer.data, client->tx_buffer.len, CMD_PREFIX "%u@%s", tag, cmd + CMD_PREFIX_LEN);
+        ret = sscma_client_write(client, client->tx_buffer.data, len);
+    }
+    xSemaphoreGive(client->tx_lock);
+
+    return ret;
+}
+
+static inline bool sscma_client_can_tag(sscma_client_handle_t client, const char *cmd)
+{
+    return strlen(cmd) + 6 < client->tx_buffer.len; // room for "65535@"
+}
+
 esp_err_t sscma_client_request(sscma_client_handle_t client, const char *cmd, sscma_client_reply_t *reply, bool wait, TickType_t timeout)
 {
     esp_err_t ret = ESP_OK;
     sscma_client_request_t *request = NULL;
 
-    if (wait)
+    if (!wait)
     {
-        request = (sscma_client_request_t *)__malloc(sizeof(sscma_client_request_t));
-        ESP_GOTO_ON_FALSE(request, ESP_ERR_NO_MEM, err, TAG, "no mem for request");
-        request->reply = xQueueCreate(1, sizeof(sscma_client_reply_t));
-        strncpy(request->cmd, &cmd[CMD_PREFIX_LEN], sizeof(request->cmd) - 1);
-        request->cmd[sizeof(request->cmd) - 1] = '\0';
-        for (int i = 0; i < sizeof(request->cmd); i++)
-        {
-            if (request->cmd[i] == '\n' || request->cmd[i] == '\r' || request->cmd[i] == '=')
-            {
-                request->cmd[i] = '\0';
-            }
-        }
-        ESP_GOTO_ON_FALSE(request->reply, ESP_ERR_NO_MEM, err, TAG, "no mem for reply");
-        vListInitialiseItem(&(request->item));
-        listSET_LIST_ITEM_OWNER(&(request->item), request);
-        vListInsertEnd(client->request_list, &(request->item));
+        return sscma_client_write_command(client, cmd, 0);
     }
 
-    ESP_GOTO_ON_ERROR(sscma_client_write(client, cmd, strlen(cmd)), err, TAG, "write command failed");
+    xSemaphoreTake(client->request_lock, portMAX_DELAY);
+    request = sscma_client_request_alloc(client, cmd, sscma_client_can_tag(client, cmd));
+    xSemaphoreGive(client->request_lock);
+    ESP_RETURN_ON_FALSE(request, ESP_ERR_NO_MEM, TAG, "no free request slot");
+
+    ESP_GOTO_ON_ERROR(sscma_client_write_command(client, cmd, request->tag), err, TAG, "write command failed");
+
+    ret = ESP_ERR_TIMEOUT;
+    xSemaphoreTake(request->done, timeout);
 
-    if (wait)
+err:
+    xSemaphoreTake(client->request_lock, portMAX_DELAY);
+    if (request->state == SSCMA_CLIENT_REQUEST_DONE)
     {
-        if (xQueueReceive(request->reply, reply, timeout) == pdTRUE)
-        {
-            ret = ESP_OK;
-        }
-        else
-        {
-            ret = ESP_ERR_TIMEOUT;
-        }
+        // the reply may have come in right after the wait timed out
+        xSemaphoreTake(request->done, 0);
+        *reply = request->reply;
+        ret = ESP_OK;
     }
+    request->state = SSCMA_CLIENT_REQUEST_FREE;
+    xSemaphoreGive(client->request_lock);
 
-err:
-    if (wait)
+    return ret;
+}
+
+esp_err_t sscma_client_request_async(sscma_client_handle_t client, const char *cmd, sscma_client_request_cb_t cb, void *user_ctx, TickType_t timeout)
+{
+    esp_err_t ret = ESP_OK;
+    sscma_client_request_t *request = NULL;
+    uint16_t tag = 0;
+    uint32_t hash = 0;
+
+    ESP_RETURN_ON_FALSE(client && cmd && cb, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+
+    xSemaphoreTake(client->request_lock, portMAX_DELAY);
+    request = sscma_client_request_alloc(client, cmd, sscma_client_can_tag(client, cmd));
+    if (request != NULL)
+    {
+        request->cb = cb;
+        request->user_ctx = user_ctx;
+        tag = request->tag;
+        hash = request->hash;
+    }
+    xSemaphoreGive(client->request_lock);
+    ESP_RETURN_ON_FALSE(request, ESP_ERR_NO_MEM, TAG, "no free request slot");
+
+    ret = sscma_client_write_command(client, cmd, tag);
+
+    xSemaphoreTake(client->request_lock, portMAX_DELAY);
+    // the reply may already have completed the request and the slot been reused
+    if (request->state == SSCMA_CLIENT_REQUEST_PENDING && request->tag == tag && request->hash == hash && request->cb == cb)
     {
-        if (listIS_CONTAINED_WITHIN(client->request_list, &(request->item)))
+        if (ret != ESP_OK)
         {
-            uxListRemove(&(request->item));
+            request->state = SSCMA_CLIENT_REQUEST_FREE;
         }
-        if (request)
+        else
         {
-            vQueueDelete(request->reply);
-            free(request);
+            request->deadline = xTaskGetTickCount() + timeout;
+            request->state = SSCMA_CLIENT_REQUEST_SENT;
         }
     }
-    return ret;
+    xSemaphoreGive(client->request_lock);
+
+    ESP_RETURN_ON_ERROR(ret, TAG, "write command failed");
+
+    return ESP_OK;
 }
 
 esp_err_t sscma_client_get_info(sscma_client_handle_t client, sscma_client_info_t **info, bool cached)
@@ -1172,6 +1633,53 @@ esp_err_t sscma_client_break(sscma_client_handle_t client)
     return ret;
 }
 
+esp_err_t sscma_client_set_framing(sscma_client_handle_t client, bool binary)
+{
+    esp_err_t ret = ESP_OK;
+    sscma_client_reply_t reply;
+    char cmd[64] = { 0 };
+
+    if (binary)
+    {
+        // older firmware answers with the unknown command log
+        ESP_RETURN_ON_ERROR(sscma_client_request(client, CMD_PREFIX CMD_AT_FRAMING CMD_QUERY CMD_SUFFIX, &reply, true, CMD_WAIT_DELAY), TAG, "request get framing failed");
+        if (reply.payload != NULL)
+        {
+            int type = get_int_from_object(reply.payload, "type");
+            int code = get_int_from_object(reply.payload, "code");
+            int modes = get_int_from_object(reply.payload, "data");
+            if (type != CMD_TYPE_RESPONSE || code != CMD_OK || !(modes & SSCMA_CLIENT_FRAMING_BINARY))
+            {
+                ret = ESP_ERR_NOT_SUPPORTED;
+            }
+            sscma_client_reply_clear(&reply);
+        }
+        ESP_RETURN_ON_ERROR(ret, TAG, "binary framing not supported");
+        // the first binary event may follow the response in the same read
+        sscma_client_set_rx_binary(client, true);
+    }
+
+    snprintf(cmd, sizeof(cmd), CMD_PREFIX CMD_AT_FRAMING CMD_SET "%d" CMD_SUFFIX, binary ? 1 : 0);
+
+    ret = sscma_client_request(client, cmd, &reply, true, CMD_WAIT_DELAY);
+    if (ret == ESP_OK && reply.payload != NULL)
+    {
+        int code = get_int_from_object(reply.payload, "code");
+        ret = SSCMA_CLIENT_CMD_ERROR_CODE(code);
+        sscma_client_reply_clear(&reply);
+    }
+    if (ret != ESP_OK)
+    {
+        // the device keeps the framing it had
+        sscma_client_set_rx_binary(client, !binary);
+        ESP_LOGE(TAG, "request set framing failed");
+        return ret;
+    }
+    sscma_client_set_rx_binary(client, binary);
+
+    return ret;
+}
+
 esp_err_t sscma_client_set_iou_threshold(sscma_client_handle_t client, int threshold)
 {
     esp_err_t ret = ESP_OK;
@@ -1318,11 +1826,26 @@ esp_err_t sscma_utils_fetch_boxes_from_reply(const sscma_client_reply_t *reply,
     ESP_RETURN_ON_FALSE(reply != NULL, ESP_ERR_INVALID_ARG, TAG, "reply is NULL");
     ESP_RETURN_ON_FALSE(boxes != NULL, ESP_ERR_INVALID_ARG, TAG, "boxes is NULL");
     ESP_RETURN_ON_FALSE(num_boxes != NULL, ESP_ERR_INVALID_ARG, TAG, "num_boxes is NULL");
-    ESP_RETURN_ON_FALSE(cJSON_IsObject(reply->payload), ESP_ERR_INVALID_ARG, TAG, "reply is not object");
 
     *boxes = NULL;
     *num_boxes = 0;
 
+    sscma_client_inference_t inference = { 0 };
+    if (sscma_client_scan_inference(reply, &inference))
+    {
+        if (inference.num_boxes == 0)
+            return ESP_OK;
+        inference.boxes = __malloc(sizeof(sscma_client_box_t) * inference.num_boxes);
+        ESP_RETURN_ON_FALSE(inference.boxes != NULL, ESP_ERR_NO_MEM, TAG, "malloc boxes failed");
+        inference.max_boxes = inference.num_boxes;
+        sscma_client_scan_inference(reply, &inference); // the first pass only counted them
+        *boxes = inference.boxes;
+        *num_boxes = inference.num_boxes;
+        return ESP_OK;
+    }
+
+    ESP_RETURN_ON_FALSE(cJSON_IsObject(reply->payload), ESP_ERR_INVALID_ARG, TAG, "reply is not object");
+
     cJSON *data = cJSON_GetObjectItem(reply->payload, "data");
     if (data != NULL)
     {
@@ -1359,10 +1882,18 @@ esp_err_t sscma_utils_copy_boxes_from_reply(const sscma_client_reply_t *reply, s
     ESP_RETURN_ON_FALSE(reply != NULL, ESP_ERR_INVALID_ARG, TAG, "reply is NULL");
     ESP_RETURN_ON_FALSE(boxes != NULL, ESP_ERR_INVALID_ARG, TAG, "classes is NULL");
     ESP_RETURN_ON_FALSE(num_boxes != NULL, ESP_ERR_INVALID_ARG, TAG, "num_classes is NULL");
-    ESP_RETURN_ON_FALSE(cJSON_IsObject(reply->payload), ESP_ERR_INVALID_ARG, TAG, "reply is not object");
 
     *num_boxes = 0;
 
+    sscma_client_inference_t inference = { .boxes = boxes, .max_boxes = max_boxes };
+    if (sscma_client_scan_inference(reply, &inference))
+    {
+        *num_boxes = inference.num_boxes > max_boxes ? max_boxes : inference.num_boxes;
+        return ESP_OK;
+    }
+
+    ESP_RETURN_ON_FALSE(cJSON_IsObject(reply->payload), ESP_ERR_INVALID_ARG, TAG, "reply is not object");
+
     cJSON *data = cJSON_GetObjectItem(reply->payload, "data");
     if (data != NULL)
     {
@@ -1396,11 +1927,26 @@ esp_err_t sscma_utils_fetch_classes_from_reply(const sscma_client_reply_t *reply
     ESP_RETURN_ON_FALSE(reply != NULL, ESP_ERR_INVALID_ARG, TAG, "reply is NULL");
     ESP_RETURN_ON_FALSE(classes != NULL, ESP_ERR_INVALID_ARG, TAG, "classes is NULL");
     ESP_RETURN_ON_FALSE(num_classes != NULL, ESP_ERR_INVALID_ARG, TAG, "num_classes is NULL");
-    ESP_RETURN_ON_FALSE(cJSON_IsObject(reply->payload), ESP_ERR_INVALID_ARG, TAG, "reply is not object");
 
     *classes = NULL;
     *num_classes = 0;
 
+    sscma_client_inference_t inference = { 0 };
+    if (sscma_client_scan_inference(reply, &inference))
+    {
+        if (inference.num_classes == 0)
+            return ESP_OK;
+        inference.classes = __malloc(sizeof(sscma_client_class_t) * inference.num_classes);
+        ESP_RETURN_ON_FALSE(inference.classes != NULL, ESP_ERR_NO_MEM, TAG, "malloc classes failed");
+        inference.max_classes = inference.num_classes;
+        sscma_client_scan_inference(reply, &inference); // the first pass only counted them
+        *classes = inference.classes;
+        *num_classes = inference.num_classes;
+        return ESP_OK;
+    }
+
+    ESP_RETURN_ON_FALSE(cJSON_IsObject(reply->payload), ESP_ERR_INVALID_ARG, TAG, "reply is not object");
+
     cJSON *data = cJSON_GetObjectItem(reply->payload, "data");
     if (data != NULL)
     {
@@ -1433,10 +1979,18 @@ esp_err_t sscma_utils_copy_classes_from_reply(const sscma_client_reply_t *reply,
     ESP_RETURN_ON_FALSE(reply != NULL, ESP_ERR_INVALID_ARG, TAG, "reply is NULL");
     ESP_RETURN_ON_FALSE(classes != NULL, ESP_ERR_INVALID_ARG, TAG, "classes is NULL");
     ESP_RETURN_ON_FALSE(num_classes != NULL, ESP_ERR_INVALID_ARG, TAG, "num_classes is NULL");
-    ESP_RETURN_ON_FALSE(cJSON_IsObject(reply->payload), ESP_ERR_INVALID_ARG, TAG, "reply is not object");
 
     *num_classes = 0;
 
+    sscma_client_inference_t inference = { .classes = classes, .max_classes = max_classes };
+    if (sscma_client_scan_inference(reply, &inference))
+    {
+        *num_classes = inference.num_classes > max_classes ? max_classes : inference.num_classes;
+        return ESP_OK;
+    }
+
+    ESP_RETURN_ON_FALSE(cJSON_IsObject(reply->payload), ESP_ERR_INVALID_ARG, TAG, "reply is not object");
+
     cJSON *data = cJSON_GetObjectItem(reply->payload, "data");
     if (data != NULL)
     {
@@ -1467,11 +2021,26 @@ esp_err_t sscma_utils_fetch_points_from_reply(const sscma_client_reply_t *reply,
     ESP_RETURN_ON_FALSE(reply != NULL, ESP_ERR_INVALID_ARG, TAG, "reply is NULL");
     ESP_RETURN_ON_FALSE(points != NULL, ESP_ERR_INVALID_ARG, TAG, "points is NULL");
     ESP_RETURN_ON_FALSE(num_points != NULL, ESP_ERR_INVALID_ARG, TAG, "num_points is NULL");
-    ESP_RETURN_ON_FALSE(cJSON_IsObject(reply->payload), ESP_ERR_INVALID_ARG, TAG, "reply is not object");
 
     *points = NULL;
     *num_points = 0;
 
+    sscma_client_inference_t inference = { 0 };
+    if (sscma_client_scan_inference(reply, &inference))
+    {
+        if (inference.num_points == 0)
+            return ESP_OK;
+        inference.points = __malloc(sizeof(sscma_client_point_t) * inference.num_points);
+        ESP_RETURN_ON_FALSE(inference.points != NULL, ESP_ERR_NO_MEM, TAG, "malloc points failed");
+        inference.max_points = inference.num_points;
+        sscma_client_scan_inference(reply, &inference); // the first pass only counted them
+        *points = inference.points;
+        *num_points = inference.num_points;
+        return ESP_OK;
+    }
+
+    ESP_RETURN_ON_FALSE(cJSON_IsObject(reply->payload), ESP_ERR_INVALID_ARG, TAG, "reply is not object");
+
     cJSON *data = cJSON_GetObjectItem(reply->payload, "data");
     if (data != NULL)
     {
@@ -1507,10 +2076,18 @@ esp_err_t sscma_utils_copy_points_from_reply(const sscma_client_reply_t *reply,
     ESP_RETURN_ON_FALSE(reply != NULL, ESP_ERR_INVALID_ARG, TAG, "reply is NULL");
     ESP_RETURN_ON_FALSE(points != NULL, ESP_ERR_INVALID_ARG, TAG, "points is NULL");
     ESP_RETURN_ON_FALSE(num_points != NULL, ESP_ERR_INVALID_ARG, TAG, "num_points is NULL");
-    ESP_RETURN_ON_FALSE(cJSON_IsObject(reply->payload), ESP_ERR_INVALID_ARG, TAG, "reply is not object");
 
     *num_points = 0;
 
+    sscma_client_inference_t inference = { .points = points, .max_points = max_points };
+    if (sscma_client_scan_inference(reply, &inference))
+    {
+        *num_points = inference.num_points > max_points ? max_points : inference.num_points;
+        return ESP_OK;
+    }
+
+    ESP_RETURN_ON_FALSE(cJSON_IsObject(reply->payload), ESP_ERR_INVALID_ARG, TAG, "reply is not object");
+
     cJSON *data = cJSON_GetObjectItem(reply->payload, "data");
     if (data != NULL)
     {
@@ -1545,11 +2122,26 @@ esp_err_t sscma_utils_fetch_keypoints_from_reply(const sscma_client_reply_t *rep
     ESP_RETURN_ON_FALSE(reply != NULL, ESP_ERR_INVALID_ARG, TAG, "reply is NULL");
     ESP_RETURN_ON_FALSE(keypoints != NULL, ESP_ERR_INVALID_ARG, TAG, "keypoints is NULL");
     ESP_RETURN_ON_FALSE(num_keypoints != NULL, ESP_ERR_INVALID_ARG, TAG, "num_keypoints is NULL");
-    ESP_RETURN_ON_FALSE(cJSON_IsObject(reply->payload), ESP_ERR_INVALID_ARG, TAG, "reply is not object");
 
     *keypoints = NULL;
     *num_keypoints = 0;
 
+    sscma_client_inference_t inference = { 0 };
+    if (sscma_client_scan_inference(reply, &inference))
+    {
+        if (inference.num_keypoints == 0)
+            return ESP_OK;
+        inference.keypoints = __malloc(sizeof(sscma_client_keypoint_t) * inference.num_keypoints);
+        ESP_RETURN_ON_FALSE(inference.keypoints != NULL, ESP_ERR_NO_MEM, TAG, "malloc keypoints failed");
+        inference.max_keypoints = inference.num_keypoints;
+        sscma_client_scan_inference(reply, &inference); // the first pass only counted them
+        *keypoints = inference.keypoints;
+        *num_keypoints = inference.num_keypoints;
+        return ESP_OK;
+    }
+
+    ESP_RETURN_ON_FALSE(cJSON_IsObject(reply->payload), ESP_ERR_INVALID_ARG, TAG, "reply is not object");
+
     cJSON *data = cJSON_GetObjectItem(reply->payload, "data");
     if (data != NULL)
     {
@@ -1604,10 +2196,18 @@ esp_err_t sscma_utils_copy_keypoints_from_reply(const sscma_client_reply_t *repl
     ESP_RETURN_ON_FALSE(reply != NULL, ESP_ERR_INVALID_ARG, TAG, "reply is NULL");
     ESP_RETURN_ON_FALSE(keypoints != NULL, ESP_ERR_INVALID_ARG, TAG, "keypoints is NULL");
     ESP_RETURN_ON_FALSE(num_keypoints != NULL, ESP_ERR_INVALID_ARG, TAG, "num_keypoints is NULL");
-    ESP_RETURN_ON_FALSE(cJSON_IsObject(reply->payload), ESP_ERR_INVALID_ARG, TAG, "reply is not object");
 
     *num_keypoints = 0;
 
+    sscma_client_inference_t inference = { .keypoints = keypoints, .max_keypoints = max_keypoints };
+    if (sscma_client_scan_inference(reply, &inference))
+    {
+        *num_keypoints = inference.num_keypoints > max_keypoints ? max_keypoints : inference.num_keypoints;
+        return ESP_OK;
+    }
+
+    ESP_RETURN_ON_FALSE(cJSON_IsObject(reply->payload), ESP_ERR_INVALID_ARG, TAG, "reply is not object");
+
     cJSON *data = cJSON_GetObjectItem(reply->payload, "data");
     if (data != NULL)
     {
@@ -1652,13 +2252,37 @@ esp_err_t sscma_utils_copy_keypoints_from_reply(const sscma_client_reply_t *repl
     return ret;
 }
 
-esp_err_t sscma_utils_fetch_image_from_reply(const sscma_client_reply_t *reply, char **image, int *image_size)
+esp_err_t sscma_utils_parse_inference_from_reply(const sscma_client_reply_t *reply, sscma_client_inference_t *inference)
+{
+    ESP_RETURN_ON_FALSE(reply && inference, ESP_ERR_INVALID_ARG, TAG, "Invalid argument(s) detected");
+
+    if (!sscma_client_scan_inference(reply, inference))
+    {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t sscma_utils_view_image_from_reply(const sscma_client_reply_t *reply, const char **image, size_t *image_size)
 {
     ESP_RETURN_ON_FALSE(reply && image && image_size, ESP_ERR_INVALID_ARG, TAG, "Invalid argument(s) detected");
 
     *image = NULL;
     *image_size = 0;
 
+    // the image of a binary frame is not base64, see sscma_utils_view_jpeg_from_reply
+    if (sscma_client_binary_is_frame(reply->data, reply->len))
+    {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    if (reply->data && sscma_client_find_image(reply->data, reply->len, image, image_size))
+    {
+        return *image_size ? ESP_OK : ESP_FAIL;
+    }
+
+    // an image with escapes is left in the payload
     if (!cJSON_IsObject(reply->payload))
     {
         return ESP_ERR_INVALID_ARG;
@@ -1670,25 +2294,86 @@ esp_err_t sscma_utils_fetch_image_from_reply(const sscma_client_reply_t *reply,
         return ESP_FAIL;
     }
 
-    cJSON *image_data = cJSON_GetObjectItem(data, "image");
-    if (!image_data)
+    const char *image_str = cJSON_GetStringValue(cJSON_GetObjectItem(data, "image"));
+    if (!image_str || !image_str[0])
     {
         return ESP_FAIL;
     }
 
-    const char *image_str = cJSON_GetStringValue(image_data);
-    if (!image_str)
+    *image = image_str;
+    *image_size = strlen(image_str);
+
+    return ESP_OK;
+}
+
+esp_err_t sscma_utils_view_jpeg_from_reply(const sscma_client_reply_t *reply, const uint8_t **jpeg, size_t *jpeg_size)
+{
+    ESP_RETURN_ON_FALSE(reply && jpeg && jpeg_size, ESP_ERR_INVALID_ARG, TAG, "Invalid argument(s) detected");
+
+    *jpeg = NULL;
+    *jpeg_size = 0;
+
+    if (!sscma_client_binary_is_frame(reply->data, reply->len))
+    {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    sscma_client_inference_t inference = { 0 };
+    if (!sscma_client_binary_decode_inference(reply->data, reply->len, &inference))
+    {
+        return ESP_ERR_INVALID_RESPONSE;
+    }
+    if (inference.image_len == 0)
     {
         return ESP_FAIL;
     }
 
-    *image = __strdup(image_str);
+    *jpeg = (const uint8_t *)inference.image;
+    *jpeg_size = inference.image_len;
+
+    return ESP_OK;
+}
+
+esp_err_t sscma_utils_fetch_image_from_reply(const sscma_client_reply_t *reply, char **image, int *image_size)
+{
+    ESP_RETURN_ON_FALSE(reply && image && image_size, ESP_ERR_INVALID_ARG, TAG, "Invalid argument(s) detected");
+
+    *image = NULL;
+    *image_size = 0;
+
+    const uint8_t *jpeg = NULL;
+    size_t jpeg_size = 0;
+    if (sscma_utils_view_jpeg_from_reply(reply, &jpeg, &jpeg_size) == ESP_OK)
+    {
+        size_t olen = 0;
+        mbedtls_base64_encode(NULL, 0, &olen, jpeg, jpeg_size);
+        *image = (char *)__malloc(olen);
+        if (!(*image))
+        {
+            return ESP_ERR_NO_MEM;
+        }
+        mbedtls_base64_encode((unsigned char *)*image, olen, &olen, jpeg, jpeg_size);
+        *image_size = olen;
+        return ESP_OK;
+    }
+
+    const char *view = NULL;
+    size_t view_size = 0;
+    esp_err_t ret = sscma_utils_view_image_from_reply(reply, &view, &view_size);
+    if (ret != ESP_OK)
+    {
+        return ret;
+    }
+
+    *image = (char *)__malloc(view_size + 1);
     if (!(*image))
     {
         return ESP_ERR_NO_MEM;
     }
+    memcpy(*image, view, view_size);
+    (*image)[view_size] = '\0';
 
-    *image_size = strlen(image_str);
+    *image_size = view_size;
 
     return ESP_OK;
 }
@@ -1697,37 +2382,77 @@ esp_err_t sscma_utils_copy_image_from_reply(const sscma_client_reply_t *reply, c
 {
     ESP_RETURN_ON_FALSE(reply && image && image_size, ESP_ERR_INVALID_ARG, TAG, "Invalid argument(s) detected");
 
-    if (!cJSON_IsObject(reply->payload))
+    const uint8_t *jpeg = NULL;
+    size_t jpeg_size = 0;
+    if (sscma_utils_view_jpeg_from_reply(reply, &jpeg, &jpeg_size) == ESP_OK)
     {
-        return ESP_ERR_INVALID_ARG;
+        size_t olen = 0;
+        // the encoder counts and writes the terminating NUL
+        if (max_image_size <= 0 || mbedtls_base64_encode((unsigned char *)image, max_image_size, &olen, jpeg, jpeg_size) != 0)
+        {
+            return ESP_ERR_INVALID_SIZE;
+        }
+        *image_size = olen;
+        return ESP_OK;
     }
 
-    cJSON *data = cJSON_GetObjectItem(reply->payload, "data");
-    if (!data)
+    const char *view = NULL;
+    size_t view_size = 0;
+    esp_err_t ret = sscma_utils_view_image_from_reply(reply, &view, &view_size);
+    if (ret != ESP_OK)
     {
-        return ESP_FAIL;
+        return ret;
     }
 
-    cJSON *image_data = cJSON_GetObjectItem(data, "image");
-    if (!image_data)
+    // room for the terminating NUL is needed too
+    if (view_size >= max_image_size)
     {
-        return ESP_FAIL;
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    *image_size = view_size;
+    memcpy(image, view, view_size);
+    image[view_size] = '\0';
+
+    return ESP_OK;
+}
+
+esp_err_t sscma_utils_decode_image_into(const sscma_client_reply_t *reply, uint8_t *dst, size_t cap, size_t *len)
+{
+    ESP_RETURN_ON_FALSE(reply && dst && len, ESP_ERR_INVALID_ARG, TAG, "Invalid argument(s) detected");
+
+    *len = 0;
+
+    const uint8_t *jpeg = NULL;
+    size_t jpeg_size = 0;
+    if (sscma_utils_view_jpeg_from_reply(reply, &jpeg, &jpeg_size) == ESP_OK)
+    {
+        if (jpeg_size > cap)
+        {
+            return ESP_ERR_INVALID_SIZE;
+        }
+        memcpy(dst, jpeg, jpeg_size);
+        *len = jpeg_size;
+        return ESP_OK;
     }
 
-    const char *image_str = cJSON_GetStringValue(image_data);
-    if (!image_str)
+    const char *view = NULL;
+    size_t view_size = 0;
+    esp_err_t ret = sscma_utils_view_image_from_reply(reply, &view, &view_size);
+    if (ret != ESP_OK)
     {
-        return ESP_FAIL;
+        return ret;
     }
 
-    size_t image_str_len = strlen(image_str);
-    if (image_str_len > max_image_size)
+    int err = mbedtls_base64_decode(dst, cap, len, (const unsigned char *)view, view_size);
+    if (err == MBEDTLS_ERR_BASE64_BUFFER_TOO_SMALL)
     {
         return ESP_ERR_INVALID_SIZE;
     }
-
-    *image_size = image_str_len;
-    strcpy(image, image_str);
+    if (err != 0)
+    {
+        return ESP_ERR_INVALID_RESPONSE;
+    }
 
     return ESP_OK;
 }
@@ -0,0 +1,214 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "sdkconfig.h"
+#include "esp_heap_caps.h"
+
+#include "sscma_client_pool.h"
+
+#define POOL_ALIGN(x) (((x) + 7) & ~(size_t)7)
+
+enum
+{
+    POOL_SLAB,
+    POOL_LARGE,
+    POOL_HEAP,
+};
+
+// Precedes every buffer handed out
+typedef struct
+{
+    sscma_client_pool_t *pool; // Owner
+    uint32_t refs;             // References, changed atomically
+    uint16_t index;            // Block in its class
+    uint8_t kind;              // Slab, large or heap
+} pool_header_t;
+
+#define POOL_HEADER_SIZE POOL_ALIGN(sizeof(pool_header_t))
+
+static inline pool_header_t *pool_header(char *data)
+{
+    return (pool_header_t *)(data - POOL_HEADER_SIZE);
+}
+
+static void *pool_heap_alloc(size_t size, bool large)
+{
+    void *p = NULL;
+
+#ifdef CONFIG_SSCMA_ALLOC_SMALL_SHORTTERM_MEM_EXTERNALLY
+    large = true;
+#endif
+    if (large)
+    {
+        p = heap_caps_malloc(size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    }
+    return p != NULL ? p : malloc(size);
+}
+
+static inline void pool_raise(uint32_t *high, uint32_t value)
+{
+    uint32_t seen = __atomic_load_n(high, __ATOMIC_RELAXED);
+    while (value > seen && !__atomic_compare_exchange_n(high, &seen, value, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+    {
+    }
+}
+
+static bool pool_class_init(sscma_client_pool_class_t *class, size_t size, int count, bool large)
+{
+    memset(class, 0, sizeof(*class));
+    if (size == 0 || count <= 0)
+    {
+        return true;
+    }
+    if (count > UINT16_MAX)
+    {
+        return false;
+    }
+    class->size = POOL_ALIGN(size);
+    class->stride = POOL_HEADER_SIZE + class->size;
+    class->count = count;
+    class->storage = (char *)pool_heap_alloc(class->stride * count, large);
+    class->used = (uint32_t *)calloc((count + 31) / 32, sizeof(uint32_t));
+    if (class->storage == NULL || class->used == NULL)
+    {
+        free(class->storage);
+        free(class->used);
+        memset(class, 0, sizeof(*class));
+        return false;
+    }
+    return true;
+}
+
+// Claim a free block of the class, NULL if all are held
+static pool_header_t *pool_class_take(sscma_client_pool_class_t *class)
+{
+    for (int word = 0; word * 32 < class->count; word++)
+    {
+        uint32_t used = __atomic_load_n(&class->used[word], __ATOMIC_RELAXED);
+        while (~used != 0)
+        {
+            int bit = __builtin_ctz(~used);
+            int index = word * 32 + bit;
+            if (index >= class->count)
+            {
+                break;
+            }
+            if (__atomic_compare_exchange_n(&class->used[word], &used, used | (1u << bit), true, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+            {
+                pool_raise(&class->high, __atomic_add_fetch(&class->in_use, 1, __ATOMIC_RELAXED));
+                pool_header_t *header = (pool_header_t *)(class->storage + (size_t)index * class->stride);
+                header->index = index;
+                return header;
+            }
+        }
+    }
+    return NULL;
+}
+
+static void pool_class_put(sscma_client_pool_class_t *class, uint16_t index)
+{
+    __atomic_sub_fetch(&class->in_use, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_and(&class->used[index / 32], ~(1u << (index % 32)), __ATOMIC_RELEASE);
+}
+
+bool sscma_client_pool_init(sscma_client_pool_t *pool, const sscma_client_pool_config_t *config)
+{
+    memset(pool, 0, sizeof(*pool));
+    if (!pool_class_init(&pool->slabs, config->slab_size, config->slabs, false) || !pool_class_init(&pool->large, config->large_size, config->large_blocks, true))
+    {
+        sscma_client_pool_deinit(pool);
+        return false;
+    }
+    return true;
+}
+
+void sscma_client_pool_deinit(sscma_client_pool_t *pool)
+{
+    free(pool->slabs.storage);
+    free(pool->slabs.used);
+    free(pool->large.storage);
+    free(pool->large.used);
+    memset(pool, 0, sizeof(*pool));
+}
+
+char *sscma_client_pool_alloc(sscma_client_pool_t *pool, size_t len)
+{
+    pool_header_t *header = NULL;
+    uint8_t kind = POOL_HEAP;
+
+    // the smallest class that fits, a reply that finds it used up may still take a larger one
+    if (len <= pool->slabs.size && (header = pool_class_take(&pool->slabs)) != NULL)
+    {
+        kind = POOL_SLAB;
+    }
+    else if (len <= pool->large.size && (header = pool_class_take(&pool->large)) != NULL)
+    {
+        kind = POOL_LARGE;
+    }
+    else
+    {
+        header = (pool_header_t *)pool_heap_alloc(POOL_HEADER_SIZE + len, len > pool->slabs.size);
+        if (header == NULL)
+        {
+            return NULL;
+        }
+        header->index = 0;
+        __atomic_add_fetch(&pool->heap_fallbacks, 1, __ATOMIC_RELAXED);
+        pool_raise(&pool->heap_high, __atomic_add_fetch(&pool->heap_in_use, 1, __ATOMIC_RELAXED));
+    }
+    __atomic_add_fetch(&pool->allocs, 1, __ATOMIC_RELAXED);
+
+    header->pool = pool;
+    header->kind = kind;
+    __atomic_store_n(&header->refs, 1, __ATOMIC_RELAXED);
+
+    return (char *)header + POOL_HEADER_SIZE;
+}
+
+char *sscma_client_pool_retain(char *data)
+{
+    __atomic_add_fetch(&pool_header(data)->refs, 1, __ATOMIC_RELAXED);
+    return data;
+}
+
+bool sscma_client_pool_release(char *data)
+{
+    pool_header_t *header = pool_header(data);
+    sscma_client_pool_t *pool = header->pool;
+
+    if (__atomic_sub_fetch(&header->refs, 1, __ATOMIC_ACQ_REL) != 0)
+    {
+        return false;
+    }
+    switch (header->kind)
+    {
+        case POOL_SLAB:
+            pool_class_put(&pool->slabs, header->index);
+            break;
+        case POOL_LARGE:
+            pool_class_put(&pool->large, header->index);
+            break;
+        default:
+            __atomic_sub_fetch(&pool->heap_in_use, 1, __ATOMIC_RELAXED);
+            free(header);
+            break;
+    }
+    return true;
+}
+
+uint32_t sscma_client_pool_in_use(sscma_client_pool_t *pool)
+{
+    return __atomic_load_n(&pool->slabs.in_use, __ATOMIC_ACQUIRE) + __atomic_load_n(&pool->large.in_use, __ATOMIC_ACQUIRE) + __atomic_load_n(&pool->heap_in_use, __ATOMIC_ACQUIRE);
+}
+
+void sscma_client_pool_get_stats(sscma_client_pool_t *pool, sscma_client_pool_stats_t *stats)
+{
+    stats->allocs = __atomic_load_n(&pool->allocs, __ATOMIC_RELAXED);
+    stats->heap_fallbacks = __atomic_load_n(&pool->heap_fallbacks, __ATOMIC_RELAXED);
+    stats->slabs_in_use = __atomic_load_n(&pool->slabs.in_use, __ATOMIC_RELAXED);
+    stats->slabs_high_water = __atomic_load_n(&pool->slabs.high, __ATOMIC_RELAXED);
+    stats->large_in_use = __atomic_load_n(&pool->large.in_use, __ATOMIC_RELAXED);
+    stats->large_high_water = __atomic_load_n(&pool->large.high, __ATOMIC_RELAXED);
+    stats->heap_in_use = __atomic_load_n(&pool->heap_in_use, __ATOMIC_RELAXED);
+    stats->heap_high_water = __atomic_load_n(&pool->heap_high, __ATOMIC_RELAXED);
+}
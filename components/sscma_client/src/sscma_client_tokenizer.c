@@ -0,0 +1,539 @@
+#include <limits.h>
+#include <string.h>
+#include "sscma_client_tokenizer.h"
+
+// Nesting accepted in skipped values, the inference schema itself is four levels deep
+#define TOKENIZER_MAX_DEPTH 32
+
+typedef struct
+{
+    const char *p;
+    const char *end;
+} tokenizer_t;
+
+static inline bool peek(tokenizer_t *t, char *c)
+{
+    while (t->p < t->end && (*t->p == ' ' || *t->p == '\t' || *t->p == '\r' || *t->p == '\n'))
+    {
+        t->p++;
+    }
+    if (t->p >= t->end)
+    {
+        return false;
+    }
+    *c = *t->p;
+    return true;
+}
+
+static inline bool consume(tokenizer_t *t, char expected)
+{
+    char c;
+    if (!peek(t, &c) || c != expected)
+    {
+        return false;
+    }
+    t->p++;
+    return true;
+}
+
+static inline bool is_digit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+static bool scan_string(tokenizer_t *t, const char **str, size_t *len, bool *escaped)
+{
+    if (!consume(t, '"'))
+    {
+        return false;
+    }
+    const char *begin = t->p;
+    const char *quote = begin;
+    while ((quote = memchr(quote, '"', t->end - quote)) != NULL)
+    {
+        // a quote after an odd number of backslashes is escaped
+        const char *slash = quote;
+        while (slash > begin && slash[-1] == '\\')
+        {
+            slash--;
+        }
+        if (((quote - slash) & 1) == 0)
+        {
+            break;
+        }
+        quote++;
+    }
+    if (quote == NULL)
+    {
+        return false;
+    }
+    *str = begin;
+    *len = quote - begin;
+    *escaped = memchr(begin, '\\', *len) != NULL;
+    t->p = quote + 1;
+    return true;
+}
+
+// Integer part of a number, saturated like cJSON does for valueint
+static bool scan_number(tokenizer_t *t, int *value)
+{
+    char c;
+    if (!peek(t, &c))
+    {
+        return false;
+    }
+    bool negative = c == '-';
+    if (negative)
+    {
+        t->p++;
+    }
+    if (t->p >= t->end || !is_digit(*t->p))
+    {
+        return false;
+    }
+    long long v = 0;
+    while (t->p < t->end && is_digit(*t->p))
+    {
+        if (v <= INT_MAX)
+        {
+            v = v * 10 + (*t->p - '0');
+        }
+        t->p++;
+    }
+    if (t->p < t->end && *t->p == '.')
+    {
+        t->p++;
+        while (t->p < t->end && is_digit(*t->p))
+        {
+            t->p++;
+        }
+    }
+    if (t->p < t->end && (*t->p == 'e' || *t->p == 'E'))
+    {
+        return false; // rare enough to leave to cJSON
+    }
+    v = negative ? -v : v;
+    *value = v > INT_MAX ? INT_MAX : v < INT_MIN ? INT_MIN : (int)v;
+    return true;
+}
+
+static bool skip_value(tokenizer_t *t, int depth);
+
+// Step to the next element of an array or object whose opening bracket is consumed: 1 when there is
+// one, 0 after the closing bracket, -1 on a syntax error
+static int next_element(tokenizer_t *t, int index, char close)
+{
+    if (index == 0)
+    {
+        return consume(t, close) ? 0 : 1;
+    }
+    if (consume(t, ','))
+    {
+        return 1;
+    }
+    return consume(t, close) ? 0 : -1;
+}
+
+static bool skip_value(tokenizer_t *t, int depth)
+{
+    char c;
+    const char *str;
+    size_t len;
+    bool escaped;
+    int value;
+
+    if (depth > TOKENIZER_MAX_DEPTH || !peek(t, &c))
+    {
+        return false;
+    }
+    switch (c)
+    {
+    case '"':
+        return scan_string(t, &str, &len, &escaped);
+    case '[':
+    case '{':
+        t->p++;
+        for (int i = 0;; i++)
+        {
+            int next = next_element(t, i, c == '[' ? ']' : '}');
+            if (next <= 0)
+            {
+                return next == 0;
+            }
+            if (c == '{' && (!scan_string(t, &str, &len, &escaped) || !consume(t, ':')))
+            {
+                return false;
+            }
+            if (!skip_value(t, depth + 1))
+            {
+                return false;
+            }
+        }
+    case 't':
+        len = 4;
+        str = "true";
+        break;
+    case 'f':
+        len = 5;
+        str = "false";
+        break;
+    case 'n':
+        len = 4;
+        str = "null";
+        break;
+    default:
+        return scan_number(t, &value);
+    }
+    if ((size_t)(t->end - t->p) < len || memcmp(t->p, str, len) != 0)
+    {
+        return false;
+    }
+    t->p += len;
+    return true;
+}
+
+// Read an array of numbers, entries that are missing or not numbers read as INT_MIN
+static bool scan_numbers(tokenizer_t *t, int *values, int max, int *num, int depth)
+{
+    char c;
+
+    for (int i = 0; i < max; i++)
+    {
+        values[i] = INT_MIN;
+    }
+    *num = 0;
+    if (!peek(t, &c))
+    {
+        return false;
+    }
+    if (c != '[')
+    {
+        return skip_value(t, depth);
+    }
+    t->p++;
+    for (int i = 0;; i++)
+    {
+        int next = next_element(t, i, ']');
+        if (next <= 0)
+        {
+            *num = i;
+            return next == 0;
+        }
+        if (!peek(t, &c))
+        {
+            return false;
+        }
+        if (c == '-' || is_digit(c))
+        {
+            int value;
+            if (!scan_number(t, &value))
+            {
+                return false;
+            }
+            if (i < max)
+            {
+                values[i] = value;
+            }
+        }
+        else if (!skip_value(t, depth + 1))
+        {
+            return false;
+        }
+    }
+}
+
+typedef void (*store_record_t)(void *items, int index, const int *values);
+
+static void store_box(void *items, int index, const int *values)
+{
+    sscma_client_box_t *box = (sscma_client_box_t *)items + index;
+    box->x = values[0];
+    box->y = values[1];
+    box->w = values[2];
+    box->h = values[3];
+    box->score = values[4];
+    box->target = values[5];
+}
+
+static void store_class(void *items, int index, const int *values)
+{
+    sscma_client_class_t *item = (sscma_client_class_t *)items + index;
+    item->score = values[0];
+    item->target = values[1];
+}
+
+static void store_point(void *items, int index, const int *values)
+{
+    sscma_client_point_t *point = (sscma_client_point_t *)items + index;
+    point->x = values[0];
+    point->y = values[1];
+    point->z = 0;
+    point->score = values[2];
+    point->target = values[3];
+}
+
+// Read an array of fixed size records, such as boxes
+static bool scan_records(tokenizer_t *t, int fields, store_record_t store, void *items, int max, int *num, int depth)
+{
+    int values[6];
+    int count;
+    char c;
+
+    *num = 0;
+    if (!peek(t, &c))
+    {
+        return false;
+    }
+    if (c != '[')
+    {
+        return skip_value(t, depth);
+    }
+    t->p++;
+    for (int i = 0;; i++)
+    {
+        int next = next_element(t, i, ']');
+        if (next <= 0)
+        {
+            *num = i;
+            return next == 0;
+        }
+        if (!scan_numbers(t, values, fields, &count, depth + 1))
+        {
+            return false;
+        }
+        if (items != NULL && i < max)
+        {
+            store(items, i, values);
+        }
+    }
+}
+
+// Keypoints are [[x, y, w, h, score, target], [[x, y, score, target], ...]]
+static bool scan_keypoints(tokenizer_t *t, sscma_client_keypoint_t *keypoints, int max, int *num, int depth)
+{
+    sscma_client_keypoint_t dummy;
+    int values[6];
+    int count;
+    char c;
+
+    *num = 0;
+    if (!peek(t, &c))
+    {
+        return false;
+    }
+    if (c != '[')
+    {
+        return skip_value(t, depth);
+    }
+    t->p++;
+    for (int i = 0;; i++)
+    {
+        int next = next_element(t, i, ']');
+        if (next <= 0)
+        {
+            *num = i;
+            return next == 0;
+        }
+        sscma_client_keypoint_t *keypoint = keypoints != NULL && i < max ? &keypoints[i] : &dummy;
+        keypoint->points_num = 0;
+        if (!peek(t, &c))
+        {
+            return false;
+        }
+        if (c != '[')
+        {
+            if (!skip_value(t, depth + 1))
+            {
+                return false;
+            }
+            continue;
+        }
+        t->p++;
+        for (int j = 0;; j++)
+        {
+            next = next_element(t, j, ']');
+            if (next < 0)
+            {
+                return false;
+            }
+            if (next == 0)
+            {
+                break;
+            }
+            if (j == 0)
+            {
+                if (!scan_numbers(t, values, 6, &count, depth + 2))
+                {
+                    return false;
+                }
+                store_box(&keypoint->box, 0, values);
+            }
+            else if (j == 1)
+            {
+                if (!scan_records(t, 4, store_point, keypoint->points, SSCMA_CLIENT_MODEL_KEYPOINTS_MAX, &count, depth + 2))
+                {
+                    return false;
+                }
+                keypoint->points_num = count > SSCMA_CLIENT_MODEL_KEYPOINTS_MAX ? SSCMA_CLIENT_MODEL_KEYPOINTS_MAX : count;
+            }
+            else if (!skip_value(t, depth + 2))
+            {
+                return false;
+            }
+        }
+    }
+}
+
+static inline bool key_is(const char *key, size_t len, const char *name)
+{
+    return strlen(name) == len && memcmp(key, name, len) == 0;
+}
+
+static bool scan_data(tokenizer_t *t, sscma_client_inference_t *inference)
+{
+    const char *key;
+    size_t key_len;
+    bool escaped;
+    char c;
+
+    if (!peek(t, &c))
+    {
+        return false;
+    }
+    if (c != '{')
+    {
+        return skip_value(t, 1);
+    }
+    t->p++;
+    for (int i = 0;; i++)
+    {
+        int next = next_element(t, i, '}');
+        if (next <= 0)
+        {
+            return next == 0;
+        }
+        if (!scan_string(t, &key, &key_len, &escaped) || !consume(t, ':'))
+        {
+            return false;
+        }
+
+        bool ok;
+        if (key_is(key, key_len, "count"))
+        {
+            ok = peek(t, &c) && (c == '-' || is_digit(c)) ? scan_number(t, &inference->count) : skip_value(t, 2);
+        }
+        else if (key_is(key, key_len, "resolution"))
+        {
+            int resolution[2];
+            int count;
+            ok = scan_numbers(t, resolution, 2, &count, 2);
+            if (count >= 2)
+            {
+                inference->width = resolution[0];
+                inference->height = resolution[1];
+            }
+        }
+        else if (key_is(key, key_len, "boxes"))
+        {
+            ok = scan_records(t, 6, store_box, inference->boxes, inference->max_boxes, &inference->num_boxes, 2);
+        }
+        else if (key_is(key, key_len, "classes"))
+        {
+            ok = scan_records(t, 2, store_class, inference->classes, inference->max_classes, &inference->num_classes, 2);
+        }
+        else if (key_is(key, key_len, "points"))
+        {
+            ok = scan_records(t, 4, store_point, inference->points, inference->max_points, &inference->num_points, 2);
+        }
+        else if (key_is(key, key_len, "keypoints"))
+        {
+            ok = scan_keypoints(t, inference->keypoints, inference->max_keypoints, &inference->num_keypoints, 2);
+        }
+        else if (key_is(key, key_len, "image") && peek(t, &c) && c == '"')
+        {
+            ok = scan_string(t, &inference->image, &inference->image_len, &escaped) && !escaped;
+        }
+        else
+        {
+            ok = skip_value(t, 2);
+        }
+        if (!ok)
+        {
+            return false;
+        }
+    }
+}
+
+bool sscma_client_tokenize_inference(const char *json, size_t len, sscma_client_inference_t *inference)
+{
+    tokenizer_t t = { .p = json, .end = json + len };
+    const char *key;
+    size_t key_len;
+    bool escaped;
+    char c;
+
+    inference->type = INT_MIN;
+    inference->code = INT_MIN;
+    inference->name = NULL;
+    inference->name_len = 0;
+    inference->count = INT_MIN;
+    inference->width = 0;
+    inference->height = 0;
+    inference->image = NULL;
+    inference->image_len = 0;
+    inference->image_raw = false;
+    inference->num_boxes = 0;
+    inference->num_classes = 0;
+    inference->num_points = 0;
+    inference->num_keypoints = 0;
+
+    if (json == NULL || !consume(&t, '{'))
+    {
+        return false;
+    }
+    for (int i = 0;; i++)
+    {
+        int next = next_element(&t, i, '}');
+        if (next < 0)
+        {
+            return false;
+        }
+        if (next == 0)
+        {
+            break;
+        }
+        if (!scan_string(&t, &key, &key_len, &escaped) || !consume(&t, ':'))
+        {
+            return false;
+        }
+
+        bool ok;
+        if (key_is(key, key_len, "type") && peek(&t, &c) && (c == '-' || is_digit(c)))
+        {
+            ok = scan_number(&t, &inference->type);
+        }
+        else if (key_is(key, key_len, "code") && peek(&t, &c) && (c == '-' || is_digit(c)))
+        {
+            ok = scan_number(&t, &inference->code);
+        }
+        else if (key_is(key, key_len, "name") && peek(&t, &c) && c == '"')
+        {
+            ok = scan_string(&t, &inference->name, &inference->name_len, &escaped);
+        }
+        else if (key_is(key, key_len, "data"))
+        {
+            ok = scan_data(&t, inference);
+        }
+        else
+        {
+            ok = skip_value(&t, 1);
+        }
+        if (!ok)
+        {
+            return false;
+        }
+    }
+
+    // nothing but whitespace may follow
+    return !peek(&t, &c);
+}
@@ -23,6 +23,8 @@ void app_main(void) {
       {{90., 100., 110., 120.}, 0.7, 2, 0},
     };
 
+    bt_bbox_t tracks[8];
+
     int try = 3;
     do {
         for (size_t i = 0; i < sizeof(bboxes) / sizeof(bboxes[0]); ++i) {
@@ -30,9 +32,9 @@ void app_main(void) {
             bboxes[i].tlwh[1] += 5.0;
         }
 
-        bt_bbox_t* tracks     = NULL;
         size_t     num_tracks = 0;
-        bt_error_t err = bt_tracker_update(tracker, bboxes, sizeof(bboxes) / sizeof(bboxes[0]), &tracks, &num_tracks);
+        bt_error_t err        = bt_tracker_update_into(
+          tracker, bboxes, sizeof(bboxes) / sizeof(bboxes[0]), tracks, sizeof(tracks) / sizeof(tracks[0]), &num_tracks);
         if (err != BT_ERR_OK) {
             ESP_LOGE(TAG, "Failed to update tracker");
             assert(0);
@@ -50,8 +52,6 @@ void app_main(void) {
                     tracks[i].label,
                     tracks[i].track_id);
         }
-
-        free(tracks);
     } while (--try);
 
     bt_tracker_destroy(tracker);
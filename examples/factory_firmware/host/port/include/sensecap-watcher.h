@@ -0,0 +1,7 @@
+#pragma once
+
+/* The board support package, of which the module headers only need what it includes */
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/event_groups.h"
+#include "esp_timer.h"
@@ -0,0 +1,7 @@
+#pragma once
+
+#include <stddef.h>
+
+/* strlcpy() of newlib, for C libraries without it */
+
+size_t strlcpy(char *dst, const char *src, size_t size);
@@ -0,0 +1,412 @@
+// Tests of the tf_data helpers of the task flow modules.
+//
+//   alloc      a buffer is freed with its last release only, retain and release of NULL do nothing
+//   buf        a shared buffer is the same memory, a copy is new memory with the same bytes
+//   share      an event shared to several outputs costs no block, every output frees its own
+//              reference and the blocks go with the last, in any order
+//   copy       a copied event owns new blocks, freeing it leaves the original alone
+//   threads    threads share and free the same event at once, every block goes exactly once
+//   base64     an image encodes to what mbedtls gives for it, into a buffer or in chunks, around
+//              the chunk size too, and a failing write stops it
+//   json       image marks of a JSON document are replaced by the base64 of their image, the
+//              length is known beforehand and other strings are left alone
+//
+// tf_malloc() and tf_free() are the ones below, they count the blocks in use.
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mbedtls/base64.h"
+#include "tf_module_util.h"
+#include "tf_util.h"
+#include "tf_wire.h"
+
+#define THREADS     8
+#define ITERATIONS  100000
+
+ESP_EVENT_DEFINE_BASE(TF_EVENT_BASE);
+
+static int failures = 0;
+static int g_blocks = 0;
+
+#define CHECK(cond, ...)                    \
+    do {                                    \
+        if( !(cond) ) {                     \
+            printf("%s:%d: ", __func__, __LINE__); \
+            printf(__VA_ARGS__);            \
+            printf("\n");                   \
+            failures++;                     \
+            return;                         \
+        }                                   \
+    } while (0)
+
+void *tf_malloc(size_t sz)
+{
+    void *p = malloc(sz);
+    if( p != NULL ) {
+        __atomic_add_fetch(&g_blocks, 1, __ATOMIC_RELAXED);
+    }
+    return p;
+}
+
+void tf_free(void *ptr)
+{
+    if( ptr != NULL ) {
+        __atomic_sub_fetch(&g_blocks, 1, __ATOMIC_RELAXED);
+    }
+    free(ptr);
+}
+
+static int blocks(void)
+{
+    return __atomic_load_n(&g_blocks, __ATOMIC_RELAXED);
+}
+
+static uint8_t *bytes_alloc(size_t len, uint8_t seed)
+{
+    uint8_t *p = tf_data_alloc(len);
+    for (size_t i = 0; p != NULL && i < len; i++) {
+        p[i] = (uint8_t)(seed + i);
+    }
+    return p;
+}
+
+static char *name_alloc(const char *p_name)
+{
+    char *p = tf_data_alloc(strlen(p_name) + 1);
+    if( p != NULL ) {
+        strcpy(p, p_name);
+    }
+    return p;
+}
+
+// An event as the AI camera posts it: two images, three boxes and two class names
+static void event_make(tf_data_dualimage_with_inference_t *p_event)
+{
+    memset(p_event, 0, sizeof(*p_event));
+    p_event->type = TF_DATA_TYPE_DUALIMAGE_WITH_INFERENCE;
+    p_event->img_small.p_buf = bytes_alloc(1000, 1);
+    p_event->img_small.len = 1000;
+    p_event->img_small.time = 1234;
+    p_event->img_large.p_buf = bytes_alloc(5000, 2);
+    p_event->img_large.len = 5000;
+    p_event->img_large.time = 1234;
+    p_event->inference.is_valid = true;
+    p_event->inference.type = INFERENCE_TYPE_BOX;
+    p_event->inference.p_data = bytes_alloc(3 * sizeof(sscma_client_box_t), 3);
+    p_event->inference.cnt = 3;
+    p_event->inference.classes[0] = name_alloc("person");
+    p_event->inference.classes[1] = name_alloc("cat");
+}
+
+static bool event_same(const tf_data_dualimage_with_inference_t *p_a, const tf_data_dualimage_with_inference_t *p_b)
+{
+    return p_a->type == p_b->type &&
+           p_a->img_small.len == p_b->img_small.len && p_a->img_small.time == p_b->img_small.time &&
+           memcmp(p_a->img_small.p_buf, p_b->img_small.p_buf, p_a->img_small.len) == 0 &&
+           p_a->img_large.len == p_b->img_large.len &&
+           memcmp(p_a->img_large.p_buf, p_b->img_large.p_buf, p_a->img_large.len) == 0 &&
+           p_a->inference.is_valid == p_b->inference.is_valid && p_a->inference.type == p_b->inference.type &&
+           p_a->inference.cnt == p_b->inference.cnt &&
+           memcmp(p_a->inference.p_data, p_b->inference.p_data, p_a->inference.cnt * sizeof(sscma_client_box_t)) == 0 &&
+           strcmp(p_a->inference.classes[0], p_b->inference.classes[0]) == 0 &&
+           strcmp(p_a->inference.classes[1], p_b->inference.classes[1]) == 0 &&
+           p_a->inference.classes[2] == NULL && p_b->inference.classes[2] == NULL;
+}
+
+static void test_alloc(void)
+{
+    uint8_t *p = tf_data_alloc(100);
+
+    CHECK(p != NULL && blocks() == 1, "alloc: %p, %d blocks", p, blocks());
+    CHECK(((uintptr_t)p & 7) == 0, "data not 8 byte aligned: %p", p);
+    CHECK(tf_data_retain(p) == p && tf_data_retain(p) == p, "retain does not give back the buffer");
+    tf_data_release(p);
+    tf_data_release(p);
+    CHECK(blocks() == 1, "freed with a reference left");
+    tf_data_release(p);
+    CHECK(blocks() == 0, "not freed with the last release");
+
+    CHECK(tf_data_retain(NULL) == NULL, "retain of NULL");
+    tf_data_release(NULL);
+    CHECK(blocks() == 0, "release of NULL");
+}
+
+static void test_buf(void)
+{
+    struct tf_data_buf src = { .p_buf = bytes_alloc(64, 7), .len = 64 };
+    struct tf_data_buf shared, copied, empty = { 0 }, empty_out;
+
+    tf_data_buf_share(&shared, &src);
+    CHECK(shared.p_buf == src.p_buf && shared.len == 64 && blocks() == 1, "share: %p, %u bytes, %d blocks", shared.p_buf, shared.len, blocks());
+    tf_data_buf_copy(&copied, &src);
+    CHECK(copied.p_buf != src.p_buf && copied.len == 64 && memcmp(copied.p_buf, src.p_buf, 64) == 0 && blocks() == 2, "copy: %d blocks", blocks());
+
+    tf_data_buf_free(&src);
+    CHECK(src.p_buf == NULL && src.len == 0, "free leaves the buffer set");
+    CHECK(blocks() == 2 && shared.p_buf[63] == (uint8_t)(7 + 63), "shared buffer gone with the first free");
+    tf_data_buf_free(&shared);
+    tf_data_buf_free(&copied);
+    CHECK(blocks() == 0, "%d blocks left", blocks());
+
+    // nothing to share or copy
+    tf_data_buf_share(&empty_out, &empty);
+    CHECK(empty_out.p_buf == NULL && empty_out.len == 0, "share of an empty buffer");
+    tf_data_buf_copy(&empty_out, &empty);
+    CHECK(empty_out.p_buf == NULL && empty_out.len == 0 && blocks() == 0, "copy of an empty buffer");
+    tf_data_buf_free(&empty_out);
+}
+
+static void test_share(void)
+{
+    enum { OUTPUTS = 3 };
+    tf_data_dualimage_with_inference_t src;
+    tf_data_dualimage_with_inference_t outputs[OUTPUTS];
+
+    event_make(&src);
+    CHECK(blocks() == 5, "event of %d blocks", blocks());
+
+    // as a module with three outputs posts one frame
+    for (int i = 0; i < OUTPUTS; i++) {
+        memset(&outputs[i], 0xa5, sizeof(outputs[i]));
+        tf_data_share(&outputs[i], &src);
+        CHECK(event_same(&outputs[i], &src), "output %d differs", i);
+        CHECK(outputs[i].img_large.p_buf == src.img_large.p_buf && outputs[i].inference.classes[1] == src.inference.classes[1],
+              "output %d does not share the buffers", i);
+    }
+    CHECK(blocks() == 5, "sharing allocated: %d blocks", blocks());
+
+    // the producer lets go first, the outputs in any order
+    tf_data_free(&src);
+    CHECK(src.img_small.p_buf == NULL && src.inference.p_data == NULL && src.inference.classes[0] == NULL && src.inference.cnt == 0,
+          "free leaves the event set");
+    tf_data_free(&outputs[1]);
+    CHECK(blocks() == 5 && event_same(&outputs[0], &outputs[2]), "blocks gone before the last output");
+    tf_data_free(&outputs[2]);
+    CHECK(blocks() == 5 && outputs[0].img_large.p_buf[4999] == (uint8_t)(2 + 4999), "blocks gone before the last output");
+    tf_data_free(&outputs[0]);
+    CHECK(blocks() == 0, "%d blocks left after the last output", blocks());
+}
+
+static void test_copy(void)
+{
+    tf_data_dualimage_with_inference_t src, copy;
+
+    event_make(&src);
+    copy.type = src.type;
+    tf_data_image_copy(&copy.img_small, &src.img_small);
+    tf_data_image_copy(&copy.img_large, &src.img_large);
+    tf_data_inference_copy(&copy.inference, &src.inference);
+    CHECK(blocks() == 10, "copy of %d blocks, expected 5 more", blocks() - 5);
+    CHECK(event_same(&copy, &src), "copy differs");
+    CHECK(copy.img_large.p_buf != src.img_large.p_buf && copy.inference.classes[0] != src.inference.classes[0], "copy shares the buffers");
+
+    tf_data_free(&src);
+    CHECK(blocks() == 5 && copy.inference.classes[0][0] == 'p', "copy freed with the original");
+    tf_data_free(&copy);
+    CHECK(blocks() == 0, "%d blocks left", blocks());
+}
+
+typedef struct
+{
+    tf_data_dualimage_with_inference_t **pp_mailbox;  // shared by the workers
+    tf_data_dualimage_with_inference_t *p_src;
+    unsigned seed;
+    int mismatches;
+} worker_t;
+
+// Each worker shares the source event into events of its own and hands half of them to the
+// others through a mailbox, so references are dropped by threads that did not take them while
+// others take new ones, as with a frame fanned out to wires run by several workers
+static void *worker(void *arg)
+{
+    worker_t *w = (worker_t *)arg;
+
+    for (int it = 0; it < ITERATIONS; it++) {
+        tf_data_dualimage_with_inference_t *p_event = malloc(sizeof(*p_event));
+        tf_data_share(p_event, w->p_src);
+        if( p_event->img_small.p_buf[999] != (uint8_t)(1 + 999) || p_event->inference.classes[0][0] != 'p' ) {
+            w->mismatches++;
+        }
+        if( rand_r(&w->seed) % 2 ) {
+            p_event = __atomic_exchange_n(w->pp_mailbox, p_event, __ATOMIC_ACQ_REL);
+        }
+        if( p_event != NULL ) {
+            tf_data_free(p_event);
+            free(p_event);
+        }
+    }
+    return NULL;
+}
+
+static void test_threads(void)
+{
+    tf_data_dualimage_with_inference_t src;
+    tf_data_dualimage_with_inference_t *p_mailbox = NULL;
+    pthread_t threads[THREADS];
+    worker_t workers[THREADS];
+    int mismatches = 0;
+
+    event_make(&src);
+    for (int t = 0; t < THREADS; t++) {
+        workers[t] = (worker_t) { .pp_mailbox = &p_mailbox, .p_src = &src, .seed = 1 + t };
+        pthread_create(&threads[t], NULL, worker, &workers[t]);
+    }
+    for (int t = 0; t < THREADS; t++) {
+        pthread_join(threads[t], NULL);
+        mismatches += workers[t].mismatches;
+    }
+    CHECK(mismatches == 0, "%d events saw other bytes", mismatches);
+    CHECK(blocks() == 5, "%d blocks while the source holds 5", blocks());
+    if( p_mailbox != NULL ) {
+        tf_data_free(p_mailbox);
+        free(p_mailbox);
+    }
+    CHECK(blocks() == 5, "%d blocks while the source holds 5", blocks());
+    tf_data_free(&src);
+    CHECK(blocks() == 0, "%d blocks left", blocks());
+}
+
+// Collects what a write callback gets, fails after fail_after calls if set
+typedef struct
+{
+    uint8_t *p_buf;
+    size_t len;
+    size_t cap;
+    int calls;
+    int fail_after;
+} sink_t;
+
+static int sink_write(void *p_ctx, const void *p_buf, size_t len)
+{
+    sink_t *p_sink = (sink_t *)p_ctx;
+
+    if( p_sink->fail_after && p_sink->calls == p_sink->fail_after ) {
+        return -2;
+    }
+    p_sink->calls++;
+    if( p_sink->len + len > p_sink->cap ) {
+        p_sink->cap = (p_sink->len + len) * 2;
+        p_sink->p_buf = realloc(p_sink->p_buf, p_sink->cap);
+    }
+    memcpy(p_sink->p_buf + p_sink->len, p_buf, len);
+    p_sink->len += len;
+    return 0;
+}
+
+static void image_make(struct tf_data_image *p_img, size_t len, uint8_t seed)
+{
+    p_img->p_buf = len ? bytes_alloc(len, seed) : NULL;
+    p_img->len = len;
+    p_img->time = 0;
+}
+
+static void test_base64(void)
+{
+    // around the 3072 byte chunks, lengths of each remainder mod 3
+    static const size_t lens[] = { 0, 1, 2, 3, 4, 100, 3071, 3072, 3073, 6143, 6144, 6145, 20000, 20001 };
+
+    for (size_t n = 0; n < sizeof(lens) / sizeof(lens[0]); n++) {
+        struct tf_data_image img;
+        size_t len = lens[n];
+        size_t b64_len = (len + 2) / 3 * 4;
+        uint8_t *p_expect = malloc(b64_len + 1);
+        uint8_t *p_out = malloc(b64_len + 1);
+        sink_t sink = { 0 };
+        size_t olen = 0;
+
+        image_make(&img, len, (uint8_t)n);
+        CHECK(mbedtls_base64_encode(p_expect, b64_len + 1, &olen, img.p_buf, len) == 0 && olen == b64_len, "mbedtls encode of %zu bytes", len);
+        CHECK(tf_data_image_base64_len(&img) == (len ? b64_len : 0), "%zu bytes: length %zu, expected %zu", len, tf_data_image_base64_len(&img), b64_len);
+
+        CHECK(tf_data_image_base64_encode(&img, p_out, b64_len + 1, &olen) == 0 && olen == b64_len, "%zu bytes: encode gave %zu", len, olen);
+        CHECK(memcmp(p_out, p_expect, b64_len) == 0 && p_out[b64_len] == '\0', "%zu bytes: encode differs", len);
+        if( len ) {
+            // no room for the '\0'
+            CHECK(tf_data_image_base64_encode(&img, p_out, b64_len, &olen) != 0, "%zu bytes: encode into a short buffer", len);
+        }
+
+        CHECK(tf_data_image_base64_write(&img, sink_write, &sink) == 0, "%zu bytes: write failed", len);
+        CHECK(sink.len == b64_len && (len == 0 || memcmp(sink.p_buf, p_expect, b64_len) == 0), "%zu bytes: written %zu differs", len, sink.len);
+        CHECK(sink.calls == (int)((len + 3071) / 3072), "%zu bytes in %d chunks", len, sink.calls);
+        CHECK(tf_data_image_base64_write(&img, sink_write, &(sink_t) { .fail_after = 1 }) == (len > 3072 ? -2 : 0), "%zu bytes: write error not returned", len);
+
+        free(sink.p_buf);
+        free(p_expect);
+        free(p_out);
+        tf_data_image_free(&img);
+    }
+    CHECK(blocks() == 0, "%d blocks left", blocks());
+}
+
+// Decoded bytes of the string value of key in p_json
+static bool json_image_same(const uint8_t *p_json, size_t len, const char *key, const struct tf_data_image *p_img)
+{
+    char pattern[32];
+    uint8_t decoded[8192];
+    size_t olen = 0;
+
+    snprintf(pattern, sizeof(pattern), "\"%s\":\"", key);
+    const uint8_t *p = memmem(p_json, len, pattern, strlen(pattern));
+    if( p == NULL ) {
+        return false;
+    }
+    p += strlen(pattern);
+    const uint8_t *p_end = memchr(p, '"', p_json + len - p);
+    return p_end != NULL && mbedtls_base64_decode(decoded, sizeof(decoded), &olen, p, p_end - p) == 0 &&
+           olen == p_img->len && (olen == 0 || memcmp(decoded, p_img->p_buf, olen) == 0);
+}
+
+static void test_json(void)
+{
+    // as the SenseCraft and HTTP alarms build their bodies, with strings that only look like marks
+    static const char json[] = "{\"small\":\"" TF_DATA_IMAGE_JSON_MARK(0) "\",\"text\":\"$tf_image_1\",\"note\":\"$tf_image_0$ and more\","
+                               "\"large\":\"" TF_DATA_IMAGE_JSON_MARK(1) "\",\"again\":\"" TF_DATA_IMAGE_JSON_MARK(0) "\","
+                               "\"none\":\"" TF_DATA_IMAGE_JSON_MARK(2) "\",\"other\":\"" TF_DATA_IMAGE_JSON_MARK(5) "\","
+                               "\"nan\":\"$tf_image_x$\"}";
+    static const char rest[] = "\"none\":\"\",\"other\":\"$tf_image_5$\",\"nan\":\"$tf_image_x$\"}";
+    struct tf_data_image small, large, empty = { 0 };
+    const struct tf_data_image *imgs[] = { &small, &large, &empty };
+    sink_t sink = { 0 };
+
+    image_make(&small, 1000, 1);
+    image_make(&large, 5000, 2);
+
+    CHECK(tf_data_image_json_write(json, imgs, 3, sink_write, &sink) == 0, "write failed");
+    CHECK(sink.len == tf_data_image_json_len(json, imgs, 3), "wrote %zu, length said %zu", sink.len, tf_data_image_json_len(json, imgs, 3));
+    CHECK(json_image_same(sink.p_buf, sink.len, "small", &small) && json_image_same(sink.p_buf, sink.len, "again", &small), "small image not spliced");
+    CHECK(json_image_same(sink.p_buf, sink.len, "large", &large), "large image not spliced");
+    CHECK(memcmp(sink.p_buf, "{\"small\":\"", 10) == 0 && sink.len > strlen(rest) &&
+          memcmp(sink.p_buf + sink.len - strlen(rest), rest, strlen(rest)) == 0, "text around the marks changed: %.*s", (int)sink.len, sink.p_buf);
+    CHECK(memmem(sink.p_buf, sink.len, "\"text\":\"$tf_image_1\",\"note\":\"$tf_image_0$ and more\",", 52) != NULL,
+          "a string that is not a mark was replaced");
+
+    // no marks, and a write error in the middle
+    sink.len = 0;
+    CHECK(tf_data_image_json_write("{\"a\":1}", imgs, 3, sink_write, &sink) == 0 && sink.len == 7 && memcmp(sink.p_buf, "{\"a\":1}", 7) == 0,
+          "document without marks changed");
+    CHECK(tf_data_image_json_len("{\"a\":1}", imgs, 3) == 7, "length of a document without marks");
+    CHECK(tf_data_image_json_write(json, imgs, 3, sink_write, &(sink_t) { .fail_after = 2 }) == -2, "write error not returned");
+
+    free(sink.p_buf);
+    tf_data_image_free(&small);
+    tf_data_image_free(&large);
+    CHECK(blocks() == 0, "%d blocks left", blocks());
+}
+
+int main(void)
+{
+    test_alloc();
+    test_buf();
+    test_share();
+    test_copy();
+    test_threads();
+    test_base64();
+    test_json();
+
+    printf("%s\n", failures ? "FAILED" : "OK");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,478 @@
+// Tests of how the task flow engine moves from one flow to the next, with modules that only count
+// the calls the engine makes on them.
+//
+//   start      a flow set on an idle engine sets up every module
+//   reload     a flow set while another runs keeps the modules it leaves alone, updates the ones
+//              with new params or outputs that can take them while running, restarts on the same
+//              instance the ones that cannot, stops the removed ones and sets up the new ones
+//   rename     a module whose id stays but whose type changes is a new module
+//   failure    a flow naming an unknown module stops everything, old and kept modules included,
+//              and the next flow starts from scratch
+//   stats      the counters of tf_engine_stats_get() and its JSON are those of each module's wire
+//
+// The modules are "probe", with cfg_update and msgs_pub_update, and "plain", without. A probe
+// takes its input on a wire and passes each event on to its first output, allocating a tf_data
+// buffer on the way, a plain module has no input.
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "tf.h"
+#include "tf_module_util.h"
+
+#define INSTANCE_MAX 32
+#define OUTPUT_MAX   4
+#define EVENTS       10
+#define EVENT_BYTES  100
+
+static int failures = 0;
+
+#define CHECK(cond, ...)                    \
+    do {                                    \
+        if( !(cond) ) {                     \
+            printf("%s:%d: ", __func__, __LINE__); \
+            printf(__VA_ARGS__);            \
+            printf("\n");                   \
+            failures++;                     \
+            return;                         \
+        }                                   \
+    } while (0)
+
+// What the engine did to one instance
+typedef struct
+{
+    tf_module_t handle;
+    const char *p_type;
+    int id;
+    bool destroyed;
+    bool running;
+    int cfg;
+    int cfg_update;
+    int sub_set;
+    int pub_set;
+    int pub_update;
+    int start;
+    int stop;
+    int outputs;            // event ids of the first output, as last set
+    int output_ids[OUTPUT_MAX];
+    bool registered;
+} probe_t;
+
+static probe_t g_instances[INSTANCE_MAX];
+static int g_instance_num = 0;
+static int g_status = -1;
+
+static int probe_start(void *p_module)
+{
+    probe_t *p_probe = (probe_t *)p_module;
+    p_probe->start++;
+    p_probe->running = true;
+    return ESP_OK;
+}
+
+static void probe_event_handler(void *p_arg, esp_event_base_t base, int32_t id, void *p_data);
+
+static int probe_stop(void *p_module)
+{
+    probe_t *p_probe = (probe_t *)p_module;
+    p_probe->stop++;
+    p_probe->running = false;
+    if( p_probe->registered ) {
+        tf_event_handler_unregister(p_probe->id, probe_event_handler);
+        p_probe->registered = false;
+    }
+    return ESP_OK;
+}
+
+static void probe_event_handler(void *p_arg, esp_event_base_t base, int32_t id, void *p_data)
+{
+    probe_t *p_probe = (probe_t *)p_arg;
+    int value = *(int *)p_data;
+
+    tf_data_free(tf_data_alloc(EVENT_BYTES));
+    for (int i = 0; i < p_probe->outputs && i < OUTPUT_MAX; i++) {
+        tf_event_post(p_probe->output_ids[i], &value, sizeof(value), 0);
+    }
+}
+
+static int probe_cfg(void *p_module, cJSON *p_json)
+{
+    ((probe_t *)p_module)->cfg++;
+    return ESP_OK;
+}
+
+static int probe_cfg_update(void *p_module, cJSON *p_json)
+{
+    ((probe_t *)p_module)->cfg_update++;
+    return ESP_OK;
+}
+
+static int probe_msgs_sub_set(void *p_module, int evt_id)
+{
+    probe_t *p_probe = (probe_t *)p_module;
+    p_probe->sub_set++;
+    p_probe->id = evt_id;
+    if( strcmp(p_probe->p_type, "plain") == 0 ) {
+        return ESP_OK;
+    }
+    int ret = tf_event_handler_register(evt_id, probe_event_handler, p_probe);
+    p_probe->registered = ret == ESP_OK;
+    return ret;
+}
+
+static void probe_outputs_set(probe_t *p_probe, int *p_evt_id, int num)
+{
+    p_probe->outputs = num;
+    for (int i = 0; i < num && i < OUTPUT_MAX; i++) {
+        p_probe->output_ids[i] = p_evt_id[i];
+    }
+}
+
+static int probe_msgs_pub_set(void *p_module, int output_index, int *p_evt_id, int num)
+{
+    probe_t *p_probe = (probe_t *)p_module;
+    p_probe->pub_set++;
+    probe_outputs_set(p_probe, p_evt_id, num);
+    return ESP_OK;
+}
+
+static int probe_msgs_pub_update(void *p_module, int output_index, int *p_evt_id, int num)
+{
+    probe_t *p_probe = (probe_t *)p_module;
+    p_probe->pub_update++;
+    probe_outputs_set(p_probe, p_evt_id, num);
+    return ESP_OK;
+}
+
+static const struct tf_module_ops probe_ops = {
+    .start = probe_start,
+    .stop = probe_stop,
+    .cfg = probe_cfg,
+    .msgs_sub_set = probe_msgs_sub_set,
+    .msgs_pub_set = probe_msgs_pub_set,
+    .cfg_update = probe_cfg_update,
+    .msgs_pub_update = probe_msgs_pub_update,
+};
+
+static const struct tf_module_ops plain_ops = {
+    .start = probe_start,
+    .stop = probe_stop,
+    .cfg = probe_cfg,
+    .msgs_sub_set = probe_msgs_sub_set,
+    .msgs_pub_set = probe_msgs_pub_set,
+};
+
+static tf_module_t *instance(const char *p_type, const struct tf_module_ops *p_ops)
+{
+    if( g_instance_num >= INSTANCE_MAX ) {
+        return NULL;
+    }
+    probe_t *p_probe = &g_instances[g_instance_num++];
+    memset(p_probe, 0, sizeof(*p_probe));
+    p_probe->p_type = p_type;
+    p_probe->id = -1;
+    p_probe->handle.ops = p_ops;
+    p_probe->handle.p_module = p_probe;
+    return &p_probe->handle;
+}
+
+static tf_module_t *probe_instance(void)
+{
+    return instance("probe", &probe_ops);
+}
+
+static tf_module_t *plain_instance(void)
+{
+    return instance("plain", &plain_ops);
+}
+
+static void probe_destroy(tf_module_t *p_module)
+{
+    ((probe_t *)p_module->p_module)->destroyed = true;
+}
+
+static tf_module_mgmt_t probe_mgmt = { .tf_module_instance = probe_instance, .tf_module_destroy = probe_destroy };
+static tf_module_mgmt_t plain_mgmt = { .tf_module_instance = plain_instance, .tf_module_destroy = probe_destroy };
+
+// The live instance of module id, NULL if none or more than one
+static probe_t *probe_find(int id)
+{
+    probe_t *p_found = NULL;
+    for (int i = 0; i < g_instance_num; i++) {
+        if( g_instances[i].id == id && !g_instances[i].destroyed ) {
+            if( p_found != NULL ) {
+                return NULL;
+            }
+            p_found = &g_instances[i];
+        }
+    }
+    return p_found;
+}
+
+static int live_num(void)
+{
+    int num = 0;
+    for (int i = 0; i < g_instance_num; i++) {
+        num += !g_instances[i].destroyed;
+    }
+    return num;
+}
+
+static void status_cb(void *p_arg, intmax_t tid, int status, const char *p_err_module)
+{
+    __atomic_store_n(&g_status, status, __ATOMIC_SEQ_CST);
+}
+
+// Set a flow and wait for the engine to be done with it: running and counted, or failed
+static bool flow_set(const char *p_json, int status)
+{
+    tf_engine_reload_stats_t stats;
+    tf_engine_reload_stats_get(&stats);
+    uint32_t num = stats.num;
+
+    __atomic_store_n(&g_status, -1, __ATOMIC_SEQ_CST);
+    if( tf_engine_flow_set(p_json, strlen(p_json)) != ESP_OK ) {
+        return false;
+    }
+    int64_t deadline = esp_timer_get_time() + 10 * 1000 * 1000;
+    while (esp_timer_get_time() < deadline) {
+        int now = __atomic_load_n(&g_status, __ATOMIC_SEQ_CST);
+        tf_engine_reload_stats_get(&stats);
+        if( now == TF_STATUS_RUNNING && stats.num == num + 1 ) {
+            return status == TF_STATUS_RUNNING;
+        }
+        if( now >= TF_STATUS_ERR_GENERAL ) {
+            // the engine task stops the modules once it saw the error
+            vTaskDelay(pdMS_TO_TICKS(50));
+            return now == status;
+        }
+        vTaskDelay(1);
+    }
+    return false;
+}
+
+#define FLOW(modules) "{\"tlid\":1,\"ctd\":1,\"tn\":\"test\",\"type\":0,\"task_flow\":[" modules "]}"
+
+static const char *FLOW_1 = FLOW(
+    "{\"id\":1,\"type\":\"probe\",\"index\":0,\"params\":{\"a\":1},\"wires\":[[2,3]]},"
+    "{\"id\":2,\"type\":\"probe\",\"index\":1,\"params\":{\"b\":1},\"wires\":[]},"
+    "{\"id\":3,\"type\":\"plain\",\"index\":2,\"params\":{\"c\":1},\"wires\":[]},"
+    "{\"id\":4,\"type\":\"plain\",\"index\":3,\"params\":{\"d\":1},\"wires\":[]},"
+    "{\"id\":6,\"type\":\"probe\",\"index\":4,\"params\":{\"e\":{\"f\":[1,2]}},\"wires\":[]}");
+
+// 1 loses its output to 3, 2 and 4 get new params, 3 goes, 5 comes, 6 is the same in another order
+static const char *FLOW_2 = FLOW(
+    "{\"id\":6,\"type\":\"probe\",\"index\":4,\"params\":{\"e\":{\"f\":[1,2]}},\"wires\":[]},"
+    "{\"id\":1,\"type\":\"probe\",\"index\":0,\"params\":{\"a\":1},\"wires\":[[2]]},"
+    "{\"id\":2,\"type\":\"probe\",\"index\":1,\"params\":{\"b\":2},\"wires\":[]},"
+    "{\"id\":4,\"type\":\"plain\",\"index\":3,\"params\":{\"d\":2},\"wires\":[]},"
+    "{\"id\":5,\"type\":\"plain\",\"index\":2,\"params\":{},\"wires\":[]}");
+
+// 2 becomes a plain module
+static const char *FLOW_3 = FLOW(
+    "{\"id\":6,\"type\":\"probe\",\"index\":4,\"params\":{\"e\":{\"f\":[1,2]}},\"wires\":[]},"
+    "{\"id\":1,\"type\":\"probe\",\"index\":0,\"params\":{\"a\":1},\"wires\":[[2]]},"
+    "{\"id\":2,\"type\":\"plain\",\"index\":1,\"params\":{\"b\":2},\"wires\":[]},"
+    "{\"id\":4,\"type\":\"plain\",\"index\":3,\"params\":{\"d\":2},\"wires\":[]},"
+    "{\"id\":5,\"type\":\"plain\",\"index\":2,\"params\":{},\"wires\":[]}");
+
+static const char *FLOW_UNKNOWN = FLOW(
+    "{\"id\":1,\"type\":\"probe\",\"index\":0,\"params\":{\"a\":1},\"wires\":[[2]]},"
+    "{\"id\":2,\"type\":\"missing\",\"index\":1,\"params\":{},\"wires\":[]}");
+
+static void reload_check(int kept, int updated, int restarted, int added, int removed, const char *p_what)
+{
+    tf_engine_reload_stats_t stats;
+    tf_engine_reload_stats_get(&stats);
+    CHECK(stats.kept == kept && stats.updated == updated && stats.restarted == restarted && stats.added == added && stats.removed == removed,
+          "%s: kept %d, updated %d, restarted %d, added %d, removed %d", p_what, stats.kept, stats.updated, stats.restarted, stats.added, stats.removed);
+}
+
+static void test_start(void)
+{
+    tf_engine_reload_stats_t stats;
+
+    CHECK(flow_set(FLOW_1, TF_STATUS_RUNNING), "first flow not running, status %d", g_status);
+    tf_engine_reload_stats_get(&stats);
+    CHECK(stats.num == 1 && stats.full_num == 1, "%u flows, %u full", stats.num, stats.full_num);
+    reload_check(0, 0, 0, 5, 0, "start");
+    CHECK(g_instance_num == 5 && live_num() == 5, "%d instances, %d live", g_instance_num, live_num());
+    for (int id = 1; id <= 6; id++) {
+        probe_t *p_probe = probe_find(id);
+        if( id == 5 ) {
+            CHECK(p_probe == NULL, "module 5 set up before its flow");
+            continue;
+        }
+        CHECK(p_probe && p_probe->running && p_probe->cfg == 1 && p_probe->sub_set == 1 && p_probe->start == 1 && p_probe->stop == 0,
+              "module %d: running %d, cfg %d, sub %d, start %d, stop %d", id, p_probe ? p_probe->running : -1, p_probe ? p_probe->cfg : -1,
+              p_probe ? p_probe->sub_set : -1, p_probe ? p_probe->start : -1, p_probe ? p_probe->stop : -1);
+    }
+    CHECK(probe_find(1)->pub_set == 1 && probe_find(1)->outputs == 2, "module 1 outputs not set");
+}
+
+static void test_reload(void)
+{
+    tf_engine_reload_stats_t stats;
+    probe_t *p_one = probe_find(1);
+    probe_t *p_two = probe_find(2);
+    probe_t *p_three = probe_find(3);
+    probe_t *p_four = probe_find(4);
+    probe_t *p_six = probe_find(6);
+
+    CHECK(p_one && p_two && p_three && p_four && p_six, "modules of the first flow missing");
+    CHECK(flow_set(FLOW_2, TF_STATUS_RUNNING), "second flow not running, status %d", g_status);
+    tf_engine_reload_stats_get(&stats);
+    CHECK(stats.num == 2 && stats.full_num == 1, "%u flows, %u full", stats.num, stats.full_num);
+    reload_check(1, 2, 1, 1, 1, "reload");
+
+    // kept: nothing called
+    CHECK(probe_find(6) == p_six && p_six->running && p_six->cfg == 1 && p_six->cfg_update == 0 && p_six->start == 1 && p_six->stop == 0,
+          "unchanged module touched: cfg %d, update %d, start %d, stop %d", p_six->cfg, p_six->cfg_update, p_six->start, p_six->stop);
+    // new outputs while running
+    CHECK(probe_find(1) == p_one && p_one->running && p_one->pub_update == 1 && p_one->outputs == 1 && p_one->cfg_update == 0 && p_one->stop == 0,
+          "module 1: pub update %d, outputs %d, cfg update %d, stop %d", p_one->pub_update, p_one->outputs, p_one->cfg_update, p_one->stop);
+    // new params while running
+    CHECK(probe_find(2) == p_two && p_two->running && p_two->cfg_update == 1 && p_two->pub_update == 0 && p_two->stop == 0,
+          "module 2: cfg update %d, pub update %d, stop %d", p_two->cfg_update, p_two->pub_update, p_two->stop);
+    // new params, no update: restarted on its instance
+    CHECK(probe_find(4) == p_four && p_four->running && p_four->stop == 1 && p_four->cfg == 2 && p_four->sub_set == 2 && p_four->start == 2,
+          "module 4: stop %d, cfg %d, sub %d, start %d", p_four->stop, p_four->cfg, p_four->sub_set, p_four->start);
+    // removed
+    CHECK(p_three->destroyed && !p_three->running && p_three->stop == 1, "module 3: destroyed %d, stop %d", p_three->destroyed, p_three->stop);
+    // added
+    probe_t *p_five = probe_find(5);
+    CHECK(p_five && p_five->running && p_five->cfg == 1 && p_five->start == 1, "module 5 not set up");
+    CHECK(g_instance_num == 6 && live_num() == 5, "%d instances, %d live", g_instance_num, live_num());
+}
+
+static void test_rename(void)
+{
+    probe_t *p_two = probe_find(2);
+
+    CHECK(p_two && strcmp(p_two->p_type, "probe") == 0, "probe 2 missing");
+    CHECK(flow_set(FLOW_3, TF_STATUS_RUNNING), "third flow not running, status %d", g_status);
+    reload_check(4, 0, 0, 1, 1, "rename");
+    CHECK(p_two->destroyed && p_two->stop == 1, "old module 2: destroyed %d, stop %d", p_two->destroyed, p_two->stop);
+    CHECK(probe_find(2) && strcmp(probe_find(2)->p_type, "plain") == 0 && probe_find(2)->running, "new module 2 not running");
+    CHECK(live_num() == 5, "%d live", live_num());
+}
+
+static void test_failure(void)
+{
+    tf_engine_reload_stats_t stats;
+    int before = g_instance_num;
+
+    CHECK(flow_set(FLOW_UNKNOWN, TF_STATUS_ERR_MODULE_NOT_FOUND), "unknown module gave status %d", g_status);
+    CHECK(live_num() == 0, "%d modules left after a failed flow", live_num());
+    CHECK(g_instance_num == before, "%d modules set up for a failed flow", g_instance_num - before);
+    for (int i = 0; i < g_instance_num; i++) {
+        CHECK(!g_instances[i].running, "instance %d of module %d still running", i, g_instances[i].id);
+    }
+
+    CHECK(flow_set(FLOW_1, TF_STATUS_RUNNING), "flow after a failure not running, status %d", g_status);
+    tf_engine_reload_stats_get(&stats);
+    CHECK(stats.num == 4 && stats.full_num == 2, "%u flows, %u full", stats.num, stats.full_num);
+    reload_check(0, 0, 0, 5, 0, "after failure");
+    CHECK(live_num() == 5 && g_instance_num == before + 5, "%d live of %d", live_num(), g_instance_num);
+}
+
+static bool module_stats_get(const tf_engine_stats_t *p_stats, int id, const tf_engine_module_stats_t **pp_module)
+{
+    for (int i = 0; i < p_stats->module_num; i++) {
+        if( p_stats->modules[i].id == id ) {
+            *pp_module = &p_stats->modules[i];
+            return true;
+        }
+    }
+    return false;
+}
+
+static int json_number(cJSON *p_obj, const char *p_name)
+{
+    cJSON *p_item = cJSON_GetObjectItem(p_obj, p_name);
+    return cJSON_IsNumber(p_item) ? p_item->valueint : -1;
+}
+
+// FLOW_1 runs: 1 passes its events to 2 and to 3, which has no input to take them
+static void test_stats(void)
+{
+    static tf_engine_stats_t stats;
+    const tf_engine_module_stats_t *p_one = NULL;
+    const tf_engine_module_stats_t *p_two = NULL;
+    const tf_engine_module_stats_t *p_three = NULL;
+    tf_wire_stats_t unbound;
+
+    tf_wire_unbound_stats_get(&unbound);
+    for (int i = 0; i < EVENTS; i++) {
+        CHECK(tf_event_post(1, &i, sizeof(i), portMAX_DELAY) == ESP_OK, "post to module 1 refused");
+    }
+    int64_t deadline = esp_timer_get_time() + 10 * 1000 * 1000;
+    do {
+        vTaskDelay(1);
+        CHECK(tf_engine_stats_get(&stats) == ESP_OK, "stats get failed");
+        CHECK(module_stats_get(&stats, 2, &p_two), "no stats of module 2");
+    } while (p_two->wire.handled < EVENTS && esp_timer_get_time() < deadline);
+
+    CHECK(stats.module_num == 5 && stats.reload.num == 4, "%d modules, %u flows", stats.module_num, stats.reload.num);
+    CHECK(module_stats_get(&stats, 1, &p_one) && module_stats_get(&stats, 3, &p_three), "no stats of modules 1 and 3");
+    CHECK(strcmp(p_one->name, "probe") == 0 && strcmp(p_three->name, "plain") == 0, "names %s and %s", p_one->name, p_three->name);
+    CHECK(p_one->wire.event_id == 1 && p_one->wire.posted == EVENTS && p_one->wire.handled == EVENTS && p_one->wire.out == EVENTS,
+          "module 1: in %u, handled %u, out %u", p_one->wire.posted, p_one->wire.handled, p_one->wire.out);
+    CHECK(p_one->wire.data_alloc_bytes == EVENTS * EVENT_BYTES && p_one->wire.data_copy_bytes == 0,
+          "module 1: %llu bytes allocated, %llu copied", (unsigned long long)p_one->wire.data_alloc_bytes, (unsigned long long)p_one->wire.data_copy_bytes);
+    CHECK(p_two->wire.posted == EVENTS && p_two->wire.handled == EVENTS && p_two->wire.out == 0 && p_two->wire.data_alloc_bytes == EVENTS * EVENT_BYTES,
+          "module 2: in %u, handled %u, out %u", p_two->wire.posted, p_two->wire.handled, p_two->wire.out);
+    CHECK(p_three->wire.event_id == -1, "module 3 without input has wire %ld", (long)p_three->wire.event_id);
+    CHECK(stats.unbound.out == unbound.out + EVENTS, "unbound out went from %u to %u", unbound.out, stats.unbound.out);
+
+    cJSON *p_json = tf_engine_stats_json_create();
+    CHECK(p_json, "no stats JSON");
+    cJSON *p_modules = cJSON_GetObjectItem(p_json, "modules");
+    cJSON *p_module = NULL;
+    int checked = 0;
+    cJSON_ArrayForEach(p_module, p_modules) {
+        int id = json_number(p_module, "id");
+        if( id == 1 ) {
+            checked += json_number(p_module, "in") == EVENTS && json_number(p_module, "out") == EVENTS &&
+                       json_number(p_module, "alloc") == EVENTS * EVENT_BYTES;
+        } else if( id == 2 ) {
+            checked += json_number(p_module, "in") == EVENTS && json_number(p_module, "out") == 0;
+        } else if( id == 3 ) {
+            checked += cJSON_GetObjectItem(p_module, "in") == NULL;
+        }
+    }
+    cJSON *p_reload = cJSON_GetObjectItem(p_json, "reload");
+    int reload_num = json_number(p_reload, "num");
+    cJSON_Delete(p_json);
+    CHECK(checked == 3, "modules 1 to 3 wrong in the JSON");
+    CHECK(reload_num == 4, "reload num %d in the JSON", reload_num);
+}
+
+int main(void)
+{
+    if( tf_engine_init() != ESP_OK ) {
+        printf("engine init failed\n");
+        return 1;
+    }
+    // tf_engine_init() raises the engine's level, the host port only has one
+    esp_log_level_set("*", ESP_LOG_WARN);
+    tf_engine_status_cb_register(status_cb, NULL);
+    if( tf_module_register("probe", "counts calls", "1.0.0", &probe_mgmt) != ESP_OK ||
+        tf_module_register("plain", "counts calls, no updates", "1.0.0", &plain_mgmt) != ESP_OK ) {
+        printf("module register failed\n");
+        return 1;
+    }
+
+    test_start();
+    test_reload();
+    test_rename();
+    test_failure();
+    test_stats();
+
+    printf("%s\n", failures ? "FAILED" : "OK");
+    return failures ? 1 : 0;
+}
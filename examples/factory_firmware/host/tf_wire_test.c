@@ -0,0 +1,513 @@
+// Tests of the wires of the task flow engine, on the workers of tf_wires_init().
+//
+//   depth      depths round up to a power of 2, from 2 to TF_WIRE_DEPTH_MAX
+//   ring       a wire whose handler is held keeps its items in order up to its depth, a full
+//              DROP_NEWEST wire refuses the post and the producer keeps the data, a producer
+//              waiting on it gets in once the handler runs again
+//   policies   a full DROP_OLDEST wire frees its oldest item, COALESCE_LATEST frees everything
+//              queued, through the free callback
+//   self       a LOW handler posting to a full LOW wire is refused at once, not after its wait,
+//              since the worker it runs on is the only one for LOW wires
+//   order      threads post to wires of every priority at once, each handler sees the items of a
+//              producer in order and never runs on two workers at once
+//   refs       a frame shared to several wires, some of them dropping, is freed exactly once
+//   stats      the counters of a wire, and of the wire a handler or a bound task posts for
+//
+// tf_malloc() and tf_free() are the ones below, they count the blocks in use.
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_timer.h"
+#include "tf_module_util.h"
+#include "tf_util.h"
+#include "tf_wire.h"
+
+#define PRODUCERS   4
+#define ITEMS       20000
+
+ESP_EVENT_DEFINE_BASE(TF_EVENT_BASE);
+
+static int failures = 0;
+static int g_blocks = 0;
+
+#define CHECK(cond, ...)                    \
+    do {                                    \
+        if( !(cond) ) {                     \
+            printf("%s:%d: ", __func__, __LINE__); \
+            printf(__VA_ARGS__);            \
+            printf("\n");                   \
+            failures++;                     \
+            return;                         \
+        }                                   \
+    } while (0)
+
+void *tf_malloc(size_t sz)
+{
+    void *p = malloc(sz);
+    if( p != NULL ) {
+        __atomic_add_fetch(&g_blocks, 1, __ATOMIC_RELAXED);
+    }
+    return p;
+}
+
+void tf_free(void *ptr)
+{
+    if( ptr != NULL ) {
+        __atomic_sub_fetch(&g_blocks, 1, __ATOMIC_RELAXED);
+    }
+    free(ptr);
+}
+
+static int blocks(void)
+{
+    return __atomic_load_n(&g_blocks, __ATOMIC_RELAXED);
+}
+
+// What the tests post: who sent it and its number
+typedef struct
+{
+    uint32_t type;
+    uint32_t producer;
+    uint32_t seq;
+} item_t;
+
+// A handler that records what it sees, held on its gate after the first item when hold is set
+typedef struct
+{
+    SemaphoreHandle_t gate;
+    bool hold;
+    uint32_t seen[64];
+    uint32_t num;
+    uint32_t next[PRODUCERS];
+    uint32_t running;
+    uint32_t errors;
+} sink_t;
+
+static void sink_init(sink_t *p_sink, bool hold)
+{
+    memset(p_sink, 0, sizeof(*p_sink));
+    p_sink->hold = hold;
+    p_sink->gate = xSemaphoreCreateCounting(ITEMS, 0);
+}
+
+static void sink_handler(void *p_arg, esp_event_base_t base, int32_t id, void *p_data)
+{
+    sink_t *p_sink = (sink_t *)p_arg;
+    item_t *p_item = (item_t *)p_data;
+
+    if( __atomic_add_fetch(&p_sink->running, 1, __ATOMIC_SEQ_CST) != 1 ) {
+        p_sink->errors++; // on two workers at once
+    }
+    if( p_sink->num < 64 ) {
+        p_sink->seen[p_sink->num] = p_item->seq;
+    }
+    if( p_item->producer < PRODUCERS ) {
+        if( p_item->seq != p_sink->next[p_item->producer] ) {
+            p_sink->errors++; // out of order
+        }
+        p_sink->next[p_item->producer] = p_item->seq + 1;
+    }
+    __atomic_add_fetch(&p_sink->num, 1, __ATOMIC_SEQ_CST);
+    if( p_sink->hold ) {
+        xSemaphoreTake(p_sink->gate, portMAX_DELAY);
+    }
+    __atomic_sub_fetch(&p_sink->running, 1, __ATOMIC_SEQ_CST);
+}
+
+static bool sink_wait(sink_t *p_sink, uint32_t num)
+{
+    int64_t deadline = esp_timer_get_time() + 10 * 1000 * 1000;
+    while (__atomic_load_n(&p_sink->num, __ATOMIC_SEQ_CST) < num) {
+        if( esp_timer_get_time() > deadline ) {
+            return false;
+        }
+        vTaskDelay(1);
+    }
+    return true;
+}
+
+// The handled counter moves once the handler returned
+static bool wire_wait(int32_t event_id, uint32_t handled)
+{
+    int64_t deadline = esp_timer_get_time() + 10 * 1000 * 1000;
+    tf_wire_stats_t stats[TF_WIRE_MAX_NUM];
+
+    while (esp_timer_get_time() < deadline) {
+        int num = tf_wires_stats_get(stats, TF_WIRE_MAX_NUM);
+        for (int i = 0; i < num; i++) {
+            if( stats[i].event_id == event_id && stats[i].handled >= handled ) {
+                return true;
+            }
+        }
+        vTaskDelay(1);
+    }
+    return false;
+}
+
+static bool stats_get(int32_t event_id, tf_wire_stats_t *p_stats)
+{
+    tf_wire_stats_t stats[TF_WIRE_MAX_NUM];
+    int num = tf_wires_stats_get(stats, TF_WIRE_MAX_NUM);
+
+    for (int i = 0; i < num; i++) {
+        if( stats[i].event_id == event_id ) {
+            *p_stats = stats[i];
+            return true;
+        }
+    }
+    return false;
+}
+
+static esp_err_t post(int32_t event_id, uint32_t producer, uint32_t seq, TickType_t ticks)
+{
+    item_t item = { .type = TF_DATA_TYPE_UNKNOWN, .producer = producer, .seq = seq };
+    return tf_wire_post(event_id, &item, sizeof(item), ticks);
+}
+
+static int g_freed = 0;
+static uint32_t g_freed_seq[64];
+
+static void item_free(void *p_data)
+{
+    item_t *p_item = (item_t *)p_data;
+    if( p_item->type != TF_DATA_TYPE_UNKNOWN ) {
+        tf_data_free(p_data);
+        return;
+    }
+    g_freed_seq[g_freed++ % 64] = p_item->seq;
+}
+
+static void test_depth(void)
+{
+    static const int depths[][2] = { { 0, 2 }, { 1, 2 }, { 2, 2 }, { 3, 4 }, { 5, 8 }, { 64, 64 }, { 1000, TF_WIRE_DEPTH_MAX } };
+    sink_t sink;
+    tf_wire_stats_t stats = { 0 };
+
+    sink_init(&sink, false);
+    for (size_t i = 0; i < sizeof(depths) / sizeof(depths[0]); i++) {
+        tf_wire_cfg_t cfg = TF_WIRE_CFG_DEFAULT();
+        cfg.depth = depths[i][0];
+        CHECK(tf_wire_register(100, sink_handler, &sink, &cfg) == ESP_OK, "register failed");
+        CHECK(stats_get(100, &stats) && stats.cfg.depth == depths[i][1], "depth %d became %d, expected %d", depths[i][0], stats.cfg.depth, depths[i][1]);
+        CHECK(tf_wire_unregister(100, sink_handler) == ESP_OK, "unregister failed");
+    }
+    CHECK(tf_wire_register(100, sink_handler, &sink, NULL) == ESP_OK, "register failed");
+    CHECK(tf_wire_register(100, sink_handler, &sink, NULL) == ESP_ERR_INVALID_STATE, "second handler of a wire taken");
+    CHECK(tf_wire_unregister(100, sink_handler) == ESP_OK, "unregister failed");
+    CHECK(tf_wire_unregister(100, sink_handler) == ESP_ERR_NOT_FOUND, "unregistered twice");
+    CHECK(post(100, PRODUCERS, 0, 0) == ESP_ERR_NOT_FOUND, "post to no wire");
+}
+
+static void test_ring(void)
+{
+    tf_wire_cfg_t cfg = { .depth = 4, .policy = TF_WIRE_POLICY_DROP_NEWEST, .prio = TF_WIRE_PRIO_NORMAL };
+    tf_wire_stats_t stats = { 0 };
+    sink_t sink;
+
+    sink_init(&sink, true);
+    CHECK(tf_wire_register(101, sink_handler, &sink, &cfg) == ESP_OK, "register failed");
+
+    // the first item holds the handler, four more fill the wire
+    CHECK(post(101, PRODUCERS, 0, 0) == ESP_OK && sink_wait(&sink, 1), "first item not handled");
+    for (uint32_t seq = 1; seq <= 4; seq++) {
+        CHECK(post(101, PRODUCERS, seq, 0) == ESP_OK, "item %u refused", seq);
+    }
+    int64_t start = esp_timer_get_time();
+    CHECK(post(101, PRODUCERS, 5, pdMS_TO_TICKS(20)) == ESP_ERR_TIMEOUT, "post to a full wire taken");
+    CHECK(esp_timer_get_time() - start >= 19000, "full wire refused after %lld us, not its wait", (long long)(esp_timer_get_time() - start));
+    CHECK(stats_get(101, &stats) && stats.pending == 4 && stats.high_water == 4 && stats.dropped == 1 && stats.posted == 5,
+          "%u pending, high water %u, %u dropped, %u posted", stats.pending, stats.high_water, stats.dropped, stats.posted);
+    CHECK(g_freed == 0, "refused item freed by the wire");
+
+    // the handler goes on, a waiting producer gets in
+    for (int i = 0; i < 6; i++) {
+        xSemaphoreGive(sink.gate);
+    }
+    CHECK(post(101, PRODUCERS, 5, portMAX_DELAY) == ESP_OK, "waiting post refused");
+    CHECK(wire_wait(101, 6), "%u items handled", sink.num);
+    for (uint32_t i = 0; i < 6; i++) {
+        CHECK(sink.seen[i] == i, "item %u seen as %u", i, sink.seen[i]);
+    }
+    CHECK(tf_wire_unregister(101, sink_handler) == ESP_OK, "unregister failed");
+}
+
+static void test_policies(void)
+{
+    tf_wire_cfg_t cfg = { .depth = 2, .policy = TF_WIRE_POLICY_DROP_OLDEST, .prio = TF_WIRE_PRIO_HIGH };
+    tf_wire_stats_t stats = { 0 };
+    sink_t sink;
+
+    tf_wire_free_cb_set(item_free);
+
+    // held on 0, 1 and 2 queued, 3 and 4 push them out
+    sink_init(&sink, true);
+    g_freed = 0;
+    CHECK(tf_wire_register(102, sink_handler, &sink, &cfg) == ESP_OK, "register failed");
+    CHECK(post(102, PRODUCERS, 0, 0) == ESP_OK && sink_wait(&sink, 1), "first item not handled");
+    for (uint32_t seq = 1; seq <= 4; seq++) {
+        CHECK(post(102, PRODUCERS, seq, 0) == ESP_OK, "item %u refused", seq);
+    }
+    CHECK(g_freed == 2 && g_freed_seq[0] == 1 && g_freed_seq[1] == 2, "%d freed, first %u", g_freed, g_freed_seq[0]);
+    for (int i = 0; i < 3; i++) {
+        xSemaphoreGive(sink.gate);
+    }
+    CHECK(wire_wait(102, 3), "%u items handled", sink.num);
+    CHECK(sink.seen[1] == 3 && sink.seen[2] == 4, "handled %u and %u, expected 3 and 4", sink.seen[1], sink.seen[2]);
+    CHECK(stats_get(102, &stats) && stats.dropped == 2 && stats.handled == 3, "%u dropped, %u handled", stats.dropped, stats.handled);
+    CHECK(tf_wire_unregister(102, sink_handler) == ESP_OK, "unregister failed");
+
+    // coalesced: only the latest of what the held handler missed is left
+    cfg.policy = TF_WIRE_POLICY_COALESCE_LATEST;
+    cfg.depth = 8;
+    sink_init(&sink, true);
+    g_freed = 0;
+    CHECK(tf_wire_register(102, sink_handler, &sink, &cfg) == ESP_OK, "register failed");
+    CHECK(post(102, PRODUCERS, 0, 0) == ESP_OK && sink_wait(&sink, 1), "first item not handled");
+    for (uint32_t seq = 1; seq <= 5; seq++) {
+        CHECK(post(102, PRODUCERS, seq, 0) == ESP_OK, "item %u refused", seq);
+    }
+    CHECK(g_freed == 4 && g_freed_seq[3] == 4, "%d freed, last %u", g_freed, g_freed_seq[3]);
+    for (int i = 0; i < 2; i++) {
+        xSemaphoreGive(sink.gate);
+    }
+    CHECK(wire_wait(102, 2) && sink.seen[1] == 5, "%u handled, second %u", sink.num, sink.seen[1]);
+
+    // unregister frees what is still queued
+    sink.hold = true;
+    CHECK(post(102, PRODUCERS, 6, 0) == ESP_OK && sink_wait(&sink, 3), "item not handled");
+    CHECK(post(102, PRODUCERS, 7, 0) == ESP_OK, "item refused");
+    g_freed = 0;
+    xSemaphoreGive(sink.gate);
+    xSemaphoreGive(sink.gate);
+    CHECK(tf_wire_unregister(102, sink_handler) == ESP_OK, "unregister failed");
+    CHECK(g_freed + sink.num == 4, "%d freed and %u handled of 4", g_freed, sink.num);
+}
+
+// A LOW handler forwarding to another LOW wire, as the image analyzer feeds a cloud alarm
+typedef struct
+{
+    SemaphoreHandle_t gate;
+    esp_err_t ret;
+    int64_t us;
+    uint32_t done;
+} forward_t;
+
+static void forward_handler(void *p_arg, esp_event_base_t base, int32_t id, void *p_data)
+{
+    forward_t *p_fwd = (forward_t *)p_arg;
+
+    xSemaphoreTake(p_fwd->gate, portMAX_DELAY);
+    int64_t start = esp_timer_get_time();
+    p_fwd->ret = post(104, PRODUCERS, 99, pdMS_TO_TICKS(1000));
+    p_fwd->us = esp_timer_get_time() - start;
+    __atomic_store_n(&p_fwd->done, 1, __ATOMIC_SEQ_CST);
+}
+
+static void test_self(void)
+{
+    tf_wire_cfg_t cfg = { .depth = 2, .policy = TF_WIRE_POLICY_DROP_NEWEST, .prio = TF_WIRE_PRIO_LOW };
+    forward_t fwd = { .gate = xSemaphoreCreateBinary() };
+    tf_wire_stats_t stats = { 0 };
+    sink_t sink;
+
+    sink_init(&sink, false);
+    CHECK(tf_wire_register(103, forward_handler, &fwd, &cfg) == ESP_OK, "register failed");
+    CHECK(tf_wire_register(104, sink_handler, &sink, &cfg) == ESP_OK, "register failed");
+
+    // worker 0 is held in the forwarding handler, so nothing drains the wire it forwards to
+    CHECK(post(103, PRODUCERS, 0, 0) == ESP_OK, "post refused");
+    vTaskDelay(pdMS_TO_TICKS(10));
+    CHECK(post(104, PRODUCERS, 0, 0) == ESP_OK && post(104, PRODUCERS, 1, 0) == ESP_OK, "filling posts refused");
+    xSemaphoreGive(fwd.gate);
+
+    int64_t deadline = esp_timer_get_time() + 5 * 1000 * 1000;
+    while (!__atomic_load_n(&fwd.done, __ATOMIC_SEQ_CST) && esp_timer_get_time() < deadline) {
+        vTaskDelay(1);
+    }
+    CHECK(fwd.done, "forwarding handler still waiting");
+    CHECK(fwd.ret == ESP_ERR_TIMEOUT && fwd.us < 500 * 1000, "forward returned 0x%x after %lld us, expected a refusal at once", fwd.ret, (long long)fwd.us);
+    CHECK(wire_wait(104, 2), "queued items not handled after the forward");
+    CHECK(stats_get(104, &stats) && stats.dropped == 1 && stats.handled == 2, "%u dropped, %u handled", stats.dropped, stats.handled);
+    CHECK(tf_wire_unregister(103, forward_handler) == ESP_OK && tf_wire_unregister(104, sink_handler) == ESP_OK, "unregister failed");
+}
+
+typedef struct
+{
+    uint32_t producer;
+    int32_t event_ids[TF_WIRE_PRIO_NUM];
+    int refused;
+} producer_t;
+
+static void *producer(void *arg)
+{
+    producer_t *p_prod = (producer_t *)arg;
+
+    for (uint32_t seq = 0; seq < ITEMS; seq++) {
+        for (int i = 0; i < TF_WIRE_PRIO_NUM; i++) {
+            if( post(p_prod->event_ids[i], p_prod->producer, seq, portMAX_DELAY) != ESP_OK ) {
+                p_prod->refused++;
+            }
+        }
+    }
+    return NULL;
+}
+
+static void test_order(void)
+{
+    sink_t sinks[TF_WIRE_PRIO_NUM];
+    producer_t producers[PRODUCERS];
+    pthread_t threads[PRODUCERS];
+    tf_wire_stats_t stats = { 0 };
+
+    for (int i = 0; i < TF_WIRE_PRIO_NUM; i++) {
+        tf_wire_cfg_t cfg = { .depth = 8, .policy = TF_WIRE_POLICY_DROP_NEWEST, .prio = i };
+        sink_init(&sinks[i], false);
+        CHECK(tf_wire_register(110 + i, sink_handler, &sinks[i], &cfg) == ESP_OK, "register failed");
+    }
+    for (int p = 0; p < PRODUCERS; p++) {
+        producers[p] = (producer_t) { .producer = p, .event_ids = { 110, 111, 112 } };
+        pthread_create(&threads[p], NULL, producer, &producers[p]);
+    }
+    for (int p = 0; p < PRODUCERS; p++) {
+        pthread_join(threads[p], NULL);
+        CHECK(producers[p].refused == 0, "producer %d refused %d times", p, producers[p].refused);
+    }
+    for (int i = 0; i < TF_WIRE_PRIO_NUM; i++) {
+        CHECK(wire_wait(110 + i, PRODUCERS * ITEMS), "prio %d: %u of %u handled", i, sinks[i].num, PRODUCERS * ITEMS);
+        CHECK(sinks[i].errors == 0, "prio %d: %u items out of order or handled twice at once", i, sinks[i].errors);
+        CHECK(stats_get(110 + i, &stats) && stats.posted == PRODUCERS * ITEMS && stats.dropped == 0 && stats.high_water <= 8,
+              "prio %d: %u posted, %u dropped, high water %u", i, stats.posted, stats.dropped, stats.high_water);
+        CHECK(tf_wire_unregister(110 + i, sink_handler) == ESP_OK, "unregister failed");
+    }
+}
+
+static uint32_t g_frames = 0;
+
+static void frame_handler(void *p_arg, esp_event_base_t base, int32_t id, void *p_data)
+{
+    tf_data_dualimage_with_inference_t *p_frame = (tf_data_dualimage_with_inference_t *)p_data;
+    if( p_frame->img_small.p_buf == NULL || p_frame->img_small.p_buf[99] != 99 ) {
+        __atomic_add_fetch((uint32_t *)p_arg, 1, __ATOMIC_RELAXED);
+    }
+    tf_data_free(p_data);
+    __atomic_add_fetch(&g_frames, 1, __ATOMIC_SEQ_CST);
+}
+
+static void test_refs(void)
+{
+    enum { FRAMES = 2000, OUTPUTS = 3 };
+    tf_wire_cfg_t cfgs[OUTPUTS] = {
+        { .depth = 2, .policy = TF_WIRE_POLICY_DROP_OLDEST, .prio = TF_WIRE_PRIO_HIGH },
+        { .depth = 2, .policy = TF_WIRE_POLICY_COALESCE_LATEST, .prio = TF_WIRE_PRIO_NORMAL },
+        { .depth = 4, .policy = TF_WIRE_POLICY_DROP_NEWEST, .prio = TF_WIRE_PRIO_LOW },
+    };
+    uint32_t bad = 0;
+    uint32_t expected = 0;
+    tf_wire_stats_t stats = { 0 };
+    int64_t deadline = esp_timer_get_time() + 10 * 1000 * 1000;
+
+    tf_wire_free_cb_set(item_free);
+    g_frames = 0;
+    for (int o = 0; o < OUTPUTS; o++) {
+        CHECK(tf_wire_register(120 + o, frame_handler, &bad, &cfgs[o]) == ESP_OK, "register failed");
+    }
+    // as the AI camera posts a frame to each of its outputs, freeing what a wire refuses
+    for (int f = 0; f < FRAMES; f++) {
+        tf_data_dualimage_with_inference_t frame = { .type = TF_DATA_TYPE_DUALIMAGE_WITH_INFERENCE };
+        frame.img_small.p_buf = tf_data_alloc(100);
+        frame.img_small.len = 100;
+        for (int i = 0; i < 100; i++) {
+            frame.img_small.p_buf[i] = i;
+        }
+        for (int o = 0; o < OUTPUTS; o++) {
+            tf_data_dualimage_with_inference_t out;
+            tf_data_share(&out, &frame);
+            if( tf_wire_post(120 + o, &out, sizeof(out), 0) != ESP_OK ) {
+                tf_data_free(&out);
+            }
+        }
+        tf_data_free(&frame);
+    }
+    // the cells of the wires are all that is left once the handlers freed the last frames
+    while (blocks() > OUTPUTS && esp_timer_get_time() < deadline) {
+        vTaskDelay(1);
+    }
+    CHECK(blocks() == OUTPUTS, "%d blocks left", blocks() - OUTPUTS);
+    for (int o = 0; o < OUTPUTS; o++) {
+        CHECK(stats_get(120 + o, &stats), "no stats");
+        // refused posts are not queued, dropped ones were
+        CHECK(wire_wait(120 + o, stats.posted - (cfgs[o].policy == TF_WIRE_POLICY_DROP_NEWEST ? 0 : stats.dropped)), "output %d not drained", o);
+        CHECK(stats_get(120 + o, &stats), "no stats");
+        expected += stats.handled;
+    }
+    CHECK(__atomic_load_n(&g_frames, __ATOMIC_SEQ_CST) == expected, "%u frames handled, stats say %u", g_frames, expected);
+    CHECK(bad == 0, "%u frames freed under a handler", bad);
+    for (int o = 0; o < OUTPUTS; o++) {
+        CHECK(tf_wire_unregister(120 + o, frame_handler) == ESP_OK, "unregister failed");
+    }
+}
+
+static void test_stats(void)
+{
+    tf_wire_cfg_t cfg = { .depth = 4, .policy = TF_WIRE_POLICY_DROP_NEWEST, .prio = TF_WIRE_PRIO_NORMAL };
+    tf_wire_stats_t stats, unbound_before, unbound;
+    sink_t sink;
+    forward_t fwd = { .gate = xSemaphoreCreateCounting(4, 4) };
+
+    sink_init(&sink, false);
+    CHECK(tf_wire_register(130, forward_handler, &fwd, &cfg) == ESP_OK, "register failed");
+    CHECK(tf_wire_register(104, sink_handler, &sink, &cfg) == ESP_OK, "register failed");
+    tf_wire_unbound_stats_get(&unbound_before);
+
+    // posts of the handler count for its wire, the ones of this unbound task for nobody
+    CHECK(post(130, PRODUCERS, 0, 0) == ESP_OK && post(130, PRODUCERS, 1, 0) == ESP_OK, "post refused");
+    CHECK(wire_wait(130, 2) && wire_wait(104, 2), "items not handled");
+    CHECK(stats_get(130, &stats) && stats.out == 2 && stats.posted == 2 && stats.handled == 2, "forwarder: %u out, %u posted, %u handled", stats.out, stats.posted, stats.handled);
+    CHECK(stats.handle_hist[0] + stats.handle_hist[1] + stats.handle_hist[2] + stats.handle_hist[3] + stats.handle_hist[4] + stats.handle_hist[5] == 2,
+          "histogram does not add up to the handled items");
+    tf_wire_unbound_stats_get(&unbound);
+    CHECK(unbound.out == unbound_before.out + 2 && unbound.event_id == -1, "unbound out went from %u to %u", unbound_before.out, unbound.out);
+
+    // a bound task counts its posts and tf_data for the wire it is bound to
+    CHECK(tf_wire_task_bind(xTaskGetCurrentTaskHandle(), 130) == ESP_OK, "bind failed");
+    void *p_buf = tf_data_alloc(1000);
+    struct tf_data_buf src = { .p_buf = p_buf, .len = 1000 }, copy;
+    tf_data_buf_copy(&copy, &src);
+    CHECK(post(104, PRODUCERS, 2, 0) == ESP_OK && sink_wait(&sink, 3), "post refused");
+    CHECK(stats_get(130, &stats) && stats.out == 3 && stats.data_alloc_bytes == 2000 && stats.data_copy_bytes == 1000,
+          "bound: %u out, %llu bytes allocated, %llu copied", stats.out, (unsigned long long)stats.data_alloc_bytes, (unsigned long long)stats.data_copy_bytes);
+    CHECK(tf_wire_task_bind(xTaskGetCurrentTaskHandle(), -1) == ESP_OK, "unbind failed");
+    tf_data_buf_free(&src);
+    tf_data_buf_free(&copy);
+    CHECK(post(104, PRODUCERS, 3, 0) == ESP_OK && wire_wait(104, 4), "post refused");
+    CHECK(stats_get(130, &stats) && stats.out == 3, "unbound task still counted: %u out", stats.out);
+
+    CHECK(tf_wire_unregister(130, forward_handler) == ESP_OK && tf_wire_unregister(104, sink_handler) == ESP_OK, "unregister failed");
+    CHECK(blocks() == 0, "%d blocks left", blocks());
+}
+
+int main(void)
+{
+    if( tf_wires_init() != ESP_OK ) {
+        printf("wires init failed\n");
+        return 1;
+    }
+    g_blocks = 0;
+
+    test_depth();
+    test_ring();
+    test_policies();
+    test_self();
+    test_order();
+    test_refs();
+    test_stats();
+
+    printf("%s\n", failures ? "FAILED" : "OK");
+    return failures ? 1 : 0;
+}
@@ -399,10 +399,10 @@ static void __audio_player_cb(audio_player_cb_ctx_t *ctx)
     case AUDIO_PLAYER_CALLBACK_EVENT_IDLE:
         ESP_LOGI(TAG, "Player IDLE");
         __data_lock(p_audio_player);
-        if( p_audio_player->mem_need_free && p_audio_player->p_mem_buf != NULL) {
+        if( p_audio_player->mem_free != NULL && p_audio_player->p_mem_buf != NULL) {
             ESP_LOGI(TAG, "free mem");
-            free(p_audio_player->p_mem_buf);
-            p_audio_player->mem_need_free = false;
+            p_audio_player->mem_free(p_audio_player->p_mem_buf);
+            p_audio_player->mem_free = NULL;
             p_audio_player->p_mem_buf = NULL;
         }
         p_audio_player->status = AUDIO_PLAYER_STATUS_IDLE;
@@ -794,6 +794,11 @@ esp_err_t app_audio_player_file_block(void *p_filepath, TickType_t xTicksToWait)
 }
 
 esp_err_t app_audio_player_mem(uint8_t *p_buf, size_t len, bool is_need_free)
+{
+    return app_audio_player_mem_with_free(p_buf, len, is_need_free ? free : NULL);
+}
+
+esp_err_t app_audio_player_mem_with_free(uint8_t *p_buf, size_t len, void (*free_fn)(void *))
 {
     struct app_audio_player * p_audio_player = gp_audio_player;
     if( p_audio_player == NULL) {
@@ -806,7 +811,7 @@ esp_err_t app_audio_player_mem(uint8_t *p_buf, size_t len, bool is_need_free)
         if( status == ESP_OK ) {
             __data_lock(p_audio_player);
             p_audio_player->status = AUDIO_PLAYER_STATUS_PLAYING_MEM;
-            p_audio_player->mem_need_free = is_need_free;
+            p_audio_player->mem_free = free_fn;
             p_audio_player->p_mem_buf = p_buf;
             __data_unlock(p_audio_player);
             ESP_LOGI(TAG, "play mem: %d", len);
@@ -834,9 +839,9 @@ esp_err_t app_audio_player_mem_block(uint8_t *p_buf, size_t len, bool is_need_fr
             audio_player_stop();
             
             __data_lock(p_audio_player);
-            if( p_audio_player->mem_need_free && p_audio_player->p_mem_buf != NULL) {
-                free(p_audio_player->p_mem_buf);
-                p_audio_player->mem_need_free = false;
+            if( p_audio_player->mem_free != NULL && p_audio_player->p_mem_buf != NULL) {
+                p_audio_player->mem_free(p_audio_player->p_mem_buf);
+                p_audio_player->mem_free = NULL;
                 p_audio_player->p_mem_buf = NULL;
             }
             p_audio_player->status = AUDIO_PLAYER_STATUS_IDLE;
@@ -114,7 +114,7 @@ struct app_audio_player {
     size_t stream_play_len;
     bool stream_finished;
     bool stream_need_cache;
-    bool mem_need_free;
+    void (*mem_free)(void *); // gives p_mem_buf back once played, NULL to keep it
     void *p_mem_buf;
 #if defined(CONFIG_AUDIO_PLAYER_ENABLE_MP3_STREAM)
     HMP3Decoder mp3_decoder;
@@ -151,4 +151,6 @@ esp_err_t app_audio_player_file(void *p_filepath);
 esp_err_t app_audio_player_file_block(void *p_filepath, TickType_t xTicksToWait);
 
 esp_err_t app_audio_player_mem(uint8_t *p_buf, size_t len, bool is_need_free);
+// play p_buf and hand it to free_fn when done, e.g. tf_data_release for a shared task flow buffer
+esp_err_t app_audio_player_mem_with_free(uint8_t *p_buf, size_t len, void (*free_fn)(void *));
 esp_err_t app_audio_player_mem_block(uint8_t *p_buf, size_t len, bool is_need_free, TickType_t xTicksToWait);
@@ -375,6 +375,7 @@ static struct {
     struct arg_lit *export;
     struct arg_str *file;
     struct arg_str *json;
+    struct arg_lit *stats;
     struct arg_end *end;
 } taskflow_cfg_args;
 
@@ -395,6 +396,11 @@ static int taskflow_cmd(int argc, char **argv)
         return 1;
     }
 
+    if (taskflow_cfg_args.stats->count) {
+        tf_modules_report();
+        return 0;
+    }
+
     if (taskflow_cfg_args.export->count) {
         export = true;
     }
@@ -490,11 +496,12 @@ static void register_cmd_taskflow(void)
     taskflow_cfg_args.export = arg_lit0("e", "export", "export taskflow");
     taskflow_cfg_args.file =  arg_str0("f", "file", "<string>", "File path, import or export taskflow json string by SD, eg: test.json");
     taskflow_cfg_args.json =  arg_lit0("j", "json", "import taskflow json string by stdin");
-    taskflow_cfg_args.end = arg_end(4);
+    taskflow_cfg_args.stats =  arg_lit0("s", "stats", "print the queue depth and drop counters of every wire");
+    taskflow_cfg_args.end = arg_end(5);
 
     const esp_console_cmd_t cmd = {
         .command = "taskflow",
-        .help = "import taskflow by json string or SD file, eg:taskflow -i -f \"test.json\".\n export taskflow to stdout or SD file, eg: taskflow -e -f \"test.json\"",
+        .help = "import taskflow by json string or SD file, eg:taskflow -i -f \"test.json\".\n export taskflow to stdout or SD file, eg: taskflow -e -f \"test.json\".\n print wire counters, eg: taskflow -s",
         .hint = NULL,
         .func = &taskflow_cmd,
         .argtable = &taskflow_cfg_args
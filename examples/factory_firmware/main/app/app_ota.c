@@ -39,6 +39,9 @@ ESP_EVENT_DEFINE_BASE(OTA_EVENT_BASE);
 #define HTTP_RX_CHUNK_SIZE              512
 #define SSCMA_FLASH_CHUNK_SIZE_SPI      256   //this value is copied from the `sscma_client_ota` example
 #define SSCMA_FLASH_CHUNK_SIZE_UART     128   //this value is copied from the `sscma_client_ota` example
+#define SSCMA_FLASH_WRITE_SIZE          4096  //bytes per flasher write, a multiple of both chunk sizes and of the xmodem-1k block
+#define SSCMA_WRITER_POLL_MS            100
+#define SSCMA_WRITER_TIMEOUT_MS         60000 //give up when the download stalls this long
 #define AI_MODEL_RINGBUFF_SIZE          102400
 
 //event group events
@@ -384,6 +387,7 @@ static sscma_client_flasher_handle_t bsp_sscma_flasher_init_legacy(sscma_client_
         .io_expander = sscma_client->io_expander,
         .flags.reset_use_expander = BSP_SSCMA_CLIENT_RST_USE_EXPANDER,
         .flags.reset_high_active = false,
+        .flags.xmodem_1k = true,
         .user_ctx = NULL,
     };
 
@@ -445,7 +449,7 @@ static void __sscma_writer_task(void *p_arg)
                                                                         bsp_sscma_flasher_init_legacy(sscma_client);
         assert(sscma_flasher != NULL);
 
-        int sscma_flasher_chunk_size_decided = use_spi_flasher ? SSCMA_FLASH_CHUNK_SIZE_SPI : SSCMA_FLASH_CHUNK_SIZE_UART;
+        int sscma_flasher_align = use_spi_flasher ? SSCMA_FLASH_CHUNK_SIZE_SPI : SSCMA_FLASH_CHUNK_SIZE_UART;
 
         //sscma_client_init(sscma_client);
 
@@ -471,72 +475,54 @@ static void __sscma_writer_task(void *p_arg)
                                             &ota_status, sizeof(struct view_data_ota_status),
                                             pdMS_TO_TICKS(10000));
 
-        // drain the ringbuffer and write to himax
+        // drain the ringbuffer and write to himax, a whole write at a time while the download goes on
         int written_len = 0;
         int remain_len = content_len - written_len;
         int step_bytes = (int)(content_len / 10);
         int last_report_bytes = step_bytes;
-        int target_bytes;
-        int retry_cnt = 0;
-        void *chunk = psram_calloc(1, sscma_flasher_chunk_size_decided);
+        int target_bytes, filled, write_bytes;
+        int64_t last_data = esp_timer_get_time();
+        int64_t wait_us = 0, wait_start;
+        void *chunk = psram_calloc(1, SSCMA_FLASH_WRITE_SIZE);
         void *tmp;
-        UBaseType_t available_bytes = 0;
-        size_t rcvlen, rcvlen2;
+        size_t rcvlen;
 
         while (remain_len > 0 && !atomic_load(&g_sscma_writer_abort)) {
-            target_bytes = MIN(sscma_flasher_chunk_size_decided, remain_len);
-            vRingbufferGetInfo(g_rb_ai_model, NULL, NULL, NULL, NULL, &available_bytes);
-            if ((int)available_bytes < target_bytes) {
-                vTaskDelay(pdMS_TO_TICKS(1));
-                retry_cnt++;
-                if (retry_cnt > 60000) {
-                    ESP_LOGE(TAG, "sscma writer reach timeout on ringbuffer!!! want_bytes: %d", target_bytes);
-                    userdata->err = ESP_ERR_OTA_SSCMA_WRITE_FAIL;
-                    goto sscma_writer_end0;
-                }
-                continue;
-            }
-            retry_cnt = 0;
-
-            rcvlen = 0, rcvlen2 = 0;
-            tmp = xRingbufferReceiveUpTo(g_rb_ai_model, &rcvlen, 0, target_bytes);
-            if (!tmp) {
-                ESP_LOGW(TAG, "sscma writer, ringbuffer insufficient? this should never happen!");
-                userdata->err = ESP_ERR_OTA_SSCMA_INTERNAL_ERR;
-                goto sscma_writer_end0;
-            }
-            memset(chunk, 0, sscma_flasher_chunk_size_decided);
-            memcpy(chunk, tmp, rcvlen);
-            target_bytes -= rcvlen;
-            vRingbufferReturnItem(g_rb_ai_model, tmp);
-            //rollover?
-            if (target_bytes > 0) {
-                tmp = xRingbufferReceiveUpTo(g_rb_ai_model, &rcvlen2, 0, target_bytes);  //receive the 2nd part
+            target_bytes = MIN(SSCMA_FLASH_WRITE_SIZE, remain_len);
+            filled = 0;
+            //block on the ringbuffer instead of polling it, the 2nd receive takes the part after a rollover
+            wait_start = esp_timer_get_time();
+            while (filled < target_bytes && !atomic_load(&g_sscma_writer_abort)) {
+                rcvlen = 0;
+                tmp = xRingbufferReceiveUpTo(g_rb_ai_model, &rcvlen, pdMS_TO_TICKS(SSCMA_WRITER_POLL_MS), target_bytes - filled);
                 if (!tmp) {
-                    ESP_LOGW(TAG, "sscma writer, ringbuffer insufficient? this should never happen [2]!");
-                    userdata->err = ESP_ERR_OTA_SSCMA_INTERNAL_ERR;
-                    goto sscma_writer_end0;
+                    if (esp_timer_get_time() - last_data > SSCMA_WRITER_TIMEOUT_MS * 1000LL) {
+                        ESP_LOGE(TAG, "sscma writer reach timeout on ringbuffer!!! want_bytes: %d", target_bytes - filled);
+                        userdata->err = ESP_ERR_OTA_SSCMA_WRITE_FAIL;
+                        goto sscma_writer_end0;
+                    }
+                    continue;
                 }
-                memcpy(chunk + rcvlen, tmp, rcvlen2);
-                target_bytes -= rcvlen2;
+                memcpy(chunk + filled, tmp, rcvlen);
+                filled += rcvlen;
                 vRingbufferReturnItem(g_rb_ai_model, tmp);
+                last_data = esp_timer_get_time();
             }
+            wait_us += esp_timer_get_time() - wait_start;
+            if (filled < target_bytes) break;  //aborted
 
-            if (target_bytes != 0) {
-                ESP_LOGW(TAG, "sscma writer, this really should never happen!");
-                userdata->err = ESP_ERR_OTA_SSCMA_INTERNAL_ERR;
-                goto sscma_writer_end0;
-            }
+            //the flashers take whole pages or blocks, pad the tail
+            write_bytes = (filled + sscma_flasher_align - 1) / sscma_flasher_align * sscma_flasher_align;
+            memset(chunk + filled, 0, write_bytes - filled);
 
             //write to sscma client
-            // ESP_LOGD(TAG, "sscma writer, sscma_client_ota_write");
-            if (sscma_client_ota_write(sscma_client, chunk, sscma_flasher_chunk_size_decided) != ESP_OK)
+            if (sscma_client_ota_write(sscma_client, chunk, write_bytes) != ESP_OK)
             {
                 ESP_LOGW(TAG, "sscma writer, sscma_client_ota_write failed\n");
                 userdata->err = ESP_ERR_OTA_SSCMA_WRITE_FAIL;
                 goto sscma_writer_end0;
             } else {
-                written_len += (rcvlen + rcvlen2);
+                written_len += filled;
                 if (written_len >= last_report_bytes) {
                     ota_status.status = OTA_STATUS_DOWNLOADING;
                     ota_status.percentage = (int)(100 * written_len / content_len);
@@ -545,11 +531,12 @@ static void __sscma_writer_task(void *p_arg)
                                         &ota_status, sizeof(struct view_data_ota_status),
                                         pdMS_TO_TICKS(10000));
                     last_report_bytes += step_bytes;
-                    ESP_LOGI(TAG, "%s ota, bytes written: %d, %d%%", ota_type_str(ota_type), written_len, ota_status.percentage);
+                    ESP_LOGI(TAG, "%s ota, bytes written: %d, %d%%, %d KB/s", ota_type_str(ota_type), written_len, ota_status.percentage,
+                                    (int)(1000LL * written_len / (esp_timer_get_time() - start)));
                 }
             }
 
-            remain_len -= (rcvlen + rcvlen2);
+            remain_len -= filled;
         }  //while
 
         if (atomic_load(&g_sscma_writer_abort)) {
@@ -558,8 +545,8 @@ static void __sscma_writer_task(void *p_arg)
         } else {
             ESP_LOGD(TAG, "%s sscma writer, write done, take %lld us", ota_type_str(ota_type), esp_timer_get_time() - start);
             sscma_client_ota_finish(sscma_client);
-            ESP_LOGI(TAG, "%s sscma writer, finish, take %lld us, speed %d KB/s", ota_type_str(ota_type), esp_timer_get_time() - start,
-                            (int)(1000 * content_len / (esp_timer_get_time() - start)));
+            ESP_LOGI(TAG, "%s sscma writer, finish, take %lld us, speed %d KB/s, %lld us waiting for download", ota_type_str(ota_type), esp_timer_get_time() - start,
+                            (int)(1000LL * content_len / (esp_timer_get_time() - start)), wait_us);
         }
 sscma_writer_end0:
         free(chunk);
@@ -1139,6 +1139,64 @@ esp_err_t app_sensecraft_mqtt_report_taskflow_info(intmax_t taskflow_id,
     return ret;
 }
 
+esp_err_t app_sensecraft_mqtt_report_taskflow_stats(intmax_t taskflow_id,
+                                                     intmax_t taskflow_ctd,
+                                                     char *p_str, size_t len)
+{
+    int ret = ESP_OK;
+    struct app_sensecraft * p_sensecraft = gp_sensecraft;
+    if( p_sensecraft == NULL) {
+        return ESP_FAIL;
+    }
+    const char *json_fmt =  \
+    "{"
+        "\"requestId\": \"%s\","
+        "\"timestamp\": %jd,"
+        "\"intent\": \"event\","
+        "\"deviceEui\": \"%s\","
+        "\"events\":  ["
+            "{"
+                "\"name\": \"task-flow-stats\","
+                "\"value\": {"
+                    "\"tlid\": %jd,"
+                    "\"ctd\": %jd,"
+                    "\"stats\": %.*s"
+                "}"
+            "}"
+        "]"
+    "}";
+
+    ESP_RETURN_ON_FALSE(p_sensecraft->mqtt_handle != NULL, ESP_FAIL, TAG, "mqtt_client is not inited yet");
+    ESP_RETURN_ON_FALSE(p_sensecraft->mqtt_connected_flag, ESP_FAIL, TAG, "mqtt_client is not connected yet");
+
+    size_t json_buf_len = len + 512;
+    char *json_buff = psram_malloc( json_buf_len );
+    ESP_RETURN_ON_FALSE(json_buff != NULL, ESP_FAIL, TAG, "psram_malloc failed");
+
+    char uuid[37];
+    time_t timestamp_ms = util_get_timestamp_ms();
+
+    UUIDGen(uuid);
+
+    size_t json_len = sniprintf(json_buff, json_buf_len, json_fmt, uuid, timestamp_ms, \
+                                    p_sensecraft->deviceinfo.eui, taskflow_id, taskflow_ctd, len, p_str);
+
+    ESP_LOGD(TAG, "app_sensecraft_mqtt_report_taskflow_stats: \r\n%s\r\nstrlen=%d", json_buff, json_len);
+
+    // a lost report is replaced by the next one
+    int msg_id = esp_mqtt_client_enqueue(p_sensecraft->mqtt_handle, p_sensecraft->topic_up_taskflow_report, json_buff, json_len,
+                                        MQTT_PUB_QOS0, false/*retain*/, true/*store*/);
+
+    free(json_buff);
+
+    if (msg_id < 0) {
+        ESP_LOGW(TAG, "app_sensecraft_mqtt_report_taskflow_stats enqueue failed, err=%d", msg_id);
+        ret = ESP_FAIL;
+    }
+
+    return ret;
+}
+
 
 esp_err_t app_sensecraft_mqtt_report_taskflow_model_ota_status(intmax_t taskflow_id,
                                                                 intmax_t taskflow_ctd,
@@ -1200,9 +1258,28 @@ esp_err_t app_sensecraft_mqtt_report_taskflow_model_ota_status(intmax_t taskflow
     return ret;
 }
 
+// Base64 of a JPEG appended at *p_len, buf_len counts the '\0'
+static int __json_jpeg_append(char *p_buf, size_t buf_len, size_t *p_len, const uint8_t *p_jpeg, size_t jpeg_len)
+{
+    size_t olen = 0;
+    if( *p_len >= buf_len ) {
+        return -1;
+    }
+    if( p_jpeg == NULL || jpeg_len == 0 ) {
+        return 0;
+    }
+    int ret = mbedtls_base64_encode((uint8_t *)p_buf + *p_len, buf_len - *p_len, &olen, p_jpeg, jpeg_len);
+    if( ret != 0 ) {
+        ESP_LOGE(TAG, "mbedtls_base64_encode failed:%d,", ret);
+        return ret;
+    }
+    *p_len += olen;
+    return 0;
+}
+
 esp_err_t app_sensecraft_mqtt_report_warn_event(intmax_t taskflow_id, 
                                                 char *taskflow_name, 
-                                                char *p_img, size_t img_len, 
+                                                const uint8_t *p_jpeg, size_t jpeg_len, 
                                                 char *p_msg, size_t msg_len)
 {
     int ret = ESP_OK;
@@ -1225,7 +1302,10 @@ esp_err_t app_sensecraft_mqtt_report_warn_event(intmax_t taskflow_id,
                         "{"
                             "\"tlid\": %jd,"
                             "\"tn\": \"%s\","
-                            "\"image\": \"%.*s\","
+                            "\"image\": \"";
+    // the image is encoded in place between the two halves
+    const char *json_fmt_tail =  \
+                            "\","
                             "\"content\": \"%.*s\""
                         "}"
                     "]"
@@ -1238,7 +1318,7 @@ esp_err_t app_sensecraft_mqtt_report_warn_event(intmax_t taskflow_id,
     ESP_RETURN_ON_FALSE(p_sensecraft->mqtt_handle, ESP_FAIL, TAG, "mqtt_client is not inited yet [3]");
     ESP_RETURN_ON_FALSE(p_sensecraft->mqtt_connected_flag, ESP_FAIL, TAG, "mqtt_client is not connected yet [3]");
 
-    size_t json_buf_len = img_len + msg_len + 512;
+    size_t json_buf_len = (jpeg_len + 2) / 3 * 4 + msg_len + 512;
     char *json_buff = psram_malloc( json_buf_len );
     ESP_RETURN_ON_FALSE(json_buff != NULL, ESP_FAIL, TAG, "psram_malloc failed");
 
@@ -1247,7 +1327,12 @@ esp_err_t app_sensecraft_mqtt_report_warn_event(intmax_t taskflow_id,
 
     UUIDGen(uuid);
     size_t json_len = sniprintf(json_buff, json_buf_len, json_fmt, uuid, timestamp_ms, p_sensecraft->deviceinfo.eui,
-              taskflow_id, taskflow_name, img_len, p_img, msg_len, p_msg, timestamp_ms);
+              taskflow_id, taskflow_name);
+    if( __json_jpeg_append(json_buff, json_buf_len, &json_len, p_jpeg, jpeg_len) != 0 ) {
+        free(json_buff);
+        return ESP_FAIL;
+    }
+    json_len += sniprintf(json_buff + json_len, json_buf_len - json_len, json_fmt_tail, msg_len, p_msg, timestamp_ms);
 
     ESP_LOGD(TAG, "app_sensecraft_mqtt_report_warn_event: \r\n%s\r\nstrlen=%d", json_buff, json_len);
 
@@ -1399,7 +1484,7 @@ esp_err_t app_sensecraft_mqtt_report_firmware_ota_status_generic(char *ota_statu
 }
 
 
-esp_err_t app_sensecraft_mqtt_preview_upload_with_reduce_freq(char *p_img, size_t img_len)
+esp_err_t app_sensecraft_mqtt_preview_upload_with_reduce_freq(const uint8_t *p_jpeg, size_t jpeg_len)
 {
 
     int ret = ESP_OK;
@@ -1436,7 +1521,10 @@ esp_err_t app_sensecraft_mqtt_preview_upload_with_reduce_freq(char *p_img, size_
             "\"name\": \"camera-preview-upload\","
             "\"value\": [{"
                 "\"data\": {"
-                    "\"image\": \"%.*s\""
+                    "\"image\": \"";
+    // the image is encoded in place between the two halves
+    const char *json_fmt_tail =  \
+                    "\""
                 "},"
                 "\"measureTime\": %jd"
             "}]"
@@ -1446,7 +1534,7 @@ esp_err_t app_sensecraft_mqtt_preview_upload_with_reduce_freq(char *p_img, size_
     ESP_RETURN_ON_FALSE(p_sensecraft->mqtt_handle, ESP_FAIL, TAG, "mqtt_client is not inited yet [3]");
     ESP_RETURN_ON_FALSE(p_sensecraft->mqtt_connected_flag, ESP_FAIL, TAG, "mqtt_client is not connected yet [3]");
 
-    size_t json_buf_len = img_len + 512;
+    size_t json_buf_len = (jpeg_len + 2) / 3 * 4 + 512;
     char *json_buff = psram_malloc( json_buf_len );
     ESP_RETURN_ON_FALSE(json_buff != NULL, ESP_FAIL, TAG, "psram_malloc failed");
 
@@ -1454,8 +1542,12 @@ esp_err_t app_sensecraft_mqtt_preview_upload_with_reduce_freq(char *p_img, size_
     time_t timestamp_ms = util_get_timestamp_ms();
 
     UUIDGen(uuid);
-    size_t json_len = sniprintf(json_buff, json_buf_len, json_fmt, uuid, timestamp_ms, p_sensecraft->deviceinfo.eui,
-                               img_len, p_img, timestamp_ms);
+    size_t json_len = sniprintf(json_buff, json_buf_len, json_fmt, uuid, timestamp_ms, p_sensecraft->deviceinfo.eui);
+    if( __json_jpeg_append(json_buff, json_buf_len, &json_len, p_jpeg, jpeg_len) != 0 ) {
+        free(json_buff);
+        return ESP_FAIL;
+    }
+    json_len += sniprintf(json_buff + json_len, json_buf_len - json_len, json_fmt_tail, timestamp_ms);
 
     ESP_LOGV(TAG, "app_sensecraft_mqtt_preview_upload: \r\n%s\r\nstrlen=%d", json_buff, json_len);
 
@@ -112,6 +112,11 @@ esp_err_t app_sensecraft_mqtt_report_taskflow_info(intmax_t taskflow_id,
                                                     int module_status,
                                                     char *p_str, size_t len);
 
+// p_str is the JSON of tf_engine_stats_json_create
+esp_err_t app_sensecraft_mqtt_report_taskflow_stats(intmax_t taskflow_id,
+                                                     intmax_t taskflow_ctd,
+                                                     char *p_str, size_t len);
+
 esp_err_t app_sensecraft_mqtt_report_taskflow_model_ota_status(intmax_t taskflow_id,
                                                                 intmax_t taskflow_ctd,
                                                                 int ota_status,
@@ -121,7 +126,7 @@ esp_err_t app_sensecraft_mqtt_report_taskflow_model_ota_status(intmax_t taskflow
                                                                          
 esp_err_t app_sensecraft_mqtt_report_warn_event(intmax_t taskflow_id, 
                                                 char *taskflow_name, 
-                                                char *p_img, size_t img_len, 
+                                                const uint8_t *p_jpeg, size_t jpeg_len, 
                                                 char *p_msg, size_t msg_len);
 
 esp_err_t app_sensecraft_mqtt_report_device_status_generic(char *event_value_fields);
@@ -129,7 +134,8 @@ esp_err_t app_sensecraft_mqtt_report_device_status(struct view_data_device_statu
 
 esp_err_t app_sensecraft_mqtt_report_firmware_ota_status_generic(char *ota_status_fields_str);
 
-esp_err_t app_sensecraft_mqtt_preview_upload_with_reduce_freq(char *p_img, size_t img_len);
+// the JPEG is base64 encoded only when a preview is actually sent
+esp_err_t app_sensecraft_mqtt_preview_upload_with_reduce_freq(const uint8_t *p_jpeg, size_t jpeg_len);
 
 #ifdef __cplusplus
 }
@@ -9,6 +9,7 @@
 #include "uuid.h"
 #include "app_sensecraft.h"
 #include "tf.h"
+#include "tf_module_util.h"
 #include "tf_module_timer.h"
 #include "tf_module_debug.h"
 #include "tf_module_ai_camera.h"
@@ -575,6 +576,37 @@ static void __task_flow_module_status_cb(void *p_arg, const char *p_name, int mo
 
 }
 
+static void __taskflow_stats_report(struct app_taskflow * p_taskflow)
+{
+    intmax_t tlid = 0;
+    intmax_t ctd = 0;
+    int engine_status = 0;
+
+    tf_engine_status_get( &engine_status);
+    if( engine_status != TF_STATUS_RUNNING ) {
+        return;
+    }
+    cJSON *p_stats = tf_engine_stats_json_create();
+    if( p_stats == NULL ) {
+        ESP_LOGW(TAG, "Failed to get taskflow stats");
+        return;
+    }
+    char *p_str = cJSON_PrintUnformatted(p_stats);
+    cJSON_Delete(p_stats);
+    if( p_str == NULL ) {
+        return;
+    }
+
+    __report_lock(p_taskflow);
+    tf_engine_ctd_get( &ctd );
+    tf_engine_tid_get( &tlid );
+    if( app_sensecraft_mqtt_report_taskflow_stats( tlid, ctd, p_str, strlen(p_str)) != ESP_OK ) {
+        ESP_LOGW(TAG, "Failed to report taskflow stats to MQTT server");
+    }
+    __report_unlock(p_taskflow);
+    free(p_str);
+}
+
 static void __taskflow_task(void *p_arg)
 {
     struct app_taskflow * p_taskflow = ( struct app_taskflow *)p_arg;
@@ -582,6 +614,7 @@ static void __taskflow_task(void *p_arg)
     struct view_data_taskflow_status status;
     
     p_taskflow->report_cnt = 0;
+    p_taskflow->stats_report_cnt = 0;
 
     while(1) {
         
@@ -648,6 +681,13 @@ static void __taskflow_task(void *p_arg)
                 }
                 p_taskflow->report_cnt++;
             }
+
+#if CONFIG_TASKFLOW_STATS_REPORT_INTERVAL > 0
+            if ( ++p_taskflow->stats_report_cnt >= CONFIG_TASKFLOW_STATS_REPORT_INTERVAL ) {
+                __taskflow_stats_report(p_taskflow);
+                p_taskflow->stats_report_cnt = 0;
+            }
+#endif
         } 
         vTaskDelay(pdMS_TO_TICKS(1000));
     }
@@ -1018,6 +1058,7 @@ static void __ctrl_event_handler(void* handler_args,
 static  void taskflow_engine_module_init( struct app_taskflow * p_taskflow)
 {
     ESP_ERROR_CHECK(tf_engine_init());
+    ESP_ERROR_CHECK(tf_event_free_cb_register(tf_data_free));
     ESP_ERROR_CHECK(tf_module_timer_register());
     ESP_ERROR_CHECK(tf_module_debug_register());
     ESP_ERROR_CHECK(tf_module_ai_camera_register());
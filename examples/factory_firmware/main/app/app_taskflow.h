@@ -30,6 +30,7 @@ struct app_taskflow
     bool status_need_report;
     bool mqtt_connect_flag;
     int report_cnt;
+    int stats_report_cnt;
     bool need_pause_taskflow;
 };
 
@@ -359,6 +359,7 @@ void AT_command_reg()
     add_command(&commands, "taskflow?", handle_taskflow_query_command);
     add_command(&commands, "taskflow=", handle_taskflow_command);
     add_command(&commands, "taskflowinfo?", handle_taskflow_info_query_command);
+    add_command(&commands, "taskflowstats?", handle_taskflow_stats_query_command);
     add_command(&commands, "cloudservice=", handle_cloud_service_command);
     add_command(&commands, "cloudservice?", handle_cloud_service_query_command);
     add_command(&commands, "emoji=", handle_emoji_command);
@@ -1473,6 +1474,41 @@ at_cmd_error_code handle_taskflow_info_query_command(char *params)
     return AT_CMD_SUCCESS;
 }
 
+at_cmd_error_code handle_taskflow_stats_query_command(char *params)
+{
+    ESP_LOGI(TAG, "Handling handle_taskflow_stats_query_command \n");
+    cJSON *root = cJSON_CreateObject();
+    if (root == NULL)
+    {
+        ESP_LOGE(TAG, "Failed to create JSON object\n");
+        return ERROR_CMD_JSON_CREATE;
+    }
+    cJSON *data_rep = tf_engine_stats_json_create();
+    if (data_rep == NULL)
+    {
+        ESP_LOGE(TAG, "Failed to create JSON object\n");
+        cJSON_Delete(root);
+        return ERROR_CMD_JSON_CREATE;
+    }
+    cJSON_AddStringToObject(root, "name", "taskflowstats");
+    cJSON_AddNumberToObject(root, "code", 0);
+    cJSON_AddItemToObject(root, "data", data_rep);
+
+    char *json_string = cJSON_PrintUnformatted(root);
+    ESP_LOGD(TAG, "JSON String: %s\n", json_string);
+    esp_err_t send_result = send_at_response(json_string);
+    if (send_result != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Failed to send AT response\n");
+        cJSON_Delete(root);
+        free(json_string);
+        return ERROR_CMD_RESPONSE;
+    }
+    cJSON_Delete(root);
+    free(json_string);
+    return AT_CMD_SUCCESS;
+}
+
 at_cmd_error_code handle_taskflow_command(char *params)
 {
     esp_err_t code = ESP_OK;
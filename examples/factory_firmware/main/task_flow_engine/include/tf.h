@@ -1,6 +1,7 @@
 #pragma once
 #include "tf_module.h"
 #include "tf_parse.h"
+#include "tf_wire.h"
 #include "sys/queue.h"
 #include "esp_event.h"
 #include "freertos/FreeRTOS.h"
@@ -60,9 +61,41 @@ typedef void (*tf_engine_status_cb_t)(void * p_arg, intmax_t tid, int status, co
 
 typedef void (*tf_module_status_cb_t)(void * p_arg, const char *p_name, int status);
 
+// A flow set while another runs only restarts the modules it changes
+typedef struct
+{
+    uint32_t num;           // flows that went running
+    uint32_t full_num;      // of which every module was started, nothing was running before
+    int64_t last_us;        // time the last one took from receipt to running
+    int64_t max_us;
+    // modules of the last one
+    uint16_t kept;          // untouched
+    uint16_t updated;       // new params or outputs applied while running
+    uint16_t restarted;     // stopped and set up again on the same instance
+    uint16_t added;
+    uint16_t removed;
+} tf_engine_reload_stats_t;
+
+#define TF_ENGINE_STATS_NAME_LEN 24
+
+typedef struct
+{
+    int id;
+    char name[TF_ENGINE_STATS_NAME_LEN];
+    tf_wire_stats_t wire;   // event_id is -1 for a module without input
+} tf_engine_module_stats_t;
+
+// Counters of the running flow, too large for most task stacks
+typedef struct
+{
+    tf_engine_reload_stats_t reload;
+    int module_num;
+    tf_engine_module_stats_t modules[TF_WIRE_MAX_NUM];
+    tf_wire_stats_t unbound;    // posts and tf_data of tasks working for no module
+} tf_engine_stats_t;
+
 typedef struct tf_engine
 {
-    esp_event_loop_handle_t event_handle;
     tf_module_nodes_t module_nodes;
     TaskHandle_t task_handle;
     StaticTask_t *p_task_buf;
@@ -79,6 +112,7 @@ typedef struct tf_engine
     tf_module_status_cb_t  module_status_cb;
     void * p_module_status_cb_arg;
     int status;
+    tf_engine_reload_stats_t reload_stats;
 } tf_engine_t;
 
 /**
@@ -273,6 +307,41 @@ esp_err_t tf_engine_info_get(tf_info_t *p_info);
  */
 esp_err_t tf_engine_status_get(int *p_status);
 
+/**
+ * Retrieves the counters of the flows applied and the time the last one took to run.
+ *
+ * @param p_stats A pointer to store the counters.
+ *
+ * @return ESP_OK
+ *
+ * @throws None.
+ */
+esp_err_t tf_engine_reload_stats_get(tf_engine_reload_stats_t *p_stats);
+
+/**
+ * Retrieves the counters of every module of the running flow: events in and out,
+ * handler time histogram, queue high water, drops and tf_data bytes, with the reload counters.
+ *
+ * @param p_stats A pointer to store the counters.
+ *
+ * @return The result of the retrieval operation. Possible return values are:
+ *         - ESP_OK: The counters were successfully retrieved.
+ *         - ESP_ERR_INVALID_ARG: The pointer to store the counters is NULL.
+ *         - ESP_ERR_NO_MEM: Insufficient memory to collect the wire counters.
+ *
+ * @throws None.
+ */
+esp_err_t tf_engine_stats_get(tf_engine_stats_t *p_stats);
+
+/**
+ * Retrieves the counters of tf_engine_stats_get as JSON, for the AT command and the cloud report.
+ *
+ * @return The JSON object, NULL if out of memory. It must be freed with cJSON_Delete after use.
+ *
+ * @throws None.
+ */
+cJSON *tf_engine_stats_json_create(void);
+
 /**
  * Registers a callback function to receive notifications about engine status changes.
  *
@@ -331,17 +400,26 @@ esp_err_t tf_module_register(const char *p_name,
                                 const char *p_version,
                                 tf_module_mgmt_t *mgmt_handle);
 
+/**
+ * Logs the counters of tf_engine_stats_get for every module.
+ *
+ * @return ESP_OK
+ *
+ * @throws None
+ */
 esp_err_t tf_modules_report(void);
 
 /**
- * Posts an event to the task flow engine event loop.
+ * Posts an event to the wire of a module input.
  *
  * @param event_id the ID of the event to post
- * @param event_data pointer to the event data
- * @param event_data_size size of the event data
- * @param ticks_to_wait the amount of time to wait for the event to be posted
+ * @param event_data pointer to the event data, copied into the wire
+ * @param event_data_size size of the event data, TF_WIRE_ITEM_SIZE at most
+ * @param ticks_to_wait how long a full TF_WIRE_POLICY_DROP_NEWEST wire is waited for, the other policies never wait,
+ *        nor does a handler posting to a wire of its own worker's priority, which only it may be left to run
  *
- * @return esp_err_t ESP_OK if the event is successfully posted, error code otherwise
+ * @return esp_err_t ESP_OK if the event is successfully posted, error code otherwise.
+ *         The caller still owns the event data on error and must free it.
  *
  * @throws None
  */
@@ -351,7 +429,7 @@ esp_err_t tf_event_post(int32_t event_id,
                         TickType_t ticks_to_wait);
 
 /**
- * Registers an event handler for a specific event ID.
+ * Registers an event handler for a specific event ID, on a wire of the default configuration.
  *
  * @param event_id The ID of the event to register the handler for.
  * @param event_handler The event handler function to register.
@@ -364,6 +442,35 @@ esp_err_t tf_event_post(int32_t event_id,
 esp_err_t tf_event_handler_register(int32_t event_id,
                                     esp_event_handler_t event_handler,
                                     void *event_handler_arg);
+
+/**
+ * Registers an event handler for a specific event ID, with the depth, overflow policy and priority of its wire.
+ *
+ * @param event_id The ID of the event to register the handler for.
+ * @param event_handler The event handler function to register.
+ * @param event_handler_arg The argument to pass to the event handler.
+ * @param p_cfg The wire configuration, NULL for TF_WIRE_CFG_DEFAULT().
+ *
+ * @return The result of the registration operation.
+ *
+ * @throws None.
+ */
+esp_err_t tf_event_handler_register_with_cfg(int32_t event_id,
+                                             esp_event_handler_t event_handler,
+                                             void *event_handler_arg,
+                                             const tf_wire_cfg_t *p_cfg);
+
+/**
+ * Registers the function that frees event data a wire drops: items replaced under
+ * TF_WIRE_POLICY_DROP_OLDEST or TF_WIRE_POLICY_COALESCE_LATEST, and items still queued on unregister.
+ *
+ * @param free_cb The free function, tf_data_free for the task flow modules.
+ *
+ * @return ESP_OK
+ *
+ * @throws None.
+ */
+esp_err_t tf_event_free_cb_register(tf_event_free_cb_t free_cb);
 /**
  * Unregisters an event handler for a specific event ID.
  *
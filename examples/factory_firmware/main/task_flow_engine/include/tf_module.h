@@ -2,6 +2,7 @@
 #pragma once
 #include <stdint.h>
 #include "cJSON.h"
+#include "esp_err.h"
 
 #ifdef __cplusplus
 extern "C"
@@ -15,6 +16,11 @@ struct tf_module_ops
     int (*cfg)(void *p_module, cJSON *p_json);
     int (*msgs_sub_set)(void *p_module, int evt_id);
     int (*msgs_pub_set)(void *p_module, int output_index, int *p_evt_id, int num);
+
+    // Optional, used when a new flow changes a running module. Left NULL the
+    // engine stops the module and sets it up again instead.
+    int (*cfg_update)(void *p_module, cJSON *p_json);
+    int (*msgs_pub_update)(void *p_module, int output_index, int *p_evt_id, int num);
 };
 
 typedef struct 
@@ -55,6 +61,22 @@ static inline int tf_module_msgs_pub_set(tf_module_t *handle, int output_index,
     return handle->ops->msgs_pub_set(handle->p_module, output_index, p_evt_id, num);
 }
 
+static inline int tf_module_cfg_update(tf_module_t *handle, cJSON *p_json)
+{
+    if (handle->ops->cfg_update == NULL) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    return handle->ops->cfg_update(handle->p_module, p_json);
+}
+
+static inline int tf_module_msgs_pub_update(tf_module_t *handle, int output_index, int *p_evt_id, int num)
+{
+    if (handle->ops->msgs_pub_update == NULL) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    return handle->ops->msgs_pub_update(handle->p_module, output_index, p_evt_id, num);
+}
+
 #ifdef __cplusplus
 }
 #endif
\ No newline at end of file
@@ -0,0 +1,117 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "esp_event.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+ESP_EVENT_DECLARE_BASE(TF_EVENT_BASE);
+
+/*
+ * Every module input is a wire: a bounded lock-free queue of event data copies
+ * drained by a small worker pool. A handler only ever runs on one worker at a
+ * time and sees its events in order, different wires run in parallel. There is
+ * one worker per priority that runs wires of its priority and above, so a slow
+ * cloud module can hold up other low priority wires but never the camera to
+ * local alarm path.
+ */
+
+#define TF_WIRE_MAX_NUM              32
+#define TF_WIRE_ITEM_SIZE            256   // largest event data, tf_data_* structs fit
+#define TF_WIRE_DEPTH_MAX            64
+
+#define TF_WIRE_WORKER_STACK_SIZE    1024 * 3
+#define TF_WIRE_WORKER_PRIO          12    // task priority of the low priority worker, one more per wire priority
+#define TF_WIRE_WORKER_CORE          1
+
+#define TF_WIRE_TASK_BIND_MAX        4     // tasks of modules that post outside a handler
+
+// Handler run times are counted in buckets below 1 ms, 10 ms, 100 ms, 1 s, 10 s and longer
+#define TF_WIRE_HIST_NUM             6
+#define TF_WIRE_HIST_BOUNDS_US       { 1000, 10000, 100000, 1000000, 10000000 }
+
+enum tf_wire_policy {
+    TF_WIRE_POLICY_DROP_NEWEST = 0,  // a full wire refuses the post after ticks_to_wait, at once for the worker of
+                                     // its priority, the producer keeps the data
+    TF_WIRE_POLICY_DROP_OLDEST,      // a full wire frees its oldest item to make room
+    TF_WIRE_POLICY_COALESCE_LATEST,  // a post frees everything still queued, the handler only sees the latest
+};
+
+enum tf_wire_prio {
+    TF_WIRE_PRIO_LOW = 0,            // cloud uploads and other slow handlers
+    TF_WIRE_PRIO_NORMAL,
+    TF_WIRE_PRIO_HIGH,
+    TF_WIRE_PRIO_NUM,
+};
+
+typedef struct {
+    int depth;                       // items queued at most, rounded up to a power of 2
+    enum tf_wire_policy policy;
+    enum tf_wire_prio prio;
+} tf_wire_cfg_t;
+
+#define TF_WIRE_CFG_DEFAULT()                                                       \
+    {                                                                               \
+        .depth = 4, .policy = TF_WIRE_POLICY_DROP_NEWEST, .prio = TF_WIRE_PRIO_NORMAL, \
+    }
+
+typedef struct {
+    int32_t event_id;
+    tf_wire_cfg_t cfg;
+    uint32_t pending;                // items queued now
+    uint32_t high_water;             // most items queued at once
+    uint32_t posted;                 // items taken
+    uint32_t handled;                // items the handler ran on
+    uint32_t dropped;                // items refused, freed to make room or coalesced
+    uint32_t handle_max_us;          // longest handler run
+    uint32_t handle_hist[TF_WIRE_HIST_NUM];
+    uint32_t out;                    // items posted by the handler or a task bound to the wire
+    uint64_t data_alloc_bytes;       // tf_data allocated by them
+    uint64_t data_copy_bytes;        // of which copied from other tf_data
+} tf_wire_stats_t;
+
+typedef void (*tf_event_free_cb_t)(void *event_data);
+
+// Create the workers, called once by tf_engine_init
+esp_err_t tf_wires_init(void);
+
+// The wires behind tf_event_handler_register_with_cfg, tf_event_handler_unregister and tf_event_post
+esp_err_t tf_wire_register(int32_t event_id,
+                           esp_event_handler_t event_handler,
+                           void *event_handler_arg,
+                           const tf_wire_cfg_t *p_cfg);
+
+esp_err_t tf_wire_unregister(int32_t event_id, esp_event_handler_t event_handler);
+
+esp_err_t tf_wire_post(int32_t event_id,
+                       const void *event_data,
+                       size_t event_data_size,
+                       TickType_t ticks_to_wait);
+
+// Frees the items a wire drops, without one they leak
+void tf_wire_free_cb_set(tf_event_free_cb_t free_cb);
+
+// Counters of up to max_num registered wires, returns how many were written
+int tf_wires_stats_get(tf_wire_stats_t *p_stats, int max_num);
+
+// Posts and tf_data of tasks working for no wire, event_id is -1
+void tf_wire_unbound_stats_get(tf_wire_stats_t *p_stats);
+
+/*
+ * Posts and tf_data allocations are counted against the wire the calling task
+ * works for: the one whose handler a worker is running, or the one a module
+ * task that posts on its own was bound to. Binding -1 unbinds the task.
+ */
+esp_err_t tf_wire_task_bind(TaskHandle_t task, int32_t event_id);
+
+void tf_wire_data_count(size_t alloc_bytes, size_t copy_bytes);
+
+#ifdef __cplusplus
+}
+#endif
@@ -5,6 +5,7 @@
 #include "tf_util.h"
 #include "esp_log.h"
 #include "esp_check.h"
+#include "esp_timer.h"
 
 ESP_EVENT_DEFINE_BASE(TF_EVENT_BASE);
 
@@ -26,6 +27,8 @@ static tf_engine_t *gp_engine = NULL;
 #define MODULE_FLAG_SUB_SET_DONE   BIT3
 #define MODULE_FLAG_PUB_SET_DONE   BIT4
 #define MODULE_FLAG_START_DONE     BIT5
+#define MODULE_FLAG_CFG_CHANGED    BIT6   // reload: kept instance with new params
+#define MODULE_FLAG_PUB_CHANGED    BIT7   // reload: kept instance with new outputs
 
 static void __data_lock( tf_engine_t *p_engine)
 {
@@ -229,29 +232,52 @@ static int __modules_wires_check(tf_module_item_t *p_head, int num, struct tf_mo
    return ESP_OK;
 }
 
-static int __modules_msgs_pub_set(tf_module_item_t *p_head, int num, const char **pp_err_module)
+static int __modules_wires_check_all(tf_module_item_t *p_head, int num, const char **pp_err_module)
 {
     int ret = ESP_OK;
     *pp_err_module = NULL;
-    if( p_head ==NULL || num <= 0 ) {
-        return ESP_FAIL;
-    }
     for(int i = 0; i < num; i++) {
         for(int j = 0; j < p_head[i].output_port_num; j++) {
-
-            ret = __modules_wires_check(p_head, num, p_head[i].p_wires);
+            ret = __modules_wires_check(p_head, num, &p_head[i].p_wires[j]);
             if(ret != ESP_OK) {
                 *pp_err_module = p_head[i].p_name;
                 return ret;
             }
-            ret = tf_module_msgs_pub_set(p_head[i].handle, j,  \
-                                         p_head[i].p_wires->p_evt_id, p_head[i].p_wires->num);
-            if(ret != ESP_OK) {
-                ESP_LOGE(TAG, "Module %s msgs pub set failed", p_head[i].p_name);
-                *pp_err_module = p_head[i].p_name;
-                return ret;
-            }
-            p_head[i].flag |= MODULE_FLAG_PUB_SET_DONE;
+        }
+    }
+   return ESP_OK;
+}
+
+static int __module_msgs_pub_set(tf_module_item_t *p_item, bool update)
+{
+    int ret = ESP_OK;
+    for(int j = 0; j < p_item->output_port_num; j++) {
+        if( update ) {
+            ret = tf_module_msgs_pub_update(p_item->handle, j, p_item->p_wires[j].p_evt_id, p_item->p_wires[j].num);
+        } else {
+            ret = tf_module_msgs_pub_set(p_item->handle, j, p_item->p_wires[j].p_evt_id, p_item->p_wires[j].num);
+        }
+        if(ret != ESP_OK) {
+            return ret;
+        }
+        p_item->flag |= MODULE_FLAG_PUB_SET_DONE;
+    }
+   return ESP_OK;
+}
+
+static int __modules_msgs_pub_set(tf_module_item_t *p_head, int num, const char **pp_err_module)
+{
+    int ret = ESP_OK;
+    *pp_err_module = NULL;
+    if( p_head ==NULL || num <= 0 ) {
+        return ESP_FAIL;
+    }
+    for(int i = 0; i < num; i++) {
+        ret = __module_msgs_pub_set(&p_head[i], false);
+        if(ret != ESP_OK) {
+            ESP_LOGE(TAG, "Module %s msgs pub set failed", p_head[i].p_name);
+            *pp_err_module = p_head[i].p_name;
+            return ret;
         }
     }
    return ESP_OK;
@@ -310,6 +336,12 @@ static int __run(tf_engine_t *p_engine)
         return ESP_FAIL;
     }
 
+    ret = __modules_wires_check_all(p_engine->p_module_head, p_engine->module_item_num, &p_err_module);
+    if( ret != ESP_OK ) {
+        __status_cb(p_engine, TF_STATUS_ERR_MODULES_WIRES, p_err_module);
+        return ESP_FAIL;
+    }
+
     ret = __modules_msgs_pub_set(p_engine->p_module_head, p_engine->module_item_num, &p_err_module);
     if( ret != ESP_OK ) {
         __status_cb(p_engine, TF_STATUS_ERR_MODULES_WIRES, p_err_module);
@@ -326,12 +358,230 @@ static int __run(tf_engine_t *p_engine)
     return ESP_OK;
 }
 
+static bool __module_wires_equal(tf_module_item_t *p_a, tf_module_item_t *p_b)
+{
+    if( p_a->output_port_num != p_b->output_port_num ) {
+        return false;
+    }
+    for(int j = 0; j < p_a->output_port_num; j++) {
+        if( p_a->p_wires[j].num != p_b->p_wires[j].num ) {
+            return false;
+        }
+        if( p_a->p_wires[j].num > 0 &&
+            memcmp(p_a->p_wires[j].p_evt_id, p_b->p_wires[j].p_evt_id, sizeof(int) * p_a->p_wires[j].num) != 0 ) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Stop a module and set it up again on the same instance, the expensive part of
+// a restart is usually the instance (tasks, buffers), not start
+static int __module_restart(tf_engine_t *p_engine, tf_module_item_t *p_item)
+{
+    const char *p_err_module = NULL;
+
+    __modules_stop(p_item, 1);
+    p_item->flag &= MODULE_FLAG_INIT_DONE | MODULE_FLAG_INSTANCE_DONE;
+
+    if( __modules_cfg(p_item, 1, &p_err_module) != ESP_OK ) {
+        __status_cb(p_engine, TF_STATUS_ERR_MODULES_PARAMS, p_err_module);
+        return ESP_FAIL;
+    }
+    if( __modules_msgs_sub_set(p_item, 1, &p_err_module) != ESP_OK ||
+        __modules_msgs_pub_set(p_item, 1, &p_err_module) != ESP_OK ) {
+        __status_cb(p_engine, TF_STATUS_ERR_MODULES_WIRES, p_err_module);
+        return ESP_FAIL;
+    }
+    if( __modules_start(p_item, 1, &p_err_module) != ESP_OK ) {
+        __status_cb(p_engine, TF_STATUS_ERR_MODULES_START, p_err_module);
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+/*
+ * Replace the running flow with a new one, touching only what changed. A module
+ * with the same id and name keeps its instance: left alone when its params and
+ * outputs are the same, updated while running when the module supports it, else
+ * restarted on the instance. Removed modules are stopped, new ones started.
+ * The new flow is installed either way, on error the status is reported and the
+ * caller stops it like a failed __run.
+ */
+static int __reload(tf_engine_t *p_engine, cJSON *p_root, tf_module_item_t *p_head, int num,
+                    tf_info_t *p_info, tf_engine_reload_stats_t *p_last)
+{
+    int ret = ESP_OK;
+    int init_ret = ESP_OK;
+    const char *p_err_module = NULL;
+    cJSON *p_old_root = p_engine->cur_flow_root;
+    tf_module_item_t *p_old_head = p_engine->p_module_head;
+    int old_num = p_engine->module_item_num;
+
+    memset(p_last, 0, sizeof(tf_engine_reload_stats_t));
+
+    init_ret = __modules_init(p_engine, p_head, num, &p_err_module);
+
+    for(int i = 0; i < num; i++) {
+        for(int j = 0; j < old_num; j++) {
+            tf_module_item_t *p_old = &p_old_head[j];
+            if( p_old->handle == NULL || p_old->id != p_head[i].id || strcmp(p_old->p_name, p_head[i].p_name) != 0 ) {
+                continue;
+            }
+            // the instance moves to the new flow
+            p_head[i].handle = p_old->handle;
+            p_head[i].mgmt_handle = p_old->mgmt_handle;
+            p_head[i].flag = p_old->flag;
+            if( !cJSON_Compare(p_old->p_params, p_head[i].p_params, true) ) {
+                p_head[i].flag |= MODULE_FLAG_CFG_CHANGED;
+            }
+            if( !__module_wires_equal(p_old, &p_head[i]) ) {
+                p_head[i].flag |= MODULE_FLAG_PUB_CHANGED;
+            }
+            p_old->handle = NULL;
+            p_old->flag = 0;
+            break;
+        }
+    }
+
+    // removed modules first, so a new module may take over their id
+    for(int j = 0; j < old_num; j++) {
+        if( p_old_head[j].handle != NULL ) {
+            ESP_LOGI(TAG, "remove %s-%d", p_old_head[j].p_name, p_old_head[j].id);
+            p_last->removed++;
+        }
+    }
+    __modules_stop(p_old_head, old_num);
+    __modules_destroy(p_old_head, old_num);
+
+    __data_lock(p_engine);
+    p_engine->cur_flow_root = p_root;
+    p_engine->p_module_head = p_head;
+    p_engine->module_item_num = num;
+    p_engine->tf_info = *p_info;
+    __data_unlock(p_engine);
+    tf_parse_free(p_old_root, p_old_head, old_num);
+
+    __status_cb(p_engine, TF_STATUS_STARTING, NULL);
+
+    ESP_LOGI(TAG, "======= RELOAD =====");
+    ESP_LOGI(TAG, "tlid: %jd", p_engine->tf_info.tid);
+    ESP_LOGI(TAG, "name: %s", p_engine->tf_info.p_tf_name);
+    ESP_LOGI(TAG, "num:  %d", num);
+    ESP_LOGI(TAG, "====================");
+
+    if( init_ret != ESP_OK ) {
+        __status_cb(p_engine, TF_STATUS_ERR_MODULE_NOT_FOUND, p_err_module);
+        return ESP_FAIL;
+    }
+    ret = __modules_wires_check_all(p_head, num, &p_err_module);
+    if( ret != ESP_OK ) {
+        __status_cb(p_engine, TF_STATUS_ERR_MODULES_WIRES, p_err_module);
+        return ESP_FAIL;
+    }
+
+    // new modules are set up but only started once the others are rewired
+    for(int i = 0; i < num; i++) {
+        if( p_head[i].flag & MODULE_FLAG_INSTANCE_DONE ) {
+            continue;
+        }
+        ESP_LOGI(TAG, "add %s-%d", p_head[i].p_name, p_head[i].id);
+        p_last->added++;
+        if( __modules_instance(&p_head[i], 1, &p_err_module) != ESP_OK ) {
+            __status_cb(p_engine, TF_STATUS_ERR_MODULES_INSTANCE, p_err_module);
+            return ESP_FAIL;
+        }
+        if( __modules_cfg(&p_head[i], 1, &p_err_module) != ESP_OK ) {
+            __status_cb(p_engine, TF_STATUS_ERR_MODULES_PARAMS, p_err_module);
+            return ESP_FAIL;
+        }
+        if( __modules_msgs_sub_set(&p_head[i], 1, &p_err_module) != ESP_OK ||
+            __modules_msgs_pub_set(&p_head[i], 1, &p_err_module) != ESP_OK ) {
+            __status_cb(p_engine, TF_STATUS_ERR_MODULES_WIRES, p_err_module);
+            return ESP_FAIL;
+        }
+    }
+
+    for(int i = 0; i < num; i++) {
+        uint32_t changed = p_head[i].flag & (MODULE_FLAG_CFG_CHANGED | MODULE_FLAG_PUB_CHANGED);
+        if( !(p_head[i].flag & MODULE_FLAG_START_DONE) ) {
+            continue;
+        }
+        p_head[i].flag &= ~changed;
+        if( changed == 0 ) {
+            p_last->kept++;
+            continue;
+        }
+        ret = ESP_OK;
+        if( changed & MODULE_FLAG_CFG_CHANGED ) {
+            ret = tf_module_cfg_update(p_head[i].handle, p_head[i].p_params);
+        }
+        if( ret == ESP_OK && (changed & MODULE_FLAG_PUB_CHANGED) ) {
+            ret = __module_msgs_pub_set(&p_head[i], true);
+        }
+        if( ret == ESP_OK ) {
+            ESP_LOGI(TAG, "update %s-%d", p_head[i].p_name, p_head[i].id);
+            p_last->updated++;
+            continue;
+        }
+        ESP_LOGI(TAG, "restart %s-%d", p_head[i].p_name, p_head[i].id);
+        p_last->restarted++;
+        if( __module_restart(p_engine, &p_head[i]) != ESP_OK ) {
+            return ESP_FAIL;
+        }
+    }
+
+    for(int i = 0; i < num; i++) {
+        if( p_head[i].flag & MODULE_FLAG_START_DONE ) {
+            continue;
+        }
+        if( __modules_start(&p_head[i], 1, &p_err_module) != ESP_OK ) {
+            __status_cb(p_engine, TF_STATUS_ERR_MODULES_START, p_err_module);
+            return ESP_FAIL;
+        }
+    }
+    __status_cb(p_engine, TF_STATUS_RUNNING, NULL);
+
+    return ESP_OK;
+}
+
+static void __reload_stats_update(tf_engine_t *p_engine, int64_t start_us, bool full, tf_engine_reload_stats_t *p_last)
+{
+    int64_t us = esp_timer_get_time() - start_us;
+
+    __data_lock(p_engine);
+    tf_engine_reload_stats_t *p_stats = &p_engine->reload_stats;
+    p_stats->num++;
+    if( full ) {
+        p_stats->full_num++;
+    }
+    p_stats->last_us = us;
+    if( us > p_stats->max_us ) {
+        p_stats->max_us = us;
+    }
+    p_stats->kept = p_last->kept;
+    p_stats->updated = p_last->updated;
+    p_stats->restarted = p_last->restarted;
+    p_stats->added = p_last->added;
+    p_stats->removed = p_last->removed;
+    __data_unlock(p_engine);
+
+    ESP_LOGI(TAG, "%s in %lld ms: kept %d, updated %d, restarted %d, added %d, removed %d",
+             full ? "start" : "reload", (long long)(us / 1000), p_last->kept, p_last->updated,
+             p_last->restarted, p_last->added, p_last->removed);
+}
+
 
 static void __tf_engine_task(void *p_arg)
 {
     tf_engine_t *p_engine = (tf_engine_t *)p_arg;
     tf_flow_data_t  flow;
     EventBits_t bits;
+    cJSON *p_root = NULL;
+    tf_module_item_t *p_head = NULL;
+    tf_info_t info;
+    tf_engine_reload_stats_t last;
+    int64_t start_us = 0;
 
     int ret =  0;
     ESP_LOGI(TAG, "tf engine task start");
@@ -404,6 +654,23 @@ static void __tf_engine_task(void *p_arg)
         if( xQueueReceive(p_engine->queue_handle, &flow, ( TickType_t ) 10 ) == pdPASS ) {
 
             ESP_LOGI(TAG, "RECV NEW TASK");
+            start_us = esp_timer_get_time();
+            memset(&info, 0, sizeof(info));
+            ret = tf_parse_json_with_length( flow.p_data, flow.len, &p_root, &p_head, &info);
+            tf_free(flow.p_data);
+
+            if( run_flag && ret > 0 ) {
+                ESP_LOGI(TAG, "RELOAD LAST TASK");
+                if( __reload(p_engine, p_root, p_head, ret, &info, &last) == ESP_OK ) {
+                    __reload_stats_update(p_engine, start_us, false, &last);
+                } else {
+                    __stop(p_engine);
+                    __clear(p_engine);
+                    run_flag = false;
+                }
+                continue;
+            }
+
             if(run_flag) {
                 ESP_LOGI(TAG, "STOP LAST TASK");
                 __stop(p_engine);
@@ -416,12 +683,12 @@ static void __tf_engine_task(void *p_arg)
             }
 
             __data_lock(p_engine);
-            ret = tf_parse_json_with_length( flow.p_data, flow.len, &p_engine->cur_flow_root, &p_engine->p_module_head, &p_engine->tf_info);
+            p_engine->cur_flow_root = p_root;
+            p_engine->p_module_head = p_head;
             p_engine->module_item_num = ret;
+            p_engine->tf_info = info;
             __data_unlock(p_engine);
 
-            tf_free(flow.p_data);
-
             __status_cb(p_engine, TF_STATUS_STARTING, NULL);
 
             if( ret  <= 0) {
@@ -432,6 +699,9 @@ static void __tf_engine_task(void *p_arg)
             ret = __run(p_engine);
             if(  ret == ESP_OK ) {
                 run_flag = true;
+                memset(&last, 0, sizeof(last));
+                last.added = p_engine->module_item_num;
+                __reload_stats_update(p_engine, start_us, true, &last);
             } else {
                 __stop(p_engine);
                 __clear(p_engine);
@@ -449,15 +719,8 @@ esp_err_t tf_engine_init(void)
     ESP_GOTO_ON_FALSE(gp_engine, ESP_ERR_NO_MEM, err, TAG, "no mem for tf engine");
     memset(gp_engine, 0, sizeof(tf_engine_t));
 
-    esp_event_loop_args_t event_task_args = {
-        .queue_size = 32,
-        .task_name = "tf_event_task",
-        .task_priority = 14,
-        .task_stack_size = 1024 * 3,
-        .task_core_id = 1
-    };
-    ret = esp_event_loop_create(&event_task_args, &gp_engine->event_handle);
-    ESP_GOTO_ON_ERROR(ret, err, TAG, "event_loop_create failed");
+    ret = tf_wires_init();
+    ESP_GOTO_ON_ERROR(ret, err, TAG, "wires init failed");
 
     SLIST_INIT(&(gp_engine->module_nodes));
 
@@ -675,6 +938,115 @@ esp_err_t tf_engine_status_get(int *p_status)
     return ESP_OK;
 }
 
+esp_err_t tf_engine_reload_stats_get(tf_engine_reload_stats_t *p_stats)
+{
+    assert(gp_engine);
+    __data_lock(gp_engine);
+    *p_stats = gp_engine->reload_stats;
+    __data_unlock(gp_engine);
+    return ESP_OK;
+}
+
+esp_err_t tf_engine_stats_get(tf_engine_stats_t *p_stats)
+{
+    assert(gp_engine);
+    ESP_RETURN_ON_FALSE(p_stats, ESP_ERR_INVALID_ARG, TAG, "invalid stats");
+
+    tf_wire_stats_t *p_wires = (tf_wire_stats_t *)tf_malloc(sizeof(tf_wire_stats_t) * TF_WIRE_MAX_NUM);
+    ESP_RETURN_ON_FALSE(p_wires, ESP_ERR_NO_MEM, TAG, "no mem for wire stats");
+    int wire_num = tf_wires_stats_get(p_wires, TF_WIRE_MAX_NUM);
+
+    memset(p_stats, 0, sizeof(tf_engine_stats_t));
+    tf_wire_unbound_stats_get(&p_stats->unbound);
+
+    __data_lock(gp_engine);
+    p_stats->reload = gp_engine->reload_stats;
+    for(int i = 0; i < gp_engine->module_item_num && i < TF_WIRE_MAX_NUM; i++) {
+        tf_module_item_t *p_item = &gp_engine->p_module_head[i];
+        tf_engine_module_stats_t *p_module = &p_stats->modules[p_stats->module_num++];
+
+        p_module->id = p_item->id;
+        strlcpy(p_module->name, p_item->p_name ? p_item->p_name : "", sizeof(p_module->name));
+        p_module->wire.event_id = -1;
+        for(int j = 0; j < wire_num; j++) {
+            if( p_wires[j].event_id == p_item->id ) {
+                p_module->wire = p_wires[j];
+                break;
+            }
+        }
+    }
+    __data_unlock(gp_engine);
+
+    tf_free(p_wires);
+    return ESP_OK;
+}
+
+cJSON *tf_engine_stats_json_create(void)
+{
+    cJSON *p_root = NULL;
+    cJSON *p_modules = NULL;
+    cJSON *p_obj = NULL;
+
+    tf_engine_stats_t *p_stats = (tf_engine_stats_t *)tf_malloc(sizeof(tf_engine_stats_t));
+    if( p_stats == NULL || tf_engine_stats_get(p_stats) != ESP_OK ) {
+        goto err;
+    }
+
+    p_root = cJSON_CreateObject();
+    if( p_root == NULL ) {
+        goto err;
+    }
+
+    p_obj = cJSON_AddObjectToObject(p_root, "reload");
+    if( p_obj ) {
+        cJSON_AddNumberToObject(p_obj, "num", p_stats->reload.num);
+        cJSON_AddNumberToObject(p_obj, "full", p_stats->reload.full_num);
+        cJSON_AddNumberToObject(p_obj, "last_ms", p_stats->reload.last_us / 1000);
+        cJSON_AddNumberToObject(p_obj, "max_ms", p_stats->reload.max_us / 1000);
+    }
+
+    p_modules = cJSON_AddArrayToObject(p_root, "modules");
+    for(int i = 0; p_modules && i < p_stats->module_num; i++) {
+        tf_engine_module_stats_t *p_module = &p_stats->modules[i];
+        tf_wire_stats_t *p_wire = &p_module->wire;
+
+        p_obj = cJSON_CreateObject();
+        if( p_obj == NULL ) {
+            break;
+        }
+        cJSON_AddItemToArray(p_modules, p_obj);
+        cJSON_AddNumberToObject(p_obj, "id", p_module->id);
+        cJSON_AddStringToObject(p_obj, "name", p_module->name);
+        if( p_wire->event_id < 0 ) {
+            continue;
+        }
+        cJSON_AddNumberToObject(p_obj, "in", p_wire->posted);
+        cJSON_AddNumberToObject(p_obj, "handled", p_wire->handled);
+        cJSON_AddNumberToObject(p_obj, "out", p_wire->out);
+        cJSON_AddNumberToObject(p_obj, "dropped", p_wire->dropped);
+        cJSON_AddNumberToObject(p_obj, "pending", p_wire->pending);
+        cJSON_AddNumberToObject(p_obj, "high_water", p_wire->high_water);
+        cJSON_AddNumberToObject(p_obj, "max_us", p_wire->handle_max_us);
+        cJSON *p_hist = cJSON_AddArrayToObject(p_obj, "hist");
+        for(int j = 0; p_hist && j < TF_WIRE_HIST_NUM; j++) {
+            cJSON_AddItemToArray(p_hist, cJSON_CreateNumber(p_wire->handle_hist[j]));
+        }
+        cJSON_AddNumberToObject(p_obj, "alloc", (double)p_wire->data_alloc_bytes);
+        cJSON_AddNumberToObject(p_obj, "copied", (double)p_wire->data_copy_bytes);
+    }
+
+    p_obj = cJSON_AddObjectToObject(p_root, "unbound");
+    if( p_obj ) {
+        cJSON_AddNumberToObject(p_obj, "out", p_stats->unbound.out);
+        cJSON_AddNumberToObject(p_obj, "alloc", (double)p_stats->unbound.data_alloc_bytes);
+        cJSON_AddNumberToObject(p_obj, "copied", (double)p_stats->unbound.data_copy_bytes);
+    }
+
+err:
+    tf_free(p_stats);
+    return p_root;
+}
+
 esp_err_t tf_engine_status_cb_register(tf_engine_status_cb_t engine_status_cb, void *p_arg)
 {
     assert(gp_engine);
@@ -760,7 +1132,45 @@ esp_err_t tf_module_register(const char *p_name,
 
 esp_err_t tf_modules_report(void)
 {
-    return ESP_OK;
+    static const char *policy_str[] = { "drop-newest", "drop-oldest", "coalesce" };
+    static const char *prio_str[] = { "low", "normal", "high" };
+    esp_err_t ret = ESP_OK;
+
+    tf_engine_stats_t *p_stats = (tf_engine_stats_t *)tf_malloc(sizeof(tf_engine_stats_t));
+    ESP_RETURN_ON_FALSE(p_stats, ESP_ERR_NO_MEM, TAG, "no mem for stats");
+    ESP_GOTO_ON_ERROR(tf_engine_stats_get(p_stats), err, TAG, "stats get failed");
+
+    ESP_LOGI(TAG, "modules: %d", p_stats->module_num);
+    for(int i = 0; i < p_stats->module_num; i++) {
+        tf_engine_module_stats_t *p_module = &p_stats->modules[i];
+        tf_wire_stats_t *p_wire = &p_module->wire;
+        if( p_wire->event_id < 0 ) {
+            ESP_LOGI(TAG, "    %d %s: no input", p_module->id, p_module->name);
+            continue;
+        }
+        ESP_LOGI(TAG, "    %d %s: %s %s depth %d, pending %lu, high water %lu, posted %lu, handled %lu, dropped %lu, out %lu",
+                 p_module->id, p_module->name, prio_str[p_wire->cfg.prio], policy_str[p_wire->cfg.policy], p_wire->cfg.depth,
+                 (unsigned long)p_wire->pending, (unsigned long)p_wire->high_water, (unsigned long)p_wire->posted,
+                 (unsigned long)p_wire->handled, (unsigned long)p_wire->dropped, (unsigned long)p_wire->out);
+        ESP_LOGI(TAG, "        handler <1ms %lu, <10ms %lu, <100ms %lu, <1s %lu, <10s %lu, longer %lu, max %lu us; data %llu B, %llu B copied",
+                 (unsigned long)p_wire->handle_hist[0], (unsigned long)p_wire->handle_hist[1], (unsigned long)p_wire->handle_hist[2],
+                 (unsigned long)p_wire->handle_hist[3], (unsigned long)p_wire->handle_hist[4], (unsigned long)p_wire->handle_hist[5],
+                 (unsigned long)p_wire->handle_max_us,
+                 (unsigned long long)p_wire->data_alloc_bytes, (unsigned long long)p_wire->data_copy_bytes);
+    }
+    ESP_LOGI(TAG, "    unbound: out %lu, data %llu B, %llu B copied", (unsigned long)p_stats->unbound.out,
+             (unsigned long long)p_stats->unbound.data_alloc_bytes, (unsigned long long)p_stats->unbound.data_copy_bytes);
+
+    tf_engine_reload_stats_t *p_reload = &p_stats->reload;
+    ESP_LOGI(TAG, "flows: %lu, %lu started from scratch, last %lld ms, max %lld ms",
+             (unsigned long)p_reload->num, (unsigned long)p_reload->full_num,
+             (long long)(p_reload->last_us / 1000), (long long)(p_reload->max_us / 1000));
+    ESP_LOGI(TAG, "    last: kept %d, updated %d, restarted %d, added %d, removed %d",
+             p_reload->kept, p_reload->updated, p_reload->restarted, p_reload->added, p_reload->removed);
+
+err:
+    tf_free(p_stats);
+    return ret;
 }
 
 esp_err_t tf_event_post(int32_t event_id,
@@ -769,7 +1179,7 @@ esp_err_t tf_event_post(int32_t event_id,
                         TickType_t ticks_to_wait)
 {
     assert(gp_engine);
-    return esp_event_post_to(gp_engine->event_handle, TF_EVENT_BASE, event_id, event_data, event_data_size, ticks_to_wait);
+    return tf_wire_post(event_id, event_data, event_data_size, ticks_to_wait);
 }
 
 esp_err_t tf_event_handler_register(int32_t event_id,
@@ -777,12 +1187,28 @@ esp_err_t tf_event_handler_register(int32_t event_id,
                                     void *event_handler_arg)
 {
     assert(gp_engine);
-    return esp_event_handler_register_with(gp_engine->event_handle, TF_EVENT_BASE, event_id, event_handler, event_handler_arg);
+    return tf_wire_register(event_id, event_handler, event_handler_arg, NULL);
+}
+
+esp_err_t tf_event_handler_register_with_cfg(int32_t event_id,
+                                             esp_event_handler_t event_handler,
+                                             void *event_handler_arg,
+                                             const tf_wire_cfg_t *p_cfg)
+{
+    assert(gp_engine);
+    return tf_wire_register(event_id, event_handler, event_handler_arg, p_cfg);
+}
+
+esp_err_t tf_event_free_cb_register(tf_event_free_cb_t free_cb)
+{
+    assert(gp_engine);
+    tf_wire_free_cb_set(free_cb);
+    return ESP_OK;
 }
 
 esp_err_t tf_event_handler_unregister(int32_t event_id,
                                       esp_event_handler_t event_handler)
 {
     assert(gp_engine);
-    return esp_event_handler_unregister_with(gp_engine->event_handle, TF_EVENT_BASE, event_id, event_handler);
+    return tf_wire_unregister(event_id, event_handler);
 }
\ No newline at end of file
@@ -0,0 +1,531 @@
+#include "tf_wire.h"
+#include <stdio.h>
+#include <string.h>
+#include "tf_util.h"
+#include "esp_log.h"
+#include "esp_check.h"
+#include "esp_timer.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+
+static const char *TAG = "tf.wire";
+
+// One queued event, seq tells producers and consumers whose turn the cell is
+struct tf_wire_cell
+{
+    uint32_t seq;
+    uint32_t size;
+    uint64_t data[TF_WIRE_ITEM_SIZE / sizeof(uint64_t)];
+};
+
+struct tf_wire
+{
+    int32_t event_id;
+    esp_event_handler_t handler;
+    void *p_handler_arg;
+    tf_wire_cfg_t cfg;
+    struct tf_wire_cell *p_cells;
+    uint32_t mask;
+    uint32_t enqueue_pos;
+    uint32_t dequeue_pos;
+    uint32_t active;        // registered, changed atomically
+    uint32_t posting;       // producers inside tf_wire_post
+    uint32_t busy;          // a worker runs the handler
+    uint32_t high_water;
+    uint32_t posted;
+    uint32_t handled;
+    uint32_t dropped;
+    uint32_t handle_max_us;
+    uint32_t handle_hist[TF_WIRE_HIST_NUM];
+    uint32_t out;
+    uint64_t data_alloc_bytes;
+    uint64_t data_copy_bytes;
+};
+
+struct tf_wire_worker
+{
+    SemaphoreHandle_t sem;          // given for every item it may run
+    enum tf_wire_prio min_prio;     // runs wires of this priority and above
+    int next;                       // where the next scan starts, keeps wires of one priority fair
+    TaskHandle_t task;
+    struct tf_wire *p_running;      // wire whose handler runs, only touched by the worker
+};
+
+struct tf_wire_bind
+{
+    TaskHandle_t task;
+    int32_t event_id;
+};
+
+struct tf_wires
+{
+    struct tf_wire wires[TF_WIRE_MAX_NUM];
+    struct tf_wire_worker workers[TF_WIRE_PRIO_NUM];
+    SemaphoreHandle_t lock;         // guards register, unregister and binds
+    tf_event_free_cb_t free_cb;
+    struct tf_wire_bind binds[TF_WIRE_TASK_BIND_MAX];
+    struct tf_wire unbound;         // counters of tasks working for no wire
+};
+
+static struct tf_wires *gp_wires = NULL;
+
+static const uint32_t g_hist_bounds_us[TF_WIRE_HIST_NUM - 1] = TF_WIRE_HIST_BOUNDS_US;
+
+static bool __cell_push(struct tf_wire *p_wire, const void *p_data, size_t size)
+{
+    uint32_t pos = __atomic_load_n(&p_wire->enqueue_pos, __ATOMIC_RELAXED);
+    struct tf_wire_cell *p_cell = NULL;
+
+    while (1) {
+        p_cell = &p_wire->p_cells[pos & p_wire->mask];
+        int32_t dif = (int32_t)(__atomic_load_n(&p_cell->seq, __ATOMIC_ACQUIRE) - pos);
+        if( dif == 0 ) {
+            if( __atomic_compare_exchange_n(&p_wire->enqueue_pos, &pos, pos + 1, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED) ) {
+                break;
+            }
+        } else if( dif < 0 ) {
+            return false; // full
+        } else {
+            pos = __atomic_load_n(&p_wire->enqueue_pos, __ATOMIC_RELAXED);
+        }
+    }
+    memcpy(p_cell->data, p_data, size);
+    p_cell->size = size;
+    __atomic_store_n(&p_cell->seq, pos + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+static bool __cell_pop(struct tf_wire *p_wire, void *p_data, size_t *p_size)
+{
+    uint32_t pos = __atomic_load_n(&p_wire->dequeue_pos, __ATOMIC_RELAXED);
+    struct tf_wire_cell *p_cell = NULL;
+
+    while (1) {
+        p_cell = &p_wire->p_cells[pos & p_wire->mask];
+        int32_t dif = (int32_t)(__atomic_load_n(&p_cell->seq, __ATOMIC_ACQUIRE) - (pos + 1));
+        if( dif == 0 ) {
+            if( __atomic_compare_exchange_n(&p_wire->dequeue_pos, &pos, pos + 1, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED) ) {
+                break;
+            }
+        } else if( dif < 0 ) {
+            return false; // empty
+        } else {
+            pos = __atomic_load_n(&p_wire->dequeue_pos, __ATOMIC_RELAXED);
+        }
+    }
+    *p_size = p_cell->size;
+    memcpy(p_data, p_cell->data, p_cell->size);
+    __atomic_store_n(&p_cell->seq, pos + p_wire->mask + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+static uint32_t __wire_pending(struct tf_wire *p_wire)
+{
+    uint32_t dequeue_pos = __atomic_load_n(&p_wire->dequeue_pos, __ATOMIC_RELAXED);
+    uint32_t enqueue_pos = __atomic_load_n(&p_wire->enqueue_pos, __ATOMIC_RELAXED);
+    uint32_t pending = enqueue_pos - dequeue_pos;
+    return pending > p_wire->mask + 1 ? 0 : pending;
+}
+
+static void __atomic_max(uint32_t *p_max, uint32_t value)
+{
+    uint32_t seen = __atomic_load_n(p_max, __ATOMIC_RELAXED);
+    while (value > seen && !__atomic_compare_exchange_n(p_max, &seen, value, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+}
+
+// Free an item the handler will never see
+static void __wire_drop(struct tf_wire *p_wire, void *p_data)
+{
+    tf_event_free_cb_t free_cb = gp_wires->free_cb;
+    __atomic_add_fetch(&p_wire->dropped, 1, __ATOMIC_RELAXED);
+    if( free_cb ) {
+        free_cb(p_data);
+    }
+}
+
+static struct tf_wire *__wire_find(int32_t event_id)
+{
+    for (int i = 0; i < TF_WIRE_MAX_NUM; i++) {
+        struct tf_wire *p_wire = &gp_wires->wires[i];
+        if( __atomic_load_n(&p_wire->active, __ATOMIC_ACQUIRE) && p_wire->event_id == event_id ) {
+            return p_wire;
+        }
+    }
+    return NULL;
+}
+
+// The worker the calling task is, NULL for other tasks
+static struct tf_wire_worker *__worker_current(void)
+{
+    TaskHandle_t task = xTaskGetCurrentTaskHandle();
+
+    for (int i = 0; i < TF_WIRE_PRIO_NUM; i++) {
+        if( gp_wires->workers[i].task == task ) {
+            return &gp_wires->workers[i];
+        }
+    }
+    return NULL;
+}
+
+// The wire the calling task works for, the unbound counters if none
+static struct tf_wire *__wire_current(void)
+{
+    TaskHandle_t task = xTaskGetCurrentTaskHandle();
+    struct tf_wire_worker *p_worker = __worker_current();
+    struct tf_wire *p_wire = p_worker ? p_worker->p_running : NULL;
+
+    for (int i = 0; p_wire == NULL && i < TF_WIRE_TASK_BIND_MAX; i++) {
+        if( gp_wires->binds[i].task == task ) {
+            p_wire = __wire_find(gp_wires->binds[i].event_id);
+        }
+    }
+    return p_wire ? p_wire : &gp_wires->unbound;
+}
+
+static void __wire_handled(struct tf_wire *p_wire, uint32_t us)
+{
+    int i = 0;
+    while (i < TF_WIRE_HIST_NUM - 1 && us >= g_hist_bounds_us[i]) {
+        i++;
+    }
+    __atomic_add_fetch(&p_wire->handle_hist[i], 1, __ATOMIC_RELAXED);
+    __atomic_max(&p_wire->handle_max_us, us);
+    __atomic_add_fetch(&p_wire->handled, 1, __ATOMIC_RELAXED);
+}
+
+// Take the highest priority wire with an item that no other worker is running
+static struct tf_wire *__wire_claim(struct tf_wire_worker *p_worker)
+{
+    struct tf_wire *p_best = NULL;
+
+    for (int n = 0; n < TF_WIRE_MAX_NUM; n++) {
+        int i = (p_worker->next + n) % TF_WIRE_MAX_NUM;
+        struct tf_wire *p_wire = &gp_wires->wires[i];
+        if( !__atomic_load_n(&p_wire->active, __ATOMIC_ACQUIRE) || p_wire->cfg.prio < p_worker->min_prio ) {
+            continue;
+        }
+        if( __atomic_load_n(&p_wire->busy, __ATOMIC_RELAXED) || __wire_pending(p_wire) == 0 ) {
+            continue;
+        }
+        if( p_best == NULL || p_wire->cfg.prio > p_best->cfg.prio ) {
+            p_best = p_wire;
+        }
+    }
+    if( p_best == NULL ) {
+        return NULL;
+    }
+
+    uint32_t idle = 0;
+    if( !__atomic_compare_exchange_n(&p_best->busy, &idle, 1, false, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED) ) {
+        return NULL;
+    }
+    // unregister clears active then waits for busy to drop
+    if( !__atomic_load_n(&p_best->active, __ATOMIC_SEQ_CST) ) {
+        __atomic_store_n(&p_best->busy, 0, __ATOMIC_RELEASE);
+        return NULL;
+    }
+    p_worker->next = (p_best - gp_wires->wires + 1) % TF_WIRE_MAX_NUM;
+    return p_best;
+}
+
+static void __worker_task(void *p_arg)
+{
+    struct tf_wire_worker *p_worker = (struct tf_wire_worker *)p_arg;
+    uint64_t data[TF_WIRE_ITEM_SIZE / sizeof(uint64_t)];
+    size_t size = 0;
+
+    while (1) {
+        xSemaphoreTake(p_worker->sem, portMAX_DELAY);
+
+        // a worker finishing an item looks again, so an item skipped while its wire was busy is not lost
+        struct tf_wire *p_wire = NULL;
+        while ((p_wire = __wire_claim(p_worker)) != NULL) {
+            if( __cell_pop(p_wire, data, &size) ) {
+                int64_t start = esp_timer_get_time();
+                p_worker->p_running = p_wire;
+                p_wire->handler(p_wire->p_handler_arg, TF_EVENT_BASE, p_wire->event_id, data);
+                p_worker->p_running = NULL;
+                __wire_handled(p_wire, (uint32_t)(esp_timer_get_time() - start));
+            }
+            __atomic_store_n(&p_wire->busy, 0, __ATOMIC_RELEASE);
+        }
+    }
+}
+
+esp_err_t tf_wires_init(void)
+{
+    esp_err_t ret = ESP_OK;
+    gp_wires = (struct tf_wires *)tf_malloc(sizeof(struct tf_wires));
+    ESP_GOTO_ON_FALSE(gp_wires, ESP_ERR_NO_MEM, err, TAG, "no mem for wires");
+    memset(gp_wires, 0, sizeof(struct tf_wires));
+
+    gp_wires->lock = xSemaphoreCreateMutex();
+    ESP_GOTO_ON_FALSE(gp_wires->lock, ESP_ERR_NO_MEM, err, TAG, "Failed to create semaphore");
+    gp_wires->unbound.event_id = -1;
+
+    for (int i = 0; i < TF_WIRE_PRIO_NUM; i++) {
+        struct tf_wire_worker *p_worker = &gp_wires->workers[i];
+        char name[16];
+
+        p_worker->min_prio = i;
+        p_worker->sem = xSemaphoreCreateCounting(TF_WIRE_MAX_NUM, 0);
+        ESP_GOTO_ON_FALSE(p_worker->sem, ESP_ERR_NO_MEM, err, TAG, "Failed to create semaphore");
+
+        snprintf(name, sizeof(name), "tf_wire_%d", i);
+        ESP_GOTO_ON_FALSE(xTaskCreatePinnedToCore(__worker_task, name, TF_WIRE_WORKER_STACK_SIZE, p_worker,
+                                                  TF_WIRE_WORKER_PRIO + i, &p_worker->task, TF_WIRE_WORKER_CORE) == pdPASS,
+                          ESP_ERR_NO_MEM, err, TAG, "create worker failed");
+    }
+    return ESP_OK;
+
+err:
+    return ret;
+}
+
+void tf_wire_free_cb_set(tf_event_free_cb_t free_cb)
+{
+    gp_wires->free_cb = free_cb;
+}
+
+esp_err_t tf_wire_register(int32_t event_id,
+                           esp_event_handler_t event_handler,
+                           void *event_handler_arg,
+                           const tf_wire_cfg_t *p_cfg)
+{
+    esp_err_t ret = ESP_OK;
+    struct tf_wire *p_wire = NULL;
+    tf_wire_cfg_t cfg = TF_WIRE_CFG_DEFAULT();
+    uint32_t depth = 2;
+
+    ESP_RETURN_ON_FALSE(event_handler, ESP_ERR_INVALID_ARG, TAG, "invalid handler");
+    if( p_cfg ) {
+        cfg = *p_cfg;
+    }
+    ESP_RETURN_ON_FALSE(cfg.prio >= TF_WIRE_PRIO_LOW && cfg.prio < TF_WIRE_PRIO_NUM, ESP_ERR_INVALID_ARG, TAG, "invalid prio");
+    // two cells at least, the lock-free ring cannot tell full from empty with one
+    while (depth < cfg.depth && depth < TF_WIRE_DEPTH_MAX) {
+        depth <<= 1;
+    }
+    cfg.depth = depth;
+
+    xSemaphoreTake(gp_wires->lock, portMAX_DELAY);
+    ESP_GOTO_ON_FALSE(__wire_find(event_id) == NULL, ESP_ERR_INVALID_STATE, err, TAG, "wire %ld already has a handler", (long)event_id);
+    for (int i = 0; i < TF_WIRE_MAX_NUM; i++) {
+        if( !__atomic_load_n(&gp_wires->wires[i].active, __ATOMIC_ACQUIRE) ) {
+            p_wire = &gp_wires->wires[i];
+            break;
+        }
+    }
+    ESP_GOTO_ON_FALSE(p_wire, ESP_ERR_NO_MEM, err, TAG, "no free wire");
+
+    p_wire->p_cells = (struct tf_wire_cell *)tf_malloc(sizeof(struct tf_wire_cell) * depth);
+    ESP_GOTO_ON_FALSE(p_wire->p_cells, ESP_ERR_NO_MEM, err, TAG, "no mem for wire cells");
+    for (uint32_t i = 0; i < depth; i++) {
+        p_wire->p_cells[i].seq = i;
+    }
+    p_wire->event_id = event_id;
+    p_wire->handler = event_handler;
+    p_wire->p_handler_arg = event_handler_arg;
+    p_wire->cfg = cfg;
+    p_wire->mask = depth - 1;
+    p_wire->enqueue_pos = 0;
+    p_wire->dequeue_pos = 0;
+    p_wire->high_water = 0;
+    p_wire->posted = 0;
+    p_wire->handled = 0;
+    p_wire->dropped = 0;
+    p_wire->handle_max_us = 0;
+    memset(p_wire->handle_hist, 0, sizeof(p_wire->handle_hist));
+    p_wire->out = 0;
+    p_wire->data_alloc_bytes = 0;
+    p_wire->data_copy_bytes = 0;
+    __atomic_store_n(&p_wire->active, 1, __ATOMIC_SEQ_CST);
+
+err:
+    xSemaphoreGive(gp_wires->lock);
+    return ret;
+}
+
+esp_err_t tf_wire_unregister(int32_t event_id, esp_event_handler_t event_handler)
+{
+    esp_err_t ret = ESP_OK;
+    uint64_t data[TF_WIRE_ITEM_SIZE / sizeof(uint64_t)];
+    size_t size = 0;
+
+    xSemaphoreTake(gp_wires->lock, portMAX_DELAY);
+    struct tf_wire *p_wire = __wire_find(event_id);
+    ESP_GOTO_ON_FALSE(p_wire && p_wire->handler == event_handler, ESP_ERR_NOT_FOUND, err, TAG, "wire %ld not found", (long)event_id);
+
+    __atomic_store_n(&p_wire->active, 0, __ATOMIC_SEQ_CST);
+    while (__atomic_load_n(&p_wire->posting, __ATOMIC_SEQ_CST) || __atomic_load_n(&p_wire->busy, __ATOMIC_SEQ_CST)) {
+        vTaskDelay(1);
+    }
+    while (__cell_pop(p_wire, data, &size)) {
+        __wire_drop(p_wire, data);
+    }
+    tf_free(p_wire->p_cells);
+    p_wire->p_cells = NULL;
+    p_wire->handler = NULL;
+
+err:
+    xSemaphoreGive(gp_wires->lock);
+    return ret;
+}
+
+esp_err_t tf_wire_post(int32_t event_id,
+                       const void *event_data,
+                       size_t event_data_size,
+                       TickType_t ticks_to_wait)
+{
+    esp_err_t ret = ESP_OK;
+    uint64_t data[TF_WIRE_ITEM_SIZE / sizeof(uint64_t)];
+    size_t size = 0;
+
+    ESP_RETURN_ON_FALSE(event_data_size <= TF_WIRE_ITEM_SIZE, ESP_ERR_INVALID_SIZE, TAG, "event data too large: %d", (int)event_data_size);
+
+    struct tf_wire *p_wire = __wire_find(event_id);
+    if( p_wire == NULL ) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    // unregister clears active then waits for posting to drop
+    __atomic_add_fetch(&p_wire->posting, 1, __ATOMIC_SEQ_CST);
+    if( !__atomic_load_n(&p_wire->active, __ATOMIC_SEQ_CST) || p_wire->event_id != event_id ) {
+        __atomic_sub_fetch(&p_wire->posting, 1, __ATOMIC_SEQ_CST);
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    if( p_wire->cfg.policy == TF_WIRE_POLICY_COALESCE_LATEST ) {
+        while (__cell_pop(p_wire, data, &size)) {
+            __wire_drop(p_wire, data);
+        }
+    }
+
+    // The worker of the wire's priority would wait for itself: it is the only one to run LOW
+    // wires, and the ones below it may be held by slow handlers. A full wire refuses it at once.
+    struct tf_wire_worker *p_worker = __worker_current();
+    if( p_worker != NULL && p_worker->min_prio == p_wire->cfg.prio ) {
+        ticks_to_wait = 0;
+    }
+
+    TickType_t start = xTaskGetTickCount();
+    while (!__cell_push(p_wire, event_data, event_data_size)) {
+        if( p_wire->cfg.policy != TF_WIRE_POLICY_DROP_NEWEST ) {
+            if( __cell_pop(p_wire, data, &size) ) {
+                __wire_drop(p_wire, data);
+            }
+            continue;
+        }
+        if( (xTaskGetTickCount() - start) >= ticks_to_wait ) {
+            __atomic_add_fetch(&p_wire->dropped, 1, __ATOMIC_RELAXED);
+            ret = ESP_ERR_TIMEOUT;
+            goto out;
+        }
+        vTaskDelay(1);
+    }
+    __atomic_add_fetch(&p_wire->posted, 1, __ATOMIC_RELAXED);
+    __atomic_max(&p_wire->high_water, __wire_pending(p_wire));
+    __atomic_add_fetch(&__wire_current()->out, 1, __ATOMIC_RELAXED);
+
+    for (int i = 0; i <= p_wire->cfg.prio; i++) {
+        xSemaphoreGive(gp_wires->workers[i].sem);
+    }
+out:
+    __atomic_sub_fetch(&p_wire->posting, 1, __ATOMIC_SEQ_CST);
+    return ret;
+}
+
+static void __wire_stats_get(struct tf_wire *p_wire, tf_wire_stats_t *p_stats)
+{
+    p_stats->event_id = p_wire->event_id;
+    p_stats->cfg = p_wire->cfg;
+    p_stats->pending = __wire_pending(p_wire);
+    p_stats->high_water = __atomic_load_n(&p_wire->high_water, __ATOMIC_RELAXED);
+    p_stats->posted = __atomic_load_n(&p_wire->posted, __ATOMIC_RELAXED);
+    p_stats->handled = __atomic_load_n(&p_wire->handled, __ATOMIC_RELAXED);
+    p_stats->dropped = __atomic_load_n(&p_wire->dropped, __ATOMIC_RELAXED);
+    p_stats->handle_max_us = __atomic_load_n(&p_wire->handle_max_us, __ATOMIC_RELAXED);
+    for (int i = 0; i < TF_WIRE_HIST_NUM; i++) {
+        p_stats->handle_hist[i] = __atomic_load_n(&p_wire->handle_hist[i], __ATOMIC_RELAXED);
+    }
+    p_stats->out = __atomic_load_n(&p_wire->out, __ATOMIC_RELAXED);
+    p_stats->data_alloc_bytes = __atomic_load_n(&p_wire->data_alloc_bytes, __ATOMIC_RELAXED);
+    p_stats->data_copy_bytes = __atomic_load_n(&p_wire->data_copy_bytes, __ATOMIC_RELAXED);
+}
+
+int tf_wires_stats_get(tf_wire_stats_t *p_stats, int max_num)
+{
+    int num = 0;
+    if( gp_wires == NULL ) {
+        return 0;
+    }
+    xSemaphoreTake(gp_wires->lock, portMAX_DELAY);
+    for (int i = 0; i < TF_WIRE_MAX_NUM && num < max_num; i++) {
+        struct tf_wire *p_wire = &gp_wires->wires[i];
+        if( !__atomic_load_n(&p_wire->active, __ATOMIC_ACQUIRE) ) {
+            continue;
+        }
+        __wire_stats_get(p_wire, &p_stats[num]);
+        num++;
+    }
+    xSemaphoreGive(gp_wires->lock);
+    return num;
+}
+
+void tf_wire_unbound_stats_get(tf_wire_stats_t *p_stats)
+{
+    memset(p_stats, 0, sizeof(tf_wire_stats_t));
+    p_stats->event_id = -1;
+    if( gp_wires != NULL ) {
+        __wire_stats_get(&gp_wires->unbound, p_stats);
+    }
+}
+
+esp_err_t tf_wire_task_bind(TaskHandle_t task, int32_t event_id)
+{
+    esp_err_t ret = ESP_OK;
+    struct tf_wire_bind *p_bind = NULL;
+
+    ESP_RETURN_ON_FALSE(task, ESP_ERR_INVALID_ARG, TAG, "invalid task");
+    // modules may bind on every event, most find it done
+    for (int i = 0; i < TF_WIRE_TASK_BIND_MAX && event_id >= 0; i++) {
+        if( gp_wires->binds[i].task == task && gp_wires->binds[i].event_id == event_id ) {
+            return ESP_OK;
+        }
+    }
+    xSemaphoreTake(gp_wires->lock, portMAX_DELAY);
+    for (int i = 0; i < TF_WIRE_TASK_BIND_MAX; i++) {
+        if( gp_wires->binds[i].task == task ) {
+            p_bind = &gp_wires->binds[i];
+            break;
+        }
+        if( p_bind == NULL && gp_wires->binds[i].task == NULL ) {
+            p_bind = &gp_wires->binds[i];
+        }
+    }
+    if( event_id < 0 ) {
+        if( p_bind && p_bind->task == task ) {
+            p_bind->task = NULL;
+        }
+        goto err;
+    }
+    ESP_GOTO_ON_FALSE(p_bind, ESP_ERR_NO_MEM, err, TAG, "no free task bind");
+    p_bind->event_id = event_id;
+    p_bind->task = task;
+
+err:
+    xSemaphoreGive(gp_wires->lock);
+    return ret;
+}
+
+void tf_wire_data_count(size_t alloc_bytes, size_t copy_bytes)
+{
+    if( gp_wires == NULL ) {
+        return;
+    }
+    struct tf_wire *p_wire = __wire_current();
+    __atomic_add_fetch(&p_wire->data_alloc_bytes, (uint64_t)alloc_bytes, __ATOMIC_RELAXED);
+    if( copy_bytes ) {
+        __atomic_add_fetch(&p_wire->data_copy_bytes, (uint64_t)copy_bytes, __ATOMIC_RELAXED);
+    }
+}
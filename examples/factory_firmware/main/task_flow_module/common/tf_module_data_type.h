@@ -34,7 +34,7 @@ struct tf_data_buf
 
 struct tf_data_image
 {
-    uint8_t *p_buf;  //base64 data
+    uint8_t *p_buf;  //JPEG data, base64 is only made where a protocol needs text
     uint32_t len;
     time_t   time;
 };
@@ -1,6 +1,49 @@
+#include <stdlib.h>
+#include <string.h>
+#include <mbedtls/base64.h>
 #include "tf_module_util.h"
 #include "tf_module_data_type.h"
 #include "tf_util.h"
+#include "tf_wire.h"
+
+/*
+ * Every buffer behind a tf_data struct is reference counted. A module that fans
+ * one frame out to several outputs shares it, each output event holds a
+ * reference and the last tf_data_*_free() gives the memory back.
+ */
+struct tf_data_ref
+{
+    uint32_t refs;
+    uint32_t reserved; // keeps the data 8 byte aligned
+};
+
+#define TF_DATA_REF(p) ((struct tf_data_ref *)((uint8_t *)(p) - sizeof(struct tf_data_ref)))
+
+void *tf_data_alloc(size_t len)
+{
+    struct tf_data_ref *p_ref = tf_malloc(sizeof(struct tf_data_ref) + len);
+    if( p_ref == NULL ) {
+        return NULL;
+    }
+    __atomic_store_n(&p_ref->refs, 1, __ATOMIC_RELAXED);
+    tf_wire_data_count(len, 0);
+    return p_ref + 1;
+}
+
+void *tf_data_retain(void *p_buf)
+{
+    if( p_buf != NULL ) {
+        __atomic_add_fetch(&TF_DATA_REF(p_buf)->refs, 1, __ATOMIC_RELAXED);
+    }
+    return p_buf;
+}
+
+void tf_data_release(void *p_buf)
+{
+    if( p_buf != NULL && __atomic_sub_fetch(&TF_DATA_REF(p_buf)->refs, 1, __ATOMIC_ACQ_REL) == 0 ) {
+        tf_free(TF_DATA_REF(p_buf));
+    }
+}
 
 const char * tf_data_type_to_str(uint32_t type)
 {
@@ -54,19 +97,29 @@ void tf_data_buf_copy(struct tf_data_buf *p_dst, struct tf_data_buf *p_src)
 {
     p_dst->len  = p_src->len;
     if( p_src->p_buf != NULL &&  p_src->len > 0) {
-        p_dst->p_buf = tf_malloc(p_src->len);
-        memcpy(p_dst->p_buf, p_src->p_buf, p_src->len);
+        p_dst->p_buf = tf_data_alloc(p_src->len);
+        if( p_dst->p_buf != NULL ) {
+            memcpy(p_dst->p_buf, p_src->p_buf, p_src->len);
+            tf_wire_data_count(0, p_src->len);
+        } else {
+            p_dst->len  = 0;
+        }
     } else {
         p_dst->p_buf = NULL;
         p_dst->len  = 0;
     }
 }
+
+void tf_data_buf_share(struct tf_data_buf *p_dst, struct tf_data_buf *p_src)
+{
+    p_dst->p_buf = tf_data_retain(p_src->p_buf);
+    p_dst->len   = p_dst->p_buf != NULL ? p_src->len : 0;
+}
+
 void tf_data_buf_free(struct tf_data_buf *p_data)
 {
     p_data->len  = 0;
-    if( p_data->p_buf != NULL) {
-        tf_free(p_data->p_buf);
-    }
+    tf_data_release(p_data->p_buf);
     p_data->p_buf = NULL;
 }
 
@@ -75,22 +128,31 @@ void tf_data_image_copy(struct tf_data_image *p_dst, struct tf_data_image *p_src
     p_dst->len  = p_src->len;
     p_dst->time = p_src->time;
     if( p_src->p_buf != NULL &&  p_src->len > 0) {
-        p_dst->p_buf = tf_malloc(p_src->len + 1);
-        memcpy(p_dst->p_buf, p_src->p_buf, p_src->len);
-        p_dst->p_buf[p_src->len] = 0; // image is base64 data, so add last char '\0'.
+        p_dst->p_buf = tf_data_alloc(p_src->len);
+        if( p_dst->p_buf != NULL ) {
+            memcpy(p_dst->p_buf, p_src->p_buf, p_src->len);
+            tf_wire_data_count(0, p_src->len);
+        } else {
+            p_dst->len  = 0;
+        }
     } else {
         p_dst->p_buf = NULL;
         p_dst->len  = 0;
     }
 }
 
+void tf_data_image_share(struct tf_data_image *p_dst, struct tf_data_image *p_src)
+{
+    p_dst->p_buf = tf_data_retain(p_src->p_buf);
+    p_dst->len   = p_dst->p_buf != NULL ? p_src->len : 0;
+    p_dst->time  = p_src->time;
+}
+
 void tf_data_image_free(struct tf_data_image *p_data)
 {
     p_data->len  = 0;
     p_data->time  = 0;
-    if( p_data->p_buf != NULL) {
-        tf_free(p_data->p_buf);
-    }
+    tf_data_release(p_data->p_buf);
     p_data->p_buf = NULL;
 }
 
@@ -117,8 +179,13 @@ void tf_data_inference_copy(struct tf_data_inference_info *p_dst, struct tf_data
         }
 
         if( size ) {
-            p_dst->p_data = tf_malloc( size * p_src->cnt);
-            memcpy(p_dst->p_data, p_src->p_data, size * p_src->cnt);
+            p_dst->p_data = tf_data_alloc( size * p_src->cnt);
+            if( p_dst->p_data != NULL ) {
+                memcpy(p_dst->p_data, p_src->p_data, size * p_src->cnt);
+                tf_wire_data_count(0, size * p_src->cnt);
+            } else {
+                p_dst->cnt = 0;
+            }
         } else {
             p_dst->p_data = NULL;
             p_dst->cnt    = 0; 
@@ -129,26 +196,31 @@ void tf_data_inference_copy(struct tf_data_inference_info *p_dst, struct tf_data
         p_dst->cnt    = 0;
     }
     
+    tf_data_classes_copy(p_dst->classes, p_src->classes);
+}
+
+void tf_data_inference_share(struct tf_data_inference_info *p_dst, struct tf_data_inference_info *p_src)
+{
+    p_dst->is_valid = p_src->is_valid;
+    p_dst->type     = p_src->type;
+    p_dst->p_data   = tf_data_retain(p_src->p_data);
+    p_dst->cnt      = p_dst->p_data != NULL ? p_src->cnt : 0;
+
     memset(p_dst->classes, 0, sizeof(char *) * CONFIG_MODEL_CLASSES_MAX_NUM);
-    for (int i = 0; p_src->classes[i] != NULL && i < CONFIG_MODEL_CLASSES_MAX_NUM; i++)
+    for (int i = 0; i < CONFIG_MODEL_CLASSES_MAX_NUM && p_src->classes[i] != NULL; i++)
     {
-        char *p_name = tf_malloc(strlen(p_src->classes[i]) + 1); //Using strup may cause internal memory fragmentation
-        memset(p_name, 0, strlen(p_src->classes[i]) + 1);
-        strcpy(p_name, p_src->classes[i]);
-        p_dst->classes[i] = p_name;
+        p_dst->classes[i] = tf_data_retain(p_src->classes[i]);
     }
 }
 
 void tf_data_inference_free(struct tf_data_inference_info *p_inference)
 {
-    if( p_inference->p_data != NULL) {
-        tf_free(p_inference->p_data);
-    }
+    tf_data_release(p_inference->p_data);
     p_inference->p_data   = NULL;
 
-    for (int i = 0; p_inference->classes[i] != NULL && i < CONFIG_MODEL_CLASSES_MAX_NUM; i++)
+    for (int i = 0; i < CONFIG_MODEL_CLASSES_MAX_NUM && p_inference->classes[i] != NULL; i++)
     {
-        tf_free(p_inference->classes[i]);
+        tf_data_release(p_inference->classes[i]);
         p_inference->classes[i] = NULL;
     }
     p_inference->cnt      = 0;
@@ -156,3 +228,160 @@ void tf_data_inference_free(struct tf_data_inference_info *p_inference)
     p_inference->type     = INFERENCE_TYPE_UNKNOWN;
 }
 
+void tf_data_classes_copy(char *classes_dst[], char *classes_src[])
+{
+    memset(classes_dst, 0, sizeof(char *) * CONFIG_MODEL_CLASSES_MAX_NUM);
+    for (int i = 0; i < CONFIG_MODEL_CLASSES_MAX_NUM && classes_src[i] != NULL; i++)
+    {
+        size_t len = strlen(classes_src[i]) + 1;
+        char *p_name = tf_data_alloc(len);
+        if( p_name == NULL ) {
+            break;
+        }
+        memcpy(p_name, classes_src[i], len);
+        tf_wire_data_count(0, len);
+        classes_dst[i] = p_name;
+    }
+}
+
+void tf_data_share(void *p_dst, void *p_src)
+{
+    uint32_t type = ((uint32_t *)p_src)[0];
+
+    switch (type)
+    {
+    case TF_DATA_TYPE_BUFFER:{
+        tf_data_buffer_t * p_s = (tf_data_buffer_t *)p_src;
+        tf_data_buffer_t * p_d = (tf_data_buffer_t *)p_dst;
+        p_d->type = type;
+        tf_data_buf_share(&p_d->data, &p_s->data);
+        break;
+    }
+    case TF_DATA_TYPE_DUALIMAGE_WITH_INFERENCE:{
+        tf_data_dualimage_with_inference_t * p_s = (tf_data_dualimage_with_inference_t *)p_src;
+        tf_data_dualimage_with_inference_t * p_d = (tf_data_dualimage_with_inference_t *)p_dst;
+        p_d->type = type;
+        tf_data_image_share(&p_d->img_small, &p_s->img_small);
+        tf_data_image_share(&p_d->img_large, &p_s->img_large);
+        tf_data_inference_share(&p_d->inference, &p_s->inference);
+        break;
+    }
+    case TF_DATA_TYPE_DUALIMAGE_WITH_INFERENCE_AUDIO_TEXT:{
+        tf_data_dualimage_with_audio_text_t * p_s = (tf_data_dualimage_with_audio_text_t *)p_src;
+        tf_data_dualimage_with_audio_text_t * p_d = (tf_data_dualimage_with_audio_text_t *)p_dst;
+        p_d->type = type;
+        tf_data_image_share(&p_d->img_small, &p_s->img_small);
+        tf_data_image_share(&p_d->img_large, &p_s->img_large);
+        tf_data_inference_share(&p_d->inference, &p_s->inference);
+        tf_data_buf_share(&p_d->audio, &p_s->audio);
+        tf_data_buf_share(&p_d->text, &p_s->text);
+        break;
+    }
+
+    default:
+        break;
+    }
+}
+
+// JPEG bytes encoded per chunk, a multiple of 3 so the chunks concatenate to one base64 text
+#define TF_DATA_BASE64_CHUNK    3072
+
+size_t tf_data_image_base64_len(const struct tf_data_image *p_img)
+{
+    if( p_img == NULL || p_img->p_buf == NULL ) {
+        return 0;
+    }
+    return (p_img->len + 2) / 3 * 4;
+}
+
+int tf_data_image_base64_encode(const struct tf_data_image *p_img, uint8_t *p_dst, size_t dst_len, size_t *p_olen)
+{
+    *p_olen = 0;
+    if( p_img == NULL || p_img->p_buf == NULL || p_img->len == 0 ) {
+        if( dst_len > 0 ) {
+            p_dst[0] = '\0';
+        }
+        return 0;
+    }
+    // dst_len counts the '\0' mbedtls appends
+    return mbedtls_base64_encode(p_dst, dst_len, p_olen, p_img->p_buf, p_img->len);
+}
+
+int tf_data_image_base64_write(const struct tf_data_image *p_img, tf_data_write_cb_t write_cb, void *p_ctx)
+{
+    int ret = 0;
+    size_t olen = 0;
+
+    if( p_img == NULL || p_img->p_buf == NULL || p_img->len == 0 ) {
+        return 0;
+    }
+    uint8_t *p_chunk = tf_malloc(TF_DATA_BASE64_CHUNK / 3 * 4 + 1);
+    if( p_chunk == NULL ) {
+        return -1;
+    }
+    for (size_t pos = 0; pos < p_img->len && ret == 0; pos += TF_DATA_BASE64_CHUNK) {
+        size_t len = p_img->len - pos < TF_DATA_BASE64_CHUNK ? p_img->len - pos : TF_DATA_BASE64_CHUNK;
+        ret = mbedtls_base64_encode(p_chunk, TF_DATA_BASE64_CHUNK / 3 * 4 + 1, &olen, p_img->p_buf + pos, len);
+        if( ret == 0 ) {
+            ret = write_cb(p_ctx, p_chunk, olen);
+        }
+    }
+    tf_free(p_chunk);
+    return ret;
+}
+
+// Next "$tf_image_<i>$" string value of p_json with i < num, NULL if there is none
+static const char *__json_image_mark_find(const char *p_json, int num, int *p_index, size_t *p_mark_len)
+{
+    static const char prefix[] = "\"$tf_image_";
+    const char *p = p_json;
+
+    while ((p = strstr(p, prefix)) != NULL) {
+        const char *p_num = p + sizeof(prefix) - 1;
+        char *p_end = NULL;
+        long index = strtol(p_num, &p_end, 10);
+        if( p_end != p_num && p_end[0] == '$' && p_end[1] == '"' && index >= 0 && index < num ) {
+            *p_index = index;
+            *p_mark_len = p_end + 2 - p;
+            return p;
+        }
+        p++;
+    }
+    return NULL;
+}
+
+size_t tf_data_image_json_len(const char *p_json, const struct tf_data_image *p_imgs[], int num)
+{
+    size_t len = strlen(p_json);
+    const char *p = p_json;
+    size_t mark_len = 0;
+    int index = 0;
+
+    while ((p = __json_image_mark_find(p, num, &index, &mark_len)) != NULL) {
+        len = len - mark_len + 2 + tf_data_image_base64_len(p_imgs[index]);
+        p += mark_len;
+    }
+    return len;
+}
+
+int tf_data_image_json_write(const char *p_json, const struct tf_data_image *p_imgs[], int num,
+                             tf_data_write_cb_t write_cb, void *p_ctx)
+{
+    int ret = 0;
+    const char *p = p_json;
+    const char *p_mark = NULL;
+    size_t mark_len = 0;
+    int index = 0;
+
+    while (ret == 0 && (p_mark = __json_image_mark_find(p, num, &index, &mark_len)) != NULL) {
+        ret = write_cb(p_ctx, p, p_mark - p + 1); // up to the opening quote
+        if( ret == 0 ) {
+            ret = tf_data_image_base64_write(p_imgs[index], write_cb, p_ctx);
+        }
+        p = p_mark + mark_len - 1; // from the closing quote
+    }
+    if( ret == 0 && *p != '\0' ) {
+        ret = write_cb(p_ctx, p, strlen(p));
+    }
+    return ret;
+}
@@ -10,18 +10,53 @@ extern "C" {
 
 const char * tf_data_type_to_str(uint32_t type);
 
-void tf_data_free(void *event_data);
+/*
+ * Buffers behind tf_data structs (p_buf, p_data and class names) are reference
+ * counted and must come from tf_data_alloc() or a *_copy(). *_share() hands out
+ * another reference to the same immutable data, *_free() drops one and the
+ * memory goes with the last. Fanning a frame out to N outputs costs one buffer.
+ */
+void *tf_data_alloc(size_t len);
+void *tf_data_retain(void *p_buf);
+void tf_data_release(void *p_buf);
 
+void tf_data_free(void *event_data);
+void tf_data_share(void *p_dst, void *p_src);
 
 void tf_data_buf_copy(struct tf_data_buf *p_dst, struct tf_data_buf *p_src);
+void tf_data_buf_share(struct tf_data_buf *p_dst, struct tf_data_buf *p_src);
 void tf_data_buf_free(struct tf_data_buf *p_data);
 
 void tf_data_image_copy(struct tf_data_image *p_dst, struct tf_data_image *p_src);
+void tf_data_image_share(struct tf_data_image *p_dst, struct tf_data_image *p_src);
 void tf_data_image_free(struct tf_data_image *p_data);
 
 void tf_data_inference_copy(struct tf_data_inference_info *p_dst, struct tf_data_inference_info *p_src);
+void tf_data_inference_share(struct tf_data_inference_info *p_dst, struct tf_data_inference_info *p_src);
 void tf_data_inference_free(struct tf_data_inference_info *p_inference);
 
+void tf_data_classes_copy(char *classes_dst[], char *classes_src[]);
+
+/*
+ * Images travel as JPEG bytes. Base64 is made at the network edge only: encoded
+ * into the caller's buffer, or streamed out in chunks through a write callback.
+ * In a JSON document a string value TF_DATA_IMAGE_JSON_MARK(i) stands for the
+ * base64 of image i, so a body can be built with cJSON and streamed without
+ * ever holding the encoded image.
+ */
+#define TF_DATA_IMAGE_JSON_MARK(i)  "$tf_image_" #i "$"
+
+// Returns 0 on success, anything else stops the write
+typedef int (*tf_data_write_cb_t)(void *p_ctx, const void *p_buf, size_t len);
+
+size_t tf_data_image_base64_len(const struct tf_data_image *p_img);
+int tf_data_image_base64_encode(const struct tf_data_image *p_img, uint8_t *p_dst, size_t dst_len, size_t *p_olen);
+int tf_data_image_base64_write(const struct tf_data_image *p_img, tf_data_write_cb_t write_cb, void *p_ctx);
+
+size_t tf_data_image_json_len(const char *p_json, const struct tf_data_image *p_imgs[], int num);
+int tf_data_image_json_write(const char *p_json, const struct tf_data_image *p_imgs[], int num,
+                             tf_data_write_cb_t write_cb, void *p_ctx);
+
 #ifdef __cplusplus
 }
 #endif
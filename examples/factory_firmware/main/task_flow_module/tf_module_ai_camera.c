@@ -84,15 +84,75 @@ static int __model_flag_clear(void)
     return __model_flag_set(&flag);
 }
 
-static void __classes_name_copy(char *classes_dst[], char *classes_src[])
+// JPEG of the reply image, straight into a tf_data buffer that the outputs share
+static int __image_fetch(const sscma_client_reply_t *reply, struct tf_data_image *p_img)
 {
-    memset(classes_dst, NULL, sizeof(char *) * CONFIG_MODEL_CLASSES_MAX_NUM);
-    for (int i = 0; classes_src[i] != NULL && i < CONFIG_MODEL_CLASSES_MAX_NUM; i++)
+    const uint8_t *jpeg = NULL;
+    const char *view = NULL;
+    size_t size = 0;
+    esp_err_t ret = ESP_OK;
+
+    p_img->p_buf = NULL;
+    p_img->len = 0;
+    p_img->time = 0;
+
+    if( sscma_utils_view_jpeg_from_reply(reply, &jpeg, &size) == ESP_OK ) {
+        p_img->p_buf = tf_data_alloc(size);
+        if( p_img->p_buf == NULL ) {
+            return ESP_ERR_NO_MEM;
+        }
+        memcpy(p_img->p_buf, jpeg, size);
+        p_img->len = size;
+    } else if( sscma_utils_view_image_from_reply(reply, &view, &size) == ESP_OK ) {
+        // base64 from a JSON reply, decoded once here rather than by every consumer
+        size_t cap = (size + 3) / 4 * 3;
+        p_img->p_buf = tf_data_alloc(cap);
+        if( p_img->p_buf == NULL ) {
+            return ESP_ERR_NO_MEM;
+        }
+        ret = sscma_utils_decode_image_into(reply, p_img->p_buf, cap, &size);
+        if( ret != ESP_OK ) {
+            tf_data_image_free(p_img);
+            return ret;
+        }
+        p_img->len = size;
+    } else {
+        return ESP_FAIL;
+    }
+    p_img->time = time(NULL);
+    return ESP_OK;
+}
+
+// Move a result array of sscma_utils_fetch_* into a tf_data buffer
+static void __inference_set(struct tf_data_inference_info *p_inference, enum tf_data_inference_type type, void *p_data, int cnt, size_t size)
+{
+    p_inference->type = type;
+    p_inference->p_data = NULL;
+    p_inference->cnt = 0;
+    if( p_data != NULL && cnt > 0 ) {
+        p_inference->p_data = tf_data_alloc(size * cnt);
+        if( p_inference->p_data != NULL ) {
+            memcpy(p_inference->p_data, p_data, size * cnt);
+            p_inference->cnt = cnt;
+        }
+    }
+    free(p_data);
+}
+
+// Post one reference of p_data to every output, the caller keeps its own
+static void __output_post(tf_module_ai_camera_t *p_module_ins, void *p_data)
+{
+    esp_err_t ret = ESP_OK;
+    for (int i = 0; i < p_module_ins->output_evt_num; i++)
     {
-        char *p_name = tf_malloc(strlen(classes_src[i]) + 1); //Using strup may cause internal memory fragmentation
-        memset(p_name, 0, strlen(classes_src[i]) + 1);
-        strcpy(p_name, classes_src[i]);
-        classes_dst[i] = p_name;
+        tf_data_share(&p_module_ins->output_data, p_data);
+        ret = tf_event_post(p_module_ins->p_output_evt_id[i], &p_module_ins->output_data, sizeof(p_module_ins->output_data), pdMS_TO_TICKS(1));
+        if( ret != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to post event %d", p_module_ins->p_output_evt_id[i]);
+            tf_data_free(&p_module_ins->output_data);
+        } else {
+            ESP_LOGI(TAG, "Output --> %d", p_module_ins->p_output_evt_id[i]);
+        }
     }
 }
 
@@ -432,15 +492,21 @@ static bool __output_check(tf_module_ai_camera_t *p_module_ins, struct tf_data_i
 }
 
 
-static int __get_camera_sensor_resolution(cJSON *payload)
+// inference is NULL when the reply could not be scanned and has to be read from the payload
+static int __get_camera_sensor_resolution(const sscma_client_inference_t *inference, cJSON *payload)
 {
     int width = 0, height = 0;
-    cJSON *data = cJSON_GetObjectItem(payload, "data");
-    if (data != NULL && cJSON_IsObject(data)) {
-        cJSON *resolution = cJSON_GetObjectItem(data, "resolution");
-        if (data != NULL && cJSON_IsArray(resolution) && cJSON_GetArraySize(resolution) == 2) {
-            width = cJSON_GetArrayItem(resolution, 0)->valueint;
-            height = cJSON_GetArrayItem(resolution, 1)->valueint;
+    if (inference != NULL) {
+        width = inference->width;
+        height = inference->height;
+    } else {
+        cJSON *data = cJSON_GetObjectItem(payload, "data");
+        if (data != NULL && cJSON_IsObject(data)) {
+            cJSON *resolution = cJSON_GetObjectItem(data, "resolution");
+            if (data != NULL && cJSON_IsArray(resolution) && cJSON_GetArraySize(resolution) == 2) {
+                width = cJSON_GetArrayItem(resolution, 0)->valueint;
+                height = cJSON_GetArrayItem(resolution, 1)->valueint;
+            }
         }
     }
     switch ((width+height)) {
@@ -458,15 +524,26 @@ static int __get_camera_sensor_resolution(cJSON *payload)
     }
 }
 
-static int __get_camera_mode_get(cJSON *payload)
+static int __get_camera_mode_get(const sscma_client_inference_t *inference, cJSON *payload)
 {
     int mode = 0;
-    cJSON * name = cJSON_GetObjectItem(payload, "name");
-    if( name != NULL  && name->valuestring != NULL ) {
+    const char *name = NULL;
+    size_t name_len = 0;
+    if (inference != NULL) {
+        name = inference->name;
+        name_len = inference->name_len;
+    } else {
+        cJSON *item = cJSON_GetObjectItem(payload, "name");
+        if (item != NULL && item->valuestring != NULL) {
+            name = item->valuestring;
+            name_len = strlen(item->valuestring);
+        }
+    }
+    if( name != NULL ) {
         // maybe have "xxx@SAMPLE, so use strnstr, not strcmp"
-        if(strnstr(name->valuestring, "SAMPLE", strlen(name->valuestring)) != NULL) {
+        if(strnstr(name, "SAMPLE", name_len) != NULL) {
             mode = TF_MODULE_AI_CAMERA_MODES_SAMPLE;  
-        } else if( strnstr(name->valuestring, "INVOKE", strlen(name->valuestring)) != NULL) {
+        } else if( strnstr(name, "INVOKE", name_len) != NULL) {
             mode = TF_MODULE_AI_CAMERA_MODES_INFERENCE;
         } else {
             mode = -1;
@@ -536,8 +613,14 @@ static void sscma_on_event(sscma_client_handle_t client, const sscma_client_repl
 {
     tf_module_ai_camera_t *p_module_ins = (tf_module_ai_camera_t *)user_ctx;
     esp_err_t ret = ESP_OK;
-    int resolution = __get_camera_sensor_resolution(reply->payload);
-    int mode = __get_camera_mode_get(reply->payload);
+    sscma_client_inference_t inference = { 0 };
+    bool scanned = sscma_utils_parse_inference_from_reply(reply, &inference) == ESP_OK;
+    int resolution = __get_camera_sensor_resolution(scanned ? &inference : NULL, reply->payload);
+    int mode = __get_camera_mode_get(scanned ? &inference : NULL, reply->payload);
+
+    // count the frames and their posts against the camera wire
+    p_module_ins->event_task = xTaskGetCurrentTaskHandle();
+    tf_wire_task_bind(p_module_ins->event_task, p_module_ins->input_evt_id);
 
     switch (resolution)
     {
@@ -551,8 +634,6 @@ static void sscma_on_event(sscma_client_handle_t client, const sscma_client_repl
             int box_count = 0;
             int point_count = 0;
 
-            char *img = NULL;
-            int img_size = 0;
             bool is_need_output = false;
 
             int algorithm_type = p_module_ins->params.algorithm.type;
@@ -566,16 +647,13 @@ static void sscma_on_event(sscma_client_handle_t client, const sscma_client_repl
             info.inference.p_data = NULL;
 
             __data_lock(p_module_ins);
-            __classes_name_copy(info.inference.classes, p_module_ins->classes);
+            tf_data_classes_copy(info.inference.classes, p_module_ins->classes);
             __data_unlock(p_module_ins);
 
             // printf("sscma:%s\r\n",reply->data);
 
-            if ( sscma_utils_fetch_image_from_reply(reply, &img, &img_size) == ESP_OK ) {
-                info.img.p_buf = (uint8_t *)img;
-                info.img.len = img_size;
-                info.img.time = time(NULL);
-                ESP_LOGD(TAG, "Small img:%.1fk (%d), time: %ld", (float)img_size/1024, img_size, (long)time(NULL));
+            if ( __image_fetch(reply, &info.img) == ESP_OK ) {
+                ESP_LOGD(TAG, "Small img:%.1fk (%d), time: %ld", (float)info.img.len/1024, (int)info.img.len, (long)info.img.time);
             }
 
             if( mode == TF_MODULE_AI_CAMERA_MODES_INFERENCE ) {
@@ -583,9 +661,9 @@ static void sscma_on_event(sscma_client_handle_t client, const sscma_client_repl
 
                 if (algorithm_category == TF_MODULE_AI_CAMERA_ALGORITHM_CAT_DET) {  // all boxes come from category 1
                     if (sscma_utils_fetch_boxes_from_reply(reply, &boxes, &box_count) == ESP_OK) {
-                        info.inference.type = INFERENCE_TYPE_BOX;
-                        info.inference.p_data = (void *)boxes;
-                        info.inference.cnt = box_count;
+                        __inference_set(&info.inference, INFERENCE_TYPE_BOX, boxes, box_count, sizeof(*boxes));
+                        boxes = info.inference.p_data;
+                        box_count = info.inference.cnt;
                         if (box_count > 0) {
                             for (int i = 0; i < box_count; i++) {
                                 ESP_LOGD(TAG, "[box %d]: x=%d, y=%d, w=%d, h=%d, score=%d, target=%d", i,  \
@@ -595,9 +673,9 @@ static void sscma_on_event(sscma_client_handle_t client, const sscma_client_repl
                     }
                 } else if (algorithm_type == TF_MODULE_AI_CAMERA_ALGORITHM_TYPE_IMCLS) {  // only image classification outputs classes
                     if (sscma_utils_fetch_classes_from_reply(reply, &classes, &class_count) == ESP_OK) {
-                        info.inference.type = INFERENCE_TYPE_CLASS;
-                        info.inference.p_data = (void *)classes;
-                        info.inference.cnt = class_count;
+                        __inference_set(&info.inference, INFERENCE_TYPE_CLASS, classes, class_count, sizeof(*classes));
+                        classes = info.inference.p_data;
+                        class_count = info.inference.cnt;
                         if (class_count > 0) {
                             for (int i = 0; i < class_count; i++) {
                                 ESP_LOGD(TAG, "[class %d]: target=%d, score=%d", i, \
@@ -607,9 +685,9 @@ static void sscma_on_event(sscma_client_handle_t client, const sscma_client_repl
                     }
                 } else if (algorithm_type == TF_MODULE_AI_CAMERA_ALGORITHM_TYPE_PFLD) {  // only pfld outputs points
                     if (sscma_utils_fetch_points_from_reply(reply, &points, &point_count) == ESP_OK ) {
-                        info.inference.type = INFERENCE_TYPE_POINT;
-                        info.inference.p_data = (void *)points;
-                        info.inference.cnt = point_count;
+                        __inference_set(&info.inference, INFERENCE_TYPE_POINT, points, point_count, sizeof(*points));
+                        points = info.inference.p_data;
+                        point_count = info.inference.cnt;
                         if (point_count > 0) {
                             for (int i = 0; i < point_count; i++) {
                                 ESP_LOGD(TAG, "[point %d]: x=%d, y=%d, z=%d, score=%d, target=%d", i, \
@@ -648,35 +726,25 @@ static void sscma_on_event(sscma_client_handle_t client, const sscma_client_repl
                     tf_data_image_free(&p_module_ins->preview_info_cache.img);
                     tf_data_inference_free(&p_module_ins->preview_info_cache.inference);
 
-                    tf_data_image_copy(&p_module_ins->preview_info_cache.img, &info.img);
-                    tf_data_inference_copy(&p_module_ins->preview_info_cache.inference, &info.inference);
+                    tf_data_image_share(&p_module_ins->preview_info_cache.img, &info.img);
+                    tf_data_inference_share(&p_module_ins->preview_info_cache.inference, &info.inference);
 
                 } else {
+                    tf_data_dualimage_with_inference_t frame;
                     p_module_ins->last_output_time = time(NULL);
-                    p_module_ins->output_data.type = TF_DATA_TYPE_DUALIMAGE_WITH_INFERENCE;
-                    p_module_ins->output_data.img_large.p_buf = NULL;
-                    p_module_ins->output_data.img_large.len = 0;
-                    p_module_ins->output_data.img_large.time = 0;
-                    for (int i = 0; i < p_module_ins->output_evt_num; i++)
-                    {
-                        tf_data_image_copy(&p_module_ins->output_data.img_small, &info.img);
-                        tf_data_inference_copy(&p_module_ins->output_data.inference, &info.inference);
-
-                        ret = tf_event_post(p_module_ins->p_output_evt_id[i], &p_module_ins->output_data, sizeof(p_module_ins->output_data), pdMS_TO_TICKS(1));
-                        if( ret != ESP_OK) {
-                            ESP_LOGE(TAG, "Failed to post event %d", p_module_ins->p_output_evt_id[i]);
-                            tf_data_free(&p_module_ins->output_data);
-                        } else {
-                            ESP_LOGI(TAG, "Output --> %d", p_module_ins->p_output_evt_id[i]);
-                        }
-                    }
-
+                    frame.type = TF_DATA_TYPE_DUALIMAGE_WITH_INFERENCE;
+                    frame.img_small = info.img;
+                    frame.img_large.p_buf = NULL;
+                    frame.img_large.len = 0;
+                    frame.img_large.time = 0;
+                    frame.inference = info.inference;
+                    __output_post(p_module_ins, &frame);
                 }
             }
             __data_unlock(p_module_ins);
 
             // Upload image
-            app_sensecraft_mqtt_preview_upload_with_reduce_freq((char *)info.img.p_buf, info.img.len);
+            app_sensecraft_mqtt_preview_upload_with_reduce_freq(info.img.p_buf, info.img.len);
 
             tf_data_image_free(&info.img);
             tf_data_inference_free(&info.inference);
@@ -684,8 +752,6 @@ static void sscma_on_event(sscma_client_handle_t client, const sscma_client_repl
             break;
         }
         case TF_MODULE_AI_CAMERA_SENSOR_RESOLUTION_640_480:{
-            char *img = NULL;
-            int img_size = 0;
             struct tf_data_image img_large;
             // printf("sscma:%s\r\n",reply->data);
 
@@ -695,19 +761,12 @@ static void sscma_on_event(sscma_client_handle_t client, const sscma_client_repl
                 esp_timer_stop(p_module_ins->timer_handle);
             }
 
-            if ( sscma_utils_fetch_image_from_reply(reply, &img, &img_size) == ESP_OK ) {
-                img_large.p_buf = (uint8_t *)img;
-                img_large.len = img_size;
-                img_large.time = time(NULL);
-                ESP_LOGI(TAG, "Large img:%.1fk(%d), time: %ld", (float)img_size/1024, img_size, (long)time(NULL));
-            } else {
-                img_large.p_buf = NULL;
-                img_large.len = 0;
-                img_large.time = 0;
+            if ( __image_fetch(reply, &img_large) == ESP_OK ) {
+                ESP_LOGI(TAG, "Large img:%.1fk(%d), time: %ld", (float)img_large.len/1024, (int)img_large.len, (long)img_large.time);
             }
 
             //check image
-            ret = view_image_check((uint8_t *)img, img_size, 640*480*2);
+            ret = view_image_check(img_large.p_buf, img_large.len, 640*480*2);
             if( ret != 0) {
                 p_module_ins->large_image_check_fail_cnt++;
                 ESP_LOGE(TAG, "Failed to check large image, ret = %d", ret);
@@ -729,21 +788,13 @@ static void sscma_on_event(sscma_client_handle_t client, const sscma_client_repl
             }
 
             __data_lock(p_module_ins);
+            tf_data_dualimage_with_inference_t frame;
             p_module_ins->last_output_time = time(NULL);
-            p_module_ins->output_data.type = TF_DATA_TYPE_DUALIMAGE_WITH_INFERENCE;
-            for (int i = 0; i < p_module_ins->output_evt_num; i++)
-            {
-                tf_data_image_copy(&p_module_ins->output_data.img_large, &img_large);
-                tf_data_image_copy(&p_module_ins->output_data.img_small, &p_module_ins->preview_info_cache.img);
-                tf_data_inference_copy(&p_module_ins->output_data.inference, &p_module_ins->preview_info_cache.inference);
-                ret = tf_event_post(p_module_ins->p_output_evt_id[i], &p_module_ins->output_data, sizeof(p_module_ins->output_data), pdMS_TO_TICKS(1));
-                if( ret != ESP_OK) {
-                    ESP_LOGE(TAG, "Failed to post event %d", p_module_ins->p_output_evt_id[i]);
-                    tf_data_free(&p_module_ins->output_data);
-                } else {
-                    ESP_LOGI(TAG, "Output --> %d", p_module_ins->p_output_evt_id[i]);
-                }
-            }
+            frame.type = TF_DATA_TYPE_DUALIMAGE_WITH_INFERENCE;
+            frame.img_small = p_module_ins->preview_info_cache.img;
+            frame.img_large = img_large;
+            frame.inference = p_module_ins->preview_info_cache.inference;
+            __output_post(p_module_ins, &frame);
             __data_unlock(p_module_ins);
 
             tf_data_image_free(&img_large);
@@ -1065,6 +1116,82 @@ static bool __himax_keepalive_check(tf_module_ai_camera_t *p_module_ins)
     return false;
 }
 
+/*
+ * Commands sent back to back without waiting for each reply, the device still runs them in
+ * order. Every request that was sent gets exactly one callback, with its reply or on timeout.
+ */
+#define AI_CAMERA_BATCH_MAX 4
+
+struct ai_camera_batch;
+
+struct ai_camera_batch_req {
+    struct ai_camera_batch *p_batch;
+    const char *p_name;
+    esp_err_t err;
+};
+
+struct ai_camera_batch {
+    SemaphoreHandle_t done;
+    StaticSemaphore_t done_buffer;
+    int num;
+    struct ai_camera_batch_req req[AI_CAMERA_BATCH_MAX];
+};
+
+static void __batch_request_cb(sscma_client_handle_t client, esp_err_t err, const sscma_client_reply_t *reply, void *user_ctx)
+{
+    struct ai_camera_batch_req *p_req = (struct ai_camera_batch_req *)user_ctx;
+    p_req->err = err;
+    xSemaphoreGive(p_req->p_batch->done);
+}
+
+static void __batch_init(struct ai_camera_batch *p_batch)
+{
+    p_batch->done = xSemaphoreCreateCountingStatic(AI_CAMERA_BATCH_MAX, 0, &p_batch->done_buffer);
+    p_batch->num = 0;
+}
+
+static void __batch_send(struct ai_camera_batch *p_batch, sscma_client_handle_t client, const char *p_name, const char *p_cmd)
+{
+    struct ai_camera_batch_req *p_req = NULL;
+    if (p_batch->num >= AI_CAMERA_BATCH_MAX) {
+        ESP_LOGE(TAG, "batch is full: %s", p_name);
+        return;
+    }
+    p_req = &p_batch->req[p_batch->num++];
+    p_req->p_batch = p_batch;
+    p_req->p_name = p_name;
+    p_req->err = sscma_client_request_async(client, p_cmd, __batch_request_cb, p_req, CMD_WAIT_DELAY);
+    if (p_req->err != ESP_OK) {
+        xSemaphoreGive(p_batch->done); // no callback will come
+    }
+}
+
+static int __batch_wait(struct ai_camera_batch *p_batch)
+{
+    int failed = 0;
+    // the client times out every request, so the callbacks never outlive the batch
+    for (int i = 0; i < p_batch->num; i++) {
+        xSemaphoreTake(p_batch->done, portMAX_DELAY);
+    }
+    for (int i = 0; i < p_batch->num; i++) {
+        if (p_batch->req[i].err != ESP_OK) {
+            ESP_LOGE(TAG, "%s failed: %d", p_batch->req[i].p_name, p_batch->req[i].err);
+            failed++;
+        }
+    }
+    vSemaphoreDelete(p_batch->done);
+    p_batch->num = 0;
+    return failed;
+}
+
+static void __batch_send_break_and_sensor(struct ai_camera_batch *p_batch, sscma_client_handle_t client, int opt_id)
+{
+    char cmd[64] = { 0 };
+    __batch_send(p_batch, client, "break", CMD_PREFIX CMD_AT_BREAK CMD_SUFFIX);
+    snprintf(cmd, sizeof(cmd), CMD_PREFIX CMD_AT_SENSOR CMD_SET "%d,%d,%d" CMD_SUFFIX, 1, 1, opt_id);
+    __batch_send(p_batch, client, "set sensor", cmd);
+}
+
 static void ai_camera_task(void *p_arg)
 {
     esp_err_t ret = ESP_OK;
@@ -1073,6 +1200,8 @@ static void ai_camera_task(void *p_arg)
     struct tf_module_ai_camera_params *p_params = &p_module_ins->params;
     sscma_client_model_t *model_info;
     EventBits_t bits;
+    struct ai_camera_batch batch;
+    char cmd[64] = { 0 };
     bool run_flag = false;
     uint32_t check_cnt = 0;
     ESP_LOGI(TAG, "Task start");
@@ -1085,9 +1214,9 @@ static void ai_camera_task(void *p_arg)
 
         if( ( bits & EVENT_SIMPLE_640_480 ) != 0  && run_flag ) {
             ESP_LOGI(TAG, "EVENT_SIMPLE_640_480");
-            sscma_client_break(p_module_ins->sscma_client_handle);
-            sscma_client_set_sensor(p_module_ins->sscma_client_handle, 1,  \
-                                    TF_MODULE_AI_CAMERA_SENSOR_RESOLUTION_640_480, true);
+            __batch_init(&batch);
+            __batch_send_break_and_sensor(&batch, p_module_ins->sscma_client_handle,
+                                          TF_MODULE_AI_CAMERA_SENSOR_RESOLUTION_640_480);
 
             esp_timer_start_once(p_module_ins->timer_handle, 5 * 1000000); // 5s
 
@@ -1096,12 +1225,14 @@ static void ai_camera_task(void *p_arg)
                 ESP_LOGE(TAG, "Sample %d failed\n", TF_MODULE_AI_CAMERA_SENSOR_RESOLUTION_640_480);
                 xEventGroupSetBits(p_module_ins->event_group, EVENT_PRVIEW_416_416);
             }
+            __batch_wait(&batch);
         }
         if( ( bits & EVENT_PRVIEW_416_416 ) != 0 && run_flag ) {
             ESP_LOGI(TAG, "EVENT_PRVIEW_416_416");
-            sscma_client_break(p_module_ins->sscma_client_handle);
-            sscma_client_set_sensor(p_module_ins->sscma_client_handle, 1,  \
-                                    TF_MODULE_AI_CAMERA_SENSOR_RESOLUTION_416_416, true);
+            // break and sensor are only waited for after invoke, which needs its own reply
+            __batch_init(&batch);
+            __batch_send_break_and_sensor(&batch, p_module_ins->sscma_client_handle,
+                                          TF_MODULE_AI_CAMERA_SENSOR_RESOLUTION_416_416);
 
             esp_event_post_to(app_event_loop_handle, VIEW_EVENT_BASE,  \
                                 VIEW_EVENT_AI_CAMERA_READY, NULL, 0, portMAX_DELAY);
@@ -1121,18 +1252,14 @@ static void ai_camera_task(void *p_arg)
                     p_params->algorithm.type == TF_MODULE_AI_CAMERA_ALGORITHM_TYPE_YOLO ||
                     p_params->algorithm.type == TF_MODULE_AI_CAMERA_ALGORITHM_TYPE_YOLO_V8)
                 {
-                    if (sscma_client_set_iou_threshold(p_module_ins->sscma_client_handle, p_params->model.iou) != ESP_OK) {
-                        ESP_LOGE(TAG, "Failed to set iou threshold: %d\n", p_params->model.iou);
-                    } else {
-                        ESP_LOGI(TAG, "Set iou threshold: %d", p_params->model.iou);
-                    }
+                    snprintf(cmd, sizeof(cmd), CMD_PREFIX CMD_AT_TIOU CMD_SET "%d" CMD_SUFFIX, p_params->model.iou);
+                    __batch_send(&batch, p_module_ins->sscma_client_handle, "set iou threshold", cmd);
+                    ESP_LOGI(TAG, "Set iou threshold: %d", p_params->model.iou);
                 }
                 if (p_params->algorithm.type != TF_MODULE_AI_CAMERA_ALGORITHM_TYPE_PFLD) {
-                    if (sscma_client_set_confidence_threshold(p_module_ins->sscma_client_handle, p_params->model.confidence)) {
-                        ESP_LOGE(TAG, "Failed to set confidence threshold: %d\n", p_params->model.confidence);
-                    } else {
-                        ESP_LOGI(TAG, "Set confidence threshold: %d", p_params->model.confidence);
-                    }
+                    snprintf(cmd, sizeof(cmd), CMD_PREFIX CMD_AT_TSCORE CMD_SET "%d" CMD_SUFFIX, p_params->model.confidence);
+                    __batch_send(&batch, p_module_ins->sscma_client_handle, "set confidence threshold", cmd);
+                    ESP_LOGI(TAG, "Set confidence threshold: %d", p_params->model.confidence);
                 }
             } else {
                 if (sscma_client_sample(p_module_ins->sscma_client_handle, -1) != ESP_OK) {
@@ -1140,6 +1267,7 @@ static void ai_camera_task(void *p_arg)
                     err_flag |= TF_MODULE_AI_CAMERA_CODE_ERR_SSCMA_SIMPLE; 
                 }
             }
+            __batch_wait(&batch);
         }
 
         if( ( bits & EVENT_START ) != 0 ) {
@@ -1435,6 +1563,10 @@ static int __stop(void *p_module)
     xEventGroupSetBits(p_module_ins->event_group, EVENT_STOP);
     xEventGroupWaitBits(p_module_ins->event_group, EVENT_STOP_DONE, 1, 1, pdMS_TO_TICKS(60000));
 
+    if( p_module_ins->event_task ) {
+        tf_wire_task_bind(p_module_ins->event_task, -1);
+        p_module_ins->event_task = NULL;
+    }
     p_module_ins->start_flag = false;
     p_module_ins->need_abort_ai_model_download = false;
 
@@ -1483,15 +1615,21 @@ static int __msgs_pub_set(void *p_module, int output_index, int *p_evt_id, int n
 {
     tf_module_ai_camera_t *p_module_ins = (tf_module_ai_camera_t *)p_module;
     __data_lock(p_module_ins);
-    if (output_index == 0 && num > 0)
+    if (output_index == 0)
     {
-        p_module_ins->p_output_evt_id = (int *)tf_malloc(sizeof(int) * num);
+        // also rewires a running module, the outputs are only read under the lock
+        if( p_module_ins->p_output_evt_id ) {
+            tf_free(p_module_ins->p_output_evt_id);
+        }
+        p_module_ins->p_output_evt_id = num > 0 ? (int *)tf_malloc(sizeof(int) * num) : NULL;
         if (p_module_ins->p_output_evt_id )
         {
             memcpy(p_module_ins->p_output_evt_id, p_evt_id, sizeof(int) * num);
             p_module_ins->output_evt_num = num;
         } else {
-            ESP_LOGE(TAG, "Failed to malloc p_output_evt_id");
+            if( num > 0 ) {
+                ESP_LOGE(TAG, "Failed to malloc p_output_evt_id");
+            }
             p_module_ins->output_evt_num = 0;
         }
     }
@@ -1531,7 +1669,8 @@ const static struct tf_module_ops __g_module_ops = {
     .stop = __stop,
     .cfg = __cfg,
     .msgs_sub_set = __msgs_sub_set,
-    .msgs_pub_set = __msgs_pub_set
+    .msgs_pub_set = __msgs_pub_set,
+    .msgs_pub_update = __msgs_pub_set,
 };
 
 const static struct tf_module_mgmt __g_module_mgmt = {  
@@ -185,6 +185,7 @@ typedef struct tf_module_ai_camera
     SemaphoreHandle_t sem_handle; 
     EventGroupHandle_t event_group;
     TaskHandle_t task_handle;
+    TaskHandle_t event_task;    // sscma client task the frames are posted from
     esp_timer_handle_t timer_handle;
     StaticTask_t *p_task_buf;
     StackType_t *p_task_stack_buf;
@@ -33,7 +33,7 @@ static int __params_parse(struct tf_module_alarm_trigger_params *p_params, cJSON
         int decode_ret = mbedtls_base64_decode(NULL, 0, &output_len, \
                             (uint8_t *)json_audio->valuestring, strlen(json_audio->valuestring));
         if( decode_ret != MBEDTLS_ERR_BASE64_INVALID_CHARACTER  && output_len > 0 ) {
-            uint8_t *p_audio = (uint8_t *)tf_malloc( output_len);
+            uint8_t *p_audio = (uint8_t *)tf_data_alloc( output_len);
             if( p_audio != NULL ) {
                 decode_ret = mbedtls_base64_decode(p_audio, output_len, &output_len, \
                     (uint8_t *)json_audio->valuestring, strlen(json_audio->valuestring));
@@ -41,7 +41,7 @@ static int __params_parse(struct tf_module_alarm_trigger_params *p_params, cJSON
                     p_params->audio.p_buf = p_audio;
                     p_params->audio.len   = output_len;
                 } else {
-                    tf_free(p_audio);
+                    tf_data_release(p_audio);
                     ESP_LOGE(TAG, "base64 decode failed");
                 }
             }
@@ -52,7 +52,7 @@ static int __params_parse(struct tf_module_alarm_trigger_params *p_params, cJSON
 
     cJSON *json_text = cJSON_GetObjectItem(p_json, "text");
     if (json_text != NULL  && cJSON_IsString(json_text)) {
-        p_params->text.p_buf = (uint8_t *)tf_malloc(strlen(json_text->valuestring) + 1);
+        p_params->text.p_buf = (uint8_t *)tf_data_alloc(strlen(json_text->valuestring) + 1);
         if( p_params->text.p_buf ) {
             memcpy(p_params->text.p_buf, json_text->valuestring, strlen(json_text->valuestring));
             p_params->text.len = strlen(json_text->valuestring) + 1;
@@ -81,12 +81,12 @@ static void __event_handler(void *handler_args, esp_event_base_t base, int32_t i
     output_data.type = TF_DATA_TYPE_DUALIMAGE_WITH_INFERENCE_AUDIO_TEXT;
     __data_lock(p_module_ins);
     for (int i = 0; i < p_module_ins->output_evt_num; i++) {
-        tf_data_image_copy(&output_data.img_small, &p_data->img_small);
-        tf_data_image_copy(&output_data.img_large, &p_data->img_large);
-        tf_data_inference_copy(&output_data.inference, &p_data->inference);
-        tf_data_buf_copy(&output_data.audio, &p_params->audio);
-        tf_data_buf_copy(&output_data.text, &p_params->text);
-        ret = tf_event_post(p_module_ins->p_output_evt_id[i], &output_data, sizeof(output_data), pdMS_TO_TICKS(100));
+        tf_data_image_share(&output_data.img_small, &p_data->img_small);
+        tf_data_image_share(&output_data.img_large, &p_data->img_large);
+        tf_data_inference_share(&output_data.inference, &p_data->inference);
+        tf_data_buf_share(&output_data.audio, &p_params->audio);
+        tf_data_buf_share(&output_data.text, &p_params->text);
+        ret = tf_event_post(p_module_ins->p_output_evt_id[i], &output_data, sizeof(output_data), 0);
         if( ret != ESP_OK) {
             ESP_LOGE(TAG, "Failed to post event %d", p_module_ins->p_output_evt_id[i]);
             tf_data_free(&output_data);
@@ -132,12 +132,26 @@ static int __cfg(void *p_module, cJSON *p_json)
     __data_unlock(p_module_ins);
     return 0;
 }
+static int __cfg_update(void *p_module, cJSON *p_json)
+{
+    tf_module_alarm_trigger_t *p_module_ins = (tf_module_alarm_trigger_t *)p_module;
+    __data_lock(p_module_ins);
+    // alarms already posted hold their own reference to the old audio and text
+    tf_data_buf_free(&p_module_ins->params.audio);
+    tf_data_buf_free(&p_module_ins->params.text);
+    __parmas_default(&p_module_ins->params);
+    __params_parse(&p_module_ins->params, p_json);
+    __data_unlock(p_module_ins);
+    return 0;
+}
 static int __msgs_sub_set(void *p_module, int evt_id)
 {
     tf_module_alarm_trigger_t *p_module_ins = (tf_module_alarm_trigger_t *)p_module;
     esp_err_t ret;
     p_module_ins->input_evt_id = evt_id;
-    ret = tf_event_handler_register(evt_id, __event_handler, p_module_ins);
+    // only the latest frame is worth checking, and it feeds the local alarm
+    tf_wire_cfg_t cfg = { .depth = 2, .policy = TF_WIRE_POLICY_COALESCE_LATEST, .prio = TF_WIRE_PRIO_HIGH };
+    ret = tf_event_handler_register_with_cfg(evt_id, __event_handler, p_module_ins, &cfg);
     return ret;
 }
 
@@ -145,15 +159,21 @@ static int __msgs_pub_set(void *p_module, int output_index, int *p_evt_id, int n
 {
     tf_module_alarm_trigger_t *p_module_ins = (tf_module_alarm_trigger_t *)p_module;
     __data_lock(p_module_ins);
-    if (output_index == 0 && num > 0)
+    if (output_index == 0)
     {
-        p_module_ins->p_output_evt_id = (int *)tf_malloc(sizeof(int) * num);
+        // also rewires a running module, the outputs are only read under the lock
+        if( p_module_ins->p_output_evt_id ) {
+            tf_free(p_module_ins->p_output_evt_id);
+        }
+        p_module_ins->p_output_evt_id = num > 0 ? (int *)tf_malloc(sizeof(int) * num) : NULL;
         if (p_module_ins->p_output_evt_id )
         {
             memcpy(p_module_ins->p_output_evt_id, p_evt_id, sizeof(int) * num);
             p_module_ins->output_evt_num = num;
         } else {
-            ESP_LOGE(TAG, "Failed to malloc p_output_evt_id");
+            if( num > 0 ) {
+                ESP_LOGE(TAG, "Failed to malloc p_output_evt_id");
+            }
             p_module_ins->output_evt_num = 0;
         }
     }
@@ -193,7 +213,9 @@ const static struct tf_module_ops  __g_module_ops = {
     .stop = __stop,
     .cfg = __cfg,
     .msgs_sub_set = __msgs_sub_set,
-    .msgs_pub_set = __msgs_pub_set
+    .msgs_pub_set = __msgs_pub_set,
+    .cfg_update = __cfg_update,
+    .msgs_pub_update = __msgs_pub_set,
 };
 
 const static struct tf_module_mgmt __g_module_mgmt = {
@@ -75,7 +75,7 @@ static int __params_parse(struct tf_module_http_alarm_params *p_params, cJSON *p
 
     cJSON *json_text = cJSON_GetObjectItem(p_json, "text");
     if (json_text != NULL  && cJSON_IsString(json_text)) {
-        p_params->text.p_buf = (uint8_t *)tf_malloc(strlen(json_text->valuestring) + 1);
+        p_params->text.p_buf = (uint8_t *)tf_data_alloc(strlen(json_text->valuestring) + 1);
         if( p_params->text.p_buf ) {
             memcpy(p_params->text.p_buf, json_text->valuestring, strlen(json_text->valuestring));
             p_params->text.len = strlen(json_text->valuestring) + 1;
@@ -86,15 +86,24 @@ static int __params_parse(struct tf_module_http_alarm_params *p_params, cJSON *p
     return 0;
 }
 
+static int __http_write(void *p_ctx, const void *p_buf, size_t len)
+{
+    esp_http_client_handle_t client = (esp_http_client_handle_t)p_ctx;
+    return esp_http_client_write(client, (const char *)p_buf, len) == (int)len ? 0 : -1;
+}
+
+// The body is p_json with the images marked in it streamed as base64
 static char *__request( const char *url,
                         esp_http_client_method_t method, 
                         const char *token, 
                         const char *content_type,
                         const char *head, 
-                        uint8_t *data, size_t len)
+                        const char *p_json,
+                        const struct tf_data_image *p_imgs[], int img_num)
 {
     esp_err_t  ret = ESP_OK;
     char *result = NULL;
+    size_t len = tf_data_image_json_len(p_json, p_imgs, img_num);
 
     esp_http_client_config_t config = {
         .url = url,
@@ -125,8 +134,8 @@ static char *__request( const char *url,
 
     if (len > 0)
     {
-        int wlen = esp_http_client_write(client, (const char *)data, len);
-        ESP_GOTO_ON_FALSE(wlen >= 0, ESP_FAIL, err, TAG, "Failed to write client!");
+        ret = tf_data_image_json_write(p_json, p_imgs, img_num, __http_write, client);
+        ESP_GOTO_ON_FALSE(ret == 0, ESP_FAIL, err, TAG, "Failed to write client!");
     }
 
     int content_length = esp_http_client_fetch_headers(client);
@@ -202,11 +211,7 @@ static int __http_report_warn_event(tf_module_http_alarm_t *p_module_ins,
     }
 
     if (p_params->image_en) {
-        p_str = "";
-        if (p_data->img_small.p_buf != NULL) {
-            p_str = (char *)p_data->img_small.p_buf;
-        }
-        cJSON_AddItemToObject(events, "img", cJSON_CreateString(p_str));
+        cJSON_AddItemToObject(events, "img", cJSON_CreateString(TF_DATA_IMAGE_JSON_MARK(0)));
     }
 
     cJSON *data = NULL;
@@ -316,12 +321,13 @@ static int __http_report_warn_event(tf_module_http_alarm_t *p_module_ins,
 
     ESP_LOGI(TAG, "Post %s", p_module_ins->url);
 
+    const struct tf_data_image *p_imgs[] = { &p_data->img_small };
     p_resp = __request(p_module_ins->url, 
                     HTTP_METHOD_POST, 
                     p_module_ins->token,
                     "application/json",
                     p_module_ins->head, 
-                    (uint8_t *)json_str, strlen(json_str));
+                    json_str, p_imgs, 1);
     free(json_str);
 
     if (p_resp == NULL) {
@@ -540,7 +546,9 @@ static int __msgs_sub_set(void *p_module, int evt_id)
     tf_module_http_alarm_t *p_module_ins = (tf_module_http_alarm_t *)p_module;
     esp_err_t ret;
     p_module_ins->input_evt_id = evt_id;
-    ret = tf_event_handler_register(evt_id, __event_handler, p_module_ins);
+    // the HTTP post takes seconds, refuse alarms rather than hold up the others
+    tf_wire_cfg_t cfg = { .depth = 2, .policy = TF_WIRE_POLICY_DROP_NEWEST, .prio = TF_WIRE_PRIO_LOW };
+    ret = tf_event_handler_register_with_cfg(evt_id, __event_handler, p_module_ins, &cfg);
     return ret;
 }
 
@@ -167,16 +167,25 @@ char * __token_gen(void)
     return token;
 }
 
+static int __http_write(void *p_ctx, const void *p_buf, size_t len)
+{
+    esp_http_client_handle_t client = (esp_http_client_handle_t)p_ctx;
+    return esp_http_client_write(client, (const char *)p_buf, len) == (int)len ? 0 : -1;
+}
+
+// The body is p_json with the images marked in it streamed as base64
 static char *__request( const char *url,
                         esp_http_client_method_t method, 
                         const char *token, 
                         const char *content_type,
                         const char *head, 
-                        uint8_t *data, size_t len,
+                        const char *p_json,
+                        const struct tf_data_image *p_imgs[], int img_num,
                         int timeout_ms )
 {
     esp_err_t  ret = ESP_OK;
     char *result = NULL;
+    size_t len = tf_data_image_json_len(p_json, p_imgs, img_num);
 
     esp_http_client_config_t config = {
         .url = url,
@@ -203,8 +212,8 @@ static char *__request( const char *url,
 
     if (len > 0)
     {
-        int wlen = esp_http_client_write(client, (const char *)data, len);
-        ESP_GOTO_ON_FALSE(wlen >= 0, ESP_FAIL, err, TAG, "Failed to write client!");
+        ret = tf_data_image_json_write(p_json, p_imgs, img_num, __http_write, client);
+        ESP_GOTO_ON_FALSE(ret == 0, ESP_FAIL, err, TAG, "Failed to write client!");
     }
 
     int content_length = esp_http_client_fetch_headers(client);
@@ -249,11 +258,7 @@ static int __https_upload_image(tf_module_img_analyzer_t             *p_module_i
 
     json = cJSON_CreateObject();
 
-    p_str = "";
-    if(p_data->img_large.p_buf != NULL) {
-        p_str = (char *)p_data->img_large.p_buf;
-    }
-    cJSON_AddItemToObject(json, "img", cJSON_CreateString(p_str));
+    cJSON_AddItemToObject(json, "img", cJSON_CreateString(TF_DATA_IMAGE_JSON_MARK(0)));
 
     __data_lock(p_module_ins);
     p_str = "";
@@ -276,12 +281,13 @@ static int __https_upload_image(tf_module_img_analyzer_t             *p_module_i
 
     ESP_LOGI(TAG, "Post %s", p_module_ins->url); 
 
+    const struct tf_data_image *p_imgs[] = { &p_data->img_large };
     p_resp = __request(p_module_ins->url, 
                        HTTP_METHOD_POST, 
                        p_module_ins->token,
                        "application/json",
                        p_module_ins->head, 
-                       (uint8_t *)json_str, strlen(json_str),
+                       json_str, p_imgs, 1,
                        p_module_ins->timeout_ms);
     free(json_str);
 
@@ -329,7 +335,7 @@ static int __https_upload_image(tf_module_img_analyzer_t             *p_module_i
                 int decode_ret = mbedtls_base64_decode(NULL, 0, &output_len, \
                                     (uint8_t *)json_audio->valuestring, strlen(json_audio->valuestring));
                 if( decode_ret != MBEDTLS_ERR_BASE64_INVALID_CHARACTER  && output_len > 0 ) {
-                    uint8_t *p_audio = (uint8_t *)tf_malloc( output_len);
+                    uint8_t *p_audio = (uint8_t *)tf_data_alloc( output_len);
                     if( p_audio != NULL ) {
                         decode_ret = mbedtls_base64_decode(p_audio, output_len, &output_len, \
                             (uint8_t *)json_audio->valuestring, strlen(json_audio->valuestring));
@@ -338,7 +344,7 @@ static int __https_upload_image(tf_module_img_analyzer_t             *p_module_i
                             p_result->audio.len   = output_len;
                             ESP_LOGI(TAG, "audio:%d", output_len);
                         } else {
-                            tf_free(p_audio);
+                            tf_data_release(p_audio);
                             ESP_LOGE(TAG, "base64 decode failed");
                         }
                     }
@@ -350,14 +356,22 @@ static int __https_upload_image(tf_module_img_analyzer_t             *p_module_i
             p_result->img.p_buf = NULL;
             p_result->img.len   = 0;
             cJSON *json_img = cJSON_GetObjectItem(json_data, "img");
-            if ( json_img != NULL && cJSON_IsString(json_img)) {
-                uint8_t *p_img = (uint8_t *)tf_malloc( strlen(json_img->valuestring) );
+            if ( json_img != NULL && cJSON_IsString(json_img) && strlen(json_img->valuestring) > 0 ) {
+                // the cloud sends base64, frames carry JPEG
+                size_t b64_len = strlen(json_img->valuestring);
+                size_t img_len = 0;
+                uint8_t *p_img = (uint8_t *)tf_data_alloc( (b64_len + 3) / 4 * 3 );
                 if( p_img ) {
-                    memcpy(p_img, json_img->valuestring, strlen(json_img->valuestring));
-                    p_result->img.p_buf = p_img;
-                    p_result->img.len   = strlen(json_img->valuestring);
-                    p_result->img.time  = p_data->img_large.time;
-                    ESP_LOGI(TAG, "img:%d", p_result->img.len);
+                    if( mbedtls_base64_decode(p_img, (b64_len + 3) / 4 * 3, &img_len, \
+                                              (uint8_t *)json_img->valuestring, b64_len) == 0 ) {
+                        p_result->img.p_buf = p_img;
+                        p_result->img.len   = img_len;
+                        p_result->img.time  = p_data->img_large.time;
+                        ESP_LOGI(TAG, "img:%d", p_result->img.len);
+                    } else {
+                        ESP_LOGE(TAG, "img base64 decode failed");
+                        tf_data_release(p_img);
+                    }
                 }
             }
             ret = 0; //success
@@ -415,20 +429,22 @@ static void img_analyzer_task(void *p_arg)
                 if( result.type == TF_MODULE_IMG_ANALYZER_TYPE_RECOGNIZE || result.status == 1) {
                     output_data.type = TF_DATA_TYPE_DUALIMAGE_WITH_INFERENCE_AUDIO_TEXT;
                     struct tf_data_buf   text;
-                    text.p_buf = (uint8_t *)p_params->p_audio_txt;
-                    text.len = strlen(p_params->p_audio_txt) + 1; // add \0
+                    struct tf_data_buf   audio_txt;
+                    audio_txt.p_buf = (uint8_t *)p_params->p_audio_txt;
+                    audio_txt.len = strlen(p_params->p_audio_txt) + 1; // add \0
+                    tf_data_buf_copy(&text, &audio_txt);
 
                     __data_lock(p_module_ins); 
                     for (int i = 0; i < p_module_ins->output_evt_num; i++) {
                         if( result.img.p_buf) {
-                            tf_data_image_copy(&output_data.img_small, &result.img); //use cloud image
+                            tf_data_image_share(&output_data.img_small, &result.img); //use cloud image
                         } else {
-                            tf_data_image_copy(&output_data.img_small, &data.img_small);
+                            tf_data_image_share(&output_data.img_small, &data.img_small);
                         }
-                        tf_data_image_copy(&output_data.img_large, &data.img_large);
-                        tf_data_inference_copy(&output_data.inference, &data.inference);
-                        tf_data_buf_copy(&output_data.audio, &result.audio);
-                        tf_data_buf_copy(&output_data.text, &text);
+                        tf_data_image_share(&output_data.img_large, &data.img_large);
+                        tf_data_inference_share(&output_data.inference, &data.inference);
+                        tf_data_buf_share(&output_data.audio, &result.audio);
+                        tf_data_buf_share(&output_data.text, &text);
                         ret = tf_event_post(p_module_ins->p_output_evt_id[i], &output_data, sizeof(output_data), pdMS_TO_TICKS(10000));
                         if( ret != ESP_OK) {
                             ESP_LOGE(TAG, "Failed to post event %d", p_module_ins->p_output_evt_id[i]);
@@ -438,6 +454,7 @@ static void img_analyzer_task(void *p_arg)
                         }
                     }
                     __data_unlock(p_module_ins);
+                    tf_data_buf_free(&text);
                 }
                 
                 tf_data_image_free(&result.img);
@@ -576,7 +593,9 @@ static int __msgs_sub_set(void *p_module, int evt_id)
     tf_module_img_analyzer_t *p_module_ins = (tf_module_img_analyzer_t *)p_module;
     esp_err_t ret;
     p_module_ins->input_evt_id = evt_id;
-    ret = tf_event_handler_register(evt_id, __event_handler, p_module_ins);
+    // the cloud request takes seconds, refuse frames rather than hold up the others
+    tf_wire_cfg_t cfg = { .depth = 2, .policy = TF_WIRE_POLICY_DROP_NEWEST, .prio = TF_WIRE_PRIO_LOW };
+    ret = tf_event_handler_register_with_cfg(evt_id, __event_handler, p_module_ins, &cfg);
     return ret;
 }
 
@@ -584,15 +603,21 @@ static int __msgs_pub_set(void *p_module, int output_index, int *p_evt_id, int n
 {
     tf_module_img_analyzer_t *p_module_ins = (tf_module_img_analyzer_t *)p_module;
     __data_lock(p_module_ins);
-    if (output_index == 0 && num > 0)
+    if (output_index == 0)
     {
-        p_module_ins->p_output_evt_id = (int *)tf_malloc(sizeof(int) * num);
+        // also rewires a running module, the outputs are only read under the lock
+        if( p_module_ins->p_output_evt_id ) {
+            tf_free(p_module_ins->p_output_evt_id);
+        }
+        p_module_ins->p_output_evt_id = num > 0 ? (int *)tf_malloc(sizeof(int) * num) : NULL;
         if (p_module_ins->p_output_evt_id )
         {
             memcpy(p_module_ins->p_output_evt_id, p_evt_id, sizeof(int) * num);
             p_module_ins->output_evt_num = num;
         } else {
-            ESP_LOGE(TAG, "Failed to malloc p_output_evt_id");
+            if( num > 0 ) {
+                ESP_LOGE(TAG, "Failed to malloc p_output_evt_id");
+            }
             p_module_ins->output_evt_num = 0;
         }
     }
@@ -628,7 +653,8 @@ const static struct tf_module_ops  __g_module_ops = {
     .stop = __stop,
     .cfg = __cfg,
     .msgs_sub_set = __msgs_sub_set,
-    .msgs_pub_set = __msgs_pub_set
+    .msgs_pub_set = __msgs_pub_set,
+    .msgs_pub_update = __msgs_pub_set,
 };
 
 const static struct tf_module_mgmt __g_module_mgmt = {
@@ -162,7 +162,7 @@ static void __event_handler(void *handler_args, esp_event_base_t base, int32_t i
         if( app_audio_player_status_get() == AUDIO_PLAYER_STATUS_IDLE ) {
             if( p_data->audio.p_buf != NULL && p_data->audio.len > 0 ) {
                 ESP_LOGI(TAG,"play audio buf");
-                ret = app_audio_player_mem(p_data->audio.p_buf, p_data->audio.len, true);
+                ret = app_audio_player_mem_with_free(p_data->audio.p_buf, p_data->audio.len, tf_data_release);
                 if( ret == ESP_OK) {
                     audio_used = true;
                 }
@@ -229,7 +229,9 @@ static int __msgs_sub_set(void *p_module, int evt_id)
     tf_module_local_alarm_t *p_module_ins = (tf_module_local_alarm_t *)p_module;
     esp_err_t ret;
     p_module_ins->input_evt_id = evt_id;
-    ret = tf_event_handler_register(evt_id, __event_handler, p_module_ins);
+    // an alarm that could not sound yet is stale once a newer one arrives
+    tf_wire_cfg_t cfg = { .depth = 2, .policy = TF_WIRE_POLICY_DROP_OLDEST, .prio = TF_WIRE_PRIO_HIGH };
+    ret = tf_event_handler_register_with_cfg(evt_id, __event_handler, p_module_ins, &cfg);
     return ret;
 }
 
@@ -268,7 +270,8 @@ const static struct tf_module_ops  __g_module_ops = {
     .stop = __stop,
     .cfg = __cfg,
     .msgs_sub_set = __msgs_sub_set,
-    .msgs_pub_set = __msgs_pub_set
+    .msgs_pub_set = __msgs_pub_set,
+    .cfg_update = __cfg,    // plain values, nothing to free
 };
 
 const static struct tf_module_mgmt __g_module_mgmt = {
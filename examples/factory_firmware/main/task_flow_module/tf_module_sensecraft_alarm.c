@@ -30,7 +30,7 @@ static int __params_parse(struct tf_module_sensecraft_alarm_params *p_params, cJ
     }
     cJSON *json_text = cJSON_GetObjectItem(p_json, "text");
     if (json_text != NULL  && cJSON_IsString(json_text)) {
-        p_params->text.p_buf = (uint8_t *)tf_malloc(strlen(json_text->valuestring) + 1);
+        p_params->text.p_buf = (uint8_t *)tf_data_alloc(strlen(json_text->valuestring) + 1);
         if( p_params->text.p_buf ) {
             memcpy(p_params->text.p_buf, json_text->valuestring, strlen(json_text->valuestring));
             p_params->text.len = strlen(json_text->valuestring) + 1;
@@ -85,7 +85,7 @@ static void __event_handler(void *handler_args, esp_event_base_t base, int32_t i
 
         ret = app_sensecraft_mqtt_report_warn_event(tf_info.tid, 
                                               tf_info.p_tf_name,
-                                              (char *)p_data->img_small.p_buf, p_data->img_small.len,
+                                              p_data->img_small.p_buf, p_data->img_small.len,
                                               (char *)p_text_buf, text_len);
         __data_unlock(p_module_ins);
 
@@ -124,12 +124,24 @@ static int __cfg(void *p_module, cJSON *p_json)
     __data_unlock(p_module_ins);
     return 0;
 }
+static int __cfg_update(void *p_module, cJSON *p_json)
+{
+    tf_module_sensecraft_alarm_t *p_module_ins = (tf_module_sensecraft_alarm_t *)p_module;
+    __data_lock(p_module_ins);
+    tf_data_buf_free(&p_module_ins->params.text);
+    __parmas_default(&p_module_ins->params);
+    __params_parse(&p_module_ins->params, p_json);
+    __data_unlock(p_module_ins);
+    return 0;
+}
 static int __msgs_sub_set(void *p_module, int evt_id)
 {
     tf_module_sensecraft_alarm_t *p_module_ins = (tf_module_sensecraft_alarm_t *)p_module;
     esp_err_t ret;
     p_module_ins->input_evt_id = evt_id;
-    ret = tf_event_handler_register(evt_id, __event_handler, p_module_ins);
+    // the upload takes seconds, refuse alarms rather than hold up the others
+    tf_wire_cfg_t cfg = { .depth = 2, .policy = TF_WIRE_POLICY_DROP_NEWEST, .prio = TF_WIRE_PRIO_LOW };
+    ret = tf_event_handler_register_with_cfg(evt_id, __event_handler, p_module_ins, &cfg);
     return ret;
 }
 
@@ -170,7 +182,8 @@ const static struct tf_module_ops  __g_module_ops = {
     .stop = __stop,
     .cfg = __cfg,
     .msgs_sub_set = __msgs_sub_set,
-    .msgs_pub_set = __msgs_pub_set
+    .msgs_pub_set = __msgs_pub_set,
+    .cfg_update = __cfg_update,
 };
 
 const static struct tf_module_mgmt __g_module_mgmt = {
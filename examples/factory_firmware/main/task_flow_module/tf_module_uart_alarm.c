@@ -20,6 +20,23 @@ static const char *TAG = "tfm.uart_alarm";
 static volatile atomic_int g_ins_cnt = ATOMIC_VAR_INIT(0);
 
 
+static int __uart_write(void *p_ctx, const void *p_buf, size_t len)
+{
+    return uart_write_bytes(UART_NUM_2, p_buf, len) == (int)len ? 0 : -1;
+}
+
+// Append the length and base64 of an image to a binary packet, the protocol carries base64 text
+static uint8_t *__binary_image_append(uint8_t *buffer, uint32_t *p_total_len, const struct tf_data_image *p_img)
+{
+    uint32_t image_len = tf_data_image_base64_len(p_img);
+    size_t olen = 0;
+    buffer = psram_realloc(buffer, *p_total_len + image_len + 4 + 1); // mbedtls appends '\0'
+    memcpy(buffer + *p_total_len, &image_len, 4);
+    tf_data_image_base64_encode(p_img, buffer + *p_total_len + 4, image_len + 1, &olen);
+    *p_total_len += image_len + 4;
+    return buffer;
+}
+
 static void __event_handler(void *handler_args, esp_event_base_t base, int32_t id, void *p_event_data)
 {
     tf_module_uart_alarm_t *p_module_ins = (tf_module_uart_alarm_t *)handler_args;
@@ -71,14 +88,10 @@ static void __event_handler(void *handler_args, esp_event_base_t base, int32_t i
         ESP_LOGI(TAG, "include_big_image: %d", (int)p_module_ins->include_big_image);
         if (p_module_ins->output_format == 0) {
             //binary output
-            uint32_t big_image_len = p_data->img_large.len;
-            buffer = psram_realloc(buffer, total_len + big_image_len + 4);
-            memcpy(buffer + total_len, &big_image_len, 4);
-            memcpy(buffer + total_len + 4, p_data->img_large.p_buf, big_image_len);
-            total_len += big_image_len + 4;
+            buffer = __binary_image_append(buffer, &total_len, &p_data->img_large);
         } else {
-            //json output
-            cJSON_AddItemToObject(json, "big_image", cJSON_CreateString((char *)p_data->img_large.p_buf));
+            //json output, base64 is streamed out with the packet
+            cJSON_AddItemToObject(json, "big_image", cJSON_CreateString(TF_DATA_IMAGE_JSON_MARK(0)));
         }
     } else if( p_module_ins->output_format == 0 ) {
         uint32_t big_image_len = 0;
@@ -92,14 +105,10 @@ static void __event_handler(void *handler_args, esp_event_base_t base, int32_t i
         ESP_LOGI(TAG, "include_small_image: %d", (int)p_module_ins->include_small_image);
         if (p_module_ins->output_format == 0) {
             //binary output
-            uint32_t small_image_len = p_data->img_small.len;
-            buffer = psram_realloc(buffer, total_len + small_image_len + 4);
-            memcpy(buffer + total_len, &small_image_len, 4);
-            memcpy(buffer + total_len + 4, p_data->img_small.p_buf, small_image_len);
-            total_len += small_image_len + 4;
+            buffer = __binary_image_append(buffer, &total_len, &p_data->img_small);
         } else {
-            //json output
-            cJSON_AddItemToObject(json, "small_image", cJSON_CreateString((char *)p_data->img_small.p_buf));
+            //json output, base64 is streamed out with the packet
+            cJSON_AddItemToObject(json, "small_image", cJSON_CreateString(TF_DATA_IMAGE_JSON_MARK(1)));
         }
     } else if( p_module_ins->output_format == 0 ) {
         uint32_t small_image_len = 0;
@@ -257,10 +266,11 @@ static void __event_handler(void *handler_args, esp_event_base_t base, int32_t i
         uart_write_bytes(UART_NUM_2, buffer, total_len);
         free(buffer);
     } else {
+        const struct tf_data_image *p_imgs[] = { &p_data->img_large, &p_data->img_small };
         char *str = cJSON_PrintUnformatted(json);
-        total_len = strlen(str);
+        total_len = tf_data_image_json_len(str, p_imgs, 2);
         ESP_LOGD(TAG, "output json:\n%s\ntotal_len=%d", str, total_len);
-        uart_write_bytes(UART_NUM_2, str, total_len);
+        tf_data_image_json_write(str, p_imgs, 2, __uart_write, NULL);
         uart_write_bytes(UART_NUM_2, "\r\n", 2);
         free(str);
         cJSON_Delete(json);
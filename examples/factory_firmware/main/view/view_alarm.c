@@ -5,7 +5,6 @@
 #include "esp_timer.h"
 #include "data_defs.h"
 
-#include <mbedtls/base64.h>
 #include "esp_jpeg_dec.h"
 #include "util.h"
 
@@ -35,7 +34,6 @@ static int16_t indicator_value = 0;
 static lv_obj_t * ui_image = NULL;
 static lv_obj_t * ui_Page_test;
 
-static uint8_t *image_jpeg_buf = NULL;
 static uint8_t *image_ram_buf = NULL;
 
 static jpeg_dec_io_t *jpeg_io = NULL;
@@ -159,9 +157,6 @@ int view_alarm_init(lv_obj_t *ui_screen)
         return ret;
     }
 
-    image_jpeg_buf = psram_malloc(IMG_JPEG_BUF_SIZE);
-    assert(image_jpeg_buf);
-
     //must be 16 byte aligned
     image_ram_buf = heap_caps_aligned_alloc(16, IMG_RAM_BUF_SIZE, MALLOC_CAP_SPIRAM);
     assert(image_ram_buf);
@@ -235,16 +230,7 @@ int view_alarm_on(struct tf_module_local_alarm_info *alarm_st)
         struct tf_data_image *alarm_img = &alarm_st->img;
         if (alarm_img->p_buf != NULL) {
 
-            int ret = 0; 
-            size_t output_len = 0;       
-            ret = mbedtls_base64_decode(image_jpeg_buf, IMG_JPEG_BUF_SIZE, &output_len, alarm_img->p_buf, alarm_img->len);
-            if (ret != 0 || output_len == 0)
-            {
-                ESP_LOGE("view", "Failed to decode base64: %d", ret);
-                return ret;
-            }
-
-            ret = esp_jpeg_decoder_one_picture(image_jpeg_buf, output_len, image_ram_buf);
+            int ret = esp_jpeg_decoder_one_picture(alarm_img->p_buf, alarm_img->len, image_ram_buf);
             if (ret != ESP_OK) {
                 ESP_LOGE("view", "Failed to decode jpeg: %d", ret);
                 return ret;
@@ -1,6 +1,5 @@
 #include "view_image_preview.h"
 #include "esp_log.h"
-#include <mbedtls/base64.h>
 #include "esp_jpeg_dec.h"
 #include "ui/ui_helpers.h"
 #include "util.h"
@@ -24,7 +23,6 @@ static lv_obj_t *ui_image = NULL;
 static lv_obj_t *ui_rectangle[IMAGE_INVOKED_BOXES];
 static lv_obj_t *ui_class_name[IMAGE_INVOKED_BOXES];
 
-static uint8_t *image_jpeg_buf = NULL;
 static uint8_t *image_ram_buf = NULL;
 
 static lv_color_t cls_color[20];
@@ -156,9 +154,6 @@ int view_image_preview_init(lv_obj_t *ui_screen)
         return ret;
     }
 
-    image_jpeg_buf = psram_malloc(IMG_JPEG_BUF_SIZE);
-    assert(image_jpeg_buf);
-
     //must be 16 byte aligned
     image_ram_buf = heap_caps_aligned_alloc(16, IMG_RAM_BUF_SIZE, MALLOC_CAP_SPIRAM);
     assert(image_ram_buf);
@@ -186,7 +181,6 @@ int view_image_preview_flush(struct tf_module_ai_camera_preview_info *p_info)
 {
     int ret = 0;
     int64_t start = 0, end = 0;
-    size_t output_len = 0;
     if (ui_image == NULL)
     {
         return 0;
@@ -196,15 +190,14 @@ int view_image_preview_flush(struct tf_module_ai_camera_preview_info *p_info)
         return 0;
     }
 
-    ret = mbedtls_base64_decode(image_jpeg_buf, IMG_JPEG_BUF_SIZE, &output_len, p_info->img.p_buf, p_info->img.len);
-    if (ret != 0 || output_len == 0)
+    if (p_info->img.p_buf == NULL || p_info->img.len == 0)
     {
-        ESP_LOGE("view", "Failed to decode base64: %d", ret);
-        return ret;
+        ESP_LOGE("view", "No image");
+        return -1;
     }
 
     start = esp_timer_get_time();
-    ret = esp_jpeg_decoder_one_picture(image_jpeg_buf, output_len, image_ram_buf);
+    ret = esp_jpeg_decoder_one_picture(p_info->img.p_buf, p_info->img.len, image_ram_buf);
     if (ret != ESP_OK) {
         ESP_LOGE("view", "Failed to decode jpeg: %d", ret);
         return ret;
@@ -360,38 +353,22 @@ void view_image_black_flush()
 int view_image_check(uint8_t *p_buf, size_t len, size_t ram_buf_len)
 {
     int ret = 0;
-    size_t output_len = 0;
     int64_t start = 0, end = 0;
-    uint8_t* p_jpeg_buf = NULL;
-     uint8_t* p_ram_buf = NULL;  
+    uint8_t* p_ram_buf = NULL;
     if (p_buf == NULL || len == 0 || ram_buf_len == 0)
     {
         return -1;
     }
     start = esp_timer_get_time();
 
-    p_jpeg_buf = psram_malloc(len); //base64 decode buf,  len / (3 * 4)
-    if (p_jpeg_buf == NULL )
-    {
-        ESP_LOGW("view", "psram_malloc failed: %d", len);
-        goto err;
-    }
     p_ram_buf = heap_caps_aligned_alloc(16, ram_buf_len, MALLOC_CAP_SPIRAM);
     if ( p_ram_buf == NULL)
     {
         ESP_LOGW("view", "psram_malloc failed: %d", ram_buf_len);
         goto err;
     }
-    
-    ret = mbedtls_base64_decode(p_jpeg_buf, len, &output_len, p_buf, len);
-    if (ret != 0 || output_len == 0)
-    {
-        ESP_LOGE("view", "Failed to decode base64: %d", ret);
-        ret = -1;
-        goto err;
-    }
-    
-    ret = esp_jpeg_decoder_one_picture(p_jpeg_buf, output_len, p_ram_buf);
+
+    ret = esp_jpeg_decoder_one_picture(p_buf, len, p_ram_buf);
     if (ret != ESP_OK) {
         ESP_LOGE("view", "Failed to decode jpeg: %d", ret);
         goto err;
@@ -400,9 +377,6 @@ int view_image_check(uint8_t *p_buf, size_t len, size_t ram_buf_len)
     printf("decode time:%lld ms\r\n", (end - start) / 1000);
 
 err:
-    if (p_jpeg_buf) {
-        free(p_jpeg_buf);
-    }
     if( p_ram_buf) {
         free(p_ram_buf);
     }
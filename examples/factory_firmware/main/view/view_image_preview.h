@@ -13,7 +13,6 @@ extern "C" {
 #define IMG_WIDTH            416
 #define IMG_HEIGHT           416
 
-#define IMG_JPEG_BUF_SIZE   48 * 1024
 #define IMG_RAM_BUF_SIZE    (IMG_WIDTH * IMG_HEIGHT * LV_COLOR_DEPTH / 8)
 
 /**
@@ -30,7 +29,7 @@ int view_image_preview_init(lv_obj_t *ui_screen);
 /**
  * @brief Flush the image preview with new image data.
  * 
- * This function decodes the base64-encoded JPEG image data, processes the decoded image, and updates the image display
+ * This function decodes the JPEG image data, processes the decoded image, and updates the image display
  * and bounding boxes based on the provided inference data.
  * 
  * @param p_info Pointer to the AI camera preview information structure containing image data and inference results.
@@ -45,7 +44,7 @@ int view_image_preview_flush(struct tf_module_ai_camera_preview_info *p_info);
  */
 void view_image_black_flush();
 
-// return 0 check success
+// decode a JPEG into a scratch buffer of ram_buf_len, return 0 check success
 int view_image_check(uint8_t *p_buf, size_t len, size_t ram_buf_len);
 
 #ifdef __cplusplus
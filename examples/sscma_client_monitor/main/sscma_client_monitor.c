@@ -108,20 +108,21 @@ _exit:
     return ret;
 }
 
-void display_one_image(lv_obj_t *image, const unsigned char *p_data)
+void display_one_image(lv_obj_t *image, const sscma_client_reply_t *reply)
 {
     int64_t start = 0, end = 0;
-    if (!p_data)
-        return;
-
-    size_t str_len = strlen((const char *)p_data);
     size_t output_len = 0;
 
+    // decode straight from the reply into the JPEG buffer
     start = esp_timer_get_time();
-    int decode_ret = mbedtls_base64_decode(decoded_str, DECODED_STR_MAX_SIZE, &output_len, p_data, str_len);
+    esp_err_t decode_ret = sscma_utils_decode_image_into(reply, decoded_str, DECODED_STR_MAX_SIZE, &output_len);
     end = esp_timer_get_time();
-    ESP_LOGI(TAG, "mbedtls_base64_decode time:%lld ms", (end - start) / 1000);
-    if (decode_ret == 0)
+    if (decode_ret == ESP_FAIL)
+    {
+        return; // no image in this reply
+    }
+    ESP_LOGI(TAG, "sscma_utils_decode_image_into time:%lld ms", (end - start) / 1000);
+    if (decode_ret == ESP_OK)
     {
         if (img_dsc.data == NULL)
         {
@@ -156,9 +157,9 @@ void display_one_image(lv_obj_t *image, const unsigned char *p_data)
 #endif
         }
     }
-    else if (decode_ret == MBEDTLS_ERR_BASE64_BUFFER_TOO_SMALL)
+    else if (decode_ret == ESP_ERR_INVALID_SIZE)
     {
-        ESP_LOGE(TAG, "Buffer too small for decoding %d bytes %d output", str_len, output_len);
+        ESP_LOGE(TAG, "Buffer too small for decoding, %d bytes available", DECODED_STR_MAX_SIZE);
     }
     else
     {
@@ -171,19 +172,17 @@ void on_event(sscma_client_handle_t client, const sscma_client_reply_t *reply, v
 {
     // Note: reply is automatically recycled after exiting the function.
 
-    char *img = NULL;
-    int img_size = 0;
+    const char *img = NULL;
+    size_t img_size = 0;
 
-    if (sscma_utils_fetch_image_from_reply(reply, &img, &img_size) == ESP_OK)
+    if (sscma_utils_view_image_from_reply(reply, &img, &img_size) == ESP_OK)
     {
         if (lvgl_port_lock(0))
         {
             ESP_LOGI(TAG, "Got a new image: %d bytes", img_size);
-            display_one_image(image, (const unsigned char *)img);
+            display_one_image(image, reply);
             lvgl_port_unlock();
         }
-
-        free(img);
     }
     sscma_client_box_t *boxes = NULL;
     int box_count = 0;
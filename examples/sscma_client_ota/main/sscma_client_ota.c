@@ -35,12 +35,11 @@ void on_event(sscma_client_handle_t client, const sscma_client_reply_t *reply, v
 {
     // Note: reply is automatically recycled after exiting the function.
 
-    char *img = NULL;
-    int img_size = 0;
-    if (sscma_utils_fetch_image_from_reply(reply, &img, &img_size) == ESP_OK)
+    const char *img = NULL;
+    size_t img_size = 0;
+    if (sscma_utils_view_image_from_reply(reply, &img, &img_size) == ESP_OK)
     {
         ESP_LOGI(TAG, "image_size: %d\n", img_size);
-        free(img);
     }
     sscma_client_box_t *boxes = NULL;
     int box_count = 0;
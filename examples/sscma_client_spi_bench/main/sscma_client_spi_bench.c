@@ -0,0 +1,159 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "driver/gpio.h"
+#include "driver/spi_master.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+
+#include "esp_timer.h"
+#include "esp_log.h"
+#include "esp_check.h"
+
+#include "sensecap-watcher.h"
+
+#include "sscma_client_io.h"
+#include "sscma_client_ops.h"
+
+/*
+ * SPI frame fetch throughput of the SSCMA client against the SPI packet size and the number of
+ * packets in flight. Every configuration gets a fresh IO and client, then samples 640x480 frames
+ * and reports the bytes received per second.
+ */
+
+static const char *TAG = "main";
+
+#define BENCH_FRAMES        10
+#define BENCH_SENSOR_ID     1
+#define BENCH_SENSOR_OPT_ID 3 // 640x480
+#define BENCH_TIMEOUT_MS    30000
+
+typedef struct
+{
+    size_t max_read_len;
+    size_t trans_queue_depth;
+    int wait_delay;
+} bench_config_t;
+
+static const bench_config_t bench_configs[] = {
+    { 1024, 1, 2 },
+    { 2048, 1, 2 },
+    { 4095, 1, 2 },
+    { 4095, 2, 2 },
+    { 4095, 2, 0 },
+    { 4095, 3, 0 },
+    { 8190, 2, 0 },
+    { 16380, 2, 0 },
+};
+
+typedef struct
+{
+    SemaphoreHandle_t done;
+    int frames;
+    size_t bytes;
+    int64_t first_us;
+    int64_t last_us;
+} bench_result_t;
+
+static esp_io_expander_handle_t io_expander = NULL;
+
+static void on_event(sscma_client_handle_t client, const sscma_client_reply_t *reply, void *user_ctx)
+{
+    bench_result_t *result = (bench_result_t *)user_ctx;
+
+    // the first frame only starts the clock, the sensor setup is not part of the transfer
+    if (result->frames == 0)
+    {
+        result->first_us = esp_timer_get_time();
+    }
+    else
+    {
+        result->bytes += reply->len;
+    }
+    result->last_us = esp_timer_get_time();
+    if (++result->frames == BENCH_FRAMES)
+    {
+        xSemaphoreGive(result->done);
+    }
+}
+
+static esp_err_t bench_run(const bench_config_t *bench, bench_result_t *result)
+{
+    esp_err_t ret = ESP_OK;
+    sscma_client_io_handle_t io = NULL;
+    sscma_client_handle_t client = NULL;
+
+    const sscma_client_io_spi_config_t spi_io_config = {
+        .sync_gpio_num = BSP_SSCMA_CLIENT_SPI_SYNC,
+        .cs_gpio_num = BSP_SSCMA_CLIENT_SPI_CS,
+        .pclk_hz = BSP_SSCMA_CLIENT_SPI_CLK,
+        .spi_mode = 0,
+        .wait_delay = bench->wait_delay,
+        .trans_queue_depth = bench->trans_queue_depth,
+        .max_read_len = bench->max_read_len,
+        .io_expander = io_expander,
+        .flags.sync_use_expander = BSP_SSCMA_CLIENT_SPI_SYNC_USE_EXPANDER,
+    };
+    ESP_RETURN_ON_ERROR(sscma_client_new_io_spi_bus((sscma_client_spi_bus_handle_t)BSP_SSCMA_CLIENT_SPI_NUM, &spi_io_config, &io), TAG, "new io failed");
+
+    sscma_client_config_t sscma_client_config = SSCMA_CLIENT_CONFIG_DEFAULT();
+    sscma_client_config.reset_gpio_num = BSP_SSCMA_CLIENT_RST;
+    sscma_client_config.io_expander = io_expander;
+    sscma_client_config.flags.reset_use_expander = BSP_SSCMA_CLIENT_RST_USE_EXPANDER;
+    ESP_GOTO_ON_ERROR(sscma_client_new(io, &sscma_client_config, &client), err, TAG, "new client failed");
+
+    const sscma_client_callback_t callback = {
+        .on_event = on_event,
+    };
+    ESP_GOTO_ON_ERROR(sscma_client_register_callback(client, &callback, result), err, TAG, "register callback failed");
+    ESP_GOTO_ON_ERROR(sscma_client_init(client), err, TAG, "init failed");
+    ESP_GOTO_ON_ERROR(sscma_client_set_sensor(client, BENCH_SENSOR_ID, BENCH_SENSOR_OPT_ID, true), err, TAG, "set sensor failed");
+    ESP_GOTO_ON_ERROR(sscma_client_sample(client, BENCH_FRAMES), err, TAG, "sample failed");
+    ESP_GOTO_ON_FALSE(xSemaphoreTake(result->done, pdMS_TO_TICKS(BENCH_TIMEOUT_MS)) == pdTRUE, ESP_ERR_TIMEOUT, err, TAG, "got %d of %d frames", result->frames, BENCH_FRAMES);
+
+err:
+    if (client)
+    {
+        sscma_client_break(client);
+        sscma_client_del(client);
+    }
+    sscma_client_del_io(io);
+    return ret;
+}
+
+void app_main(void)
+{
+    io_expander = bsp_io_expander_init();
+    assert(io_expander != NULL);
+    ESP_ERROR_CHECK(bsp_spi_bus_init());
+
+    // SD card shares the SPI bus with the SSCMA client, keep it deselected
+    const gpio_config_t io_config = {
+        .pin_bit_mask = (1ULL << BSP_SD_SPI_CS),
+        .mode = GPIO_MODE_OUTPUT,
+        .pull_up_en = GPIO_PULLUP_ENABLE,
+    };
+    ESP_ERROR_CHECK(gpio_config(&io_config));
+    gpio_set_level(BSP_SD_SPI_CS, 1);
+
+    printf("read_len,depth,wait_delay,frames,bytes,ms,kB/s\n");
+    for (size_t i = 0; i < sizeof(bench_configs) / sizeof(bench_configs[0]); i++)
+    {
+        const bench_config_t *bench = &bench_configs[i];
+        bench_result_t result = { 0 };
+
+        result.done = xSemaphoreCreateBinary();
+        assert(result.done != NULL);
+
+        esp_err_t ret = bench_run(bench, &result);
+        int64_t us = result.last_us - result.first_us;
+        printf("%d,%d,%d,%d,%d,%lld,%.1f%s\n", bench->max_read_len, bench->trans_queue_depth, bench->wait_delay, result.frames, result.bytes, us / 1000,
+            us > 0 ? result.bytes * 1000.0 / us : 0.0, ret == ESP_OK ? "" : ",failed");
+
+        vSemaphoreDelete(result.done);
+        vTaskDelay(pdMS_TO_TICKS(1000));
+    }
+}